@@ -0,0 +1,431 @@
+#pragma once
+#include "alarm_bank.hpp"
+#include "binary_frame.hpp"
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <array>
+#include <cstdint>
+
+// The alarms an operator has to see: active ones, and those that have returned to normal but are not acknowledged yet,
+// in a table of fixed capacity that the HMIs (binary protocol on serial and UDP, Modbus) follow by sequence number.
+//
+// An alarm is an id (0..Ids-1) with a severity, raised and cleared by its source and acknowledged from an HMI; it
+// leaves the table once it is both cleared and acknowledged. Raising an alarm that is in the table does not add
+// another: the entry counts the repeat, so a chattering contact costs one entry and, per poll of an HMI, one record.
+// The entries form a binary heap with the least important at the root, severity first and then age, the older the
+// more important, and a table of the position of every id, so raise(), clear() and ack() are O(log n). A full table
+// makes room for an alarm more important than its least important entry, which is dropped; otherwise the new alarm
+// is. Either way dropped() counts it.
+//
+//     alarms::AlarmManager<16> alarm_table;                  // 16 entries, ids 0..63
+//
+//     void setup() {
+//         levels.event_out >> alarm_table.event_in;          // An AlarmBank's level changes, the channel as the id
+//         commander.attach_alarms(alarm_table);              // ALARM_READ and ALARM_ACK of the binary protocol
+//         modbus_slave.use_alarms(alarm_table);              // The alarm registers, see actor_modbus.hpp
+//     }
+//     ...     alarm_table.raise(DOOR_OPEN, 3);
+//
+// Every change of an entry takes the next 16-bit sequence number. read() returns the changes after a given number,
+// oldest first: entries, and removals, which a ring of the last Capacity of them remembers. An HMI keeps the number
+// of the last change it has seen and reads again from there, so it gets each entry once per poll however often it
+// changed in between, and a flood costs it no more than the table's size. A record is the whole state of its alarm,
+// to be applied over what the HMI had. A number older than the removals remembered, or than the last 32767 changes,
+// gets the whole table with the RESYNC flag, after which the HMI forgets the alarms it knew; so does asking for it.
+//
+// An entry is 10 bytes, a removal 3, and the position table a byte per id. Times are those of the scan clock, in
+// milliseconds since boot. The firmware's table is opt-in with -D ALARM_MANAGER (see main.cpp).
+
+namespace alarms {
+
+// State bits of a record
+constexpr std::uint8_t ACTIVE = 0x01;
+constexpr std::uint8_t ACKNOWLEDGED = 0x02;
+constexpr std::uint8_t REMOVED = 0x80;  // The record of a removal: cleared and acknowledged, or dropped
+
+constexpr std::uint8_t ALL = 0xFF;  // ack(ALL) acknowledges every alarm
+constexpr std::uint8_t RECORD_SIZE = 10;
+constexpr std::uint8_t RESYNC = 0x01;  // Flag of a read: the whole table, oldest first
+
+// One change: seq:u16 id severity state repeats time:u32, little-endian
+struct Record {
+    std::uint16_t seq;
+    std::uint8_t id;
+    std::uint8_t severity;
+    std::uint8_t state;
+    std::uint8_t repeats;  // Raises while in the table, saturating at 255
+    std::uint32_t time;    // Of the raise that put it in the table, or made it active again
+};
+
+struct ReadResult {
+    std::uint8_t count = 0;
+    std::uint8_t flags = 0;
+    std::uint16_t next = 0;  // To read from next time
+};
+
+// A read for the binary protocol's ALARM_READ
+struct ReadEvent {
+    struct Reply {
+        bool handled = false;
+        ReadResult result;
+    };
+    std::uint16_t since;
+    std::uint8_t flags;     // RESYNC for the whole table
+    std::uint8_t* records;  // Room for `max` records of RECORD_SIZE bytes
+    std::uint8_t max;
+    Reply* reply;
+};
+
+// An acknowledgement for the binary protocol's ALARM_ACK
+struct AckEvent {
+    std::uint8_t id;  // Or ALL
+    bool* handled;
+};
+
+// Size-independent part of an AlarmManager, as the HMI links see it
+class AlarmTable {
+public:
+    // Raises alarm `id` at `severity` (1..255), or counts a repeat if it is in the table; false if it was dropped
+    bool raise(std::uint8_t id, std::uint8_t severity) {
+        if (id >= ids_ || severity == 0) {
+            return false;
+        }
+        const std::uint8_t at = position_[id];
+        if (at != NONE) {
+            Entry& e = entries_[at];
+            if (e.repeats != UINT8_MAX) {
+                ++e.repeats;
+            }
+            if ((e.state & ACTIVE) == 0) {
+                e.state = ACTIVE;  // Again, to be acknowledged again
+                e.time = scan_clock::now();
+            }
+            e.severity = severity;
+            e.seq = next_seq();
+            sift(at);
+            return true;
+        }
+        const Entry added{scan_clock::now(), 0, id, severity, ACTIVE, 0};
+        if (size_ == capacity_) {
+            count_drop();
+            if (!less(entries_[0], added)) {
+                return false;
+            }
+            remove(0);
+        }
+        const std::uint8_t last = size_++;
+        place(last, added);
+        entries_[last].seq = next_seq();
+        sift_up(last);
+        return true;
+    }
+
+    // The source of alarm `id` is back to normal; the entry stays until acknowledged
+    void clear(std::uint8_t id) {
+        const std::uint8_t at = find(id);
+        if (at == NONE || (entries_[at].state & ACTIVE) == 0) {
+            return;
+        }
+        if ((entries_[at].state & ACKNOWLEDGED) != 0) {
+            remove(at);
+        } else {
+            entries_[at].state = 0;
+            entries_[at].seq = next_seq();
+        }
+    }
+
+    // An operator has seen alarm `id`, or every alarm with ALL; one that has cleared leaves the table
+    void ack(std::uint8_t id) {
+        if (id == ALL) {
+            for (std::uint8_t i = 0; i < ids_; ++i) {
+                ack(i);
+            }
+            return;
+        }
+        const std::uint8_t at = find(id);
+        if (at == NONE || (entries_[at].state & ACKNOWLEDGED) != 0) {
+            return;
+        }
+        if ((entries_[at].state & ACTIVE) == 0) {
+            remove(at);
+        } else {
+            entries_[at].state = ACTIVE | ACKNOWLEDGED;
+            entries_[at].seq = next_seq();
+        }
+    }
+
+    // Up to `max` changes after `since`, oldest first, RECORD_SIZE bytes each into `out`; the whole table with RESYNC
+    ReadResult read(std::uint16_t since, std::uint8_t* out, std::uint8_t max, std::uint8_t flags = 0) const {
+        ReadResult result;
+        if ((flags & RESYNC) != 0 || age(since) > age(oldest_)) {
+            result.flags = RESYNC;
+        }
+        // Records are taken by falling age; every entry is at most as old as oldest_, so a resync takes them all
+        std::uint16_t limit = (result.flags == RESYNC) ? static_cast<std::uint16_t>(age(oldest_) + 1U) : age(since);
+        const bool entries_only = result.flags == RESYNC;
+        Record r{};
+        while (result.count < max && next_record(limit, entries_only, r)) {
+            write(r, out + RECORD_SIZE * result.count);
+            ++result.count;
+            limit = age(r.seq);
+        }
+        const bool more = result.count == max && next_record(limit, entries_only, r);
+        result.next = more ? static_cast<std::uint16_t>(seq_ - limit) : seq_;
+        return result;
+    }
+
+    // The most important alarm in the table; false if it is empty. O(n), as the heap keeps the least important at hand.
+    bool top(Record& r) const {
+        if (size_ == 0) {
+            return false;
+        }
+        std::uint8_t best = 0;
+        for (std::uint8_t i = 1; i < size_; ++i) {
+            if (less(entries_[best], entries_[i])) {
+                best = i;
+            }
+        }
+        r = record(entries_[best]);
+        return true;
+    }
+
+    std::uint8_t unacknowledged() const {
+        std::uint8_t n = 0;
+        for (std::uint8_t i = 0; i < size_; ++i) {
+            if ((entries_[i].state & ACKNOWLEDGED) == 0) {
+                ++n;
+            }
+        }
+        return n;
+    }
+
+    std::uint8_t size() const { return size_; }
+    std::uint8_t capacity() const { return capacity_; }
+    std::uint8_t ids() const { return ids_; }
+    std::uint16_t sequence() const { return seq_; }     // Of the newest change
+    std::uint16_t dropped() const { return dropped_; }  // Alarms that found the table full, saturating at 65535
+
+    // Input: level changes of an AlarmBank, the channel as the id and severity() of the level as the severity
+    ramen::Pushable<Event> event_in = [this](const Event& evt) {
+        if (evt.to == NORMAL) {
+            clear(evt.channel);
+        } else {
+            raise(evt.channel, severity(evt.to));
+        }
+    };
+
+    // Binary protocol: ALARM_READ and ALARM_ACK, see actor_serial_commander.hpp
+    ramen::Pushable<const ReadEvent&> read_in = [this](const ReadEvent& evt) {
+        evt.reply->handled = true;
+        evt.reply->result = read(evt.since, evt.records, evt.max, evt.flags);
+    };
+    ramen::Pushable<const AckEvent&> ack_in = [this](const AckEvent& evt) {
+        ack(evt.id);
+        *evt.handled = true;
+    };
+
+protected:
+    struct Entry {
+        std::uint32_t time;
+        std::uint16_t seq;
+        std::uint8_t id;
+        std::uint8_t severity;
+        std::uint8_t state;
+        std::uint8_t repeats;
+    };
+    struct Removal {
+        std::uint16_t seq;
+        std::uint8_t id;
+    };
+
+    static constexpr std::uint8_t NONE = 0xFF;
+
+    AlarmTable(std::uint8_t capacity, std::uint8_t ids) : capacity_(capacity), ids_(ids) {}
+
+    // Takes the storage of the owning table, called once from its constructor
+    void format(Entry* entries, std::uint8_t* position, Removal* removals) {
+        entries_ = entries;
+        position_ = position;
+        removals_ = removals;
+        for (std::uint8_t i = 0; i < ids_; ++i) {
+            position[i] = NONE;
+        }
+    }
+    AlarmTable(const AlarmTable&) = delete;
+    AlarmTable& operator=(const AlarmTable&) = delete;
+
+private:
+    static constexpr std::uint16_t WINDOW = 0x7FFF;  // Changes a reader may be behind without a resync
+
+    Entry* entries_ = nullptr;          // The heap, least important first
+    std::uint8_t* position_ = nullptr;  // Of each id in the heap, NONE if absent
+    Removal* removals_ = nullptr;       // Ring of the last capacity_ removals
+    const std::uint8_t capacity_;
+    const std::uint8_t ids_;
+    std::uint8_t size_ = 0;
+    std::uint8_t removal_head_ = 0;  // Next to overwrite
+    std::uint8_t removal_count_ = 0;
+    std::uint16_t seq_ = 0;
+    std::uint16_t oldest_ = 0;  // A reader at or after this number has missed nothing; no entry is older
+    std::uint16_t dropped_ = 0;
+
+    // How many changes ago `seq` was
+    std::uint16_t age(std::uint16_t seq) const { return static_cast<std::uint16_t>(seq_ - seq); }
+
+    std::uint16_t next_seq() {
+        seq_ = static_cast<std::uint16_t>(seq_ + 1U);
+        if (age(oldest_) > WINDOW) {
+            forget(static_cast<std::uint16_t>(seq_ - WINDOW));
+        }
+        return seq_;
+    }
+
+    // Moves oldest_ forward to `seq`, renumbering the entries older than that so they stay in the window
+    void forget(std::uint16_t seq) {
+        oldest_ = seq;
+        const std::uint16_t limit = age(seq);
+        for (std::uint8_t i = 0; i < size_; ++i) {
+            if (age(entries_[i].seq) > limit) {
+                seq_ = static_cast<std::uint16_t>(seq_ + 1U);
+                entries_[i].seq = seq_;
+            }
+        }
+    }
+
+    std::uint8_t find(std::uint8_t id) const { return (id < ids_) ? position_[id] : NONE; }
+
+    // a is less important than b: less severe, or as severe and newer
+    static bool less(const Entry& a, const Entry& b) {
+        if (a.severity != b.severity) {
+            return a.severity < b.severity;
+        }
+        return static_cast<std::int32_t>(a.time - b.time) > 0;
+    }
+
+    void count_drop() {
+        if (dropped_ != UINT16_MAX) {
+            ++dropped_;
+        }
+    }
+
+    void place(std::uint8_t at, const Entry& e) {
+        entries_[at] = e;
+        position_[e.id] = at;
+    }
+
+    void sift_up(std::uint8_t at) {
+        const Entry e = entries_[at];
+        while (at > 0) {
+            const std::uint8_t parent = static_cast<std::uint8_t>((at - 1U) / 2U);
+            if (!less(e, entries_[parent])) {
+                break;
+            }
+            place(at, entries_[parent]);
+            at = parent;
+        }
+        place(at, e);
+    }
+
+    void sift_down(std::uint8_t at) {
+        const Entry e = entries_[at];
+        for (;;) {
+            std::uint8_t child = static_cast<std::uint8_t>(2U * at + 1U);
+            if (child >= size_) {
+                break;
+            }
+            if (child + 1U < size_ && less(entries_[child + 1U], entries_[child])) {
+                ++child;
+            }
+            if (!less(entries_[child], e)) {
+                break;
+            }
+            place(at, entries_[child]);
+            at = child;
+        }
+        place(at, e);
+    }
+
+    void sift(std::uint8_t at) {
+        if (at > 0 && less(entries_[at], entries_[(at - 1U) / 2U])) {
+            sift_up(at);
+        } else {
+            sift_down(at);
+        }
+    }
+
+    // Takes the entry at `at` out of the heap and remembers the removal for the readers
+    void remove(std::uint8_t at) {
+        const std::uint8_t id = entries_[at].id;
+        position_[id] = NONE;
+        --size_;
+        if (at != size_) {
+            place(at, entries_[size_]);
+            sift(at);
+        }
+        const std::uint16_t seq = next_seq();
+        if (removal_count_ == capacity_) {
+            // A reader from before the removal overwritten would miss it
+            const std::uint16_t lost = removals_[removal_head_].seq;
+            if (age(lost) < age(oldest_)) {
+                forget(lost);
+            }
+        } else {
+            ++removal_count_;
+        }
+        removals_[removal_head_] = Removal{seq, id};
+        removal_head_ = static_cast<std::uint8_t>((removal_head_ + 1U) % capacity_);
+    }
+
+    static Record record(const Entry& e) { return Record{e.seq, e.id, e.severity, e.state, e.repeats, e.time}; }
+
+    // The oldest change younger than `limit`, of the entries and, unless `entries_only`, the removals after oldest_
+    bool next_record(std::uint16_t limit, bool entries_only, Record& r) const {
+        std::uint16_t best = 0;
+        bool found = false;
+        for (std::uint8_t i = 0; i < size_; ++i) {
+            const std::uint16_t a = age(entries_[i].seq);
+            if (a < limit && (!found || a > best)) {
+                r = record(entries_[i]);
+                best = a;
+                found = true;
+            }
+        }
+        for (std::uint8_t i = 0; !entries_only && i < removal_count_; ++i) {
+            const std::uint16_t a = age(removals_[i].seq);
+            if (a < limit && a <= age(oldest_) && (!found || a > best)) {
+                r = Record{removals_[i].seq, removals_[i].id, 0, REMOVED, 0, 0};
+                best = a;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    static void write(const Record& r, std::uint8_t* out) {
+        binary_frame::write_le16(out, r.seq);
+        out[2] = r.id;
+        out[3] = r.severity;
+        out[4] = r.state;
+        out[5] = r.repeats;
+        binary_frame::write_le32(out + 6, r.time);
+    }
+};
+
+template <std::uint8_t Capacity, std::uint8_t Ids = 64>
+class AlarmManager : public AlarmTable {
+    static_assert(Capacity > 0 && Capacity < NONE, "A table holds 1 to 254 alarms");
+    static_assert(Ids > 0 && Ids < ALL, "Alarm ids are 0 to 254");
+
+public:
+    AlarmManager() : AlarmTable(Capacity, Ids)
+    {
+        format(entry_storage_.data(), position_storage_.data(), removal_storage_.data());
+    }
+
+private:
+    std::array<Entry, Capacity> entry_storage_{};
+    std::array<std::uint8_t, Ids> position_storage_{};
+    std::array<Removal, Capacity> removal_storage_{};
+};
+
+} // namespace alarms
@@ -0,0 +1,202 @@
+#pragma once
+#include "actor_serial_commander.hpp"
+#include "binary_frame.hpp"
+#include "eeprom_access.hpp"
+#include "fmt.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+
+// Replays a stored list of LED commands at every boot, so the outputs reach their working state without a host:
+//
+//     script; interval 1 200; start 1-3     // Runs the commands now and saves them
+//     script                                // Lists the saved commands
+//     script clear                          // Boots with the defaults of setup() again
+//
+// The commands after 'script' on its line are saved as the command parser built them, so begin() decodes them
+// straight into one LedBatchEvent for the executor: the boot does not wait for a line or run the text parser, and
+// the outputs are in their state by the end of setup(). Only start, stop and interval are saved; other commands on
+// the line run but are not replayed. The record sits in the last 64 bytes of the EEPROM (see eeprom_access.hpp):
+//
+//     count:u8 {type:u8 led_id:u8 count:u8 interval:u32}*count crc:u16
+//
+// and is written a byte per update() while the EEPROM is ready, so saving does not hold loop(). A record cut short by
+// a power loss fails its CRC and the boot runs without a script.
+//
+//     boot_script::BootScriptActor boot;
+//     void setup() { ...; commander.attach_boot_script(boot); ...; boot.begin(); }  // After the outputs' defaults
+//     void loop()  { boot.update(); ... }
+//
+// The script is opt-in with -D BOOT_SCRIPT. Without it ENABLED is false, begin() runs nothing and 'script' reports
+// that it is disabled.
+
+namespace boot_script {
+
+#if defined(BOOT_SCRIPT)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+class BootScriptActor {
+public:
+    static constexpr std::uint8_t MAX_COMMANDS = serial_cmd::CommandParserActor::MAX_LINE_COMMANDS;
+    static constexpr std::size_t ENTRY_SIZE = 7;  // type led_id count interval:u32
+    static constexpr std::size_t MAX_RECORD_SIZE = 1 + ENTRY_SIZE * MAX_COMMANDS + binary_frame::CRC_SIZE;
+
+    static_assert(MAX_RECORD_SIZE <= eeprom_access::SIZE - eeprom_access::BOOT_SCRIPT_REGION,
+                  "The boot script does not fit into its region of the EEPROM");
+
+    BootScriptActor() = default;
+    BootScriptActor(const BootScriptActor&) = delete;
+    BootScriptActor& operator=(const BootScriptActor&) = delete;
+
+    // Input: 'script' commands of the parser (see SerialCommandSystem::attach_boot_script())
+    ramen::Pushable<serial_cmd::BootScriptEvent> script_in = [this](const serial_cmd::BootScriptEvent& evt) {
+        if (!ENABLED) {
+            flash_response_out(F("Boot script disabled (build with -D BOOT_SCRIPT)"));
+            return;
+        }
+        switch (evt.action) {
+            case serial_cmd::BootScriptEvent::SHOW:
+                show();
+                break;
+            case serial_cmd::BootScriptEvent::SAVE:
+                save(evt.commands);
+                break;
+            case serial_cmd::BootScriptEvent::CLEAR:
+                save(ramen::Span<const serial_cmd::LedCommandEvent>(nullptr, 0));
+                flash_response_out(F("Boot script cleared"));
+                break;
+        }
+    };
+
+    // Output: the saved commands, once at boot
+    ramen::Pusher<serial_cmd::LedBatchEvent> batch_out;
+
+    // Output: responses to 'script', formatted in RAM or constant in flash
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;
+
+    // Runs the saved commands; false if there are none (or the script is disabled) and the outputs keep their state
+    bool begin() {
+        if (!ENABLED) {
+            return false;
+        }
+        eeprom_access::read_block(image_, eeprom_access::BOOT_SCRIPT_REGION, 1);
+        if (image_[0] > MAX_COMMANDS) {  // Blank EEPROM reads 0xFF
+            image_[0] = 0;
+            return false;
+        }
+        eeprom_access::read_block(image_, eeprom_access::BOOT_SCRIPT_REGION, record_size());
+        serial_cmd::LedCommandEvent commands[MAX_COMMANDS];
+        if (!binary_frame::crc_ok(image_, record_size()) || !decode(commands)) {
+            image_[0] = 0;
+            return false;
+        }
+        if (image_[0] == 0) {
+            return false;
+        }
+        flash_response_out(F("Boot script:"));
+        batch_out(serial_cmd::LedBatchEvent{ramen::Span<const serial_cmd::LedCommandEvent>(commands, image_[0])});
+        return true;
+    }
+
+    // Writes a saved script, a byte whenever the EEPROM is ready
+    void update() {
+        while (write_pos_ < write_end_ && eeprom_access::ready()) {
+            const std::uint16_t address = static_cast<std::uint16_t>(eeprom_access::BOOT_SCRIPT_REGION + write_pos_);
+            if (eeprom_access::update_byte(address, image_[write_pos_++])) {
+                return;
+            }
+        }
+    }
+
+    // True while a saved script is being written
+    bool pending() const { return write_pos_ < write_end_; }
+
+private:
+    std::uint8_t image_[MAX_RECORD_SIZE] = {};  // The saved script, as recorded; none until begin() or a save
+    std::uint8_t write_pos_ = 0;                // Next byte of image_ to write...
+    std::uint8_t write_end_ = 0;                // ...up to this one
+
+    std::size_t record_size() const { return 1 + ENTRY_SIZE * image_[0] + binary_frame::CRC_SIZE; }
+
+    const std::uint8_t* entry(std::uint8_t i) const { return image_ + 1 + i * ENTRY_SIZE; }
+
+    // The commands of image_ into `commands`; false if one of them could not have come from the parser
+    bool decode(serial_cmd::LedCommandEvent* commands) const {
+        for (std::uint8_t i = 0; i < image_[0]; ++i) {
+            const std::uint8_t* e = entry(i);
+            const std::uint32_t interval = binary_frame::read_le32(e + 3);
+            if (e[0] > serial_cmd::LedCommandEvent::SET_INTERVAL ||
+                (e[0] == serial_cmd::LedCommandEvent::SET_INTERVAL && (interval < 1 || interval > 60000))) {
+                return false;
+            }
+            commands[i] = serial_cmd::LedCommandEvent{e[1], static_cast<serial_cmd::LedCommandEvent::Type>(e[0]),
+                                                      interval, e[2]};
+        }
+        return true;
+    }
+
+    // Records `commands` in image_ and starts writing them; a write still going on starts over with these
+    void save(const ramen::Span<const serial_cmd::LedCommandEvent>& commands) {
+        image_[0] = static_cast<std::uint8_t>(commands.len);
+        for (std::uint8_t i = 0; i < image_[0]; ++i) {
+            const serial_cmd::LedCommandEvent& cmd = commands.ptr[i];
+            std::uint8_t* e = image_ + 1 + i * ENTRY_SIZE;  // entry(i), writable
+            e[0] = static_cast<std::uint8_t>(cmd.type);
+            e[1] = cmd.led_id;
+            e[2] = cmd.count;
+            binary_frame::write_le32(e + 3, cmd.interval_ms);
+        }
+        const std::size_t length = binary_frame::append_crc(image_, record_size() - binary_frame::CRC_SIZE);
+        write_end_ = static_cast<std::uint8_t>(length);
+        write_pos_ = 0;
+        update();
+        if (image_[0] > 0) {
+            fmt::Line<40> msg;
+            fmt::write(msg, "Boot script saved: ", static_cast<unsigned>(image_[0]), " commands");
+            response_out(msg.c_str());
+        }
+    }
+
+    // Lists the saved commands in the syntax they were typed in, e.g. "  interval 1-3 200"
+    void show() {
+        if (image_[0] == 0) {
+            flash_response_out(F("No boot script"));
+            return;
+        }
+        flash_response_out(F("Boot script:"));
+        for (std::uint8_t i = 0; i < image_[0]; ++i) {
+            const std::uint8_t* e = entry(i);
+            fmt::Line<32> msg;
+            switch (e[0]) {
+                case serial_cmd::LedCommandEvent::START:
+                    fmt::write(msg, "  start ");
+                    break;
+                case serial_cmd::LedCommandEvent::STOP:
+                    fmt::write(msg, "  stop ");
+                    break;
+                default:
+                    fmt::write(msg, "  interval ");
+                    break;
+            }
+            const unsigned first = e[1] + 1U;
+            if (e[2] == serial_cmd::LedCommandEvent::ALL) {
+                fmt::write(msg, '*');
+            } else if (e[2] == 1) {
+                fmt::write(msg, first);
+            } else {
+                fmt::write(msg, first, '-', first + e[2] - 1U);
+            }
+            if (e[0] == serial_cmd::LedCommandEvent::SET_INTERVAL) {
+                fmt::write(msg, ' ', static_cast<unsigned long>(binary_frame::read_le32(e + 3)));
+            }
+            response_out(msg.c_str());
+        }
+    }
+};
+
+} // namespace boot_script
@@ -0,0 +1,230 @@
+#pragma once
+#include "binary_frame.hpp"
+#include "eeprom_access.hpp"
+#include "output_registry.hpp"
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Keeps the configuration of the outputs (blink interval, running or stopped) in EEPROM across reboots, so settings
+// made over the command interfaces survive a power cycle:
+//
+//     config_store::ConfigStoreActor<3> config(outputs);
+//     void setup() { ...; led1.start(); ...; config.begin(); }  // Applies the saved configuration over these
+//     void loop()  { config.update(); ... }
+//
+// update() takes a snapshot of the outputs every CHECK_MS and compares it with the last one saved; a change is written
+// once the configuration has stayed the same for COALESCE_MS (or, while it keeps changing, MAX_DELAY_MS after the
+// first change), so a commissioning session of many commands costs one write. Records rotate through SLOTS slots of
+// the EEPROM region, which spreads the wear over all of them; each record carries a sequence number and ends in a
+// CRC-16 (as in binary_frame.hpp):
+//
+//     seq:u16 count {interval:u32 flags}*count crc:u16        flags: bit 0 running
+//
+// begin() reads the headers of the slots, then the newest record in one block read, and falls back to the one before
+// if a write was cut short by a power loss. Writing never waits: update() writes one byte whenever the EEPROM is ready
+// (a byte takes 3.4 ms), and bytes that already hold their value are skipped.
+//
+// The store is opt-in with -D EEPROM_CONFIG. Without it ENABLED is false, begin() loads nothing and update() does
+// nothing. Off AVR the EEPROM is an array in RAM (see eeprom_access.hpp).
+
+#ifndef EEPROM_CONFIG_ADDRESS
+#define EEPROM_CONFIG_ADDRESS 0  // Start of the region
+#endif
+#ifndef EEPROM_CONFIG_SLOTS
+#define EEPROM_CONFIG_SLOTS 16  // Records in rotation, at most 32
+#endif
+
+namespace config_store {
+
+#if defined(EEPROM_CONFIG)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t RUNNING = 0x01;
+
+template <std::uint8_t MaxOutputs>
+class ConfigStoreActor {
+public:
+    static constexpr std::uint8_t SLOTS = EEPROM_CONFIG_SLOTS;
+    static constexpr std::size_t ENTRY_SIZE = 5;  // interval:u32 flags
+    static constexpr std::size_t HEADER_SIZE = 3;
+    static constexpr std::size_t RECORD_SIZE = HEADER_SIZE + ENTRY_SIZE * MaxOutputs + binary_frame::CRC_SIZE;
+    static constexpr std::uint16_t CHECK_MS = 100;
+    static constexpr std::uint16_t COALESCE_MS = 2000;
+    static constexpr std::uint16_t MAX_DELAY_MS = 30000;
+    static constexpr std::uint32_t MIN_INTERVAL_MS = 1;
+    static constexpr std::uint32_t MAX_INTERVAL_MS = 60000;
+
+    static_assert(SLOTS >= 2 && SLOTS <= 32, "EEPROM_CONFIG_SLOTS must be in [2, 32]");
+    static_assert(MaxOutputs > 0 && RECORD_SIZE < 255, "The store holds 1 to 49 outputs");
+    static_assert(EEPROM_CONFIG_ADDRESS + SLOTS * RECORD_SIZE <= eeprom_access::RECIPE_REGION,
+                  "The slots overlap the recipes' region of the EEPROM");
+
+    explicit ConfigStoreActor(const led::OutputTable& output_table) : outputs(output_table) {}
+    ConfigStoreActor(const ConfigStoreActor&) = delete;
+    ConfigStoreActor& operator=(const ConfigStoreActor&) = delete;
+
+    // Applies the newest saved configuration to the outputs; false if there is none (or the store is disabled), and
+    // the current one is then saved with the first change
+    bool begin() {
+        snapshot(image_);
+        if (!ENABLED) {
+            return false;
+        }
+        const bool loaded = load();
+        if (loaded) {
+            apply();
+            snapshot(image_);  // As applied: outputs beyond the record keep their own settings
+        }
+        started_ = true;
+        last_check_ms_ = millis();
+        return loaded;
+    }
+
+    void update() {
+        if (!started_) {
+            return;
+        }
+        if (write_pos_ < RECORD_SIZE) {
+            write_step();
+            return;
+        }
+        const std::uint32_t now = millis();
+        if (now - last_check_ms_ < CHECK_MS) {
+            return;
+        }
+        last_check_ms_ = now;
+        std::uint8_t current[RECORD_SIZE];
+        snapshot(current);
+        if (std::memcmp(current + BODY, image_ + BODY, BODY_SIZE) != 0) {
+            std::memcpy(image_ + BODY, current + BODY, BODY_SIZE);
+            if (!dirty_) {
+                dirty_ = true;
+                first_change_ms_ = now;
+            }
+            last_change_ms_ = now;
+            return;
+        }
+        if (dirty_ && (now - last_change_ms_ >= COALESCE_MS || now - first_change_ms_ >= MAX_DELAY_MS)) {
+            dirty_ = false;
+            start_write();
+        }
+    }
+
+    // True while changes wait for their write or are being written
+    bool pending() const { return dirty_ || write_pos_ < RECORD_SIZE; }
+
+    std::uint16_t writes() const { return writes_; }  // Records written since boot; saturates at 65535
+    std::uint8_t slot() const { return slot_; }       // Of the newest record
+
+private:
+    static constexpr std::size_t BODY = 2;  // The count and the entries, which the sequence number and CRC enclose
+    static constexpr std::size_t BODY_SIZE = RECORD_SIZE - BODY - binary_frame::CRC_SIZE;
+
+    const led::OutputTable& outputs;
+    std::uint8_t image_[RECORD_SIZE] = {};   // The configuration last seen, as a record
+    std::uint32_t last_check_ms_ = 0;
+    std::uint32_t first_change_ms_ = 0;
+    std::uint32_t last_change_ms_ = 0;
+    std::uint16_t seq_ = 0;                  // Of the newest record
+    std::uint16_t writes_ = 0;
+    std::uint8_t slot_ = SLOTS - 1U;         // So the first record goes to slot 0
+    std::uint8_t write_pos_ = RECORD_SIZE;   // Next byte of image_ to write; RECORD_SIZE when idle
+    bool dirty_ = false;
+    bool started_ = false;
+
+    static std::uint16_t slot_address(std::uint8_t slot) {
+        return static_cast<std::uint16_t>(EEPROM_CONFIG_ADDRESS + slot * RECORD_SIZE);
+    }
+
+    std::uint8_t count() const { return outputs.size() < MaxOutputs ? outputs.size() : MaxOutputs; }
+
+    // The record of the current configuration, without sequence number and CRC, into `record`
+    void snapshot(std::uint8_t* record) const {
+        std::memset(record, 0, RECORD_SIZE);
+        record[2] = count();
+        for (std::uint8_t i = 0; i < count(); ++i) {
+            const led::OutputRef output = outputs.at(i);
+            std::uint8_t* entry = record + HEADER_SIZE + i * ENTRY_SIZE;
+            binary_frame::write_le32(entry, output.blink_interval_ms());
+            entry[4] = output.state_id() != led::STATE_STOPPED ? RUNNING : 0;
+        }
+    }
+
+    // Finds the newest record whose CRC holds, trying older ones after a bad one, and reads it into image_
+    bool load() {
+        std::uint16_t seqs[SLOTS];
+        std::uint32_t candidates = 0;
+        for (std::uint8_t s = 0; s < SLOTS; ++s) {
+            std::uint8_t header[HEADER_SIZE];
+            eeprom_access::read_block(header, slot_address(s), HEADER_SIZE);
+            seqs[s] = binary_frame::read_le16(header);
+            if (header[2] <= MaxOutputs) {  // Blank EEPROM reads 0xFF
+                candidates |= 1UL << s;
+            }
+        }
+        while (candidates != 0) {
+            std::uint8_t best = 0;
+            for (std::uint8_t s = 0; s < SLOTS; ++s) {
+                const bool newer = static_cast<std::int16_t>(seqs[s] - seqs[best]) > 0;
+                if ((candidates & (1UL << s)) != 0 && ((candidates & (1UL << best)) == 0 || newer)) {
+                    best = s;
+                }
+            }
+            candidates &= ~(1UL << best);
+            eeprom_access::read_block(image_, slot_address(best), RECORD_SIZE);
+            if (binary_frame::crc_ok(image_, RECORD_SIZE)) {
+                seq_ = seqs[best];
+                slot_ = best;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void apply() {
+        const std::uint8_t n = image_[2] < count() ? image_[2] : count();
+        for (std::uint8_t i = 0; i < n; ++i) {
+            const led::OutputRef output = outputs.at(i);
+            const std::uint8_t* entry = image_ + HEADER_SIZE + i * ENTRY_SIZE;
+            const std::uint32_t interval = binary_frame::read_le32(entry);
+            if (interval >= MIN_INTERVAL_MS && interval <= MAX_INTERVAL_MS) {
+                output.set_blink_interval(interval);
+            }
+            if ((entry[4] & RUNNING) != 0) {
+                output.start();
+            } else {
+                output.stop();
+            }
+        }
+    }
+
+    void start_write() {
+        seq_ = static_cast<std::uint16_t>(seq_ + 1U);
+        slot_ = static_cast<std::uint8_t>((slot_ + 1U) % SLOTS);
+        binary_frame::write_le16(image_, seq_);
+        binary_frame::append_crc(image_, RECORD_SIZE - binary_frame::CRC_SIZE);
+        write_pos_ = 0;
+        write_step();
+    }
+
+    // Writes bytes until one has to be programmed, which takes the EEPROM until a later pass
+    void write_step() {
+        while (write_pos_ < RECORD_SIZE && eeprom_access::ready()) {
+            const std::uint16_t address = static_cast<std::uint16_t>(slot_address(slot_) + write_pos_);
+            const bool programmed = eeprom_access::update_byte(address, image_[write_pos_++]);
+            if (write_pos_ == RECORD_SIZE && writes_ != UINT16_MAX) {
+                ++writes_;
+            }
+            if (programmed) {
+                return;
+            }
+        }
+    }
+};
+
+} // namespace config_store
@@ -0,0 +1,319 @@
+#pragma once
+#include "event.hpp"
+#include "fast_pin.hpp"
+#include "input_record.hpp"
+#include "ramen.hpp"
+#include "ramen_mailbox.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Debounced digital inputs with edge timestamps.
+//
+// Raw edges are caught by interrupts (-D DIGITAL_INPUT_IRQ): the pin-change interrupts of ports B, E0, J and K and the
+// external interrupts INT0..INT7 (ports D0..D3, E4..E7, among them CONTROLLINO_IN0/IN1) read the whole port once and
+// post it with its micros() timestamp to the `samples` mailbox. Pins on other ports, and all pins without the flag,
+// are read by update() instead, one PINx read per port.
+//
+// A raw change only arms the sampling timer. Each sampling tick reads the ports and runs them through a vertical
+// counter: two bytes per port hold a 2-bit counter for each of its 8 pins, so one port is debounced with a handful of
+// logic operations whatever the number of pins on it. A pin's debounced level follows the raw level once it has read
+// the same for DEBOUNCE_SAMPLES ticks in a row; shorter pulses are dropped. Every change is published on edge_out
+// with the time of the raw edge that started it, not that of the tick that confirmed it. Once every port has settled
+// the timer is disarmed again, so idle inputs cost no timer ticks:
+//
+//     din::DigitalInputActor<2> inputs({CONTROLLINO_IN0, CONTROLLINO_IN1});  // 1 ms ticks: 4 ms debounce
+//     void setup() {
+//         inputs.arm_timer_request_out >> timer.arm_timer_request_in;
+//         inputs.disarm_timer_request_out >> timer.disarm_timer_request_in;
+//         inputs.edge_out >> counter.edge_in;
+//         inputs.start();
+//     }
+//     void loop() { inputs.update(); ... }
+//
+// The raw levels the actor takes in are recorded with -D INPUT_RECORD; with -D INPUT_REPLAY it reads the replayed ones
+// instead of the pins, polling them all in update() (see input_record.hpp).
+//
+// The interrupt vectors (src/digital_input.cpp) and the mailbox are global, so a firmware has one input actor. INTn
+// pins are hooked through attachInterrupt(); pin-change vectors are defined directly and cannot be shared with a
+// library defining them, such as SoftwareSerial.
+
+namespace din {
+
+constexpr std::uint8_t DEBOUNCE_SAMPLES = 4;  // Fixed by the 2-bit vertical counters
+constexpr std::uint8_t NO_PORT = 0xFF;
+
+struct EdgeEvent {
+    std::uint8_t pin;
+    bool level;             // Debounced level after the edge
+    std::uint32_t time_us;  // micros() at the first raw edge of the change
+};
+
+// Port levels as captured by an interrupt
+struct Sample {
+    std::uint8_t port;  // Port index 0..PORT_COUNT-1 (A..L)
+    std::uint8_t levels;
+    std::uint32_t time_us;
+};
+
+using PortBits = std::array<std::uint8_t, gpio::detail::PORT_COUNT>;
+
+// Filled by the interrupts, drained by DigitalInputActor::update()
+inline ramen::SpscMailbox<Sample, 16> samples;
+inline PortBits irq_mask{};    // Pins of each port watched by an interrupt; set before the interrupts are enabled
+inline PortBits irq_levels{};  // Watched levels as last posted; interrupt side only
+
+// Called first by every capture with all levels of the port, still in the interrupt (see interlock.hpp)
+inline void (*port_hook)(std::uint8_t port, std::uint8_t levels) = nullptr;
+
+// Interrupt side: posts the watched pins of a port if any of them changed
+inline void capture(std::uint8_t port) {
+    const std::uint8_t mask = irq_mask[port];
+#if defined(__AVR__) && defined(PORTA)
+    const std::uint8_t raw = *gpio::detail::port_register(port, true);
+#else
+    const std::uint8_t raw = 0;
+#endif
+    if (port_hook != nullptr) {
+        port_hook(port, raw);
+    }
+    const std::uint8_t levels = static_cast<std::uint8_t>(raw & mask);
+    if (((levels ^ irq_levels[port]) & mask) == 0) {
+        return;
+    }
+    if (samples.push(Sample{port, levels, static_cast<std::uint32_t>(micros())})) {
+        irq_levels[port] = levels;
+    }
+}
+
+#if defined(__AVR__) && defined(DIGITAL_INPUT_IRQ)
+constexpr bool IRQ_ENABLED = true;
+
+template <gpio::detail::Port P>
+void capture_port() {
+    capture(static_cast<std::uint8_t>(static_cast<std::uint8_t>(P) - 1U));
+}
+
+// Hooks a pin to its pin-change or external interrupt; false if it has neither
+inline bool enable_interrupt(std::uint8_t pin) {
+    using gpio::detail::Port;
+    const Port port = gpio::detail::pin_port(pin);
+    const std::uint8_t bit = gpio::detail::pin_bit(pin);
+    const std::uint8_t mask = static_cast<std::uint8_t>(1U << bit);
+    const std::uint8_t index = static_cast<std::uint8_t>(static_cast<std::uint8_t>(port) - 1U);
+    if (port == Port::D && bit < 4U) {
+        irq_mask[index] |= mask;
+        attachInterrupt(digitalPinToInterrupt(pin), &capture_port<Port::D>, CHANGE);
+    } else if (port == Port::E && bit >= 4U) {
+        irq_mask[index] |= mask;
+        attachInterrupt(digitalPinToInterrupt(pin), &capture_port<Port::E>, CHANGE);
+    } else if (port == Port::B) {
+        irq_mask[index] |= mask;
+        PCMSK0 |= mask;
+        PCICR |= _BV(PCIE0);
+    } else if ((port == Port::E && bit == 0U) || (port == Port::J && bit < 7U)) {
+        irq_mask[index] |= mask;
+        PCMSK1 |= (port == Port::E) ? 1U : static_cast<std::uint8_t>(mask << 1U);  // PCINT8 is PE0, PCINT9.. PJ0..
+        PCICR |= _BV(PCIE1);
+    } else if (port == Port::K) {
+        irq_mask[index] |= mask;
+        PCMSK2 |= mask;
+        PCICR |= _BV(PCIE2);
+    } else {
+        return false;
+    }
+    return true;
+}
+#else
+constexpr bool IRQ_ENABLED = false;
+inline bool enable_interrupt(std::uint8_t) { return false; }
+#endif
+
+template <std::uint8_t Inputs>
+class DigitalInputActor {
+public:
+    ramen::Pusher<EdgeEvent> edge_out;
+    ramen::Pushable<Sample> sample_in = [this](const Sample& s) {
+        note(s.port, irq_mask[s.port], s.levels, s.time_us);
+    };
+
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    ramen::Pushable<const BaseEvent&> event_handler_in = [this](const BaseEvent& event) {
+        EventRouter<AppEvents, DigitalInputActor, TickEvent>::dispatch(*this, event);
+    };
+
+    // Pins outside the pin table of fast_pin.hpp are ignored; the debounce time is DEBOUNCE_SAMPLES * sample_ms
+    explicit DigitalInputActor(const std::array<std::uint8_t, Inputs>& input_pins, std::uint16_t sample_ms = 1,
+                               bool pullup = false) :
+        pins_(input_pins), sample_ms_(sample_ms > 0 ? sample_ms : 1) {
+        ct0_.fill(0xFF);
+        ct1_.fill(0xFF);
+        for (std::uint8_t i = 0; i < Inputs; ++i) {
+            const gpio::detail::Port port = gpio::detail::pin_port(pins_[i]);
+            port_[i] = NO_PORT;
+            if (port == gpio::detail::Port::NONE) {
+                continue;
+            }
+            port_[i] = static_cast<std::uint8_t>(static_cast<std::uint8_t>(port) - 1U);
+            mask_[i] = static_cast<std::uint8_t>(1U << gpio::detail::pin_bit(pins_[i]));
+            in_mask_[port_[i]] |= mask_[i];
+            pinMode(pins_[i], pullup ? INPUT_PULLUP : INPUT);
+        }
+        timeout_event_relay_out >> event_handler_in;
+        samples.out >> sample_in;
+    }
+
+    // Takes the current levels as debounced without publishing them and enables the interrupts
+    void start() {
+        for (std::uint8_t port = 0; port < gpio::detail::PORT_COUNT; ++port) {
+            if (in_mask_[port] != 0) {
+                state_[port] = read_port(port);
+                input_record::port(port, in_mask_[port], state_[port]);
+            }
+        }
+        irq_levels = state_;  // Before any interrupt is enabled
+        for (std::uint8_t i = 0; i < Inputs; ++i) {
+            if (port_[i] != NO_PORT && (input_record::REPLAY || !enable_interrupt(pins_[i]))) {
+                poll_mask_[port_[i]] |= mask_[i];
+            }
+        }
+    }
+
+    // From loop(): takes over the captured edges and reads the pins no interrupt watches
+    void update() {
+        samples.drain();
+        if (samples.dropped() != dropped_seen_) {
+            dropped_seen_ = samples.dropped();  // Edges were lost; the sampling ticks read the ports themselves
+            arm_sampling();
+        }
+        const std::uint32_t now = static_cast<std::uint32_t>(micros());
+        for (std::uint8_t port = 0; port < gpio::detail::PORT_COUNT; ++port) {
+            if (poll_mask_[port] != 0) {
+                note(port, poll_mask_[port], read_port(port), now);
+            }
+        }
+    }
+
+    // Routed from event_handler_in: one debounce sample of every port in use
+    void on_event(const TickEvent&) {
+        bool settled = true;
+        for (std::uint8_t port = 0; port < gpio::detail::PORT_COUNT; ++port) {
+            if (in_mask_[port] == 0) {
+                continue;
+            }
+            const std::uint8_t raw = read_port(port);
+            input_record::port(port, in_mask_[port], raw);
+            std::uint8_t changed = static_cast<std::uint8_t>(state_[port] ^ raw);
+            // Counters of unchanged pins reset to 3; those of changed pins count down and roll over on the 4th sample
+            ct0_[port] = static_cast<std::uint8_t>(~(ct0_[port] & changed));
+            ct1_[port] = static_cast<std::uint8_t>(ct0_[port] ^ (ct1_[port] & changed));
+            changed &= static_cast<std::uint8_t>(ct0_[port] & ct1_[port]);
+            state_[port] ^= changed;
+            if (changed != 0) {
+                publish(port, changed);
+            }
+            pending_[port] &= static_cast<std::uint8_t>(state_[port] ^ raw);  // Timestamps of glitches are dropped
+            settled = settled && state_[port] == raw;
+        }
+        if (settled) {
+            disarm_sampling();
+        }
+    }
+
+    // Debounced level of input i
+    bool level(std::uint8_t i) const {
+        return i < Inputs && port_[i] != NO_PORT && (state_[port_[i]] & mask_[i]) != 0;
+    }
+
+    bool sampling() const { return timer_handle_.valid(); }
+
+private:
+    const std::array<std::uint8_t, Inputs> pins_;
+    std::array<std::uint8_t, Inputs> port_{};
+    std::array<std::uint8_t, Inputs> mask_{};
+    std::array<std::uint32_t, Inputs> edge_time_us_{};
+
+    PortBits in_mask_{};
+    PortBits poll_mask_{};  // Pins read by update()
+    PortBits state_{};      // Debounced levels
+    PortBits ct0_;          // Vertical counters, bit i of both for pin i
+    PortBits ct1_;
+    PortBits pending_{};    // Pins whose edge time is recorded, until the change is published or dropped
+
+    const std::uint16_t sample_ms_;
+    TimerHandle timer_handle_;
+    std::uint8_t dropped_seen_ = 0;
+
+    // Raw levels of the pins in `mask`: notes the time of the first edge away from the debounced level
+    void note(std::uint8_t port, std::uint8_t mask, std::uint8_t levels, std::uint32_t time_us) {
+        input_record::port(port, mask, levels);
+        const std::uint8_t away = static_cast<std::uint8_t>((levels ^ state_[port]) & mask & in_mask_[port]);
+        const std::uint8_t fresh = static_cast<std::uint8_t>(away & ~pending_[port]);
+        if (fresh != 0) {
+            for (std::uint8_t i = 0; i < Inputs; ++i) {
+                if (port_[i] == port && (fresh & mask_[i]) != 0) {
+                    edge_time_us_[i] = time_us;
+                }
+            }
+            pending_[port] |= fresh;
+        }
+        if (away != 0) {
+            arm_sampling();
+        }
+    }
+
+    void publish(std::uint8_t port, std::uint8_t changed) {
+        const std::uint32_t now = static_cast<std::uint32_t>(micros());
+        for (std::uint8_t i = 0; i < Inputs; ++i) {
+            if (port_[i] == port && (changed & mask_[i]) != 0) {
+                const EdgeEvent edge{pins_[i], (state_[port] & mask_[i]) != 0,
+                                     (pending_[port] & mask_[i]) ? edge_time_us_[i] : now};
+                edge_out(edge);
+            }
+        }
+        pending_[port] &= static_cast<std::uint8_t>(~changed);
+    }
+
+    void arm_sampling() {
+        if (!timer_handle_.valid()) {
+            ArmTimerEvt evt(sample_ms_, &timeout_event_relay_out, true, &timer_handle_);
+            arm_timer_request_out(evt);
+        }
+    }
+
+    void disarm_sampling() {
+        if (timer_handle_.valid()) {
+            DisarmTimerEvt evt(timer_handle_);
+            disarm_timer_request_out(evt);
+            timer_handle_ = TimerHandle{};
+        }
+    }
+
+#if defined(INPUT_REPLAY)
+    std::uint8_t read_port(std::uint8_t port) const {
+        return static_cast<std::uint8_t>(input_record::replayed_levels(port) & in_mask_[port]);
+    }
+#elif defined(__AVR__) && defined(PORTA)
+    std::uint8_t read_port(std::uint8_t port) const {
+        return static_cast<std::uint8_t>(*gpio::detail::port_register(port, true) & in_mask_[port]);
+    }
+#else
+    std::uint8_t read_port(std::uint8_t port) const {
+        std::uint8_t levels = 0;
+        for (std::uint8_t i = 0; i < Inputs; ++i) {
+            if (port_[i] == port && digitalRead(pins_[i])) {
+                levels |= mask_[i];
+            }
+        }
+        return levels;
+    }
+#endif
+};
+
+} // namespace din
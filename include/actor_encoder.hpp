@@ -0,0 +1,197 @@
+#pragma once
+#include "fast_pin.hpp"
+#include "ramen.hpp"
+#include "ramen_latch.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
+
+// A quadrature encoder on two pins of one pin-change port, decoded in the interrupt and read at scan rate.
+//
+// Every edge on A or B enters the port's pin-change interrupt (src/encoder.cpp), which reads the port once and looks
+// the step up in a 16-entry table by the previous and the new AB state: +1, -1, or 0 for no change and for a jump of
+// both bits, which is a missed edge and counted in errors(). The position accumulates in a SeqLatch written by the
+// interrupt alone, so the interrupt never waits and the main loop reads the 32 bits without tearing or holding off
+// interrupts. update() reads it once per scan, derives the velocity over a window of the scan clock and publishes
+// both:
+//
+//     encoder::EncoderActor axis(100);  // Velocity over 100 ms windows
+//
+//     void setup() {
+//         axis.motion_out >> positioner.motion_in;
+//         axis.begin();
+//     }
+//     void loop() { axis.update(); ... }
+//
+// Counts are in quarter periods (x4 decoding), positive while A leads B. The table is in RAM, a load cheaper than
+// the LPM of a flash table; with the pin-change entry and exit an edge costs about 90 cycles, 6 us at 16 MHz, so
+// 20 kHz of edges takes about an eighth of the CPU. Edges closer than the interrupt's latency (other interrupts
+// running, cli() sections) fuse into a jump the table cannot resolve and show as errors.
+//
+// The pins are ENCODER_PIN_A and ENCODER_PIN_B, by default 62 and 63 (A8 and A9, PK0 and PK1), both on port B
+// (PCINT0) or port K (PCINT2). With -D DIGITAL_INPUT_IRQ the digital inputs own those vectors and call
+// on_pin_change() first, so both work from one interrupt. One encoder per firmware, as the vector is global.
+// Opt-in with -D QUADRATURE_ENCODER; without it begin() does nothing. Off AVR the pins are detail::host_levels, taken
+// by detail::on_edge().
+
+#ifndef ENCODER_PIN_A
+#define ENCODER_PIN_A 62
+#endif
+#ifndef ENCODER_PIN_B
+#define ENCODER_PIN_B 63
+#endif
+#if ENCODER_PIN_A >= 62 && ENCODER_PIN_A <= 69  // Port K, else port B (checked below)
+#define ENCODER_PCINT_VECT PCINT2_vect
+#else
+#define ENCODER_PCINT_VECT PCINT0_vect
+#endif
+
+namespace encoder {
+
+#if defined(QUADRATURE_ENCODER)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+using gpio::detail::Port;
+
+constexpr Port PORT = gpio::detail::port_of(ENCODER_PIN_A);
+constexpr std::uint8_t BIT_A = gpio::detail::PIN_BIT[ENCODER_PIN_A];
+constexpr std::uint8_t BIT_B = gpio::detail::PIN_BIT[ENCODER_PIN_B];
+
+static_assert(PORT == gpio::detail::port_of(ENCODER_PIN_B), "ENCODER_PIN_A and ENCODER_PIN_B share a port");
+static_assert(PORT == Port::B || PORT == Port::K, "The encoder pins are on port B (PCINT0) or port K (PCINT2)");
+static_assert(BIT_A != BIT_B, "ENCODER_PIN_A and ENCODER_PIN_B are two pins");
+
+struct Motion {
+    std::int32_t position;  // Counts
+    std::int32_t velocity;  // Counts per second over the last window
+};
+
+namespace detail {
+
+// The step from the previous AB state (bits 3-2) to the new one (bits 1-0), A the higher bit of each
+constexpr std::int8_t STEPS[16] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
+
+inline ramen::SeqLatch<std::int32_t> position;  // Written by the interrupt only
+inline volatile std::uint8_t errors = 0;        // Interrupt side, saturating at 255
+inline std::uint8_t state = 0;                  // AB as of the last edge; interrupt side once begun
+
+#if !defined(__AVR__)
+inline std::uint8_t host_levels = 0;  // Off the board: the port's input levels
+#endif
+
+inline std::uint8_t read_ab() {
+#if defined(__AVR__) && defined(PORTA)
+    const std::uint8_t pins = gpio::detail::PortRegs<PORT>::in();
+#else
+    const std::uint8_t pins = host_levels;
+#endif
+    return static_cast<std::uint8_t>((((pins >> BIT_A) & 1U) << 1) | ((pins >> BIT_B) & 1U));
+}
+
+// Interrupt side: one edge on A or B
+inline void on_edge() {
+    const std::uint8_t ab = read_ab();
+    const std::uint8_t index = static_cast<std::uint8_t>((state << 2) | ab);
+    const std::int8_t step = STEPS[index];
+    if (step != 0) {
+        position.write(position.unsafe_value() + step);
+    } else if ((state ^ ab) == 3U && errors != UINT8_MAX) {
+        errors = static_cast<std::uint8_t>(errors + 1U);
+    }
+    state = ab;
+}
+
+} // namespace detail
+
+// Called by the pin-change vector of port P, whichever source file defines it
+template <Port P>
+inline void on_pin_change() {
+    if (ENABLED && P == PORT) {
+        detail::on_edge();
+    }
+}
+
+class EncoderActor {
+public:
+    explicit EncoderActor(std::uint16_t window_ms = 100) : window_ms_((window_ms == 0) ? 1 : window_ms) {}
+    EncoderActor(const EncoderActor&) = delete;
+    EncoderActor& operator=(const EncoderActor&) = delete;
+
+    // Output: position and velocity, after each scan that changed either
+    ramen::Pusher<Motion> motion_out;
+
+    // Takes the pins' state and enables their pin-change interrupt
+    void begin(bool pullup = true) {
+        if (!ENABLED) {
+            return;
+        }
+        pinMode(ENCODER_PIN_A, pullup ? INPUT_PULLUP : INPUT);
+        pinMode(ENCODER_PIN_B, pullup ? INPUT_PULLUP : INPUT);
+        detail::state = detail::read_ab();
+#if defined(__AVR__) && defined(QUADRATURE_ENCODER)
+        const std::uint8_t mask = static_cast<std::uint8_t>(_BV(BIT_A) | _BV(BIT_B));
+        if (PORT == Port::B) {
+            PCIFR = _BV(PCIF0);
+            PCMSK0 |= mask;
+            PCICR |= _BV(PCIE0);
+        } else {
+            PCIFR = _BV(PCIF2);
+            PCMSK2 |= mask;
+            PCICR |= _BV(PCIE2);
+        }
+#endif
+        window_start_ = scan_clock::now();
+        window_position_ = position();
+        started_ = true;
+    }
+
+    // Once per scan
+    void update() {
+        if (!started_) {
+            return;
+        }
+        const std::int32_t now_position = position();
+        bool changed = now_position != motion_.position;
+        motion_.position = now_position;
+        const std::uint32_t elapsed = scan_clock::now() - window_start_;
+        if (elapsed >= window_ms_) {
+            const std::int64_t counts = static_cast<std::int64_t>(now_position) - window_position_;
+            const std::int32_t velocity = static_cast<std::int32_t>(counts * 1000 / static_cast<std::int64_t>(elapsed));
+            changed = changed || velocity != motion_.velocity;
+            motion_.velocity = velocity;
+            window_start_ += elapsed;
+            window_position_ = now_position;
+        }
+        if (changed) {
+            motion_out(motion_);
+        }
+    }
+
+    // Counts since begin(), less the offset of set_position()
+    std::int32_t position() const { return detail::position.read() - offset_; }
+    std::int32_t velocity() const { return motion_.velocity; }
+    std::uint8_t errors() const { return detail::errors; }  // Missed edges, saturating at 255
+
+    // The position from here on counts from `value`; the interrupt's count is left alone
+    void set_position(std::int32_t value) {
+        const std::int32_t old = position();
+        offset_ += old - value;
+        window_position_ -= old - value;
+    }
+
+private:
+    const std::uint16_t window_ms_;
+    bool started_ = false;
+    std::int32_t offset_ = 0;
+    Motion motion_{0, 0};
+    scan_clock::Timestamp window_start_ = 0;
+    std::int32_t window_position_ = 0;
+};
+
+} // namespace encoder
@@ -0,0 +1,482 @@
+#pragma once
+#include "actor_wall_clock.hpp"
+#include "binary_frame.hpp"
+#include "eeprom_access.hpp"
+#include "fast_pin.hpp"
+#include "output_registry.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#if defined(__AVR__)
+#include <SPI.h>
+#endif
+
+// A log of alarms, commands and output state changes that survives a reset, stamped with the time of the RTC and
+// kept in EEPROM, or in an SPI FRAM for a log that outlives the EEPROM's endurance. log() only queues the record in
+// RAM; update() appends the queued records to the open page of the log, once they fill the page or FLUSH_MS after the
+// oldest of them, so the records of a burst are written together and logging never waits for the memory:
+//
+//     event_log::EventLogActor<> log;                               // In the EEPROM's event log region
+//     void setup() {
+//         log.begin();                                              // Finds the newest record, and the RTC's time
+//         log.watch(outputs);                                       // Records of the outputs' settings
+//         log.log(event_log::BOOT, 0, step_watchdog::reset_cause);  // MCUSR itself is cleared before setup()
+//         commander.attach_event_log(log);                          // Read by the LOG_READ request
+//     }
+//     void loop() { log.update(); ... }
+//     ...     log.log(event_log::ALARM, sensor_id, temperature.raw());
+//
+// A record is 8 bytes, time:u32 source value:u16 kind: the time in seconds since 2000-01-01 00:00 (of the Controllino
+// RTC read by begin(), or set with set_time(); seconds since boot until then), a kind, the source within the kind
+// (e.g. the output id) and a value. Records are numbered from 0 as they are logged, and the number of a record gives
+// its place: RECORDS_PER_PAGE records to a page, pages in a ring over the region, so the newest pages overwrite the
+// oldest. A page ends in its own number, which tells a page of this lap from one of the last, and an index header
+// in two alternating copies holds the number of the open page, rewritten once a page is full. begin() thus recovers
+// the log from the header and the open page alone, whatever the size of the log. A record is valid once its kind,
+// its last byte, is written, so a record cut short by a power loss is dropped, not misread; records still queued in
+// RAM are lost.
+//
+// Writing never waits: to EEPROM a byte whenever it is ready (3.4 ms a byte, a page of 36 bytes in 0.12 s), to FRAM a
+// page in one SPI transfer of some 50 us. The index header is written once every RECORDS_PER_PAGE records: at the
+// EEPROM's 100000 erase cycles, with the two copies, 800000 records outlast the header.
+//
+// Opt-in with -D EVENT_LOG. Without it begin() reads nothing and log() drops every record. Off AVR both memories are
+// arrays in RAM.
+
+#ifndef EVENT_LOG_QUEUE
+#define EVENT_LOG_QUEUE 8  // Records waiting in RAM for their write
+#endif
+
+namespace event_log {
+
+#if defined(EVENT_LOG)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+enum Kind : std::uint8_t {
+    BOOT = 0x01,     // Value: the reset cause, MCUSR as step_watchdog::reset_cause saved it
+    ALARM = 0x02,
+    COMMAND = 0x03,  // Source: the output id, value: the LedCommandEvent::Type
+    STATE = 0x04,    // Source: the output id, value: 1 running, 0 stopped
+    INTERVAL = 0x05,  // Source: the output id, value: the blink interval in ms, at most 65535
+    USER = 0x10,     // Kinds of the application from here up
+    EMPTY = 0xFF     // Not written
+};
+
+constexpr std::uint8_t RECORD_SIZE = 8;
+constexpr std::uint8_t RECORDS_PER_PAGE = 4;
+constexpr std::uint8_t PAGE_SIZE = RECORDS_PER_PAGE * RECORD_SIZE + 4;  // The records, then the page number
+constexpr std::uint8_t HEADER_SIZE = 4 + binary_frame::CRC_SIZE;       // Open page number, CRC
+
+struct Event {
+    std::uint8_t kind;
+    std::uint8_t source;
+    std::uint16_t value;
+};
+
+// A query of the binary protocol's LOG_READ: the records from number `from` on, or from the oldest one kept
+struct ReadEvent {
+    struct Reply {
+        bool handled = false;
+        std::uint8_t count = 0;   // Records copied
+        std::uint32_t first = 0;  // Number of the first of them
+        std::uint32_t next = 0;   // Number the next record logged will take
+    };
+    std::uint32_t from;
+    std::uint8_t* records;  // Room for `max` records
+    std::uint8_t max;
+    Reply* reply;
+};
+
+// The event log region of the internal EEPROM (see eeprom_access.hpp)
+struct EepromStorage {
+    static constexpr std::uint16_t SIZE = eeprom_access::LOGIC_PROGRAM_REGION - eeprom_access::EVENT_LOG_REGION;
+
+    static void begin() {}
+
+    static void read(std::uint16_t address, std::uint8_t* data, std::uint8_t length) {
+        eeprom_access::read_block(data, static_cast<std::uint16_t>(eeprom_access::EVENT_LOG_REGION + address), length);
+    }
+
+    // Writes from `data` until a byte has to be programmed, which takes the EEPROM until a later call; returns the
+    // bytes done
+    static std::uint8_t write(std::uint16_t address, const std::uint8_t* data, std::uint8_t length) {
+        std::uint8_t done = 0;
+        while (done < length && eeprom_access::ready()) {
+            const std::uint16_t at = static_cast<std::uint16_t>(eeprom_access::EVENT_LOG_REGION + address + done);
+            if (eeprom_access::update_byte(at, data[done++])) {
+                break;
+            }
+        }
+        return done;
+    }
+};
+
+// An SPI FRAM (MB85RS64V and the like: READ, WRITE and WREN with a 16-bit address) of `Size` bytes, its chip select
+// on CsPin, at 8 MHz on the bus of the W5100. Writes complete with the transfer
+template <std::uint8_t CsPin, std::uint16_t Size = 8192>
+struct FramStorage {
+    static constexpr std::uint16_t SIZE = Size;
+
+    static void begin() {
+        gpio::FastPin<CsPin>::make_output();
+        gpio::FastPin<CsPin>::high();
+#if defined(__AVR__)
+        SPI.begin();
+#endif
+    }
+
+    static void read(std::uint16_t address, std::uint8_t* data, std::uint8_t length) {
+#if defined(__AVR__)
+        select(READ, address);
+        for (std::uint8_t i = 0; i < length; ++i) {
+            data[i] = SPI.transfer(0);
+        }
+        deselect();
+#else
+        std::memcpy(data, host_fram.data() + address, length);
+#endif
+    }
+
+    static std::uint8_t write(std::uint16_t address, const std::uint8_t* data, std::uint8_t length) {
+#if defined(__AVR__)
+        select(WREN, address, false);
+        deselect();
+        select(WRITE, address);
+        for (std::uint8_t i = 0; i < length; ++i) {
+            SPI.transfer(data[i]);
+        }
+        deselect();
+#else
+        std::memcpy(host_fram.data() + address, data, length);
+#endif
+        return length;
+    }
+
+private:
+    enum Opcode : std::uint8_t { WREN = 0x06, WRITE = 0x02, READ = 0x03 };
+
+#if defined(__AVR__)
+    static void select(Opcode opcode, std::uint16_t address, bool addressed = true) {
+        SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+        gpio::FastPin<CsPin>::low();
+        SPI.transfer(opcode);
+        if (addressed) {
+            SPI.transfer(static_cast<std::uint8_t>(address >> 8));
+            SPI.transfer(static_cast<std::uint8_t>(address));
+        }
+    }
+    static void deselect() {
+        gpio::FastPin<CsPin>::high();
+        SPI.endTransaction();
+    }
+#else
+    static inline std::array<std::uint8_t, Size> host_fram = [] {
+        std::array<std::uint8_t, Size> blank{};
+        blank.fill(0xFF);
+        return blank;
+    }();
+#endif
+};
+
+template <class Storage = EepromStorage, std::uint8_t Queue = EVENT_LOG_QUEUE>
+class EventLogActor {
+public:
+    static constexpr std::uint16_t PAGES = (Storage::SIZE - 2U * HEADER_SIZE) / PAGE_SIZE;
+    static constexpr std::uint16_t FLUSH_MS = 2000;  // Longest a record waits in RAM for the page to fill
+    static constexpr std::uint16_t CHECK_MS = 100;   // Of the watched outputs
+    static constexpr std::uint8_t MAX_WATCHED = 16;
+
+    static_assert(PAGES >= 2, "The storage holds at least two pages");
+    static_assert(Queue > 0, "EVENT_LOG_QUEUE must be at least 1");
+
+    // Inputs: events, as log() takes them, and the time in seconds since 2000 (an NTP server's or a host's, say)
+    ramen::Pushable<const Event&> event_in = [this](const Event& e) { log(e.kind, e.source, e.value); };
+    ramen::Pushable<std::uint32_t> time_in = [this](std::uint32_t seconds) { set_time(seconds); };
+
+    // Input: the time of a wall clock (WallClockActor::seconds_out), which then stamps the records instead
+    ramen::Puller<std::uint32_t> seconds_in;
+
+    // Input: LOG_READ queries of the binary protocol (see BinaryEndpointActor)
+    ramen::Pushable<const ReadEvent&> read_in = [this](const ReadEvent& evt) {
+        ReadEvent::Reply& reply = *evt.reply;
+        reply.handled = true;
+        reply.next = next_;
+        reply.first = evt.from > oldest() ? evt.from : oldest();
+        reply.count = 0;
+        while (reply.count < evt.max && read(reply.first + reply.count, evt.records + reply.count * RECORD_SIZE)) {
+            ++reply.count;
+        }
+    };
+
+    EventLogActor() = default;
+    EventLogActor(const EventLogActor&) = delete;
+    EventLogActor& operator=(const EventLogActor&) = delete;
+
+    // Finds the newest record and takes the time of the RTC; false if the storage held no log, which then starts
+    bool begin() {
+        if (!ENABLED) {
+            return false;
+        }
+        Storage::begin();
+        seconds_anchor_ms_ = scan_clock::now();
+        std::uint32_t seconds = 0;
+        if (wall_clock::ControllinoRtc::begin() && wall_clock::ControllinoRtc::read(seconds)) {
+            seconds_ = seconds;
+        }
+        bool found = false;
+        for (std::uint8_t slot = 0; slot < 2; ++slot) {
+            std::uint8_t header[HEADER_SIZE];
+            Storage::read(static_cast<std::uint16_t>(slot * HEADER_SIZE), header, HEADER_SIZE);
+            const std::uint32_t open = binary_frame::read_le32(header);
+            if (binary_frame::crc_ok(header, HEADER_SIZE) && (!found || open > open_)) {
+                open_ = open;
+                found = true;
+            }
+        }
+        load_open_page();
+        started_ = true;
+        return found;
+    }
+
+    // Logs STATE and INTERVAL records as up to MAX_WATCHED outputs start, stop or change their interval (not as they
+    // blink, which would wear the EEPROM out in days)
+    void watch(const led::OutputTable& outputs) {
+        outputs_ = &outputs;
+        for (std::uint8_t i = 0; i < outputs.size() && i < MAX_WATCHED; ++i) {
+            running_[i] = running(i);
+            intervals_[i] = interval(i);
+        }
+    }
+
+    // Queues a record stamped with the current time; false if the queue is full and the record dropped
+    bool log(std::uint8_t kind, std::uint8_t source, std::uint16_t value) {
+        if (!started_ || kind == EMPTY || queued_ >= Queue) {
+            count(dropped_);
+            return false;
+        }
+        std::uint8_t* record = queue_[(queue_head_ + queued_) % Queue].data();
+        binary_frame::write_le32(record, now());
+        record[4] = source;
+        binary_frame::write_le16(record + 5, value);
+        record[7] = kind;
+        if (queued_++ == 0) {
+            queued_since_ = scan_clock::now();
+        }
+        ++next_;
+        return true;
+    }
+
+    void set_time(std::uint32_t seconds) {
+        seconds_ = seconds;
+        seconds_anchor_ms_ = scan_clock::now();
+    }
+
+    // Seconds since 2000 (since boot without a time): the wall clock's if linked, else of the RTC read by begin()
+    std::uint32_t now() {
+        if (seconds_in) {
+            std::uint32_t seconds = 0;
+            seconds_in(seconds);
+            return seconds;
+        }
+        return seconds_ + (scan_clock::now() - seconds_anchor_ms_) / 1000U;
+    }
+
+    // Writes what is due, without waiting for the memory
+    void update() {
+        if (!started_) {
+            return;
+        }
+        const std::uint32_t now_ms = scan_clock::now();
+        while (now_ms - seconds_anchor_ms_ >= 1000U) {  // Keeps the anchor within a second, clear of millis() wrap
+            seconds_anchor_ms_ += 1000U;
+            ++seconds_;
+        }
+        if (outputs_ != nullptr && now_ms - last_check_ms_ >= CHECK_MS) {
+            last_check_ms_ = now_ms;
+            check_outputs();
+        }
+        if (write_left_ > 0) {
+            write_step();
+            return;
+        }
+        if (writing_header_) {
+            writing_header_ = false;
+            open_page(open_ + 1U);
+        }
+        if (fill_ == RECORDS_PER_PAGE) {
+            start_header();
+            return;
+        }
+        const std::uint8_t room = static_cast<std::uint8_t>(RECORDS_PER_PAGE - fill_);
+        if (queued_ == 0 || (queued_ < room && now_ms - queued_since_ < FLUSH_MS)) {
+            return;
+        }
+        start_page(queued_ < room ? queued_ : room);
+    }
+
+    // Numbers of the next record to be logged and of the oldest one kept
+    std::uint32_t next() const { return next_; }
+    std::uint32_t oldest() const {
+        return (open_ >= PAGES - 1U) ? (open_ - (PAGES - 1U)) * RECORDS_PER_PAGE : 0;
+    }
+    std::uint8_t pending() const { return queued_; }  // Not yet written
+    bool idle() const { return queued_ == 0 && write_left_ == 0 && !writing_header_ && fill_ < RECORDS_PER_PAGE; }
+
+    // The record of number n into `record` (RECORD_SIZE bytes); false if it is not kept, or not logged yet
+    bool read(std::uint32_t n, std::uint8_t* record) const {
+        const std::uint32_t page_first = open_ * RECORDS_PER_PAGE;
+        if (n >= next_ || n < oldest()) {
+            return false;
+        }
+        if (n >= page_first + fill_) {
+            std::memcpy(record, queue_[(queue_head_ + (n - page_first - fill_)) % Queue].data(), RECORD_SIZE);
+            return true;
+        }
+        if (n >= page_first) {
+            std::memcpy(record, &page_[(n - page_first) * RECORD_SIZE], RECORD_SIZE);
+            return true;
+        }
+        const std::uint32_t page = n / RECORDS_PER_PAGE;
+        std::uint8_t number[4];
+        Storage::read(static_cast<std::uint16_t>(page_address(page) + RECORDS_PER_PAGE * RECORD_SIZE), number, 4);
+        if (binary_frame::read_le32(number) != page) {
+            return false;
+        }
+        Storage::read(static_cast<std::uint16_t>(page_address(page) + (n % RECORDS_PER_PAGE) * RECORD_SIZE), record,
+                      RECORD_SIZE);
+        return true;
+    }
+
+    // Counters, saturating at 65535
+    std::uint16_t dropped() const { return dropped_; }            // Queue full, or the log disabled
+    std::uint16_t pages_written() const { return pages_written_; }
+
+private:
+    std::array<std::array<std::uint8_t, RECORD_SIZE>, Queue> queue_{};
+    std::array<std::uint8_t, PAGE_SIZE> page_{};  // Image of the open page
+    std::array<std::uint8_t, HEADER_SIZE> header_{};
+    std::array<bool, MAX_WATCHED> running_{};
+    std::array<std::uint16_t, MAX_WATCHED> intervals_{};
+    const led::OutputTable* outputs_ = nullptr;
+    std::uint32_t open_ = 0;        // Number of the open page, the one written next
+    std::uint32_t next_ = 0;
+    std::uint32_t seconds_ = 0;     // At seconds_anchor_ms_
+    std::uint32_t seconds_anchor_ms_ = 0;
+    std::uint32_t queued_since_ = 0;
+    std::uint32_t last_check_ms_ = 0;
+    const std::uint8_t* write_from_ = nullptr;  // The write in progress
+    std::uint16_t write_address_ = 0;
+    std::uint8_t write_left_ = 0;
+    std::uint8_t fill_ = 0;         // Records in the open page
+    std::uint8_t queue_head_ = 0;
+    std::uint8_t queued_ = 0;
+    bool page_written_ = false;     // The open page has been written since it was opened
+    bool writing_header_ = false;
+    bool started_ = false;
+    std::uint16_t dropped_ = 0;
+    std::uint16_t pages_written_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    static std::uint16_t page_address(std::uint32_t page) {
+        return static_cast<std::uint16_t>(2U * HEADER_SIZE + (page % PAGES) * PAGE_SIZE);
+    }
+
+    // The open page as stored, or an empty one if the storage holds another page (of the last lap) in its place
+    void load_open_page() {
+        Storage::read(page_address(open_), page_.data(), PAGE_SIZE);
+        fill_ = 0;
+        if (binary_frame::read_le32(&page_[RECORDS_PER_PAGE * RECORD_SIZE]) != open_) {
+            open_page(open_);
+        } else {
+            page_written_ = true;
+            while (fill_ < RECORDS_PER_PAGE && page_[fill_ * RECORD_SIZE + RECORD_SIZE - 1U] != EMPTY) {
+                ++fill_;
+            }
+        }
+        next_ = open_ * RECORDS_PER_PAGE + fill_;  // A full page is closed by the next update(), as if just written
+    }
+
+    void open_page(std::uint32_t page) {
+        open_ = page;
+        page_.fill(EMPTY);
+        binary_frame::write_le32(&page_[RECORDS_PER_PAGE * RECORD_SIZE], page);
+        fill_ = 0;
+        page_written_ = false;
+    }
+
+    void start_write(std::uint16_t address, const std::uint8_t* data, std::uint8_t length) {
+        write_address_ = address;
+        write_from_ = data;
+        write_left_ = length;
+        write_step();
+    }
+
+    void write_step() {
+        const std::uint8_t done = Storage::write(write_address_, write_from_, write_left_);
+        write_address_ = static_cast<std::uint16_t>(write_address_ + done);
+        write_from_ += done;
+        write_left_ = static_cast<std::uint8_t>(write_left_ - done);
+    }
+
+    // Moves `n` queued records into the open page and writes them; the first write of a page writes all of it, so
+    // that the records of the last lap are erased before the page number that would validate them
+    void start_page(std::uint8_t n) {
+        const std::uint8_t first = fill_;
+        for (std::uint8_t i = 0; i < n; ++i) {
+            std::memcpy(&page_[(fill_++) * RECORD_SIZE], queue_[queue_head_].data(), RECORD_SIZE);
+            queue_head_ = static_cast<std::uint8_t>((queue_head_ + 1U) % Queue);
+        }
+        queued_ = static_cast<std::uint8_t>(queued_ - n);
+        queued_since_ = scan_clock::now();
+        if (page_written_) {
+            start_write(static_cast<std::uint16_t>(page_address(open_) + first * RECORD_SIZE),
+                        &page_[first * RECORD_SIZE], static_cast<std::uint8_t>(n * RECORD_SIZE));
+        } else {
+            page_written_ = true;
+            count(pages_written_);
+            start_write(page_address(open_), page_.data(), PAGE_SIZE);
+        }
+    }
+
+    // Names the next page as the open one, in the copy the previous header did not use
+    void start_header() {
+        const std::uint32_t next_page = open_ + 1U;
+        binary_frame::write_le32(header_.data(), next_page);
+        binary_frame::append_crc(header_.data(), 4);
+        writing_header_ = true;
+        start_write(static_cast<std::uint16_t>((next_page & 1U) * HEADER_SIZE), header_.data(), HEADER_SIZE);
+    }
+
+    bool running(std::uint8_t i) const { return outputs_->at(i).state_id() != led::STATE_STOPPED; }
+    std::uint16_t interval(std::uint8_t i) const {
+        const std::uint32_t ms = outputs_->at(i).blink_interval_ms();
+        return ms < UINT16_MAX ? static_cast<std::uint16_t>(ms) : UINT16_MAX;
+    }
+
+    // A change is logged again at the next check if the queue had no room for it
+    void check_outputs() {
+        for (std::uint8_t i = 0; i < outputs_->size() && i < MAX_WATCHED; ++i) {
+            const std::uint8_t id = static_cast<std::uint8_t>(i + 1U);
+            const bool now_running = running(i);
+            if (now_running != running_[i] && log(STATE, id, now_running ? 1U : 0U)) {
+                running_[i] = now_running;
+            }
+            const std::uint16_t ms = interval(i);
+            if (ms != intervals_[i] && log(INTERVAL, id, ms)) {
+                intervals_[i] = ms;
+            }
+        }
+    }
+};
+
+} // namespace event_log
@@ -0,0 +1,149 @@
+#pragma once
+#include "event.hpp"
+#include "ramen.hpp"
+#include "sml.hpp"
+#include "sml_trace.hpp"
+#include <cstdint>
+#include <type_traits>
+
+// State machine plumbing shared by the actors.
+//
+// Boost SML picks how process_event() finds the handler of the current state through a dispatch policy:
+//   switch_stm - a switch over the state index (SML's default)
+//   branch_stm - a chain of comparisons
+//   jump_table - an indexed table of handler pointers per event type; constant time in the number of states, but
+//                on AVR the tables are const data and therefore live in SRAM
+//   fold_expr  - a fold over all states (C++17)
+// Actors take the policy as a template parameter and build their machine with fsm::actor_sm. The 'fsmbench' command
+// (build with -D FSM_BENCHMARK) measures the policies on the target; compare flash use by building with
+// -D LED_FSM_DISPATCH=<policy>. Machines built with traced_sm record their transitions (see sml_trace.hpp).
+//
+// States are numbered by their index in SM::states, the order of first appearance in the transition table; the same
+// ids appear in trace records. current_state_id() reads the state of a machine as such a byte, for status reports.
+
+// Actions and guards of the actor FSMs are written as `[](Context& ctx) FSM_ACTION { ... }`. By default the compiler
+// inlines them into the dispatch code of every transition that uses them; -D FSM_NOINLINE_ACTIONS keeps each one a
+// single out-of-line function instead, trading a call per action for flash (and showing every action separately in
+// tools/fsm_flash_report.py, 'pio run -t fsmreport').
+#if defined(FSM_NOINLINE_ACTIONS)
+#define FSM_ACTION __attribute__((noinline))
+#else
+#define FSM_ACTION
+#endif
+
+namespace fsm {
+
+namespace dispatch {
+using switch_stm = boost::sml::back::policies::switch_stm;
+using branch_stm = boost::sml::back::policies::branch_stm;
+using jump_table = boost::sml::back::policies::jump_table;
+#if defined(__cpp_fold_expressions)
+using fold_expr = boost::sml::back::policies::fold_expr;
+#endif
+} // namespace dispatch
+
+using default_dispatch = dispatch::switch_stm;
+
+template <class Fsm, class Dispatch = default_dispatch, class... Policies>
+using actor_sm = boost::sml::sm<Fsm, boost::sml::dispatch<Dispatch>, Policies...>;
+
+// Machine of an actor whose transitions are recorded by sml_trace when built with -D SML_TRACE. Construct it with
+// the actor's sml_trace::Logger as the first argument in either case; SML ignores dependencies it does not use.
+template <class Fsm, class Dispatch = default_dispatch, class... Policies>
+using traced_sm = std::conditional_t<sml_trace::ENABLED,
+                                     actor_sm<Fsm, Dispatch, boost::sml::logger<sml_trace::Logger>, Policies...>,
+                                     actor_sm<Fsm, Dispatch, Policies...>>;
+
+template <class SM, class State>
+constexpr std::uint8_t state_index_v = sml_trace::detail::index_of<State, typename SM::states>::value;
+
+namespace detail {
+template <class SM, class... States>
+std::uint8_t current_state_id(const SM& sm, boost::sml::aux::type_list<States...>) {
+    // Each probe compares the machine's state byte with a constant; no handler dispatch is involved
+    std::uint8_t id = 0;
+    (void)((sm.is(boost::sml::state<States>) || (++id, false)) || ...);
+    return id;
+}
+} // namespace detail
+
+// Current state of a single-region machine, numbered like state_index_v
+template <class SM>
+std::uint8_t current_state_id(const SM& sm) {
+    return detail::current_state_id(sm, typename SM::states{});
+}
+
+// Timed states: a state that leaves on a timeout declares its timer in the transition table instead of arming and
+// disarming one in its actions. The actor owns one StateTimer, linked to the TimerActor like any timer user and passed
+// to the machine as a dependency; entering a timed state arms it, leaving the state releases it, and the expiry
+// arrives as a state_timeout event:
+//
+//     *state<idle>    + event<start>               = state<heating>,
+//      state<heating> + on_entry<_>                / fsm::after<5000>,  // Or fsm::every<250>: a state_timeout each
+//      state<heating> + on_exit<_>                 / fsm::release_timer,
+//      state<heating> + event<fsm::state_timeout>  = state<idle>
+//
+//     fsm::StateTimer state_timer;                   // In the actor, linked like blinky_led_context's ports
+//     fsm::actor_sm<heater_fsm> sm{context, state_timer};
+//     state_timer.process(sm, start{});              // Instead of sm.process_event(); so is every state_timeout
+//
+// There is one timer handle for all the timed states of a machine, as a single-region machine has one state active:
+// entering a timed state re-arms it in place, and a release only takes effect when no state re-arms it by the end of
+// the event, so a transition from one timed state to another (or to itself, which restarts the timer) costs one arm
+// and no disarm. The timer slot is held only while a timed state is active.
+struct state_timeout {};
+
+class StateTimer {
+public:
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+
+    // Arms the timer, or re-arms it in place if it runs; the entry action of a timed state
+    void start(std::uint32_t interval_ms, bool periodic) {
+        releasing_ = false;
+        ArmTimerEvt evt(interval_ms, &timeout_event_relay_out, periodic, &handle_);
+        arm_timer_request_out(evt);
+    }
+
+    // Releases the timer once the event being processed completes; the exit action of a timed state
+    void release() { releasing_ = true; }
+
+    // Processes an event and then releases the timer if the machine left its timed state for one that is not timed
+    template <class SM, class Event>
+    void process(SM& sm, const Event& event) {
+        sm.process_event(event);
+        settle();
+    }
+
+    // Disarms a timer that was released and not re-armed since; process() calls it after every event
+    void settle() {
+        if (releasing_) {
+            releasing_ = false;
+            if (handle_.valid()) {
+                DisarmTimerEvt evt(handle_);
+                disarm_timer_request_out(evt);
+                handle_ = TimerHandle{};
+            }
+        }
+    }
+
+    // True from the entry of a timed state to its exit (false if TimerActor had no free slot); a one-shot timer that
+    // expired counts until then
+    bool armed() const { return handle_.valid() && !releasing_; }
+
+private:
+    TimerHandle handle_;
+    bool releasing_ = false;
+};
+
+// Entry actions of timed states, and the exit action that goes with them
+template <std::uint32_t Ms>
+inline constexpr auto after = [](StateTimer& timer) FSM_ACTION { timer.start(Ms, false); };
+
+template <std::uint32_t Ms>
+inline constexpr auto every = [](StateTimer& timer) FSM_ACTION { timer.start(Ms, true); };
+
+inline constexpr auto release_timer = [](StateTimer& timer) FSM_ACTION { timer.release(); };
+
+} // namespace fsm
@@ -0,0 +1,367 @@
+#pragma once
+#include "actor_led.hpp"
+#include "fmt.hpp"
+#include "output_registry.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(ETHERNET_HTTP)
+#include <Ethernet.h>
+#endif
+
+// A status page for a browser on the W5100: GET / serves the state of the outputs as HTML, GET /status.json the same
+// as JSON, anything else a 404, for field technicians with a laptop and no serial cable.
+//
+//     http::StatusPageActor status_page(outputs);
+//     void setup() { status_page.begin(mac, {192, 168, 1, 177}); }  // Or begin() once another actor started Ethernet
+//     void loop()  { status_page.update(); ... }
+//
+// No page is held in RAM. A page is a template in flash, streamed by a PageWriter: its text is copied from PROGMEM
+// straight into a CHUNK_SIZE buffer on the stack, as much as the socket's transmit buffer takes right now, and its
+// fields, control characters in the template, are formatted with fmt in place:
+//
+//     "<tr><td>" "\x04" "<td>" "\x05" ...    ID and NAME of the output of the row (see Field)
+//
+// The text between ROWS and END_ROWS is repeated for every output. A connection is served across passes, a step per
+// update(): one accepted at a time, its request read REQUEST_BYTES_PER_UPDATE bytes at a time, its response written
+// MAX_CHUNKS_PER_UPDATE chunks at a time, never more than the socket takes without waiting, so a browser costs the
+// loop a few hundred microseconds per pass however slowly it reads. The response carries no length and ends with the
+// connection ("Connection: close"); a request that is not complete after REQUEST_TIMEOUT_MS is dropped.
+//
+// Opt-in with -D ETHERNET_HTTP; without it the actor does nothing and the Ethernet library is not used. The server
+// takes one of the W5100's four sockets, beside those of net::UdpEndpointActor and mqtt_sn::MqttSnActor.
+
+namespace http {
+
+#if defined(ETHERNET_HTTP)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Fields of the page templates: control characters that page text has no use for
+enum Field : char {
+    UPTIME = 0x01,    // Seconds since reset
+    ROWS = 0x02,      // The text up to END_ROWS, once per output
+    END_ROWS = 0x03,
+    ID = 0x04,        // Of the output of the row, as in the serial commands
+    NAME = 0x05,
+    STATE = 0x06,     // led::state_name_P()
+    INTERVAL = 0x07,  // Blink interval in milliseconds
+    FAULT = 0x08,     // "true" or "false"
+    COMMA = 0x0E      // "," unless the row is the last one
+};
+
+namespace detail {
+
+// clang-format off
+const char PAGE_HTML[] PROGMEM =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nCache-Control: no-store\r\nRefresh: 5\r\nConnection: close\r\n\r\n"
+    "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>Controllino</title></head><body>"
+    "<h1>Controllino</h1><p>Up " "\x01" " s</p>"
+    "<table border=\"1\"><tr><th>Id<th>Name<th>State<th>Interval (ms)<th>Fault"
+    "\x02" "<tr><td>" "\x04" "<td>" "\x05" "<td>" "\x06" "<td>" "\x07" "<td>" "\x08" "\x03"
+    "</table><p><a href=\"/status.json\">JSON</a></p></body></html>\r\n";
+
+const char PAGE_JSON[] PROGMEM =
+    "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n"
+    "{\"uptime_s\":" "\x01" ",\"outputs\":["
+    "\x02" "{\"id\":" "\x04" ",\"name\":\"" "\x05" "\",\"state\":\"" "\x06" "\",\"interval_ms\":" "\x07"
+    ",\"fault\":" "\x08" "}" "\x0E" "\x03"
+    "]}\r\n";
+
+const char PAGE_NOT_FOUND[] PROGMEM =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\nNot found\r\n";
+// clang-format on
+
+const char PATH_HTML[] PROGMEM = "/";
+const char PATH_JSON[] PROGMEM = "/status.json";
+
+// Whether `text`, up to its terminator, equals the flash string `str_P`
+inline bool equals_P(const char* text, const char* str_P) {
+    for (;; ++text, ++str_P) {
+        const char c = static_cast<char>(pgm_read_byte(str_P));
+        if (*text != c) {
+            return false;
+        }
+        if (c == '\0') {
+            return true;
+        }
+    }
+}
+
+} // namespace detail
+
+// Streams a page template, a chunk at a time; the whole state of a response is its position in the template
+class PageWriter {
+public:
+    static constexpr std::uint8_t FIELD_SIZE = 24;  // Longest formatted field, terminator included
+
+    explicit PageWriter(const led::OutputTable& output_table) : outputs(output_table) {}
+
+    void start(const char* page_P) {
+        page_P_ = page_P;
+        pos_ = 0;
+        row_ = 0;
+        done_ = false;
+    }
+
+    bool done() const { return done_; }
+
+    // Writes the next bytes of the page into `out`, up to `room`, and returns their count; a field that does not fit
+    // waits for the next chunk, so a page with fields needs chunks of FIELD_SIZE - 1 bytes to progress
+    std::size_t fill(std::uint8_t* out, std::size_t room) {
+        std::size_t n = 0;
+        while (n < room && !done_) {
+            const char c = static_cast<char>(pgm_read_byte(page_P_ + pos_));
+            if (c == '\0') {
+                done_ = true;
+            } else if (c == '\r' || c == '\n' || static_cast<std::uint8_t>(c) >= 0x20) {
+                out[n++] = static_cast<std::uint8_t>(c);
+                ++pos_;
+            } else if (c == ROWS) {
+                rows_pos_ = static_cast<std::uint16_t>(pos_ + 1U);
+                pos_ = (outputs.size() > 0) ? rows_pos_ : end_of_rows();
+            } else if (c == END_ROWS) {
+                pos_ = (++row_ < outputs.size()) ? rows_pos_ : static_cast<std::uint16_t>(pos_ + 1U);
+            } else {
+                fmt::Line<FIELD_SIZE> text;
+                write_field(text, c);
+                if (text.size() > room - n) {
+                    break;
+                }
+                std::memcpy(out + n, text.c_str(), text.size());
+                n += text.size();
+                ++pos_;
+            }
+        }
+        return n;
+    }
+
+private:
+    const led::OutputTable& outputs;
+    const char* page_P_ = detail::PAGE_NOT_FOUND;
+    std::uint16_t pos_ = 0;
+    std::uint16_t rows_pos_ = 0;  // Of the first character after ROWS
+    std::uint8_t row_ = 0;
+    bool done_ = true;
+
+    // Position after the END_ROWS of the ROWS at pos_
+    std::uint16_t end_of_rows() const {
+        std::uint16_t p = pos_;
+        for (char c; (c = static_cast<char>(pgm_read_byte(page_P_ + p))) != '\0'; ++p) {
+            if (c == END_ROWS) {
+                return static_cast<std::uint16_t>(p + 1U);
+            }
+        }
+        return p;
+    }
+
+    template <class Sink>
+    void write_field(Sink& sink, char field) const {
+        switch (field) {
+        case UPTIME:
+            fmt::write(sink, static_cast<unsigned long>(scan_clock::now() / 1000UL));
+            return;
+        case ID:
+            fmt::write(sink, static_cast<unsigned>(row_ + 1U));
+            return;
+        case NAME:
+            outputs.write_name(sink, row_);
+            return;
+        case STATE:
+            fmt::write(sink, fmt::flash(led::state_name_P(outputs.at(row_).state_id())));
+            return;
+        case INTERVAL:
+            fmt::write(sink, static_cast<unsigned long>(outputs.at(row_).blink_interval_ms()));
+            return;
+        case FAULT:
+            fmt::write(sink, outputs.at(row_).fault() ? "true" : "false");
+            return;
+        case COMMA:
+            fmt::write(sink, (row_ + 1U < outputs.size()) ? "," : "");
+            return;
+        default:
+            return;  // Not a field: left out
+        }
+    }
+};
+
+class StatusPageActor {
+public:
+    static constexpr std::uint16_t DEFAULT_PORT = 80;
+    static constexpr std::uint8_t CHUNK_SIZE = 64;
+    static_assert(CHUNK_SIZE >= PageWriter::FIELD_SIZE, "A chunk holds any field");
+    static constexpr std::uint8_t MAX_CHUNKS_PER_UPDATE = 4;
+    static constexpr std::uint8_t REQUEST_BYTES_PER_UPDATE = 64;
+    static constexpr std::uint32_t REQUEST_TIMEOUT_MS = 2000;
+    static constexpr std::uint16_t CLOSE_TIMEOUT_MS = 10;  // Bounds the wait of EthernetClient::stop() for the FIN
+    static constexpr std::uint8_t MAX_REQUEST_LINE = 24;   // "GET /status.json HTTP/1.1", cut off
+
+    enum class State : std::uint8_t { IDLE, REQUEST, RESPONSE };
+
+    explicit StatusPageActor(const led::OutputTable& output_table) : page_(output_table) {}
+    StatusPageActor(const StatusPageActor&) = delete;
+    StatusPageActor& operator=(const StatusPageActor&) = delete;
+
+    // Starts the Ethernet interface with a static address, then listens as below; false if no W5100 answers
+    bool begin(std::uint8_t (&mac)[6], const std::uint8_t (&ip)[4], std::uint16_t port = DEFAULT_PORT) {
+#if defined(ETHERNET_HTTP)
+        Ethernet.begin(mac, IPAddress(ip[0], ip[1], ip[2], ip[3]));
+        if (Ethernet.hardwareStatus() == EthernetNoHardware) {
+            return false;
+        }
+#else
+        (void)mac;
+        (void)ip;
+#endif
+        return begin(port);
+    }
+
+    // Listens on `port` of an Ethernet interface already up, e.g. by net::UdpEndpointActor::begin(); false without
+    // -D ETHERNET_HTTP
+    bool begin(std::uint16_t port = DEFAULT_PORT) {
+#if defined(ETHERNET_HTTP)
+        server_ = EthernetServer(port);
+        server_.begin();
+        return true;
+#else
+        (void)port;
+        return false;
+#endif
+    }
+
+    // Takes the next step of the connection being served, or accepts one
+    void update() {
+#if defined(ETHERNET_HTTP)
+        switch (state_) {
+        case State::IDLE:
+            client_ = server_.accept();
+            if (client_) {
+                client_.setConnectionTimeout(CLOSE_TIMEOUT_MS);
+                state_ = State::REQUEST;
+                started_ms_ = scan_clock::now();
+                line_length_ = 0;
+                line_done_ = false;
+                blank_line_ = false;
+            }
+            return;
+        case State::REQUEST:
+            read_request();
+            return;
+        case State::RESPONSE:
+            write_response();
+            return;
+        }
+#endif
+    }
+
+    State state() const { return state_; }
+
+    // Counters, saturating at 65535
+    std::uint16_t served() const { return served_; }        // Responses completed, 404s included
+    std::uint16_t not_found() const { return not_found_; }
+    std::uint16_t timeouts() const { return timeouts_; }    // Requests dropped incomplete, or connections lost
+
+private:
+    PageWriter page_;
+    State state_ = State::IDLE;
+    std::uint16_t served_ = 0;
+    std::uint16_t not_found_ = 0;
+    std::uint16_t timeouts_ = 0;
+#if defined(ETHERNET_HTTP)
+    EthernetServer server_{DEFAULT_PORT};
+    EthernetClient client_;
+    std::uint32_t started_ms_ = 0;
+    char line_[MAX_REQUEST_LINE + 1];  // The request line, as far as it fits
+    std::uint8_t line_length_ = 0;
+    bool line_done_ = false;
+    bool blank_line_ = false;          // Nothing but CR since the last LF
+#endif
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+#if defined(ETHERNET_HTTP)
+    // Reads the request line and skips the headers up to the blank line that ends them
+    void read_request() {
+        for (std::uint8_t i = 0; i < REQUEST_BYTES_PER_UPDATE && client_.available() > 0; ++i) {
+            const int c = client_.read();
+            if (!line_done_) {
+                if (c == '\r' || c == '\n') {
+                    line_done_ = true;
+                } else if (line_length_ < MAX_REQUEST_LINE) {
+                    line_[line_length_++] = static_cast<char>(c);
+                }
+            }
+            if (c == '\n') {
+                if (blank_line_) {
+                    line_[line_length_] = '\0';
+                    page_.start(route());
+                    state_ = State::RESPONSE;
+                    return;
+                }
+                blank_line_ = true;
+            } else if (c != '\r') {
+                blank_line_ = false;
+            }
+        }
+        if (!client_.connected() || scan_clock::now() - started_ms_ >= REQUEST_TIMEOUT_MS) {
+            count(timeouts_);
+            close();
+        }
+    }
+
+    // The page of the request line: "GET <target> HTTP/1.x", the query of the target ignored
+    const char* route() {
+        if (std::strncmp(line_, "GET ", 4) == 0) {
+            char* target = line_ + 4;
+            target[std::strcspn(target, " ?")] = '\0';
+            if (detail::equals_P(target, detail::PATH_HTML)) {
+                return detail::PAGE_HTML;
+            }
+            if (detail::equals_P(target, detail::PATH_JSON)) {
+                return detail::PAGE_JSON;
+            }
+        }
+        count(not_found_);
+        return detail::PAGE_NOT_FOUND;
+    }
+
+    void write_response() {
+        if (!client_.connected()) {
+            count(timeouts_);
+            close();
+            return;
+        }
+        for (std::uint8_t i = 0; i < MAX_CHUNKS_PER_UPDATE && !page_.done(); ++i) {
+            const int room = client_.availableForWrite();
+            if (room <= 0) {
+                return;  // The browser reads slowly: the rest on a later pass
+            }
+            std::uint8_t chunk[CHUNK_SIZE];
+            const std::size_t n = page_.fill(chunk, (room < CHUNK_SIZE) ? static_cast<std::size_t>(room) : CHUNK_SIZE);
+            if (n == 0) {
+                return;  // The next field takes more than the room
+            }
+            client_.write(chunk, n);
+        }
+        if (page_.done()) {
+            count(served_);
+            close();
+        }
+    }
+
+    void close() {
+        client_.stop();
+        state_ = State::IDLE;
+    }
+#endif
+};
+
+} // namespace http
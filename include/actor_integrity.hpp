@@ -0,0 +1,294 @@
+#pragma once
+#include "alarm_bank.hpp"
+#include "cycle_counter.hpp"
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#endif
+
+// Background self-test of the program memory and the RAM, for the periodic checks a safety review asks for, in slices
+// small enough to leave the scan time as it was. update() runs one slice at the end of each loop() pass:
+//
+//     integrity::IntegrityActor integrity;
+//
+//     void setup() { integrity.event_out >> alarm_table.event_in; }  // Faults as alarms, see actor_alarm_manager.hpp
+//     void loop()  { ...; scan_monitor::end_busy(); integrity.update(); idle_sleep::sleep(timer); }
+//
+// The flash check is a CRC-32 (IEEE, as zlib's) of the image, from address 0 to the end of the initialized data's
+// copy (__data_load_end), read with the ELPM of pgm_read_dword_far() a word of four bytes at a time and folded in
+// byte by byte through a table of 256 entries in flash. A slice takes CHUNK bytes after another while its cycles stay
+// under INTEGRITY_STEP_US (from the cycle counter; with CYCLE_COUNTER_DISABLE one chunk a slice), so at about 30
+// cycles a byte a pass over 64 KB of image takes some 1200 passes of the loop. The image's CRC is not known before the
+// link, so the first pass after boot takes it as the reference and every later one must match it: the check finds the
+// flash changing under the running firmware, not an image that was wrong when it started; the bootloader verified that.
+//
+// The RAM check is a March C- over the internal SRAM, BLOCK bytes a slice with interrupts disabled: the block is saved
+// in the frame of the test, written and read with 0x55 and 0xAA up and down, and restored, about 250 cycles for 4
+// bytes, so interrupts wait some 16 us. Blocks at or above the stack pointer, the stack in use, are skipped; those of
+// the heap-stack gap are tested like any other. External RAM (xmem.hpp) is not tested.
+//
+// A pass that fails counts the failure and raises its alarm, FLASH_ALARM or RAM_ALARM at the severity of HH, with
+// the CRC's low word or the block's address as the value. A fault is latched: the alarm is raised once and stays
+// active until reset. The counters follow the passes ('stats' lists them, see main.cpp) and progress() tells where
+// each check stands. Opt-in with -D INTEGRITY_CHECK; without it, and off AVR, update() does nothing.
+
+#ifndef INTEGRITY_STEP_US
+#define INTEGRITY_STEP_US 100  // Cycle budget of the flash check's slice, in microseconds
+#endif
+#ifndef INTEGRITY_RAM_BLOCK
+#define INTEGRITY_RAM_BLOCK 4  // Bytes of RAM tested with interrupts disabled
+#endif
+
+namespace integrity {
+
+#if defined(__AVR__) && defined(INTEGRITY_CHECK)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t FLASH_ALARM = 62;  // Alarm ids, the last two of an AlarmManager's 64
+constexpr std::uint8_t RAM_ALARM = 63;
+constexpr std::uint8_t CHUNK = 16;        // Flash bytes between two looks at the budget, a multiple of 4
+constexpr std::uint8_t BLOCK = INTEGRITY_RAM_BLOCK;
+constexpr std::uint32_t STEP_CYCLES = INTEGRITY_STEP_US * cycle_counter::CYCLES_PER_US;
+constexpr std::uint8_t STACK_MARGIN = 16;  // Bytes below the stack pointer left untested, as stack_monitor does
+
+static_assert(CHUNK % 4U == 0, "The flash is read a word of four bytes at a time");
+static_assert(BLOCK > 0 && BLOCK <= 16, "The RAM block is tested with interrupts disabled");
+
+namespace detail {
+
+constexpr std::uint32_t POLYNOMIAL = 0xEDB88320UL;  // Reflected 0x04C11DB7
+
+constexpr std::uint32_t crc_entry(std::uint32_t byte) {
+    std::uint32_t crc = byte;
+    for (std::uint8_t bit = 0; bit < 8; ++bit) {
+        crc = (crc & 1U) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+    }
+    return crc;
+}
+
+template <std::size_t... I>
+constexpr std::array<std::uint32_t, sizeof...(I)> crc_table(std::index_sequence<I...>) {
+    return {{crc_entry(I)...}};
+}
+
+inline constexpr std::array<std::uint32_t, 256> CRC_TABLE PROGMEM = crc_table(std::make_index_sequence<256>{});
+
+static_assert(crc_entry(1) == 0x77073096UL && crc_entry(255) == 0x2D02EF8DUL, "CRC-32 table");
+
+} // namespace detail
+
+constexpr std::uint32_t CRC_INIT = 0xFFFFFFFFUL;  // Both the initial value and the final XOR
+
+// Folds `byte` into a running CRC-32 that started at CRC_INIT; the CRC is the running one XOR CRC_INIT
+inline std::uint32_t crc32_update(std::uint32_t crc, std::uint8_t byte) {
+    return pgm_read_dword(&detail::CRC_TABLE[static_cast<std::uint8_t>(crc ^ byte)]) ^ (crc >> 8);
+}
+
+namespace detail {
+
+#if defined(__AVR__)
+extern "C" char __data_load_end[];
+
+// First byte after the image in flash, the end of the copy of .data
+inline std::uint32_t image_end() { return pgm_get_far_address(__data_load_end); }
+
+// March C- over `block`, restored before interrupts are enabled again; false if a cell failed. Out of line, so its
+// frame, and the copy of the block in it, lies above the stack pointer it compares the block with
+__attribute__((noinline)) inline bool march(std::uint8_t* block) {
+    std::uint8_t saved[BLOCK];
+    bool passed = true;
+    const std::uint8_t sreg = SREG;
+    cli();
+    if (reinterpret_cast<std::uintptr_t>(block) + BLOCK + STACK_MARGIN > SP) {
+        SREG = sreg;
+        return true;  // The stack in use
+    }
+    volatile std::uint8_t* const cell = block;
+    for (std::uint8_t i = 0; i < BLOCK; ++i) {
+        saved[i] = cell[i];
+        cell[i] = 0x55;
+    }
+    for (std::uint8_t i = 0; i < BLOCK; ++i) {
+        passed &= cell[i] == 0x55;
+        cell[i] = 0xAA;
+    }
+    for (std::uint8_t i = 0; i < BLOCK; ++i) {
+        passed &= cell[i] == 0xAA;
+        cell[i] = 0x55;
+    }
+    for (std::uint8_t i = BLOCK; i-- > 0;) {
+        passed &= cell[i] == 0x55;
+        cell[i] = 0xAA;
+    }
+    for (std::uint8_t i = BLOCK; i-- > 0;) {
+        passed &= cell[i] == 0xAA;
+        cell[i] = 0x55;
+    }
+    for (std::uint8_t i = 0; i < BLOCK; ++i) {
+        passed &= cell[i] == 0x55;
+        cell[i] = saved[i];
+    }
+    SREG = sreg;
+    return passed;
+}
+#endif
+
+} // namespace detail
+
+// Where the checks stand, for a report
+struct Progress {
+    std::uint32_t flash_offset;  // Bytes of the image in the CRC of the pass under way
+    std::uint32_t flash_size;
+    std::uint16_t ram_offset;    // Bytes of the RAM tested, or skipped as stack, in the pass under way
+    std::uint16_t ram_size;
+    std::uint32_t reference;     // CRC of the image's first pass, 0 until it completes
+    std::uint32_t pass_ms;       // Scan clock time the last flash pass took
+};
+
+class IntegrityActor {
+public:
+    IntegrityActor() = default;
+    IntegrityActor(const IntegrityActor&) = delete;
+    IntegrityActor& operator=(const IntegrityActor&) = delete;
+
+    // One slice of each check
+    void update() {
+#if defined(__AVR__) && defined(INTEGRITY_CHECK)
+        check_ram();
+        check_flash();
+#endif
+    }
+
+    Progress progress() const {
+        return Progress{flash_offset_, flash_size(), ram_offset_, ram_size(), reference_, pass_ms_};
+    }
+
+    // Counters, saturating at 65535
+    const std::uint16_t& flash_passes() const { return flash_passes_; }
+    const std::uint16_t& flash_failures() const { return flash_failures_; }
+    const std::uint16_t& ram_passes() const { return ram_passes_; }
+    const std::uint16_t& ram_failures() const { return ram_failures_; }
+
+    // Output: the faults, to an alarms::AlarmTable's event_in
+    ramen::Pusher<alarms::Event> event_out;
+
+private:
+    std::uint32_t flash_offset_ = 0;
+    std::uint32_t crc_ = CRC_INIT;
+    std::uint32_t reference_ = 0;
+    bool has_reference_ = false;
+    scan_clock::Timestamp pass_start_ = 0;
+    std::uint32_t pass_ms_ = 0;
+    std::uint16_t ram_offset_ = 0;
+    bool flash_fault_ = false;
+    bool ram_fault_ = false;
+    std::uint16_t flash_passes_ = 0;
+    std::uint16_t flash_failures_ = 0;
+    std::uint16_t ram_passes_ = 0;
+    std::uint16_t ram_failures_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    static std::uint32_t flash_size() {
+#if defined(__AVR__)
+        return detail::image_end();
+#else
+        return 0;
+#endif
+    }
+
+    static std::uint16_t ram_size() {
+#if defined(__AVR__)
+        return static_cast<std::uint16_t>(RAMEND + 1U - RAMSTART);
+#else
+        return 0;
+#endif
+    }
+
+    void fault(bool& latched, std::uint8_t id, std::int16_t value) {
+        if (!latched) {
+            latched = true;
+            event_out(alarms::Event{id, alarms::NORMAL, alarms::HH, value});
+        }
+    }
+
+#if defined(__AVR__) && defined(INTEGRITY_CHECK)
+    void check_ram() {
+        const std::uint16_t size = ram_size();
+        std::uint8_t* const block = reinterpret_cast<std::uint8_t*>(RAMSTART + ram_offset_);
+        const std::uint8_t n = (size - ram_offset_ < BLOCK) ? static_cast<std::uint8_t>(size - ram_offset_) : BLOCK;
+        if (n == BLOCK && !detail::march(block)) {  // A short block at the end is the stack's
+            count(ram_failures_);
+            fault(ram_fault_, RAM_ALARM, static_cast<std::int16_t>(reinterpret_cast<std::uintptr_t>(block)));
+        }
+        ram_offset_ = static_cast<std::uint16_t>(ram_offset_ + n);
+        if (ram_offset_ >= size) {
+            ram_offset_ = 0;
+            count(ram_passes_);
+        }
+    }
+
+    void check_flash() {
+        const std::uint32_t end = flash_size();
+        if (flash_offset_ == 0) {
+            pass_start_ = scan_clock::now();
+        }
+        const std::uint32_t start = cycle_counter::now();
+        do {
+            std::uint32_t crc = crc_;
+            std::uint32_t address = flash_offset_;
+            if (end - address >= CHUNK) {
+                for (std::uint8_t i = 0; i < CHUNK; i = static_cast<std::uint8_t>(i + 4U), address += 4U) {
+                    const std::uint32_t word = pgm_read_dword_far(address);
+                    crc = crc32_update(crc, static_cast<std::uint8_t>(word));
+                    crc = crc32_update(crc, static_cast<std::uint8_t>(word >> 8));
+                    crc = crc32_update(crc, static_cast<std::uint8_t>(word >> 16));
+                    crc = crc32_update(crc, static_cast<std::uint8_t>(word >> 24));
+                }
+            } else {
+                for (; address < end; ++address) {
+                    crc = crc32_update(crc, pgm_read_byte_far(address));
+                }
+            }
+            crc_ = crc;
+            flash_offset_ = address;
+            if (flash_offset_ >= end) {
+                end_flash_pass();
+                return;
+            }
+        } while (cycle_counter::ENABLED && cycle_counter::now() - start < STEP_CYCLES);
+    }
+
+    void end_flash_pass() {
+        const std::uint32_t crc = crc_ ^ CRC_INIT;
+        pass_ms_ = scan_clock::now() - pass_start_;
+        flash_offset_ = 0;
+        crc_ = CRC_INIT;
+        count(flash_passes_);
+        if (!has_reference_) {
+            reference_ = crc;
+            has_reference_ = true;
+        } else if (crc != reference_) {
+            count(flash_failures_);
+            fault(flash_fault_, FLASH_ALARM, static_cast<std::int16_t>(crc));
+        }
+    }
+#endif
+};
+
+} // namespace integrity
@@ -1,9 +1,18 @@
 #pragma once
 #include "event.hpp"
+#include "actor_fsm.hpp"
+#include "fsm_queue.hpp"
+#include "fast_pin.hpp"
+#include "process_image.hpp"
+#include "shift_register.hpp"
+#include "hw_blink.hpp"
+#include "pgm_array.hpp"
 #include "sml.hpp"
 #include "ramen.hpp"
 #include <Controllino.h>
+#include <cstddef>
 #include <cstdint>
+#include <utility>
 
 namespace led {
 
@@ -14,78 +23,177 @@ struct stop_blinking {};
 struct change_interval_request {
     uint32_t new_interval_ms;
 };
+struct rearm_timer {};  // Posted by the FSM itself after an interval change
 
 // States
 struct stopped {};
 struct led_off {};
 struct led_on {};
 
-// Dynamic LED component
-struct dynamic_led {
+// State ids as returned by state_id(), with their names in flash
+enum StateId : std::uint8_t { STATE_STOPPED = 0, STATE_LED_OFF, STATE_LED_ON, STATE_COUNT };
+const char STATE_NAME_STOPPED[] PROGMEM = "stopped";
+const char STATE_NAME_LED_OFF[] PROGMEM = "led_off";
+const char STATE_NAME_LED_ON[]  PROGMEM = "led_on";
+constexpr auto STATE_NAMES PROGMEM =
+    ramen::pgm_array<const char*>({STATE_NAME_STOPPED, STATE_NAME_LED_OFF, STATE_NAME_LED_ON});
+static_assert(STATE_NAMES.size() == STATE_COUNT, "A name per state id");
+constexpr std::size_t STATE_NAME_SIZE = sizeof(STATE_NAME_LED_OFF);  // Longest name, with terminator
+
+// Flash address of the name of a state id, for strncpy_P and friends
+inline const char* state_name_P(std::uint8_t id) {
+    return STATE_NAMES[(id < STATE_COUNT) ? id : std::uint8_t{STATE_STOPPED}];
+}
+
+// State a blinky LED actor shares with its state machine. The machine is stateless and receives this context by
+// reference through SML's dependency injection, so the pin, interval and ports exist once, in the actor.
+struct blinky_led_context {
     const std::uint8_t pin;
+    uint32_t blink_interval_ms;
+
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    TimerHandle timer_handle;  // The periodic timer while blinking
+    bool hardware_blink = false;  // Set by use_hardware_blink()
+
+    // Leaves the pin alone: the actors are globals, constructed before the Arduino core is initialized
+    constexpr blinky_led_context(std::uint8_t led_pin, uint32_t interval_ms_initial) :
+        pin(led_pin), blink_interval_ms(interval_ms_initial) {}
+
+    // Makes the pin an output, off (or on, without a pulse low, when a warm restart resumes the LED lit); call from
+    // setup() before the LED is started
+    void init(bool on = false) {
+        digitalWrite(pin, on ? HIGH : LOW);  // On an input, HIGH is the pull-up, which pinMode() turns into the level
+        pinMode(pin, OUTPUT);
+    }
+
+    void led_on()  { digitalWrite(pin, HIGH); }
+    void led_off() { digitalWrite(pin, LOW); }
+
+    // Lets the pin's hardware timer do the blinking where it can (-D LED_HW_BLINK, see hw_blink.hpp). While the timer
+    // blinks the pin, no periodic timeouts arrive and the state machine stays in the state it was in.
+    void use_hardware_blink() { hardware_blink = hw_blink::ENABLED; }
+
+    // Arms the periodic timer, or re-arms it in place if it is already running; offloads to the pin's hardware timer
+    // instead when enabled and possible
+    void request_periodic_timer() {
+        if (hardware_blink && blink_interval_ms > 0 && hw_blink::start(pin, blink_interval_ms)) {
+            disarm_software_timer();
+            return;
+        }
+        hw_blink::stop(pin);
+        if (blink_interval_ms > 0) {
+            ArmTimerEvt evt(blink_interval_ms, &timeout_event_relay_out, true, &timer_handle);
+            arm_timer_request_out(evt);
+        } else {
+            disarm_software_timer();
+        }
+    }
+
+    void disarm_periodic_timer() {
+        hw_blink::stop(pin);
+        disarm_software_timer();
+    }
 
-    explicit dynamic_led(std::uint8_t p) : pin(p) {}
+    // True if neither a software timer nor the pin's hardware timer drives the blinking, e.g. because TimerActor had
+    // no free slot; only meaningful while the LED is not stopped
+    bool timer_missing() const { return !timer_handle.valid() && !hw_blink::running(pin); }
 
-    void setup() { pinMode(pin, OUTPUT); }
-    void on()    { digitalWrite(pin, HIGH); }
-    void off()   { digitalWrite(pin, LOW); }
+private:
+    void disarm_software_timer() {
+        if (timer_handle.valid()) {
+            DisarmTimerEvt evt(timer_handle);
+            disarm_timer_request_out(evt);
+            timer_handle = TimerHandle{};
+        }
+    }
 };
 
-template<class Led>
-struct periodic_blinky_fsm {
-    mutable Led led_component;
-    uint32_t& blink_interval_ms_ref;
-
-    ramen::Pusher<const ArmTimerEvt&>* arm_timer_request_out_port;
-    ramen::Pusher<const BaseEvent&>*   timeout_event_relay_out_port;
-    ramen::Pusher<const DisarmTimerEvt&>* disarm_timer_request_out_port;
-
-    periodic_blinky_fsm(Led led, uint32_t& interval_ref,
-                        ramen::Pusher<const ArmTimerEvt&>* arm_port,
-                        ramen::Pusher<const BaseEvent&>* tick_relay_port,
-                        ramen::Pusher<const DisarmTimerEvt&>* disarm_port)
-        : led_component(led), blink_interval_ms_ref(interval_ref),
-          arm_timer_request_out_port(arm_port),
-          timeout_event_relay_out_port(tick_relay_port),
-          disarm_timer_request_out_port(disarm_port)
-    {
-        led_component.setup();
-        led_component.off();
+// blinky_led_context with the pin fixed at compile time: led_on() and led_off() are single port writes (see
+// fast_pin.hpp) instead of digitalWrite calls
+template <std::uint8_t Pin>
+struct fast_blinky_led_context : blinky_led_context {
+    explicit constexpr fast_blinky_led_context(uint32_t interval_ms_initial) :
+        blinky_led_context(Pin, interval_ms_initial) {}
+
+    void init(bool on = false) {
+        if (on) {
+            gpio::FastPin<Pin>::high();
+            gpio::FastPin<Pin>::set_output(true);
+        } else {
+            gpio::FastPin<Pin>::make_output();
+        }
     }
 
+    void led_on()  { gpio::FastPin<Pin>::high(); }
+    void led_off() { gpio::FastPin<Pin>::low(); }
+};
+
+// blinky_led_context that drives its pin through a process image; the level reaches the pin at the image's next
+// commit_outputs()
+struct image_blinky_led_context : blinky_led_context {
+    process_image::ProcessImage& image;
+
+    constexpr image_blinky_led_context(process_image::ProcessImage& output_image, std::uint8_t led_pin,
+                                       uint32_t interval_ms_initial) :
+        blinky_led_context(led_pin, interval_ms_initial), image(output_image) {}
+
+    // Registers the pin with the image, which drives it low at once; the image may be a global of another
+    // translation unit, so this cannot happen during static initialization
+    void init(bool on = false) { image.add_output(pin, on); }
+
+    void led_on()  { image.write(pin, true); }
+    void led_off() { image.write(pin, false); }
+};
+
+// blinky_led_context that drives a bit of a 74HC595 chain; the level reaches the output at the chain's next commit().
+// Its pin is the pseudo pin expander::pin(bit)
+struct expander_blinky_led_context : blinky_led_context {
+    expander::OutputFrame& frame;
+
+    constexpr expander_blinky_led_context(expander::OutputFrame& output_frame, std::uint8_t bit,
+                                          uint32_t interval_ms_initial) :
+        blinky_led_context(expander::pin(bit), interval_ms_initial), frame(output_frame) {}
+
+    void init(bool on = false) { frame.write(expander::bit_of(pin), on); }
+
+    void led_on()  { frame.write(expander::bit_of(pin), true); }
+    void led_off() { frame.write(expander::bit_of(pin), false); }
+};
+
+// Context provides pin control (led_on, led_off), the timer requests and blink_interval_ms
+template<class Context>
+struct periodic_blinky_fsm {
     auto operator()() const {
         using namespace boost::sml;
 
-        auto start_periodic_timer_action = [this] {
-            request_periodic_timer();
+        auto start_periodic_timer_action = [](Context& ctx) FSM_ACTION {
+            ctx.request_periodic_timer();
         };
-        auto stop_periodic_timer_action = [this] {
-            disarm_periodic_timer();
+        auto stop_periodic_timer_action = [](Context& ctx) FSM_ACTION {
+            ctx.disarm_periodic_timer();
         };
-        auto turn_led_on_action = [this] {
-            led_component.on();
+        auto turn_led_on_action = [](Context& ctx) FSM_ACTION {
+            ctx.led_on();
         };
-        auto turn_led_off_action = [this] {
-            led_component.off();
+        auto turn_led_off_action = [](Context& ctx) FSM_ACTION {
+            ctx.led_off();
         };
-        auto turn_off_and_stop_action = [this] {
-            led_component.off();
-            disarm_periodic_timer();
+        auto turn_off_and_stop_action = [](Context& ctx) FSM_ACTION {
+            ctx.led_off();
+            ctx.disarm_periodic_timer();
         };
-        auto update_interval_and_rearm_action = [this](const change_interval_request& evt) {
-            blink_interval_ms_ref = evt.new_interval_ms;
-            disarm_periodic_timer();
-            if (blink_interval_ms_ref > 0) {
-                request_periodic_timer();
-            }
+        auto rearm_timer_action = [](Context& ctx) FSM_ACTION {
+            ctx.request_periodic_timer();
         };
-        auto update_interval_when_stopped_action = [this](const change_interval_request& evt) {
-            blink_interval_ms_ref = evt.new_interval_ms;
+        auto update_interval_action = [](Context& ctx, const change_interval_request& evt) FSM_ACTION {
+            ctx.blink_interval_ms = evt.new_interval_ms;
         };
 
         return make_transition_table(
             *state<stopped> + event<start_blinking>           / start_periodic_timer_action     = state<led_off>,
-             state<stopped> + event<change_interval_request>  / update_interval_when_stopped_action = state<stopped>,
+             state<stopped> + event<change_interval_request>  / update_interval_action          = state<stopped>,
 
              state<led_off> + event<periodic_timeout>            / turn_led_on_action              = state<led_on>,
              state<led_on>  + event<periodic_timeout>            / turn_led_off_action             = state<led_off>,
@@ -93,63 +201,52 @@ struct periodic_blinky_fsm {
              state<led_off> + event<stop_blinking>            / stop_periodic_timer_action      = state<stopped>,
              state<led_on>  + event<stop_blinking>            / turn_off_and_stop_action        = state<stopped>,
 
-             state<led_off> + event<change_interval_request>  / update_interval_and_rearm_action = state<led_off>,
-             state<led_on>  + event<change_interval_request>  / update_interval_and_rearm_action = state<led_on>
-        );
-    }
+             // The timer is re-armed from the queued rearm_timer once the interval change has completed
+             state<led_off> + event<change_interval_request>  / (update_interval_action, process(rearm_timer{})) = state<led_off>,
+             state<led_on>  + event<change_interval_request>  / (update_interval_action, process(rearm_timer{})) = state<led_on>,
 
-private:
-    void request_periodic_timer() const {
-        if (arm_timer_request_out_port && timeout_event_relay_out_port) {
-            if (blink_interval_ms_ref > 0) {
-                ArmTimerEvt evt(blink_interval_ms_ref, timeout_event_relay_out_port, true);
-                (*arm_timer_request_out_port)(evt);
-            }
-        }
-    }
-
-    void disarm_periodic_timer() const {
-        if (disarm_timer_request_out_port && timeout_event_relay_out_port) {
-            DisarmTimerEvt evt(timeout_event_relay_out_port);
-            (*disarm_timer_request_out_port)(evt);
-        }
+             state<led_off> + event<rearm_timer>              / rearm_timer_action              = state<led_off>,
+             state<led_on>  + event<rearm_timer>              / rearm_timer_action              = state<led_on>
+        );
     }
 };
 
-struct BlinkyLedActor {
-    std::uint8_t pin;
-    uint32_t blink_interval_ms;
+// Dispatch policy of the LED state machines; see actor_fsm.hpp
+#ifndef LED_FSM_DISPATCH
+#define LED_FSM_DISPATCH switch_stm
+#endif
 
-    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
-    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
-    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+// Events the LED FSM posts to itself (rearm_timer) wait in a static queue; one slot is enough
+using fsm_queue_policy = boost::sml::process_queue<fsm::static_queue<1>::type>;
+
+// Context is blinky_led_context, fast_blinky_led_context<Pin>, image_blinky_led_context or
+// expander_blinky_led_context; the constructor arguments
+// are those of the context. Construction touches no hardware: call init() (the context's) from setup()
+template <class Dispatch = fsm::dispatch::LED_FSM_DISPATCH, class Context = blinky_led_context>
+struct BasicBlinkyLedActor : Context {
     ramen::Pushable<const BaseEvent&> event_handler_in;
 
-    using fsm_type = periodic_blinky_fsm<dynamic_led>;
-    boost::sml::sm<fsm_type> sm;
-
-    explicit BlinkyLedActor(std::uint8_t led_pin, uint32_t interval_ms_initial) :
-        pin(led_pin),
-        blink_interval_ms(interval_ms_initial),
-        event_handler_in([this](const BaseEvent& event) {
-            switch (event.type) {
-                case AppEventType::EV_TIMEOUT:
-                    // If TickEvent had specific members you needed, you would static_cast here:
-                    // const TickEvent& tick_evt = static_cast<const TickEvent&>(event);
-                    this->sm.process_event(periodic_timeout{});
-                    break;
-                default:
-                    // Optionally, handle or log unknown/unexpected event types
-                    break;
-            }
-        }),
-        sm(fsm_type{dynamic_led{led_pin}, this->blink_interval_ms,
-                   &this->arm_timer_request_out,
-                   &this->timeout_event_relay_out,
-                   &this->disarm_timer_request_out
-                   })
+    using fsm_type = periodic_blinky_fsm<Context>;
+    sml_trace::Logger trace_logger;  // Records transitions tagged with the pin number (-D SML_TRACE)
+    fsm::traced_sm<fsm_type, Dispatch, fsm_queue_policy> sm;
+
+    template <class... Args>
+    explicit BasicBlinkyLedActor(Args&&... context_args) :
+        Context(std::forward<Args>(context_args)...),
+        event_handler_in(ramen::bind<&BasicBlinkyLedActor::route>(this)),
+        trace_logger(this->pin),
+        sm(trace_logger, static_cast<Context&>(*this))
     {
-        timeout_event_relay_out >> event_handler_in;
+        this->timeout_event_relay_out >> event_handler_in;
+    }
+
+    void route(const BaseEvent& event) {
+        EventRouter<AppEvents, BasicBlinkyLedActor, TickEvent>::dispatch(*this, event);
+    }
+
+    // Routed from event_handler_in
+    void on_event(const TickEvent&) {
+        sm.process_event(periodic_timeout{});
     }
 
     void start() {
@@ -163,5 +260,41 @@ struct BlinkyLedActor {
     void set_blink_interval(uint32_t new_interval_ms) {
         sm.process_event(change_interval_request{new_interval_ms});
     }
+
+    // Puts the state machine in `state`, a StateId, as after a warm restart: blinking resumes with a full interval in
+    // the state it was in. From stopped or led_off the output, set by init(on), does not change
+    void resume(std::uint8_t state) {
+        stop();
+        if (state == STATE_STOPPED) {
+            return;
+        }
+        start();
+        if (state == STATE_LED_ON) {
+            sm.process_event(periodic_timeout{});
+        }
+    }
+
+    // Current state as a StateId
+    std::uint8_t state_id() const {
+        return fsm::current_state_id(sm);
+    }
+
+    static_assert(fsm::state_index_v<decltype(sm), led::stopped> == STATE_STOPPED &&
+                  fsm::state_index_v<decltype(sm), led::led_off> == STATE_LED_OFF &&
+                  fsm::state_index_v<decltype(sm), led::led_on> == STATE_LED_ON,
+                  "StateId must follow the order of the states in periodic_blinky_fsm");
 };
+
+using BlinkyLedActor = BasicBlinkyLedActor<>;
+
+// BlinkyLedActor for a pin known at compile time, e.g. led::FastBlinkyLedActor<CONTROLLINO_D0> led1(500)
+template <std::uint8_t Pin>
+using FastBlinkyLedActor = BasicBlinkyLedActor<fsm::dispatch::LED_FSM_DISPATCH, fast_blinky_led_context<Pin>>;
+
+// BlinkyLedActor writing a process image, e.g. led::ImageBlinkyLedActor led1(image, CONTROLLINO_D0, 500)
+using ImageBlinkyLedActor = BasicBlinkyLedActor<fsm::dispatch::LED_FSM_DISPATCH, image_blinky_led_context>;
+
+// BlinkyLedActor on a shift register output, e.g. led::ExpanderBlinkyLedActor led4(expander, 0, 250) for Q0 of the
+// first register
+using ExpanderBlinkyLedActor = BasicBlinkyLedActor<fsm::dispatch::LED_FSM_DISPATCH, expander_blinky_led_context>;
 } // namespace led
@@ -0,0 +1,148 @@
+#pragma once
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// N identical blinking LED channels driven by one actor.
+//
+// A BlinkyLedActor carries its own SML machine, timer ports and relay port, roughly 50 bytes per LED on AVR. A
+// LedBank keeps the per-channel data in packed arrays (pin, state, interval and time to the next toggle: 6 bytes a
+// channel) and runs every channel through one transition table in flash, equivalent to periodic_blinky_fsm in
+// actor_led.hpp. The bank does its own timekeeping from TimerActor::clock_out instead of holding a TimerActor slot
+// per channel:
+//
+//     led::LedBank<24> panel({CONTROLLINO_D0, CONTROLLINO_D1, ...}, 500);
+//     void setup() {
+//         panel.init();
+//         timer.clock_out >> panel.clock_in;
+//         panel.start(0);
+//     }
+//
+// Intervals are limited to 16 bits (65535 ms), which covers the range accepted by the 'interval' command.
+
+namespace led {
+namespace bank {
+
+// Same numbering as led::StateId, so bank and actor states share the names in actor_led.hpp
+enum State : std::uint8_t { STOPPED = 0, LED_OFF, LED_ON };
+enum Event : std::uint8_t { START = 0, STOP, TIMEOUT, CHANGE_INTERVAL, EVENT_COUNT };
+enum Action : std::uint8_t { NONE = 0, ARM, DISARM, TURN_ON, TURN_OFF, TURN_OFF_AND_DISARM, SET_INTERVAL, SET_INTERVAL_AND_REARM };
+
+// One byte per (state, event): the action in the high nibble, the next state in the low nibble
+constexpr std::uint8_t entry(Action action, State next) {
+    return static_cast<std::uint8_t>((action << 4) | next);
+}
+
+// clang-format off
+const std::uint8_t TRANSITIONS[3][EVENT_COUNT] PROGMEM = {
+    //             START                   STOP                                 TIMEOUT                   CHANGE_INTERVAL
+    /* STOPPED */ {entry(ARM,  LED_OFF),   entry(NONE, STOPPED),                entry(NONE, STOPPED),     entry(SET_INTERVAL, STOPPED)},
+    /* LED_OFF */ {entry(NONE, LED_OFF),   entry(DISARM, STOPPED),              entry(TURN_ON, LED_ON),   entry(SET_INTERVAL_AND_REARM, LED_OFF)},
+    /* LED_ON  */ {entry(NONE, LED_ON),    entry(TURN_OFF_AND_DISARM, STOPPED), entry(TURN_OFF, LED_OFF), entry(SET_INTERVAL_AND_REARM, LED_ON)},
+};
+// clang-format on
+
+} // namespace bank
+
+template <std::uint8_t N>
+class LedBank {
+    static_assert(N > 0, "LedBank needs at least one channel");
+
+public:
+    using channel_t = std::uint8_t;
+    using interval_t = std::uint16_t;
+
+    // Leaves the pins alone: the bank is a global, constructed before the Arduino core is initialized
+    LedBank(const std::array<std::uint8_t, N>& led_pins, interval_t interval_ms_initial) : pins_(led_pins) {
+        for (channel_t ch = 0; ch < N; ++ch) {
+            intervals_[ch] = interval_ms_initial;
+        }
+    }
+
+    // Makes the pins outputs, off; call from setup() before a channel is started
+    void init() {
+        for (channel_t ch = 0; ch < N; ++ch) {
+            digitalWrite(pins_[ch], LOW);
+            pinMode(pins_[ch], OUTPUT);
+        }
+    }
+
+    static constexpr channel_t size() { return N; }
+
+    void start(channel_t ch) { process(ch, bank::START); }
+    void stop(channel_t ch) { process(ch, bank::STOP); }
+    void set_blink_interval(channel_t ch, std::uint32_t new_interval_ms) {
+        process(ch, bank::CHANGE_INTERVAL,
+                static_cast<interval_t>((new_interval_ms > UINT16_MAX) ? UINT16_MAX : new_interval_ms));
+    }
+
+    std::uint8_t pin(channel_t ch) const { return pins_[ch]; }
+    interval_t blink_interval_ms(channel_t ch) const { return intervals_[ch]; }
+    bank::State state(channel_t ch) const { return static_cast<bank::State>(states_[ch]); }
+    // Packed state of all channels, e.g. to copy into a status frame
+    const std::uint8_t* state_ids() const { return states_.data(); }
+
+    // Time base, normally linked to TimerActor::clock_out; toggles every channel whose interval has elapsed
+    ramen::Pushable<std::uint32_t> clock_in = [this](std::uint32_t now) {
+        const std::uint32_t elapsed = now - last_clock_ms_;
+        last_clock_ms_ = now;
+        for (channel_t ch = 0; ch < N; ++ch) {
+            if (remaining_[ch] == 0) {
+                continue;  // Not armed
+            }
+            if (elapsed < remaining_[ch]) {
+                remaining_[ch] = static_cast<interval_t>(remaining_[ch] - elapsed);
+                continue;
+            }
+            // Keep the phase when the clock ticked late, unless a whole period was missed
+            const std::uint32_t late = elapsed - remaining_[ch];
+            remaining_[ch] = (late < intervals_[ch]) ? static_cast<interval_t>(intervals_[ch] - late) : intervals_[ch];
+            process(ch, bank::TIMEOUT);
+        }
+    };
+
+private:
+    void process(channel_t ch, bank::Event event, interval_t new_interval_ms = 0) {
+        if (ch >= N) {
+            return;
+        }
+        const std::uint8_t e = pgm_read_byte(&bank::TRANSITIONS[states_[ch]][event]);
+        switch (static_cast<bank::Action>(e >> 4)) {
+            case bank::NONE:
+                break;
+            case bank::ARM:
+                remaining_[ch] = intervals_[ch];
+                break;
+            case bank::DISARM:
+                remaining_[ch] = 0;
+                break;
+            case bank::TURN_ON:
+                digitalWrite(pins_[ch], HIGH);
+                break;
+            case bank::TURN_OFF:
+                digitalWrite(pins_[ch], LOW);
+                break;
+            case bank::TURN_OFF_AND_DISARM:
+                digitalWrite(pins_[ch], LOW);
+                remaining_[ch] = 0;
+                break;
+            case bank::SET_INTERVAL:
+                intervals_[ch] = new_interval_ms;
+                break;
+            case bank::SET_INTERVAL_AND_REARM:
+                intervals_[ch] = new_interval_ms;
+                remaining_[ch] = new_interval_ms;
+                break;
+        }
+        states_[ch] = static_cast<std::uint8_t>(e & 0x0F);
+    }
+
+    std::array<std::uint8_t, N> pins_;
+    std::array<std::uint8_t, N> states_{};      // bank::State of every channel
+    std::array<interval_t, N> intervals_{};
+    std::array<interval_t, N> remaining_{};     // Milliseconds to the next toggle; 0 when disarmed
+    std::uint32_t last_clock_ms_ = 0;
+};
+
+} // namespace led
@@ -0,0 +1,495 @@
+#pragma once
+#include "actor_alarm_manager.hpp"
+#include "actor_led.hpp"
+#include "modbus_rtu.hpp"
+#include "output_registry.hpp"
+#include "pgm_array.hpp"
+#include "process_image.hpp"
+#include <Controllino.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Modbus RTU slave on the RS485 port (see modbus_rtu.hpp), for a plant master that polls the outputs of the registry
+// and, optionally, pins of a process image; modbus::ModbusTcpActor serves the same data model over Ethernet (see
+// actor_modbus_tcp.hpp). The data model maps onto them directly; nothing is copied into a register table:
+//
+//     coils             0..n-1       output i is running (not stopped); writing starts or stops it
+//                       256..256+m-1 output pin k of the process image
+//     discrete inputs   0..m-1       input pin k of the process image
+//     input registers   0..n-1       led::StateId of output i
+//                       256..297     window on the alarm table, see below
+//     holding registers 0..n-1       blink interval of output i in ms, 1 to 60000 as with the text commands
+//                       256          alarm to acknowledge, FFFF for all; reads 0
+//                       257          alarm cursor: the window holds the changes after this sequence number
+//                       258          alarm window flags: bit 0 for the whole table
+//
+//     modbus::ModbusSlaveActor modbus_slave(outputs, 1);         // Slave address 1
+//     modbus_slave.use_image(image, COIL_PINS, 2, INPUT_PINS, 4);  // Optional; pin tables in PROGMEM
+//     modbus_slave.use_alarms(alarm_table);                        // Optional; see actor_alarm_manager.hpp
+//     void setup() { modbus_slave.begin(19200); }
+//     void loop()  { modbus_slave.update(); ... }
+//
+// Requests are dispatched through FUNCTIONS, a table in flash, and answered in place in the frame buffer of the link,
+// the reply overwriting the request; update() handles a frame and starts its reply in the same call, so the
+// turnaround is the 3.5 character times that end the frame plus the time until loop() next calls update(). Calling it
+// first in loop() keeps that well inside a master's poll cycle, unlike the text commands, whose replies queue behind
+// their output. Writes to several coils or registers are checked whole before any is applied, so a request fails or
+// succeeds as a whole. Broadcasts (address 0) apply writes without a reply.
+//
+// The alarm window is read from the table whenever the master reads input registers there: 256 is the number to set
+// the cursor to next, 257 the flags (bit 0: whole table) in its high byte and the count of records in its low one,
+// and from 258 on come ALARM_WINDOW records of five registers, seq, id << 8 | state, severity << 8 | repeats and the
+// time in ms, high word first (alarms::Record; state 0x80 for a removal). A master reads the window in one request,
+// then writes the cursor, and the flags back to 0 with the same request if it set them. There is one cursor, for the
+// plant master.
+
+namespace modbus {
+
+enum Exception : std::uint8_t {
+    NONE = 0,
+    ILLEGAL_FUNCTION = 1,
+    ILLEGAL_DATA_ADDRESS = 2,
+    ILLEGAL_DATA_VALUE = 3
+};
+
+class ModbusSlaveActor {
+public:
+    static constexpr std::uint16_t IMAGE_COILS = 256;  // Address of the first process image coil
+    static constexpr std::uint16_t MIN_INTERVAL_MS = 1;
+    static constexpr std::uint16_t MAX_INTERVAL_MS = 60000;
+    static constexpr std::uint16_t ALARM_REGISTERS = 256;  // Address of the first alarm register
+    static constexpr std::uint8_t ALARM_WINDOW = 8;        // Records per window
+    static constexpr std::uint8_t MAX_PDU = 253;
+
+    struct Counters {
+        std::uint16_t requests = 0;    // Addressed to this slave, broadcasts and TCP included
+        std::uint16_t crc_errors = 0;
+        std::uint16_t exceptions = 0;  // Replies with an exception code
+    };
+
+    ModbusSlaveActor(const led::OutputTable& output_table, std::uint8_t slave_address) :
+        outputs(output_table), address_(slave_address) {}
+    ModbusSlaveActor(const ModbusSlaveActor&) = delete;
+    ModbusSlaveActor& operator=(const ModbusSlaveActor&) = delete;
+
+    // Exposes pins of `image` as coils from IMAGE_COILS on and as discrete inputs; the pin tables are in PROGMEM and
+    // the pins are registered with the image by the caller
+    void use_image(process_image::ProcessImage& image, const std::uint8_t* coil_pins_P, std::uint8_t coil_count,
+                   const std::uint8_t* input_pins_P, std::uint8_t input_count) {
+        image_ = &image;
+        coil_pins_P_ = coil_pins_P;
+        coil_count_ = coil_count;
+        input_pins_P_ = input_pins_P;
+        input_count_ = input_count;
+    }
+
+    // Exposes `table` through the alarm registers
+    void use_alarms(alarms::AlarmTable& table) { alarms_ = &table; }
+
+    // Takes over the RS485 port; false if the link is not built in (-D MODBUS_RTU) or the rate is unsupported
+    bool begin(unsigned long baud, modbus_rtu::Parity parity = modbus_rtu::Parity::EVEN) {
+        return modbus_rtu::begin(baud, parity);
+    }
+
+    // Handles a received frame, if any, and starts its reply
+    void update() {
+        if (!modbus_rtu::frame_ready()) {
+            return;
+        }
+        const std::uint16_t n = handle(modbus_rtu::frame, modbus_rtu::length);
+        if (n > 0) {
+            modbus_rtu::transmit(n);
+        } else {
+            modbus_rtu::release();
+        }
+    }
+
+    // Handles the request ADU of `length` bytes at `adu` and leaves the reply ADU in its place; returns the length of
+    // the reply, 0 if there is none
+    std::uint16_t handle(std::uint8_t* adu, std::uint16_t length) {
+        if (length < 4U || length > modbus_rtu::MAX_ADU) {
+            return 0;
+        }
+        const std::uint16_t crc = static_cast<std::uint16_t>(adu[length - 2U] | (adu[length - 1U] << 8));
+        if (modbus_rtu::crc16(adu, length - modbus_rtu::CRC_SIZE) != crc) {
+            count(counters_.crc_errors);
+            return 0;
+        }
+        const bool broadcast = adu[0] == modbus_rtu::BROADCAST;
+        if (!broadcast && adu[0] != address_) {
+            return 0;
+        }
+        const std::uint8_t pdu_length =
+            handle_pdu(adu + 1, static_cast<std::uint8_t>(length - 1U - modbus_rtu::CRC_SIZE), broadcast);
+        if (pdu_length == 0) {
+            return 0;
+        }
+        std::uint16_t n = static_cast<std::uint16_t>(1U + pdu_length);
+        const std::uint16_t reply_crc = modbus_rtu::crc16(adu, n);
+        adu[n++] = static_cast<std::uint8_t>(reply_crc);
+        adu[n++] = static_cast<std::uint8_t>(reply_crc >> 8);
+        return n;
+    }
+
+    // Handles the request PDU of `length` bytes (1 to MAX_PDU) at `pdu` and leaves the reply PDU in its place; returns
+    // the length of the reply, 0 for a broadcast. The part shared by the transports, RTU above and TCP (see
+    // actor_modbus_tcp.hpp), so that both serve the one data model.
+    std::uint8_t handle_pdu(std::uint8_t* pdu, std::uint8_t length, bool broadcast = false) {
+        count(counters_.requests);
+        Function function{};
+        Exception result = ILLEGAL_FUNCTION;
+        if (find(pdu[0], function)) {
+            if (broadcast && !function.write) {
+                return 0;  // Reads cannot be broadcast
+            }
+            result = (length < function.min_length) ? ILLEGAL_DATA_VALUE : function.handler(*this, pdu, length);
+        }
+        if (broadcast) {
+            return 0;
+        }
+        if (result != NONE) {
+            count(counters_.exceptions);
+            pdu[0] = static_cast<std::uint8_t>(pdu[0] | 0x80U);
+            pdu[1] = result;
+            length = 2;
+        }
+        return length;
+    }
+
+    const Counters& counters() const { return counters_; }
+
+private:
+    // `pdu` starts with the function code; `length` is that of the request on entry and of the reply on return
+    using Handler = Exception (*)(ModbusSlaveActor&, std::uint8_t* pdu, std::uint8_t& length);
+
+    struct Function {
+        std::uint8_t code;
+        std::uint8_t min_length;  // Of the request PDU
+        bool write;               // Allowed as a broadcast
+        Handler handler;
+    };
+
+    const led::OutputTable& outputs;
+    const std::uint8_t address_;
+    process_image::ProcessImage* image_ = nullptr;
+    const std::uint8_t* coil_pins_P_ = nullptr;
+    const std::uint8_t* input_pins_P_ = nullptr;
+    std::uint8_t coil_count_ = 0;
+    std::uint8_t input_count_ = 0;
+    alarms::AlarmTable* alarms_ = nullptr;
+    std::uint16_t alarm_cursor_ = 0;
+    std::uint8_t alarm_flags_ = 0;
+    Counters counters_;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    static std::uint16_t read_be16(const std::uint8_t* p) { return static_cast<std::uint16_t>((p[0] << 8) | p[1]); }
+
+    static void write_be16(std::uint8_t* p, std::uint16_t value) {
+        p[0] = static_cast<std::uint8_t>(value >> 8);
+        p[1] = static_cast<std::uint8_t>(value);
+    }
+
+    // [first, first + quantity) within [0, size)
+    static bool in_range(std::uint16_t first, std::uint16_t quantity, std::uint16_t size) {
+        return first < size && quantity <= size - first;
+    }
+
+    // The data model
+
+    bool coils_exist(std::uint16_t first, std::uint16_t quantity) const {
+        return in_range(first, quantity, outputs.size()) ||
+               (first >= IMAGE_COILS && image_ != nullptr &&
+                in_range(static_cast<std::uint16_t>(first - IMAGE_COILS), quantity, coil_count_));
+    }
+
+    bool coil(std::uint16_t address) const {
+        if (address < IMAGE_COILS) {
+            return outputs.at(static_cast<std::uint8_t>(address)).state_id() != led::STATE_STOPPED;
+        }
+        return image_->output(pgm_read_byte(&coil_pins_P_[address - IMAGE_COILS]));
+    }
+
+    void set_coil(std::uint16_t address, bool on) {
+        if (address < IMAGE_COILS) {
+            const led::OutputRef output = outputs.at(static_cast<std::uint8_t>(address));
+            if (on) {
+                output.start();
+            } else {
+                output.stop();
+            }
+        } else {
+            image_->write(pgm_read_byte(&coil_pins_P_[address - IMAGE_COILS]), on);
+        }
+    }
+
+    bool discrete_input(std::uint16_t address) const {
+        return image_->input(pgm_read_byte(&input_pins_P_[address]));
+    }
+
+    std::uint16_t holding_register(std::uint16_t address) const {
+        const std::uint32_t ms = outputs.at(static_cast<std::uint8_t>(address)).blink_interval_ms();
+        return static_cast<std::uint16_t>(ms < UINT16_MAX ? ms : UINT16_MAX);
+    }
+
+    static bool valid_interval(std::uint16_t ms) { return ms >= MIN_INTERVAL_MS && ms <= MAX_INTERVAL_MS; }
+
+    // Holding registers from ALARM_REGISTERS: acknowledgement, cursor and flags
+    std::uint16_t alarm_registers() const { return (alarms_ != nullptr) ? 3U : 0U; }
+
+    std::uint16_t alarm_register(std::uint16_t offset) const {
+        return (offset == 1) ? alarm_cursor_ : (offset == 2) ? alarm_flags_ : 0U;
+    }
+
+    static bool valid_alarm_register(std::uint16_t offset, std::uint16_t value) {
+        return (offset == 0) ? (value < alarms::ALL || value == 0xFFFFU) : (offset == 1 || value <= alarms::RESYNC);
+    }
+
+    void set_alarm_register(std::uint16_t offset, std::uint16_t value) {
+        if (offset == 0) {
+            alarms_->ack(static_cast<std::uint8_t>(value < alarms::ALL ? value : alarms::ALL));
+        } else if (offset == 1) {
+            alarm_cursor_ = value;
+        } else {
+            alarm_flags_ = static_cast<std::uint8_t>(value);
+        }
+    }
+
+    // Function codes
+
+    // Read coils (0x01) and discrete inputs (0x02): the bits are packed into the reply from its third byte, which
+    // overwrites the request only once its fields are read
+    template <bool (ModbusSlaveActor::*Bit)(std::uint16_t) const>
+    static Exception read_bits(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length, bool exist) {
+        const std::uint16_t first = read_be16(pdu + 1);
+        const std::uint16_t quantity = read_be16(pdu + 3);
+        if (quantity < 1U || quantity > 2000U) {
+            return ILLEGAL_DATA_VALUE;
+        }
+        if (!exist) {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        const std::uint8_t bytes = static_cast<std::uint8_t>((quantity + 7U) / 8U);
+        pdu[1] = bytes;
+        for (std::uint8_t i = 0; i < bytes; ++i) {
+            pdu[2 + i] = 0;
+        }
+        for (std::uint16_t i = 0; i < quantity; ++i) {
+            if ((self.*Bit)(static_cast<std::uint16_t>(first + i))) {
+                pdu[2 + i / 8U] = static_cast<std::uint8_t>(pdu[2 + i / 8U] | (1U << (i % 8U)));
+            }
+        }
+        length = static_cast<std::uint8_t>(2U + bytes);
+        return NONE;
+    }
+
+    static Exception read_coils(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        return read_bits<&ModbusSlaveActor::coil>(self, pdu, length, self.coils_exist(read_be16(pdu + 1),
+                                                                                      read_be16(pdu + 3)));
+    }
+
+    static Exception read_discrete_inputs(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        const bool exist =
+            self.image_ != nullptr && in_range(read_be16(pdu + 1), read_be16(pdu + 3), self.input_count_);
+        return read_bits<&ModbusSlaveActor::discrete_input>(self, pdu, length, exist);
+    }
+
+    // Read holding (0x03) and input registers (0x04) of the block of `size` registers at `base`, one per output from
+    // 0 and the alarm registers from ALARM_REGISTERS; `value` takes the offset in the block
+    template <class Value>
+    static Exception read_registers(std::uint8_t* pdu, std::uint8_t& length, std::uint16_t base, std::uint16_t size,
+                                    Value value) {
+        const std::uint16_t first = read_be16(pdu + 1);
+        const std::uint16_t quantity = read_be16(pdu + 3);
+        if (quantity < 1U || quantity > 125U) {
+            return ILLEGAL_DATA_VALUE;
+        }
+        if (first < base || !in_range(static_cast<std::uint16_t>(first - base), quantity, size)) {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        pdu[1] = static_cast<std::uint8_t>(2U * quantity);
+        for (std::uint16_t i = 0; i < quantity; ++i) {
+            write_be16(pdu + 2 + 2U * i, value(static_cast<std::uint16_t>(first - base + i)));
+        }
+        length = static_cast<std::uint8_t>(2U + 2U * quantity);
+        return NONE;
+    }
+
+    static Exception read_holding_registers(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        if (read_be16(pdu + 1) >= ALARM_REGISTERS) {
+            return read_registers(pdu, length, ALARM_REGISTERS, self.alarm_registers(),
+                                  [&self](std::uint16_t i) { return self.alarm_register(i); });
+        }
+        return read_registers(pdu, length, 0, self.outputs.size(), [&self](std::uint16_t i) {
+            return self.holding_register(i);
+        });
+    }
+
+    static Exception read_input_registers(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        if (read_be16(pdu + 1) >= ALARM_REGISTERS) {
+            return read_alarm_window(self, pdu, length);
+        }
+        return read_registers(pdu, length, 0, self.outputs.size(), [&self](std::uint16_t i) {
+            return static_cast<std::uint16_t>(self.outputs.at(static_cast<std::uint8_t>(i)).state_id());
+        });
+    }
+
+    // The window is read from the table once per request, so its registers agree with each other
+    static Exception read_alarm_window(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        std::uint8_t records[alarms::RECORD_SIZE * ALARM_WINDOW];
+        alarms::ReadResult window;
+        if (self.alarms_ != nullptr) {
+            window = self.alarms_->read(self.alarm_cursor_, records, ALARM_WINDOW, self.alarm_flags_);
+        }
+        const std::uint16_t size = (self.alarms_ != nullptr) ? 2U + 5U * ALARM_WINDOW : 0U;
+        return read_registers(pdu, length, ALARM_REGISTERS, size, [&window, &records](std::uint16_t i) {
+            if (i < 2) {
+                return (i == 0) ? window.next : static_cast<std::uint16_t>((window.flags << 8) | window.count);
+            }
+            const std::uint8_t n = static_cast<std::uint8_t>((i - 2U) / 5U);
+            if (n >= window.count) {
+                return static_cast<std::uint16_t>(0);
+            }
+            const std::uint8_t* r = records + alarms::RECORD_SIZE * n;
+            switch ((i - 2U) % 5U) {
+                case 0: return static_cast<std::uint16_t>(r[0] | (r[1] << 8));
+                case 1: return static_cast<std::uint16_t>((r[2] << 8) | r[4]);
+                case 2: return static_cast<std::uint16_t>((r[3] << 8) | r[5]);
+                case 3: return static_cast<std::uint16_t>(r[8] | (r[9] << 8));
+                default: return static_cast<std::uint16_t>(r[6] | (r[7] << 8));
+            }
+        });
+    }
+
+    // Write single coil (0x05); the reply echoes the request
+    static Exception write_single_coil(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        const std::uint16_t address = read_be16(pdu + 1);
+        const std::uint16_t value = read_be16(pdu + 3);
+        if (value != 0xFF00U && value != 0x0000U) {
+            return ILLEGAL_DATA_VALUE;
+        }
+        if (!self.coils_exist(address, 1)) {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        self.set_coil(address, value != 0);
+        length = 5;
+        return NONE;
+    }
+
+    // Write single register (0x06); the reply echoes the request
+    static Exception write_single_register(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        const std::uint16_t address = read_be16(pdu + 1);
+        const std::uint16_t value = read_be16(pdu + 3);
+        if (address >= ALARM_REGISTERS) {
+            const std::uint16_t offset = static_cast<std::uint16_t>(address - ALARM_REGISTERS);
+            if (!in_range(offset, 1, self.alarm_registers())) {
+                return ILLEGAL_DATA_ADDRESS;
+            }
+            if (!valid_alarm_register(offset, value)) {
+                return ILLEGAL_DATA_VALUE;
+            }
+            self.set_alarm_register(offset, value);
+            length = 5;
+            return NONE;
+        }
+        if (!in_range(address, 1, self.outputs.size())) {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        if (!valid_interval(value)) {
+            return ILLEGAL_DATA_VALUE;
+        }
+        self.outputs.at(static_cast<std::uint8_t>(address)).set_blink_interval(value);
+        length = 5;
+        return NONE;
+    }
+
+    // Write multiple coils (0x0F); the reply is the first five bytes of the request
+    static Exception write_multiple_coils(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        const std::uint16_t first = read_be16(pdu + 1);
+        const std::uint16_t quantity = read_be16(pdu + 3);
+        if (quantity < 1U || quantity > 1968U || pdu[5] != (quantity + 7U) / 8U || length != 6U + pdu[5]) {
+            return ILLEGAL_DATA_VALUE;
+        }
+        if (!self.coils_exist(first, quantity)) {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        for (std::uint16_t i = 0; i < quantity; ++i) {
+            self.set_coil(static_cast<std::uint16_t>(first + i), ((pdu[6 + i / 8U] >> (i % 8U)) & 1U) != 0);
+        }
+        length = 5;
+        return NONE;
+    }
+
+    // Write multiple registers (0x10); the reply is the first five bytes of the request
+    static Exception write_multiple_registers(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        const std::uint16_t first = read_be16(pdu + 1);
+        const std::uint16_t quantity = read_be16(pdu + 3);
+        if (quantity < 1U || quantity > 123U || pdu[5] != 2U * quantity || length != 6U + pdu[5]) {
+            return ILLEGAL_DATA_VALUE;
+        }
+        if (first >= ALARM_REGISTERS) {
+            return write_alarm_registers(self, pdu, length);
+        }
+        if (!in_range(first, quantity, self.outputs.size())) {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        for (std::uint16_t i = 0; i < quantity; ++i) {
+            if (!valid_interval(read_be16(pdu + 6 + 2U * i))) {
+                return ILLEGAL_DATA_VALUE;
+            }
+        }
+        for (std::uint16_t i = 0; i < quantity; ++i) {
+            self.outputs.at(static_cast<std::uint8_t>(first + i)).set_blink_interval(read_be16(pdu + 6 + 2U * i));
+        }
+        length = 5;
+        return NONE;
+    }
+
+    static Exception write_alarm_registers(ModbusSlaveActor& self, std::uint8_t* pdu, std::uint8_t& length) {
+        const std::uint16_t offset = static_cast<std::uint16_t>(read_be16(pdu + 1) - ALARM_REGISTERS);
+        const std::uint16_t quantity = read_be16(pdu + 3);
+        if (!in_range(offset, quantity, self.alarm_registers())) {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        for (std::uint16_t i = 0; i < quantity; ++i) {
+            if (!valid_alarm_register(static_cast<std::uint16_t>(offset + i), read_be16(pdu + 6 + 2U * i))) {
+                return ILLEGAL_DATA_VALUE;
+            }
+        }
+        for (std::uint16_t i = 0; i < quantity; ++i) {
+            self.set_alarm_register(static_cast<std::uint16_t>(offset + i), read_be16(pdu + 6 + 2U * i));
+        }
+        length = 5;
+        return NONE;
+    }
+
+    // The functions of the slave, in flash, by code for the binary search
+    static constexpr auto FUNCTIONS PROGMEM = ramen::pgm_array<Function>({
+        {0x01, 5, false, &read_coils},
+        {0x02, 5, false, &read_discrete_inputs},
+        {0x03, 5, false, &read_holding_registers},
+        {0x04, 5, false, &read_input_registers},
+        {0x05, 5, true, &write_single_coil},
+        {0x06, 5, true, &write_single_register},
+        {0x0F, 6, true, &write_multiple_coils},
+        {0x10, 6, true, &write_multiple_registers},
+    });
+
+    // Copies the function of `code` from flash; false if the slave has none
+    static bool find(std::uint8_t code, Function& function) {
+        const auto it = std::lower_bound(FUNCTIONS.begin(), FUNCTIONS.end(), code,
+                                         [](const Function& f, std::uint8_t c) { return f.code < c; });
+        if (it == FUNCTIONS.end() || pgm_read_byte(&it.base()->code) != code) {
+            return false;
+        }
+        function = *it;
+        return true;
+    }
+};
+
+} // namespace modbus
@@ -0,0 +1,195 @@
+#pragma once
+#include "actor_modbus.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if defined(MODBUS_TCP)
+#include <Ethernet.h>
+#endif
+
+// Modbus TCP server on the W5100, for a SCADA that polls over Ethernet rather than RS485. It has no data model of its
+// own: each request goes to the PDU handler of a ModbusSlaveActor, so the coils, registers and alarm window are the
+// ones the RTU master sees, served by the same flash table of function codes.
+//
+//     modbus::ModbusTcpActor<> modbus_tcp(modbus_slave);
+//     void setup() { modbus_tcp.begin(mac, {192, 168, 1, 177}); }  // Or begin() once another actor started Ethernet
+//     void loop()  { modbus_tcp.update(); ... }
+//
+// An ADU is the 7-byte MBAP header (transaction, protocol 0, length, unit) and the PDU. A connection keeps the header
+// of the request it waits for, nothing else: once the socket holds the whole PDU, it is read with a single block
+// transfer out of the W5100's receive buffer into the frame buffer behind the header, handled there in place, the
+// reply overwriting the request, and sent back with one write. The buffer is the actor's only one, shared by the
+// connections as update() serves them one after another, a request each per pass. The unit id is echoed and not
+// checked, as the server is the device itself; requests on unit 0 are answered, not taken as broadcasts.
+//
+// Up to Connections clients at a time, each one a socket of the W5100's four, beside those of the UDP endpoint,
+// MQTT-SN and the status page; a client beyond them is closed at once. A header that is not Modbus closes its
+// connection, and so does IDLE_TIMEOUT_MS without a request, which frees the socket of a SCADA that went away without
+// closing. Opt-in with -D MODBUS_TCP; without it the actor does nothing and the Ethernet library is not used.
+
+namespace modbus {
+
+#if defined(MODBUS_TCP)
+constexpr bool TCP_ENABLED = true;
+#else
+constexpr bool TCP_ENABLED = false;
+#endif
+
+template <std::uint8_t Connections = 2>
+class ModbusTcpActor {
+    static_assert(Connections > 0 && Connections < 4, "The W5100 has four sockets, one of them listening");
+
+public:
+    static constexpr std::uint16_t DEFAULT_PORT = 502;
+    static constexpr std::uint8_t MBAP_SIZE = 7;
+    static constexpr std::uint32_t IDLE_TIMEOUT_MS = 60000;
+    static constexpr std::uint16_t CLOSE_TIMEOUT_MS = 10;  // Bounds the wait of EthernetClient::stop() for the FIN
+
+    explicit ModbusTcpActor(ModbusSlaveActor& slave) : slave_(slave) {}
+    ModbusTcpActor(const ModbusTcpActor&) = delete;
+    ModbusTcpActor& operator=(const ModbusTcpActor&) = delete;
+
+    // Starts the Ethernet interface with a static address, then listens as below; false if no W5100 answers
+    bool begin(std::uint8_t (&mac)[6], const std::uint8_t (&ip)[4], std::uint16_t port = DEFAULT_PORT) {
+#if defined(MODBUS_TCP)
+        Ethernet.begin(mac, IPAddress(ip[0], ip[1], ip[2], ip[3]));
+        if (Ethernet.hardwareStatus() == EthernetNoHardware) {
+            return false;
+        }
+#else
+        (void)mac;
+        (void)ip;
+#endif
+        return begin(port);
+    }
+
+    // Listens on `port` of an Ethernet interface already up; false without -D MODBUS_TCP
+    bool begin(std::uint16_t port = DEFAULT_PORT) {
+#if defined(MODBUS_TCP)
+        server_ = EthernetServer(port);
+        server_.begin();
+        return true;
+#else
+        (void)port;
+        return false;
+#endif
+    }
+
+    // Accepts a client, and answers at most one request of each connection
+    void update() {
+#if defined(MODBUS_TCP)
+        accept();
+        for (Connection& c : connections_) {
+            if (c.open) {
+                serve(c);
+            }
+        }
+#endif
+    }
+
+    std::uint8_t connections() const {
+        std::uint8_t n = 0;
+#if defined(MODBUS_TCP)
+        for (const Connection& c : connections_) {
+            n = static_cast<std::uint8_t>(n + (c.open ? 1U : 0U));
+        }
+#endif
+        return n;
+    }
+
+    // Counters, saturating at 65535
+    std::uint16_t refused() const { return refused_; }    // Clients beyond Connections
+    std::uint16_t bad_headers() const { return bad_headers_; }
+    std::uint16_t timeouts() const { return timeouts_; }  // Connections closed for being idle
+
+private:
+#if defined(MODBUS_TCP)
+    struct Connection {
+        EthernetClient client;
+        bool open = false;
+        std::array<std::uint8_t, MBAP_SIZE> header{};
+        bool has_header = false;  // Of the request whose PDU is awaited
+        scan_clock::Timestamp last_ms = 0;
+    };
+
+    EthernetServer server_{DEFAULT_PORT};
+    std::array<Connection, Connections> connections_{};
+    std::uint8_t adu_[MBAP_SIZE + ModbusSlaveActor::MAX_PDU];
+#endif
+    ModbusSlaveActor& slave_;
+    std::uint16_t refused_ = 0;
+    std::uint16_t bad_headers_ = 0;
+    std::uint16_t timeouts_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+#if defined(MODBUS_TCP)
+    void accept() {
+        EthernetClient client = server_.accept();
+        if (!client) {
+            return;
+        }
+        for (Connection& c : connections_) {
+            if (!c.open) {
+                client.setConnectionTimeout(CLOSE_TIMEOUT_MS);
+                c.client = client;
+                c.open = true;
+                c.has_header = false;
+                c.last_ms = scan_clock::now();
+                return;
+            }
+        }
+        count(refused_);
+        client.setConnectionTimeout(CLOSE_TIMEOUT_MS);
+        client.stop();
+    }
+
+    void serve(Connection& c) {
+        if (!c.client.connected() && c.client.available() == 0) {
+            close(c);
+            return;
+        }
+        if (!c.has_header && c.client.available() >= MBAP_SIZE) {
+            c.client.read(c.header.data(), MBAP_SIZE);
+            const std::uint16_t length = static_cast<std::uint16_t>((c.header[4] << 8) | c.header[5]);
+            if (c.header[2] != 0 || c.header[3] != 0 || length < 2U || length > 1U + ModbusSlaveActor::MAX_PDU) {
+                count(bad_headers_);
+                close(c);
+                return;
+            }
+            c.has_header = true;
+        }
+        const std::uint8_t pdu_length = static_cast<std::uint8_t>(((c.header[4] << 8) | c.header[5]) - 1U);
+        if (!c.has_header || c.client.available() < pdu_length) {
+            if (scan_clock::now() - c.last_ms >= IDLE_TIMEOUT_MS) {
+                count(timeouts_);
+                close(c);
+            }
+            return;  // The rest of the request on a later pass
+        }
+        c.has_header = false;
+        c.last_ms = scan_clock::now();
+        std::copy(c.header.begin(), c.header.end(), adu_);
+        c.client.read(adu_ + MBAP_SIZE, pdu_length);
+        const std::uint8_t reply = slave_.handle_pdu(adu_ + MBAP_SIZE, pdu_length);
+        adu_[4] = 0;
+        adu_[5] = static_cast<std::uint8_t>(reply + 1U);
+        c.client.write(adu_, MBAP_SIZE + reply);
+    }
+
+    void close(Connection& c) {
+        c.client.stop();
+        c.open = false;
+        c.has_header = false;
+    }
+#endif
+};
+
+} // namespace modbus
@@ -0,0 +1,525 @@
+#pragma once
+#include "fmt.hpp"
+#include "output_registry.hpp"
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(MQTT_SN)
+#include <Ethernet.h>
+#include <EthernetUdp.h>
+#endif
+
+// Push-based telemetry for plant-wide monitoring: an MQTT-SN client on the W5100's UDP that publishes the state of
+// the outputs, and any value linked to it, when it changes, instead of a host polling each board with 'status'.
+//
+//     mqtt_sn::MqttSnActor<8> mqtt(outputs);
+//     void setup() {
+//         mqtt.publish_outputs(1, mqtt_sn::Qos::AT_LEAST_ONCE);   // Topic ids 1..3: state of LED1..LED3
+//         mqtt.add(10) >> parts.count_out;                        // Topic id 10: a Pullable<std::uint32_t>
+//         mqtt.begin(mac, {192, 168, 1, 177}, {192, 168, 1, 10}, "plc-7");  // Gateway 192.168.1.10
+//     }
+//     void loop() { mqtt.update(); ... }
+//
+// Topics are predefined topic ids, agreed with the gateway beforehand, so there is no REGISTER exchange and a publish
+// is a 7-byte header and the value in decimal, "2" or "1500". update() reads every channel once per pass; a channel
+// whose value differs from the last one taken is published, at most once per min_interval() so that a counter ticking
+// every pass does not flood the network, and always with the retain flag, so that a new subscriber sees the state
+// without waiting for the next change. The publishes of one pass go out together: MQTT-SN messages carry their own
+// length, and update() packs as many as fit into each datagram of DATAGRAM_SIZE bytes (set_batch_limit(1) for a
+// gateway that reads one message per datagram). The other direction is handled the same way: a datagram of the
+// gateway may hold several CONNACK, PUBACK or PINGRESP messages.
+//
+// Queueing is bounded by the channels themselves: a channel holds its latest value only, so a burst of changes costs
+// no memory and the subscriber sees the last one. QoS 0 channels are sent and forgotten. A QoS 1 channel has one
+// publish in flight at most, in one of the MaxInFlight slots, and is resent with the DUP flag every RETRY_MS until its
+// PUBACK; a change in the meantime is published after it. Channels that find no slot, or no room in the datagrams of
+// the pass, stay pending for the next pass. After MAX_RETRIES resends, or KEEP_ALIVE_S without a word from the gateway
+// (PINGREQ asks for one), the client connects again and publishes every channel once more.
+//
+// Opt-in with -D MQTT_SN; without it the actor does nothing and the Ethernet library is not used. The client takes
+// one of the W5100's four sockets, beside that of net::UdpEndpointActor if both are built in.
+
+namespace mqtt_sn {
+
+#if defined(MQTT_SN)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+enum class Qos : std::uint8_t { AT_MOST_ONCE = 0, AT_LEAST_ONCE = 1 };
+
+// Message types and flags of MQTT-SN 1.2
+enum MsgType : std::uint8_t {
+    CONNECT = 0x04,
+    CONNACK = 0x05,
+    PUBLISH = 0x0C,
+    PUBACK = 0x0D,
+    PINGREQ = 0x16,
+    PINGRESP = 0x17,
+    DISCONNECT = 0x18
+};
+
+enum Flags : std::uint8_t {
+    DUP = 0x80,
+    QOS_1 = 0x20,
+    RETAIN = 0x10,
+    CLEAN_SESSION = 0x04,
+    TOPIC_PREDEFINED = 0x01
+};
+
+constexpr std::uint8_t PROTOCOL_ID = 0x01;
+constexpr std::uint8_t ACCEPTED = 0x00;
+constexpr std::uint8_t REJECTED_CONGESTION = 0x01;
+constexpr std::uint8_t PUBLISH_HEADER_SIZE = 7;  // Length, type, flags, topic id, message id
+constexpr std::uint8_t MAX_CLIENT_ID = 23;
+
+inline void write_be16(std::uint8_t* p, std::uint16_t value) {
+    p[0] = static_cast<std::uint8_t>(value >> 8);
+    p[1] = static_cast<std::uint8_t>(value);
+}
+
+inline std::uint16_t read_be16(const std::uint8_t* p) {
+    return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+// Writes a PUBLISH of `value` in decimal to a predefined topic and returns its length, or 0 if `room` is too small
+inline std::uint8_t encode_publish(std::uint8_t* out, std::size_t room, std::uint16_t topic_id, std::uint16_t msg_id,
+                                   std::uint8_t flags, std::uint32_t value) {
+    fmt::Line<11> text;  // Up to 4294967295
+    fmt::write(text, static_cast<unsigned long>(value));
+    const std::size_t length = PUBLISH_HEADER_SIZE + text.size();
+    if (length > room) {
+        return 0;
+    }
+    out[0] = static_cast<std::uint8_t>(length);
+    out[1] = PUBLISH;
+    out[2] = static_cast<std::uint8_t>(flags | TOPIC_PREDEFINED);
+    write_be16(out + 3, topic_id);
+    write_be16(out + 5, msg_id);
+    std::memcpy(out + PUBLISH_HEADER_SIZE, text.c_str(), text.size());
+    return static_cast<std::uint8_t>(length);
+}
+
+template <std::uint8_t MaxChannels, std::uint8_t MaxInFlight = 4>
+class MqttSnActor {
+    static_assert(MaxChannels > 0 && MaxChannels < 0xFF, "1 to 254 channels");
+    static_assert(MaxInFlight > 0, "QoS 1 needs a slot for a publish in flight");
+
+public:
+    static constexpr std::uint16_t DEFAULT_GATEWAY_PORT = 1884;
+    static constexpr std::uint16_t DEFAULT_LOCAL_PORT = 1884;
+    static constexpr std::uint16_t KEEP_ALIVE_S = 60;
+    static constexpr std::uint32_t RETRY_MS = 3000;  // T_retry of the specification, short for a plant network
+    static constexpr std::uint8_t MAX_RETRIES = 3;
+    static constexpr std::uint8_t DATAGRAM_SIZE = 64;
+    static constexpr std::uint8_t MAX_DATAGRAMS_PER_UPDATE = 4;  // Bounds the time update() takes, both ways
+    static constexpr std::uint8_t NO_CHANNEL = 0xFF;
+
+    enum class State : std::uint8_t { IDLE, CONNECTING, CONNECTED };
+
+    explicit MqttSnActor(const led::OutputTable& output_table) : outputs(output_table) {}
+    MqttSnActor(const MqttSnActor&) = delete;
+    MqttSnActor& operator=(const MqttSnActor&) = delete;
+
+    // A channel published to `topic_id` from the value it pulls; link it to a Pullable<std::uint32_t>. With every
+    // channel taken, a puller of a channel that never publishes
+    ramen::Puller<std::uint32_t>& add(std::uint16_t topic_id, Qos qos = Qos::AT_MOST_ONCE) {
+        const std::uint8_t c = add_channel(topic_id, qos, NO_OUTPUT);
+        return (c != NO_CHANNEL) ? channels_[c].in : spare_;
+    }
+
+    // A channel per output, publishing its led::state_id to first_topic_id + index; false if the channels run out
+    bool publish_outputs(std::uint16_t first_topic_id, Qos qos = Qos::AT_MOST_ONCE) {
+        for (std::uint8_t i = 0; i < outputs.size(); ++i) {
+            if (add_channel(static_cast<std::uint16_t>(first_topic_id + i), qos, i) == NO_CHANNEL) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Starts the Ethernet interface with a static address, then connects as below; false if no W5100 answers
+    bool begin(std::uint8_t (&mac)[6], const std::uint8_t (&ip)[4], const std::uint8_t (&gateway)[4],
+               const char* client_id, std::uint16_t gateway_port = DEFAULT_GATEWAY_PORT) {
+#if defined(MQTT_SN)
+        Ethernet.begin(mac, IPAddress(ip[0], ip[1], ip[2], ip[3]));
+        if (Ethernet.hardwareStatus() == EthernetNoHardware) {
+            return false;
+        }
+#else
+        (void)mac;
+        (void)ip;
+#endif
+        return begin(gateway, client_id, gateway_port);
+    }
+
+    // Opens the socket and connects to the gateway, on an Ethernet interface already up (e.g. by
+    // net::UdpEndpointActor::begin(): a second Ethernet.begin() would reset its socket). The id is kept by pointer, up
+    // to 23 chars. False without -D MQTT_SN or if the W5100 has no free socket
+    bool begin(const std::uint8_t (&gateway)[4], const char* client_id,
+               std::uint16_t gateway_port = DEFAULT_GATEWAY_PORT, std::uint16_t local_port = DEFAULT_LOCAL_PORT) {
+#if defined(MQTT_SN)
+        gateway_ip_ = IPAddress(gateway[0], gateway[1], gateway[2], gateway[3]);
+        gateway_port_ = gateway_port;
+        client_id_ = client_id;
+        if (udp_.begin(local_port) != 1) {
+            return false;
+        }
+        reconnect();
+        return true;
+#else
+        (void)gateway;
+        (void)client_id;
+        (void)gateway_port;
+        (void)local_port;
+        return false;
+#endif
+    }
+
+    // Handles the gateway's datagrams, then publishes the channels that changed
+    void update() {
+#if defined(MQTT_SN)
+        receive();
+        const std::uint32_t now = scan_clock::now();
+        if (state_ == State::CONNECTING) {
+            if (now - sent_ms_ >= RETRY_MS) {
+                send_connect();
+            }
+            return;
+        }
+        if (state_ != State::CONNECTED) {
+            return;
+        }
+        if (now - heard_ms_ >= KEEP_ALIVE_S * 1000UL + MAX_RETRIES * RETRY_MS) {
+            reconnect();
+            return;
+        }
+        sample();
+        length_ = 0;
+        messages_ = 0;
+        datagrams_ = 0;
+        if (!resend_due(now)) {
+            return;  // The connection is lost
+        }
+        if (now - published_ms_ >= min_interval_ms_) {
+            publish_pending(now);
+        }
+        const bool quiet = now - sent_ms_ >= KEEP_ALIVE_S * 1000UL;
+        const bool unheard = now - heard_ms_ >= KEEP_ALIVE_S * 1000UL && now - ping_ms_ >= RETRY_MS;
+        if (length_ + 2U <= DATAGRAM_SIZE && (quiet || unheard)) {
+            buffer_[length_++] = 2;
+            buffer_[length_++] = PINGREQ;
+            ping_ms_ = now;
+        }
+        flush();
+#endif
+    }
+
+    // Coalesces the changes of a channel over `ms`: one publish per interval at most, of the latest value
+    void set_min_interval(std::uint32_t ms) { min_interval_ms_ = ms; }
+    std::uint32_t min_interval() const { return min_interval_ms_; }
+
+    // Messages packed into one datagram, 1 to one per channel
+    void set_batch_limit(std::uint8_t messages) { batch_limit_ = (messages > 0) ? messages : 1; }
+
+    State state() const { return state_; }
+    bool connected() const { return state_ == State::CONNECTED; }
+    std::uint8_t channels() const { return count_; }
+    std::uint8_t in_flight() const { return in_flight_; }
+
+    // Counters, saturating at 65535
+    std::uint16_t published() const { return published_; }    // PUBLISH messages sent, resends included
+    std::uint16_t datagrams() const { return datagrams_sent_; }
+    std::uint16_t rejected() const { return rejected_; }      // PUBACKs refusing a publish, e.g. an unknown topic id
+    std::uint16_t reconnects() const { return reconnects_; }
+
+private:
+    static constexpr std::uint8_t NO_OUTPUT = 0xFF;
+
+    enum ChannelFlags : std::uint8_t {
+        AT_LEAST_ONCE = 0x01,
+        PENDING = 0x02,    // The value was not published yet
+        IN_FLIGHT = 0x04,  // A QoS 1 publish waits for its PUBACK
+        TAKEN = 0x08       // A value was read since the connection
+    };
+
+    struct Channel {
+        ramen::Puller<std::uint32_t> in;
+        std::uint32_t value = 0;  // Latest read
+        std::uint16_t topic_id = 0;
+        std::uint8_t output = NO_OUTPUT;  // Index in the table, or NO_OUTPUT to pull `in`
+        std::uint8_t flags = 0;
+    };
+
+    struct InFlight {
+        std::uint32_t value;
+        std::uint32_t sent_ms;
+        std::uint16_t msg_id;
+        std::uint8_t channel;  // NO_CHANNEL if the slot is free
+        std::uint8_t retries;
+    };
+
+    const led::OutputTable& outputs;
+    std::array<Channel, MaxChannels> channels_{};
+    ramen::Puller<std::uint32_t> spare_;
+    std::uint8_t count_ = 0;
+    State state_ = State::IDLE;
+    std::uint32_t min_interval_ms_ = 0;
+    std::uint8_t batch_limit_ = 0xFF;
+    std::uint8_t in_flight_ = 0;
+    std::uint16_t published_ = 0;
+    std::uint16_t datagrams_sent_ = 0;
+    std::uint16_t rejected_ = 0;
+    std::uint16_t reconnects_ = 0;
+#if defined(MQTT_SN)
+    EthernetUDP udp_;
+    IPAddress gateway_ip_;
+    std::uint16_t gateway_port_ = 0;
+    const char* client_id_ = "";
+    std::array<InFlight, MaxInFlight> slots_{};
+    std::uint16_t msg_id_ = 0;
+    std::uint32_t sent_ms_ = 0;       // Of the last datagram sent
+    std::uint32_t heard_ms_ = 0;      // Of the last message of the gateway
+    std::uint32_t ping_ms_ = 0;
+    std::uint32_t published_ms_ = 0;  // Of the last pass that published
+    std::uint8_t buffer_[DATAGRAM_SIZE];
+    std::uint8_t length_ = 0;         // Of the datagram being packed
+    std::uint8_t messages_ = 0;       // In it
+    std::uint8_t datagrams_ = 0;      // Sent in this pass
+#endif
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    std::uint8_t add_channel(std::uint16_t topic_id, Qos qos, std::uint8_t output) {
+        if (count_ >= MaxChannels) {
+            return NO_CHANNEL;
+        }
+        Channel& c = channels_[count_];
+        c.topic_id = topic_id;
+        c.output = output;
+        c.flags = (qos == Qos::AT_LEAST_ONCE) ? AT_LEAST_ONCE : 0;
+        return count_++;
+    }
+
+#if defined(MQTT_SN)
+    // A new session: the publishes in flight are abandoned and every channel is published again once connected
+    void reconnect() {
+        if (state_ == State::CONNECTED) {
+            count(reconnects_);
+        }
+        for (InFlight& slot : slots_) {
+            slot.channel = NO_CHANNEL;
+        }
+        in_flight_ = 0;
+        for (std::uint8_t i = 0; i < count_; ++i) {
+            channels_[i].flags = static_cast<std::uint8_t>(channels_[i].flags & AT_LEAST_ONCE);
+        }
+        state_ = State::CONNECTING;
+        send_connect();
+    }
+
+    void send_connect() {
+        std::size_t id_length = std::strlen(client_id_);
+        id_length = (id_length < MAX_CLIENT_ID) ? id_length : MAX_CLIENT_ID;
+        buffer_[0] = static_cast<std::uint8_t>(6U + id_length);
+        buffer_[1] = CONNECT;
+        buffer_[2] = CLEAN_SESSION;
+        buffer_[3] = PROTOCOL_ID;
+        write_be16(buffer_ + 4, KEEP_ALIVE_S);
+        std::memcpy(buffer_ + 6, client_id_, id_length);
+        length_ = buffer_[0];
+        messages_ = 1;
+        flush();
+    }
+
+    void receive() {
+        for (std::uint8_t i = 0; i < MAX_DATAGRAMS_PER_UPDATE; ++i) {
+            const int size = udp_.parsePacket();
+            if (size <= 0) {
+                return;
+            }
+            if (udp_.remoteIP() != gateway_ip_ || udp_.remotePort() != gateway_port_ || size > DATAGRAM_SIZE) {
+                continue;  // The next parsePacket() skips the rest of it
+            }
+            std::uint8_t datagram[DATAGRAM_SIZE];
+            const int n = udp_.read(datagram, static_cast<std::size_t>(size));
+            for (int at = 0; at + 2 <= n && datagram[at] >= 2 && at + datagram[at] <= n; at += datagram[at]) {
+                on_message(datagram + at, datagram[at]);
+            }
+        }
+    }
+
+    void on_message(const std::uint8_t* msg, std::uint8_t length) {
+        switch (msg[1]) {
+        case CONNACK:
+            if (length >= 3 && state_ == State::CONNECTING && msg[2] == ACCEPTED) {
+                state_ = State::CONNECTED;
+                heard_ms_ = ping_ms_ = scan_clock::now();
+                published_ms_ = heard_ms_ - min_interval_ms_;  // Every channel goes out right away
+            }
+            return;
+        case PUBACK:
+            if (length >= 7) {
+                on_puback(read_be16(msg + 4), msg[6]);
+            }
+            break;
+        case DISCONNECT:
+            reconnect();
+            return;
+        default:
+            break;  // PINGRESP, or a message the client does not use
+        }
+        heard_ms_ = scan_clock::now();
+    }
+
+    void on_puback(std::uint16_t msg_id, std::uint8_t code) {
+        for (InFlight& slot : slots_) {
+            if (slot.channel == NO_CHANNEL || slot.msg_id != msg_id) {
+                continue;
+            }
+            Channel& c = channels_[slot.channel];
+            c.flags = static_cast<std::uint8_t>(c.flags & ~IN_FLIGHT);
+            if (code == REJECTED_CONGESTION) {
+                c.flags |= PENDING;  // Again on a later pass, with the latest value
+            } else if (code != ACCEPTED) {
+                count(rejected_);
+            }
+            slot.channel = NO_CHANNEL;
+            --in_flight_;
+            return;
+        }
+    }
+
+    // Reads every channel, marking those that changed since the value taken last
+    void sample() {
+        for (std::uint8_t i = 0; i < count_; ++i) {
+            Channel& c = channels_[i];
+            std::uint32_t value = c.value;
+            if (c.output != NO_OUTPUT) {
+                value = outputs.contains(c.output) ? outputs.at(c.output).state_id() : 0;
+            } else if (c.in) {
+                c.in(value);
+            }
+            if (value != c.value || (c.flags & TAKEN) == 0) {
+                c.value = value;
+                c.flags |= PENDING | TAKEN;
+            }
+        }
+    }
+
+    // Resends the QoS 1 publishes whose PUBACK is overdue; false once one ran out of retries
+    bool resend_due(std::uint32_t now) {
+        for (InFlight& slot : slots_) {
+            if (slot.channel == NO_CHANNEL || now - slot.sent_ms < RETRY_MS) {
+                continue;
+            }
+            if (slot.retries >= MAX_RETRIES) {
+                reconnect();
+                return false;
+            }
+            if (!append(channels_[slot.channel].topic_id, slot.msg_id, DUP | QOS_1 | RETAIN, slot.value)) {
+                return true;  // The rest next pass
+            }
+            ++slot.retries;
+            slot.sent_ms = now;
+        }
+        return true;
+    }
+
+    void publish_pending(std::uint32_t now) {
+        bool any = false;
+        for (std::uint8_t i = 0; i < count_; ++i) {
+            Channel& c = channels_[i];
+            if ((c.flags & PENDING) == 0 || (c.flags & IN_FLIGHT) != 0) {
+                continue;
+            }
+            if ((c.flags & AT_LEAST_ONCE) == 0) {
+                if (!append(c.topic_id, 0, RETAIN, c.value)) {
+                    break;
+                }
+            } else {
+                InFlight* slot = free_slot();
+                if (slot == nullptr) {
+                    continue;  // QoS 0 channels may still go out
+                }
+                const std::uint16_t id = next_msg_id();
+                if (!append(c.topic_id, id, QOS_1 | RETAIN, c.value)) {
+                    break;
+                }
+                *slot = InFlight{c.value, now, id, i, 0};
+                ++in_flight_;
+                c.flags |= IN_FLIGHT;
+            }
+            c.flags = static_cast<std::uint8_t>(c.flags & ~PENDING);
+            any = true;
+        }
+        if (any) {
+            published_ms_ = now;
+        }
+    }
+
+    InFlight* free_slot() {
+        for (InFlight& slot : slots_) {
+            if (slot.channel == NO_CHANNEL) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    std::uint16_t next_msg_id() {
+        msg_id_ = static_cast<std::uint16_t>(msg_id_ + 1U);
+        if (msg_id_ == 0) {
+            msg_id_ = 1;  // 0 is not a message id
+        }
+        return msg_id_;
+    }
+
+    // Packs a publish into the datagram, sending the datagram first if it is full; false when the pass is out of
+    // datagrams
+    bool append(std::uint16_t topic_id, std::uint16_t msg_id, std::uint8_t flags, std::uint32_t value) {
+        for (;;) {
+            if (datagrams_ >= MAX_DATAGRAMS_PER_UPDATE) {
+                return false;
+            }
+            if (messages_ < batch_limit_) {
+                const std::uint8_t n =
+                    encode_publish(buffer_ + length_, DATAGRAM_SIZE - length_, topic_id, msg_id, flags, value);
+                if (n > 0) {
+                    length_ = static_cast<std::uint8_t>(length_ + n);
+                    ++messages_;
+                    count(published_);
+                    return true;
+                }
+            }
+            flush();
+        }
+    }
+
+    void flush() {
+        if (length_ == 0) {
+            return;
+        }
+        if (udp_.beginPacket(gateway_ip_, gateway_port_) == 1) {
+            udp_.write(buffer_, length_);
+            udp_.endPacket();
+            count(datagrams_sent_);
+        }
+        sent_ms_ = scan_clock::now();
+        length_ = 0;
+        messages_ = 0;
+        ++datagrams_;
+    }
+#endif
+};
+
+} // namespace mqtt_sn
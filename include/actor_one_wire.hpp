@@ -0,0 +1,396 @@
+#pragma once
+#include "event.hpp"
+#include "fast_pin.hpp"
+#include "fixed_point.hpp"
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// DS18B20 temperature sensors on a 1-Wire bus, read without waiting for them. The usual library call converts and
+// reads one sensor at a time and waits out the conversion, 750 ms at 12 bits. Here one Convert T, with Skip ROM,
+// starts every sensor on the bus at once; the TimerActor schedules the readout once the conversion is done, and the
+// scratchpads are then read across successive scans, one bus operation (a reset or a byte) per update():
+//
+//     onewire::Ds18b20Actor<16, CONTROLLINO_PIN_HEADER_DIGITAL_OUT_12> sensors(5000);  // Every 5 s
+//     void setup() {
+//         sensors.arm_timer_request_out >> timer.arm_timer_request_in;
+//         sensors.reading_out >> log_in;     // One Reading a sensor a cycle, ok() or not
+//         sensors.begin();                   // Searches the bus for the sensors, once and blocking
+//         sensors.start();
+//     }
+//     void loop() { sensors.update(); ... }
+//
+// A byte is 8 time slots of 70 us, so an update() costs about 0.6 ms, a reset 1 ms; interrupts are off only during
+// the part of a slot whose timing matters, at most 60 us. A sensor takes 20 operations (reset, Match ROM and its 8
+// bytes, Read Scratchpad and its 9 bytes), so 16 sensors are read in 320 scans. The interval runs from one Convert T
+// to the next, and should leave room for the conversion and the readout.
+//
+// Sensors are found by begin() (the Search ROM algorithm), or added by ROM code; with none, the actor reads the one
+// sensor of its bus with Skip ROM. A reading whose scratchpad fails its CRC, or a sensor that does not answer the
+// reset, is published with ok() false and counted. The bus is a 5 V pin of the pin header (the screw terminals are
+// 24 V drivers) with its 4.7 kOhm pull-up; parasite power is not supported.
+
+namespace onewire {
+
+enum Command : std::uint8_t {
+    SEARCH_ROM = 0xF0,
+    MATCH_ROM = 0x55,
+    SKIP_ROM = 0xCC,
+    CONVERT_T = 0x44,
+    READ_SCRATCHPAD = 0xBE
+};
+
+constexpr std::uint8_t FAMILY_DS18B20 = 0x28;
+constexpr std::uint8_t SCRATCHPAD_SIZE = 9;  // Temperature LSB and MSB first, CRC last
+
+using Rom = std::array<std::uint8_t, 8>;  // Family code, 48-bit serial number, CRC
+using Celsius = fx::Fixed<11, 4>;         // The sensor's own format: steps of 1/16 degree
+
+// Dallas/Maxim CRC-8 (x^8 + x^5 + x^4 + 1); 0 over a ROM code or a scratchpad including its CRC byte
+inline std::uint8_t crc8(const std::uint8_t* data, std::uint8_t length) {
+    std::uint8_t crc = 0;
+    for (std::uint8_t i = 0; i < length; ++i) {
+        std::uint8_t byte = data[i];
+        for (std::uint8_t bit = 0; bit < 8; ++bit) {
+            const bool mix = ((crc ^ byte) & 1U) != 0;
+            crc = static_cast<std::uint8_t>(crc >> 1);
+            if (mix) {
+                crc ^= 0x8C;
+            }
+            byte = static_cast<std::uint8_t>(byte >> 1);
+        }
+    }
+    return crc;
+}
+
+// The bus on one pin, driven open-drain: low as an output, released as an input. Time slots of the standard speed,
+// with interrupts off from the falling edge to the sample or the release
+template <std::uint8_t Pin>
+struct PinBus {
+    using pin = gpio::FastPin<Pin>;
+
+    static void begin() {
+        pin::set_output(false);
+        pin::low();  // Never driven high: releasing lets the pull-up raise the line
+    }
+
+    // Reset pulse; true if a device answered with a presence pulse
+    static bool reset() {
+        pin::set_output(true);
+        delayMicroseconds(480);  // With interrupts on: a longer reset is still a reset
+        const std::uint8_t sreg = lock();
+        pin::set_output(false);
+        delayMicroseconds(70);
+        const bool present = !pin::read();
+        unlock(sreg);
+        delayMicroseconds(410);
+        return present;
+    }
+
+    static void write_bit(bool bit) {
+        const std::uint8_t sreg = lock();
+        pin::set_output(true);
+        delayMicroseconds(bit ? 6 : 60);
+        pin::set_output(false);
+        unlock(sreg);
+        delayMicroseconds(bit ? 64 : 10);
+    }
+
+    static bool read_bit() {
+        const std::uint8_t sreg = lock();
+        pin::set_output(true);
+        delayMicroseconds(3);
+        pin::set_output(false);
+        delayMicroseconds(10);
+        const bool bit = pin::read();
+        unlock(sreg);
+        delayMicroseconds(53);
+        return bit;
+    }
+
+    static void write_byte(std::uint8_t byte) {
+        for (std::uint8_t i = 0; i < 8; ++i) {
+            write_bit((byte & (1U << i)) != 0);  // LSB first
+        }
+    }
+
+    static std::uint8_t read_byte() {
+        std::uint8_t byte = 0;
+        for (std::uint8_t i = 0; i < 8; ++i) {
+            if (read_bit()) {
+                byte = static_cast<std::uint8_t>(byte | (1U << i));
+            }
+        }
+        return byte;
+    }
+
+private:
+    static std::uint8_t lock() {
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+        return sreg;
+#else
+        return 0;
+#endif
+    }
+    static void unlock(std::uint8_t sreg) {
+#if defined(__AVR__)
+        SREG = sreg;
+#else
+        (void)sreg;
+#endif
+    }
+};
+
+struct Reading {
+    std::uint8_t sensor;  // Index in the order of begin() or add()
+    bool valid;           // False: no presence pulse, or a CRC error
+    Celsius temperature;  // The last valid one if not valid; 85.0 is the power-up value of a sensor reset meanwhile
+
+    bool ok() const { return valid; }
+};
+
+// Sensors on the bus of `Bus` (a class with the static functions of PinBus)
+template <std::uint8_t Sensors, class Bus>
+class TemperatureActor {
+    static_assert(Sensors > 0, "At least one sensor");
+
+public:
+    static constexpr std::uint16_t CONVERSION_MS = 750;  // At 12 bits, the power-up resolution
+
+    ramen::Pusher<const Reading&> reading_out;
+
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    ramen::Pushable<const BaseEvent&> event_handler_in = [this](const BaseEvent& event) {
+        EventRouter<AppEvents, TemperatureActor, TickEvent>::dispatch(*this, event);
+    };
+
+    explicit TemperatureActor(std::uint32_t interval_ms = 1000) : interval_ms_(interval_ms) {
+        timeout_event_relay_out >> event_handler_in;
+    }
+    TemperatureActor(const TemperatureActor&) = delete;
+    TemperatureActor& operator=(const TemperatureActor&) = delete;
+
+    // Releases the bus and adds the DS18B20s found on it, up to Sensors; returns the number found. Blocking, about
+    // 15 ms a sensor: for setup() only
+    std::uint8_t begin() {
+        Bus::begin();
+        Rom rom{};
+        std::int8_t last_branch = -1;
+        std::uint8_t found = 0;
+        do {
+            if (!search(rom, last_branch)) {
+                break;
+            }
+            if (rom[0] == FAMILY_DS18B20 && add(rom)) {
+                ++found;
+            }
+        } while (last_branch >= 0);
+        return found;
+    }
+
+    // Adds a sensor by its ROM code; false if the list is full
+    bool add(const Rom& rom) {
+        if (count_ >= Sensors) {
+            return false;
+        }
+        roms_[count_++] = rom;
+        return true;
+    }
+
+    // Starts the first conversion; the next follow every interval_ms
+    void start() {
+        if (phase_ == Phase::STOPPED) {
+            begin_convert();
+        }
+    }
+
+    // One bus operation of the conversion or the readout, if one is due
+    void update() {
+        if (phase_ == Phase::CONVERT) {
+            convert_step();
+        } else if (phase_ == Phase::READ) {
+            read_step();
+        }
+    }
+
+    // Routed from event_handler_in: the conversion is done, or the interval has elapsed
+    void on_event(const TickEvent&) {
+        if (phase_ == Phase::CONVERTING) {
+            phase_ = Phase::READ;
+            sensor_ = 0;
+            step_ = 0;
+        } else if (phase_ == Phase::WAITING) {
+            begin_convert();
+        }
+    }
+
+    // Sensors read: those added, or the one read with Skip ROM
+    std::uint8_t size() const { return count_ > 0 ? count_ : 1; }
+    const Rom& rom(std::uint8_t i) const { return roms_[i < Sensors ? i : 0]; }
+    Celsius temperature(std::uint8_t i) const { return i < Sensors ? last_[i] : Celsius{}; }
+    bool valid(std::uint8_t i) const { return i < Sensors && valid_[i]; }
+    bool busy() const { return phase_ == Phase::CONVERT || phase_ == Phase::READ; }
+
+    // Counters, saturating at 65535
+    std::uint16_t conversions() const { return conversions_; }
+    std::uint16_t missing() const { return missing_; }        // Resets no device answered
+    std::uint16_t crc_errors() const { return crc_errors_; }
+
+private:
+    enum class Phase : std::uint8_t {
+        STOPPED,
+        CONVERT,     // Reset, Skip ROM, Convert T
+        CONVERTING,  // Waiting for the conversion timer
+        READ,        // Reading the scratchpad of sensor_
+        WAITING      // Waiting for the interval timer
+    };
+
+    // Steps of a readout: reset, Match ROM, the ROM code, Read Scratchpad, the scratchpad
+    static constexpr std::uint8_t ROM_FIRST = 2;
+    static constexpr std::uint8_t READ_COMMAND = ROM_FIRST + 8;
+    static constexpr std::uint8_t PAD_FIRST = READ_COMMAND + 1;
+
+    std::array<Rom, Sensors> roms_{};
+    std::array<Celsius, Sensors> last_{};
+    std::array<bool, Sensors> valid_{};
+    std::array<std::uint8_t, SCRATCHPAD_SIZE> pad_{};
+    const std::uint32_t interval_ms_;
+    std::uint32_t started_ = 0;  // Of the current cycle
+    TimerHandle timer_handle_;
+    Phase phase_ = Phase::STOPPED;
+    std::uint8_t count_ = 0;
+    std::uint8_t sensor_ = 0;
+    std::uint8_t step_ = 0;
+    std::uint16_t conversions_ = 0;
+    std::uint16_t missing_ = 0;
+    std::uint16_t crc_errors_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    void arm(std::uint32_t interval) {
+        ArmTimerEvt evt(interval > 0 ? interval : 1, &timeout_event_relay_out, false, &timer_handle_);
+        arm_timer_request_out(evt);
+    }
+
+    void begin_convert() {
+        phase_ = Phase::CONVERT;
+        step_ = 0;
+        started_ = scan_clock::now();
+    }
+
+    void convert_step() {
+        switch (step_++) {
+        case 0:
+            if (!Bus::reset()) {
+                count(missing_);
+                wait();
+            }
+            return;
+        case 1:
+            Bus::write_byte(SKIP_ROM);
+            return;
+        default:
+            Bus::write_byte(CONVERT_T);
+            count(conversions_);
+            phase_ = Phase::CONVERTING;
+            arm(CONVERSION_MS);
+            return;
+        }
+    }
+
+    void read_step() {
+        const std::uint8_t step = step_++;
+        if (step == 0) {
+            if (!Bus::reset()) {
+                count(missing_);
+                publish(false);
+            }
+        } else if (step == 1) {
+            Bus::write_byte(count_ > 0 ? MATCH_ROM : SKIP_ROM);
+            if (count_ == 0) {
+                step_ = READ_COMMAND;
+            }
+        } else if (step < READ_COMMAND) {
+            Bus::write_byte(roms_[sensor_][step - ROM_FIRST]);
+        } else if (step == READ_COMMAND) {
+            Bus::write_byte(READ_SCRATCHPAD);
+        } else {
+            pad_[step - PAD_FIRST] = Bus::read_byte();
+            if (step - PAD_FIRST + 1U == SCRATCHPAD_SIZE) {
+                const bool good = crc8(pad_.data(), SCRATCHPAD_SIZE) == 0;
+                if (!good) {
+                    count(crc_errors_);
+                }
+                publish(good);
+            }
+        }
+    }
+
+    // Ends the readout of sensor_ and moves to the next one, or ends the cycle
+    void publish(bool good) {
+        if (good) {
+            last_[sensor_] = Celsius::from_raw(static_cast<std::int16_t>(pad_[0] | (pad_[1] << 8)));
+        }
+        valid_[sensor_] = good;
+        const Reading reading{sensor_, good, last_[sensor_]};
+        step_ = 0;
+        if (++sensor_ >= size()) {
+            wait();
+        }
+        reading_out(reading);
+    }
+
+    void wait() {
+        phase_ = Phase::WAITING;
+        const std::uint32_t elapsed = scan_clock::now() - started_;
+        arm(elapsed < interval_ms_ ? interval_ms_ - elapsed : 1);
+    }
+
+    // One pass of Search ROM: the next ROM code in the order of the tree of codes; false once none is left
+    static bool search(Rom& rom, std::int8_t& last_branch) {
+        if (!Bus::reset()) {
+            return false;
+        }
+        Bus::write_byte(SEARCH_ROM);
+        std::int8_t branch = -1;  // The last bit where this pass took 0 while devices with 1 remain
+        for (std::uint8_t bit = 0; bit < 64; ++bit) {
+            const bool id = Bus::read_bit();
+            const bool complement = Bus::read_bit();
+            if (id && complement) {
+                return false;  // No device left on the search
+            }
+            std::uint8_t& byte = rom[bit >> 3];
+            const std::uint8_t mask = static_cast<std::uint8_t>(1U << (bit & 7U));
+            bool direction = id;
+            if (id == complement) {  // Devices with either bit: take the other branch than last time at last_branch
+                const std::int8_t at = static_cast<std::int8_t>(bit);
+                direction = (at < last_branch) ? (byte & mask) != 0 : at == last_branch;
+                if (!direction) {
+                    branch = static_cast<std::int8_t>(bit);
+                }
+            }
+            byte = direction ? static_cast<std::uint8_t>(byte | mask) : static_cast<std::uint8_t>(byte & ~mask);
+            Bus::write_bit(direction);
+        }
+        last_branch = branch;
+        return crc8(rom.data(), 8) == 0;
+    }
+};
+
+template <std::uint8_t Sensors, std::uint8_t Pin>
+using Ds18b20Actor = TemperatureActor<Sensors, PinBus<Pin>>;
+
+} // namespace onewire
@@ -0,0 +1,191 @@
+#pragma once
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
+
+// Pulses counted by the hardware: flow and energy meters at several kHz, where an interrupt per edge would take a
+// good part of the CPU. Timer5 runs on the external clock of its T5 pin (PL2, Arduino pin 47), so every edge on the
+// pin advances TCNT5 without any code running, and update() samples the count once per scan:
+//
+//     pulse_counter::PulseCounterActor flow(1000);  // Rate over 1 s gates
+//
+//     void setup() {
+//         flow.total_out >> totalizer.in;
+//         flow.rate_out >> display.rate_in;          // Pulses per second, once per gate
+//         flow.begin();
+//     }
+//     void loop() { flow.update(); ... }
+//
+// The pulses since the last sample are the difference of two 16-bit counts, taken with interrupts held off so that
+// an interrupt reading another 16-bit register cannot come between the two bytes (they share the TEMP register).
+// The difference is exact across a wrap of TCNT5; a sample that finds the overflow flag set with a count at or past
+// the one before has missed 65536 pulses, which are added and counted in overruns(). The scans have to sample at
+// least once per 65536 pulses for the total to be exact: every 6.5 s at 10 kHz.
+//
+// The total is 32 bits and published on total_out after each sample that saw pulses; the rate, in pulses per second
+// over the gate time measured by the scan clock, on rate_out at the end of each gate. The configured edge (CS5 = 111
+// rising, 110 falling) is the one counted.
+//
+// Timer5 is taken from the cycle counter, so the build needs -D CYCLE_COUNTER_DISABLE as well, which leaves out
+// STEP_WATCHDOG and the profilers that time with the counter. Timer0, whose T0 input is the other one the
+// boards bring out, keeps millis(). Opt-in with -D PULSE_COUNTER; without it, and off AVR, begin() leaves the timers
+// alone. Off AVR the count is detail::host_count, advanced by detail::pulse().
+
+namespace pulse_counter {
+
+#if defined(PULSE_COUNTER)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+#if defined(__AVR__) && defined(PULSE_COUNTER) && !defined(CYCLE_COUNTER_DISABLE)
+#error "PULSE_COUNTER counts on Timer5, which the cycle counter keeps unless CYCLE_COUNTER_DISABLE is defined"
+#endif
+
+constexpr std::uint8_t PIN = 47;  // T5, PL2
+
+enum class Edge : std::uint8_t { RISING_EDGE, FALLING_EDGE };  // RISING and FALLING are Arduino macros
+
+namespace detail {
+
+struct Sample {
+    std::uint16_t count;
+    bool overflowed;  // Since the sample before
+};
+
+#if !defined(__AVR__)
+// Off the board: TCNT5 and TOV5
+inline std::uint16_t host_count = 0;
+inline bool host_overflow = false;
+
+inline void pulse(std::uint32_t pulses) {
+    const std::uint32_t sum = host_count + pulses;
+    host_overflow = host_overflow || sum > UINT16_MAX;
+    host_count = static_cast<std::uint16_t>(sum);
+}
+#endif
+
+inline void start(Edge edge) {
+#if defined(__AVR__) && defined(PULSE_COUNTER)
+    const std::uint8_t sreg = SREG;
+    cli();
+    TIMSK5 = 0;
+    TCCR5A = 0;
+    TCCR5B = 0;
+    TCNT5 = 0;
+    TIFR5 = _BV(TOV5);
+    TCCR5B = static_cast<std::uint8_t>(_BV(CS52) | _BV(CS51) | ((edge == Edge::RISING_EDGE) ? _BV(CS50) : 0));
+    SREG = sreg;
+#elif !defined(__AVR__)
+    (void)edge;
+    host_count = 0;
+    host_overflow = false;
+#else
+    (void)edge;
+#endif
+}
+
+// The count and the overflow flag together, the flag cleared
+inline Sample sample() {
+#if defined(__AVR__) && defined(PULSE_COUNTER)
+    const std::uint8_t sreg = SREG;
+    cli();
+    const std::uint16_t count = TCNT5;
+    const bool overflowed = (TIFR5 & _BV(TOV5)) != 0;
+    if (overflowed) {
+        TIFR5 = _BV(TOV5);
+    }
+    SREG = sreg;
+    return {count, overflowed};
+#elif !defined(__AVR__)
+    const Sample s{host_count, host_overflow};
+    host_overflow = false;
+    return s;
+#else
+    return {0, false};
+#endif
+}
+
+} // namespace detail
+
+// One per firmware, as it owns Timer5
+class PulseCounterActor {
+public:
+    explicit PulseCounterActor(std::uint16_t gate_ms = 1000, Edge edge = Edge::RISING_EDGE) :
+        gate_ms_((gate_ms == 0) ? 1 : gate_ms),
+        edge_(edge)
+    {
+    }
+    PulseCounterActor(const PulseCounterActor&) = delete;
+    PulseCounterActor& operator=(const PulseCounterActor&) = delete;
+
+    // Output: the total after each sample that saw pulses
+    ramen::Pusher<std::uint32_t> total_out;
+
+    // Output: pulses per second over the last gate, at its end
+    ramen::Pusher<std::uint32_t> rate_out;
+
+    // Takes Timer5 over and counts from zero
+    void begin() {
+        if (!ENABLED) {
+            return;
+        }
+        pinMode(PIN, INPUT);
+        detail::start(edge_);
+        last_ = 0;
+        gate_start_ = scan_clock::now();
+        gate_pulses_ = 0;
+        started_ = true;
+    }
+
+    // Once per scan
+    void update() {
+        if (!started_) {
+            return;
+        }
+        const detail::Sample s = detail::sample();
+        std::uint32_t pulses = static_cast<std::uint16_t>(s.count - last_);
+        if (s.overflowed && s.count >= last_) {
+            pulses += 0x10000UL;
+            if (overruns_ != UINT16_MAX) {
+                ++overruns_;
+            }
+        }
+        last_ = s.count;
+        if (pulses != 0) {
+            total_ += pulses;
+            gate_pulses_ += pulses;
+            total_out(total_);
+        }
+        const std::uint32_t elapsed = scan_clock::now() - gate_start_;
+        if (elapsed >= gate_ms_) {
+            rate_ = static_cast<std::uint32_t>(static_cast<std::uint64_t>(gate_pulses_) * 1000U / elapsed);
+            gate_start_ += elapsed;
+            gate_pulses_ = 0;
+            rate_out(rate_);
+        }
+    }
+
+    std::uint32_t total() const { return total_; }
+    std::uint32_t rate() const { return rate_; }          // Pulses per second over the last gate
+    std::uint16_t overruns() const { return overruns_; }  // Samples that found a missed wrap, saturating at 65535
+    void reset_total() { total_ = 0; }
+
+private:
+    const std::uint16_t gate_ms_;
+    const Edge edge_;
+    bool started_ = false;
+    std::uint16_t last_ = 0;  // TCNT5 at the last sample
+    std::uint32_t total_ = 0;
+    std::uint32_t rate_ = 0;
+    scan_clock::Timestamp gate_start_ = 0;
+    std::uint32_t gate_pulses_ = 0;
+    std::uint16_t overruns_ = 0;
+};
+
+} // namespace pulse_counter
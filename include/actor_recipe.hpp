@@ -0,0 +1,312 @@
+#pragma once
+#include "binary_frame.hpp"
+#include "eeprom_access.hpp"
+#include "output_registry.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Recipes: whole parameter sets that take effect together, between two scans, instead of parameter by parameter as
+// single commands arrive, so the machine never runs on half of an old recipe and half of a new one.
+//
+// RecipeActor keeps two copies of Params. Consumers read the active one through active(); changes go into the other,
+// the staged one, which starts as a copy of the active set, so a host sends only the bytes that differ. A switch
+// requested with switch_over() (or by a host) happens in the next update(), called at the start of the scan: a
+// one-byte index flips, whatever the size of the set, and switched_out then hands the new set to the consumers that
+// keep copies of their own. The byte store is atomic, so interrupts may read active() as well (as with DoubleLatch in
+// ramen_latch.hpp):
+//
+//     recipe::RecipeActor<recipe::OutputRecipe<3>> recipes;
+//     recipe::OutputRecipeActor<3> recipe_outputs(outputs);
+//
+//     void setup() {
+//         recipes.switched_out >> recipe_outputs.recipe_in;
+//         recipes.begin(recipe::capture<3>(outputs));       // The recipe in force until another is loaded
+//     }
+//     void loop() { recipes.update(); ... }                  // First in the pass
+//
+// Sets are staged from code (stage()), by chunks over the binary protocol (RECIPE_WRITE, see
+// actor_serial_commander.hpp) or from one of RECIPE_SLOTS slots in EEPROM, each holding a set and its CRC-16. load()
+// reads a slot into the staged set and switches to it if the CRC holds; save() writes the active set to a slot a byte
+// per pass whenever the EEPROM is ready, as the configuration store does (see actor_config_store.hpp), and a switch
+// waits until the save is done.
+//
+// The slots are in the EEPROM region before the event log (see eeprom_access.hpp). Opt-in with -D RECIPES; without it
+// begin() keeps the initial set, nothing can be staged and the binary requests are answered UNKNOWN_TYPE.
+
+#ifndef RECIPE_SLOTS
+#define RECIPE_SLOTS 4
+#endif
+
+namespace recipe {
+
+#if defined(RECIPES)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t SLOTS = RECIPE_SLOTS;
+constexpr std::uint8_t CHUNK_SIZE = 32;  // Most bytes of one RECIPE_WRITE
+
+// A request of the binary protocol, answered through `status`
+struct RequestEvent {
+    enum Action : std::uint8_t { WRITE, SWITCH, LOAD, SAVE, DISCARD };
+    enum Status : std::uint8_t { OK, BUSY, BAD_OFFSET, BAD_SLOT, BAD_ACTION, BAD_RECIPE, UNHANDLED };
+    Action action;
+    std::uint16_t offset;      // WRITE: of the data in the staged set
+    const std::uint8_t* data;  // WRITE: CHUNK_SIZE bytes at most
+    std::uint8_t length;
+    std::uint8_t slot;         // LOAD, SAVE
+    Status* status;            // Of the endpoint, UNHANDLED until a recipe actor sets it
+};
+
+template <class Params>
+class RecipeActor {
+    static_assert(std::is_trivially_copyable_v<Params>, "Recipes are copied and stored byte for byte");
+
+public:
+    static constexpr std::size_t SIZE = sizeof(Params);
+    static constexpr std::size_t RECORD_SIZE = SIZE + binary_frame::CRC_SIZE;
+
+    static_assert(SLOTS > 0 && SLOTS * RECORD_SIZE <= eeprom_access::EVENT_LOG_REGION - eeprom_access::RECIPE_REGION,
+                  "RECIPE_SLOTS recipes do not fit the recipes' region of the EEPROM");
+    static_assert(SIZE <= 0xFFFF, "Offsets of RECIPE_WRITE are 16-bit");
+
+    RecipeActor() = default;
+    RecipeActor(const RecipeActor&) = delete;
+    RecipeActor& operator=(const RecipeActor&) = delete;
+
+    // Input: RECIPE requests of the binary protocol
+    ramen::Pushable<const RequestEvent&> request_in = [this](const RequestEvent& evt) { *evt.status = request(evt); };
+
+    // Output: the active set after each switch
+    ramen::Pusher<const Params&> switched_out;
+
+    // `initial` is the active set until a switch
+    void begin(const Params& initial) {
+        sets_[active_] = initial;
+        started_ = ENABLED;
+    }
+
+    // The set in force; stays put until the next update() that switches
+    const Params& active() const {
+        const std::uint8_t index = active_;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        return sets_[index];
+    }
+
+    // The staged set, to be changed in place; a copy of the active one at the first call after a switch or discard().
+    // nullptr while a switch is pending, or without RECIPES.
+    Params* stage() {
+        if (!started_ || switch_pending_) {
+            return nullptr;
+        }
+        if (!staging_) {
+            sets_[active_ ^ 1U] = sets_[active_];
+            staging_ = true;
+        }
+        return &sets_[active_ ^ 1U];
+    }
+
+    // Drops the changes staged since the last switch
+    void discard() {
+        if (!switch_pending_) {
+            staging_ = false;
+        }
+    }
+
+    // The staged set becomes the active one at the next update(); false if nothing is staged
+    bool switch_over() {
+        if (!started_ || !staging_) {
+            return false;
+        }
+        switch_pending_ = true;
+        return true;
+    }
+
+    // Stages the set of `slot` and switches to it; false if the slot holds none whose CRC holds
+    bool load(std::uint8_t slot) {
+        if (slot >= SLOTS || stage() == nullptr) {
+            return false;
+        }
+        std::uint8_t* staged = bytes(active_ ^ 1U);
+        std::uint8_t crc[binary_frame::CRC_SIZE];
+        eeprom_access::read_block(staged, slot_address(slot), SIZE);
+        eeprom_access::read_block(crc, static_cast<std::uint16_t>(slot_address(slot) + SIZE), sizeof(crc));
+        if (binary_frame::crc16(staged, SIZE) != binary_frame::read_le16(crc)) {
+            staging_ = false;  // The next stage() starts from the active set again
+            return false;
+        }
+        switch_pending_ = true;
+        return true;
+    }
+
+    // Starts writing the active set to `slot`; false while another save is running
+    bool save(std::uint8_t slot) {
+        if (!started_ || slot >= SLOTS || saving()) {
+            return false;
+        }
+        binary_frame::write_le16(crc_, binary_frame::crc16(bytes(active_), SIZE));
+        save_slot_ = slot;
+        save_pos_ = 0;
+        write_step();
+        return true;
+    }
+
+    // At the start of each scan: writes a pending save on, then switches to a staged set once no save is running
+    void update() {
+        if (saving()) {
+            write_step();
+        }
+        if (switch_pending_ && !saving()) {
+            std::atomic_signal_fence(std::memory_order_release);  // The set must be complete before it is published
+            active_ = static_cast<std::uint8_t>(active_ ^ 1U);
+            switch_pending_ = false;
+            staging_ = false;
+            generation_ = static_cast<std::uint16_t>(generation_ + 1U);
+            switched_out(sets_[active_]);
+        }
+    }
+
+    bool pending() const { return switch_pending_; }
+    bool saving() const { return save_pos_ < RECORD_SIZE; }
+    std::uint16_t generation() const { return generation_; }  // Switches since boot, wrapping
+
+private:
+    Params sets_[2] = {};
+    volatile std::uint8_t active_ = 0;
+    bool staging_ = false;         // The staged set holds changes, or at least the copy of the active one
+    bool switch_pending_ = false;  // The staged set is frozen until update() makes it the active one
+    bool started_ = false;
+    std::uint16_t generation_ = 0;
+    std::uint8_t crc_[binary_frame::CRC_SIZE] = {};
+    std::uint8_t save_slot_ = 0;
+    std::uint16_t save_pos_ = RECORD_SIZE;  // Next byte of the record to write; RECORD_SIZE when idle
+
+    static std::uint16_t slot_address(std::uint8_t slot) {
+        return static_cast<std::uint16_t>(eeprom_access::RECIPE_REGION + slot * RECORD_SIZE);
+    }
+
+    std::uint8_t* bytes(std::uint8_t index) { return reinterpret_cast<std::uint8_t*>(&sets_[index]); }
+
+    // Writes bytes until one has to be programmed, which takes the EEPROM until a later pass
+    void write_step() {
+        while (save_pos_ < RECORD_SIZE && eeprom_access::ready()) {
+            const std::uint8_t value = (save_pos_ < SIZE) ? bytes(active_)[save_pos_] : crc_[save_pos_ - SIZE];
+            const std::uint16_t address = static_cast<std::uint16_t>(slot_address(save_slot_) + save_pos_);
+            ++save_pos_;
+            if (eeprom_access::update_byte(address, value)) {
+                return;
+            }
+        }
+    }
+
+    RequestEvent::Status request(const RequestEvent& evt) {
+        if (!started_) {
+            return RequestEvent::UNHANDLED;
+        }
+        switch (evt.action) {
+            case RequestEvent::WRITE: {
+                if (evt.offset > SIZE || evt.length > SIZE - evt.offset) {
+                    return RequestEvent::BAD_OFFSET;
+                }
+                Params* staged = stage();
+                if (staged == nullptr) {
+                    return RequestEvent::BUSY;
+                }
+                std::memcpy(reinterpret_cast<std::uint8_t*>(staged) + evt.offset, evt.data, evt.length);
+                return RequestEvent::OK;
+            }
+            case RequestEvent::SWITCH:
+                if (switch_pending_) {
+                    return RequestEvent::BUSY;
+                }
+                return switch_over() ? RequestEvent::OK : RequestEvent::BAD_RECIPE;
+            case RequestEvent::LOAD:
+                if (evt.slot >= SLOTS) {
+                    return RequestEvent::BAD_SLOT;
+                }
+                if (switch_pending_) {
+                    return RequestEvent::BUSY;
+                }
+                return load(evt.slot) ? RequestEvent::OK : RequestEvent::BAD_RECIPE;
+            case RequestEvent::SAVE:
+                if (evt.slot >= SLOTS) {
+                    return RequestEvent::BAD_SLOT;
+                }
+                return save(evt.slot) ? RequestEvent::OK : RequestEvent::BUSY;
+            case RequestEvent::DISCARD:
+                if (switch_pending_) {
+                    return RequestEvent::BUSY;
+                }
+                discard();
+                return RequestEvent::OK;
+            default:
+                return RequestEvent::BAD_ACTION;
+        }
+    }
+};
+
+// The recipe of the blinking outputs: interval and run state of each, laid out as the host stages it
+template <std::uint8_t N>
+struct OutputRecipe {
+    std::uint32_t interval_ms[N];        // Little-endian on the AVR, as the binary protocol's fields
+    std::uint8_t running[(N + 7U) / 8U];  // Bit i % 8 of byte i / 8: output i blinks
+};
+
+// The outputs' settings as they are, e.g. as the initial recipe
+template <std::uint8_t N>
+OutputRecipe<N> capture(const led::OutputTable& outputs) {
+    OutputRecipe<N> r{};
+    for (std::uint8_t i = 0; i < N && outputs.contains(i); ++i) {
+        const led::OutputRef output = outputs.at(i);
+        r.interval_ms[i] = output.blink_interval_ms();
+        if (output.state_id() != led::STATE_STOPPED) {
+            r.running[i / 8U] |= static_cast<std::uint8_t>(1U << (i % 8U));
+        }
+    }
+    return r;
+}
+
+// Applies each switched recipe to the outputs, all in the update() that switched, before any timer or command runs
+template <std::uint8_t N>
+class OutputRecipeActor {
+public:
+    static constexpr std::uint32_t MIN_INTERVAL_MS = 1;
+    static constexpr std::uint32_t MAX_INTERVAL_MS = 60000;
+
+    explicit OutputRecipeActor(const led::OutputTable& output_table) : outputs(output_table) {}
+    OutputRecipeActor(const OutputRecipeActor&) = delete;
+    OutputRecipeActor& operator=(const OutputRecipeActor&) = delete;
+
+    // Input: the recipe now active; intervals out of range leave an output's interval as it is
+    ramen::Pushable<const OutputRecipe<N>&> recipe_in = [this](const OutputRecipe<N>& r) { apply(r); };
+
+private:
+    const led::OutputTable& outputs;
+
+    void apply(const OutputRecipe<N>& r) {
+        for (std::uint8_t i = 0; i < N && outputs.contains(i); ++i) {
+            const led::OutputRef output = outputs.at(i);
+            const std::uint32_t interval = r.interval_ms[i];
+            if (interval >= MIN_INTERVAL_MS && interval <= MAX_INTERVAL_MS && interval != output.blink_interval_ms()) {
+                output.set_blink_interval(interval);
+            }
+            const bool running = (r.running[i / 8U] & (1U << (i % 8U))) != 0;
+            if (running != (output.state_id() != led::STATE_STOPPED)) {
+                if (running) {
+                    output.start();
+                } else {
+                    output.stop();
+                }
+            }
+        }
+    }
+};
+
+} // namespace recipe
@@ -0,0 +1,156 @@
+#pragma once
+#include "event.hpp"
+#include "process_image.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// Relay outputs that respect the mechanics of the contacts. Every relay has a minimum on and a minimum off time: a
+// relay that switched stays in its new position for at least that long. Commands arriving in the meantime are not
+// queued, only the last one counts, so a command that flips back before the dwell time ends costs no switching at all.
+// The waiting relays of a bank share one TimerActor slot, armed for whichever dwell time ends first.
+//
+// Relays are driven through a process image, so relays switched in the same scan change with one write per port at
+// the next commit_outputs():
+//
+//     relay::RelayBank<2> relays(image, {{{CONTROLLINO_R0, 200, 500}, {CONTROLLINO_R1, 1000, 1000}}});
+//     relays.arm_timer_request_out >> timer.arm_timer_request_in;
+//     relays.disarm_timer_request_out >> timer.disarm_timer_request_in;
+//     relays.set(0, true);
+
+namespace relay {
+
+struct RelaySpec {
+    std::uint8_t pin;
+    std::uint16_t min_on_ms;
+    std::uint16_t min_off_ms;
+};
+
+struct RelayCommand {
+    std::uint8_t index;
+    bool on;
+};
+
+// A relay that has switched, published when it is written to the image
+struct RelaySwitched {
+    std::uint8_t pin;
+    bool on;
+};
+
+template <std::uint8_t Relays>
+class RelayBank {
+    static_assert(Relays > 0, "A relay bank needs relays");
+
+public:
+    ramen::Pushable<RelayCommand> command_in = [this](const RelayCommand& cmd) { set(cmd.index, cmd.on); };
+    ramen::Pusher<RelaySwitched> switched_out;
+
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    ramen::Pushable<const BaseEvent&> event_handler_in = [this](const BaseEvent& event) {
+        EventRouter<AppEvents, RelayBank, TickEvent>::dispatch(*this, event);
+    };
+
+    // All relays start off, free to switch at once
+    RelayBank(process_image::ProcessImage& output_image, const std::array<RelaySpec, Relays>& specs) :
+        image_(output_image), specs_(specs) {
+        for (const RelaySpec& spec : specs_) {
+            image_.add_output(spec.pin, false);
+        }
+        timeout_event_relay_out >> event_handler_in;
+    }
+
+    // Requests a relay position; it is taken at once if the relay has dwelled long enough, otherwise when it has
+    void set(std::uint8_t index, bool on) {
+        if (index >= Relays) {
+            return;
+        }
+        Relay& r = relays_[index];
+        r.requested = on;
+        if (r.on != on && r.settled) {
+            switch_relay(index, static_cast<std::uint32_t>(millis()));
+            schedule();
+        }
+    }
+
+    // Routed from event_handler_in: the earliest dwell time has ended
+    void on_event(const TickEvent&) {
+        timer_handle_ = TimerHandle{};  // One-shot, expired
+        const std::uint32_t now = static_cast<std::uint32_t>(millis());
+        for (std::uint8_t i = 0; i < Relays; ++i) {
+            Relay& r = relays_[i];
+            if (!r.settled && now - r.switched_ms >= dwell_ms(i)) {
+                r.settled = true;
+                if (r.requested != r.on) {
+                    switch_relay(i, now);
+                }
+            }
+        }
+        schedule();
+    }
+
+    bool on(std::uint8_t index) const { return index < Relays && relays_[index].on; }
+    bool requested(std::uint8_t index) const { return index < Relays && relays_[index].requested; }
+
+    // A switch is held back until the relay's dwell time ends
+    bool pending(std::uint8_t index) const {
+        return index < Relays && relays_[index].requested != relays_[index].on;
+    }
+
+private:
+    struct Relay {
+        std::uint32_t switched_ms = 0;
+        bool on = false;
+        bool requested = false;
+        bool settled = true;  // Dwell time since the last switch has ended
+    };
+
+    process_image::ProcessImage& image_;
+    const std::array<RelaySpec, Relays> specs_;
+    std::array<Relay, Relays> relays_{};
+    TimerHandle timer_handle_;
+
+    std::uint16_t dwell_ms(std::uint8_t index) const {
+        return relays_[index].on ? specs_[index].min_on_ms : specs_[index].min_off_ms;
+    }
+
+    void switch_relay(std::uint8_t index, std::uint32_t now) {
+        Relay& r = relays_[index];
+        r.on = r.requested;
+        r.switched_ms = now;
+        r.settled = dwell_ms(index) == 0;
+        image_.write(specs_[index].pin, r.on);
+        const RelaySwitched evt{specs_[index].pin, r.on};
+        switched_out(evt);
+    }
+
+    // Arms the bank's timer for the end of the earliest dwell time still running, or disarms it
+    void schedule() {
+        const std::uint32_t now = static_cast<std::uint32_t>(millis());
+        bool waiting = false;
+        std::uint32_t earliest = 0;
+        for (std::uint8_t i = 0; i < Relays; ++i) {
+            if (relays_[i].settled) {
+                continue;
+            }
+            const std::uint32_t elapsed = now - relays_[i].switched_ms;
+            const std::uint32_t remaining = (elapsed < dwell_ms(i)) ? dwell_ms(i) - elapsed : 1;  // 0 is no interval
+            if (!waiting || remaining < earliest) {
+                earliest = remaining;
+                waiting = true;
+            }
+        }
+        if (waiting) {
+            ArmTimerEvt evt(earliest, &timeout_event_relay_out, false, &timer_handle_);
+            arm_timer_request_out(evt);
+        } else if (timer_handle_.valid()) {
+            DisarmTimerEvt evt(timer_handle_);
+            disarm_timer_request_out(evt);
+            timer_handle_ = TimerHandle{};
+        }
+    }
+};
+
+} // namespace relay
@@ -0,0 +1,211 @@
+#pragma once
+#include "event.hpp"
+#include "actor_fsm.hpp"
+#include "fsm_queue.hpp"
+#include "sml.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// Timed output sequences ("on 100, off 100, on 100, off 700", stack-light patterns) played from step tables in flash.
+//
+// A pattern is a list of steps; each step sets up to 8 outputs at once (bit i drives output i) and holds them for a
+// number of ticks. The sequencer arms one periodic timer with the pattern's tick period when it starts playing and
+// counts steps down locally, so a pattern occupies a single TimerActor slot however many steps it has:
+//
+//     const seq::Step DOUBLE_FLASH[] PROGMEM = {{0b01, 1}, {0b00, 1}, {0b01, 1}, {0b00, 7}};
+//     constexpr seq::Pattern double_flash{DOUBLE_FLASH, 4, 100, true};  // 100 ms ticks, repeating
+//
+//     seq::SequencerActor<2> beacon({CONTROLLINO_D3, CONTROLLINO_D4});
+//     void setup() {
+//         beacon.init();
+//         beacon.arm_timer_request_out >> timer.arm_timer_request_in;
+//         beacon.disarm_timer_request_out >> timer.disarm_timer_request_in;
+//         beacon.play(double_flash);
+//     }
+
+namespace seq {
+
+struct Step {
+    std::uint8_t outputs;  // Output levels, bit i for output i
+    std::uint8_t ticks;    // Duration in pattern ticks; 0 is treated as 1
+};
+
+struct Pattern {
+    const Step* steps;  // In PROGMEM
+    std::uint8_t count;
+    std::uint16_t tick_ms;  // Tick period; 0 is treated as 1
+    bool repeat;
+};
+
+// FSM Events
+struct play_pattern {
+    const Pattern* pattern;
+};
+struct stop_pattern {};
+struct sequence_tick {};
+struct pattern_finished {};  // Posted by the playing sub-machine after the last step of a one-shot pattern
+
+// States
+struct idle {};
+struct holding {};
+
+// State shared between a sequencer actor and its state machines, injected by reference like blinky_led_context
+template <std::uint8_t Outputs>
+struct sequencer_context {
+    static_assert((Outputs > 0) && (Outputs <= 8), "A sequencer drives 1 to 8 outputs");
+
+    const std::array<std::uint8_t, Outputs> pins;
+    const Pattern* pattern = nullptr;
+    std::uint8_t step = 0;
+    std::uint8_t remaining_ticks = 0;
+
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    TimerHandle timer_handle;
+
+    // Leaves the pins alone: the actors are globals, constructed before the Arduino core is initialized
+    constexpr explicit sequencer_context(const std::array<std::uint8_t, Outputs>& output_pins) : pins(output_pins) {}
+
+    // Makes the pins outputs, off; call from setup() before the first pattern plays
+    void init() {
+        for (std::uint8_t pin : pins) {
+            digitalWrite(pin, LOW);
+            pinMode(pin, OUTPUT);
+        }
+    }
+
+    void begin(const Pattern* p) {
+        pattern = p;
+        step = 0;
+        enter_step();
+        // Restarting a pattern re-arms the same timer slot; without a timer it would play forever
+        ArmTimerEvt evt((pattern->tick_ms > 0) ? pattern->tick_ms : 1U, &timeout_event_relay_out, true, &timer_handle);
+        arm_timer_request_out(evt);
+    }
+
+    void end() {
+        disarm_timer();
+        write_outputs(0);
+        pattern = nullptr;
+    }
+
+    bool step_elapsed() const { return remaining_ticks <= 1; }
+    bool at_last_step() const { return static_cast<std::uint8_t>(step + 1U) >= pattern->count; }
+    void count_down() { --remaining_ticks; }
+
+    void next_step() {
+        step = at_last_step() ? 0 : static_cast<std::uint8_t>(step + 1U);
+        enter_step();
+    }
+
+private:
+    void enter_step() {
+        std::uint8_t outputs = 0;
+        remaining_ticks = 1;
+        if (step < pattern->count) {
+            outputs = pgm_read_byte(&pattern->steps[step].outputs);
+            const std::uint8_t ticks = pgm_read_byte(&pattern->steps[step].ticks);
+            remaining_ticks = (ticks > 0) ? ticks : 1;
+        }
+        write_outputs(outputs);
+    }
+
+    void write_outputs(std::uint8_t outputs) {
+        for (std::uint8_t i = 0; i < Outputs; ++i) {
+            digitalWrite(pins[i], ((outputs >> i) & 1U) ? HIGH : LOW);
+        }
+    }
+
+    void disarm_timer() {
+        if (timer_handle.valid()) {
+            DisarmTimerEvt evt(timer_handle);
+            disarm_timer_request_out(evt);
+            timer_handle = TimerHandle{};
+        }
+    }
+};
+
+// Sub-machine active while a pattern plays: counts the ticks of the current step and moves to the next one
+template <class Context>
+struct playing_fsm {
+    auto operator()() const {
+        using namespace boost::sml;
+
+        auto step_pending = [](Context& ctx) FSM_ACTION { return !ctx.step_elapsed(); };
+        auto pattern_continues = [](Context& ctx) FSM_ACTION { return !ctx.at_last_step() || ctx.pattern->repeat; };
+        auto count_down_action = [](Context& ctx) FSM_ACTION { ctx.count_down(); };
+        auto next_step_action = [](Context& ctx) FSM_ACTION { ctx.next_step(); };
+
+        return make_transition_table(
+            *state<holding> + event<sequence_tick> [step_pending]      / count_down_action          = state<holding>,
+             state<holding> + event<sequence_tick> [pattern_continues] / next_step_action           = state<holding>,
+             state<holding> + event<sequence_tick>                     / process(pattern_finished{}) = state<holding>
+        );
+    }
+};
+
+template <class Context>
+struct sequencer_fsm {
+    auto operator()() const {
+        using namespace boost::sml;
+        using playing = playing_fsm<Context>;
+
+        auto begin_action = [](Context& ctx, const play_pattern& evt) FSM_ACTION { ctx.begin(evt.pattern); };
+        auto end_action = [](Context& ctx) FSM_ACTION { ctx.end(); };
+
+        // Entering playing (again) restarts the sub-machine at its initial state
+        return make_transition_table(
+            *state<idle>    + event<play_pattern>     / begin_action = state<playing>,
+             state<playing> + event<play_pattern>     / begin_action = state<playing>,
+             state<playing> + event<stop_pattern>     / end_action   = state<idle>,
+             state<playing> + event<pattern_finished> / end_action   = state<idle>
+        );
+    }
+};
+
+template <std::uint8_t Outputs, class Dispatch = fsm::default_dispatch>
+struct SequencerActor : sequencer_context<Outputs> {
+    using context_type = sequencer_context<Outputs>;
+    using fsm_type = sequencer_fsm<context_type>;
+
+    ramen::Pushable<const BaseEvent&> event_handler_in;
+
+    sml_trace::Logger trace_logger;  // Records transitions tagged with the first output pin (-D SML_TRACE)
+    fsm::traced_sm<fsm_type, Dispatch, boost::sml::process_queue<fsm::static_queue<1>::type>> sm;
+
+    explicit SequencerActor(const std::array<std::uint8_t, Outputs>& output_pins) :
+        context_type(output_pins),
+        event_handler_in([this](const BaseEvent& event) {
+            EventRouter<AppEvents, SequencerActor, TickEvent>::dispatch(*this, event);
+        }),
+        trace_logger(output_pins[0]),
+        sm(trace_logger, static_cast<context_type&>(*this))
+    {
+        this->timeout_event_relay_out >> event_handler_in;
+    }
+
+    // Routed from event_handler_in
+    void on_event(const TickEvent&) {
+        sm.process_event(sequence_tick{});
+    }
+
+    // Starts (or restarts) a pattern; the pattern must outlive its playback
+    void play(const Pattern& pattern) {
+        if (pattern.count > 0) {
+            sm.process_event(play_pattern{&pattern});
+        }
+    }
+
+    void stop() {
+        sm.process_event(stop_pattern{});
+    }
+
+    bool playing() const {
+        return !sm.is(boost::sml::state<idle>);
+    }
+};
+
+} // namespace seq
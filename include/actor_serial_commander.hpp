@@ -1,11 +1,43 @@
 #pragma once
+#include "actor_alarm_manager.hpp"
+#include "actor_event_log.hpp"
+#include "actor_fsm.hpp"
+#include "actor_recipe.hpp"
 #include "actor_led.hpp"
+#include "actor_timer.hpp"
+#include "actor_watch.hpp"
+#include "binary_frame.hpp"
+#include "boot_profile.hpp"
+#include "event.hpp"
+#include "command_table.hpp"
+#include "fixed_string.hpp"
+#include "fmt.hpp"
+#include "message_log.hpp"
+#include "output_registry.hpp"
 #include "ramen.hpp"
+#include "serial_port.hpp"
+#include "sml.hpp"
+#include "stack_monitor.hpp"
+#include "static_vector.hpp"
+#include "step_watchdog.hpp"
+#include "port_profiler.hpp"
+#include "port_trace.hpp"
+#include "scan_monitor.hpp"
+#include "fsm_benchmark.hpp"
+#include "hash_benchmark.hpp"
+#include "heap_monitor.hpp"
+#include "input_record.hpp"
+#include "logic_vm.hpp"
+#include "sml_trace.hpp"
+#include "timer_latency.hpp"
+#include "xmem.hpp"
 #include <Controllino.h>
+#include <array>
+#include <charconv>
 #include <cstdint>
 #include <cstring>
 #include <cctype>
-#include <cstdio>
+#include <type_traits>
 
 namespace serial_cmd {
 
@@ -13,333 +45,2876 @@ struct SerialCharEvent {
     std::uint8_t character;
 };
 
+constexpr std::size_t MAX_LINE_LENGTH = 64;  // Including the terminator
+constexpr std::size_t COMMAND_NAME_SIZE = 10;  // Longest command name, with terminator
+
+// View of a NUL-terminated command line in a buffer of the actor publishing it, valid until the dispatch returns
 struct CommandLineEvent {
-    std::uint8_t command_line[64];
+    const std::uint8_t* command_line;
     std::size_t length;
 };
 
-struct LedCommandEvent {
-    std::uint8_t led_id;      // 0=led1, 1=led2, 2=led3
-    enum Type { START, STOP, SET_INTERVAL } type;
-    std::uint32_t interval_ms = 0;  // Only used for SET_INTERVAL
+struct LedCommandEvent {
+    static constexpr std::uint8_t ALL = 0;  // `count` of a command for every output from `led_id` on
+
+    std::uint8_t led_id;      // Index into the output registry: 0 for id 1
+    enum Type { START, STOP, SET_INTERVAL } type;
+    std::uint32_t interval_ms = 0;  // Only used for SET_INTERVAL
+    std::uint8_t count = 1;   // Consecutive outputs from led_id on, or ALL
+};
+
+// The LED commands of one command line, applied by the executor in one dispatch; valid until the dispatch returns
+struct LedBatchEvent {
+    ramen::Span<const LedCommandEvent> commands;
+};
+
+// A 'script' command: the LED commands after it on its line become the boot script (see actor_boot_script.hpp)
+struct BootScriptEvent {
+    enum Action : std::uint8_t { SHOW, SAVE, CLEAR } action;
+    ramen::Span<const LedCommandEvent> commands;  // Of SAVE, in order; valid until the dispatch returns
+};
+
+struct StatusRequestEvent {};
+struct HelpRequestEvent {};
+struct StatsRequestEvent {};
+struct MemRequestEvent {};
+struct ProfileRequestEvent {
+    bool reset;
+};
+struct FsmBenchRequestEvent {};
+struct HashBenchRequestEvent {};
+struct TraceRequestEvent {
+    bool clear;
+};
+// Telemetry subscription of the host (see TelemetryActor), through the endpoint it came from
+struct TelemetrySubscribeEvent {
+    enum Mode : std::uint8_t { OFF = 0, PERIODIC = 1, ON_CHANGE = 2 };
+    Mode mode;
+    std::uint16_t period_ms;  // Of the frames, or of the checks for a change
+    ramen::Pusher<ramen::Span<const std::uint8_t>>* frame_out;  // Of the endpoint, for the frames
+    ramen::Puller<bool>* output_ready;                           // Of the endpoint: room for a frame right away
+};
+struct LatencyRequestEvent {
+    bool reset;
+};
+struct BootProfileRequestEvent {};
+struct ScanRequestEvent {
+    bool reset;
+};
+struct PortTraceRequestEvent {
+    bool clear;
+};
+struct WatchdogRequestEvent {
+    bool clear;
+};
+struct RecordRequestEvent {};
+// A 'baud' command: the rate to switch the programming port to, or 0 to report the current one
+struct BaudRequestEvent {
+    std::uint32_t rate;
+};
+
+class SerialCollectorActor {
+private:
+    std::uint8_t buffer[MAX_LINE_LENGTH];
+    std::size_t pos = 0;
+
+    void consume(std::uint8_t c) {
+        if (c == '\n' || c == '\r') {
+            if (pos > 0) {
+                buffer[pos] = '\0';
+                // The line is handed out as a view into the buffer; the next line starts after the dispatch
+                const CommandLineEvent cmd_evt{buffer, pos};
+                pos = 0;
+                line_out(cmd_evt);
+            }
+        } else if (pos < MAX_LINE_LENGTH - 1) {
+            buffer[pos++] = c;
+        } else {
+            // Buffer overflow, reset
+            pos = 0;
+        }
+    }
+
+public:
+    // Input: individual characters from serial
+    ramen::Pushable<SerialCharEvent> char_in = 
+        [this](const SerialCharEvent& evt) {
+            consume(evt.character);
+        };
+
+    // Input: a run of characters from serial, delivered in one dispatch
+    ramen::Pushable<ramen::Span<const std::uint8_t>> chars_in =
+        [this](const ramen::Span<const std::uint8_t>& chars) {
+            for (std::uint8_t c : chars) {
+                consume(c);
+            }
+        };
+    
+    // Output: complete command lines
+    ramen::DirectPusher<CommandLineEvent> line_out;
+};
+
+// Assembles command lines byte by byte straight into one of two line buffers, so a line is buffered once and
+// published as a view without a copy. on_byte() is the producer side and may run in a USART receive interrupt (see
+// SERIAL_LINE_FRAMER_ISR); poll() is the consumer side and publishes a completed line from the main loop while the
+// next one fills the other buffer. A line completed while the previous one is still waiting is dropped.
+class LineFramer {
+public:
+    ramen::DirectPusher<CommandLineEvent> line_out;
+
+    // Producer side; true if the byte completed a line
+    bool on_byte(std::uint8_t c) {
+        if (c == '\n' || c == '\r') {
+            const bool complete = pos_ > 0 && !overflow_;
+            if (complete && ready_ == NONE) {
+                lines_[fill_][pos_] = '\0';
+                lengths_[fill_] = pos_;
+                ready_ = fill_;
+                fill_ ^= 1U;
+            } else if (complete && dropped_ != UINT8_MAX) {
+                ++dropped_;
+            }
+            pos_ = 0;
+            overflow_ = false;
+            return complete;
+        }
+        if (pos_ < MAX_LINE_LENGTH - 1U) {
+            lines_[fill_][pos_++] = c;
+        } else {
+            overflow_ = true;  // The rest of an overlong line is discarded
+        }
+        return false;
+    }
+
+    // Consumer side; publishes the completed line, if any
+    bool poll() {
+        const std::uint8_t ready = ready_;
+        if (ready == NONE) {
+            return false;
+        }
+        const CommandLineEvent line{lines_[ready], lengths_[ready]};
+        line_out(line);
+        ready_ = NONE;  // Hands the buffer back to the producer
+        return true;
+    }
+
+    // Producer side; forgets the partial line
+    void discard() {
+        pos_ = 0;
+        overflow_ = false;
+    }
+
+    // Lines dropped because the previous one had not been published yet; saturates at 255
+    std::uint8_t dropped() const { return dropped_; }
+
+private:
+    static constexpr std::uint8_t NONE = 0xFF;
+
+    std::uint8_t lines_[2][MAX_LINE_LENGTH];
+    std::uint8_t lengths_[2] = {0, 0};
+    std::uint8_t fill_ = 0;  // Buffer being filled; producer only
+    std::uint8_t pos_ = 0;   // Producer only
+    bool overflow_ = false;  // Producer only
+    volatile std::uint8_t ready_ = NONE;  // Completed buffer: set by the producer, cleared by the consumer
+    volatile std::uint8_t dropped_ = 0;
+};
+
+class CommandParserActor {
+public:
+    // Arguments a command takes, parsed before its handler runs
+    enum class Args : std::uint8_t {
+        NONE,
+        FLAG,        // An optional keyword, e.g. "profile reset"
+        ID,          // An output id
+        ID_INTERVAL, // An output id and an interval in ms
+        NUMBER       // An optional unsigned number, 0 if there is none
+    };
+
+    struct Parsed {
+        bool flag;
+        std::uint8_t led_id;
+        std::uint8_t count;  // Of the outputs from led_id on, or LedCommandEvent::ALL
+        std::uint32_t interval;
+    };
+
+    // How a command of the line parsed
+    enum class Outcome : std::uint8_t {
+        OK,
+        INVALID,    // Unknown, or its arguments do not parse
+        UNEXPECTED  // An argument after those it takes
+    };
+
+    static constexpr std::uint8_t MAX_LINE_COMMANDS = 8;  // Of one line; separated by ';'
+    static constexpr std::uint32_t MAX_NUMBER = 10000000;  // Of an Args::NUMBER
+
+private:
+    // Unsigned decimal number at `str`, which is advanced past its digits; false if there is none or it overflows
+    template <class T>
+    static bool parse_number(const std::uint8_t*& str, T& value) {
+        const char* first = reinterpret_cast<const char*>(str);
+        const char* last = first;
+        while (*last >= '0' && *last <= '9') {
+            ++last;
+        }
+        const std::from_chars_result r = std::from_chars(first, last, value);
+        str = reinterpret_cast<const std::uint8_t*>(r.ptr);
+        return r.ec == std::errc{};
+    }
+
+    // Parses a 1-based output id (1..255) into an index; the executor checks it against the registry
+    static bool parse_id(const std::uint8_t*& str, std::uint8_t& led_id) {
+        unsigned id = 0;
+        if (!parse_number(str, id) || id < 1U || id > 255U) {
+            return false;
+        }
+        led_id = static_cast<std::uint8_t>(id - 1U);
+        return true;
+    }
+
+    // Parses the outputs a command applies to, after blanks: an id, a range of ids ("1-8") or all of them ("*")
+    static bool parse_target(const std::uint8_t*& str, std::uint8_t& led_id, std::uint8_t& count) {
+        while (*str == ' ' || *str == '\t') str++;
+        if (*str == '*') {
+            str++;
+            led_id = 0;
+            count = LedCommandEvent::ALL;
+            return true;
+        }
+        if (!parse_id(str, led_id)) {
+            return false;
+        }
+        count = 1;
+        if (*str != '-') {
+            return true;
+        }
+        str++;
+        std::uint8_t last = 0;
+        if (!parse_id(str, last) || last < led_id) {
+            return false;
+        }
+        count = static_cast<std::uint8_t>(last - led_id + 1U);  // Never ALL: ids end at 255
+        return true;
+    }
+
+    // Whether the argument at `str` (after blanks) is `word` (lower case), compared case-insensitively
+    static bool argument_is(const std::uint8_t* str, const char* word) {
+        while (*str == ' ' || *str == '\t') str++;
+        for (; *word != '\0'; ++word, ++str) {
+            if (std::tolower(*str) != *word) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Whether only blanks are left of the command at `str`, after its arguments
+    static bool at_end(const std::uint8_t* str) {
+        while (*str == ' ' || *str == '\t') str++;
+        return *str == '\0' || *str == ';';
+    }
+
+    bool parse_led_target(const std::uint8_t*& str, std::uint8_t& led_id, std::uint8_t& count) {
+        return parse_target(str, led_id, count);
+    }
+    
+    bool parse_interval_command(const std::uint8_t*& str, std::uint8_t& led_id, std::uint8_t& count,
+                                std::uint32_t& interval) {
+        // Parse the target outputs
+        if (!parse_target(str, led_id, count)) {
+            return false;
+        }
+        
+        // Skip whitespace and a plus sign; negative intervals are invalid anyway
+        while (*str == ' ' || *str == '\t') str++;
+        if (*str == '+') {
+            str++;
+        }
+        
+        // Parse interval in the valid range
+        std::uint32_t parsed_interval = 0;
+        if (!parse_number(str, parsed_interval)) {
+            return false;
+        }
+        
+        if (parsed_interval < 1 || parsed_interval > 60000) {  // 1ms to 60s range
+            return false;
+        }
+        
+        interval = parsed_interval;
+        return true;
+    }
+
+    // Parses an optional number up to MAX_NUMBER, after blanks and a plus sign; 0 if the command ends first
+    static bool parse_optional_number(const std::uint8_t*& str, std::uint32_t& value) {
+        while (*str == ' ' || *str == '\t') str++;
+        value = 0;
+        if (*str == '\0' || *str == ';') {
+            return true;
+        }
+        if (*str == '+') {
+            str++;
+        }
+        return parse_number(str, value) && value <= MAX_NUMBER;
+    }
+
+    using Handler = void (*)(CommandParserActor&, const Parsed&);
+
+    struct Command {
+        char name[COMMAND_NAME_SIZE];  // Lower case
+        Args args;
+        const char* flag;  // Keyword of an Args::FLAG command
+        const char* error; // In PROGMEM, reported if the arguments do not parse
+        Handler handler;
+    };
+
+    static void on_help(CommandParserActor& p, const Parsed&) { p.help_request_out(HelpRequestEvent{}); }
+    static void on_status(CommandParserActor& p, const Parsed&) { p.status_request_out(StatusRequestEvent{}); }
+    static void on_stats(CommandParserActor& p, const Parsed&) { p.stats_request_out(StatsRequestEvent{}); }
+    static void on_mem(CommandParserActor& p, const Parsed&) { p.mem_request_out(MemRequestEvent{}); }
+    static void on_profile(CommandParserActor& p, const Parsed& a) {
+        p.profile_request_out(ProfileRequestEvent{a.flag});
+    }
+    static void on_trace(CommandParserActor& p, const Parsed& a) { p.trace_request_out(TraceRequestEvent{a.flag}); }
+    static void on_latency(CommandParserActor& p, const Parsed& a) {
+        p.latency_request_out(LatencyRequestEvent{a.flag});
+    }
+    static void on_scan(CommandParserActor& p, const Parsed& a) { p.scan_request_out(ScanRequestEvent{a.flag}); }
+    static void on_ptrace(CommandParserActor& p, const Parsed& a) {
+        p.port_trace_request_out(PortTraceRequestEvent{a.flag});
+    }
+    static void on_watchdog(CommandParserActor& p, const Parsed& a) {
+        p.watchdog_request_out(WatchdogRequestEvent{a.flag});
+    }
+    static void on_record(CommandParserActor& p, const Parsed&) { p.record_request_out(RecordRequestEvent{}); }
+    static void on_fsmbench(CommandParserActor& p, const Parsed&) { p.fsm_bench_request_out(FsmBenchRequestEvent{}); }
+    static void on_hashbench(CommandParserActor& p, const Parsed&) {
+        p.hash_bench_request_out(HashBenchRequestEvent{});
+    }
+    static void on_script(CommandParserActor& p, const Parsed& a) { p.capture_script(a.flag); }
+    static void on_boot(CommandParserActor& p, const Parsed&) { p.boot_profile_request_out(BootProfileRequestEvent{}); }
+    static void on_baud(CommandParserActor& p, const Parsed& a) { p.baud_request_out(BaudRequestEvent{a.interval}); }
+
+    // LED commands are collected while end_line() runs and go out as one batch
+    static void on_start(CommandParserActor& p, const Parsed& a) {
+        p.add_to_batch(LedCommandEvent{a.led_id, LedCommandEvent::START, 0, a.count});
+    }
+
+    static void on_stop(CommandParserActor& p, const Parsed& a) {
+        p.add_to_batch(LedCommandEvent{a.led_id, LedCommandEvent::STOP, 0, a.count});
+    }
+
+    static void on_interval(CommandParserActor& p, const Parsed& a) {
+        p.add_to_batch(LedCommandEvent{a.led_id, LedCommandEvent::SET_INTERVAL, a.interval, a.count});
+    }
+
+    static constexpr char START_ERROR[] PROGMEM = "Invalid LED ID for start command";
+    static constexpr char STOP_ERROR[] PROGMEM = "Invalid LED ID for stop command";
+    static constexpr char INTERVAL_ERROR[] PROGMEM = "Invalid format for interval command";
+    static constexpr char BAUD_ERROR[] PROGMEM = "Invalid baud rate";
+
+    // The command language, in flash; the hash below is derived from the names at compile time
+    static constexpr Command COMMANDS[] PROGMEM = {
+        {"help", Args::NONE, nullptr, nullptr, &on_help},
+        {"status", Args::NONE, nullptr, nullptr, &on_status},
+        {"stats", Args::NONE, nullptr, nullptr, &on_stats},
+        {"mem", Args::NONE, nullptr, nullptr, &on_mem},
+        {"profile", Args::FLAG, "reset", nullptr, &on_profile},
+        {"trace", Args::FLAG, "clear", nullptr, &on_trace},
+        {"ptrace", Args::FLAG, "clear", nullptr, &on_ptrace},
+        {"latency", Args::FLAG, "reset", nullptr, &on_latency},
+        {"scan", Args::FLAG, "reset", nullptr, &on_scan},
+        {"watchdog", Args::FLAG, "clear", nullptr, &on_watchdog},
+        {"record", Args::NONE, nullptr, nullptr, &on_record},
+        {"fsmbench", Args::NONE, nullptr, nullptr, &on_fsmbench},
+        {"hashbench", Args::NONE, nullptr, nullptr, &on_hashbench},
+        {"script", Args::FLAG, "clear", nullptr, &on_script},
+        {"boot", Args::NONE, nullptr, nullptr, &on_boot},
+        {"baud", Args::NUMBER, nullptr, BAUD_ERROR, &on_baud},
+        {"start", Args::ID, nullptr, START_ERROR, &on_start},
+        {"stop", Args::ID, nullptr, STOP_ERROR, &on_stop},
+        {"interval", Args::ID_INTERVAL, nullptr, INTERVAL_ERROR, &on_interval},
+    };
+    static constexpr auto COMMAND_HASH PROGMEM = command_table::build<32>(COMMANDS);
+    static_assert(COMMAND_HASH.valid(), "No perfect hash for the command names; use more slots");
+
+    // A command of the line and its arguments, or a command to reject; run by end_line()
+    struct Pending {
+        std::uint8_t command;
+        Outcome outcome;
+        Parsed parsed;
+    };
+
+    ramen::StaticVector<Pending, MAX_LINE_COMMANDS> pending_;
+    bool pending_overflow_ = false;
+    LedCommandEvent* batch_ = nullptr;  // In the frame of end_line() while it runs
+    std::uint8_t batch_length_ = 0;
+    std::uint8_t running_ = 0;          // Index into pending_ of the command end_line() runs
+
+    void queue(std::uint8_t command, Outcome outcome, const Parsed& parsed) {
+        if (!pending_.push_back(Pending{command, outcome, parsed})) {
+            pending_overflow_ = true;
+        }
+    }
+
+    void add_to_batch(const LedCommandEvent& evt) { batch_[batch_length_++] = evt; }
+
+    void flush_batch() {
+        if (batch_length_ > 0) {
+            led_batch_out(LedBatchEvent{ramen::Span<const LedCommandEvent>(batch_, batch_length_)});
+            batch_length_ = 0;
+        }
+    }
+
+    static bool is_led_command(std::uint8_t command) {
+        return args_of(command) == Args::ID || args_of(command) == Args::ID_INTERVAL;
+    }
+
+    // Sends the valid LED commands after the running 'script' command as the boot script, built by their handlers;
+    // they still run as usual once end_line() gets to them
+    void capture_script(bool clear) {
+        if (clear) {
+            script_out(BootScriptEvent{BootScriptEvent::CLEAR, {}});
+            return;
+        }
+        LedCommandEvent script[MAX_LINE_COMMANDS];
+        LedCommandEvent* const batch = batch_;
+        batch_ = script;  // Empty here: the LED commands before 'script' have been flushed
+        for (std::uint8_t i = static_cast<std::uint8_t>(running_ + 1U); i < pending_.size(); ++i) {
+            const Pending& p = pending_[i];
+            if (p.outcome == Outcome::OK && is_led_command(p.command)) {
+                reinterpret_cast<Handler>(pgm_read_ptr(&COMMANDS[p.command].handler))(*this, p.parsed);
+            }
+        }
+        const BootScriptEvent::Action action = batch_length_ > 0 ? BootScriptEvent::SAVE : BootScriptEvent::SHOW;
+        script_out(BootScriptEvent{action, ramen::Span<const LedCommandEvent>(script, batch_length_)});
+        batch_ = batch;
+        batch_length_ = 0;
+    }
+
+    // Parses the command at the start of `segment`, which ends at the line's end or a ';'; blank segments are skipped
+    void dispatch(const std::uint8_t* segment) {
+        while (*segment == ' ' || *segment == '\t') segment++;
+        if (*segment == '\0' || *segment == ';') {
+            return;
+        }
+        const std::uint8_t* const line = segment;
+        std::size_t length = 0;
+        while (line[length] != '\0' && line[length] != ' ' && line[length] != '\t' && line[length] != ';') {
+            ++length;
+        }
+        const std::uint8_t command = lookup(line, length);
+        const std::uint8_t* args = line + length;
+        Parsed parsed{false, 0, 1, 0};
+        bool ok = command != command_table::NONE;
+        switch (ok ? args_of(command) : Args::NONE) {
+            case Args::NONE:
+                break;
+            case Args::FLAG:
+                parsed.flag = argument_is(args, flag_of(command));
+                break;
+            case Args::ID:
+                ok = parse_led_target(args, parsed.led_id, parsed.count);
+                break;
+            case Args::ID_INTERVAL:
+                ok = parse_interval_command(args, parsed.led_id, parsed.count, parsed.interval);
+                break;
+            case Args::NUMBER:
+                ok = parse_optional_number(args, parsed.interval);
+                break;
+        }
+        if (!ok) {
+            reject(command);
+        } else if (takes_value(command) && !at_end(args)) {
+            reject(command, Outcome::UNEXPECTED);
+        } else {
+            accept(command, parsed);
+        }
+    }
+
+    void report_rejection(std::uint8_t command, Outcome outcome) {
+        if (command == command_table::NONE) {
+            error_out(F("Unknown command. Type 'help' for usage."));
+        } else if (outcome == Outcome::UNEXPECTED) {
+            error_out(F("Unexpected argument"));
+        } else {
+            error_out(static_cast<const __FlashStringHelper*>(pgm_read_ptr(&COMMANDS[command].error)));
+        }
+    }
+
+public:
+    // Input: command lines to parse, each holding commands separated by ';'; the first word of a command is looked
+    // up whole, in any case, and the line is not copied
+    ramen::Pushable<CommandLineEvent> line_in =
+        [this](const CommandLineEvent& evt) {
+            for (const std::uint8_t* segment = evt.command_line; segment != nullptr;) {
+                dispatch(segment);
+                segment = reinterpret_cast<const std::uint8_t*>(std::strchr(reinterpret_cast<const char*>(segment),
+                                                                            ';'));
+                if (segment != nullptr) {
+                    ++segment;
+                }
+            }
+            end_line();
+        };
+
+    // The command table, for parsers that take the line apart themselves (see StreamingCommandParser)
+
+    // Index of the command named by a word of `length` characters, in any case, or command_table::NONE
+    static std::uint8_t lookup(const std::uint8_t* word, std::size_t length) {
+        return command_table::find(COMMANDS, COMMAND_HASH, word, length);
+    }
+
+    static Args args_of(std::uint8_t command) { return static_cast<Args>(pgm_read_byte(&COMMANDS[command].args)); }
+
+    // Keyword of an Args::FLAG command, in RAM
+    static const char* flag_of(std::uint8_t command) {
+        return static_cast<const char*>(pgm_read_ptr(&COMMANDS[command].flag));
+    }
+
+    // Whether the command takes an id or a number, after which nothing else may follow
+    static bool takes_value(std::uint8_t command) {
+        return is_led_command(command) || args_of(command) == Args::NUMBER;
+    }
+
+    // Queues a command of the current line with its parsed arguments
+    void accept(std::uint8_t command, const Parsed& args) { queue(command, Outcome::OK, args); }
+
+    // Queues the report of an unknown command (command_table::NONE), of arguments that do not parse or of one too many
+    void reject(std::uint8_t command, Outcome outcome = Outcome::INVALID) {
+        queue(command, outcome, Parsed{false, 0, 1, 0});
+    }
+
+    // At the end of a line: runs its commands in order, the LED commands between two others as one batch, and
+    // reports the rejected ones
+    void end_line() {
+        LedCommandEvent batch[MAX_LINE_COMMANDS];
+        batch_ = batch;
+        for (std::uint8_t i = 0; i < pending_.size(); ++i) {
+            const Pending& p = pending_[i];
+            running_ = i;
+            if (p.outcome == Outcome::OK && is_led_command(p.command)) {
+                reinterpret_cast<Handler>(pgm_read_ptr(&COMMANDS[p.command].handler))(*this, p.parsed);
+                continue;
+            }
+            flush_batch();
+            if (p.outcome == Outcome::OK) {
+                reinterpret_cast<Handler>(pgm_read_ptr(&COMMANDS[p.command].handler))(*this, p.parsed);
+            } else {
+                report_rejection(p.command, p.outcome);
+            }
+        }
+        flush_batch();
+        batch_ = nullptr;
+        if (pending_overflow_) {
+            error_out(F("Too many commands in one line; the rest was ignored"));
+        }
+        discard_line();
+    }
+
+    // Forgets the queued commands, e.g. of a line that turned out to be too long
+    void discard_line() {
+        pending_.clear();
+        pending_overflow_ = false;
+    }
+
+    // Outputs: parsed commands
+    ramen::DirectPusher<LedBatchEvent> led_batch_out;
+    ramen::Pusher<HelpRequestEvent> help_request_out;
+    ramen::Pusher<StatusRequestEvent> status_request_out;
+    ramen::Pusher<StatsRequestEvent> stats_request_out;
+    ramen::Pusher<MemRequestEvent> mem_request_out;
+    ramen::Pusher<ProfileRequestEvent> profile_request_out;
+    ramen::Pusher<FsmBenchRequestEvent> fsm_bench_request_out;
+    ramen::Pusher<HashBenchRequestEvent> hash_bench_request_out;
+    ramen::Pusher<TraceRequestEvent> trace_request_out;
+    ramen::Pusher<PortTraceRequestEvent> port_trace_request_out;
+    ramen::Pusher<RecordRequestEvent> record_request_out;
+    ramen::Pusher<LatencyRequestEvent> latency_request_out;
+    ramen::Pusher<ScanRequestEvent> scan_request_out;
+    ramen::Pusher<WatchdogRequestEvent> watchdog_request_out;
+    ramen::Pusher<BootScriptEvent> script_out;
+    ramen::Pusher<BootProfileRequestEvent> boot_profile_request_out;
+    ramen::Pusher<BaudRequestEvent> baud_request_out;
+    ramen::Pusher<const __FlashStringHelper*> error_out;
+};
+
+// Lexer events: one per received byte
+struct lex_symbol {
+    std::uint8_t c;
+};
+struct lex_blank {};
+struct lex_separator {};  // ';' between the commands of a line
+struct lex_end_of_line {};
+
+// Lexer states
+struct line_start {};
+struct command_word {};
+struct command_found {};  // Left at once for the arguments of the command, if any
+struct flag_argument {};
+struct id_argument {};
+struct range_argument {};  // After the '-' of "1-8"
+struct interval_argument {};
+struct line_rest {};  // Bytes that no longer change the outcome of the line
+
+// Tokens of the line being received, built up byte by byte; injected into the lexer by reference
+struct command_lexer_context {
+    using Args = CommandParserActor::Args;
+
+    CommandParserActor& parser;
+    std::uint8_t word[COMMAND_NAME_SIZE];
+    std::uint8_t word_length = 0;
+    std::uint8_t command = command_table::NONE;
+    std::uint8_t line_length = 0;  // Saturates at MAX_LINE_LENGTH: the line is too long and is dropped
+    const char* flag = nullptr;    // Rest of the flag keyword still to match
+    bool flag_started = false;
+    std::uint16_t id = 0;          // Saturates above 255
+    std::uint8_t id_digits = 0;
+    bool wildcard = false;         // "*"
+    bool ranged = false;           // "1-8": id is the first, last_id the last
+    std::uint16_t last_id = 0;     // Saturates above 255
+    std::uint8_t last_digits = 0;
+    std::uint32_t interval = 0;    // Saturates above CommandParserActor::MAX_NUMBER
+    std::uint8_t interval_digits = 0;
+    bool interval_signed = false;
+    bool interval_negative = false;
+    bool failed = false;
+    bool unexpected = false;       // A symbol after the arguments
+
+    explicit command_lexer_context(CommandParserActor& command_parser) : parser(command_parser) {}
+
+    // A new line: no tokens yet
+    void reset() {
+        word_length = 0;
+        command = command_table::NONE;
+        flag = nullptr;
+        flag_started = false;
+        id = 0;
+        id_digits = 0;
+        wildcard = false;
+        ranged = false;
+        last_id = 0;
+        last_digits = 0;
+        interval = 0;
+        interval_digits = 0;
+        interval_signed = false;
+        interval_negative = false;
+        failed = false;
+        unexpected = false;
+    }
+
+    void begin_word(std::uint8_t c) {
+        reset();
+        add_to_word(c);
+    }
+
+    void add_to_word(std::uint8_t c) {
+        if (word_length < sizeof(word)) {
+            word[word_length] = c;
+        }
+        if (word_length < UINT8_MAX) {
+            ++word_length;
+        }
+    }
+
+    void end_word() {
+        command = CommandParserActor::lookup(word, (word_length <= sizeof(word)) ? word_length : 0U);
+        if (takes(Args::FLAG)) {
+            flag = CommandParserActor::flag_of(command);
+        }
+    }
+
+    bool takes(Args args) const {
+        return command != command_table::NONE && CommandParserActor::args_of(command) == args;
+    }
+
+    bool flag_matches(std::uint8_t c) const {
+        return flag != nullptr && *flag != '\0' && command_table::lower(c) == static_cast<std::uint8_t>(*flag);
+    }
+
+    void advance_flag() {
+        ++flag;
+        flag_started = true;
+    }
+
+    void add_id_digit(std::uint8_t c) {
+        id = static_cast<std::uint16_t>((id > 255U) ? id : id * 10U + (c - '0'));
+        ++id_digits;
+    }
+
+    void add_last_digit(std::uint8_t c) {
+        last_id = static_cast<std::uint16_t>((last_id > 255U) ? last_id : last_id * 10U + (c - '0'));
+        ++last_digits;
+    }
+
+    void add_interval_digit(std::uint8_t c) {
+        interval = (interval > CommandParserActor::MAX_NUMBER) ? interval : interval * 10U + (c - '0');
+        ++interval_digits;
+    }
+
+    // At the end of a command: queues it or its rejection with the parser; overlong lines are dropped like
+    // LineFramer does
+    void finish() {
+        if (line_length >= MAX_LINE_LENGTH) {
+            return;
+        }
+        const bool first_ok = id_digits > 0 && id >= 1U && id <= 255U;
+        const bool last_ok = !ranged || (last_digits > 0 && last_id >= id && last_id <= 255U);
+        const bool id_ok = !failed && (wildcard || (first_ok && last_ok));
+        bool ok = command != command_table::NONE;
+        if (takes(Args::ID)) {
+            ok = id_ok;
+        } else if (takes(Args::ID_INTERVAL)) {
+            ok = id_ok && interval_digits > 0 && !interval_negative && interval >= 1U && interval <= 60000U;
+        } else if (takes(Args::NUMBER)) {
+            ok = !failed && !interval_negative && (interval_digits > 0 || !interval_signed) &&
+                 interval <= CommandParserActor::MAX_NUMBER;
+        }
+        if (ok && unexpected && CommandParserActor::takes_value(command)) {
+            parser.reject(command, CommandParserActor::Outcome::UNEXPECTED);
+        } else if (ok) {
+            const std::uint8_t count = wildcard ? LedCommandEvent::ALL
+                                       : ranged ? static_cast<std::uint8_t>(last_id - id + 1U)
+                                                : 1;
+            const CommandParserActor::Parsed parsed{flag != nullptr && *flag == '\0',
+                                                    static_cast<std::uint8_t>(wildcard ? 0U : id - 1U), count,
+                                                    interval};
+            parser.accept(command, parsed);
+        } else {
+            parser.reject(command);
+        }
+    }
+};
+
+// The command language as a lexer machine. Each byte moves it one transition and updates the tokens, so the command
+// is parsed by the time its line ends; it accepts exactly the lines CommandParserActor accepts.
+template <class Context>
+struct command_lexer_fsm {
+    auto operator()() const {
+        using namespace boost::sml;
+        using Args = CommandParserActor::Args;
+
+        auto is_digit = [](const lex_symbol& evt) FSM_ACTION { return evt.c >= '0' && evt.c <= '9'; };
+        auto is_sign = [](const lex_symbol& evt) FSM_ACTION { return evt.c == '+' || evt.c == '-'; };
+        auto is_wildcard = [](Context& ctx, const lex_symbol& evt) FSM_ACTION {
+            return ctx.id_digits == 0 && evt.c == '*';  // "*"
+        };
+        auto is_range = [](Context& ctx, const lex_symbol& evt) FSM_ACTION {
+            return ctx.id_digits > 0 && evt.c == '-';  // "1-8"
+        };
+        auto takes_flag = [](Context& ctx) FSM_ACTION { return ctx.takes(Args::FLAG); };
+        auto takes_id = [](Context& ctx) FSM_ACTION { return ctx.takes(Args::ID) || ctx.takes(Args::ID_INTERVAL); };
+        auto takes_interval = [](Context& ctx) FSM_ACTION { return ctx.takes(Args::ID_INTERVAL); };
+        auto takes_number = [](Context& ctx) FSM_ACTION { return ctx.takes(Args::NUMBER); };
+        auto flag_pending = [](Context& ctx) FSM_ACTION { return !ctx.flag_started; };
+        auto flag_matches = [](Context& ctx, const lex_symbol& evt) FSM_ACTION { return ctx.flag_matches(evt.c); };
+        auto id_pending = [](Context& ctx) FSM_ACTION { return ctx.id_digits == 0; };
+        auto sign_after_id = [](Context& ctx, const lex_symbol& evt) FSM_ACTION {
+            return ctx.id_digits > 0 && ctx.takes(Args::ID_INTERVAL) && (evt.c == '+' || evt.c == '-');  // "1+500"
+        };
+        auto no_last = [](Context& ctx) FSM_ACTION { return ctx.last_digits == 0; };
+        auto sign_after_last = [](Context& ctx, const lex_symbol& evt) FSM_ACTION {
+            return ctx.last_digits > 0 && ctx.takes(Args::ID_INTERVAL) && (evt.c == '+' || evt.c == '-');
+        };
+        auto interval_pending = [](Context& ctx) FSM_ACTION {
+            return ctx.interval_digits == 0 && !ctx.interval_signed;
+        };
+
+        auto begin_word = [](Context& ctx, const lex_symbol& evt) FSM_ACTION { ctx.begin_word(evt.c); };
+        auto add_to_word = [](Context& ctx, const lex_symbol& evt) FSM_ACTION { ctx.add_to_word(evt.c); };
+        auto end_word = [](Context& ctx) FSM_ACTION { ctx.end_word(); };
+        auto advance_flag = [](Context& ctx) FSM_ACTION { ctx.advance_flag(); };
+        auto add_id_digit = [](Context& ctx, const lex_symbol& evt) FSM_ACTION { ctx.add_id_digit(evt.c); };
+        auto add_last_digit = [](Context& ctx, const lex_symbol& evt) FSM_ACTION { ctx.add_last_digit(evt.c); };
+        auto set_wildcard = [](Context& ctx) FSM_ACTION { ctx.wildcard = true; };
+        auto begin_range = [](Context& ctx) FSM_ACTION { ctx.ranged = true; };
+        auto add_interval_digit = [](Context& ctx, const lex_symbol& evt) FSM_ACTION {
+            ctx.add_interval_digit(evt.c);
+        };
+        auto set_sign = [](Context& ctx, const lex_symbol& evt) FSM_ACTION {
+            ctx.interval_signed = true;
+            ctx.interval_negative = evt.c == '-';
+        };
+        auto fail = [](Context& ctx) FSM_ACTION { ctx.failed = true; };
+        auto extra = [](Context& ctx) FSM_ACTION { ctx.unexpected = true; };
+        auto finish = [](Context& ctx) FSM_ACTION { ctx.finish(); };
+        auto end_word_and_finish = [](Context& ctx) FSM_ACTION {
+            ctx.end_word();
+            ctx.finish();
+        };
+
+        const auto start = state<line_start>;
+        const auto word = state<command_word>;
+        const auto args = state<command_found>;
+        const auto flag = state<flag_argument>;
+        const auto id = state<id_argument>;
+        const auto range = state<range_argument>;
+        const auto interval = state<interval_argument>;
+        const auto rest = state<line_rest>;
+        const auto symbol = event<lex_symbol>;
+        const auto blank = event<lex_blank>;
+        const auto sep = event<lex_separator>;
+        const auto eol = event<lex_end_of_line>;
+
+        // Guards are tried in the order of the rows; guards run before the action of their row
+        return make_transition_table(
+            *start    + eol                                                         = start,
+             start    + symbol                                / begin_word          = word,
+             start    + blank                                                       = start,
+             start    + sep                                                         = start,
+
+             word     + symbol                                / add_to_word         = word,
+             word     + blank                                 / end_word            = args,
+             word     + sep                                   / end_word_and_finish = start,
+             word     + eol                                   / end_word_and_finish = start,
+             args              [takes_flag]                                         = flag,
+             args              [takes_id]                                           = id,
+             args              [takes_number]                                       = interval,
+             args                                                                   = rest,
+
+             flag     + blank  [flag_pending]                                       = flag,
+             flag     + symbol [flag_matches]                 / advance_flag        = flag,
+             flag     + symbol                                                      = rest,
+             flag     + blank                                                       = rest,
+             flag     + sep                                   / finish              = start,
+             flag     + eol                                   / finish              = start,
+
+             id       + blank  [id_pending]                                         = id,
+             id       + blank  [takes_interval]                                     = interval,
+             id       + blank                                                       = rest,
+             id       + symbol [is_digit]                     / add_id_digit        = id,
+             id       + symbol [is_wildcard && takes_interval] / set_wildcard       = interval,
+             id       + symbol [is_wildcard]                  / set_wildcard        = rest,
+             id       + symbol [is_range]                     / begin_range         = range,
+             id       + symbol [sign_after_id]                / set_sign            = interval,
+             id       + symbol [id_pending || takes_interval] / fail                = rest,
+             id       + symbol                                / extra               = rest,
+             id       + sep                                   / finish              = start,
+             id       + eol                                   / finish              = start,
+
+             range    + symbol [is_digit]                     / add_last_digit      = range,
+             range    + symbol [sign_after_last]              / set_sign            = interval,
+             range    + symbol [no_last || takes_interval]    / fail                = rest,
+             range    + symbol                                / extra               = rest,
+             range    + blank  [no_last]                      / fail                = rest,
+             range    + blank  [takes_interval]                                     = interval,
+             range    + blank                                                       = rest,
+             range    + sep                                   / finish              = start,
+             range    + eol                                   / finish              = start,
+
+             interval + blank  [interval_pending]                                   = interval,
+             interval + symbol [is_digit]                     / add_interval_digit  = interval,
+             interval + symbol [interval_pending && is_sign]  / set_sign            = interval,
+             interval + symbol [takes_number && interval_pending] / fail            = rest,
+             interval + symbol                                / extra               = rest,
+             interval + blank                                                       = rest,
+             interval + sep                                   / finish              = start,
+             interval + eol                                   / finish              = start,
+
+             rest     + symbol                                / extra               = rest,
+             rest     + blank                                                       = rest,
+             rest     + sep                                   / finish              = start,
+             rest     + eol                                   / finish              = start
+        );
+    }
+};
+
+// Parses commands while their bytes arrive instead of once the line is complete: the work of a line is spread over
+// its bytes, and the command runs, through the parser's outputs, in the dispatch of the byte that ends the line. Use
+// it in place of a LineFramer in front of `parser` (-D SERIAL_STREAMING_PARSER in SerialCommandSystem).
+class StreamingCommandParser {
+public:
+    using fsm_type = command_lexer_fsm<command_lexer_context>;
+
+    ramen::Pushable<SerialCharEvent> char_in = [this](const SerialCharEvent& evt) { on_byte(evt.character); };
+
+    explicit StreamingCommandParser(CommandParserActor& command_parser) : context_(command_parser), sm_(context_) {}
+
+    void on_byte(std::uint8_t c) {
+        if (c == '\n' || c == '\r') {
+            sm_.process_event(lex_end_of_line{});
+            if (context_.line_length >= MAX_LINE_LENGTH) {
+                context_.parser.discard_line();
+            } else {
+                context_.parser.end_line();
+            }
+            context_.line_length = 0;
+            return;
+        }
+        if (context_.line_length < MAX_LINE_LENGTH) {
+            ++context_.line_length;
+        }
+        if (c == ' ' || c == '\t') {
+            sm_.process_event(lex_blank{});
+        } else if (c == ';') {
+            sm_.process_event(lex_separator{});
+        } else {
+            sm_.process_event(lex_symbol{c});
+        }
+    }
+
+    // True between lines, when the parser holds no command of a partial one
+    bool idle() const { return context_.line_length == 0; }
+
+    // Forgets the partial line and the commands queued from it
+    void discard() {
+        sm_.process_event(lex_end_of_line{});
+        context_.parser.discard_line();
+        context_.line_length = 0;
+    }
+
+private:
+    command_lexer_context context_;
+    fsm::actor_sm<fsm_type> sm_;
+};
+
+// Binary command endpoint for host software, on the port of the text commands (-D SERIAL_BINARY_PROTOCOL in
+// SerialCommandSystem). A zero byte opens a frame and the next one closes it (see binary_frame.hpp); on_byte() claims
+// the bytes from the first to the second, which thus never reach the text parser, and handles the frame once it is
+// closed; transports of whole frames fill frame_buffer() and call on_frame() instead (see actor_udp.hpp). Each frame
+// carries one request, decoded in place with its fields read straight into the events:
+//
+//     request                                  reply
+//     01 seq action index interval:u32         81 seq result
+//     02 seq                                   82 seq result count {state pin interval:u32}*count
+//     03 seq mode period:u16                   83 seq result, then telemetry frames (see TelemetryActor)
+//     04 seq offset:u16 data{1..32}            84 seq result                 (-D LOGIC_VM, see logic_vm.hpp)
+//     05 seq                                   85 seq result
+//     06 seq from:u32                          86 seq result next:u32 first:u32 count {record:8}*count
+//     07 seq from:u8                           87 seq result total count {hash:u32 type}*count   (-D LIVE_WATCH,
+//     08 seq {index}*n                         88 seq result {value}*n                            see actor_watch.hpp)
+//     09 seq {index value}*n                   89 seq result
+//     0A seq period:u16 {index}*n              8A seq result, then sample frames
+//     0B seq offset:u16 data{1..32}            8B seq result                 (-D RECIPES, see actor_recipe.hpp)
+//     0C seq action slot                       8C seq result
+//     0D seq since:u16 flags                   8D seq result next:u16 flags count {record:10}*count
+//     0E seq id                                8E seq result                 (see actor_alarm_manager.hpp)
+//
+// Fields are little-endian and every payload ends in its CRC. `action` is a LedCommandEvent::Type, `index` the output
+// index (0 for id 1), `state` a led::state_id and `mode` a TelemetrySubscribeEvent::Mode. PROGRAM_WRITE stores data
+// at an offset of the logic program's image, PROGRAM_COMMIT verifies the image and runs it; both answer BUSY while the
+// last chunk is still being written to EEPROM. An unknown type is answered with type|0x80 and UNKNOWN_TYPE, and so
+// are the program requests without a logic VM. LOG_READ returns up to MAX_LOG_RECORDS records of the event log from
+// number `from` on, or from the oldest one kept if that is gone, with the number the next record will take, so a host
+// pages through the log by asking again from first + count (see actor_event_log.hpp); UNKNOWN_TYPE without a log.
+// The WATCH requests list, read, write and sample the variables of a watch::WatchActor's table by index, each value
+// as wide as its type; a write of a const variable is answered NOT_WRITABLE, and no indices stop the samples.
+// RECIPE_WRITE stages data at an offset of the next recipe, which starts as a copy of the active one; RECIPE_CONTROL
+// then switches to it (action 1), loads and switches to the recipe of an EEPROM slot (2), saves the active one to a
+// slot (3) or drops the staged changes (4), with `slot` ignored but present for 1 and 4. A switch happens at the start
+// of the next scan and is answered OK once accepted; BUSY while one is pending or a save runs, BAD_RECIPE if nothing is
+// staged or the slot's CRC fails, UNKNOWN_TYPE without a recipe actor.
+// ALARM_READ returns up to MAX_ALARM_RECORDS changes of the alarm table after number `since`, oldest first, with the
+// number to ask from next; flags bit 0 asks for the whole table, and is set in the reply when that is what it holds.
+// ALARM_ACK acknowledges alarm `id`, or all of them with FF. Both are UNKNOWN_TYPE without an alarm table.
+// Frames that are too long, badly encoded or fail the CRC are counted
+// and get no reply; the host retries after a timeout.
+class BinaryEndpointActor {
+    static constexpr std::size_t HEADER_SIZE = 2;  // Type and sequence number
+
+public:
+    enum Type : std::uint8_t {
+        LED_COMMAND = 0x01,
+        STATUS = 0x02,
+        SUBSCRIBE = 0x03,
+        PROGRAM_WRITE = 0x04,
+        PROGRAM_COMMIT = 0x05,
+        LOG_READ = 0x06,
+        WATCH_LIST = 0x07,
+        WATCH_READ = 0x08,
+        WATCH_WRITE = 0x09,
+        WATCH_SAMPLE = 0x0A,
+        RECIPE_WRITE = 0x0B,
+        RECIPE_CONTROL = 0x0C,
+        ALARM_READ = 0x0D,
+        ALARM_ACK = 0x0E,
+        REPLY = 0x80
+    };
+    enum Result : std::uint8_t {
+        OK = 0,
+        UNKNOWN_TYPE = 1,
+        BAD_LENGTH = 2,
+        BAD_INDEX = 3,
+        BAD_ACTION = 4,
+        BAD_PERIOD = 5,
+        BUSY = 6,
+        BAD_PROGRAM = 7,
+        NOT_WRITABLE = 8,
+        BAD_RECIPE = 9
+    };
+
+    // Longest request, encoded: a PROGRAM_WRITE or RECIPE_WRITE of a whole chunk, or a WATCH_WRITE of a full batch
+    static constexpr std::size_t PROGRAM_FRAME =
+        logic_vm::ENABLED
+            ? binary_frame::cobs_max_encoded(HEADER_SIZE + 2 + logic_vm::CHUNK_SIZE + binary_frame::CRC_SIZE)
+            : 16;
+    static constexpr std::size_t WATCH_FRAME =
+        watch::ENABLED ? binary_frame::cobs_max_encoded(HEADER_SIZE + watch::MAX_REQUEST + binary_frame::CRC_SIZE) : 16;
+    static constexpr std::size_t RECIPE_FRAME =
+        recipe::ENABLED ? binary_frame::cobs_max_encoded(HEADER_SIZE + 2 + recipe::CHUNK_SIZE + binary_frame::CRC_SIZE)
+                        : 16;
+    static constexpr std::size_t LONGER_FRAME = PROGRAM_FRAME > WATCH_FRAME ? PROGRAM_FRAME : WATCH_FRAME;
+    static constexpr std::size_t MAX_FRAME = LONGER_FRAME > RECIPE_FRAME ? LONGER_FRAME : RECIPE_FRAME;
+    static constexpr std::uint8_t MAX_STATUS_OUTPUTS = 8;
+    static constexpr std::uint8_t MAX_LOG_RECORDS = 6;
+    static constexpr std::uint8_t MAX_ALARM_RECORDS = 6;
+    // Shortest telemetry period; a frame of 8 outputs takes 46 ms at 9600 baud
+    static constexpr std::uint16_t MIN_TELEMETRY_PERIOD_MS = 50;
+
+    explicit BinaryEndpointActor(const led::OutputTable& output_table) : outputs(output_table) {}
+
+    // True if `byte` belongs to a binary frame, false if it is text
+    bool on_byte(std::uint8_t byte) {
+        if (byte == binary_frame::DELIMITER) {
+            if (!receiving_) {
+                receiving_ = true;
+                overlong_ = false;
+                length_ = 0;
+            } else if (length_ > 0) {  // Repeated delimiters open the same frame
+                receiving_ = false;
+                if (overlong_) {
+                    count_bad_frame();
+                } else {
+                    handle(frame_, length_);
+                }
+            }
+            return true;
+        }
+        if (!receiving_) {
+            return false;
+        }
+        if (length_ < MAX_FRAME) {
+            frame_[length_++] = byte;
+        } else {
+            overlong_ = true;
+        }
+        return true;
+    }
+
+    // For transports that carry whole frames, such as UDP datagrams: room for one frame of FRAME_BUFFER_SIZE bytes, its
+    // delimiters included, to be filled in place and then handled with on_frame()
+    static constexpr std::size_t FRAME_BUFFER_SIZE = MAX_FRAME + 2;
+    std::uint8_t* frame_buffer() { return frame_; }
+
+    // Handles the `length` bytes in frame_buffer(), a frame whose delimiters may be left out
+    void on_frame(std::size_t length) {
+        std::uint8_t* frame = frame_;
+        if (length > 0 && frame[0] == binary_frame::DELIMITER) {
+            ++frame;
+            --length;
+        }
+        if (length > 0 && frame[length - 1] == binary_frame::DELIMITER) {
+            --length;
+        }
+        if (length == 0 || length > MAX_FRAME) {
+            count_bad_frame();
+        } else {
+            handle(frame, length);
+        }
+    }
+
+    std::uint16_t bad_frames() const { return bad_frames_; }
+
+    // Output: decoded LED commands, for an executor of their own, as that responds in text
+    ramen::Pusher<LedCommandEvent> led_command_out;
+
+    // Output: telemetry subscriptions, checked
+    ramen::Pusher<TelemetrySubscribeEvent> subscribe_out;
+
+    // Output: chunks and commits of the logic program, for its store to answer (see logic_vm.hpp)
+    ramen::Pusher<const logic_vm::ProgramEvent&> program_out;
+
+    // Output: LOG_READ queries, for the event log to answer
+    ramen::Pusher<const event_log::ReadEvent&> log_read_out;
+
+    // Output: WATCH requests, for a watch::WatchActor to answer
+    ramen::Pusher<const watch::RequestEvent&> watch_out;
+
+    // Output: RECIPE requests, for a recipe::RecipeActor to answer
+    ramen::Pusher<const recipe::RequestEvent&> recipe_out;
+
+    // Output: ALARM_READ queries and ALARM_ACK requests, for an alarms::AlarmTable to answer
+    ramen::Pusher<const alarms::ReadEvent&> alarm_read_out;
+    ramen::Pusher<const alarms::AckEvent&> alarm_ack_out;
+
+    // Output: encoded reply frames, delimiters included, and the telemetry frames of its subscriptions
+    ramen::Pusher<ramen::Span<const std::uint8_t>> frame_out;
+
+    // Whether the transport takes a telemetry frame without waiting (see SerialOutputActor::can_accept)
+    ramen::Puller<bool> output_ready;
+
+private:
+    static constexpr std::size_t STATUS_REPLY = 4 + 6 * MAX_STATUS_OUTPUTS;
+    static constexpr std::size_t LOG_REPLY = 12 + event_log::RECORD_SIZE * MAX_LOG_RECORDS;
+    static constexpr std::size_t WATCH_REPLY = 3 + watch::REPLY_SIZE;
+    static constexpr std::size_t ALARM_REPLY = 7 + alarms::RECORD_SIZE * MAX_ALARM_RECORDS;
+    static constexpr std::size_t MAX_CONTENT = STATUS_REPLY > LOG_REPLY ? STATUS_REPLY : LOG_REPLY;
+    static constexpr std::size_t LONGER_CONTENT = MAX_CONTENT > WATCH_REPLY ? MAX_CONTENT : WATCH_REPLY;
+    static constexpr std::size_t MAX_REPLY =
+        (LONGER_CONTENT > ALARM_REPLY ? LONGER_CONTENT : ALARM_REPLY) + binary_frame::CRC_SIZE;
+
+    const led::OutputTable& outputs;
+    std::uint8_t frame_[FRAME_BUFFER_SIZE];
+    std::uint8_t length_ = 0;
+    bool receiving_ = false;
+    bool overlong_ = false;
+    std::uint16_t bad_frames_ = 0;
+
+    void count_bad_frame() {
+        if (bad_frames_ != UINT16_MAX) {
+            ++bad_frames_;
+        }
+    }
+
+    // Decodes the `received` bytes at `frame` in place and answers the request
+    void handle(std::uint8_t* frame, std::size_t received) {
+        std::size_t length = 0;
+        if (!binary_frame::cobs_decode(frame, received, length) || !binary_frame::crc_ok(frame, length) ||
+            length < HEADER_SIZE + binary_frame::CRC_SIZE) {
+            count_bad_frame();
+            return;
+        }
+        const std::uint8_t type = frame[0];
+        const std::uint8_t seq = frame[1];
+        const std::size_t body_length = length - HEADER_SIZE - binary_frame::CRC_SIZE;
+        switch (type) {
+            case LED_COMMAND:
+                reply(type, seq, led_command(frame + HEADER_SIZE, body_length));
+                break;
+            case STATUS:
+                if (body_length == 0) {
+                    reply_status(seq);
+                } else {
+                    reply(type, seq, BAD_LENGTH);
+                }
+                break;
+            case SUBSCRIBE:
+                reply(type, seq, subscribe(frame + HEADER_SIZE, body_length));
+                break;
+            case PROGRAM_WRITE:
+            case PROGRAM_COMMIT:
+                reply(type, seq, program(type, frame + HEADER_SIZE, body_length));
+                break;
+            case LOG_READ:
+                if (body_length == 4) {
+                    reply_log(seq, binary_frame::read_le32(frame + HEADER_SIZE));
+                } else {
+                    reply(type, seq, BAD_LENGTH);
+                }
+                break;
+            case WATCH_LIST:
+            case WATCH_READ:
+            case WATCH_WRITE:
+            case WATCH_SAMPLE:
+                reply_watch(type, seq, frame + HEADER_SIZE, body_length);
+                break;
+            case RECIPE_WRITE:
+            case RECIPE_CONTROL:
+                reply(type, seq, recipe_request(type, frame + HEADER_SIZE, body_length));
+                break;
+            case ALARM_READ:
+                if (body_length == 3) {
+                    reply_alarms(seq, binary_frame::read_le16(frame + HEADER_SIZE), frame[HEADER_SIZE + 2]);
+                } else {
+                    reply(type, seq, BAD_LENGTH);
+                }
+                break;
+            case ALARM_ACK:
+                reply(type, seq, alarm_ack(frame + HEADER_SIZE, body_length));
+                break;
+            default:
+                reply(type, seq, UNKNOWN_TYPE);
+                break;
+        }
+    }
+
+    Result led_command(const std::uint8_t* body, std::size_t length) {
+        if (length != 6) {
+            return BAD_LENGTH;
+        }
+        if (body[0] > LedCommandEvent::SET_INTERVAL) {
+            return BAD_ACTION;
+        }
+        if (!outputs.contains(body[1])) {
+            return BAD_INDEX;
+        }
+        const LedCommandEvent evt{body[1], static_cast<LedCommandEvent::Type>(body[0]),
+                                  binary_frame::read_le32(body + 2)};
+        led_command_out(evt);
+        return OK;
+    }
+
+    Result subscribe(const std::uint8_t* body, std::size_t length) {
+        if (length != 3) {
+            return BAD_LENGTH;
+        }
+        if (body[0] > TelemetrySubscribeEvent::ON_CHANGE) {
+            return BAD_ACTION;
+        }
+        const TelemetrySubscribeEvent evt{static_cast<TelemetrySubscribeEvent::Mode>(body[0]),
+                                          binary_frame::read_le16(body + 1), &frame_out, &output_ready};
+        if (evt.mode != TelemetrySubscribeEvent::OFF && evt.period_ms < MIN_TELEMETRY_PERIOD_MS) {
+            return BAD_PERIOD;
+        }
+        subscribe_out(evt);
+        return OK;
+    }
+
+    Result program(std::uint8_t type, const std::uint8_t* body, std::size_t length) {
+        logic_vm::ProgramEvent::Status status = logic_vm::ProgramEvent::UNHANDLED;
+        if (type == PROGRAM_COMMIT) {
+            if (length != 0) {
+                return BAD_LENGTH;
+            }
+            program_out(logic_vm::ProgramEvent{logic_vm::ProgramEvent::COMMIT, 0, nullptr, 0, &status});
+        } else {
+            if (length < 3 || length > 2U + logic_vm::CHUNK_SIZE) {
+                return BAD_LENGTH;
+            }
+            program_out(logic_vm::ProgramEvent{logic_vm::ProgramEvent::WRITE, binary_frame::read_le16(body), body + 2,
+                                               static_cast<std::uint8_t>(length - 2U), &status});
+        }
+        switch (status) {
+            case logic_vm::ProgramEvent::OK: return OK;
+            case logic_vm::ProgramEvent::BUSY: return BUSY;
+            case logic_vm::ProgramEvent::BAD_OFFSET: return BAD_INDEX;
+            case logic_vm::ProgramEvent::BAD_PROGRAM: return BAD_PROGRAM;
+            default: return UNKNOWN_TYPE;
+        }
+    }
+
+    Result recipe_request(std::uint8_t type, const std::uint8_t* body, std::size_t length) {
+        recipe::RequestEvent::Status status = recipe::RequestEvent::UNHANDLED;
+        if (type == RECIPE_CONTROL) {
+            if (length != 2) {
+                return BAD_LENGTH;
+            }
+            if (body[0] < recipe::RequestEvent::SWITCH || body[0] > recipe::RequestEvent::DISCARD) {
+                return BAD_ACTION;
+            }
+            recipe_out(recipe::RequestEvent{static_cast<recipe::RequestEvent::Action>(body[0]), 0, nullptr, 0, body[1],
+                                            &status});
+        } else {
+            if (length < 3 || length > 2U + recipe::CHUNK_SIZE) {
+                return BAD_LENGTH;
+            }
+            recipe_out(recipe::RequestEvent{recipe::RequestEvent::WRITE, binary_frame::read_le16(body), body + 2,
+                                            static_cast<std::uint8_t>(length - 2U), 0, &status});
+        }
+        switch (status) {
+            case recipe::RequestEvent::OK: return OK;
+            case recipe::RequestEvent::BUSY: return BUSY;
+            case recipe::RequestEvent::BAD_OFFSET:
+            case recipe::RequestEvent::BAD_SLOT: return BAD_INDEX;
+            case recipe::RequestEvent::BAD_ACTION: return BAD_ACTION;
+            case recipe::RequestEvent::BAD_RECIPE: return BAD_RECIPE;
+            default: return UNKNOWN_TYPE;
+        }
+    }
+
+    Result alarm_ack(const std::uint8_t* body, std::size_t length) {
+        if (length != 1) {
+            return BAD_LENGTH;
+        }
+        bool handled = false;
+        alarm_ack_out(alarms::AckEvent{body[0], &handled});
+        return handled ? OK : UNKNOWN_TYPE;
+    }
+
+    void reply(std::uint8_t type, std::uint8_t seq, Result result) {
+        std::uint8_t payload[3 + binary_frame::CRC_SIZE] = {static_cast<std::uint8_t>(type | REPLY), seq, result};
+        send(payload, 3);
+    }
+
+    void reply_status(std::uint8_t seq) {
+        std::uint8_t payload[MAX_REPLY];
+        const std::uint8_t count = (outputs.size() < MAX_STATUS_OUTPUTS) ? outputs.size() : MAX_STATUS_OUTPUTS;
+        payload[0] = STATUS | REPLY;
+        payload[1] = seq;
+        payload[2] = OK;
+        payload[3] = count;
+        std::size_t n = 4;
+        for (std::uint8_t i = 0; i < count; ++i, n += 6) {
+            const led::OutputRef output = outputs.at(i);
+            payload[n] = output.state_id();
+            payload[n + 1] = output.pin();
+            binary_frame::write_le32(payload + n + 2, output.blink_interval_ms());
+        }
+        send(payload, n);
+    }
+
+    void reply_log(std::uint8_t seq, std::uint32_t from) {
+        std::uint8_t payload[MAX_REPLY];
+        event_log::ReadEvent::Reply result;
+        log_read_out(event_log::ReadEvent{from, payload + 12, MAX_LOG_RECORDS, &result});
+        if (!result.handled) {
+            reply(LOG_READ, seq, UNKNOWN_TYPE);
+            return;
+        }
+        payload[0] = LOG_READ | REPLY;
+        payload[1] = seq;
+        payload[2] = OK;
+        binary_frame::write_le32(payload + 3, result.next);
+        binary_frame::write_le32(payload + 7, result.first);
+        payload[11] = result.count;
+        send(payload, 12U + event_log::RECORD_SIZE * result.count);
+    }
+
+    void reply_alarms(std::uint8_t seq, std::uint16_t since, std::uint8_t flags) {
+        std::uint8_t payload[MAX_REPLY];
+        alarms::ReadEvent::Reply result;
+        alarm_read_out(alarms::ReadEvent{since, flags, payload + 7, MAX_ALARM_RECORDS, &result});
+        if (!result.handled) {
+            reply(ALARM_READ, seq, UNKNOWN_TYPE);
+            return;
+        }
+        payload[0] = ALARM_READ | REPLY;
+        payload[1] = seq;
+        payload[2] = OK;
+        binary_frame::write_le16(payload + 3, result.result.next);
+        payload[5] = result.result.flags;
+        payload[6] = result.result.count;
+        send(payload, 7U + alarms::RECORD_SIZE * result.result.count);
+    }
+
+    void reply_watch(std::uint8_t type, std::uint8_t seq, const std::uint8_t* body, std::size_t length) {
+        if (length > watch::MAX_REQUEST + 2U) {
+            reply(type, seq, BAD_LENGTH);
+            return;
+        }
+        std::uint8_t payload[MAX_REPLY];
+        watch::RequestEvent::Reply result;
+        const auto kind = static_cast<watch::RequestEvent::Kind>(type - WATCH_LIST);
+        watch_out(watch::RequestEvent{kind, body, static_cast<std::uint8_t>(length), payload + 3, &result, &frame_out,
+                                      &output_ready});
+        switch (result.status) {
+            case watch::RequestEvent::OK: break;
+            case watch::RequestEvent::BAD_LENGTH: reply(type, seq, BAD_LENGTH); return;
+            case watch::RequestEvent::BAD_INDEX: reply(type, seq, BAD_INDEX); return;
+            case watch::RequestEvent::BAD_PERIOD: reply(type, seq, BAD_PERIOD); return;
+            case watch::RequestEvent::NOT_WRITABLE: reply(type, seq, NOT_WRITABLE); return;
+            default: reply(type, seq, UNKNOWN_TYPE); return;
+        }
+        payload[0] = static_cast<std::uint8_t>(type | REPLY);
+        payload[1] = seq;
+        payload[2] = OK;
+        send(payload, 3U + result.length);
+    }
+
+    // `payload` has room for the CRC
+    void send(std::uint8_t* payload, std::size_t length) {
+        length = binary_frame::append_crc(payload, length);
+        std::uint8_t wire[binary_frame::max_frame(MAX_REPLY)];
+        frame_out(ramen::Span<const std::uint8_t>(wire, binary_frame::encode_frame(payload, length, wire)));
+    }
+};
+
+// Telemetry for host software: while subscribed (BinaryEndpointActor's SUBSCRIBE request), a compact frame with the
+// state of every output, instead of a 'status' round trip and a text line per output. The frame is a binary_frame
+// payload of its own type, not a reply:
+//
+//     50 seq flags count states[(count + 3) / 4] faults[(count + 7) / 8] {interval:u32}*count
+//
+// `states` holds the led::state_id of output i in bits 2*(i%4) of byte i/4, `faults` output i's fault() in bit i%8 of
+// byte i/8; `seq` counts the frames sent, so the host sees the ones it missed. With 3 outputs, a frame is 23 bytes on
+// the wire. With -D SCAN_MONITOR the SCAN flag is set and the body is followed by the scan figures (see
+// scan_monitor.hpp), which do not count as a change: {max_us:u32 avg_us:u16 busy_permille:u16}, avg_us saturated. A
+// TimerActor timer ticks every period: PERIODIC sends a frame on every tick, ON_CHANGE only if the frame would differ
+// from the last one sent (the first is always sent). The output is polled first and a frame that does not fit right
+// away is skipped instead of waiting, as the next one supersedes it; ON_CHANGE then retries on the next tick. The
+// frames go out through the endpoint that subscribed last, so a subscription over another transport takes them over.
+// The timer ports are wired by the owner, e.g. SerialCommandSystem::attach_timer().
+class TelemetryActor {
+public:
+    static constexpr std::uint8_t FRAME_TYPE = 0x50;
+    static constexpr std::uint8_t MAX_OUTPUTS = 8;
+
+    enum Flags : std::uint8_t {
+        CHANGED = 0x01,         // The frame differs from the one before
+        SKIPPED = 0x02,         // Frames were skipped for lack of room in the output since the one before
+        OUTPUT_DROPPED = 0x04,  // Other output was dropped since the frame before (see serial_port::Overflow)
+        SCAN = 0x08             // The scan figures follow the body
+    };
+
+    explicit TelemetryActor(const led::OutputTable& output_table) :
+        event_handler_in([this](const BaseEvent& event) {
+            EventRouter<AppEvents, TelemetryActor, TickEvent>::dispatch(*this, event);
+        }),
+        outputs(output_table)
+    {
+        timeout_event_relay_out >> event_handler_in;
+    }
+    TelemetryActor(const TelemetryActor&) = delete;
+    TelemetryActor& operator=(const TelemetryActor&) = delete;
+
+    // Input: subscriptions; OFF stops the frames
+    ramen::Pushable<TelemetrySubscribeEvent> subscribe_in =
+        [this](const TelemetrySubscribeEvent& evt) {
+            mode_ = evt.mode;
+            frame_out_ = evt.frame_out;
+            output_ready_ = evt.output_ready;
+            last_length_ = 0;  // The first frame goes out in either mode
+            if (mode_ == TelemetrySubscribeEvent::OFF) {
+                disarm_timer();
+            } else {
+                ArmTimerEvt arm(evt.period_ms, &timeout_event_relay_out, true, &timer_handle_);
+                arm_timer_request_out(arm);
+            }
+        };
+
+    // Routed from event_handler_in
+    void on_event(const TickEvent&) {
+        std::uint8_t payload[HEADER_SIZE + MAX_BODY + SCAN_SIZE + binary_frame::CRC_SIZE];
+        const std::uint8_t length = snapshot(payload + HEADER_SIZE);
+        const bool changed = length != last_length_ || std::memcmp(payload + HEADER_SIZE, last_, length) != 0;
+        if (mode_ == TelemetrySubscribeEvent::OFF || frame_out_ == nullptr ||
+            (mode_ == TelemetrySubscribeEvent::ON_CHANGE && !changed)) {
+            return;
+        }
+        bool ready = true;  // Unlinked: always
+        if (output_ready_ != nullptr) {
+            (*output_ready_)(ready);
+        }
+        if (!ready) {
+            skipped_ = true;
+            return;
+        }
+        payload[0] = FRAME_TYPE;
+        payload[1] = seq_++;
+        payload[2] = static_cast<std::uint8_t>((changed ? CHANGED : 0) | (skipped_ ? SKIPPED : 0) |
+                                               (serial_port::dropped_messages != dropped_seen_ ? OUTPUT_DROPPED : 0) |
+                                               (scan_monitor::ENABLED ? SCAN : 0));
+        std::memcpy(last_, payload + HEADER_SIZE, length);
+        last_length_ = length;
+        skipped_ = false;
+        dropped_seen_ = serial_port::dropped_messages;
+
+        std::size_t n = HEADER_SIZE + length;
+        if (scan_monitor::ENABLED) {
+            const scan_monitor::Stats& scan = scan_monitor::stats();
+            binary_frame::write_le32(payload + n, scan.max_us);
+            binary_frame::write_le16(payload + n + 4, static_cast<std::uint16_t>(
+                                                          (scan.avg_us > UINT16_MAX) ? UINT16_MAX : scan.avg_us));
+            binary_frame::write_le16(payload + n + 6, scan.busy_permille);
+            n += SCAN_SIZE;
+        }
+        n = binary_frame::append_crc(payload, n);
+        std::uint8_t wire[binary_frame::max_frame(sizeof(payload))];
+        (*frame_out_)(ramen::Span<const std::uint8_t>(wire, binary_frame::encode_frame(payload, n, wire)));
+    }
+
+    ramen::Pushable<const BaseEvent&> event_handler_in;
+
+    // Timer requests, for a TimerActor
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+
+private:
+    static constexpr std::size_t HEADER_SIZE = 3;  // Type, sequence number and flags
+    static constexpr std::size_t MAX_BODY = 1 + (MAX_OUTPUTS + 3) / 4 + (MAX_OUTPUTS + 7) / 8 + 4 * MAX_OUTPUTS;
+    static constexpr std::size_t SCAN_SIZE = scan_monitor::ENABLED ? 8 : 0;
+
+    const led::OutputTable& outputs;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    TimerHandle timer_handle_;
+    TelemetrySubscribeEvent::Mode mode_ = TelemetrySubscribeEvent::OFF;
+    ramen::Pusher<ramen::Span<const std::uint8_t>>* frame_out_ = nullptr;  // Of the subscribed endpoint
+    ramen::Puller<bool>* output_ready_ = nullptr;
+    std::uint8_t seq_ = 0;
+    bool skipped_ = false;
+    std::uint16_t dropped_seen_ = 0;
+    std::uint8_t last_[MAX_BODY];  // Body of the last frame sent, for ON_CHANGE and CHANGED
+    std::uint8_t last_length_ = 0;  // 0: none sent since subscribing
+
+    // Writes the body of a frame for the current state of the outputs and returns its length
+    std::uint8_t snapshot(std::uint8_t* body) const {
+        const std::uint8_t count = (outputs.size() < MAX_OUTPUTS) ? outputs.size() : MAX_OUTPUTS;
+        std::uint8_t* const states = body + 1;
+        std::uint8_t* const faults = states + (count + 3U) / 4U;
+        std::uint8_t* interval = faults + (count + 7U) / 8U;
+        body[0] = count;
+        std::memset(states, 0, static_cast<std::size_t>(interval - states));
+        for (std::uint8_t i = 0; i < count; ++i, interval += 4) {
+            const led::OutputRef output = outputs.at(i);
+            const unsigned state = output.state_id() & 0x03U;
+            states[i / 4U] = static_cast<std::uint8_t>(states[i / 4U] | (state << (2U * (i % 4U))));
+            if (output.fault()) {
+                faults[i / 8U] = static_cast<std::uint8_t>(faults[i / 8U] | (1U << (i % 8U)));
+            }
+            binary_frame::write_le32(interval, output.blink_interval_ms());
+        }
+        return static_cast<std::uint8_t>(interval - body);
+    }
+
+    void disarm_timer() {
+        if (timer_handle_.valid()) {
+            DisarmTimerEvt evt(timer_handle_);
+            disarm_timer_request_out(evt);
+            timer_handle_ = TimerHandle{};
+        }
+    }
+};
+
+// "LED<index + 1>" followed by `what` for each index, padded to Size characters; built at compile time
+template <std::size_t Size, std::size_t N, std::size_t... I>
+constexpr std::array<ramen::FixedString<Size>, sizeof...(I)> default_name_messages(const ramen::FixedString<N>& what,
+                                                                                   std::index_sequence<I...>) {
+    return {{(ramen::fixed_string("LED") + ramen::to_fixed_string<I + 1>() + what).template pad<Size>()...}};
+}
+
+// Applies LED commands to the outputs of the registry. A single command on one output is answered as before, e.g.
+// "LED1 started"; a batch or a command on several outputs gets a single summary line
+class LedExecutorActor {
+private:
+    const led::OutputTable& outputs;
+
+    // The start and stop answers of outputs with the default names, as constant text in flash; one per digital output
+    // of a Controllino MAXI, beyond which they are formatted like the others
+    static constexpr std::uint8_t PRESET_OUTPUTS = 12;
+    static constexpr std::size_t PRESET_SIZE = 13;  // "LED12 started"
+    static constexpr auto STARTED_MESSAGES PROGMEM =
+        default_name_messages<PRESET_SIZE>(ramen::fixed_string(" started"), std::make_index_sequence<PRESET_OUTPUTS>{});
+    static constexpr auto STOPPED_MESSAGES PROGMEM =
+        default_name_messages<PRESET_SIZE>(ramen::fixed_string(" stopped"), std::make_index_sequence<PRESET_OUTPUTS>{});
+
+    // Answers with the preset message of an output if it has one, or else its name and `what`
+    template <std::size_t N>
+    void respond_preset(const std::array<ramen::FixedString<PRESET_SIZE>, N>& presets, std::uint8_t id,
+                        const char* what) {
+        if (!outputs.named() && id < N) {
+            flash_response_out(reinterpret_cast<const __FlashStringHelper*>(presets[id].c_str()));
+        } else {
+            respond(id, what);
+        }
+    }
+
+    template <class... What>
+    void respond(std::uint8_t id, const What&... what) {
+        fmt::Line<48> msg;
+        outputs.write_name(msg, id);
+        fmt::write(msg, ' ', what...);
+        response_out(msg.c_str());
+    }
+
+    // Applies `evt` to each of its outputs and returns how many there were, or 0 if any is not in the registry
+    std::uint8_t apply(const LedCommandEvent& evt) {
+        const std::uint16_t end = (evt.count == LedCommandEvent::ALL) ? outputs.size() : evt.led_id + evt.count;
+        if (!outputs.contains(evt.led_id) || end > outputs.size()) {
+            return 0;
+        }
+        for (std::uint8_t i = evt.led_id; i < end; ++i) {
+            const led::OutputRef output = outputs.at(i);
+            switch (evt.type) {
+                case LedCommandEvent::START:
+                    output.start();
+                    break;
+                case LedCommandEvent::STOP:
+                    output.stop();
+                    break;
+                case LedCommandEvent::SET_INTERVAL:
+                    output.set_blink_interval(evt.interval_ms);
+                    break;
+            }
+        }
+        return static_cast<std::uint8_t>(end - evt.led_id);
+    }
+
+    void report_invalid() {
+        if (message_log::ENABLED) {
+            message_log::write<message_log::INVALID_LED_ID>(record_out);
+        } else {
+            flash_response_out(F("Invalid LED ID"));
+        }
+    }
+
+    void report(const LedCommandEvent& evt) {
+        switch (evt.type) {
+            case LedCommandEvent::START:
+                if (message_log::ENABLED) {
+                    message_log::write<message_log::LED_STARTED>(record_out, evt.led_id);
+                } else {
+                    respond_preset(STARTED_MESSAGES, evt.led_id, "started");
+                }
+                break;
+
+            case LedCommandEvent::STOP:
+                if (message_log::ENABLED) {
+                    message_log::write<message_log::LED_STOPPED>(record_out, evt.led_id);
+                } else {
+                    respond_preset(STOPPED_MESSAGES, evt.led_id, "stopped");
+                }
+                break;
+
+            case LedCommandEvent::SET_INTERVAL:
+                if (message_log::ENABLED) {
+                    message_log::write<message_log::LED_INTERVAL_SET>(record_out, evt.led_id, evt.interval_ms);
+                } else {
+                    respond(evt.led_id, "interval set to ", evt.interval_ms, "ms");
+                }
+                break;
+        }
+    }
+
+    void report_summary(std::uint8_t done, std::uint8_t total, std::uint16_t updated) {
+        if (message_log::ENABLED) {
+            if (done == total) {
+                message_log::write<message_log::BATCH_DONE>(record_out, done, total, updated);
+            } else {
+                message_log::write<message_log::BATCH_PARTIAL>(record_out, done, total, updated);
+            }
+            return;
+        }
+        fmt::Line<80> msg;
+        fmt::write(msg, "Commands done: ", done, " of ", total, ", outputs updated: ", updated);
+        if (done < total) {
+            fmt::write(msg, F(" (invalid LED IDs in the others)"));
+        }
+        response_out(msg.c_str());
+    }
+
+    void execute(const ramen::Span<const LedCommandEvent>& commands) {
+        std::uint8_t done = 0;
+        std::uint16_t updated = 0;
+        for (const LedCommandEvent& evt : commands) {
+            const std::uint8_t applied = apply(evt);
+            if (applied > 0) {
+                ++done;
+                updated = static_cast<std::uint16_t>(updated + applied);
+            }
+        }
+        if (commands.len == 1) {
+            if (done == 0) {
+                report_invalid();
+                return;
+            }
+            if (commands.ptr[0].count == 1) {
+                report(commands.ptr[0]);
+                return;
+            }
+        }
+        report_summary(done, static_cast<std::uint8_t>(commands.len), updated);
+    }
+
+public:
+    explicit LedExecutorActor(const led::OutputTable& output_table) : outputs(output_table) {}
+    
+    // Input: LED commands to execute
+    ramen::Pushable<LedCommandEvent> command_in = 
+        [this](const LedCommandEvent& evt) {
+            execute(ramen::Span<const LedCommandEvent>(&evt, 1));
+        };
+
+    // Input: the LED commands of a line, applied in order
+    ramen::Pushable<LedBatchEvent> batch_in =
+        [this](const LedBatchEvent& batch) {
+            execute(batch.commands);
+        };
+    
+    // Output: response messages, formatted in RAM or constant in flash, or as records (see message_log.hpp)
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;
+    ramen::Pusher<ramen::Span<const std::uint8_t>> record_out;
+};
+
+class StatusReporterActor {
+private:
+    const led::OutputTable& outputs;
+
+public:
+    explicit StatusReporterActor(const led::OutputTable& output_table) : outputs(output_table) {}
+    
+    ramen::Pushable<StatusRequestEvent> request_in = 
+        [this](const StatusRequestEvent&) {
+            flash_response_out(F("LED Status:"));
+            for (std::uint8_t i = 0; i < outputs.size(); i++) {
+                const led::OutputRef output = outputs.at(i);
+                fmt::Line<80> msg;
+                fmt::write(msg, "  ");
+                outputs.write_name(msg, i);
+                fmt::write(msg, ": Pin D", output.pin(), ", Interval: ", output.blink_interval_ms(), "ms, State: ",
+                           fmt::flash(led::state_name_P(output.state_id())));
+                response_out(msg.c_str());
+            }
+        };
+    
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
+
+// Besides the dispatch depth and the stack, 'stats' lists the watched counters: the sent() counts of chosen ports and
+// the counts of requests an actor rejected, e.g. the arm requests TimerActor found no free slot for (see watch()).
+class StatsReporterActor {
+public:
+    static constexpr std::uint8_t MAX_COUNTERS = 12;
+
+    // Lists a 16-bit counter under a name, e.g. watch(F("led1 timer arms"), led1.arm_timer_request_out.sent_counter());
+    // false once MAX_COUNTERS are watched
+    bool watch(const __FlashStringHelper* name, const std::uint16_t& count) {
+        return counters_.push_back(Counter{name, &count});
+    }
+
+    ramen::Pushable<StatsRequestEvent> request_in =
+        [this](const StatsRequestEvent&) {
+            fmt::Line<64> msg;
+            if (ramen::dispatch_stats_enabled) {
+                fmt::write(msg, "Dispatch depth: ", static_cast<unsigned>(ramen::dispatch_depth()),
+                           " (max ", static_cast<unsigned>(ramen::max_dispatch_depth()), ')');
+                response_out(msg.c_str());
+            } else {
+                flash_response_out(F("Dispatch depth: disabled (build with -D RAMEN_CFG_DISPATCH_STATS)"));
+            }
+            msg.clear();
+            fmt::write(msg, "Stack free: ", static_cast<unsigned>(stack_monitor::free_now()), " bytes now, ",
+                       static_cast<unsigned>(stack_monitor::unused()), " bytes min");
+            response_out(msg.c_str());
+            if (serial_port::ENABLED) {
+                msg.clear();
+                fmt::write(msg, "Serial TX: ", serial_port::tx_free(), " bytes free, ", serial_port::dropped_messages,
+                           " lines dropped");
+                response_out(msg.c_str());
+            }
+            if (!counters_.empty()) {
+                flash_response_out(F("Counts:"));
+            }
+            for (const Counter& c : counters_) {
+                msg.clear();
+                fmt::write(msg, "  ", c.name, ": ", *c.count, (*c.count == UINT16_MAX) ? "+" : "");
+                response_out(msg.c_str());
+            }
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+
+private:
+    struct Counter {
+        const __FlashStringHelper* name;
+        const std::uint16_t* count;
+    };
+    ramen::StaticVector<Counter, MAX_COUNTERS> counters_;
+};
+
+class MemReporterActor {
+public:
+    ramen::Pushable<MemRequestEvent> request_in =
+        [this](const MemRequestEvent&) {
+            fmt::Line<64> msg;
+            if (heap_monitor::ENABLED) {
+                fmt::write(msg, "Heap: ", heap_monitor::current_bytes(), " bytes in ", heap_monitor::live_blocks(),
+                           " blocks, ", heap_monitor::peak_bytes(), " peak");
+                response_out(msg.c_str());
+                msg.clear();
+                fmt::write(msg, "Allocations: ", heap_monitor::allocations(), ", ", heap_monitor::late_allocations(),
+                           " after setup");
+                response_out(msg.c_str());
+            } else {
+                flash_response_out(F("Heap counts: disabled (build with -D HEAP_MONITOR)"));
+            }
+            msg.clear();
+            fmt::write(msg, "Free list: ", heap_monitor::free_list_bytes(), " bytes in ",
+                       heap_monitor::free_list_blocks(), " blocks");
+            response_out(msg.c_str());
+            msg.clear();
+            fmt::write(msg, "Largest free block: ", heap_monitor::largest_free_block(), " bytes");
+            response_out(msg.c_str());
+            msg.clear();
+            fmt::write(msg, "Heap-stack gap: ", stack_monitor::free_now(), " bytes now, ", stack_monitor::unused(),
+                       " bytes min");
+            response_out(msg.c_str());
+            if (xmem::ENABLED) {
+                msg.clear();
+                fmt::write(msg, "XMEM: ", xmem::used(), " of ", xmem::SIZE, " bytes, ", xmem::spilled(), " spilled",
+                           xmem::test() ? "" : " (no RAM found)");
+                response_out(msg.c_str());
+            }
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
+
+class ProfileReporterActor {
+public:
+    ramen::Pushable<ProfileRequestEvent> request_in =
+        [this](const ProfileRequestEvent& evt) {
+            if (!port_profiler::ENABLED) {
+                flash_response_out(F("Profiler disabled (build with -D RAMEN_CFG_DISPATCH_HOOKS)"));
+                return;
+            }
+            if (evt.reset) {
+                port_profiler::profiler.reset();
+                flash_response_out(F("Profile reset"));
+                return;
+            }
+            flash_response_out(F("Port      Calls   Min     Avg     Max (cycles)"));
+            for (const port_profiler::Entry& e : port_profiler::profiler.entries()) {
+                if (e.port == nullptr) {
+                    break;
+                }
+                fmt::Line<64> msg;
+                const auto address = static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(e.port));
+                fmt::write(msg, "  0x", fmt::hex(address, 4),
+                           "  ", fmt::left(static_cast<unsigned>(e.count), 7),
+                           ' ', fmt::left(static_cast<unsigned long>(e.min_cycles), 7),
+                           ' ', fmt::left(static_cast<unsigned long>(e.avg_cycles()), 7),
+                           ' ', static_cast<unsigned long>(e.max_cycles));
+                response_out(msg.c_str());
+            }
+            if (port_profiler::profiler.overflowed() > 0) {
+                fmt::Line<48> msg;
+                fmt::write(msg, "  ", static_cast<unsigned>(port_profiler::profiler.overflowed()),
+                           " dispatches of untracked ports");
+                response_out(msg.c_str());
+            }
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
+
+class FsmBenchActor {
+public:
+    ramen::Pushable<FsmBenchRequestEvent> request_in =
+        [this](const FsmBenchRequestEvent&) {
+            fsm_benchmark::run(response_out, flash_response_out);
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
+
+class HashBenchActor {
+public:
+    ramen::Pushable<HashBenchRequestEvent> request_in =
+        [this](const HashBenchRequestEvent&) {
+            hash_benchmark::run(response_out, flash_response_out);
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
+
+class TraceReporterActor {
+public:
+    ramen::Pushable<TraceRequestEvent> request_in =
+        [this](const TraceRequestEvent& evt) {
+#if defined(SML_TRACE)
+            if (evt.clear) {
+                sml_trace::clear();
+                flash_response_out(F("Trace cleared"));
+                return;
+            }
+            fmt::Line<48> msg;
+            fmt::write(msg, "Transitions: ", static_cast<unsigned>(sml_trace::records.size()),
+                       " (", static_cast<unsigned>(sml_trace::overwritten), " overwritten)");
+            response_out(msg.c_str());
+            flash_response_out(F("  Time(ms)    SM  Event  Src->Dst"));
+            for (std::size_t i = 0; i < sml_trace::records.size(); ++i) {
+                const sml_trace::Record& r = sml_trace::records[static_cast<decltype(sml_trace::records)::size_type>(i)];
+                msg.clear();
+                fmt::write(msg, "  ", fmt::left(static_cast<unsigned long>(r.timestamp_ms), 10),
+                           "  ", fmt::left(static_cast<unsigned>(r.sm_id), 3),
+                           ' ', fmt::left(static_cast<unsigned>(r.event_id), 5),
+                           "  ", static_cast<unsigned>(r.src_state), "->", static_cast<unsigned>(r.dst_state));
+                response_out(msg.c_str());
+            }
+#else
+            (void)evt;
+            flash_response_out(F("Trace disabled (build with -D SML_TRACE)"));
+#endif
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
+
+// Prints the port trace for tools/port_trace_export.py: a header, then a record per line, oldest first:
+//
+//     Port trace: <records> records, <overwritten> overwritten, <cycles per us> cycles/us
+//     @ <cycles> <kind letter> <port address in hex> <payload size>
+class PortTraceReporterActor {
+public:
+    ramen::Pushable<PortTraceRequestEvent> request_in =
+        [this](const PortTraceRequestEvent& evt) {
+#if defined(PORT_TRACE)
+            const port_trace::Pause pause;
+            if (evt.clear) {
+                port_trace::clear();
+                flash_response_out(F("Port trace cleared"));
+                return;
+            }
+            fmt::Line<64> msg;
+            fmt::write(msg, "Port trace: ", static_cast<unsigned>(port_trace::records.size()), " records, ",
+                       static_cast<unsigned>(port_trace::overwritten), " overwritten, ",
+                       static_cast<unsigned long>(cycle_counter::CYCLES_PER_US), " cycles/us");
+            response_out(msg.c_str());
+            for (std::size_t i = 0; i < port_trace::records.size(); ++i) {
+                using Index = std::remove_reference_t<decltype(port_trace::records)>::size_type;
+                const port_trace::Record& r = port_trace::records[static_cast<Index>(i)];
+                msg.clear();
+                fmt::write(msg, "@ ", static_cast<unsigned long>(r.cycles), ' ', static_cast<char>(r.kind), ' ',
+                           fmt::hex(static_cast<std::uint32_t>(r.port), 4), ' ', static_cast<unsigned>(r.payload_size));
+                response_out(msg.c_str());
+            }
+#else
+            (void)evt;
+            flash_response_out(F("Port trace disabled (build with -D PORT_TRACE -D RAMEN_CFG_DISPATCH_HOOKS)"));
+#endif
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
+
+class LatencyReporterActor {
+public:
+    timer_latency::Report report;  // Set through SerialCommandSystem::attach_timer_latency()
+
+    ramen::Pushable<LatencyRequestEvent> request_in =
+        [this](const LatencyRequestEvent& evt) {
+            if (!timer_latency::ENABLED || !report.attached()) {
+                flash_response_out(F("Timer latency disabled (build with -D TIMER_LATENCY_STATS)"));
+                return;
+            }
+            if (evt.reset) {
+                report.reset();
+                flash_response_out(F("Timer latency reset"));
+                return;
+            }
+            flash_response_out(F("Late by (ms)  Expiries"));
+            fmt::Line<48> msg;
+            for (std::uint8_t i = 0; i < timer_latency::BUCKETS; ++i) {
+                const std::uint16_t count = report.histogram->counts[i];
+                if (count == 0) {
+                    continue;
+                }
+                const unsigned long floor = timer_latency::Histogram::bucket_floor(i);
+                msg.clear();
+                fmt::write(msg, "  ", floor);
+                if (i == timer_latency::BUCKETS - 1U) {
+                    fmt::write(msg, '+');
+                } else if (floor > 1) {
+                    fmt::write(msg, '-', 2 * floor - 1);
+                }
+                msg.pad_to(13);
+                fmt::write(msg, ' ', static_cast<unsigned>(count));
+                response_out(msg.c_str());
+            }
+            for (std::uint8_t slot = 0; slot < report.slots; ++slot) {
+                msg.clear();
+                fmt::write(msg, "  Slot ", static_cast<unsigned>(slot), " max: ",
+                           static_cast<unsigned long>(report.slot_max[slot]), " ms");
+                response_out(msg.c_str());
+            }
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
 };
 
-struct StatusRequestEvent {};
-struct HelpRequestEvent {};
+class ScanReporterActor {
+    static constexpr std::size_t NAME_SIZE = 12;
+    static constexpr char STAGE_NAMES[scan_monitor::STAGE_COUNT][NAME_SIZE] PROGMEM = {
+        "modbus", "commander", "network", "config", "boot script", "logic", "timers",
+    };
 
-class SerialCollectorActor {
-private:
-    static constexpr std::size_t MAX_CMD_LENGTH = 64;
-    std::uint8_t buffer[MAX_CMD_LENGTH];
-    std::size_t pos = 0;
+public:
+    ramen::Pushable<ScanRequestEvent> request_in =
+        [this](const ScanRequestEvent& evt) {
+            if (!scan_monitor::ENABLED) {
+                flash_response_out(F("Scan monitor disabled (build with -D SCAN_MONITOR)"));
+                return;
+            }
+            if (evt.reset) {
+                scan_monitor::reset();
+                flash_response_out(F("Scan statistics reset"));
+                return;
+            }
+            const scan_monitor::Stats& s = scan_monitor::stats();
+            if (s.scans == 0) {
+                flash_response_out(F("No scans yet"));
+                return;
+            }
+            fmt::Line<72> msg;
+            fmt::write(msg, "Scans: ", static_cast<unsigned long>(s.scans), ", min ",
+                       static_cast<unsigned long>(s.min_us), " us, max ", static_cast<unsigned long>(s.max_us),
+                       " us, period max ", static_cast<unsigned long>(s.max_period_us), " us");
+            response_out(msg.c_str());
+            msg.clear();
+            if (s.window_done) {
+                fmt::write(msg, "Last second: avg ", static_cast<unsigned long>(s.avg_us), " us, CPU busy ",
+                           static_cast<unsigned>(s.busy_permille / 10U), '.',
+                           static_cast<unsigned>(s.busy_permille % 10U), '%');
+            } else {
+                fmt::write(msg, "Last second: not measured yet");
+            }
+            response_out(msg.c_str());
+            msg.clear();
+            fmt::write(msg, "Longest scan mostly in: ",
+                       reinterpret_cast<const __FlashStringHelper*>(STAGE_NAMES[s.slowest_stage]));
+            response_out(msg.c_str());
+
+            flash_response_out(F("Scan time (us)  Scans"));
+            for (std::uint8_t i = 0; i < timer_latency::BUCKETS; ++i) {
+                const std::uint16_t count = s.histogram.counts[i];
+                if (count == 0) {
+                    continue;
+                }
+                const unsigned long floor = timer_latency::Histogram::bucket_floor(i) * scan_monitor::BUCKET_US;
+                msg.clear();
+                fmt::write(msg, "  ", floor);
+                if (i == timer_latency::BUCKETS - 1U) {
+                    fmt::write(msg, '+');
+                } else {
+                    fmt::write(msg, '-', ((floor == 0) ? scan_monitor::BUCKET_US : 2 * floor) - 1);
+                }
+                msg.pad_to(15);
+                fmt::write(msg, ' ', static_cast<unsigned>(count));
+                response_out(msg.c_str());
+            }
+            for (std::uint8_t i = 0; i < scan_monitor::STAGE_COUNT; ++i) {
+                msg.clear();
+                fmt::write(msg, "  ", reinterpret_cast<const __FlashStringHelper*>(STAGE_NAMES[i]));
+                msg.pad_to(15);
+                fmt::write(msg, " max ", static_cast<unsigned long>(s.stage_max_us[i]), " us");
+                response_out(msg.c_str());
+            }
+        };
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+};
 
+class WatchdogReporterActor {
 public:
-    // Input: individual characters from serial
-    ramen::Pushable<SerialCharEvent> char_in = 
-        [this](const SerialCharEvent& evt) {
-            std::uint8_t c = evt.character;
-            
-            if (c == '\n' || c == '\r') {
-                if (pos > 0) {
-                    buffer[pos] = '\0';
-                    CommandLineEvent cmd_evt;
-                    // Copy as bytes, but treat as null-terminated string
-                    std::memcpy(cmd_evt.command_line, buffer, pos + 1);
-                    cmd_evt.length = pos;
-                    
-                    line_out(cmd_evt);
-                    pos = 0;
+    ramen::Pushable<WatchdogRequestEvent> request_in =
+        [this](const WatchdogRequestEvent& evt) {
+            if (!step_watchdog::ENABLED) {
+                flash_response_out(F("Step watchdog disabled (build with -D STEP_WATCHDOG)"));
+                return;
+            }
+            if (evt.clear) {
+                step_watchdog::clear();
+                flash_response_out(F("Overruns and the last reset cleared"));
+                return;
+            }
+            fmt::Line<72> msg;
+            if (step_watchdog::reset_by_watchdog()) {
+                const step_watchdog::ResetRecord& r = step_watchdog::last_reset();
+                fmt::write(msg, "Last reset: watchdog, in 0x", fmt::hex(static_cast<std::uint32_t>(r.running), 4));
+                if (r.late != 0) {
+                    fmt::write(msg, ", late 0x", fmt::hex(static_cast<std::uint32_t>(r.late), 4));
                 }
-            } else if (pos < MAX_CMD_LENGTH - 1) {
-                buffer[pos++] = c;
+                response_out(msg.c_str());
+                msg.clear();
+                fmt::write(msg, "  waiting for");
+                for (std::uint8_t i = 0; i < step_watchdog::critical_count(); ++i) {
+                    if ((r.waiting & (1U << i)) != 0) {
+                        const auto port = reinterpret_cast<std::uintptr_t>(step_watchdog::critical(i));
+                        fmt::write(msg, " 0x", fmt::hex(static_cast<std::uint32_t>(port), 4));
+                    }
+                }
+                response_out(msg.c_str());
+                report_dump(r);
             } else {
-                // Buffer overflow, reset
-                pos = 0;
+                flash_response_out(F("Last reset: not by the watchdog"));
+            }
+            msg.clear();
+            fmt::write(msg, "Reset cause: MCUSR 0x", fmt::hex(step_watchdog::reset_cause, 2));
+            response_out(msg.c_str());
+            msg.clear();
+            fmt::write(msg, "Watchdog: ", step_watchdog::TIMEOUT_MS, " ms, ",
+                       static_cast<unsigned>(step_watchdog::critical_count()), " critical actors");
+            response_out(msg.c_str());
+            msg.clear();
+            fmt::write(msg, "Overruns: ", step_watchdog::overrun_count(), ", default budget ",
+                       step_watchdog::DEFAULT_BUDGET_US, " us");
+            response_out(msg.c_str());
+            const auto& overruns = step_watchdog::overruns();
+            for (std::size_t i = 0; i < overruns.size(); ++i) {
+                const step_watchdog::Overrun& o = overruns[static_cast<decltype(overruns.size())>(i)];
+                msg.clear();
+                fmt::write(msg, "  0x", fmt::hex(static_cast<std::uint32_t>(o.port), 4), "  ",
+                           static_cast<unsigned long>(o.cycles / cycle_counter::CYCLES_PER_US), " us of ",
+                           o.budget_us, " us");
+                response_out(msg.c_str());
             }
         };
-    
-    // Output: complete command lines
-    ramen::Pusher<CommandLineEvent> line_out;
-};
 
-class CommandParserActor {
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+
 private:
-    bool parse_led_id(const std::uint8_t* str, std::uint8_t& led_id) {
-        while (*str == ' ' || *str == '\t') str++;
-        if (*str >= '1' && *str <= '3') {
-            led_id = *str - '1';
-            return true;
-        }
-        return false;
-    }
-    
-    bool parse_interval_command(const std::uint8_t* str, std::uint8_t& led_id, std::uint32_t& interval) {
-        // Skip whitespace
-        while (*str == ' ' || *str == '\t') str++;
-        
-        // Parse LED ID
-        if (*str < '1' || *str > '3') {
-            Serial.println("Debug: Invalid LED ID");
-            return false;
-        }
-        led_id = *str - '1';
-        str++;
-        
-        // Skip whitespace
-        while (*str == ' ' || *str == '\t') str++;
-        
-        // Parse interval - convert to char* for strtol
-        char* endptr;
-        long parsed_interval = std::strtol(reinterpret_cast<const char*>(str), &endptr, 10);
-        
-        // Check if parsing succeeded and value is in valid range
-        if (endptr == reinterpret_cast<const char*>(str)) {
-            return false;
+    // The crash dump: the interrupted address, the nesting, the last ports traced and the stack above the address
+    void report_dump(const step_watchdog::ResetRecord& r) {
+        fmt::Line<72> msg;
+        fmt::write(msg, "  pc 0x", fmt::hex(r.pc, 5), ", steps ", static_cast<unsigned>(r.step_depth),
+                   " deep, dispatch ", static_cast<unsigned>(r.dispatch_depth), " deep");
+        response_out(msg.c_str());
+        if (r.trace_count > 0) {
+            msg.clear();
+            fmt::write(msg, "  traced");
+            for (std::uint8_t i = 0; i < r.trace_count; ++i) {
+                fmt::write(msg, " 0x", fmt::hex(static_cast<std::uint32_t>(r.trace[i]), 4));
+            }
+            response_out(msg.c_str());
         }
-        
-        if (parsed_interval < 1 || parsed_interval > 60000) {  // 1ms to 60s range
-            return false;
+        msg.clear();
+        fmt::write(msg, "  stack 0x", fmt::hex(r.sp, 4), ":");
+        for (std::uint8_t i = 0; i < step_watchdog::STACK_BYTES; ++i) {
+            fmt::write(msg, " ", fmt::hex(r.stack[i], 2));
         }
-        
-        interval = static_cast<std::uint32_t>(parsed_interval);
-        return true;
+        response_out(msg.c_str());
     }
+};
 
+// Prints the input record for tools/input_record.py: a header, then the log in hex, 32 bytes per line:
+//
+//     Input record: <bytes> bytes, <lost> records lost, <ms> ms
+//     > <hex bytes>
+class RecordReporterActor {
 public:
-    // Input: command lines to parse
-    ramen::Pushable<CommandLineEvent> line_in = 
-        [this](const CommandLineEvent& evt) {
-            std::uint8_t lower_cmd[64];
-            std::memcpy(lower_cmd, evt.command_line, sizeof(lower_cmd));
-            
-            // Convert to lowercase
-            for (std::uint8_t* p = lower_cmd; *p; ++p) {
-                *p = static_cast<std::uint8_t>(std::tolower(*p));
-            }
-            
-            // Parse and route commands
-            if (std::strncmp(reinterpret_cast<const char*>(lower_cmd), "help", 4) == 0) {
-                help_request_out(HelpRequestEvent{});
-            }
-            else if (std::strncmp(reinterpret_cast<const char*>(lower_cmd), "status", 6) == 0) {
-                status_request_out(StatusRequestEvent{});
-            }
-            else if (std::strncmp(reinterpret_cast<const char*>(lower_cmd), "start", 5) == 0) {
-                std::uint8_t led_id;
-                if (parse_led_id(lower_cmd + 5, led_id)) {
-                    LedCommandEvent cmd{led_id, LedCommandEvent::START, 0};
-                    led_command_out(cmd);
-                } else {
-                    error_out("Invalid LED ID for start command");
-                }
+    static constexpr std::uint8_t BYTES_PER_LINE = 32;
+
+    ramen::Pushable<RecordRequestEvent> request_in =
+        [this](const RecordRequestEvent&) {
+            fmt::Line<72> msg;
+            if (input_record::REPLAY) {
+                fmt::write(msg, "Replay: ", input_record::replay_position(), " of ", input_record::replay_size(),
+                           " bytes", input_record::replay_done() ? ", done" : "");
+                response_out(msg.c_str());
+                msg.clear();
             }
-            else if (std::strncmp(reinterpret_cast<const char*>(lower_cmd), "stop", 4) == 0) {
-                std::uint8_t led_id;
-                if (parse_led_id(lower_cmd + 4, led_id)) {
-                    LedCommandEvent cmd{led_id, LedCommandEvent::STOP, 0};
-                    led_command_out(cmd);
-                } else {
-                    error_out("Invalid LED ID for stop command");
-                }
+            if (!input_record::ENABLED) {
+                flash_response_out(F("Input record disabled (build with -D INPUT_RECORD)"));
+                return;
             }
-            else if (std::strncmp(reinterpret_cast<const char*>(lower_cmd), "interval", 8) == 0) {
-                std::uint8_t led_id;
-                std::uint32_t interval;
-                
-                if (parse_interval_command(lower_cmd + 8, led_id, interval)) {
-                    LedCommandEvent cmd{led_id, LedCommandEvent::SET_INTERVAL, interval};
-                    led_command_out(cmd);
-                } else {
-                    error_out("Invalid format for interval command");
+            fmt::write(msg, "Input record: ", input_record::size(), " bytes, ", input_record::lost(),
+                       " records lost, ", static_cast<unsigned long>(input_record::duration_ms()), " ms");
+            response_out(msg.c_str());
+            for (std::uint16_t i = 0; i < input_record::size(); i = static_cast<std::uint16_t>(i + BYTES_PER_LINE)) {
+                msg.clear();
+                fmt::write(msg, "> ");
+                for (std::uint16_t j = i; j < input_record::size() && j < i + BYTES_PER_LINE; ++j) {
+                    fmt::write(msg, fmt::hex(input_record::at(j), 2));
                 }
-            }
-            else {
-                error_out("Unknown command. Type 'help' for usage.");
+                response_out(msg.c_str());
             }
         };
-    
-    // Outputs: parsed commands
-    ramen::Pusher<LedCommandEvent> led_command_out;
-    ramen::Pusher<HelpRequestEvent> help_request_out;
-    ramen::Pusher<StatusRequestEvent> status_request_out;
-    ramen::Pusher<const char*> error_out;
+
+    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
 };
 
-class LedExecutorActor {
-private:
-    led::BlinkyLedActor* leds[3];
-    const char* led_names[3] = {"LED1", "LED2", "LED3"};
+class BootProfileReporterActor {
+    static constexpr std::size_t NAME_SIZE = 14;
+    static constexpr char PHASE_NAMES[boot_profile::PHASE_COUNT][NAME_SIZE] PROGMEM = {
+        "constructors", "setup", "commander", "linked", "first timer",
+    };
 
 public:
-    LedExecutorActor(led::BlinkyLedActor& led1, 
-                    led::BlinkyLedActor& led2, 
-                    led::BlinkyLedActor& led3) {
-        leds[0] = &led1;
-        leds[1] = &led2;
-        leds[2] = &led3;
-    }
-    
-    // Input: LED commands to execute
-    ramen::Pushable<LedCommandEvent> command_in = 
-        [this](const LedCommandEvent& evt) {
-            if (evt.led_id >= 3) {
-                response_out("Invalid LED ID");
+    ramen::Pushable<BootProfileRequestEvent> request_in =
+        [this](const BootProfileRequestEvent&) {
+            if (!boot_profile::ENABLED) {
+                flash_response_out(F("Boot profile disabled (build with -D BOOT_PROFILE)"));
                 return;
             }
-            
-            switch (evt.type) {
-                case LedCommandEvent::START:
-                    leds[evt.led_id]->start();
-                    {
-                        std::uint8_t msg[32];
-                        std::snprintf(reinterpret_cast<char*>(msg), sizeof(msg), 
-                                     "%s started", led_names[evt.led_id]);
-                        response_out(reinterpret_cast<const char*>(msg));
-                    }
-                    break;
-                    
-                case LedCommandEvent::STOP:
-                    leds[evt.led_id]->stop();
-                    {
-                        std::uint8_t msg[32];
-                        std::snprintf(reinterpret_cast<char*>(msg), sizeof(msg), 
-                                     "%s stopped", led_names[evt.led_id]);
-                        response_out(reinterpret_cast<const char*>(msg));
-                    }
-                    break;
-                    
-                case LedCommandEvent::SET_INTERVAL:
-                    leds[evt.led_id]->set_blink_interval(evt.interval_ms);
-                    {
-                        std::uint8_t msg[64];
-                        std::snprintf(reinterpret_cast<char*>(msg), sizeof(msg), 
-                                     "%s interval set to %lums", 
-                                     led_names[evt.led_id], 
-                                     static_cast<unsigned long>(evt.interval_ms));
-                        response_out(reinterpret_cast<const char*>(msg));
-                    }
-                    break;
+            flash_response_out(F("Boot phase      Time from reset (us)"));
+            fmt::Line<40> msg;
+            for (std::uint8_t i = 0; i < boot_profile::PHASE_COUNT; ++i) {
+                const auto phase = static_cast<boot_profile::Phase>(i);
+                msg.clear();
+                fmt::write(msg, "  ", reinterpret_cast<const __FlashStringHelper*>(PHASE_NAMES[i]));
+                msg.pad_to(16);
+                if (boot_profile::reached_phase(phase)) {
+                    fmt::write(msg, static_cast<unsigned long>(boot_profile::at(phase)));
+                } else {
+                    fmt::write(msg, '-');
+                }
+                response_out(msg.c_str());
             }
         };
-    
-    // Output: response messages
+
     ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
 };
 
-class StatusReporterActor {
-private:
-    led::BlinkyLedActor* leds[3];
-    const char* led_names[3] = {"LED1", "LED2", "LED3"};
-
+// The 'baud' command: moves the programming port to another rate for the session, and back if the terminal does not
+// follow. The reply goes out at the old rate; once it is sent the port switches, and the first line received at the
+// new rate confirms it. No line within CONFIRM_MS, or a framing error first, restores the old rate. At any rate but
+// DEFAULT_BAUD, FALLBACK_ERRORS framing errors without a good line between them, as a terminal opened at 9600 causes,
+// return the port to DEFAULT_BAUD; a reset does too. Framing errors are only seen with -D SERIAL_BUFFERED_OUTPUT:
+// without it, the fallback is on the timeout only.
+//
+//     > baud 1000000
+//     Baud rate 1000000 next: switch the terminal and send a line within 2 s
+//     (terminal at 1000000) > status
+//     Baud rate now 1000000
+class BaudRateActor {
 public:
-    StatusReporterActor(led::BlinkyLedActor& led1, 
-                       led::BlinkyLedActor& led2, 
-                       led::BlinkyLedActor& led3) {
-        leds[0] = &led1;
-        leds[1] = &led2;
-        leds[2] = &led3;
-    }
-    
-    ramen::Pushable<StatusRequestEvent> request_in = 
-        [this](const StatusRequestEvent&) {
-            response_out("LED Status:");
-            for (std::size_t i = 0; i < 3; i++) {
-                std::uint8_t msg[64];
-                std::snprintf(reinterpret_cast<char*>(msg), sizeof(msg), 
-                             "  %s: Pin D%d, Interval: %lums", 
-                             led_names[i], 
-                             static_cast<int>(leds[i]->pin), 
-                             static_cast<unsigned long>(leds[i]->blink_interval_ms));
-                response_out(reinterpret_cast<const char*>(msg));
+    static constexpr std::uint16_t CONFIRM_MS = 2000;
+    static constexpr std::uint8_t FALLBACK_ERRORS = 4;
+
+    ramen::Pushable<BaudRequestEvent> request_in =
+        [this](const BaudRequestEvent& evt) {
+            fmt::Line<80> msg;
+            if (evt.rate == 0) {
+                fmt::write(msg, "Baud rate: ", serial_port::baud_rate);
+                response_out(msg.c_str());
+                return;
+            }
+            if (state_ != State::STEADY) {
+                flash_response_out(F("Baud rate change in progress"));
+                return;
+            }
+            if (!serial_port::supported(evt.rate)) {
+                fmt::write(msg, "Baud rate ", static_cast<unsigned long>(evt.rate), " unavailable: ",
+                           static_cast<int>(serial_port::divisor(evt.rate).error_permille), " per mille off");
+                response_out(msg.c_str());
+                return;
             }
+            fmt::write(msg, "Baud rate ", static_cast<unsigned long>(evt.rate),
+                       " next: switch the terminal and send a line within 2 s");
+            response_out(msg.c_str());
+            previous_ = serial_port::baud_rate;
+            target_ = evt.rate;
+            state_ = State::SWITCHING;
         };
-    
+
+    // A line ended on the port; confirms a new rate
+    void on_line() {
+        if (state_ == State::SWITCHING) {
+            return;
+        }
+        if (state_ == State::CONFIRMING) {
+            if (serial_port::framing_errors != errors_) {
+                return;  // Received at the wrong rate; update() falls back
+            }
+            state_ = State::STEADY;
+            fmt::Line<32> msg;
+            fmt::write(msg, "Baud rate now ", serial_port::baud_rate);
+            response_out(msg.c_str());
+        }
+        errors_ = serial_port::framing_errors;
+    }
+
+    // Switches once the reply is sent, and falls back; called every pass
+    void update() {
+        const std::uint8_t errors = static_cast<std::uint8_t>(serial_port::framing_errors - errors_);
+        switch (state_) {
+            case State::SWITCHING:
+                if (serial_port::tx_idle()) {
+                    serial_port::set_baud(target_);
+                    errors_ = serial_port::framing_errors;
+                    since_ = millis();
+                    state_ = State::CONFIRMING;
+                }
+                break;
+            case State::CONFIRMING:
+                if (errors != 0 || millis() - since_ >= CONFIRM_MS) {
+                    fall_back(previous_);
+                }
+                break;
+            case State::STEADY:
+                if (serial_port::baud_rate == serial_port::DEFAULT_BAUD) {
+                    errors_ = serial_port::framing_errors;  // Nowhere to fall back to
+                } else if (errors >= FALLBACK_ERRORS) {
+                    fall_back(serial_port::DEFAULT_BAUD);
+                }
+                break;
+        }
+    }
+
     ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> flash_response_out;  // Constant text, printed from flash
+
+private:
+    enum class State : std::uint8_t { STEADY, SWITCHING, CONFIRMING };
+
+    State state_ = State::STEADY;
+    unsigned long target_ = 0;
+    unsigned long previous_ = 0;
+    std::uint32_t since_ = 0;     // Of the switch
+    std::uint8_t errors_ = 0;     // serial_port::framing_errors (which wraps) at the switch or the last good line
+
+    void fall_back(unsigned long baud) {
+        serial_port::set_baud(baud);
+        errors_ = serial_port::framing_errors;
+        state_ = State::STEADY;
+        fmt::Line<32> msg;
+        fmt::write(msg, "Baud rate back to ", baud);
+        response_out(msg.c_str());
+    }
 };
 
+// Writes the help text a line at a time while output_ready reports room, continuing from update() on later passes,
+// so the longest response does not hold loop() until the port has sent it
 class HelpProviderActor {
+private:
+    static constexpr std::uint8_t IDLE = 0xFF;
+    std::uint8_t next_line = IDLE;
+
+    static constexpr std::size_t LINE_SIZE = 76;  // Longest line, with terminator
+    static constexpr char HELP_LINES[][LINE_SIZE] PROGMEM = {
+        "Available commands:",
+        "  start <ids>         - Start LEDs (1=LED1, 2=LED2, ...; 1-3 or * for all)",
+        "  stop <ids>          - Stop LEDs",
+        "  interval <ids> <ms> - Set blink interval in milliseconds",
+        "  status              - Show current status",
+        "  stats               - Show dispatch depth, stack usage and message counts",
+        "  mem                 - Show heap usage and the heap-stack gap",
+        "  profile [reset]     - Show or clear per-port dispatch timings",
+        "  trace [clear]       - Show or clear the state transition trace",
+        "  ptrace [clear]      - Show or clear the trace of port dispatches",
+        "  latency [reset]     - Show or clear the timer expiry latency histogram",
+        "  scan [reset]        - Show or clear loop scan times and CPU utilization",
+        "  watchdog [clear]    - Show or clear step overruns and the watchdog reset",
+        "  record              - Show the record of serial input and input levels",
+        "  boot                - Show the time from reset to each boot phase",
+        "  baud [<rate>]       - Show the port's baud rate, or switch it to <rate>",
+        "  fsmbench            - Compare SML dispatch policies",
+        "  hashbench           - Compare the hashes behind std::hash",
+        "  script [clear]      - Show, or clear, the LED commands run at boot",
+        "  help                - Show this help",
+        "",
+        "Examples:",
+        "  start 1             - Start LED1",
+        "  stop 2              - Stop LED2",
+        "  interval 1 200      - Set LED1 to 200ms blink interval",
+        "  stop *; start 1-3   - Commands separated by ';' run in order",
+        "  script; start 1-3   - Start LED1..3 now and at every boot",
+    };
+    static constexpr std::uint8_t LINE_COUNT = sizeof(HELP_LINES) / sizeof(HELP_LINES[0]);
+
 public:
     ramen::Pushable<HelpRequestEvent> request_in = 
         [this](const HelpRequestEvent&) {
-            static const char* help_lines[] = {
-                "Available commands:",
-                "  start <1-3>        - Start LED (1=LED1, 2=LED2, 3=LED3)",
-                "  stop <1-3>         - Stop LED",
-                "  interval <1-3> <ms> - Set blink interval in milliseconds",
-                "  status             - Show current status",
-                "  help               - Show this help",
-                "",
-                "Examples:",
-                "  start 1            - Start LED1",
-                "  stop 2             - Stop LED2",
-                "  interval 1 200     - Set LED1 to 200ms blink interval",
-                nullptr
-            };
-            
-            for (const char** line = help_lines; *line != nullptr; ++line) {
-                response_out(*line);
-            }
+            next_line = 0;
+            update();
         };
+
+    // Stops the help text where it is
+    void cancel() { next_line = IDLE; }
+
+    // Writes pending help lines until the output reports it is full
+    void update() {
+        while (next_line != IDLE) {
+            bool ready = true;  // Unlinked: always
+            output_ready(ready);
+            if (!ready) {
+                return;
+            }
+            if (next_line == LINE_COUNT) {
+                next_line = IDLE;
+                return;
+            }
+            response_out(reinterpret_cast<const __FlashStringHelper*>(HELP_LINES[next_line++]));
+        }
+    }
     
-    ramen::Pusher<const char*> response_out;
+    ramen::Pusher<const __FlashStringHelper*> response_out;
+    ramen::Puller<bool> output_ready;
 };
 
+// Writes responses to the programming port as lines (see serial_port.hpp)
 class SerialOutputActor {
 public:
+    // Room for the longest response line and its line break
+    static constexpr std::uint16_t LINE_RESERVE = 82;
+
+    // What happens to a response that does not fit into the transmit buffer. Responses block by default, as a
+    // command's output should not be cut short; with the buffer, this waits only after a long burst
+    serial_port::Overflow overflow = serial_port::Overflow::BLOCK;
+
     ramen::Pushable<const char*> message_in = 
         [this](const char* const& msg) {
-            Serial.println(msg);
+            serial_port::write_line(msg, overflow);
+        };
+
+    // Input: constant messages in PROGMEM
+    ramen::Pushable<const __FlashStringHelper*> flash_in =
+        [this](const __FlashStringHelper* const& msg) {
+            serial_port::write_line(msg, overflow);
         };
+
+    // Input: raw bytes, such as binary reply frames, under the same policy
+    ramen::Pushable<ramen::Span<const std::uint8_t>> bytes_in =
+        [this](const ramen::Span<const std::uint8_t>& bytes) {
+            serial_port::write(reinterpret_cast<const char*>(bytes.ptr), static_cast<std::uint16_t>(bytes.len),
+                               overflow);
+        };
+
+    // True while a response line fits without waiting or being dropped, for producers that can continue later
+    ramen::Pullable<bool> can_accept =
+        [](bool& ready) {
+            ready = serial_port::tx_free() >= LINE_RESERVE;
+        };
+};
+
+// Writes responses to another UART through its HardwareSerial (Serial1..Serial3), with the inputs of
+// SerialOutputActor. The core queues 64 bytes and then waits in write(), so can_accept always reports room, as
+// SerialOutputActor does without SERIAL_BUFFERED_OUTPUT
+class UartOutputActor {
+public:
+    explicit UartOutputActor(HardwareSerial& port) : port_(port) {}
+
+    ramen::Pushable<const char*> message_in = [this](const char* const& msg) { port_.println(msg); };
+    ramen::Pushable<const __FlashStringHelper*> flash_in =
+        [this](const __FlashStringHelper* const& msg) { port_.println(msg); };
+    ramen::Pushable<ramen::Span<const std::uint8_t>> bytes_in =
+        [this](const ramen::Span<const std::uint8_t>& bytes) { port_.write(bytes.ptr, bytes.len); };
+    ramen::Pullable<bool> can_accept = [](bool& ready) { ready = true; };
+
+private:
+    HardwareSerial& port_;
+};
+
+// A command session on another UART, e.g. an HMI on Serial1 beside the service laptop on the programming port: its
+// own line buffers and response port, in front of the parser and executors that SerialCommandSystem shares between
+// all sessions (see attach_session()). The owner begins the port
+class UartSession {
+public:
+    explicit UartSession(HardwareSerial& port) : port_(port), output(port) {}
+    UartSession(const UartSession&) = delete;
+    UartSession& operator=(const UartSession&) = delete;
+
+    HardwareSerial& port() { return port_; }
+
+private:
+    friend class SerialCommandSystem;
+
+    HardwareSerial& port_;
+    LineFramer framer;
+    UartOutputActor output;
+    bool waiting_ = false;  // A complete line waits for the streaming parser (see SerialCommandSystem::update())
+};
+
+// Sends the responses of the shared actors to the session whose command they answer: number 0 is the programming
+// port, numbers 1 on the attached UartSessions. select() is called before a session's line runs
+class ResponseRouter {
+public:
+    static constexpr std::uint8_t MAX_SESSIONS = 4;  // The Mega's USARTs
+
+    explicit ResponseRouter(SerialOutputActor& primary) : primary_(primary) {}
+
+    // Number of the new session, or 0 if all are taken
+    std::uint8_t attach(UartOutputActor& output) {
+        if (count_ == MAX_SESSIONS) {
+            return 0;
+        }
+        outputs_[count_ - 1U] = &output;
+        return count_++;
+    }
+
+    void select(std::uint8_t session) { current_ = session; }
+    std::uint8_t current() const { return current_; }
+    std::uint8_t sessions() const { return count_; }
+
+    ramen::Pushable<const char*> message_in = [this](const char* const& msg) {
+        if (current_ == 0) {
+            primary_.message_in(msg);
+        } else {
+            outputs_[current_ - 1U]->message_in(msg);
+        }
+    };
+    ramen::Pushable<const __FlashStringHelper*> flash_in = [this](const __FlashStringHelper* const& msg) {
+        if (current_ == 0) {
+            primary_.flash_in(msg);
+        } else {
+            outputs_[current_ - 1U]->flash_in(msg);
+        }
+    };
+    ramen::Pushable<ramen::Span<const std::uint8_t>> bytes_in = [this](const ramen::Span<const std::uint8_t>& bytes) {
+        if (current_ == 0) {
+            primary_.bytes_in(bytes);
+        } else {
+            outputs_[current_ - 1U]->bytes_in(bytes);
+        }
+    };
+    ramen::Pullable<bool> can_accept = [this](bool& ready) {
+        if (current_ == 0) {
+            primary_.can_accept(ready);
+        } else {
+            outputs_[current_ - 1U]->can_accept(ready);
+        }
+    };
+
+private:
+    SerialOutputActor& primary_;
+    UartOutputActor* outputs_[MAX_SESSIONS - 1] = {};
+    std::uint8_t count_ = 1;
+    std::uint8_t current_ = 0;
 };
 
 // Main serial commander system - composes all actors
 class SerialCommandSystem {
 private:
-    SerialCollectorActor collector;
     CommandParserActor parser;
+#if defined(SERIAL_STREAMING_PARSER)
+    StreamingCommandParser streaming{parser};
+#else
+    LineFramer framer;
+#endif
     LedExecutorActor executor;
     StatusReporterActor status_reporter;
     HelpProviderActor help_provider;
+    StatsReporterActor stats_reporter;
+    MemReporterActor mem_reporter;
+    ProfileReporterActor profile_reporter;
+    FsmBenchActor fsm_bench;
+    HashBenchActor hash_bench;
+    TraceReporterActor trace_reporter;
+    PortTraceReporterActor port_trace_reporter;
+    LatencyReporterActor latency_reporter;
+    ScanReporterActor scan_reporter;
+    WatchdogReporterActor watchdog_reporter;
+    RecordReporterActor record_reporter;
+    BootProfileReporterActor boot_profile_reporter;
+    BaudRateActor baud;
     SerialOutputActor output;
+    ResponseRouter router{output};
+    UartSession* sessions_[ResponseRouter::MAX_SESSIONS - 1] = {};
+    std::uint8_t help_session_ = 0;  // Of the help text being written
+#if defined(SERIAL_BINARY_PROTOCOL)
+    BinaryEndpointActor binary;
+    LedExecutorActor binary_executor;  // Its text responses stay unlinked
+    TelemetryActor telemetry;
+#endif
 
 public:
-    SerialCommandSystem(led::BlinkyLedActor& led1, 
-                       led::BlinkyLedActor& led2, 
-                       led::BlinkyLedActor& led3) 
-        : executor(led1, led2, led3)
-        , status_reporter(led1, led2, led3) {
+    // TimerActor slots the system needs besides those of the outputs (see attach_timer())
+#if defined(SERIAL_BINARY_PROTOCOL)
+    static constexpr std::uint8_t TIMERS = 1;
+#else
+    static constexpr std::uint8_t TIMERS = 0;
+#endif
+
+    explicit SerialCommandSystem(const led::OutputTable& outputs)
+        : executor(outputs)
+        , status_reporter(outputs)
+#if defined(SERIAL_BINARY_PROTOCOL)
+        , binary(outputs)
+        , binary_executor(outputs)
+        , telemetry(outputs)
+#endif
+    {
         
         // Wire up the data flow using push syntax
-        collector.line_out >> parser.line_in;
+#if !defined(SERIAL_STREAMING_PARSER)
+        framer.line_out >> parser.line_in;
+#endif
+#if defined(SERIAL_BINARY_PROTOCOL)
+        binary.led_command_out >> binary_executor.command_in;
+        binary.frame_out >> output.bytes_in;
+        binary.output_ready >> output.can_accept;
+        binary.subscribe_out >> telemetry.subscribe_in;
+#endif
         
-        parser.led_command_out >> executor.command_in;
+        parser.led_batch_out >> executor.batch_in;
         parser.help_request_out >> help_provider.request_in;
         parser.status_request_out >> status_reporter.request_in;
+        parser.stats_request_out >> stats_reporter.request_in;
+        parser.mem_request_out >> mem_reporter.request_in;
+        parser.profile_request_out >> profile_reporter.request_in;
+        parser.fsm_bench_request_out >> fsm_bench.request_in;
+        parser.hash_bench_request_out >> hash_bench.request_in;
+        parser.trace_request_out >> trace_reporter.request_in;
+        parser.port_trace_request_out >> port_trace_reporter.request_in;
+        parser.latency_request_out >> latency_reporter.request_in;
+        parser.scan_request_out >> scan_reporter.request_in;
+        parser.watchdog_request_out >> watchdog_reporter.request_in;
+        parser.record_request_out >> record_reporter.request_in;
+        parser.boot_profile_request_out >> boot_profile_reporter.request_in;
+        parser.baud_request_out >> baud_session_in;
         
-        // All text outputs go to serial
-        executor.response_out >> output.message_in;
-        status_reporter.response_out >> output.message_in;
-        help_provider.response_out >> output.message_in;
-        parser.error_out >> output.message_in;
+        // All text outputs go to the session of the command, the programming port unless others are attached
+        executor.response_out >> router.message_in;
+        status_reporter.response_out >> router.message_in;
+        stats_reporter.response_out >> router.message_in;
+        mem_reporter.response_out >> router.message_in;
+        profile_reporter.response_out >> router.message_in;
+        fsm_bench.response_out >> router.message_in;
+        hash_bench.response_out >> router.message_in;
+        trace_reporter.response_out >> router.message_in;
+        port_trace_reporter.response_out >> router.message_in;
+        latency_reporter.response_out >> router.message_in;
+        scan_reporter.response_out >> router.message_in;
+        watchdog_reporter.response_out >> router.message_in;
+        record_reporter.response_out >> router.message_in;
+        boot_profile_reporter.response_out >> router.message_in;
+        baud.response_out >> router.message_in;
+
+        // Constant text is printed straight from flash
+        executor.flash_response_out >> router.flash_in;
+        executor.record_out >> router.bytes_in;
+        fsm_bench.flash_response_out >> router.flash_in;
+        hash_bench.flash_response_out >> router.flash_in;
+        status_reporter.flash_response_out >> router.flash_in;
+        help_provider.response_out >> router.flash_in;
+        stats_reporter.flash_response_out >> router.flash_in;
+        mem_reporter.flash_response_out >> router.flash_in;
+        profile_reporter.flash_response_out >> router.flash_in;
+        trace_reporter.flash_response_out >> router.flash_in;
+        port_trace_reporter.flash_response_out >> router.flash_in;
+        latency_reporter.flash_response_out >> router.flash_in;
+        scan_reporter.flash_response_out >> router.flash_in;
+        watchdog_reporter.flash_response_out >> router.flash_in;
+        record_reporter.flash_response_out >> router.flash_in;
+        boot_profile_reporter.flash_response_out >> router.flash_in;
+        baud.flash_response_out >> router.flash_in;
+        parser.error_out >> router.flash_in;
+        help_provider.output_ready >> router.can_accept;
+        parser.help_request_out >> help_session_in;
+
+        stats_reporter.watch(F("LED command batches"), parser.led_batch_out.sent_counter());
+        stats_reporter.watch(F("Rejected commands"), parser.error_out.sent_counter());
+    }
+
+    // Remembers who asked for the help text, which update() continues on later passes
+    ramen::Pushable<HelpRequestEvent> help_session_in = [this](const HelpRequestEvent&) {
+        help_session_ = router.current();
+    };
+
+    // The programming port's rate changes; the other sessions' UARTs keep theirs
+    ramen::Pushable<BaudRequestEvent> baud_session_in = [this](const BaudRequestEvent& evt) {
+        if (router.current() == 0) {
+            baud.request_in(evt);
+        } else {
+            router.flash_in(F("Baud rate: programming port only"));
+        }
+    };
+
+    // Takes commands from another UART as well, with their responses going back there, e.g. attach_session(hmi) for
+    // a UartSession on Serial1; false once every USART has a session
+    bool attach_session(UartSession& session) {
+        const std::uint8_t number = router.attach(session.output);
+        if (number == 0) {
+            return false;
+        }
+        sessions_[number - 1U] = &session;
+        session.framer.line_out >> parser.line_in;
+        return true;
     }
     
+    // Source of the 'latency' command, e.g. attach_timer_latency(timer.latency_report())
+    void attach_timer_latency(const timer_latency::Report& report) {
+        latency_reporter.report = report;
+    }
+
+    // Serves the binary protocol of another transport with the same executor and telemetry (see actor_udp.hpp); no-op
+    // without SERIAL_BINARY_PROTOCOL
+    void attach_binary_endpoint(BinaryEndpointActor& endpoint) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+        endpoint.led_command_out >> binary_executor.command_in;
+        endpoint.subscribe_out >> telemetry.subscribe_in;
+#else
+        (void)endpoint;
+#endif
+    }
+
+    // Store of the logic program downloaded over the binary protocol, e.g. attach_logic_vm(logic) for a
+    // logic_vm::LogicVmActor; no-op without SERIAL_BINARY_PROTOCOL
+    template <class Vm>
+    void attach_logic_vm(Vm& vm) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+        binary.program_out >> vm.program_in;
+#else
+        (void)vm;
+#endif
+    }
+
+    // Variables of the WATCH requests, e.g. attach_watch(watches) for a watch::WatchActor; no-op without
+    // SERIAL_BINARY_PROTOCOL
+    template <class Watch>
+    void attach_watch(Watch& watches) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+        binary.watch_out >> watches.request_in;
+#else
+        (void)watches;
+#endif
+    }
+
+    // Recipes staged, switched, loaded and saved by the RECIPE requests, e.g. attach_recipes(recipes) for a
+    // recipe::RecipeActor; no-op without SERIAL_BINARY_PROTOCOL
+    template <class Recipes>
+    void attach_recipes(Recipes& recipes) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+        binary.recipe_out >> recipes.request_in;
+#else
+        (void)recipes;
+#endif
+    }
+
+    // Alarms read and acknowledged by the ALARM requests, e.g. attach_alarms(alarm_table) for an alarms::AlarmManager;
+    // no-op without SERIAL_BINARY_PROTOCOL
+    void attach_alarms(alarms::AlarmTable& table) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+        binary.alarm_read_out >> table.read_in;
+        binary.alarm_ack_out >> table.ack_in;
+#else
+        (void)table;
+#endif
+    }
+
+    // Event log read by LOG_READ requests, e.g. attach_event_log(log) for an event_log::EventLogActor; no-op without
+    // SERIAL_BINARY_PROTOCOL
+    template <class Log>
+    void attach_event_log(Log& log) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+        binary.log_read_out >> log.read_in;
+#else
+        (void)log;
+#endif
+    }
+
+    // Store of the 'script' command, whose commands at boot run through the same executor as typed ones, e.g.
+    // attach_boot_script(boot) for a boot_script::BootScriptActor
+    template <class Script>
+    void attach_boot_script(Script& script) {
+        parser.script_out >> script.script_in;
+        script.batch_out >> executor.batch_in;
+        script.response_out >> router.message_in;
+        script.flash_response_out >> router.flash_in;
+    }
+
+    // Timer of the telemetry frames, e.g. attach_timer(timer), whose rejected requests 'stats' counts
+    template <class Timer>
+    void attach_timer(Timer& timer) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+        telemetry.arm_timer_request_out >> timer.arm_timer_request_in;
+        telemetry.disarm_timer_request_out >> timer.disarm_timer_request_in;
+#endif
+        const auto count = [&timer](TimerError error) -> const std::uint16_t& {
+            return timer.error_counts[static_cast<std::uint8_t>(error)];
+        };
+        stats_reporter.watch(F("Timer arms without a free slot"), count(TimerError::NO_FREE_SLOTS));
+        stats_reporter.watch(F("Timer requests without a target"), count(TimerError::NULL_TARGET_PUSHER));
+        stats_reporter.watch(F("Timer arms of no interval"), count(TimerError::INVALID_INTERVAL));
+        stats_reporter.watch(F("Timer disarms of stale handles"), count(TimerError::STALE_HANDLE));
+        stats_reporter.watch(F("Timer disarms of unknown targets"), count(TimerError::TARGET_PUSHER_NOT_FOUND));
+    }
+
+    // Lists a counter in the 'stats' output (see StatsReporterActor::watch()); false once MAX_COUNTERS are watched
+    bool watch(const __FlashStringHelper* name, const std::uint16_t& count) {
+        return stats_reporter.watch(name, count);
+    }
+
     void init() {
-        Serial.begin(9600);
-        Serial.println(F("LED Controller Ready"));
+        serial_port::begin(serial_port::DEFAULT_BAUD);
+        if (message_log::ENABLED) {
+            message_log::write<message_log::CONTROLLER_READY>(output.bytes_in);
+        } else {
+            serial_port::write_line(F("LED Controller Ready"), serial_port::Overflow::BLOCK);
+        }
         HelpRequestEvent help{};
         help_provider.request_in(help);
     }
     
+    // USART0 belongs to serial_port (or, without SERIAL_BUFFERED_OUTPUT, to the core's Serial), which also carries
+    // the responses, so the framer (or the streaming parser) takes the bytes straight out of its receive buffer; lines
+    // are dispatched as they complete. Bytes of binary frames never reach them. The lines of the other sessions follow
+    // (with the streaming parser, only while the programming port is between lines, as its commands queue up in the
+    // shared parser), and the help text then continues where the transmit buffer last stopped it. An ABORT byte goes
+    // ahead of all of them, the bytes queued before it dropped (-D SERIAL_ABORT, see serial_port.hpp)
     void update() {
-        // Feed characters into the system
-        while (Serial.available()) {
-            int ch = Serial.read();
-            if (ch >= 0) {  // Valid character received
-                SerialCharEvent evt{static_cast<std::uint8_t>(ch)};
-                collector.char_in(evt);
+        router.select(0);
+        serial_port::poll();
+        if (serial_port::take_abort()) {
+            abort();
+        }
+        while (serial_port::available() > 0) {
+            const int ch = serial_port::read();
+            if (ch < 0) {
+                continue;
+            }
+#if defined(SERIAL_BINARY_PROTOCOL)
+            if (binary.on_byte(static_cast<std::uint8_t>(ch))) {
+                continue;
+            }
+#endif
+#if defined(SERIAL_ABORT)
+            if (ch == serial_port::ABORT) {
+                abort();
+                continue;
+            }
+#endif
+            if (ch == '\n' || ch == '\r') {
+                baud.on_line();
+            }
+#if defined(SERIAL_STREAMING_PARSER)
+            streaming.on_byte(static_cast<std::uint8_t>(ch));
+#else
+            if (framer.on_byte(static_cast<std::uint8_t>(ch))) {
+                framer.poll();
+            }
+#endif
+        }
+        for (std::uint8_t i = 0; i + 1U < router.sessions(); ++i) {
+            update_session(i);
+        }
+        router.select(0);
+        baud.update();
+        router.select(help_session_);
+        help_provider.update();
+    }
+
+private:
+    // The priority lane of -D SERIAL_ABORT: stops every output with one command straight to the executor, past the
+    // partial line and the help text, whose rest is dropped with the input queued before the ABORT
+    void abort() {
+#if defined(SERIAL_STREAMING_PARSER)
+        streaming.discard();
+#else
+        framer.discard();
+#endif
+        if (help_session_ == 0) {
+            help_provider.cancel();
+        }
+        router.flash_in(F("Aborted: pending input and output dropped"));
+        const LedCommandEvent stop_all{0, LedCommandEvent::STOP, 0, LedCommandEvent::ALL};
+        executor.command_in(stop_all);
+    }
+
+    bool parser_idle() const {
+#if defined(SERIAL_STREAMING_PARSER)
+        return streaming.idle();
+#else
+        return true;
+#endif
+    }
+
+    // A line that completes while the programming port is inside one waits in the framer, and the bytes after it
+    // wait in the port, so no line is dropped
+    void update_session(std::uint8_t i) {
+        UartSession& session = *sessions_[i];
+        router.select(static_cast<std::uint8_t>(i + 1U));
+        if (session.waiting_) {
+            if (!parser_idle()) {
+                return;
+            }
+            session.waiting_ = false;
+            session.framer.poll();
+        }
+        while (session.port_.available() > 0) {
+            const int ch = session.port_.read();
+            if (ch < 0 || !session.framer.on_byte(static_cast<std::uint8_t>(ch))) {
+                continue;
+            }
+            if (!parser_idle()) {
+                session.waiting_ = true;
+                return;
             }
+            session.framer.poll();
         }
     }
 };
 
 } // namespace serial_cmd
+
+// Defines the receive interrupt of USART `n` (1..3) feeding `framer`, for a port whose HardwareSerial object
+// (Serial1..Serial3) is not linked in, as that defines the same vector; publish the lines with framer.poll() in loop().
+// Framing errors and the 9th bit are not checked.
+#if defined(__AVR__)
+#define SERIAL_LINE_FRAMER_ISR(n, framer) ISR(USART##n##_RX_vect) { (framer).on_byte(UDR##n); }
+#else
+#define SERIAL_LINE_FRAMER_ISR(n, framer)
+#endif
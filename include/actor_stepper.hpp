@@ -0,0 +1,321 @@
+#pragma once
+#include "fast_pin.hpp"
+#include "pgm_array.hpp"
+#include "ramen.hpp"
+#include "ramen_latch.hpp"
+#include <Controllino.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Step pulses for a small positioning axis, timed by the Timer3 compare A interrupt instead of the scan: 10 kHz and
+// more, with every edge where the timer puts it, while loop() goes on at its own pace.
+//
+// A move is a trapezoid: up the acceleration ramp, at the cruise speed, and down the same ramp to a stop. The ramp is
+// a table in flash of the timer interval before each step, computed by the compiler from STEPPER_ACCEL and
+// STEPPER_START_SPEED, so the interrupt does no arithmetic beyond picking an entry: step s of N waits for
+// RAMP[min(s, N - 1 - s)], or the cruise interval once the ramp has reached it. move() finds where that is, a binary
+// search in the main loop, and hands the move to the interrupt:
+//
+//     stepper::StepperActor axis;
+//
+//     void setup() {
+//         planner.move_out >> axis.move_in;        // stepper::Move{steps, speed}
+//         axis.done_out >> planner.position_in;    // The position after each move
+//         axis.begin();
+//     }
+//     void loop() { axis.update(); ... }
+//
+// Each interrupt raises the step pin, counts the step, sets the next interval and lowers the pin at least
+// STEPPER_PULSE_US after raising it: about 100 cycles, 5% of the CPU at 10 kHz. The timer runs at clk/8 (0.5 us per
+// count) in CTC mode and restarts at each compare, so the intervals do not drift with the interrupt's latency.
+// Completion reaches done_out from update(), as ports do not run in interrupt context. A move arriving during
+// another one waits for it to end, the last one received winning; stop() ramps down early, halt() stops at once.
+//
+// Speeds are in steps per second, from STEPPER_START_SPEED (where a move starts and ends) to STEPPER_MAX_SPEED. The
+// table has STEPPER_RAMP_STEPS entries (2 bytes of flash each); a move faster than the speed at its end cruises there.
+// Pins STEPPER_STEP_PIN and STEPPER_DIR_PIN, by default CONTROLLINO_D6 and D7. Timer3 is taken from the Arduino core
+// and from hw_blink (pins 2, 3, 5). One axis per firmware, as it owns the timer. Opt-in with -D STEPPER; without it
+// begin() does nothing. Off AVR the timer is detail::on_compare(), called by hand.
+
+#ifndef STEPPER_STEP_PIN
+#define STEPPER_STEP_PIN CONTROLLINO_D6
+#endif
+#ifndef STEPPER_DIR_PIN
+#define STEPPER_DIR_PIN CONTROLLINO_D7
+#endif
+#ifndef STEPPER_ACCEL
+#define STEPPER_ACCEL 50000  // Steps per second squared
+#endif
+#ifndef STEPPER_START_SPEED
+#define STEPPER_START_SPEED 200
+#endif
+#ifndef STEPPER_MAX_SPEED
+#define STEPPER_MAX_SPEED 20000
+#endif
+#ifndef STEPPER_RAMP_STEPS
+#define STEPPER_RAMP_STEPS 1024
+#endif
+#ifndef STEPPER_PULSE_US
+#define STEPPER_PULSE_US 3
+#endif
+
+namespace stepper {
+
+#if defined(STEPPER)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint32_t COUNTS_PER_S = 2000000UL;  // Timer3 at clk/8
+constexpr std::uint16_t MIN_INTERVAL = COUNTS_PER_S / STEPPER_MAX_SPEED;
+constexpr std::uint16_t PULSE_COUNTS = STEPPER_PULSE_US * 2U;
+
+static_assert(STEPPER_START_SPEED > COUNTS_PER_S / 0xFFFFUL, "STEPPER_START_SPEED is below what Timer3 can time");
+static_assert(STEPPER_MAX_SPEED > STEPPER_START_SPEED && STEPPER_MAX_SPEED <= 40000,
+              "STEPPER_MAX_SPEED is above the start speed and leaves the interrupt 25 us per step");
+static_assert(STEPPER_RAMP_STEPS > 0 && STEPPER_RAMP_STEPS <= 4096, "STEPPER_RAMP_STEPS is 1..4096");
+
+struct Move {
+    std::int32_t steps;   // Relative, negative with the direction pin low
+    std::uint16_t speed;  // Cruise speed in steps per second, 0 for STEPPER_MAX_SPEED
+};
+
+namespace detail {
+
+using StepPin = gpio::FastPin<STEPPER_STEP_PIN>;
+using DirPin = gpio::FastPin<STEPPER_DIR_PIN>;
+
+constexpr std::uint16_t isqrt(std::uint64_t x) {
+    std::uint64_t r = x;
+    std::uint64_t y = (r + 1U) / 2U;
+    while (y < r) {
+        r = y;
+        y = (r + x / r) / 2U;
+    }
+    return static_cast<std::uint16_t>(r);
+}
+
+struct RampTable {
+    std::uint16_t intervals[STEPPER_RAMP_STEPS];
+};
+
+// Before step i the speed is sqrt(v0^2 + 2 a i), so the interval is COUNTS_PER_S over that
+constexpr RampTable make_ramp() {
+    RampTable table{};
+    constexpr std::uint64_t V0_SQUARED = static_cast<std::uint64_t>(STEPPER_START_SPEED) * STEPPER_START_SPEED;
+    for (std::uint16_t i = 0; i < STEPPER_RAMP_STEPS; ++i) {
+        const std::uint64_t speed_squared = V0_SQUARED + 2ULL * STEPPER_ACCEL * i;
+        const std::uint16_t interval = isqrt(static_cast<std::uint64_t>(COUNTS_PER_S) * COUNTS_PER_S / speed_squared);
+        table.intervals[i] = (interval < MIN_INTERVAL) ? MIN_INTERVAL : interval;
+    }
+    return table;
+}
+
+constexpr auto RAMP PROGMEM = ramen::pgm_array<std::uint16_t>(make_ramp().intervals);
+
+// The move the interrupt runs; written by the main loop while the timer is stopped, or with interrupts off
+struct Profile {
+    std::uint32_t total;  // Steps
+    std::uint16_t ramp;   // Ramp entries used; from there on the cruise interval
+    std::uint16_t cruise;
+};
+
+inline Profile profile = {0, 0, 0};
+inline ramen::SeqLatch<std::uint32_t> done;  // Steps of the move made so far; written by the interrupt only
+inline volatile bool running = false;
+
+inline void start_timer(std::uint16_t first_interval) {
+#if defined(__AVR__) && defined(STEPPER)
+    const std::uint8_t sreg = SREG;
+    cli();
+    TCCR3A = 0;
+    TCCR3B = 0;
+    TCNT3 = 0;
+    OCR3A = first_interval;
+    TIFR3 = _BV(OCF3A);
+    TIMSK3 = _BV(OCIE3A);
+    TCCR3B = _BV(WGM32) | _BV(CS31);  // CTC with TOP = OCR3A, clk/8
+    SREG = sreg;
+#else
+    (void)first_interval;
+#endif
+}
+
+inline void stop_timer() {
+#if defined(__AVR__) && defined(STEPPER)
+    TCCR3B = 0;
+    TIMSK3 = 0;
+#endif
+}
+
+// Interrupt side: one step, then the interval to the next
+inline void on_compare() {
+    StepPin::high();
+    const std::uint32_t s = done.unsafe_value() + 1U;
+    done.write(s);
+    if (s >= profile.total) {
+        stop_timer();
+        running = false;
+    } else {
+        const std::uint32_t down = profile.total - 1U - s;
+        const std::uint32_t index = (s < down) ? s : down;
+        const std::uint16_t interval = (index < profile.ramp) ? RAMP[index] : profile.cruise;
+#if defined(__AVR__) && defined(STEPPER)
+        OCR3A = interval;
+        while (TCNT3 < PULSE_COUNTS) {
+        }
+#else
+        (void)interval;
+#endif
+    }
+    StepPin::low();
+}
+
+} // namespace detail
+
+// One per firmware, as it owns Timer3
+class StepperActor {
+public:
+    StepperActor() = default;
+    StepperActor(const StepperActor&) = delete;
+    StepperActor& operator=(const StepperActor&) = delete;
+
+    // Input: a move relative to where the last one ends
+    ramen::Pushable<Move> move_in = [this](const Move& m) { move(m.steps, m.speed); };
+
+    // Output: the position at the end of each move, stopped early or not
+    ramen::Pusher<std::int32_t> done_out;
+
+    // Takes the pins; Timer3 only runs during moves
+    void begin() {
+        if (!ENABLED) {
+            return;
+        }
+        detail::StepPin::make_output();
+        detail::DirPin::make_output();
+        started_ = true;
+    }
+
+    // Runs the move now, or after the one running, in place of any other waiting
+    void move(std::int32_t steps, std::uint16_t speed = 0) {
+        if (!started_) {
+            return;
+        }
+        if (running_) {
+            pending_ = {steps, speed};
+            has_pending_ = true;
+            return;
+        }
+        if (steps == 0) {
+            done_out(origin_);
+            return;
+        }
+        const bool forward = steps > 0;
+        detail::DirPin::write(forward);
+        forward_ = forward;
+        if (speed == 0 || speed > STEPPER_MAX_SPEED) {
+            speed = STEPPER_MAX_SPEED;
+        } else if (speed < STEPPER_START_SPEED) {
+            speed = STEPPER_START_SPEED;
+        }
+        std::uint16_t cruise = static_cast<std::uint16_t>(COUNTS_PER_S / speed);
+        // The ramp runs while its intervals are longer than the cruise interval; past its end, the speed stays there
+        const auto reached = std::lower_bound(detail::RAMP.begin(), detail::RAMP.end(), cruise, std::greater<>());
+        if (reached == detail::RAMP.end()) {
+            cruise = detail::RAMP.back();
+        }
+        detail::profile = {forward ? static_cast<std::uint32_t>(steps) : 0U - static_cast<std::uint32_t>(steps),
+                           static_cast<std::uint16_t>(reached - detail::RAMP.begin()), cruise};
+        detail::done.write(0);
+        detail::running = true;
+        running_ = true;
+        detail::start_timer(detail::RAMP[0]);
+    }
+
+    // Ramps down from the current speed and ends the move there; drops a waiting move
+    void stop() {
+        has_pending_ = false;
+        if (!running_) {
+            return;
+        }
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+#endif
+        const std::uint32_t s = detail::done.unsafe_value();
+        if (s < detail::profile.total) {
+            const std::uint32_t down = detail::profile.total - 1U - s;
+            std::uint32_t index = (s < down) ? s : down;
+            if (index > detail::profile.ramp) {
+                index = detail::profile.ramp;
+            }
+            detail::profile.total = s + index + 1U;  // Each step from here one ramp entry further down
+        }
+#if defined(__AVR__)
+        SREG = sreg;
+#endif
+    }
+
+    // Stops at once, which a loaded axis may not follow; drops a waiting move
+    void halt() {
+        has_pending_ = false;
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+#endif
+        detail::stop_timer();
+        detail::running = false;
+#if defined(__AVR__)
+        SREG = sreg;
+#endif
+        detail::StepPin::low();
+    }
+
+    // Once per scan: reports a finished move and starts the one waiting
+    void update() {
+        if (!running_ || detail::running) {
+            return;
+        }
+        origin_ = position();
+        running_ = false;
+        done_out(origin_);
+        if (has_pending_) {
+            has_pending_ = false;
+            move(pending_.steps, pending_.speed);
+        }
+    }
+
+    // Steps from the start, counted as they are made
+    std::int32_t position() const {
+        if (!running_) {
+            return origin_;
+        }
+        const std::int32_t made = static_cast<std::int32_t>(detail::done.read());
+        return forward_ ? origin_ + made : origin_ - made;
+    }
+
+    bool busy() const { return running_; }
+
+    // The position from here on counts from `value`; ignored during a move
+    void set_position(std::int32_t value) {
+        if (!running_) {
+            origin_ = value;
+        }
+    }
+
+private:
+    bool started_ = false;
+    bool running_ = false;  // Main-loop view: set by move(), cleared by update() once the interrupt is done
+    bool forward_ = true;
+    bool has_pending_ = false;
+    Move pending_{0, 0};
+    std::int32_t origin_ = 0;  // Position at the start of the move running
+};
+
+} // namespace stepper
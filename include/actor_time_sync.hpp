@@ -0,0 +1,222 @@
+#pragma once
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <chrono>
+#include <cstdint>
+
+// A network time base shared by several controllers: one runs a TimeSyncMaster, the others a TimeSyncSlave, and
+// every one of them builds its TimerActor on NetworkClock instead of MillisClock. Deadlines then fall on the same
+// network millisecond on every node, so outputs armed for the same time switch together.
+//
+// The slave stamps a request with its micros() (t1) and the master stamps its receipt (t2) and its reply (t3) with
+// the network time; the slave's receipt of the reply is t4. As in PTP, the path delay is (t4 - t1) - (t3 - t2), and
+// the offset of the network time from the slave's clock is ((t2 - t1) + (t3 - t4)) / 2 if both directions take as
+// long, which is why requests and replies are the same SyncMessage. The slave steps to each accepted offset and
+// estimates the rate of its clock against the master's from the offsets' change, so the network time keeps
+// following the master between exchanges:
+//
+//     ramen::BridgeLink bridge;                                // See ramen_bridge.hpp
+//     ramen::BridgeExport<time_sync::SyncMessage> sync_out(bridge, time_sync::REQUEST_CHANNEL);
+//     ramen::BridgeImport<time_sync::SyncMessage> sync_in(bridge, time_sync::REPLY_CHANNEL);
+//     time_sync::TimeSyncSlave sync;
+//     TimerActor<3, DefaultTimerQueue, time_sync::NetworkClock> timer;
+//
+//     sync.request_out >> sync_out.in;  sync.sent_out >> bridge.flush_in;  sync_in.out >> sync.reply_in;
+//     void loop() { sync.update(); ... }
+//
+// The master links the channels the other way round, to request_in and reply_out. Stamps are taken in the main loop,
+// so the time a byte waits for loop() to read it and a frame waits for the bridge to send it both count as path
+// delay; sent_out flushes at once, and exchanges noticeably slower than the fastest recent one are discarded, which
+// keeps that error to a fraction of the loop's own latency, under a millisecond on an idle loop. Sync steps can move
+// the network time either way by the offset's change; arm outputs that must line up once synchronized() is true.
+
+namespace time_sync {
+
+constexpr std::uint8_t REQUEST_CHANNEL = 250;  // Suggested bridge channels, clear of the application's
+constexpr std::uint8_t REPLY_CHANNEL = 251;
+
+// A request carries seq and t1; the reply copies them and adds the master's stamps
+struct SyncMessage {
+    std::uint8_t seq = 0;
+    std::uint32_t t1 = 0;             // Slave's micros() when sending the request
+    std::uint32_t t2 = 0;             // Network micros when the master received it
+    std::uint32_t t3 = 0;             // Network micros when the master replied
+    std::uint32_t t3_millis = 0;      // Network millis at t3
+    std::uint16_t t3_fraction = 0;    // Microseconds of t3 into that millisecond
+};
+
+// The network time of this node: the master's own clock there, the corrected local one on a slave
+struct ClockState {
+    std::uint32_t offset_us = 0;         // Network minus local micros at sync_local_us, modulo 2^32
+    std::int32_t rate = 0;               // Network against local clock rate, minus one, in units of 2^-20
+    std::uint32_t sync_local_us = 0;     // Local micros of the last correction
+    std::uint32_t anchor_millis = 0;     // A network millisecond boundary...
+    std::uint32_t anchor_us = 0;         // ...and its network micros
+    bool synchronized = false;
+};
+
+inline ClockState clock_state;
+
+namespace detail {
+
+constexpr std::uint32_t MAX_CORRECTED_US = 1UL << 28;  // Rate correction stops after 268 s without an exchange
+constexpr std::int32_t MAX_RATE = 1L << 12;            // About 3900 ppm, beyond even a ceramic resonator
+constexpr std::uint32_t REBASE_US = 1000000000UL;      // Keeps network micros minus the anchor clear of wrapping
+
+inline std::int32_t clamp(std::int32_t value, std::int32_t limit) {
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+inline std::uint32_t network_micros_at(std::uint32_t local_us) {
+    std::uint32_t elapsed = local_us - clock_state.sync_local_us;
+    if (elapsed > MAX_CORRECTED_US) {
+        elapsed = MAX_CORRECTED_US;
+    }
+    const std::int32_t drift = static_cast<std::int32_t>(elapsed >> 10) * clock_state.rate / 1024;
+    return local_us + clock_state.offset_us + static_cast<std::uint32_t>(drift);
+}
+
+// Network micros since the anchor, which first moves up if they approach wrapping
+inline std::uint32_t since_anchor(std::uint32_t network_us) {
+    std::uint32_t since = network_us - clock_state.anchor_us;
+    if (since >= REBASE_US) {
+        clock_state.anchor_us += REBASE_US;
+        clock_state.anchor_millis += REBASE_US / 1000UL;
+        since -= REBASE_US;
+    }
+    return since;
+}
+
+} // namespace detail
+
+inline std::uint32_t network_micros() { return detail::network_micros_at(micros()); }
+
+// Call at least once every 71 minutes (TimerActor does on every update()), so the anchor keeps up with micros()
+inline std::uint32_t network_millis() {
+    const std::uint32_t since = detail::since_anchor(network_micros());
+    return clock_state.anchor_millis + since / 1000UL;
+}
+
+inline bool synchronized() { return clock_state.synchronized; }
+
+// Clock of a TimerActor on network time. Sync steps can make a deadline a millisecond early or late, and a fast
+// local clock reaches it before millis() does, hence the guard
+struct NetworkClock {
+    using duration = std::chrono::milliseconds;
+    static constexpr std::uint32_t IDLE_SLEEP_GUARD = 1;
+    static std::uint32_t now() { return network_millis(); }
+    static constexpr std::uint32_t ticks(duration interval) { return static_cast<std::uint32_t>(interval.count()); }
+};
+
+// Answers the slaves' requests; the network time is this node's own
+struct TimeSyncMaster {
+    TimeSyncMaster() { clock_state.synchronized = true; }
+    TimeSyncMaster(const TimeSyncMaster&) = delete;
+    TimeSyncMaster& operator=(const TimeSyncMaster&) = delete;
+
+    ramen::Pushable<SyncMessage> request_in = [this](const SyncMessage& request) { reply(request); };
+    ramen::Pusher<SyncMessage> reply_out;
+    ramen::Pusher<> sent_out;  // Link to the transport's flush, so the reply leaves with its stamp
+
+private:
+    void reply(const SyncMessage& request) {
+        SyncMessage msg = request;
+        msg.t2 = network_micros();
+        msg.t3 = network_micros();
+        const std::uint32_t since = detail::since_anchor(msg.t3);
+        msg.t3_millis = clock_state.anchor_millis + since / 1000UL;
+        msg.t3_fraction = static_cast<std::uint16_t>(since % 1000UL);
+        reply_out(msg);
+        sent_out();
+    }
+};
+
+// Keeps this node's network time on the master's, with an exchange every `period_ms`
+struct TimeSyncSlave {
+    static constexpr std::uint32_t DEFAULT_PERIOD_MS = 1000;
+    static constexpr std::uint32_t DELAY_TOLERANCE_US = 500;  // Over the fastest recent exchange
+
+    explicit TimeSyncSlave(std::uint32_t period_ms = DEFAULT_PERIOD_MS) : period_ms_(period_ms) {}
+    TimeSyncSlave(const TimeSyncSlave&) = delete;
+    TimeSyncSlave& operator=(const TimeSyncSlave&) = delete;
+
+    ramen::Pusher<SyncMessage> request_out;
+    ramen::Pusher<> sent_out;  // Link to the transport's flush, so the request leaves with its stamp
+    ramen::Pushable<SyncMessage> reply_in = [this](const SyncMessage& reply) { on_reply(reply, micros()); };
+
+    // Sends the next request once the period has passed; a reply that never came is given up then
+    void update() {
+        const std::uint32_t now = millis();
+        if (started_ && now - last_request_ms_ < period_ms_) {
+            return;
+        }
+        started_ = true;
+        last_request_ms_ = now;
+        SyncMessage msg;
+        msg.seq = ++seq_;
+        awaiting_ = true;
+        msg.t1 = micros();
+        request_out(msg);
+        sent_out();
+    }
+
+    // Round trip of the last accepted exchange, without the master's turnaround
+    std::uint32_t path_delay_us() const { return delay_us_; }
+    std::uint16_t accepted() const { return accepted_; }
+    std::uint16_t rejected() const { return rejected_; }  // Stale, or slower than the tolerance allows; saturates
+
+    // Takes a reply received at local time t4; public so that a transport can stamp the receipt itself
+    void on_reply(const SyncMessage& reply, std::uint32_t t4) {
+        const std::uint32_t delay = (t4 - reply.t1) - (reply.t3 - reply.t2);
+        if (!awaiting_ || reply.seq != seq_ || static_cast<std::int32_t>(delay) < 0 || !fast_enough(delay)) {
+            if (rejected_ != UINT16_MAX) {
+                ++rejected_;
+            }
+            return;
+        }
+        awaiting_ = false;  // A duplicate of this reply is stale now
+        if (accepted_ != UINT16_MAX) {
+            ++accepted_;
+        }
+        delay_us_ = delay;
+        const std::uint32_t offset = (reply.t2 - reply.t1) - delay / 2U;  // ((t2 - t1) + (t3 - t4)) / 2, wrapping
+        if (clock_state.synchronized) {
+            // What is left of the offset's change after the rate correction is the rate's error
+            const std::uint32_t interval = (t4 - clock_state.sync_local_us) >> 10;
+            const std::uint32_t predicted = detail::network_micros_at(t4) - t4;
+            const std::int32_t residual = detail::clamp(static_cast<std::int32_t>(offset - predicted), 1L << 20);
+            if (interval > 0 && interval < (detail::MAX_CORRECTED_US >> 10)) {
+                const std::int32_t error = residual * 1024 / static_cast<std::int32_t>(interval);
+                clock_state.rate = detail::clamp(clock_state.rate + error / 2, detail::MAX_RATE);
+            }
+        }
+        clock_state.offset_us = offset;
+        clock_state.sync_local_us = t4;
+        clock_state.anchor_us = reply.t3 - reply.t3_fraction;
+        clock_state.anchor_millis = reply.t3_millis;
+        clock_state.synchronized = true;
+    }
+
+private:
+    std::uint32_t period_ms_;
+    std::uint32_t last_request_ms_ = 0;
+    std::uint32_t delay_us_ = 0;
+    std::uint32_t best_delay_us_ = UINT32_MAX;
+    std::uint16_t accepted_ = 0;
+    std::uint16_t rejected_ = 0;
+    std::uint8_t seq_ = 0;
+    bool started_ = false;
+    bool awaiting_ = false;  // A request is out with seq_
+
+    // The fastest recent exchange ages towards the current ones, so a path that got slower is followed
+    bool fast_enough(std::uint32_t delay) {
+        if (delay < best_delay_us_) {
+            best_delay_us_ = delay;
+        } else {
+            best_delay_us_ += (delay - best_delay_us_) / 16U;
+        }
+        return delay <= best_delay_us_ + DELAY_TOLERANCE_US;
+    }
+};
+
+} // namespace time_sync
@@ -1,12 +1,20 @@
 #pragma once
+#include "boot_profile.hpp"
 #include "event.hpp"
 #include "ramen.hpp"
+#include "ramen_request.hpp"
+#include "scan_clock.hpp"
+#include "timer_compare.hpp"
+#include "timer_latency.hpp"
+#include "timer_queue.hpp"
 #include <Controllino.h>
+#include <chrono>
 #include <cstdint>
 #include <array>
+#include <type_traits>
 
-// Defines concurrency of timeout events
-constexpr size_t MAX_CONCURRENT_TIMEOUTS = 3;
+// Default concurrency of timeout events, the slot count of TimerActor<>
+constexpr std::uint8_t MAX_CONCURRENT_TIMEOUTS = 3;
 
 // Error codes for TimerActor operations
 enum class TimerError : uint8_t {
@@ -14,16 +22,37 @@ enum class TimerError : uint8_t {
     NULL_TARGET_PUSHER,
     NO_FREE_SLOTS,
     TARGET_PUSHER_NOT_FOUND,
-    INVALID_INTERVAL
+    INVALID_INTERVAL,
+    STALE_HANDLE
+};
+constexpr std::uint8_t TIMER_ERROR_KINDS = static_cast<std::uint8_t>(TimerError::STALE_HANDLE) + 1U;
+
+// Time bases of TimerActor. Deadlines, intervals (ArmTimerEvt::interval_ms) and clock_out are in the clock's units.
+// IDLE_SLEEP_GUARD is how far ahead a deadline keeps idle_sleep::sleep() awake, as sleeping may last up to one
+// Timer0 overflow (1024 us). ticks() converts a std::chrono duration into the clock's units; only conversions without
+// loss compile (ticks(1500us) for milliseconds does not), and a constant converts at compile time.
+struct MillisClock {
+    using duration = std::chrono::milliseconds;
+    static constexpr std::uint32_t IDLE_SLEEP_GUARD = 0;
+    static std::uint32_t now() { return millis(); }
+    static constexpr std::uint32_t ticks(duration interval) { return static_cast<std::uint32_t>(interval.count()); }
+};
+// 4 us resolution at 16 MHz; intervals up to 2^31 us (about 35 minutes)
+struct MicrosClock {
+    using duration = std::chrono::microseconds;
+    static constexpr std::uint32_t IDLE_SLEEP_GUARD = 1024;
+    static std::uint32_t now() { return micros(); }
+    static constexpr std::uint32_t ticks(duration interval) { return static_cast<std::uint32_t>(interval.count()); }
 };
 
 struct ActiveTimeout {
-    uint32_t target_millis = 0;
+    uint32_t target_millis = 0;  // In units of the owning TimerActor's clock
     ramen::Pusher<const BaseEvent&>* on_expired_pusher = nullptr; // Client's pusher to invoke
     bool is_active = false;
     bool is_periodic = false;
     uint32_t period_ms = 0;
     void* user_data_for_tick = nullptr; // To pass back in TickEvent if needed
+    OverrunPolicy overrun = OverrunPolicy::SKIP;
 
     void clear() {
         target_millis = 0;
@@ -32,19 +61,22 @@ struct ActiveTimeout {
         is_periodic = false;
         period_ms = 0;
         user_data_for_tick = nullptr;
+        overrun = OverrunPolicy::SKIP;
     }
 
-    void setup_periodic(uint32_t interval_ms, ramen::Pusher<const BaseEvent&>* pusher, void* udata) {
-        target_millis = millis() + interval_ms;
+    void setup_periodic(uint32_t now, uint32_t interval_ms, ramen::Pusher<const BaseEvent&>* pusher, void* udata,
+                        OverrunPolicy overrun_policy) {
+        target_millis = now + interval_ms;
         on_expired_pusher = pusher;
         is_active = true;
         is_periodic = true;
         period_ms = interval_ms;
+        overrun = overrun_policy;
         // user_data_for_tick = udata;
     }
 
-    void setup_oneshot(uint32_t interval_ms, ramen::Pusher<const BaseEvent&>* pusher, void* udata) {
-        target_millis = millis() + interval_ms;
+    void setup_oneshot(uint32_t now, uint32_t interval_ms, ramen::Pusher<const BaseEvent&>* pusher, void* udata) {
+        target_millis = now + interval_ms;
         on_expired_pusher = pusher;
         is_active = true;
         is_periodic = false;
@@ -52,101 +84,240 @@ struct ActiveTimeout {
         user_data_for_tick = udata;
     }
 
-    void restart_periodic() {
+    // Whole periods between the deadline and `now`, i.e. ticks that are overdue besides the current one
+    uint32_t missed_periods(uint32_t now) const {
+        const int32_t late = static_cast<int32_t>(now - target_millis);
+        return (is_periodic && period_ms > 0 && late > 0) ? static_cast<uint32_t>(late) / period_ms : 0;
+    }
+
+    // Advances the deadline from the previous one, so periods do not accumulate dispatch latency
+    void restart_periodic(uint32_t now) {
         if (is_periodic && period_ms > 0) {
-            target_millis = millis() + period_ms;
+            const uint32_t skipped = (overrun == OverrunPolicy::CATCH_UP) ? 0 : missed_periods(now);
+            target_millis += period_ms * (skipped + 1U);
         }
     }
 };
 
+// Active slots are kept in a deadline queue (see timer_queue.hpp), so update() only looks at timers that are due.
+// The default binary heap compares the earliest deadline with the current time and returns at once while nothing is
+// due; -D TIMER_QUEUE_WHEEL selects a hashed timing wheel with O(1) arm and disarm for large timer counts, with
+// TIMER_WHEEL_SIZE buckets of TIMER_WHEEL_TICK_MS each.
+#ifndef TIMER_WHEEL_SIZE
+#define TIMER_WHEEL_SIZE 32
+#endif
+#ifndef TIMER_WHEEL_TICK_MS
+#define TIMER_WHEEL_TICK_MS 1
+#endif
+
+#if defined(TIMER_QUEUE_WHEEL)
+template <std::uint8_t N>
+using DefaultTimerQueue = timer_queue::Wheel<N, TIMER_WHEEL_SIZE, TIMER_WHEEL_TICK_MS>;
+#else
+template <std::uint8_t N>
+using DefaultTimerQueue = timer_queue::Heap<N>;
+#endif
+
+// A pool of N timeout slots. Subsystems with different timing needs can run separately sized pools, e.g.
+// TimerActor<8> for comms and TimerActor<4> for HMI timeouts. Free slots are chained in a free list, so arming
+// takes a slot in O(1).
+//
+// Clients that pass a TimerHandle with ArmTimerEvt get the armed slot back and can re-arm or disarm it directly,
+// without the scan over all slots; this also lets one client hold several timers on the same pusher. Every slot
+// carries a generation counter that advances when the slot is released, so stale handles are rejected.
+//
+// Periodic timers are rescheduled from their previous deadline, so they keep their phase however late update() runs;
+// ArmTimerEvt selects what happens to ticks missed entirely (OverrunPolicy in event.hpp).
+//
+// With -D TIMER_HW_COMPARE, one TimerActor can call use_hardware_compare() to have the earliest deadline programmed
+// into a Timer4 output compare (see timer_compare.hpp); its interrupt marks the timer as expired and wakes an idle
+// CPU, instead of the expiry waiting for the next millis() tick to be noticed.
+//
+// set_coalescing() lets timers share deadlines, so that update() expires them in one pass (and an idle CPU or the
+// compare wakes once for all of them): a new deadline moves back by up to `slack` onto an armed one, and with
+// `align_periods` a periodic timer takes the phase of an armed timer of the same period. Deadlines only ever move
+// later, by less than the slack or one period. Arming then scans the armed slots, so it is off by default.
+//
+// The constructor is constexpr (the ports are bound methods, the queues constant-initialized), so a global TimerActor
+// is laid out in .data by the compiler and costs no code at startup.
+template <std::uint8_t N = MAX_CONCURRENT_TIMEOUTS, template <std::uint8_t> class Queue = DefaultTimerQueue,
+          class Clock = MillisClock>
 struct TimerActor {
-    std::array<ActiveTimeout, MAX_CONCURRENT_TIMEOUTS> active_timeouts;
+    static_assert(N > 0 && N < timer_queue::NONE, "TimerActor needs 1 to 254 slots");
+    static constexpr std::uint8_t capacity = N;
+    using clock_type = Clock;
+
+    std::array<ActiveTimeout, N> active_timeouts;
     TimerError last_error = TimerError::NONE;
+    // Occurrences of each error, indexed by TimerError and saturating at 65535; last_error only keeps the latest
+    std::array<std::uint16_t, TIMER_ERROR_KINDS> error_counts{};
+
+    constexpr TimerActor() {
+        for (std::uint8_t i = 0; i < N; ++i) {
+            free_next_[i] = static_cast<std::uint8_t>(i + 1U);
+        }
+        free_next_[N - 1U] = timer_queue::NONE;
+    }
+    TimerActor(const TimerActor&) = delete;
+    TimerActor& operator=(const TimerActor&) = delete;
 
-    void set_error(TimerError error) { last_error = error; }
+    void set_error(TimerError error) {
+        last_error = error;
+        std::uint16_t& count = error_counts[static_cast<std::uint8_t>(error)];
+        if (count != UINT16_MAX) {
+            ++count;
+        }
+    }
     bool has_error() const { return last_error != TimerError::NONE; }
     void clear_error() { last_error = TimerError::NONE; }
 
-    ramen::Pushable<const ArmTimerEvt&> arm_timer_request_in =
-        [this](const ArmTimerEvt& evt) {
-            clear_error();
+    // Bound methods keep only the object pointer, so the ports reserve no more (ramen::this_footprint)
+    ramen::Pushable<ramen::Footprint<ramen::this_footprint>, const ArmTimerEvt&> arm_timer_request_in =
+        ramen::bind<&TimerActor::arm>(this);
 
-            if (!evt.target_pusher) {
-                set_error(TimerError::NULL_TARGET_PUSHER);
-                return;
-            }
+    void arm(const ArmTimerEvt& evt) {
+        clear_error();
 
-            if (evt.interval_ms == 0) {
-                set_error(TimerError::INVALID_INTERVAL);
-                return;
-            }
+        if (!evt.target_pusher) {
+            set_error(TimerError::NULL_TARGET_PUSHER);
+            return;
+        }
 
-            // Find a free slot
-            for (size_t i = 0; i < MAX_CONCURRENT_TIMEOUTS; ++i) {
-                if (!active_timeouts[i].is_active) {
-                    if (evt.is_periodic) {
-                        active_timeouts[i].setup_periodic(evt.interval_ms, evt.target_pusher, evt.user_data);
-                    } else {
-                        active_timeouts[i].setup_oneshot(evt.interval_ms, evt.target_pusher, evt.user_data);
-                    }
-                    return; // Successfully armed
+        if (evt.interval_ms == 0) {
+            set_error(TimerError::INVALID_INTERVAL);
+            return;
+        }
+
+        std::uint8_t slot = live_slot(evt.handle);
+        if (slot != timer_queue::NONE) {
+            dequeue(slot);  // Re-arm in place
+        } else {
+            slot = free_head_;
+            if (slot == timer_queue::NONE) {
+                if (evt.handle) {
+                    *evt.handle = TimerHandle{};
                 }
+                set_error(TimerError::NO_FREE_SLOTS); // No free slots
+                return;
             }
-            set_error(TimerError::NO_FREE_SLOTS); // No free slots
-        };
+            free_head_ = free_next_[slot];
+        }
+        if (evt.is_periodic) {
+            active_timeouts[slot].setup_periodic(Clock::now(), evt.interval_ms, evt.target_pusher, evt.user_data, evt.overrun);
+        } else {
+            active_timeouts[slot].setup_oneshot(Clock::now(), evt.interval_ms, evt.target_pusher, evt.user_data);
+        }
+        if (evt.handle) {
+            *evt.handle = TimerHandle{slot, generation_[slot]};
+        }
+        if (coalesce_slack_ > 0 || align_periods_) {
+            coalesce(slot);
+        }
+        enqueue(slot);
+    }
+
+    void set_coalescing(std::uint32_t slack, bool align_periods) {
+        coalesce_slack_ = slack;
+        align_periods_ = align_periods;
+    }
 
     // NEW Pushable to handle DisarmTimerEvt
-    ramen::Pushable<const DisarmTimerEvt&> disarm_timer_request_in =
-        [this](const DisarmTimerEvt& evt) {
-            clear_error();
+    ramen::Pushable<ramen::Footprint<ramen::this_footprint>, const DisarmTimerEvt&> disarm_timer_request_in =
+        ramen::bind<&TimerActor::disarm>(this);
 
-            if (!evt.target_pusher) {
-                set_error(TimerError::NULL_TARGET_PUSHER);
-                return;
-            }
+    void disarm(const DisarmTimerEvt& evt) {
+        clear_error();
 
-            bool found = false;
-            for (size_t i = 0; i < MAX_CONCURRENT_TIMEOUTS; ++i) {
-                if (active_timeouts[i].is_active &&
-                    active_timeouts[i].on_expired_pusher == evt.target_pusher) {
-                    active_timeouts[i].clear();
-                    found = true;
-                    // If a client can have multiple timers and this disarms all, continue.
-                    // If only one timer per client or disarming specific one, logic might change.
-                }
+        if (evt.handle.valid()) {
+            const std::uint8_t slot = live_slot(&evt.handle);
+            if (slot == timer_queue::NONE) {
+                set_error(TimerError::STALE_HANDLE);
+            } else {
+                release(slot);
             }
+            return;
+        }
 
-            if (!found) {
-                set_error(TimerError::TARGET_PUSHER_NOT_FOUND);
+        if (!evt.target_pusher) {
+            set_error(TimerError::NULL_TARGET_PUSHER);
+            return;
+        }
+
+        bool found = false;
+        for (std::uint8_t i = 0; i < N; ++i) {
+            if (active_timeouts[i].is_active &&
+                active_timeouts[i].on_expired_pusher == evt.target_pusher) {
+                release(i);
+                found = true;
+                // If a client can have multiple timers and this disarms all, continue.
+                // If only one timer per client or disarming specific one, logic might change.
             }
-        };
+        }
+
+        if (!found) {
+            set_error(TimerError::TARGET_PUSHER_NOT_FOUND);
+        }
+    }
+
+    // arm and disarm as requests (ramen_request.hpp), each answered on call_result_out with its TimerError under the
+    // id of the request, so a caller learns of a failure without reading last_error
+    ramen::Pushable<ramen::Footprint<ramen::this_footprint>, const ramen::Request<ArmTimerEvt>&> arm_call_in =
+        ramen::bind<&TimerActor::arm_call>(this);
+    ramen::Pushable<ramen::Footprint<ramen::this_footprint>, const ramen::Request<DisarmTimerEvt>&> disarm_call_in =
+        ramen::bind<&TimerActor::disarm_call>(this);
+    ramen::Pusher<ramen::Response<TimerError>> call_result_out;
+
+    void arm_call(const ramen::Request<ArmTimerEvt>& request) {
+        arm(request.body);
+        call_result_out(ramen::Response<TimerError>{request.id, last_error});
+    }
+
+    void disarm_call(const ramen::Request<DisarmTimerEvt>& request) {
+        disarm(request.body);
+        call_result_out(ramen::Response<TimerError>{request.id, last_error});
+    }
+
+    // Shared time base for time-aware operators (ramen_timing.hpp); pushed with Clock::now() on every update()
+    ramen::Pusher<std::uint32_t> clock_out;
 
     void update() {
-        std::uint32_t now = millis();
-        for (size_t i = 0; i < MAX_CONCURRENT_TIMEOUTS; ++i) {
-            if (active_timeouts[i].is_active) {
-                // Handle wraparound using signed arithmetic
-                if ((int32_t)(now - active_timeouts[i].target_millis) >= 0) {
-                    // Fire the timer by invoking the client's Pusher
-                    if (active_timeouts[i].on_expired_pusher &&
-                        *(active_timeouts[i].on_expired_pusher)) {
-
-                        TickEvent tick_to_send;
-                        tick_to_send.user_data = active_timeouts[i].user_data_for_tick;
-
-                        // Invoke the client's Pusher. This Pusher will then
-                        // trigger any Behaviors (Pushables) linked to it.
-                        (*(active_timeouts[i].on_expired_pusher))(tick_to_send);
-                    }
-
-                    if (active_timeouts[i].is_periodic) {
-                        active_timeouts[i].restart_periodic();
-                    } else {
-                        active_timeouts[i].clear(); // Clear one-shot timers
-                    }
-                }
-            }
+        std::uint32_t now = Clock::now();
+        if (clock_out) {
+            clock_out(now);
         }
+        if (hw_compare_) {
+            take_compare_expiries(now);
+        }
+        for (std::uint8_t slot = queue_.pop_due(now, deadline_of()); slot != timer_queue::NONE;
+             slot = queue_.pop_due(now, deadline_of())) {
+            expire(slot, now);
+        }
+        if (hw_compare_) {
+            program_compare(now);
+        }
+    }
+
+    // Routes expiries through the Timer4 output compare; only one TimerActor may do so
+    void use_hardware_compare() {
+        static_assert(std::is_same_v<Clock, MillisClock> || std::is_same_v<Clock, scan_clock::Clock>,
+                      "The compare is programmed in milliseconds of millis()");
+        hw_compare_ = timer_compare::ENABLED;
+        compare_slot_ = COMPARE_STALE;
+        timer_compare::start();
+    }
+
+    // Expiry latency statistics (-D TIMER_LATENCY_STATS); detached when disabled
+    timer_latency::Report latency_report() {
+#if defined(TIMER_LATENCY_STATS)
+        return timer_latency::Report{&latency_.histogram, latency_.slot_max.data(), N};
+#else
+        return timer_latency::Report{};
+#endif
+    }
+
+    // Earliest deadline (in Clock units) of any armed timer; false if none is armed
+    bool next_deadline(std::uint32_t& deadline_ms) const {
+        return queue_.next_deadline(deadline_of(), deadline_ms);
     }
 
     const char* get_error_string() const {
@@ -156,7 +327,167 @@ struct TimerActor {
             case TimerError::NO_FREE_SLOTS: return "No free timeout slots";
             case TimerError::TARGET_PUSHER_NOT_FOUND: return "Target pusher not found for disarm";
             case TimerError::INVALID_INTERVAL: return "Invalid timeout interval";
+            case TimerError::STALE_HANDLE: return "Timer handle expired or disarmed";
             default: return "Unknown error";
         }
     }
+
+private:
+    Queue<N> queue_;
+    std::array<std::uint8_t, N> free_next_{};  // Free list through the unused slots
+    std::array<std::uint8_t, N> generation_{};
+    std::uint8_t free_head_ = 0;
+    std::uint32_t coalesce_slack_ = 0;
+    bool align_periods_ = false;
+    bool hw_compare_ = false;
+#if defined(TIMER_LATENCY_STATS)
+    timer_latency::Stats<N> latency_;
+#endif
+    static constexpr std::uint8_t COMPARE_STALE = timer_queue::NONE - 1U;  // Matches no slot: reprogram on update()
+    // Timer the compare is programmed for, so update() only reprograms it when the earliest deadline changes
+    std::uint8_t compare_slot_ = timer_queue::NONE;
+    std::uint8_t compare_generation_ = 0;
+    std::uint32_t compare_deadline_ = 0;
+
+    // Moves the deadline of a slot about to be queued onto that of an armed timer, see set_coalescing()
+    void coalesce(std::uint8_t slot) {
+        ActiveTimeout& timeout = active_timeouts[slot];
+        const std::uint32_t requested = timeout.target_millis;
+        const std::uint32_t period = timeout.period_ms;
+        std::uint32_t best_delay = 0;
+        bool found = false;
+        for (std::uint8_t i = 0; i < N; ++i) {
+            if (!queue_.queued(i)) {
+                continue;
+            }
+            const ActiveTimeout& other = active_timeouts[i];
+            const std::int32_t offset = static_cast<std::int32_t>(other.target_millis - requested);
+            std::uint32_t delay;
+            if (align_periods_ && timeout.is_periodic && other.is_periodic && other.period_ms == period) {
+                // Next deadline in the other timer's phase, at or after the requested one
+                delay = (offset >= 0) ? static_cast<std::uint32_t>(offset) % period
+                                      : (period - static_cast<std::uint32_t>(-offset) % period) % period;
+            } else if (offset >= 0 && static_cast<std::uint32_t>(offset) <= coalesce_slack_) {
+                delay = static_cast<std::uint32_t>(offset);
+            } else {
+                continue;
+            }
+            if (!found || delay < best_delay) {
+                best_delay = delay;
+                found = true;
+            }
+        }
+        timeout.target_millis = requested + best_delay;
+    }
+
+    // Dispatches the tick of a slot taken off the queue and re-queues or releases it
+    void expire(std::uint8_t slot, std::uint32_t now) {
+        ActiveTimeout& timeout = active_timeouts[slot];
+#if defined(TIMER_LATENCY_STATS)
+        latency_.record(slot, static_cast<std::int32_t>(now - timeout.target_millis));
+#endif
+
+        // Fire the timer by invoking the client's Pusher
+        if (timeout.on_expired_pusher && *(timeout.on_expired_pusher)) {
+            TickEvent tick_to_send;
+            tick_to_send.user_data = timeout.user_data_for_tick;
+            if (timeout.overrun == OverrunPolicy::COALESCE) {
+                const std::uint32_t missed = timeout.missed_periods(now);
+                tick_to_send.missed = static_cast<std::uint16_t>((missed > UINT16_MAX) ? UINT16_MAX : missed);
+            }
+
+            // Invoke the client's Pusher. This Pusher will then
+            // trigger any Behaviors (Pushables) linked to it.
+            (*(timeout.on_expired_pusher))(tick_to_send);
+            if (boot_profile::ENABLED) {
+                boot_profile::mark(boot_profile::FIRST_TIMER);
+            }
+        }
+
+        // The client may have disarmed or re-armed the slot while handling the tick
+        if (timeout.is_active && !queue_.queued(slot)) {
+            if (timeout.is_periodic) {
+                timeout.restart_periodic(now);
+                enqueue(slot);
+            } else {
+                release(slot); // Clear one-shot timers
+            }
+        }
+    }
+
+    // Fires timers the compare interrupt found expired. Deadlines are in whole milliseconds, so one that is due
+    // within the current millis() tick counts as reached; anything else (a slot re-armed since) waits in the queue.
+    void take_compare_expiries(std::uint32_t now) {
+        timer_compare::Expiry expiry;
+        while (timer_compare::ready.pop(expiry)) {
+            compare_slot_ = COMPARE_STALE;
+            const std::uint8_t slot = expiry.slot;
+            if (slot < N && generation_[slot] == expiry.generation && queue_.queued(slot) &&
+                !timer_queue::before(now + 1U, active_timeouts[slot].target_millis)) {
+                dequeue(slot);
+                expire(slot, now);
+            }
+        }
+    }
+
+    void program_compare(std::uint32_t now) {
+        const std::uint8_t slot = queue_.earliest(deadline_of());
+        if (slot == timer_queue::NONE) {
+            if (compare_slot_ != timer_queue::NONE) {
+                timer_compare::disarm();
+                compare_slot_ = timer_queue::NONE;
+            }
+            return;
+        }
+        const std::uint32_t deadline = active_timeouts[slot].target_millis;
+        if (slot == compare_slot_ && generation_[slot] == compare_generation_ && deadline == compare_deadline_) {
+            return;
+        }
+        compare_slot_ = slot;
+        compare_generation_ = generation_[slot];
+        compare_deadline_ = deadline;
+
+        const std::int32_t remaining_ms = static_cast<std::int32_t>(deadline - now);
+        std::uint32_t ticks = (remaining_ms > 0) ? static_cast<std::uint32_t>(remaining_ms) * timer_compare::TICKS_PER_MS : 0U;
+        std::uint8_t expiring = slot;
+        if (ticks > timer_compare::MAX_TICKS) {
+            ticks = timer_compare::MAX_TICKS;  // Out of reach: wake up on the way and arm the rest then
+            expiring = timer_compare::NO_SLOT;
+        }
+        timer_compare::arm(static_cast<std::uint16_t>(ticks), expiring, compare_generation_);
+    }
+
+    void release(std::uint8_t slot) {
+        dequeue(slot);
+        active_timeouts[slot].clear();
+        ++generation_[slot];
+        free_next_[slot] = free_head_;
+        free_head_ = slot;
+    }
+
+    // Slot named by a handle if it is still armed with the same generation, NONE otherwise
+    std::uint8_t live_slot(const TimerHandle* handle) const {
+        if (handle == nullptr || handle->slot >= N || generation_[handle->slot] != handle->generation ||
+            !active_timeouts[handle->slot].is_active) {
+            return timer_queue::NONE;
+        }
+        return handle->slot;
+    }
+
+    void enqueue(std::uint8_t slot) {
+        queue_.insert(slot, deadline_of());
+    }
+    void dequeue(std::uint8_t slot) {
+        queue_.remove(slot, deadline_of());
+    }
+    struct DeadlineOf {
+        const TimerActor* self;
+        std::uint32_t operator()(std::uint8_t slot) const { return self->active_timeouts[slot].target_millis; }
+    };
+    DeadlineOf deadline_of() const { return DeadlineOf{this}; }
 };
+
+// Microsecond timers for short pulses (stepper pulse trains, solenoid kicks) on the same arm/disarm ports; intervals
+// are in microseconds. Expiry is as late as the loop() iteration that notices it, so keep loop() short when using it.
+template <std::uint8_t N = MAX_CONCURRENT_TIMEOUTS>
+using MicrosTimerActor = TimerActor<N, timer_queue::Heap, MicrosClock>;
@@ -0,0 +1,129 @@
+#pragma once
+#include "actor_serial_commander.hpp"
+#include "output_registry.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+#if defined(ETHERNET_UDP)
+#include <Ethernet.h>
+#include <EthernetUdp.h>
+#endif
+
+// The binary protocol of BinaryEndpointActor over UDP, on the W5100 Ethernet controller of the Controllino Maxi
+// Automation: the same requests, replies and telemetry frames as on the programming port, at the speed of the network
+// instead of 9600 baud.
+//
+//     std::uint8_t mac[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
+//     net::UdpEndpointActor udp_endpoint(outputs);
+//     void setup() {
+//         udp_endpoint.begin(mac, {192, 168, 1, 177});
+//         commander.attach_binary_endpoint(udp_endpoint.binary);
+//     }
+//     void loop()  { udp_endpoint.update(); ... }
+//
+// A datagram carries one frame, with or without its zero delimiters. update() takes the waiting datagrams from the
+// W5100 and reads each one out of the socket buffer with a single block transfer, straight into the frame buffer of
+// `binary`, which decodes it in place; a larger datagram cannot be a request and is discarded unread. Replies go back
+// to the sender of the request, telemetry frames to the sender of the last datagram. The endpoint has its own frame
+// buffer but shares the executor and the telemetry of SerialCommandSystem; a subscription over UDP takes the frames
+// over from the serial port and vice versa.
+//
+// Opt-in with -D ETHERNET_UDP, together with -D SERIAL_BINARY_PROTOCOL; without it the actor does nothing and the
+// Ethernet library is not used.
+
+namespace net {
+
+#if defined(ETHERNET_UDP)
+#if !defined(SERIAL_BINARY_PROTOCOL)
+#error "ETHERNET_UDP serves the binary protocol of SerialCommandSystem: add -D SERIAL_BINARY_PROTOCOL"
+#endif
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+class UdpEndpointActor {
+public:
+    static constexpr std::uint16_t DEFAULT_PORT = 5000;
+    static constexpr std::uint8_t MAX_DATAGRAMS_PER_UPDATE = 4;  // Bounds the time update() takes under a flood
+
+    explicit UdpEndpointActor(const led::OutputTable& outputs) : binary(outputs) {
+        binary.frame_out >> frame_in;
+    }
+    UdpEndpointActor(const UdpEndpointActor&) = delete;
+    UdpEndpointActor& operator=(const UdpEndpointActor&) = delete;
+
+    // The decoder of the datagrams; its commands and subscriptions are wired by
+    // SerialCommandSystem::attach_binary_endpoint()
+    serial_cmd::BinaryEndpointActor binary;
+
+    // Starts the Ethernet interface with a static address and listens on `port`; false without -D ETHERNET_UDP or if
+    // no W5100 answers
+    bool begin(std::uint8_t (&mac)[6], const std::uint8_t (&ip)[4], std::uint16_t port = DEFAULT_PORT) {
+#if defined(ETHERNET_UDP)
+        Ethernet.begin(mac, IPAddress(ip[0], ip[1], ip[2], ip[3]));
+        if (Ethernet.hardwareStatus() == EthernetNoHardware) {
+            return false;
+        }
+        return udp_.begin(port) == 1;
+#else
+        (void)mac;
+        (void)ip;
+        (void)port;
+        return false;
+#endif
+    }
+
+    // Handles the datagrams that have arrived
+    void update() {
+#if defined(ETHERNET_UDP)
+        for (std::uint8_t i = 0; i < MAX_DATAGRAMS_PER_UPDATE; ++i) {
+            const int size = udp_.parsePacket();
+            if (size <= 0) {
+                return;
+            }
+            peer_ip_ = udp_.remoteIP();
+            peer_port_ = udp_.remotePort();
+            if (static_cast<std::size_t>(size) > serial_cmd::BinaryEndpointActor::FRAME_BUFFER_SIZE) {
+                count(oversized_);  // The next parsePacket() skips the rest of it
+                continue;
+            }
+            const int n = udp_.read(binary.frame_buffer(), static_cast<std::size_t>(size));
+            binary.on_frame(n > 0 ? static_cast<std::size_t>(n) : 0U);
+        }
+#endif
+    }
+
+    // Datagrams too large for a frame
+    std::uint16_t oversized_datagrams() const { return oversized_; }
+
+    // Input: encoded frames for the peer, one datagram each
+    ramen::Pushable<ramen::Span<const std::uint8_t>> frame_in =
+        [this](const ramen::Span<const std::uint8_t>& frame) {
+#if defined(ETHERNET_UDP)
+            if (peer_port_ != 0 && udp_.beginPacket(peer_ip_, peer_port_) == 1) {
+                udp_.write(frame.ptr, frame.len);
+                udp_.endPacket();
+            }
+#else
+            (void)frame;
+#endif
+        };
+
+private:
+#if defined(ETHERNET_UDP)
+    EthernetUDP udp_;
+    IPAddress peer_ip_;
+    std::uint16_t peer_port_ = 0;  // 0 until the first datagram
+#endif
+    std::uint16_t oversized_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+};
+
+} // namespace net
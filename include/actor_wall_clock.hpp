@@ -0,0 +1,343 @@
+#pragma once
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <cstdint>
+
+// The date and time of day without an RTC transaction per timestamp: the Controllino's RTC sits on the SPI bus and
+// answers a read in a transfer of eight bytes, with the chip select and the BCD conversion around it. The wall clock
+// reads it at begin() and then once every SYNC_MS, and in between interpolates from the scan clock, so a timestamp
+// costs a subtraction and a division, and a second one in the same scan a comparison:
+//
+//     wall_clock::WallClockActor<> wall_time;
+//     ramen::Puller<wall_clock::DateTime> time_in;
+//
+//     void setup() {
+//         wall_time.begin();                       // The RTC's time, to the second
+//         time_in >> wall_time.time_out;
+//         events.seconds_in >> wall_time.seconds_out;  // The event log's timestamps (see actor_event_log.hpp)
+//     }
+//     void loop() { wall_time.update(); ... }
+//     ...     wall_clock::DateTime now; time_in(now);  if (now.hour >= 22) { ... }
+//
+// The RTC counts whole seconds, so a sync polls it every EDGE_POLL_MS until its second changes, which places the
+// second's start to within EDGE_POLL_MS / 2, and for up to 1.2 s (50 reads) in every SYNC_MS. The first sync, and any
+// that finds the clock more than STEP_MS off, steps the time to the RTC's; the others measure the rate of the scan
+// clock against the RTC over the syncs since that step and slew out what remains of the offset over the next SYNC_MS
+// instead of stepping, so between steps the time never runs backwards and never jumps. set_time() (an NTP server's
+// time, say) steps it as well, and holds until the next sync; a clock that is to keep it should also write the RTC.
+//
+// Opt-in with -D WALL_CLOCK. Without it (or off AVR) begin() and update() read no RTC and the time counts from boot,
+// unless set_time() sets it; DateTime::valid tells.
+
+namespace wall_clock {
+
+#if defined(WALL_CLOCK)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Seconds since 2000-01-01 00:00 of a date in 2000..2099
+constexpr std::uint32_t to_seconds(std::uint16_t year, std::uint8_t month, std::uint8_t day, std::uint8_t hour,
+                                   std::uint8_t minute, std::uint8_t second) {
+    constexpr std::uint16_t DAYS_BEFORE[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    const std::uint16_t years = static_cast<std::uint16_t>(year - 2000U);
+    std::uint32_t days = years * 365UL + (years + 3U) / 4U + DAYS_BEFORE[(month - 1U) % 12U] + (day - 1U);
+    if (month > 2 && years % 4U == 0) {
+        ++days;  // 2000 is a leap year, as every fourth to 2099
+    }
+    return ((days * 24UL + hour) * 60UL + minute) * 60UL + second;
+}
+
+struct DateTime {
+    std::uint32_t seconds = 0;       // Since 2000-01-01 00:00
+    std::uint16_t millisecond = 0;
+    std::uint16_t year = 2000;
+    std::uint8_t month = 1;          // 1..12
+    std::uint8_t day = 1;            // 1..31
+    std::uint8_t hour = 0;
+    std::uint8_t minute = 0;
+    std::uint8_t second = 0;
+    std::uint8_t weekday = 6;        // 0 Sunday .. 6 Saturday
+    bool valid = false;              // From the RTC or set_time(), else the time since boot
+};
+
+// The date of `seconds` since 2000, the reverse of to_seconds()
+constexpr DateTime to_date(std::uint32_t seconds, std::uint16_t millisecond = 0, bool valid = true) {
+    constexpr std::uint16_t DAYS_BEFORE[13] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
+    DateTime t;
+    t.seconds = seconds;
+    t.millisecond = millisecond;
+    t.valid = valid;
+    std::uint32_t days = seconds / 86400UL;
+    std::uint32_t rest = seconds % 86400UL;
+    t.hour = static_cast<std::uint8_t>(rest / 3600U);
+    rest %= 3600U;
+    t.minute = static_cast<std::uint8_t>(rest / 60U);
+    t.second = static_cast<std::uint8_t>(rest % 60U);
+    t.weekday = static_cast<std::uint8_t>((days + 6U) % 7U);  // 2000-01-01 was a Saturday
+    std::uint16_t year = static_cast<std::uint16_t>(2000U + 4U * (days / 1461U));  // Cycles of four years...
+    std::uint16_t day = static_cast<std::uint16_t>(days % 1461U);                // ...each starting with a leap year
+    const bool leap = day < 366U;
+    if (!leap) {
+        day = static_cast<std::uint16_t>(day - 366U);
+        year = static_cast<std::uint16_t>(year + 1U + day / 365U);
+        day = static_cast<std::uint16_t>(day % 365U);
+    }
+    t.year = year;
+    std::uint8_t month = 1;
+    while (month < 12 && day >= DAYS_BEFORE[month] + ((leap && month >= 2) ? 1U : 0U)) {
+        ++month;
+    }
+    t.month = month;
+    t.day = static_cast<std::uint8_t>(day - DAYS_BEFORE[month - 1U] - ((leap && month > 2) ? 1U : 0U) + 1U);
+    return t;
+}
+
+// The RTC of the Controllino MEGA and MAXI, through the Controllino library; reads nothing off AVR
+struct ControllinoRtc {
+    static bool begin() {
+#if defined(__AVR__)
+        return Controllino_RTC_init() == 0;
+#else
+        return false;
+#endif
+    }
+
+    // The time in seconds since 2000; false if the RTC did not answer or was never set
+    static bool read(std::uint32_t& seconds) {
+#if defined(__AVR__)
+        unsigned char day, weekday, month, year, hour, minute, second;
+        if (Controllino_ReadTimeDate(&day, &weekday, &month, &year, &hour, &minute, &second) != 0 || month == 0) {
+            return false;
+        }
+        seconds = to_seconds(static_cast<std::uint16_t>(2000U + year), month, day, hour, minute, second);
+        return true;
+#else
+        (void)seconds;
+        return false;
+#endif
+    }
+};
+
+template <class Rtc = ControllinoRtc>
+class WallClockActor {
+public:
+    static constexpr std::uint32_t SYNC_MS = 60000;
+    static constexpr std::uint16_t EDGE_POLL_MS = 20;
+    static constexpr std::uint16_t EDGE_WAIT_MS = 1200;  // Longest a sync waits for the RTC's second to change
+    static constexpr std::int32_t STEP_MS = 1000;        // An offset beyond is stepped, not slewed
+    static constexpr std::int32_t MAX_RATE = 1L << 12;   // Of the scan clock against the RTC, in units of 2^-20
+    static constexpr std::int32_t MAX_SLEW = 1L << 15;   // Rate and slew together, about 3 %
+
+    // Outputs: the time in seconds since 2000 (since boot until it is known), and as a date
+    ramen::Pullable<std::uint32_t> seconds_out = [this](std::uint32_t& seconds) { seconds = now(); };
+    ramen::Pullable<DateTime> time_out = [this](DateTime& t) { t = date(); };
+
+    // Input: the time in seconds since 2000, stepped to at once
+    ramen::Pushable<std::uint32_t> time_in = [this](std::uint32_t seconds) { set_time(seconds); };
+
+    WallClockActor() = default;
+    WallClockActor(const WallClockActor&) = delete;
+    WallClockActor& operator=(const WallClockActor&) = delete;
+
+    // Steps to the RTC's time, to the second, and starts the first sync; false without an RTC
+    bool begin() {
+        const std::uint32_t now_ms = scan_clock::now();
+        anchor(0, 0, now_ms);
+        if (!ENABLED || !Rtc::begin()) {
+            phase_ = Phase::WAITING;
+            due_ms_ = now_ms;
+            return false;
+        }
+        std::uint32_t seconds = 0;
+        if (!Rtc::read(seconds)) {
+            count(failures_);
+            phase_ = Phase::WAITING;
+            due_ms_ = now_ms;
+            return false;
+        }
+        anchor(seconds, 0, now_ms);
+        valid_ = true;
+        seek(seconds, now_ms);
+        return true;
+    }
+
+    void update() {
+        const std::uint32_t now_ms = scan_clock::now();
+        if (now_ms - due_ms_ >= 0x80000000UL) {
+            return;  // Not due
+        }
+        if (phase_ == Phase::WAITING) {
+            rebase(now_ms);
+            std::uint32_t seconds = 0;
+            if (ENABLED && Rtc::read(seconds)) {
+                seek(seconds, now_ms);
+            } else {
+                if (ENABLED) {
+                    count(failures_);
+                }
+                due_ms_ = now_ms + SYNC_MS;
+            }
+            return;
+        }
+        std::uint32_t seconds = 0;
+        if (!Rtc::read(seconds) || now_ms - seek_start_ms_ > EDGE_WAIT_MS) {
+            count(failures_);  // The RTC stopped answering, or its second stopped moving
+            wait(now_ms);
+            return;
+        }
+        if (seconds == seek_seconds_) {
+            due_ms_ = now_ms + EDGE_POLL_MS;
+            return;
+        }
+        on_edge(seconds, now_ms - EDGE_POLL_MS / 2U);
+        wait(now_ms);
+    }
+
+    // Steps the time; an RTC sync may step it back if the RTC disagrees by more than STEP_MS
+    void set_time(std::uint32_t seconds) {
+        const std::uint32_t now_ms = scan_clock::now();
+        anchor(seconds, 0, now_ms);
+        valid_ = true;
+        locked_ = false;
+        rate_ = 0;
+        count(steps_);
+    }
+
+    // Seconds since 2000, or since boot while !valid()
+    std::uint32_t now() const {
+        const std::uint32_t now_ms = scan_clock::now();
+        if (now_ms != cached_ms_ || !cached_) {
+            std::uint16_t millisecond = 0;
+            cached_seconds_ = at(now_ms, millisecond);
+            cached_ms_ = now_ms;
+            cached_ = true;
+        }
+        return cached_seconds_;
+    }
+
+    DateTime date() const {
+        std::uint16_t millisecond = 0;
+        const std::uint32_t seconds = at(scan_clock::now(), millisecond);
+        return to_date(seconds, millisecond, valid_);
+    }
+
+    bool valid() const { return valid_; }
+    bool locked() const { return locked_; }    // The rate is measured, the time follows the RTC by slewing
+    std::int32_t rate() const { return rate_; }  // Of the scan clock against the RTC, minus one, in units of 2^-20
+
+    // Counters, saturating at 65535
+    std::uint16_t syncs() const { return syncs_; }
+    std::uint16_t steps() const { return steps_; }
+    std::uint16_t failures() const { return failures_; }
+
+private:
+    enum class Phase : std::uint8_t { WAITING, SEEKING };
+
+    static constexpr std::uint32_t MAX_CORRECTED_MS = 1UL << 25;  // Slew stops 9 hours after the last update()
+    static constexpr std::uint32_t MIN_RATE_SPAN_MS = 30000;       // Shorter, the edges' jitter would swamp the rate
+    static constexpr std::uint32_t MAX_RATE_SPAN_MS = 1UL << 22;   // Longer (70 min), the rate starts from the edge
+
+    std::uint32_t anchor_seconds_ = 0;  // The time at anchor_ms_...
+    std::uint16_t anchor_millisecond_ = 0;
+    std::uint32_t anchor_ms_ = 0;       // ...of the scan clock
+    std::int32_t slew_ = 0;             // The rate applied since the anchor: rate_ plus the offset being slewed out
+    std::int32_t rate_ = 0;
+    std::uint32_t ref_seconds_ = 0;     // The RTC edge the rate is measured from
+    std::uint32_t ref_ms_ = 0;
+    std::uint32_t due_ms_ = 0;
+    std::uint32_t seek_seconds_ = 0;
+    std::uint32_t seek_start_ms_ = 0;
+    mutable std::uint32_t cached_seconds_ = 0;
+    mutable std::uint32_t cached_ms_ = 0;
+    mutable bool cached_ = false;
+    Phase phase_ = Phase::WAITING;
+    bool valid_ = false;
+    bool locked_ = false;
+    std::uint16_t syncs_ = 0;
+    std::uint16_t steps_ = 0;
+    std::uint16_t failures_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    static std::int32_t clamp(std::int32_t value, std::int32_t limit) {
+        return value > limit ? limit : (value < -limit ? -limit : value);
+    }
+
+    // The time at `ms` of the scan clock, no earlier than the anchor
+    std::uint32_t at(std::uint32_t ms, std::uint16_t& millisecond) const {
+        const std::uint32_t elapsed = ms - anchor_ms_;
+        const std::uint32_t corrected = elapsed > MAX_CORRECTED_MS ? MAX_CORRECTED_MS : elapsed;
+        const std::int32_t drift = static_cast<std::int32_t>(corrected >> 10) * slew_ / 1024;
+        const std::uint32_t total = anchor_millisecond_ + elapsed + static_cast<std::uint32_t>(drift);
+        millisecond = static_cast<std::uint16_t>(total % 1000U);
+        return anchor_seconds_ + total / 1000U;
+    }
+
+    void anchor(std::uint32_t seconds, std::uint16_t millisecond, std::uint32_t ms) {
+        anchor_seconds_ = seconds;
+        anchor_millisecond_ = millisecond;
+        anchor_ms_ = ms;
+        slew_ = rate_;
+        cached_ = false;
+    }
+
+    // Moves the anchor to `ms` where the time stays, and ends the slew
+    void rebase(std::uint32_t ms) {
+        std::uint16_t millisecond = 0;
+        const std::uint32_t seconds = at(ms, millisecond);
+        anchor(seconds, millisecond, ms);
+    }
+
+    void seek(std::uint32_t seconds, std::uint32_t ms) {
+        phase_ = Phase::SEEKING;
+        seek_seconds_ = seconds;
+        seek_start_ms_ = ms;
+        due_ms_ = ms + EDGE_POLL_MS;
+    }
+
+    void wait(std::uint32_t ms) {
+        phase_ = Phase::WAITING;
+        due_ms_ = ms + SYNC_MS;
+    }
+
+    // The RTC's second `seconds` began at `ms` of the scan clock
+    void on_edge(std::uint32_t seconds, std::uint32_t ms) {
+        count(syncs_);
+        std::uint16_t millisecond = 0;
+        const std::uint32_t clock_seconds = at(ms, millisecond);
+        const std::int32_t offset = static_cast<std::int32_t>(seconds - clock_seconds) * 1000L - millisecond;
+        valid_ = true;
+        if (!locked_ || offset > STEP_MS || offset < -STEP_MS) {
+            if (locked_) {
+                count(steps_);
+            }
+            rate_ = 0;
+            anchor(seconds, 0, ms);
+            ref_seconds_ = seconds;
+            ref_ms_ = ms;
+            locked_ = true;
+            return;
+        }
+        const std::uint32_t span = ms - ref_ms_;
+        if (span >= MIN_RATE_SPAN_MS) {
+            const std::int64_t lag = static_cast<std::int64_t>(seconds - ref_seconds_) * 1000 - span;
+            rate_ = clamp(static_cast<std::int32_t>(lag * (1L << 20) / static_cast<std::int64_t>(span)), MAX_RATE);
+        }
+        if (span >= MAX_RATE_SPAN_MS) {
+            ref_seconds_ = seconds;
+            ref_ms_ = ms;
+        }
+        anchor(clock_seconds, millisecond, ms);
+        slew_ = clamp(rate_ + static_cast<std::int32_t>(static_cast<std::int64_t>(offset) * (1L << 20) / SYNC_MS),
+                      MAX_SLEW);
+    }
+};
+
+} // namespace wall_clock
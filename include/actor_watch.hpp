@@ -0,0 +1,336 @@
+#pragma once
+#include "binary_frame.hpp"
+#include "event.hpp"
+#include "pgm_array.hpp"
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Live variables for host software: a table of watchable variables that the compiler builds into flash, read and
+// written over the binary protocol (BinaryEndpointActor's WATCH_* requests) and sampled at a fixed rate, for field
+// debugging without a text command, string formatting on the board or a new build. Each entry holds the address and
+// type of a variable and a hash of its name, as written in the table; the names stay on the host, which finds a
+// variable by hashing its name the same way (tools/watch.py):
+//
+//     constexpr auto WATCHES PROGMEM = ramen::pgm_array<watch::Entry>({
+//         WATCH(timer.last_error),
+//         WATCH(led1.blink_interval_ms),
+//         WATCH(scan_time.scans),       // Globals and their public members, of the types of watch::Type
+//     });
+//     watch::WatchActor watches(WATCHES);
+//     commander.attach_watch(watches);
+//     watches.arm_timer_request_out >> timer.arm_timer_request_in;  // And disarm_timer_request_out
+//
+// WATCH_LIST pages through the table, WATCH_READ and WATCH_WRITE take up to MAX_BATCH variables by index, and
+// WATCH_SAMPLE subscribes to frames of up to MAX_BATCH of them, sent by a TimerActor timer every `period_ms`:
+//
+//     51 seq time:u32 {value}*count
+//
+// with the values in the order subscribed, each as wide as its type, and `time` the scan clock in milliseconds. As
+// with telemetry, a frame that does not fit the output right away is skipped, and `seq` shows the host which. A write
+// checks every index and value width first and changes nothing unless all are valid; variables declared const are
+// read-only. Each variable is copied with interrupts disabled, so a value an interrupt writes is never torn.
+//
+// Opt-in with -D LIVE_WATCH, with -D SERIAL_BINARY_PROTOCOL; without it the requests are answered UNKNOWN_TYPE.
+
+namespace watch {
+
+#if defined(LIVE_WATCH)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t MAX_BATCH = 8;       // Variables per read, write or sampling subscription
+constexpr std::uint8_t MAX_LIST = 8;        // Entries per WATCH_LIST reply
+constexpr std::uint16_t MIN_PERIOD_MS = 10; // Of the samples; 8 values of 4 bytes take 5 ms at 115200 baud
+constexpr std::uint8_t SAMPLE_FRAME_TYPE = 0x51;
+constexpr std::uint8_t TIMERS = ENABLED ? 1 : 0;  // TimerActor slots of a WatchActor, for the sample frames
+
+enum Type : std::uint8_t { U8 = 0, I8 = 1, U16 = 2, I16 = 3, U32 = 4, I32 = 5, F32 = 6, BOOL = 7 };
+constexpr std::uint8_t READ_ONLY = 0x80;  // Flag of Entry::type
+constexpr std::uint8_t TYPE_MASK = 0x7F;
+
+constexpr std::uint8_t width(std::uint8_t type) {
+    switch (type & TYPE_MASK) {
+        case U16: case I16: return 2;
+        case U32: case I32: case F32: return 4;
+        default: return 1;
+    }
+}
+
+// FNV-1a, as tools/watch.py hashes the names
+constexpr std::uint32_t hash(const char* name) {
+    std::uint32_t h = 2166136261UL;
+    for (; *name != '\0'; ++name) {
+        h = (h ^ static_cast<std::uint8_t>(*name)) * 16777619UL;
+    }
+    return h;
+}
+
+struct Entry {
+    const void* address;
+    std::uint32_t hash;
+    std::uint8_t type;  // A Type, and READ_ONLY
+};
+
+template <class T>
+constexpr std::uint8_t type_of() {
+    using V = std::remove_cv_t<T>;
+    if constexpr (std::is_enum_v<V>) {
+        return type_of<std::underlying_type_t<V>>();
+    } else if constexpr (std::is_same_v<V, bool>) {
+        return BOOL;
+    } else if constexpr (std::is_same_v<V, float>) {
+        return F32;
+    } else {
+        static_assert(std::is_integral_v<V> && sizeof(V) <= 4, "Watched variables are integers, float or bool");
+        constexpr std::uint8_t base = sizeof(V) == 1 ? U8 : sizeof(V) == 2 ? U16 : U32;
+        return static_cast<std::uint8_t>(base + (std::is_signed_v<V> ? 1U : 0U));
+    }
+}
+
+template <class T>
+constexpr Entry entry(T* variable, const char* name) {
+    const void* const address = const_cast<const void*>(static_cast<const volatile void*>(variable));
+    return Entry{address, hash(name), static_cast<std::uint8_t>(type_of<T>() | (std::is_const_v<T> ? READ_ONLY : 0U))};
+}
+
+// A request of BinaryEndpointActor's WATCH_* types, answered into `reply`
+struct RequestEvent {
+    enum Kind : std::uint8_t { LIST, READ, WRITE, SAMPLE };
+    enum Status : std::uint8_t { UNHANDLED, OK, BAD_LENGTH, BAD_INDEX, BAD_PERIOD, NOT_WRITABLE };
+    struct Reply {
+        Status status = UNHANDLED;
+        std::uint8_t length = 0;  // Bytes written into `data`
+    };
+    Kind kind;
+    const std::uint8_t* body;
+    std::uint8_t length;
+    std::uint8_t* data;  // Room for REPLY_SIZE bytes
+    Reply* reply;
+    ramen::Pusher<ramen::Span<const std::uint8_t>>* frame_out;  // Of the endpoint, for the samples
+    ramen::Puller<bool>* output_ready;                           // Of the endpoint: room for a frame right away
+};
+
+constexpr std::uint8_t REPLY_SIZE = 2 + 5 * MAX_LIST;  // WATCH_LIST: total count {hash:u32 type}*count
+constexpr std::uint8_t MAX_REQUEST = 5 * MAX_BATCH;   // WATCH_WRITE: {index value:u32}*MAX_BATCH
+
+class WatchActor {
+public:
+    template <std::size_t N>
+    explicit WatchActor(const ramen::PgmArray<Entry, N>& table) :
+        event_handler_in([this](const BaseEvent& event) {
+            EventRouter<AppEvents, WatchActor, TickEvent>::dispatch(*this, event);
+        }),
+        table_P_(table.data_P()),
+        size_(static_cast<std::uint8_t>(N))
+    {
+        static_assert(N <= 255, "At most 255 watched variables");
+        timeout_event_relay_out >> event_handler_in;
+    }
+    WatchActor(const WatchActor&) = delete;
+    WatchActor& operator=(const WatchActor&) = delete;
+
+    ramen::Pushable<const RequestEvent&> request_in =
+        [this](const RequestEvent& evt) {
+            RequestEvent::Reply& reply = *evt.reply;
+            reply.length = 0;
+            switch (evt.kind) {
+                case RequestEvent::LIST: reply.status = list(evt.body, evt.length, evt.data, reply.length); break;
+                case RequestEvent::READ: reply.status = read(evt.body, evt.length, evt.data, reply.length); break;
+                case RequestEvent::WRITE: reply.status = write(evt.body, evt.length); break;
+                case RequestEvent::SAMPLE: reply.status = subscribe(evt); break;
+            }
+        };
+
+    // Routed from event_handler_in
+    void on_event(const TickEvent&) {
+        if (sampled_ == 0 || frame_out_ == nullptr) {
+            return;
+        }
+        bool ready = true;  // Unlinked: always
+        if (output_ready_ != nullptr) {
+            (*output_ready_)(ready);
+        }
+        const std::uint8_t seq = seq_++;
+        if (!ready) {
+            count(skipped_);
+            return;
+        }
+        std::uint8_t payload[6 + 4 * MAX_BATCH + binary_frame::CRC_SIZE];
+        payload[0] = SAMPLE_FRAME_TYPE;
+        payload[1] = seq;
+        binary_frame::write_le32(payload + 2, scan_clock::now());
+        std::uint8_t n = 6;
+        for (std::uint8_t i = 0; i < sampled_; ++i) {
+            n = static_cast<std::uint8_t>(n + copy_out(entry(samples_[i]), payload + n));
+        }
+        const std::size_t length = binary_frame::append_crc(payload, n);
+        std::uint8_t wire[binary_frame::max_frame(sizeof(payload))];
+        (*frame_out_)(ramen::Span<const std::uint8_t>(wire, binary_frame::encode_frame(payload, length, wire)));
+    }
+
+    std::uint8_t size() const { return size_; }
+    std::uint16_t writes() const { return writes_; }    // Variables written, saturating at 65535
+    std::uint16_t skipped() const { return skipped_; }  // Sample frames the output had no room for
+
+    ramen::Pushable<const BaseEvent&> event_handler_in;
+
+    // Timer requests, for a TimerActor
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+
+private:
+    const Entry* table_P_;
+    std::uint8_t size_;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    TimerHandle timer_handle_;
+    ramen::Pusher<ramen::Span<const std::uint8_t>>* frame_out_ = nullptr;  // Of the subscribed endpoint
+    ramen::Puller<bool>* output_ready_ = nullptr;
+    std::uint8_t samples_[MAX_BATCH] = {};
+    std::uint8_t sampled_ = 0;
+    std::uint8_t seq_ = 0;
+    std::uint16_t writes_ = 0;
+    std::uint16_t skipped_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    Entry entry(std::uint8_t index) const { return ramen::pgm_read(table_P_ + index); }
+
+    // Copies the value of a variable into `out` and returns its width
+    static std::uint8_t copy_out(const Entry& e, std::uint8_t* out) {
+        const std::uint8_t n = width(e.type);
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+        std::memcpy(out, e.address, n);
+        SREG = sreg;
+#else
+        std::memcpy(out, e.address, n);
+#endif
+        return n;
+    }
+
+    static void copy_in(const Entry& e, const std::uint8_t* in) {
+        void* const address = const_cast<void*>(e.address);  // Not READ_ONLY, so not declared const
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+        std::memcpy(address, in, width(e.type));
+        SREG = sreg;
+#else
+        std::memcpy(address, in, width(e.type));
+#endif
+    }
+
+    RequestEvent::Status list(const std::uint8_t* body, std::uint8_t length, std::uint8_t* data,
+                              std::uint8_t& reply_length) const {
+        if (length != 1) {
+            return RequestEvent::BAD_LENGTH;
+        }
+        const std::uint8_t from = body[0];
+        std::uint8_t count = 0;
+        for (std::uint8_t i = from; i < size_ && count < MAX_LIST; ++i, ++count) {
+            const Entry e = entry(i);
+            binary_frame::write_le32(data + 2 + 5 * count, e.hash);
+            data[6 + 5 * count] = e.type;
+        }
+        data[0] = size_;
+        data[1] = count;
+        reply_length = static_cast<std::uint8_t>(2 + 5 * count);
+        return RequestEvent::OK;
+    }
+
+    RequestEvent::Status read(const std::uint8_t* body, std::uint8_t length, std::uint8_t* data,
+                              std::uint8_t& reply_length) const {
+        if (length == 0 || length > MAX_BATCH) {
+            return RequestEvent::BAD_LENGTH;
+        }
+        for (std::uint8_t i = 0; i < length; ++i) {
+            if (body[i] >= size_) {
+                return RequestEvent::BAD_INDEX;
+            }
+        }
+        std::uint8_t n = 0;
+        for (std::uint8_t i = 0; i < length; ++i) {
+            n = static_cast<std::uint8_t>(n + copy_out(entry(body[i]), data + n));
+        }
+        reply_length = n;
+        return RequestEvent::OK;
+    }
+
+    // Checks the whole batch before writing any of it
+    RequestEvent::Status write(const std::uint8_t* body, std::uint8_t length) {
+        if (length == 0) {
+            return RequestEvent::BAD_LENGTH;
+        }
+        std::uint8_t offset = 0;
+        std::uint8_t variables = 0;
+        while (offset < length) {
+            if (body[offset] >= size_) {
+                return RequestEvent::BAD_INDEX;
+            }
+            const Entry e = entry(body[offset]);
+            if (e.type & READ_ONLY) {
+                return RequestEvent::NOT_WRITABLE;
+            }
+            offset = static_cast<std::uint8_t>(offset + 1U + width(e.type));
+            if (offset > length || ++variables > MAX_BATCH) {
+                return RequestEvent::BAD_LENGTH;
+            }
+        }
+        for (offset = 0; offset < length;) {
+            const Entry e = entry(body[offset]);
+            copy_in(e, body + offset + 1);
+            offset = static_cast<std::uint8_t>(offset + 1U + width(e.type));
+            count(writes_);
+        }
+        return RequestEvent::OK;
+    }
+
+    // period:u16 {index}*count; no indices stop the samples
+    RequestEvent::Status subscribe(const RequestEvent& evt) {
+        if (evt.length < 2 || evt.length > 2U + MAX_BATCH) {
+            return RequestEvent::BAD_LENGTH;
+        }
+        const std::uint16_t period = binary_frame::read_le16(evt.body);
+        const std::uint8_t count = static_cast<std::uint8_t>(evt.length - 2U);
+        for (std::uint8_t i = 0; i < count; ++i) {
+            if (evt.body[2 + i] >= size_) {
+                return RequestEvent::BAD_INDEX;
+            }
+        }
+        if (count > 0 && period < MIN_PERIOD_MS) {
+            return RequestEvent::BAD_PERIOD;
+        }
+        std::memcpy(samples_, evt.body + 2, count);
+        sampled_ = count;
+        frame_out_ = evt.frame_out;
+        output_ready_ = evt.output_ready;
+        if (count == 0) {
+            if (timer_handle_.valid()) {
+                DisarmTimerEvt disarm(timer_handle_);
+                disarm_timer_request_out(disarm);
+                timer_handle_ = TimerHandle{};
+            }
+        } else {
+            ArmTimerEvt arm(period, &timeout_event_relay_out, true, &timer_handle_);
+            arm_timer_request_out(arm);
+        }
+        return RequestEvent::OK;
+    }
+};
+
+} // namespace watch
+
+// An entry for the table of watch::WatchActor, named as written
+#define WATCH(variable) ::watch::entry(&(variable), #variable)
@@ -0,0 +1,300 @@
+#pragma once
+#include "ramen.hpp"
+#include "ramen_mailbox.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Analog acquisition without analogRead(): the ADC converts a scan list on its own, in free-running mode (one
+// conversion every 13 ADC clocks, about 104 us at clk/128) or auto-triggered by the Timer0 overflow behind millis()
+// (one conversion every 1.024 ms). The conversion-complete interrupt (src/adc_pipeline.cpp) posts each result to the
+// `ring` mailbox and points the multiplexer at the channel due next. ScanActor::update() reassembles the results into
+// one frame per scan, a value per channel, and pushes it as a Span; the filters below take and produce such frames:
+//
+//     adc::ScanActor<3> scan({CONTROLLINO_A0, CONTROLLINO_A1, CONTROLLINO_A2});
+//     adc::Oversampler<3, 2> oversample;     // 12-bit values from 16 scans
+//     adc::Iir<3, 3> smooth;                 // y += (x - y) / 8
+//     void setup() {
+//         scan.frame_out >> oversample.in;
+//         oversample.out >> smooth.in;
+//         smooth.out >> level_display.in;
+//         scan.start();
+//     }
+//     void loop()  { scan.update(); }
+//
+// Frames refer to the actor's buffers and are only valid during the dispatch. Once the ADC runs on its own,
+// analogRead() must not be used. Opt-in with -D ADC_FREE_RUNNING; otherwise, and off AVR, update() converts one
+// channel per call with analogRead().
+
+#ifndef ADC_RING_SIZE
+#define ADC_RING_SIZE 32  // Results buffered between two update() calls; a power of two
+#endif
+
+namespace adc {
+
+constexpr std::uint8_t MAX_CHANNELS = 16;
+
+enum class Trigger : std::uint8_t {
+    FREE_RUNNING,    // Back-to-back conversions
+    TIMER0_OVERFLOW  // One conversion per millis() tick
+};
+
+struct Sample {
+    std::uint8_t index;  // Position in the scan list
+    std::uint16_t value;
+};
+
+using Frame = ramen::Span<const std::uint16_t>;
+
+// Scan list and results of the interrupt; one ScanActor owns them
+inline ramen::SpscMailbox<Sample, ADC_RING_SIZE> ring;
+inline std::array<std::uint8_t, MAX_CHANNELS> scan_mux{};
+inline std::uint8_t scan_length = 1;
+inline std::uint8_t scan_lead = 1;  // Conversions between a result and the one the multiplexer is set for
+inline std::uint8_t scan_pos = 0;   // Scan index of the conversion completing next; interrupt side only
+
+// Multiplexer channel of an analog pin (CONTROLLINO_A0.. or A0..) or of a channel number 0..15
+inline std::uint8_t mux_of(std::uint8_t pin) {
+    return (pin >= 54U) ? static_cast<std::uint8_t>(pin - 54U) : pin;
+}
+
+inline void select(std::uint8_t mux) {
+#if defined(__AVR__) && defined(ADCSRB)
+    // Both registers are latched when a conversion starts, so the running conversion is not affected
+    ADCSRB = static_cast<std::uint8_t>((ADCSRB & ~_BV(MUX5)) | ((mux & 0x08U) ? _BV(MUX5) : 0U));
+    ADMUX = static_cast<std::uint8_t>(_BV(REFS0) | (mux & 0x07U));  // AVcc reference
+#else
+    (void)mux;
+#endif
+}
+
+inline std::uint8_t scan_next(std::uint8_t index, std::uint8_t steps) {
+    index = static_cast<std::uint8_t>(index + steps);
+    while (index >= scan_length) {
+        index = static_cast<std::uint8_t>(index - scan_length);
+    }
+    return index;
+}
+
+// Interrupt side: takes the result of one conversion
+inline void on_conversion(std::uint16_t value) {
+    const std::uint8_t pos = scan_pos;
+    ring.push(Sample{pos, value});
+    scan_pos = scan_next(pos, 1);
+    if (scan_length > 1U) {
+        select(scan_mux[scan_next(pos, static_cast<std::uint8_t>(scan_lead + 1U))]);
+    }
+}
+
+#if defined(__AVR__) && defined(ADC_FREE_RUNNING)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+template <std::uint8_t Channels>
+class ScanActor {
+    static_assert(Channels > 0 && Channels <= MAX_CHANNELS, "The ADC multiplexes 1 to 16 channels");
+
+public:
+    ramen::Pusher<Frame> frame_out;
+    ramen::Pushable<Sample> sample_in = [this](const Sample& s) { take(s); };
+
+    explicit ScanActor(const std::array<std::uint8_t, Channels>& pins) : pins_(pins) {
+        ring.out >> sample_in;
+    }
+
+    // Starts converting the scan list; the first frame follows one scan later
+    void start(Trigger trigger = Trigger::FREE_RUNNING) {
+        for (std::uint8_t i = 0; i < Channels; ++i) {
+            scan_mux[i] = mux_of(pins_[i]);
+        }
+        scan_length = Channels;
+        scan_pos = 0;
+        next_ = 0;
+        complete_ = true;
+#if defined(__AVR__) && defined(ADC_FREE_RUNNING)
+        // A free-running ADC has started the next conversion by the time a result is read, so the multiplexer is set
+        // two conversions ahead; a triggered one waits for the trigger, one conversion ahead is enough
+        scan_lead = (trigger == Trigger::FREE_RUNNING) ? 1U : 0U;
+        ADCSRA = 0;
+        select(scan_mux[0]);
+        ADCSRB = static_cast<std::uint8_t>((ADCSRB & _BV(MUX5)) |
+                                           ((trigger == Trigger::TIMER0_OVERFLOW) ? (_BV(ADTS2)) : 0U));
+        ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADIF) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);  // clk/128
+        if (trigger == Trigger::FREE_RUNNING) {
+            ADCSRA |= _BV(ADSC);
+            select(scan_mux[scan_next(0, 1)]);  // Taken up by the second conversion
+        }
+#else
+        (void)trigger;
+        scan_lead = 0;
+#endif
+        started_ = true;
+    }
+
+    void stop() {
+#if defined(__AVR__) && defined(ADC_FREE_RUNNING)
+        ADCSRA = static_cast<std::uint8_t>(ADCSRA & ~(_BV(ADATE) | _BV(ADIE)));
+#endif
+        started_ = false;
+    }
+
+    // From loop(): takes over the results converted since the last call; frames are pushed from here
+    void update() {
+        if (!started_) {
+            return;
+        }
+        if (ENABLED) {
+            ring.drain();
+        } else {
+            take(Sample{next_, static_cast<std::uint16_t>(analogRead(pins_[next_]))});
+        }
+    }
+
+    // Results lost because update() ran too seldom; the scans they belonged to are dropped
+    std::uint8_t overruns() const { return ring.dropped(); }
+
+private:
+    const std::array<std::uint8_t, Channels> pins_;
+    std::array<std::uint16_t, Channels> frame_{};
+    std::uint8_t next_ = 0;   // Scan index expected next
+    bool complete_ = true;    // No result of the current scan is missing
+    bool started_ = false;
+
+    void take(const Sample& s) {
+        if (s.index >= Channels) {
+            return;
+        }
+        complete_ = complete_ && s.index == next_;
+        frame_[s.index] = s.value;
+        next_ = (s.index + 1U < Channels) ? static_cast<std::uint8_t>(s.index + 1U) : 0;
+        if (next_ == 0) {
+            if (complete_) {
+                frame_out(Frame(frame_));
+            }
+            complete_ = true;
+        }
+    }
+};
+
+// Moving average over the last Window frames (a power of two), from a running sum per channel
+template <std::uint8_t Channels, std::uint8_t Window>
+class MovingAverage {
+    static_assert(Window > 0 && (Window & (Window - 1U)) == 0 && Window <= 64, "Window must be a power of two <= 64");
+
+public:
+    ramen::Pushable<Frame> in = [this](const Frame& frame) { filter(frame); };
+    ramen::Pusher<Frame> out;
+
+private:
+    std::array<std::array<std::uint16_t, Channels>, Window> history_{};
+    std::array<std::uint32_t, Channels> sum_{};
+    std::array<std::uint16_t, Channels> value_{};
+    std::uint8_t oldest_ = 0;
+    bool primed_ = false;
+
+    void filter(const Frame& frame) {
+        const std::uint8_t n = (frame.size() < Channels) ? static_cast<std::uint8_t>(frame.size()) : Channels;
+        for (std::uint8_t ch = 0; ch < n; ++ch) {
+            if (!primed_) {
+                for (auto& row : history_) {
+                    row[ch] = frame[ch];  // Starts from a window full of the first value
+                }
+                sum_[ch] = static_cast<std::uint32_t>(frame[ch]) * Window;
+            }
+            sum_[ch] = sum_[ch] - history_[oldest_][ch] + frame[ch];
+            history_[oldest_][ch] = frame[ch];
+            value_[ch] = static_cast<std::uint16_t>(sum_[ch] / Window);
+        }
+        primed_ = true;
+        oldest_ = static_cast<std::uint8_t>((oldest_ + 1U) & (Window - 1U));
+        out(Frame(value_.data(), n));
+    }
+};
+
+// First-order low-pass y += (x - y) / 2^Shift, with Shift fraction bits kept per channel
+template <std::uint8_t Channels, std::uint8_t Shift>
+class Iir {
+    static_assert(Shift > 0 && Shift <= 15, "Shift must be in [1, 15]");
+
+public:
+    ramen::Pushable<Frame> in = [this](const Frame& frame) { filter(frame); };
+    ramen::Pusher<Frame> out;
+
+private:
+    std::array<std::uint32_t, Channels> acc_{};  // y * 2^Shift
+    std::array<std::uint16_t, Channels> value_{};
+    bool primed_ = false;
+
+    void filter(const Frame& frame) {
+        const std::uint8_t n = (frame.size() < Channels) ? static_cast<std::uint8_t>(frame.size()) : Channels;
+        for (std::uint8_t ch = 0; ch < n; ++ch) {
+            if (primed_) {
+                acc_[ch] = acc_[ch] - (acc_[ch] >> Shift) + frame[ch];
+            } else {
+                acc_[ch] = static_cast<std::uint32_t>(frame[ch]) << Shift;
+            }
+            value_[ch] = static_cast<std::uint16_t>(acc_[ch] >> Shift);
+        }
+        primed_ = true;
+        out(Frame(value_.data(), n));
+    }
+};
+
+// Oversampling and decimation: sums 4^ExtraBits frames and pushes one frame with ExtraBits more bits of resolution.
+// The extra bits are only real if the input carries noise of at least one LSB.
+template <std::uint8_t Channels, std::uint8_t ExtraBits>
+class Oversampler {
+    static_assert(ExtraBits > 0 && ExtraBits <= 6, "A 10-bit ADC oversamples to at most 16 bits");
+    static constexpr std::uint16_t FRAMES = static_cast<std::uint16_t>(1U << (2U * ExtraBits));
+
+public:
+    ramen::Pushable<Frame> in = [this](const Frame& frame) { filter(frame); };
+    ramen::Pusher<Frame> out;
+
+private:
+    std::array<std::uint32_t, Channels> sum_{};
+    std::array<std::uint16_t, Channels> value_{};
+    std::uint16_t count_ = 0;
+
+    void filter(const Frame& frame) {
+        const std::uint8_t n = (frame.size() < Channels) ? static_cast<std::uint8_t>(frame.size()) : Channels;
+        for (std::uint8_t ch = 0; ch < n; ++ch) {
+            sum_[ch] += frame[ch];
+        }
+        if (++count_ < FRAMES) {
+            return;
+        }
+        for (std::uint8_t ch = 0; ch < Channels; ++ch) {
+            value_[ch] = static_cast<std::uint16_t>(sum_[ch] >> ExtraBits);
+            sum_[ch] = 0;
+        }
+        count_ = 0;
+        out(Frame(value_.data(), n));
+    }
+};
+
+// Forwards every Factor-th frame, e.g. after a filter that already averaged over the frames dropped
+template <std::uint8_t Factor>
+class Decimator {
+    static_assert(Factor > 0, "Factor must be positive");
+
+public:
+    ramen::Pushable<Frame> in = [this](const Frame& frame) {
+        if (++count_ >= Factor) {
+            count_ = 0;
+            out(frame);
+        }
+    };
+    ramen::Pusher<Frame> out;
+
+private:
+    std::uint8_t count_ = 0;
+};
+
+} // namespace adc
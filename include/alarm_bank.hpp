@@ -0,0 +1,219 @@
+#pragma once
+#include "adc_pipeline.hpp"
+#include "ramen.hpp"
+#include <array>
+#include <cstdint>
+
+// A bank of analog alarms: HH, H, L and LL limits with hysteresis and delays on every channel, checked together once
+// per execution in a loop over integer arrays, where an actor with a state machine and ports per channel would cost
+// several times the RAM and a dispatch per channel.
+//
+// Like the PID bank (pid_bank.hpp), the channels are kept as a structure of arrays and evaluated by update(), as a
+// task of a rate group of the cyclic executive. Measurements come from the frames of the ADC pipeline, each channel
+// taking the value of its channel of the frame, or from set_measurement() in any integer or fixed-point scale; the
+// limits are in the same units. Only changes leave the bank, as one Event each:
+//
+//     alarms::AlarmBank<4> alarms;
+//     constexpr cyclic::Task CHECKS[] PROGMEM = {cyclic::task<&alarms::AlarmBank<4>::update>(alarms)};
+//
+//     void setup() {
+//         smooth.out >> alarms.measurement_in;         // ADC counts, an alarm channel per ADC channel
+//         alarms.event_out >> events.alarm_in;
+//         alarms.set_limit(0, alarms::HH, 900);        // Tank level: high-high at 900 counts...
+//         alarms.set_limit(0, alarms::H, 800);
+//         alarms.set_limit(0, alarms::LL, 100);        // ...and low-low at 100, with no H/L pair below it
+//         alarms.set_hysteresis(0, 20);                // Clears 20 counts inside a limit
+//         alarms.set_delays(0, 5, 0);                  // Raised after 5 more executions beyond the limit
+//     }
+//
+// The level of a channel is the most severe of its enabled limits that the measurement has reached: HH or H at or
+// above the limit, LL or L at or below it. A level is left, toward NORMAL, only once the measurement is `hysteresis`
+// inside its limit, so a value hovering at a limit does not chatter. A new level is then reported only if it holds
+// for `on_delay` more executions when it is more severe than the reported one, and `off_delay` when it is less;
+// a level that changes again in the meantime starts its delay afresh.
+//
+// The state of a channel is a byte: the reported and the pending level, 3 bits each. With the limits and the delay
+// counter a channel takes 17 bytes.
+
+namespace alarms {
+
+enum Level : std::int8_t { LL = -2, L = -1, NORMAL = 0, H = 1, HH = 2 };
+
+inline constexpr std::uint8_t severity(Level level) {
+    return static_cast<std::uint8_t>(level < 0 ? -level : level);
+}
+
+struct Event {
+    std::uint8_t channel;
+    Level from;
+    Level to;
+    std::int16_t value;  // The measurement of the execution that reported it
+};
+
+template <std::uint8_t N>
+class AlarmBank {
+    static_assert(N > 0 && N <= adc::MAX_CHANNELS, "A bank holds 1 to 16 channels");
+
+public:
+    static constexpr std::uint8_t SIZE = N;
+
+    // Input: a frame of measurements, of which alarm i takes the value of its channel (i unless configured)
+    ramen::Pushable<adc::Frame> measurement_in = [this](const adc::Frame& frame) {
+        for (std::uint8_t i = 0; i < N; ++i) {
+            if (channel_[i] < frame.size()) {
+                const std::uint16_t value = frame[channel_[i]];
+                pv_[i] = static_cast<std::int16_t>((value > INT16_MAX) ? INT16_MAX : value);
+            }
+        }
+    };
+
+    // Output: a change of the reported level of a channel
+    ramen::Pusher<Event> event_out;
+
+    AlarmBank() {
+        for (std::uint8_t i = 0; i < N; ++i) {
+            channel_[i] = i;
+            state_[i] = pack(NORMAL, NORMAL);
+        }
+    }
+
+    // Enables a limit, HH or H crossed at or above `value`, L or LL at or below it; NORMAL does nothing
+    void set_limit(std::uint8_t i, Level level, std::int16_t value) {
+        if (i >= N || level == NORMAL) {
+            return;
+        }
+        limit(i, level) = value;
+        enabled_[i] = static_cast<std::uint8_t>(enabled_[i] | bit(level));
+    }
+
+    void clear_limit(std::uint8_t i, Level level) {
+        if (i < N && level != NORMAL) {
+            enabled_[i] = static_cast<std::uint8_t>(enabled_[i] & ~bit(level));
+        }
+    }
+
+    void set_hysteresis(std::uint8_t i, std::uint16_t hysteresis) {
+        if (i < N) {
+            hysteresis_[i] = hysteresis;
+        }
+    }
+
+    // Executions a new level must hold for before it is reported: a more severe one, and a less severe one
+    void set_delays(std::uint8_t i, std::uint16_t on_delay, std::uint16_t off_delay) {
+        if (i < N) {
+            on_delay_[i] = on_delay;
+            off_delay_[i] = off_delay;
+        }
+    }
+
+    void set_channel(std::uint8_t i, std::uint8_t channel) {
+        if (i < N) {
+            channel_[i] = channel;
+        }
+    }
+
+    // Sets the measurement directly, without a frame
+    void set_measurement(std::uint8_t i, std::int16_t value) {
+        if (i < N) {
+            pv_[i] = value;
+        }
+    }
+
+    Level level(std::uint8_t i) const { return (i < N) ? reported(i) : NORMAL; }
+    bool active(std::uint8_t i) const { return level(i) != NORMAL; }
+    std::int16_t measurement(std::uint8_t i) const { return (i < N) ? pv_[i] : 0; }
+    std::uint16_t changes() const { return changes_; }  // Events sent, saturating at 65535
+
+    // Channels with a level other than NORMAL, a bit each
+    std::uint16_t active_mask() const {
+        std::uint16_t mask = 0;
+        for (std::uint8_t i = 0; i < N; ++i) {
+            if (reported(i) != NORMAL) {
+                mask = static_cast<std::uint16_t>(mask | (1U << i));
+            }
+        }
+        return mask;
+    }
+
+    // One evaluation of every channel, and an Event for each that changes level
+    void update() {
+        for (std::uint8_t i = 0; i < N; ++i) {
+            const Level current = reported(i);
+            const Level target = zone(i, current);
+            if (target == current) {
+                state_[i] = pack(current, current);
+                count_[i] = 0;
+                continue;
+            }
+            if (target != pending(i)) {
+                state_[i] = pack(current, target);
+                count_[i] = 0;
+            }
+            const std::uint16_t delay = (severity(target) > severity(current)) ? on_delay_[i] : off_delay_[i];
+            if (count_[i] < delay) {
+                ++count_[i];
+                continue;
+            }
+            state_[i] = pack(target, target);
+            count_[i] = 0;
+            if (changes_ != UINT16_MAX) {
+                ++changes_;
+            }
+            event_out(Event{i, current, target, pv_[i]});
+        }
+    }
+
+private:
+    std::array<std::int16_t, N> pv_{};
+    std::array<std::int16_t, N> hh_{};
+    std::array<std::int16_t, N> h_{};
+    std::array<std::int16_t, N> l_{};
+    std::array<std::int16_t, N> ll_{};
+    std::array<std::uint16_t, N> hysteresis_{};
+    std::array<std::uint16_t, N> on_delay_{};
+    std::array<std::uint16_t, N> off_delay_{};
+    std::array<std::uint16_t, N> count_{};    // Executions the pending level has held
+    std::array<std::uint8_t, N> state_{};     // Reported level + 2 in bits 0-2, pending level + 2 in bits 3-5
+    std::array<std::uint8_t, N> enabled_{};   // Limits, by bit()
+    std::array<std::uint8_t, N> channel_{};
+    std::uint16_t changes_ = 0;
+
+    static constexpr std::uint8_t bit(Level level) { return static_cast<std::uint8_t>(1U << (level + 2)); }
+
+    static constexpr std::uint8_t pack(Level reported, Level pending) {
+        return static_cast<std::uint8_t>((reported + 2) | ((pending + 2) << 3));
+    }
+    Level reported(std::uint8_t i) const { return static_cast<Level>((state_[i] & 0x07) - 2); }
+    Level pending(std::uint8_t i) const { return static_cast<Level>(((state_[i] >> 3) & 0x07) - 2); }
+
+    std::int16_t& limit(std::uint8_t i, Level level) {
+        switch (level) {
+            case HH: return hh_[i];
+            case H: return h_[i];
+            case L: return l_[i];
+            default: return ll_[i];
+        }
+    }
+
+    // The level the measurement is in, with the hysteresis taken toward the level it is reported in
+    Level zone(std::uint8_t i, Level current) const {
+        const std::int32_t pv = pv_[i];
+        const std::int32_t hy = hysteresis_[i];
+        const std::uint8_t on = enabled_[i];
+        if ((on & bit(HH)) && (pv >= hh_[i] || (current == HH && pv > hh_[i] - hy))) {
+            return HH;
+        }
+        if ((on & bit(H)) && (pv >= h_[i] || (current >= H && pv > h_[i] - hy))) {
+            return H;
+        }
+        if ((on & bit(LL)) && (pv <= ll_[i] || (current == LL && pv < ll_[i] + hy))) {
+            return LL;
+        }
+        if ((on & bit(L)) && (pv <= l_[i] || (current <= L && pv < l_[i] + hy))) {
+            return L;
+        }
+        return NORMAL;
+    }
+};
+
+} // namespace alarms
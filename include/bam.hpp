@@ -0,0 +1,203 @@
+#pragma once
+#include "fast_pin.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Software dimming (lamps, proportional valves) on any digital outputs by bit-angle modulation from Timer1.
+//
+// An 8-bit duty is shown as 8 time slices of 1, 2, 4 ... 128 units; during slice b every channel whose duty has bit b
+// set is high. The Timer1 compare interrupt starts each slice and writes one precomputed bit plane per port, so its
+// cost grows with the number of ports in use, not with the number of channels. A frame lasts 255 units
+// (BAM_UNIT_US, 16 us by default: about 4 ms, 245 Hz).
+//
+// Duties arrive on the duty_in port of each channel; update() (called from loop()) rebuilds the planes in a shadow
+// buffer which the interrupt takes over at the next frame start, so a frame never mixes old and new duties:
+//
+//     bam::BamEngine<3> dimmer({CONTROLLINO_D4, CONTROLLINO_D5, CONTROLLINO_D6});
+//     BAM_TIMER_ISR(dimmer)
+//     void setup() { dimmer.start(); knob.level_out >> dimmer.channels[0].duty_in; }
+//     void loop()  { dimmer.update(); }
+//
+// Timer1 is taken from the Arduino core (no analogWrite on pins 11..13) and cannot be shared with hw_blink on those
+// pins. Channels must sit on at most MaxPorts ports of the pin table in fast_pin.hpp. Other bits of the ports stay
+// untouched, but they are written read-modify-write from the interrupt, so main-loop writes to them must be atomic
+// (FastPin on ports A..G, the process image or digitalWrite all are).
+
+#ifndef BAM_UNIT_US
+#define BAM_UNIT_US 16
+#endif
+
+namespace bam {
+
+constexpr std::uint8_t BITS = 8;
+constexpr std::uint16_t COUNTS_PER_UNIT = BAM_UNIT_US * 2U;  // Timer1 at clk/8: 0.5 us per count
+static_assert(BAM_UNIT_US >= 8, "Slices shorter than 8 us leave no time between interrupts");
+static_assert((static_cast<std::uint32_t>(COUNTS_PER_UNIT) << (BITS - 1U)) <= 0x10000UL, "Slice exceeds Timer1");
+
+template <std::uint8_t Channels, std::uint8_t MaxPorts = 2>
+class BamEngine {
+    static_assert(Channels > 0 && MaxPorts > 0, "BamEngine needs channels and ports");
+    using Planes = std::array<std::array<std::uint8_t, MaxPorts>, BITS>;
+
+public:
+    struct Channel {
+        ramen::Pushable<std::uint8_t> duty_in = [this](std::uint8_t duty) { owner->set_duty(index, duty); };
+        BamEngine* owner = nullptr;
+        std::uint8_t index = 0;
+    };
+    std::array<Channel, Channels> channels;
+
+    explicit BamEngine(const std::array<std::uint8_t, Channels>& pins) {
+        ports_.fill(NO_PORT);
+        for (std::uint8_t ch = 0; ch < Channels; ++ch) {
+            channels[ch].owner = this;
+            channels[ch].index = ch;
+            pins_[ch] = pins[ch];
+            attach(ch, pins[ch]);
+        }
+    }
+    BamEngine(const BamEngine&) = delete;
+    BamEngine& operator=(const BamEngine&) = delete;
+
+    // False if a pin is not in the pin table or the channels span more than MaxPorts ports; such channels stay low
+    bool ok() const { return ok_; }
+
+    void set_duty(std::uint8_t ch, std::uint8_t duty) {
+        if (ch < Channels && duty_[ch] != duty) {
+            duty_[ch] = duty;
+            dirty_ = true;
+        }
+    }
+    std::uint8_t duty(std::uint8_t ch) const { return (ch < Channels) ? duty_[ch] : 0; }
+
+    // Publishes changed duties once the interrupt has taken over the previous ones
+    void update() {
+        if (!dirty_ || swap_pending_) {
+            return;
+        }
+        dirty_ = false;
+        Planes& planes = planes_[active_ ^ 1U];
+        for (std::uint8_t b = 0; b < BITS; ++b) {
+            planes[b].fill(0);
+            for (std::uint8_t ch = 0; ch < Channels; ++ch) {
+                if (channel_port_[ch] != NO_PORT && ((duty_[ch] >> b) & 1U)) {
+                    planes[b][channel_port_[ch]] |= channel_mask_[ch];
+                }
+            }
+        }
+        swap_pending_ = true;  // Published last; the interrupt swaps buffers at the next frame start
+    }
+
+#if defined(__AVR__)
+    void start() {
+        const std::uint8_t sreg = SREG;
+        cli();
+        TCCR1A = 0;
+        TCCR1B = _BV(WGM12) | _BV(CS11);  // CTC with TOP = OCR1A, clk/8
+        TCNT1 = 0;
+        OCR1A = COUNTS_PER_UNIT - 1U;
+        TIFR1 = _BV(OCF1A);
+        TIMSK1 |= _BV(OCIE1A);
+        SREG = sreg;
+    }
+
+    void stop() {
+        TIMSK1 &= static_cast<std::uint8_t>(~_BV(OCIE1A));
+        TCCR1B = 0;
+        for (std::uint8_t p = 0; p < MaxPorts; ++p) {
+            write_port(p, 0);
+        }
+    }
+#else
+    void start() {}
+    void stop() {}
+#endif
+
+    // Body of the Timer1 compare A interrupt (BAM_TIMER_ISR): shows slice bit_ and sets the length of that slice
+    void on_slice() {
+        const std::uint8_t b = bit_;
+        if (b == 0 && swap_pending_) {
+            active_ ^= 1U;
+            swap_pending_ = false;
+        }
+        const auto& plane = planes_[active_][b];
+        for (std::uint8_t p = 0; p < MaxPorts; ++p) {
+            write_port(p, plane[p]);
+        }
+#if defined(__AVR__)
+        OCR1A = static_cast<std::uint16_t>((COUNTS_PER_UNIT << b) - 1U);  // The interrupt came at 0; this slice ends at TOP
+#endif
+        bit_ = static_cast<std::uint8_t>((b + 1U) % BITS);
+    }
+
+private:
+    static constexpr std::uint8_t NO_PORT = 0xFF;
+
+    std::array<std::uint8_t, Channels> pins_{};
+    std::array<std::uint8_t, Channels> duty_{};
+    std::array<std::uint8_t, Channels> channel_port_{};  // Index into ports_, NO_PORT if the channel is unusable
+    std::array<std::uint8_t, Channels> channel_mask_{};
+    std::array<std::uint8_t, MaxPorts> ports_{};         // Port index (A = 0) of each plane column
+    std::array<std::uint8_t, MaxPorts> port_mask_{};     // Bits of the port driven by channels
+    Planes planes_[2] = {};
+    volatile std::uint8_t active_ = 0;
+    volatile bool swap_pending_ = false;
+    std::uint8_t bit_ = 0;
+    bool dirty_ = false;
+    bool ok_ = true;
+
+    void attach(std::uint8_t ch, std::uint8_t pin) {
+        channel_port_[ch] = NO_PORT;
+        const gpio::detail::Port port = gpio::detail::pin_port(pin);
+        if (port == gpio::detail::Port::NONE) {
+            ok_ = false;
+            return;
+        }
+        const std::uint8_t index = static_cast<std::uint8_t>(static_cast<std::uint8_t>(port) - 1U);
+        std::uint8_t p = 0;
+        while (p < MaxPorts && ports_[p] != index && ports_[p] != NO_PORT) {
+            ++p;
+        }
+        if (p == MaxPorts) {
+            ok_ = false;
+            return;
+        }
+        ports_[p] = index;
+        channel_port_[ch] = p;
+        channel_mask_[ch] = static_cast<std::uint8_t>(1U << gpio::detail::pin_bit(pin));
+        port_mask_[p] |= channel_mask_[ch];
+        digitalWrite(pin, LOW);  // Also detaches PWM
+        pinMode(pin, OUTPUT);
+    }
+
+    void write_port(std::uint8_t p, std::uint8_t bits) {
+        if (ports_[p] == NO_PORT) {
+            return;
+        }
+#if defined(__AVR__) && defined(PORTA)
+        volatile std::uint8_t* reg = gpio::detail::port_register(ports_[p], false);
+        *reg = static_cast<std::uint8_t>((*reg & ~port_mask_[p]) | bits);
+#else
+        for (std::uint8_t ch = 0; ch < Channels; ++ch) {
+            if (channel_port_[ch] == p) {
+                digitalWrite(pins_[ch], (bits & channel_mask_[ch]) ? HIGH : LOW);
+            }
+        }
+#endif
+    }
+};
+
+} // namespace bam
+
+// Defines the Timer1 compare interrupt driving `engine`; place it once, at namespace scope, next to the engine
+#if defined(__AVR__)
+#define BAM_TIMER_ISR(engine) ISR(TIMER1_COMPA_vect) { (engine).on_slice(); }
+#else
+#define BAM_TIMER_ISR(engine)
+#endif
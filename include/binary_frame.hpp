@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVR__)
+#include <util/crc16.h>
+#endif
+
+// Framing for the binary command protocol: COBS byte stuffing, a CRC-16 and little-endian field access.
+//
+// COBS (Consistent Overhead Byte Stuffing) rewrites a payload so that it contains no zero byte, at a cost of one byte
+// per 254, which leaves 0x00 free as the frame delimiter; text lines never contain it either, so both can share a
+// port. A frame on the wire is a zero, the encoded payload and a zero. The payload ends in the CRC-16/CCITT-FALSE
+// (polynomial 0x1021, initial value 0xFFFF) of the bytes before it, low byte first:
+//
+//     std::size_t length = 0;
+//     if (binary_frame::cobs_decode(frame, received, length) && binary_frame::crc_ok(frame, length)) {
+//         handle(frame, length - binary_frame::CRC_SIZE);  // Decoded in place
+//     }
+//
+// Decoding happens in place, since it never writes ahead of where it reads.
+
+namespace binary_frame {
+
+constexpr std::uint8_t DELIMITER = 0x00;
+constexpr std::size_t CRC_SIZE = 2;
+
+// Buffer size for encoding `length` bytes
+constexpr std::size_t cobs_max_encoded(std::size_t length) { return length + length / 254U + 1U; }
+
+// Encodes `length` bytes of `in` into `out` (cobs_max_encoded(length) bytes) and returns the encoded length
+inline std::size_t cobs_encode(const std::uint8_t* in, std::size_t length, std::uint8_t* out) {
+    std::size_t code_at = 0;
+    std::size_t n = 1;
+    std::uint8_t code = 1;
+    for (std::size_t i = 0; i < length; ++i) {
+        if (in[i] == 0) {
+            out[code_at] = code;
+            code_at = n++;
+            code = 1;
+        } else {
+            out[n++] = in[i];
+            if (++code == 0xFF) {
+                out[code_at] = code;
+                code_at = n++;
+                code = 1;
+            }
+        }
+    }
+    out[code_at] = code;
+    return n;
+}
+
+// Decodes the `length` bytes at `data` in place; false if they are no valid encoding
+inline bool cobs_decode(std::uint8_t* data, std::size_t length, std::size_t& decoded) {
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < length) {
+        const std::uint8_t code = data[in++];
+        if (code == 0) {
+            return false;
+        }
+        for (std::uint8_t i = 1; i < code; ++i) {
+            if (in >= length) {
+                return false;
+            }
+            data[out++] = data[in++];
+        }
+        if (code != 0xFF && in < length) {
+            data[out++] = 0;
+        }
+    }
+    decoded = out;
+    return true;
+}
+
+inline std::uint16_t crc16_update(std::uint16_t crc, std::uint8_t byte) {
+#if defined(__AVR__)
+    return _crc_xmodem_update(crc, byte);  // Same polynomial, in hand-written assembly
+#else
+    crc = static_cast<std::uint16_t>(crc ^ (static_cast<std::uint16_t>(byte) << 8));
+    for (std::uint8_t bit = 0; bit < 8; ++bit) {
+        crc = static_cast<std::uint16_t>((crc & 0x8000U) ? (crc << 1) ^ 0x1021U : crc << 1);
+    }
+    return crc;
+#endif
+}
+
+inline std::uint16_t crc16(const std::uint8_t* data, std::size_t length) {
+    std::uint16_t crc = 0xFFFF;
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = crc16_update(crc, data[i]);
+    }
+    return crc;
+}
+
+inline std::uint16_t read_le16(const std::uint8_t* p) {
+    return static_cast<std::uint16_t>(p[0] | (static_cast<std::uint16_t>(p[1]) << 8));
+}
+
+inline std::uint32_t read_le32(const std::uint8_t* p) {
+    return static_cast<std::uint32_t>(read_le16(p)) | (static_cast<std::uint32_t>(read_le16(p + 2)) << 16);
+}
+
+inline void write_le16(std::uint8_t* p, std::uint16_t value) {
+    p[0] = static_cast<std::uint8_t>(value);
+    p[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+inline void write_le32(std::uint8_t* p, std::uint32_t value) {
+    write_le16(p, static_cast<std::uint16_t>(value));
+    write_le16(p + 2, static_cast<std::uint16_t>(value >> 16));
+}
+
+// True if the `length` bytes at `payload` end in the CRC of the ones before
+inline bool crc_ok(const std::uint8_t* payload, std::size_t length) {
+    return length >= CRC_SIZE &&
+           crc16(payload, length - CRC_SIZE) == read_le16(payload + length - CRC_SIZE);
+}
+
+// Appends the CRC of the first `length` bytes of `payload` and returns the new length
+inline std::size_t append_crc(std::uint8_t* payload, std::size_t length) {
+    write_le16(payload + length, crc16(payload, length));
+    return length + CRC_SIZE;
+}
+
+// Buffer size for the frame of a payload of `length` bytes, CRC included
+constexpr std::size_t max_frame(std::size_t length) { return cobs_max_encoded(length) + 2U; }
+
+// Writes the frame of a payload (CRC already appended) to `wire`, max_frame(length) bytes, and returns its length
+inline std::size_t encode_frame(const std::uint8_t* payload, std::size_t length, std::uint8_t* wire) {
+    std::size_t n = 0;
+    wire[n++] = DELIMITER;
+    n += cobs_encode(payload, length, wire + n);
+    wire[n++] = DELIMITER;
+    return n;
+}
+
+} // namespace binary_frame
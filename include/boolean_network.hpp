@@ -0,0 +1,333 @@
+#pragma once
+#include "fast_pin.hpp"
+#include "process_image.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#include <iterator>
+
+// Interlock and permissive logic as a boolean network over the packed bits of a process image, evaluated a byte, 8
+// signals, per operation instead of a port dispatch or a function call per signal.
+//
+// The network is a set of rules, each an AND or an OR of up to MAX_TERMS signals or their negations: the inputs of the
+// image, and internal signals that other rules define. Deeper expressions and longer chains go through internal
+// signals. compile() turns the rules into a program at compile time: it sorts them into levels, each rule after the
+// rules of the signals it reads, and then merges the rules of a level that define signals of the same byte into
+// byte-wide operations, one for the terms that come from the same byte of signals at the same bit offset. Signals
+// laid out so that the n-th bit of a byte depends on the n-th bits of others, 8 valves and their 8 limit switches on
+// one port each, say, take one operation per term for all 8. Outputs are merged alike into masked writes of the
+// image's output bytes:
+//
+//     constexpr boolnet::Signal PUMP_PERMIT = boolnet::internal(0);
+//     constexpr boolnet::Signal VALVE_PERMIT = boolnet::internal(1);
+//     constexpr boolnet::Rule RULES[] = {
+//         boolnet::all(PUMP_PERMIT, boolnet::input(CONTROLLINO_IN0), !boolnet::input(CONTROLLINO_IN1)),
+//         boolnet::any(VALVE_PERMIT, PUMP_PERMIT, boolnet::input(CONTROLLINO_A0))};
+//     constexpr boolnet::Output OUTPUTS[] = {{CONTROLLINO_D0, PUMP_PERMIT}, {CONTROLLINO_D1, !VALVE_PERMIT}};
+//     constexpr auto PERMISSIVES PROGMEM = boolnet::compile<2, 16>(RULES, OUTPUTS);  // 2 internal, up to 16 ops
+//     static_assert(PERMISSIVES.error == boolnet::Error::NONE, "See boolnet::Error");
+//
+//     boolnet::Network<2> permissives(image);
+//     void loop() { image.read_inputs(); permissives.evaluate(PERMISSIVES); image.commit_outputs(); }
+//
+// A rule whose signals are undefined or out of range, two rules of one signal, a cycle, an output pin outside the pin
+// table or more operations than the program holds set `error` instead; the static_assert then fails the build. The
+// outputs are written like image.write(), to pins registered as outputs only.
+
+namespace boolnet {
+
+constexpr std::uint8_t MAX_TERMS = 8;
+constexpr std::uint16_t INPUT_BYTES = gpio::detail::PORT_COUNT;  // A copy of the image's inputs, port by port
+constexpr std::uint16_t INPUT_SIGNALS = INPUT_BYTES * 8U;
+constexpr std::uint16_t NO_SIGNAL = UINT16_MAX;
+
+// A signal, or its negation
+struct Signal {
+    std::uint16_t id = NO_SIGNAL;  // Bit of the network's signals: the inputs, port by port, then the internal ones
+    bool negated = false;
+
+    constexpr Signal operator!() const { return Signal{id, !negated}; }
+};
+
+// The input of the image on a pin of the pin table (see fast_pin.hpp)
+constexpr Signal input(std::uint8_t pin) {
+    const gpio::detail::Port port = gpio::detail::port_of(pin);
+    return (port == gpio::detail::Port::NONE)
+               ? Signal{}
+               : Signal{static_cast<std::uint16_t>((static_cast<std::uint8_t>(port) - 1U) * 8U +
+                                                   gpio::detail::PIN_BIT[pin])};
+}
+
+constexpr Signal internal(std::uint16_t i) { return Signal{static_cast<std::uint16_t>(INPUT_SIGNALS + i)}; }
+
+struct Rule {
+    enum Kind : std::uint8_t { ALL, ANY };
+    Signal target;
+    Kind kind;
+    std::uint8_t count;
+    Signal terms[MAX_TERMS];
+};
+
+// target = the AND of the terms
+template <class... Terms>
+constexpr Rule all(Signal target, Terms... terms) {
+    static_assert(sizeof...(Terms) > 0 && sizeof...(Terms) <= MAX_TERMS, "A rule has 1 to 8 terms");
+    return Rule{target, Rule::ALL, sizeof...(Terms), {terms...}};
+}
+
+// target = the OR of the terms
+template <class... Terms>
+constexpr Rule any(Signal target, Terms... terms) {
+    static_assert(sizeof...(Terms) > 0 && sizeof...(Terms) <= MAX_TERMS, "A rule has 1 to 8 terms");
+    return Rule{target, Rule::ANY, sizeof...(Terms), {terms...}};
+}
+
+// An output pin of the image and the signal it shows
+struct Output {
+    std::uint8_t pin;
+    Signal signal;
+};
+
+enum class Error : std::uint8_t { NONE, BAD_SIGNAL, BAD_TARGET, REDEFINED, UNDEFINED, CYCLE, BAD_PIN, TOO_MANY_OPS };
+
+// One byte-wide operation: x = rotate_left(signals[src], rot) ^ inv, then on the bits of `mask`
+struct Op {
+    enum Code : std::uint8_t {
+        FILL,  // signals[dst] = inv
+        AND,   // signals[dst] &= x
+        OR,    // signals[dst] |= x
+        OUT    // output bits of port dst = x
+    };
+    std::uint8_t code;
+    std::uint8_t dst;
+    std::uint8_t src;
+    std::uint8_t rot;
+    std::uint8_t inv;
+    std::uint8_t mask;
+};
+
+template <std::uint16_t Internal, std::uint16_t MaxOps>
+struct Program {
+    static constexpr std::uint16_t INTERNAL = Internal;
+    Error error = Error::NONE;
+    std::uint16_t size = 0;    // Of ops
+    std::uint16_t levels = 0;  // Of the evaluation order
+    std::uint16_t terms = 0;   // Of the rules and outputs, what size would be without the byte-wide merging
+    std::array<Op, MaxOps> ops{};
+};
+
+namespace detail {
+template <std::uint16_t Internal, std::uint16_t MaxOps>
+struct Compiler {
+    static constexpr std::uint16_t SIGNALS = INPUT_SIGNALS + Internal;
+
+    Program<Internal, MaxOps> program{};
+    std::uint16_t group = 0;  // First op the current one may be merged into
+
+    // Adds the bit `from` as `lane` of an op on `dst`, x = rotate_left(signals[from / 8], rot)
+    constexpr void merge(std::uint8_t code, std::uint8_t dst, std::uint16_t from, bool negated, std::uint8_t lane) {
+        const auto src = static_cast<std::uint8_t>(from / 8U);
+        const auto rot = static_cast<std::uint8_t>((lane - from % 8U) & 7U);
+        const auto bit = static_cast<std::uint8_t>(1U << lane);
+        ++program.terms;
+        for (std::uint16_t i = group; i < program.size; ++i) {
+            Op& op = program.ops[i];
+            if (op.code == code && op.dst == dst && op.src == src && op.rot == rot && (op.mask & bit) == 0) {
+                op.mask = static_cast<std::uint8_t>(op.mask | bit);
+                op.inv = static_cast<std::uint8_t>(negated ? (op.inv | bit) : op.inv);
+                return;
+            }
+        }
+        emit(Op{code, dst, src, rot, static_cast<std::uint8_t>(negated ? bit : 0), bit});
+    }
+
+    constexpr bool emit(const Op& op) {
+        if (program.size == MaxOps) {
+            program.error = Error::TOO_MANY_OPS;
+            return false;
+        }
+        program.ops[program.size++] = op;
+        return true;
+    }
+};
+} // namespace detail
+
+// The program of a network of `Internal` internal signals, in at most MaxOps operations; `rules` and `outputs` are
+// arrays of Rule and Output
+template <std::uint16_t Internal, std::uint16_t MaxOps, class Rules, class Outputs>
+constexpr Program<Internal, MaxOps> compile(const Rules& rules, const Outputs& outputs) {
+    static_assert(INPUT_BYTES + (Internal + 7U) / 8U <= 256U, "The signals are indexed by a byte");
+    detail::Compiler<Internal, MaxOps> c;
+    auto& program = c.program;
+    constexpr std::uint16_t NONE = UINT16_MAX;
+    const auto count = static_cast<std::uint16_t>(std::size(rules));
+
+    // The rule of each internal signal
+    std::array<std::uint16_t, Internal + 1U> rule_of{};  // One more, as Internal may be 0
+    for (auto& r : rule_of) {
+        r = NONE;
+    }
+    for (std::uint16_t i = 0; i < count; ++i) {
+        const Rule& rule = rules[i];
+        if (rule.target.id < INPUT_SIGNALS || rule.target.id >= c.SIGNALS || rule.target.negated) {
+            program.error = Error::BAD_TARGET;
+            return program;
+        }
+        std::uint16_t& r = rule_of[rule.target.id - INPUT_SIGNALS];
+        if (r != NONE) {
+            program.error = Error::REDEFINED;
+            return program;
+        }
+        r = i;
+        for (std::uint8_t t = 0; t < rule.count; ++t) {
+            if (rule.terms[t].id >= c.SIGNALS) {
+                program.error = Error::BAD_SIGNAL;
+                return program;
+            }
+        }
+    }
+    for (std::uint16_t i = 0; i < count; ++i) {
+        for (std::uint8_t t = 0; t < rules[i].count; ++t) {
+            const std::uint16_t id = rules[i].terms[t].id;
+            if (id >= INPUT_SIGNALS && rule_of[id - INPUT_SIGNALS] == NONE) {
+                program.error = Error::UNDEFINED;
+                return program;
+            }
+        }
+    }
+
+    // Levels: a rule comes one after the highest of the rules it reads; past `count` levels there is a cycle
+    std::array<std::uint16_t, sizeof(rules) / sizeof(Rule) + 1U> level{};
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (std::uint16_t i = 0; i < count; ++i) {
+            std::uint16_t l = 0;
+            for (std::uint8_t t = 0; t < rules[i].count; ++t) {
+                const std::uint16_t id = rules[i].terms[t].id;
+                if (id >= INPUT_SIGNALS) {
+                    const std::uint16_t after = static_cast<std::uint16_t>(level[rule_of[id - INPUT_SIGNALS]] + 1U);
+                    l = (after > l) ? after : l;
+                }
+            }
+            if (l != level[i]) {
+                if (l >= count) {
+                    program.error = Error::CYCLE;
+                    return program;
+                }
+                level[i] = l;
+                changed = true;
+            }
+        }
+    }
+    for (std::uint16_t i = 0; i < count; ++i) {
+        program.levels = (level[i] + 1U > program.levels) ? static_cast<std::uint16_t>(level[i] + 1U) : program.levels;
+    }
+
+    // Level by level, the rules on each byte of signals and of each kind in one group of ops: a FILL of their bits
+    // with the identity of the kind, then the terms, merged
+    for (std::uint16_t l = 0; l < program.levels; ++l) {
+        for (std::uint16_t byte = INPUT_BYTES; byte < INPUT_BYTES + (Internal + 7U) / 8U; ++byte) {
+            for (std::uint8_t kind = Rule::ALL; kind <= Rule::ANY; ++kind) {
+                std::uint8_t mask = 0;
+                for (std::uint16_t i = 0; i < count; ++i) {
+                    if (level[i] == l && rules[i].kind == kind && rules[i].target.id / 8U == byte) {
+                        mask = static_cast<std::uint8_t>(mask | (1U << (rules[i].target.id % 8U)));
+                    }
+                }
+                if (mask == 0) {
+                    continue;
+                }
+                const auto dst = static_cast<std::uint8_t>(byte);
+                if (!c.emit(Op{Op::FILL, dst, 0, 0, static_cast<std::uint8_t>((kind == Rule::ALL) ? mask : 0), mask})) {
+                    return program;
+                }
+                c.group = program.size;
+                const std::uint8_t code = (kind == Rule::ALL) ? Op::AND : Op::OR;
+                for (std::uint16_t i = 0; i < count; ++i) {
+                    if (level[i] == l && rules[i].kind == kind && rules[i].target.id / 8U == byte) {
+                        for (std::uint8_t t = 0; t < rules[i].count; ++t) {
+                            c.merge(code, dst, rules[i].terms[t].id, rules[i].terms[t].negated,
+                                    static_cast<std::uint8_t>(rules[i].target.id % 8U));
+                        }
+                    }
+                }
+                if (program.error != Error::NONE) {
+                    return program;
+                }
+            }
+        }
+    }
+
+    // The outputs, merged the same way into masked writes of each output port
+    c.group = program.size;
+    for (const Output& output : outputs) {
+        const gpio::detail::Port port = gpio::detail::port_of(output.pin);
+        if (port == gpio::detail::Port::NONE) {
+            program.error = Error::BAD_PIN;
+            return program;
+        }
+        if (output.signal.id >= c.SIGNALS) {
+            program.error = Error::BAD_SIGNAL;
+            return program;
+        }
+        c.merge(Op::OUT, static_cast<std::uint8_t>(static_cast<std::uint8_t>(port) - 1U), output.signal.id,
+                output.signal.negated, gpio::detail::PIN_BIT[output.pin]);
+    }
+    return program;
+}
+
+// A network of rules only
+template <std::uint16_t Internal, std::uint16_t MaxOps, class Rules>
+constexpr Program<Internal, MaxOps> compile(const Rules& rules) {
+    return compile<Internal, MaxOps>(rules, std::array<Output, 0>{});
+}
+
+// The signals of a network and its evaluation against a process image
+template <std::uint16_t Internal>
+class Network {
+public:
+    static constexpr std::uint16_t BYTES = INPUT_BYTES + (Internal + 7U) / 8U;
+
+    explicit Network(process_image::ProcessImage& process_image) : image(process_image) {}
+
+    // One evaluation of a program in PROGMEM, between image.read_inputs() and image.commit_outputs()
+    template <std::uint16_t MaxOps>
+    void evaluate(const Program<Internal, MaxOps>& program_P) {
+        for (std::uint8_t port = 0; port < INPUT_BYTES; ++port) {
+            bits_[port] = image.input_bits(port);
+        }
+        const std::uint16_t size = pgm_read_word(&program_P.size);
+        const Op* op_P = program_P.ops.data();
+        for (std::uint16_t i = 0; i < size; ++i, ++op_P) {
+            Op op;
+            memcpy_P(&op, op_P, sizeof(op));
+            if (op.code == Op::FILL) {
+                bits_[op.dst] = static_cast<std::uint8_t>((bits_[op.dst] & ~op.mask) | op.inv);
+                continue;
+            }
+            std::uint8_t x = bits_[op.src];
+            if (op.rot != 0) {
+                x = static_cast<std::uint8_t>((x << op.rot) | (x >> (8U - op.rot)));
+            }
+            x = static_cast<std::uint8_t>(x ^ op.inv);
+            if (op.code == Op::AND) {
+                bits_[op.dst] = static_cast<std::uint8_t>(bits_[op.dst] & (x | ~op.mask));
+            } else if (op.code == Op::OR) {
+                bits_[op.dst] = static_cast<std::uint8_t>(bits_[op.dst] | (x & op.mask));
+            } else {
+                image.write_bits(op.dst, op.mask, x);
+            }
+        }
+    }
+
+    // The level of a signal as of the last evaluation
+    bool signal(Signal s) const {
+        return s.id < BYTES * 8U && (((bits_[s.id / 8U] >> (s.id % 8U)) & 1U) != 0) != s.negated;
+    }
+
+private:
+    process_image::ProcessImage& image;
+    std::array<std::uint8_t, BYTES> bits_{};
+};
+
+} // namespace boolnet
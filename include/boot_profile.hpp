@@ -0,0 +1,58 @@
+#pragma once
+#include <Controllino.h>
+#include <cstdint>
+
+// Time from reset to the phases of the boot, for watchdog recovery budgets: when the static constructors are done,
+// setup() is entered, the commander is initialized, setup() has linked the network, and the first timer has been
+// dispatched (the first blink of an output). The 'boot' command prints them.
+//
+//     void setup() { boot_profile::mark(boot_profile::SETUP); ...; boot_profile::mark(boot_profile::LINKED); }
+//
+// Until the Arduino core's init() takes the timers over for PWM, the count comes from Timer5, started at clk/64
+// (4 us) in .init3, before the RAM is cleared, and latched in .init7, after the constructors (src/boot_profile.cpp).
+// From init() on, micros() counts from 0, so a phase is the constructors' time plus micros(); the few instructions
+// between .init7 and init() go uncounted. The constructors may take up to 262 ms; beyond that the count saturates.
+//
+// Opt-in with -D BOOT_PROFILE. Without it ENABLED is false and mark() does nothing. Off AVR the constructors take no
+// time.
+
+namespace boot_profile {
+
+#if defined(BOOT_PROFILE)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+enum Phase : std::uint8_t { CONSTRUCTED = 0, SETUP, COMMANDER_READY, LINKED, FIRST_TIMER, PHASE_COUNT };
+
+constexpr std::uint8_t US_PER_TICK = 4;  // Of Timer5 at clk/64
+
+// Timer5 count when the constructors were done, or 0xFFFF if it overflowed; written in .init7
+inline std::uint16_t constructor_ticks = 0;
+
+inline std::uint32_t phase_us[PHASE_COUNT] = {};
+inline std::uint8_t reached = 1U << CONSTRUCTED;  // A bit per phase
+
+inline std::uint32_t constructors_us() { return static_cast<std::uint32_t>(constructor_ticks) * US_PER_TICK; }
+
+inline bool reached_phase(Phase phase) { return (reached & (1U << phase)) != 0; }
+
+// Microseconds from reset to `phase`, 0 if it has not been reached
+inline std::uint32_t at(Phase phase) {
+    if (phase == CONSTRUCTED) {
+        return constructors_us();
+    }
+    return reached_phase(phase) ? phase_us[phase] : 0;
+}
+
+// Records the time of `phase` the first time it is reached
+inline void mark(Phase phase) {
+    if (!ENABLED || reached_phase(phase)) {
+        return;
+    }
+    reached = static_cast<std::uint8_t>(reached | (1U << phase));
+    phase_us[phase] = constructors_us() + static_cast<std::uint32_t>(micros());
+}
+
+} // namespace boot_profile
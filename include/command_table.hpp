@@ -0,0 +1,99 @@
+#pragma once
+#include <Controllino.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Command lookup through a perfect hash computed at compile time.
+//
+// A command table is a constexpr array of entries in PROGMEM, each with a NUL-terminated, lower-case `name` member.
+// build<Slots>() searches for a hash multiplier under which every name lands in a slot of its own and returns the
+// slot-to-entry map; find() then hashes a word once, case-insensitively, and confirms the single candidate against
+// its name in flash. A lookup thus reads each character of the word twice, however many commands there are, and only
+// whole words match ("startx" is not "start").
+//
+//     constexpr Entry COMMANDS[] PROGMEM = {{"help", ...}, {"status", ...}};
+//     constexpr auto COMMAND_HASH PROGMEM = command_table::build<8>(COMMANDS);
+//     const std::uint8_t index = command_table::find(COMMANDS, COMMAND_HASH, word, length);
+//
+// Slots must be a power of two of at least the number of entries; if no multiplier separates the names, the
+// static_assert in the caller's build fails and a larger Slots is needed.
+
+namespace command_table {
+
+constexpr std::uint8_t NONE = 0xFF;
+
+template <std::size_t Slots>
+struct PerfectHash {
+    static_assert(Slots > 0 && (Slots & (Slots - 1U)) == 0 && Slots <= NONE, "Slots must be a power of two");
+
+    std::uint16_t multiplier;  // 0 if the search failed
+    std::array<std::uint8_t, Slots> slots;
+
+    constexpr bool valid() const { return multiplier != 0; }
+};
+
+constexpr std::uint8_t lower(std::uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<std::uint8_t>(c - 'A' + 'a') : c;
+}
+
+constexpr std::uint16_t hash_step(std::uint16_t h, std::uint8_t c, std::uint16_t multiplier) {
+    return static_cast<std::uint16_t>((h ^ c) * multiplier);
+}
+
+template <std::size_t Slots>
+constexpr std::uint8_t slot_of(std::uint16_t h) {
+    return static_cast<std::uint8_t>((h ^ (h >> 8)) & (Slots - 1U));
+}
+
+template <std::size_t Slots, class Entry, std::size_t N>
+constexpr PerfectHash<Slots> build(const Entry (&table)[N]) {
+    static_assert(N <= Slots, "More commands than slots");
+    for (std::uint32_t m = 3; m <= 0xFFFFU; m += 2) {
+        const std::uint16_t multiplier = static_cast<std::uint16_t>(m);
+        PerfectHash<Slots> result{multiplier, {}};
+        for (std::uint8_t& s : result.slots) {
+            s = NONE;
+        }
+        bool separated = true;
+        for (std::size_t i = 0; i < N && separated; ++i) {
+            std::uint16_t h = 0;
+            for (std::size_t k = 0; table[i].name[k] != '\0'; ++k) {
+                h = hash_step(h, static_cast<std::uint8_t>(table[i].name[k]), multiplier);
+            }
+            std::uint8_t& slot = result.slots[slot_of<Slots>(h)];
+            separated = slot == NONE;
+            slot = static_cast<std::uint8_t>(i);
+        }
+        if (separated) {
+            return result;
+        }
+    }
+    return PerfectHash<Slots>{0, {}};
+}
+
+// Index of the entry named `word` (`length` characters, any case), or NONE; table and hash are in PROGMEM
+template <std::size_t Slots, class Entry, std::size_t N>
+std::uint8_t find(const Entry (&table)[N], const PerfectHash<Slots>& hash, const std::uint8_t* word,
+                  std::size_t length) {
+    if (length == 0 || length >= sizeof(table[0].name)) {
+        return NONE;
+    }
+    const std::uint16_t multiplier = pgm_read_word(&hash.multiplier);
+    std::uint16_t h = 0;
+    for (std::size_t k = 0; k < length; ++k) {
+        h = hash_step(h, lower(word[k]), multiplier);
+    }
+    const std::uint8_t index = pgm_read_byte(&hash.slots[slot_of<Slots>(h)]);
+    if (index == NONE) {
+        return NONE;
+    }
+    for (std::size_t k = 0; k < length; ++k) {
+        if (pgm_read_byte(&table[index].name[k]) != lower(word[k])) {
+            return NONE;
+        }
+    }
+    return (pgm_read_byte(&table[index].name[length]) == '\0') ? index : NONE;
+}
+
+} // namespace command_table
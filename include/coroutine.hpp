@@ -0,0 +1,187 @@
+#pragma once
+#include "event.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <cstdint>
+#include <type_traits>
+
+// Stackless coroutines for sequential logic, in the style of protothreads: a sequence of steps and waits written as
+// one function instead of a state and a transition per step in a transition table.
+//
+// An actor derives from coro::Coroutine<Self> and writes its sequence in run(), between CORO_BEGIN() and CORO_END().
+// run() returns at every wait and, when the actor is resumed by its timer or one of its Await ports, continues after
+// the wait it left at: the resume point is the only state the coroutine keeps of its own, an integer (the source line
+// of the wait). Anything else that must survive a wait is a member; the compiler refuses a local variable whose
+// scope spans a wait ("jump to case label crosses initialization"), and two waits cannot share a line.
+//
+//     struct Fill : coro::Coroutine<Fill> {
+//         coro::Await<din::EdgeEvent, Fill> level_in{*this};  // Edges of a level switch
+//         std::uint8_t cycle = 0;                             // Survives the waits
+//
+//         void run() {
+//             CORO_BEGIN();
+//             for (cycle = 0; cycle < 3; ++cycle) {
+//                 digitalWrite(CONTROLLINO_D0, HIGH);  // Valve open until the tank is full
+//                 do {
+//                     CORO_AWAIT_EVENT(level_in);
+//                 } while (!level_in.value().level);
+//                 digitalWrite(CONTROLLINO_D0, LOW);
+//                 CORO_AWAIT_TIMEOUT(2000);            // Settle
+//             }
+//             CORO_END();
+//         }
+//     };
+//
+//     fill.arm_timer_request_out >> timer.arm_timer_request_in;
+//     fill.disarm_timer_request_out >> timer.disarm_timer_request_in;
+//     inputs.edge_out >> fill.level_in.in;
+//     fill.start();
+//
+// A wait on a timeout arms a one-shot timer of the TimerActor through the coroutine's TimerHandle (re-armed in place,
+// so a coroutine holds one slot at most and needs no disarm); a wait on an event returns at once if the port received
+// a value since the last wait on it, which it keeps. CORO_AWAIT(condition) waits for any condition, evaluated at every
+// resume, CORO_YIELD() until the next resume. A push that loops back from the sequence to one of its ports does not
+// run it again from within: the value waits in the port for the next wait on it.
+
+namespace coro {
+
+template <class Derived>
+class Coroutine {
+public:
+    using Point = std::uint16_t;
+    static constexpr Point DONE = 0xFFFF;
+
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    ramen::Pushable<const BaseEvent&> event_handler_in = [this](const BaseEvent& event) {
+        EventRouter<AppEvents, Coroutine, TickEvent>::dispatch(*this, event);
+    };
+
+    Coroutine() { timeout_event_relay_out >> event_handler_in; }
+
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+
+    // Runs the sequence from its beginning, stopping it first if it runs
+    void start() {
+        cancel_timeout();
+        point_ = 0;
+        resume();
+    }
+
+    void stop() {
+        cancel_timeout();
+        point_ = DONE;
+    }
+
+    bool running() const { return point_ != DONE; }
+
+    // Continues the sequence at the wait it left at, if its condition holds
+    void resume() {
+        if (point_ == DONE || running_) {
+            return;
+        }
+        running_ = true;
+        static_cast<Derived*>(this)->run();
+        running_ = false;
+    }
+
+    // Routed from event_handler_in
+    void on_event(const TickEvent&) {
+        timing_ = false;
+        resume();
+    }
+
+protected:
+    Point point_ = DONE;
+
+    // The timeout of CORO_AWAIT_TIMEOUT(); with timed_out(), also a deadline for a wait on something else
+    void start_timeout(std::uint32_t ms) {
+        timing_ = true;
+        ArmTimerEvt evt(ms, &timeout_event_relay_out, false, &timer_handle_);
+        arm_timer_request_out(evt);
+        if (!timer_handle_.valid()) {
+            timing_ = false;  // No free timer slot: the wait ends at once rather than never
+        }
+    }
+
+    bool timed_out() const { return !timing_; }
+
+    void cancel_timeout() {
+        if (timing_) {
+            DisarmTimerEvt evt(timer_handle_);
+            disarm_timer_request_out(evt);
+            timing_ = false;
+        }
+    }
+
+private:
+    TimerHandle timer_handle_;
+    bool timing_ = false;
+    bool running_ = false;
+};
+
+// A port that resumes its coroutine with every value it receives; CORO_AWAIT_EVENT() takes the value
+template <class T, class Owner>
+class Await {
+public:
+    ramen::Pushable<T> in = [this](T value) {
+        value_ = value;
+        ready_ = true;
+        owner_.resume();
+    };
+
+    explicit Await(Owner& owner) : owner_(owner) {}
+
+    // The value received last
+    const std::remove_cv_t<std::remove_reference_t<T>>& value() const { return value_; }
+
+    // Whether a value arrived since the last take(), consuming it
+    bool take() {
+        const bool was_ready = ready_;
+        ready_ = false;
+        return was_ready;
+    }
+
+private:
+    Owner& owner_;
+    std::remove_cv_t<std::remove_reference_t<T>> value_{};
+    bool ready_ = false;
+};
+
+} // namespace coro
+
+// The body of run(): resume points are cases of a switch on the line of the wait
+#define CORO_BEGIN()        \
+    switch (this->point_) { \
+    case 0:
+
+#define CORO_END() \
+    }              \
+    this->point_ = this->DONE
+
+#define CORO_AWAIT(condition)    \
+    do {                         \
+        this->point_ = __LINE__; \
+        [[fallthrough]];         \
+    case __LINE__:               \
+        if (!(condition)) {      \
+            return;              \
+        }                        \
+    } while (0)
+
+#define CORO_YIELD()             \
+    do {                         \
+        this->point_ = __LINE__; \
+        return;                  \
+    case __LINE__:;              \
+    } while (0)
+
+#define CORO_AWAIT_TIMEOUT(ms)         \
+    do {                               \
+        this->start_timeout(ms);       \
+        CORO_AWAIT(this->timed_out()); \
+    } while (0)
+
+#define CORO_AWAIT_EVENT(port) CORO_AWAIT((port).take())
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#else
+#include <Arduino.h>
+#endif
+
+// Free-running CPU cycle counter on the ATmega2560's Timer5 (no prescaler, i.e. one count per CPU cycle).
+// The 16-bit hardware count is extended to 32 bits by the overflow interrupt defined in src/cycle_counter.cpp;
+// at 16 MHz the 32-bit count wraps after about 268 seconds, which is far beyond any interval it is used to measure.
+//
+// start() takes Timer5 over from the Arduino core, which configures it for PWM on pins 44..46. Builds that need
+// Timer5 for something else define CYCLE_COUNTER_DISABLE, which removes the ISR; now() then always returns 0.
+// On non-AVR builds the counter is derived from micros().
+
+namespace cycle_counter {
+
+inline volatile std::uint16_t overflow_count = 0;
+
+#if defined(__AVR__) && !defined(CYCLE_COUNTER_DISABLE)
+constexpr bool ENABLED = true;
+
+inline void start() {
+    const std::uint8_t sreg = SREG;
+    cli();
+    TCCR5A = 0;
+    TCCR5B = _BV(CS50);  // Normal mode, clk/1
+    TCNT5 = 0;
+    overflow_count = 0;
+    TIFR5 = _BV(TOV5);
+    TIMSK5 = _BV(TOIE5);
+    SREG = sreg;
+}
+
+// Current cycle count. Safe to call with interrupts enabled or disabled.
+inline std::uint32_t now() {
+    const std::uint8_t sreg = SREG;
+    cli();
+    const std::uint16_t low = TCNT5;
+    std::uint16_t high = overflow_count;
+    // An overflow that happened after interrupts were disabled has not been counted yet.
+    if ((TIFR5 & _BV(TOV5)) && low < 0x8000U) {
+        ++high;
+    }
+    SREG = sreg;
+    return (static_cast<std::uint32_t>(high) << 16) | low;
+}
+#elif defined(__AVR__)
+constexpr bool ENABLED = false;
+inline void start() {}
+inline std::uint32_t now() { return 0; }
+#else
+constexpr bool ENABLED = true;
+inline void start() {}
+inline std::uint32_t now() { return static_cast<std::uint32_t>(micros()) * 16U; }
+#endif
+
+constexpr std::uint32_t CYCLES_PER_US = 16;  // Controllino Maxi Automation runs at 16 MHz
+
+constexpr std::uint32_t to_us(std::uint32_t cycles) { return cycles / CYCLES_PER_US; }
+
+} // namespace cycle_counter
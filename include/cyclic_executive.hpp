@@ -0,0 +1,199 @@
+#pragma once
+#include "event.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// A cyclic executive, the task classes of a PLC: periodic function blocks in rate groups of harmonic periods, all
+// driven by one periodic TimerActor slot instead of a slot and a TickEvent dispatch each.
+//
+// The periods are fixed at compile time, the first being the base tick and each a multiple of the one before. Every
+// base tick releases the groups whose period it completes, fastest first; the members of a group run back to back from
+// a table in flash, a function and the object it works on, with no dispatch in between:
+//
+//     constexpr cyclic::Task FAST[] PROGMEM = {cyclic::task<&Pid::update>(pid1), cyclic::task<&Pid::update>(pid2)};
+//     constexpr cyclic::Task SLOW[] PROGMEM = {cyclic::task<&Totaliser::update>(flow), cyclic::task<&log_levels>()};
+//
+//     cyclic::CyclicExecutiveActor<1, 10, 100> tasks;  // 1 ms, 10 ms and 100 ms groups
+//     void setup() {
+//         tasks.arm_timer_request_out >> timer.arm_timer_request_in;
+//         tasks.disarm_timer_request_out >> timer.disarm_timer_request_in;
+//         tasks.set_tasks(0, FAST);
+//         tasks.set_tasks(2, SLOW);
+//         tasks.start();
+//     }
+//
+// Overruns are detected per group. A group overruns when a release takes longer than its period. A release is late
+// when the ticks were dispatched so far behind that its release point passed unseen; the group then runs once at the
+// next tick, and the releases beyond that one are counted as skipped. The phase holds, as TimerActor advances the
+// tick from its deadline: a late 100 ms group still runs on the 100 ms boundaries. stats() gives the figures of a
+// group, which e.g. commander.watch(F("10 ms overruns"), tasks.stats(1).overruns) adds to the 'stats' command.
+
+namespace cyclic {
+
+// A member of a rate group: a function and the object it works on
+struct Task {
+    void (*run)(void* object);
+    void* object;
+};
+
+namespace detail {
+template <class T, void (T::*Method)()>
+void call(void* object) {
+    (static_cast<T*>(object)->*Method)();
+}
+
+template <void (*Function)()>
+void call_function(void*) {
+    Function();
+}
+
+template <auto Method>
+struct MethodOf;
+template <class T, void (T::*Method)()>
+struct MethodOf<Method> {
+    using type = T;
+};
+} // namespace detail
+
+// The task of a member function on an object, e.g. task<&Pid::update>(pid1)
+template <auto Method>
+constexpr Task task(typename detail::MethodOf<Method>::type& object) {
+    return Task{&detail::call<typename detail::MethodOf<Method>::type, Method>, &object};
+}
+
+// The task of a free function, e.g. task<&log_levels>()
+template <void (*Function)()>
+constexpr Task task() {
+    return Task{&detail::call_function<Function>, nullptr};
+}
+
+struct GroupStats {
+    std::uint32_t releases = 0;
+    std::uint32_t last_us = 0;    // Of the last release
+    std::uint32_t max_us = 0;
+    std::uint16_t overruns = 0;   // Releases longer than the period, saturates at 65535
+    std::uint16_t late = 0;       // Releases run after their release point had passed, saturates
+    std::uint16_t skipped = 0;    // Releases lost entirely, saturates
+};
+
+template <std::uint16_t... PeriodsMs>
+class CyclicExecutiveActor {
+public:
+    static constexpr std::uint8_t GROUPS = sizeof...(PeriodsMs);
+    static constexpr std::array<std::uint16_t, GROUPS> PERIODS_MS{{PeriodsMs...}};
+
+private:
+    static constexpr bool harmonic() {
+        for (std::uint8_t i = 0; i < GROUPS; ++i) {
+            if (PERIODS_MS[i] == 0 || (i > 0 && (PERIODS_MS[i] <= PERIODS_MS[i - 1U] ||
+                                                 PERIODS_MS[i] % PERIODS_MS[i - 1U] != 0))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(GROUPS > 0, "A cyclic executive needs a rate group");
+    static_assert(harmonic(), "The periods must rise, each a multiple of the one before");
+
+public:
+    static constexpr std::uint16_t BASE_MS = PERIODS_MS[0];
+    static constexpr std::uint16_t HYPERPERIOD_TICKS = PERIODS_MS[GROUPS - 1U] / BASE_MS;  // The tick count wraps
+
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const DisarmTimerEvt&> disarm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    ramen::Pushable<const BaseEvent&> event_handler_in = [this](const BaseEvent& event) {
+        EventRouter<AppEvents, CyclicExecutiveActor, TickEvent>::dispatch(*this, event);
+    };
+
+    CyclicExecutiveActor() { timeout_event_relay_out >> event_handler_in; }
+
+    // The members of a group, a table in PROGMEM; replaces those set before
+    void set_tasks(std::uint8_t group, const Task* tasks_P, std::uint8_t count) {
+        if (group < GROUPS) {
+            groups_[group] = Group{tasks_P, count};
+        }
+    }
+
+    template <std::uint8_t N>
+    void set_tasks(std::uint8_t group, const Task (&tasks_P)[N]) {
+        set_tasks(group, tasks_P, N);
+    }
+
+    // Arms the base tick; each group is first released one period from now
+    void start() {
+        ticks_ = 0;
+        ArmTimerEvt evt(BASE_MS, &timeout_event_relay_out, true, &timer_handle_, OverrunPolicy::COALESCE);
+        arm_timer_request_out(evt);
+    }
+
+    void stop() {
+        if (timer_handle_.valid()) {
+            DisarmTimerEvt evt(timer_handle_);
+            disarm_timer_request_out(evt);
+            timer_handle_ = TimerHandle{};
+        }
+    }
+
+    bool running() const { return timer_handle_.valid(); }
+
+    // Routed from event_handler_in: the base tick, `missed` ticks after the one expected
+    void on_event(const TickEvent& tick) {
+        const std::uint32_t from = ticks_;
+        const std::uint32_t to = from + tick.missed + 1U;
+        ticks_ = static_cast<std::uint16_t>(to % HYPERPERIOD_TICKS);
+        for (std::uint8_t g = 0; g < GROUPS; ++g) {
+            const std::uint16_t divisor = PERIODS_MS[g] / BASE_MS;
+            const std::uint32_t releases = to / divisor - from / divisor;
+            if (releases == 0) {
+                continue;
+            }
+            GroupStats& s = stats_[g];
+            if (releases > 1U || to % divisor != 0) {
+                saturating_add(s.late, 1U);
+                saturating_add(s.skipped, releases - 1U);
+            }
+            release(g, s);
+        }
+    }
+
+    const GroupStats& stats(std::uint8_t group) const { return stats_[group]; }
+    void reset_stats() { stats_ = {}; }
+
+private:
+    struct Group {
+        const Task* tasks_P = nullptr;
+        std::uint8_t count = 0;
+    };
+
+    std::array<Group, GROUPS> groups_{};
+    std::array<GroupStats, GROUPS> stats_{};
+    std::uint16_t ticks_ = 0;  // Base ticks into the hyperperiod
+    TimerHandle timer_handle_;
+
+    static void saturating_add(std::uint16_t& counter, std::uint32_t n) {
+        counter = static_cast<std::uint16_t>((n >= static_cast<std::uint32_t>(UINT16_MAX - counter)) ? UINT16_MAX
+                                                                                                     : counter + n);
+    }
+
+    void release(std::uint8_t g, GroupStats& s) {
+        const Group& group = groups_[g];
+        const std::uint32_t start = static_cast<std::uint32_t>(micros());
+        for (std::uint8_t i = 0; i < group.count; ++i) {
+            const Task* t = &group.tasks_P[i];
+            const auto run = reinterpret_cast<void (*)(void*)>(pgm_read_ptr(&t->run));
+            run(pgm_read_ptr(&t->object));
+        }
+        const std::uint32_t elapsed = static_cast<std::uint32_t>(micros()) - start;
+        ++s.releases;
+        s.last_us = elapsed;
+        s.max_us = (elapsed > s.max_us) ? elapsed : s.max_us;
+        if (elapsed > static_cast<std::uint32_t>(PERIODS_MS[g]) * 1000UL) {
+            saturating_add(s.overruns, 1U);
+        }
+    }
+};
+
+} // namespace cyclic
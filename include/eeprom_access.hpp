@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#endif
+
+// Non-blocking access to the EEPROM, shared by the stores that keep data in it (actor_config_store.hpp,
+// actor_boot_script.hpp). Reads are immediate; a write is started by update_byte() and programs for 3.4 ms, during
+// which ready() is false, so a store writes a record a byte per loop pass instead of waiting for each byte.
+//
+// Regions: the configuration store from EEPROM_CONFIG_ADDRESS (0) on, the recipes (actor_recipe.hpp) in the 512 bytes
+// before the event log, the event log (actor_event_log.hpp) in the 1 KB
+// before the logic program, the logic program (logic_vm.hpp) in the 1 KB before the boot script, the boot script in
+// the last 64 bytes. Off AVR the EEPROM is an array in RAM.
+
+namespace eeprom_access {
+
+constexpr std::uint16_t SIZE = 4096;                     // The ATmega2560's
+constexpr std::uint16_t BOOT_SCRIPT_REGION = SIZE - 64U;  // The boot script's, to the end
+constexpr std::uint16_t LOGIC_PROGRAM_REGION = BOOT_SCRIPT_REGION - 1024U;  // The logic program's, to the boot script
+constexpr std::uint16_t EVENT_LOG_REGION = LOGIC_PROGRAM_REGION - 1024U;    // The event log's, to the logic program
+constexpr std::uint16_t RECIPE_REGION = EVENT_LOG_REGION - 512U;            // The recipes', to the event log
+
+#if !defined(__AVR__)
+inline std::array<std::uint8_t, SIZE> host_eeprom = [] {
+    std::array<std::uint8_t, SIZE> blank{};
+    blank.fill(0xFF);
+    return blank;
+}();
+#endif
+
+inline void read_block(void* data, std::uint16_t address, std::size_t length) {
+#if defined(__AVR__)
+    eeprom_read_block(data, reinterpret_cast<const void*>(address), length);
+#else
+    std::memcpy(data, host_eeprom.data() + address, length);
+#endif
+}
+
+inline bool ready() {
+#if defined(__AVR__)
+    return eeprom_is_ready();
+#else
+    return true;
+#endif
+}
+
+// Starts writing a byte if it differs from the stored one; true if it did
+inline bool update_byte(std::uint16_t address, std::uint8_t value) {
+#if defined(__AVR__)
+    if (eeprom_read_byte(reinterpret_cast<const std::uint8_t*>(address)) == value) {
+        return false;
+    }
+    eeprom_write_byte(reinterpret_cast<std::uint8_t*>(address), value);  // Returns once the write has started
+    return true;
+#else
+    const bool differs = host_eeprom[address] != value;
+    host_eeprom[address] = value;
+    return differs;
+#endif
+}
+
+} // namespace eeprom_access
@@ -1,40 +1,165 @@
 #pragma once
 
 #include "ramen.hpp"
+#include <Controllino.h>
+#include <chrono>
 #include <cstdint>
+#include <type_traits>
+#include <utility>
 
-// Enum for event types, unique across your application
+// Event type ids, unique across your application. Ids are assigned at compile time by the EventRegistry below from
+// the position of each event type in AppEvents; 0 is reserved for unknown events.
 enum class AppEventType : uint8_t {
-    EV_UNKNOWN = 0,
-    EV_TIMEOUT,
-    EV_ARM_TIMER,
-    EV_DISARM_TIMER
+    EV_UNKNOWN = 0
 };
 
+// Compile-time list of event types. id<E> is the 1-based position of E in the list.
+template <class... Events>
+struct EventRegistry {
+    static constexpr std::uint8_t size = sizeof...(Events);
+
+    template <class E>
+    static constexpr AppEventType id = [] {
+        std::uint8_t index = 0;
+        const bool found = ((++index, std::is_same_v<E, Events>) || ...);
+        return found ? static_cast<AppEventType>(index) : AppEventType::EV_UNKNOWN;
+    }();
+
+    // Events are plain data: they are passed by reference and returned to pools without running a destructor
+    static constexpr bool trivially_destructible() { return (std::is_trivially_destructible_v<Events> && ...); }
+};
+
+struct TickEvent;
+struct ArmTimerEvt;
+struct DisarmTimerEvt;
+
+// Register new event types here
+using AppEvents = EventRegistry<TickEvent, ArmTimerEvt, DisarmTimerEvt>;
+
 struct BaseEvent {
     AppEventType type;
     void* user_data;
+    // Bookkeeping for events allocated from an EventPool (see event_pool.hpp).
+    // pool_id == 0 marks an event that is not pool-allocated (e.g. on the stack); reference counting ignores it.
+    std::uint8_t pool_id = 0;
+    std::uint8_t ref_count = 0;
 
     explicit BaseEvent(AppEventType t) : type(t) {}
-    virtual ~BaseEvent() = default;
+
+    // The bookkeeping belongs to the storage, not to the event: a copy (auto e = *pooled) is not pool-allocated, and
+    // assigning into an event keeps its own
+    BaseEvent(const BaseEvent& that) : type(that.type), user_data(that.user_data) {}
+    BaseEvent& operator=(const BaseEvent& that) {
+        type = that.type;
+        user_data = that.user_data;
+        return *this;
+    }
 };
 
 struct TickEvent : public BaseEvent {
-    TickEvent() : BaseEvent(AppEventType::EV_TIMEOUT) {}
+    // Whole periods a periodic timer fell behind and left out before this tick (OverrunPolicy::COALESCE only)
+    std::uint16_t missed = 0;
+
+    TickEvent() : BaseEvent(AppEvents::id<TickEvent>) {}
+};
+
+// What a periodic timer does when a tick is dispatched more than one period late. Deadlines always advance from the
+// previous deadline, never from the time of dispatch, so late dispatches do not shift the phase.
+enum class OverrunPolicy : uint8_t {
+    SKIP,      // Drop the missed ticks and fire next on the next period boundary
+    CATCH_UP,  // Fire every missed tick, back to back, until the timer is on schedule again
+    COALESCE   // Like SKIP, but report the number of dropped ticks in TickEvent::missed
+};
+
+// Names one armed timer of a TimerActor: the slot index plus the generation of the slot when it was armed, so a
+// handle to a timer that has since expired or been disarmed is recognised as stale. Default handles name no timer.
+struct TimerHandle {
+    static constexpr std::uint8_t NO_SLOT = 0xFF;
+    std::uint8_t slot = NO_SLOT;
+    std::uint8_t generation = 0;
+
+    bool valid() const { return slot != NO_SLOT; }
 };
 
 struct ArmTimerEvt : public BaseEvent {
-    std::uint32_t interval_ms;
+    std::uint32_t interval_ms;  // Milliseconds, or microseconds for a MicrosTimerActor
     ramen::Pusher<const BaseEvent&>* target_pusher;
     bool is_periodic;
+    // Optional. If it names a live timer, that timer is re-armed in place; on return it names the armed timer
+    // (or no timer if arming failed).
+    TimerHandle* handle;
+    OverrunPolicy overrun;  // Periodic timers only
+
+    ArmTimerEvt(std::uint32_t interval, ramen::Pusher<const BaseEvent&>* pusher, bool periodic,
+                TimerHandle* timer_handle = nullptr, OverrunPolicy overrun_policy = OverrunPolicy::SKIP)
+        : BaseEvent(AppEvents::id<ArmTimerEvt>), interval_ms(interval), target_pusher(pusher), is_periodic(periodic),
+          handle(timer_handle), overrun(overrun_policy) {}
 
-    ArmTimerEvt(std::uint32_t interval, ramen::Pusher<const BaseEvent&>* pusher, bool periodic)
-        : BaseEvent(AppEventType::EV_ARM_TIMER), interval_ms(interval), target_pusher(pusher), is_periodic(periodic) {}
+    // A typed interval for a millisecond TimerActor, e.g. ArmTimerEvt(1500ms, ...) or ArmTimerEvt(2s, ...). Only
+    // conversions without loss compile, so 1500us is rejected; a constant converts at compile time. For a
+    // MicrosTimerActor, pass MicrosClock::ticks(interval) instead.
+    template <class Rep, class Period, class = std::enable_if_t<std::is_convertible_v<
+                                           std::chrono::duration<Rep, Period>, std::chrono::milliseconds>>>
+    ArmTimerEvt(std::chrono::duration<Rep, Period> interval, ramen::Pusher<const BaseEvent&>* pusher, bool periodic,
+                TimerHandle* timer_handle = nullptr, OverrunPolicy overrun_policy = OverrunPolicy::SKIP)
+        : ArmTimerEvt(static_cast<std::uint32_t>(std::chrono::milliseconds(interval).count()), pusher, periodic,
+                      timer_handle, overrun_policy) {}
 };
 
+// Disarms the timer named by a handle, or every timer bound to a pusher
 struct DisarmTimerEvt : public BaseEvent {
     ramen::Pusher<const BaseEvent&>* target_pusher;
+    TimerHandle handle;
 
     explicit DisarmTimerEvt(ramen::Pusher<const BaseEvent&>* pusher)
-        : BaseEvent(AppEventType::EV_DISARM_TIMER), target_pusher(pusher) {}
+        : BaseEvent(AppEvents::id<DisarmTimerEvt>), target_pusher(pusher) {}
+    explicit DisarmTimerEvt(TimerHandle timer_handle)
+        : BaseEvent(AppEvents::id<DisarmTimerEvt>), target_pusher(nullptr), handle(timer_handle) {}
+};
+
+static_assert(AppEvents::trivially_destructible(), "Events must be trivially destructible");
+
+// Routes a BaseEvent to handler.on_event(const E&) for each E in Handled, through a table indexed by the event id
+// (one flash word per registered event). Events the handler does not list are ignored.
+//
+//     void on_event(const TickEvent&) { ... }
+//     event_handler_in([this](const BaseEvent& e) { EventRouter<AppEvents, MyActor, TickEvent>::dispatch(*this, e); })
+template <class Registry, class Handler, class... Handled>
+class EventRouter {
+    using thunk_t = void (*)(Handler&, const BaseEvent&);
+
+    template <class E>
+    static void thunk(Handler& handler, const BaseEvent& event) {
+        handler.on_event(static_cast<const E&>(event));
+    }
+
+    static constexpr thunk_t entry(std::uint8_t id) {
+        thunk_t result = nullptr;
+        (void)(((static_cast<std::uint8_t>(Registry::template id<Handled>) == id) && (result = &thunk<Handled>, true)) ||
+               ...);
+        return result;
+    }
+
+    template <std::uint8_t... Ids>
+    struct table_of {
+        static constexpr thunk_t table[sizeof...(Ids)] PROGMEM = {entry(Ids)...};
+    };
+    template <std::size_t... Ids>
+    static auto make_table(std::index_sequence<Ids...>) -> table_of<static_cast<std::uint8_t>(Ids)...>;
+    using table_t = decltype(make_table(std::make_index_sequence<Registry::size + 1U>{}));
+
+    static_assert(((Registry::template id<Handled> != AppEventType::EV_UNKNOWN) && ...),
+                  "Routed events must be listed in the registry");
+
+public:
+    static void dispatch(Handler& handler, const BaseEvent& event) {
+        const std::uint8_t id = static_cast<std::uint8_t>(event.type);
+        if (id > Registry::size) {
+            return;
+        }
+        const thunk_t fn = reinterpret_cast<thunk_t>(pgm_read_ptr(&table_t::table[id]));
+        if (fn != nullptr) {
+            fn(handler, event);
+        }
+    }
 };
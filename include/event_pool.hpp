@@ -0,0 +1,233 @@
+#pragma once
+
+#include "event.hpp"
+#include "static_vector.hpp"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Fixed-block event pools with intrusive reference counting, in the spirit of QP's event pools.
+//
+// Pools are declared statically and registered once in ascending block size. make_event<E>() takes a block from
+// the smallest pool that fits E and returns an EventRef, an intrusive smart pointer: copies share the same event
+// instance, and the block returns to its pool when the last reference goes away. An EventRef can be pushed through
+// ramen ports (e.g. ramen::Pusher<EventRef<ArmTimerEvt>>) or queued in an AsyncPusher, so fan-out and deferred
+// delivery pass a pointer instead of copying the event.
+//
+//   EventPool<16, 8> small_events;
+//   EventPool<32, 4> large_events;
+//   void setup() { event_pools.add(small_events); event_pools.add(large_events); }
+//
+// Pools are not interrupt-safe; allocate and release events from the main loop only.
+
+class EventPoolBase {
+public:
+    EventPoolBase(const EventPoolBase&) = delete;
+    EventPoolBase& operator=(const EventPoolBase&) = delete;
+
+    std::size_t block_size() const { return block_size_; }
+    std::uint8_t free_count() const { return free_count_; }
+    std::uint8_t min_free_count() const { return min_free_count_; }  // Low-water mark for sizing the pool.
+
+    // True if `ptr` is one of this pool's blocks.
+    bool owns(const void* ptr) const {
+        const unsigned char* p = static_cast<const unsigned char*>(ptr);
+        return p >= storage_ && p < storage_ + block_size_ * count_;
+    }
+
+    void* allocate() {
+        if (free_list_ == nullptr) {
+            return nullptr;
+        }
+        FreeBlock* block = free_list_;
+        free_list_ = block->next;
+        --free_count_;
+        if (free_count_ < min_free_count_) {
+            min_free_count_ = free_count_;
+        }
+        return block;
+    }
+
+    void release(void* ptr) {
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = free_list_;
+        free_list_ = block;
+        ++free_count_;
+    }
+
+protected:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    EventPoolBase(std::size_t block_size, std::uint8_t count)
+        : block_size_(block_size), count_(count), free_count_(count), min_free_count_(count) {}
+    ~EventPoolBase() = default;
+
+    // Threads all blocks of the storage onto the free list; called once by the owning pool.
+    void format(unsigned char* storage, std::uint8_t count) {
+        storage_ = storage;
+        for (std::uint8_t i = count; i > 0; --i) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(storage + (static_cast<std::size_t>(i) - 1U) * block_size_);
+            block->next = free_list_;
+            free_list_ = block;
+        }
+    }
+
+private:
+
+    FreeBlock* free_list_ = nullptr;
+    const unsigned char* storage_ = nullptr;
+    std::size_t block_size_;
+    std::uint8_t count_;
+    std::uint8_t free_count_;
+    std::uint8_t min_free_count_;
+};
+
+template <std::size_t BlockSize, std::uint8_t Count>
+class EventPool final : public EventPoolBase {
+    static constexpr std::size_t alignment = alignof(std::max_align_t);
+    static constexpr std::size_t stride =
+        ((BlockSize < sizeof(void*) ? sizeof(void*) : BlockSize) + alignment - 1U) / alignment * alignment;
+
+public:
+    EventPool() : EventPoolBase(stride, Count) { format(storage_.data(), Count); }
+
+private:
+    alignas(alignment) std::array<unsigned char, stride * Count> storage_;
+};
+
+// Registry of the application's pools, ordered by ascending block size.
+template <std::uint8_t MaxPools>
+class PoolRegistry {
+public:
+    static constexpr std::uint8_t MAX_POOLS = MaxPools;
+
+    // Pools must be added in ascending block size; returns false if full or out of order.
+    bool add(EventPoolBase& pool) {
+        if (!pools_.empty() && pools_.back()->block_size() > pool.block_size()) {
+            return false;
+        }
+        return pools_.push_back(&pool);
+    }
+
+    // Returns a block of at least `size` bytes and its pool id (1-based), or nullptr if no pool can serve it.
+    void* allocate(std::size_t size, std::uint8_t& pool_id) {
+        for (std::uint8_t i = 0; i < pools_.size(); ++i) {
+            if (pools_[i]->block_size() >= size) {
+                void* block = pools_[i]->allocate();
+                if (block != nullptr) {
+                    pool_id = static_cast<std::uint8_t>(i + 1U);
+                    return block;
+                }
+            }
+        }
+        if (failed_allocations_ < UINT16_MAX) {
+            ++failed_allocations_;
+        }
+        return nullptr;
+    }
+
+    void release(std::uint8_t pool_id, void* block) {
+        pools_[pool_id - 1U]->release(block);
+    }
+
+    // Returns a block to the pool it came from, found by its address; false if no registered pool owns it.
+    bool release(void* block) {
+        for (EventPoolBase* pool : pools_) {
+            if (pool->owns(block)) {
+                pool->release(block);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::uint8_t pool_count() const { return pools_.size(); }
+    const EventPoolBase& pool(std::uint8_t index) const { return *pools_[index]; }
+
+    std::uint16_t failed_allocations() const { return failed_allocations_; }
+
+private:
+    ramen::StaticVector<EventPoolBase*, MAX_POOLS> pools_;
+    std::uint16_t failed_allocations_ = 0;
+};
+
+using EventPoolRegistry = PoolRegistry<3>;
+
+inline EventPoolRegistry event_pools;
+
+// ref_count stops here rather than wrap and free the event while it is still in use; an event that reaches it stays
+// allocated for good
+constexpr std::uint8_t MAX_EVENT_REFS = UINT8_MAX;
+
+inline void retain_event(BaseEvent* evt) {
+    if (evt != nullptr && evt->pool_id != 0) {
+        assert(evt->ref_count != MAX_EVENT_REFS && "Event referenced more than MAX_EVENT_REFS times");
+        if (evt->ref_count != MAX_EVENT_REFS) {
+            ++evt->ref_count;
+        }
+    }
+}
+
+inline void release_event(BaseEvent* evt) {
+    if (evt != nullptr && evt->pool_id != 0 && evt->ref_count != MAX_EVENT_REFS && --evt->ref_count == 0) {
+        // Events are trivially destructible (see AppEvents), so the block can be reused as is
+        event_pools.release(evt->pool_id, evt);
+    }
+}
+
+// Intrusive shared reference to a pool-allocated event. Also accepts non-pool events, which are not counted.
+template <typename E>
+class EventRef {
+public:
+    EventRef() = default;
+    explicit EventRef(E* evt) : evt_(evt) { retain_event(evt_); }
+    EventRef(const EventRef& that) : evt_(that.evt_) { retain_event(evt_); }
+    EventRef(EventRef&& that) noexcept : evt_(that.evt_) { that.evt_ = nullptr; }
+    EventRef& operator=(const EventRef& that) {
+        if (evt_ != that.evt_) {
+            release_event(evt_);
+            evt_ = that.evt_;
+            retain_event(evt_);
+        }
+        return *this;
+    }
+    EventRef& operator=(EventRef&& that) noexcept {
+        if (this != &that) {
+            release_event(evt_);
+            evt_ = that.evt_;
+            that.evt_ = nullptr;
+        }
+        return *this;
+    }
+    ~EventRef() { release_event(evt_); }
+
+    explicit operator bool() const { return evt_ != nullptr; }
+    E* get() const { return evt_; }
+    E& operator*() const { return *evt_; }
+    E* operator->() const { return evt_; }
+
+private:
+    E* evt_ = nullptr;
+};
+
+// Constructs an event in the smallest registered pool that fits it. Returns an empty EventRef when exhausted.
+template <typename E, typename... Args>
+EventRef<E> make_event(Args&&... args) {
+    static_assert(std::is_base_of_v<BaseEvent, E>, "Pooled events must derive from BaseEvent");
+    static_assert(std::is_trivially_destructible_v<E>, "Pooled events are released without running a destructor");
+    std::uint8_t pool_id = 0;
+    void* block = event_pools.allocate(sizeof(E), pool_id);
+    if (block == nullptr) {
+        return EventRef<E>{};
+    }
+    E* evt = new (block) E(std::forward<Args>(args)...);
+    evt->pool_id = pool_id;
+    evt->ref_count = 0;
+    return EventRef<E>{evt};
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <Controllino.h>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
+
+// Digital outputs with the pin fixed at compile time. FastPin<Pin> resolves an Arduino/Controllino pin number of the
+// ATmega2560 to its PORTx register and bit, so high() and low() compile to a single SBI/CBI for ports A..G (a few
+// cycles instead of the 50+ of digitalWrite with its flash lookups, PWM check and SREG save). Ports H..L lie outside
+// the I/O space and are written read-modify-write with interrupts disabled, as digitalWrite does.
+//
+// Unlike digitalWrite, FastPin does not switch off a PWM channel driving the pin; call digitalWrite (or
+// make_output(), which does) once before use. Pins the table does not know, and all pins in non-AVR builds, fall back
+// to digitalWrite. set_output() switches the direction alone, for open-drain lines such as 1-Wire: a pin driven low
+// while an output and released while an input.
+
+namespace gpio {
+
+namespace detail {
+
+enum class Port : std::uint8_t { NONE, A, B, C, D, E, F, G, H, J, K, L };
+
+// Pin mapping of the Arduino Mega 2560 variant (pins_arduino.h), which the Controllino MAXI/MEGA pin numbers follow.
+// In flash: FastPin reads it at compile time, pin_port() and pin_bit() at run time.
+constexpr Port PIN_PORT[] PROGMEM = {
+    Port::E, Port::E, Port::E, Port::E, Port::G, Port::E, Port::H, Port::H,  //  0..7
+    Port::H, Port::H, Port::B, Port::B, Port::B, Port::B, Port::J, Port::J,  //  8..15
+    Port::H, Port::H, Port::D, Port::D, Port::D, Port::D, Port::A, Port::A,  // 16..23
+    Port::A, Port::A, Port::A, Port::A, Port::A, Port::A, Port::C, Port::C,  // 24..31
+    Port::C, Port::C, Port::C, Port::C, Port::C, Port::C, Port::D, Port::G,  // 32..39
+    Port::G, Port::G, Port::L, Port::L, Port::L, Port::L, Port::L, Port::L,  // 40..47
+    Port::L, Port::L, Port::B, Port::B, Port::B, Port::B, Port::F, Port::F,  // 48..55
+    Port::F, Port::F, Port::F, Port::F, Port::F, Port::F, Port::K, Port::K,  // 56..63
+    Port::K, Port::K, Port::K, Port::K, Port::K, Port::K                     // 64..69
+};
+constexpr std::uint8_t PIN_BIT[] PROGMEM = {
+    0, 1, 4, 5, 5, 3, 3, 4,  5, 6, 4, 5, 6, 7, 1, 0,
+    1, 0, 3, 2, 1, 0, 0, 1,  2, 3, 4, 5, 6, 7, 7, 6,
+    5, 4, 3, 2, 1, 0, 7, 2,  1, 0, 7, 6, 5, 4, 3, 2,
+    1, 0, 3, 2, 1, 0, 0, 1,  2, 3, 4, 5, 6, 7, 0, 1,
+    2, 3, 4, 5, 6, 7
+};
+static_assert(sizeof(PIN_PORT) == sizeof(PIN_BIT), "One port and one bit per pin");
+
+constexpr Port port_of(std::uint8_t pin) {
+    return (pin < sizeof(PIN_BIT)) ? PIN_PORT[pin] : Port::NONE;
+}
+
+constexpr std::uint8_t PIN_COUNT = sizeof(PIN_BIT);
+constexpr std::uint8_t PORT_COUNT = static_cast<std::uint8_t>(Port::L);  // Ports A..L
+
+inline Port pin_port(std::uint8_t pin) {
+    return (pin < PIN_COUNT) ? static_cast<Port>(pgm_read_byte(&PIN_PORT[pin])) : Port::NONE;
+}
+inline std::uint8_t pin_bit(std::uint8_t pin) {
+    return (pin < PIN_COUNT) ? pgm_read_byte(&PIN_BIT[pin]) : 0;
+}
+
+} // namespace detail
+
+#if defined(__AVR__) && defined(PORTA)
+namespace detail {
+
+template <Port P>
+struct PortRegs;
+
+// IO_SPACE: the port register is in reach of SBI/CBI (I/O addresses 0x00..0x1F)
+#define GPIO_PORT_REGS(letter, io_space)                                   \
+    template <>                                                            \
+    struct PortRegs<Port::letter> {                                        \
+        static volatile std::uint8_t& out() { return PORT##letter; }       \
+        static volatile std::uint8_t& ddr() { return DDR##letter; }        \
+        static volatile std::uint8_t& in() { return PIN##letter; }         \
+        static constexpr bool IO_SPACE = io_space;                         \
+    };
+GPIO_PORT_REGS(A, true)
+GPIO_PORT_REGS(B, true)
+GPIO_PORT_REGS(C, true)
+GPIO_PORT_REGS(D, true)
+GPIO_PORT_REGS(E, true)
+GPIO_PORT_REGS(F, true)
+GPIO_PORT_REGS(G, true)
+GPIO_PORT_REGS(H, false)
+GPIO_PORT_REGS(J, false)
+GPIO_PORT_REGS(K, false)
+GPIO_PORT_REGS(L, false)
+#undef GPIO_PORT_REGS
+
+// PORTx (or PINx) register of a port index 0..PORT_COUNT-1 (A..L) known only at run time
+inline volatile std::uint8_t* port_register(std::uint8_t port, bool pin_reg) {
+    switch (static_cast<Port>(port + 1U)) {
+        case Port::A: return pin_reg ? &PINA : &PORTA;
+        case Port::B: return pin_reg ? &PINB : &PORTB;
+        case Port::C: return pin_reg ? &PINC : &PORTC;
+        case Port::D: return pin_reg ? &PIND : &PORTD;
+        case Port::E: return pin_reg ? &PINE : &PORTE;
+        case Port::F: return pin_reg ? &PINF : &PORTF;
+        case Port::G: return pin_reg ? &PING : &PORTG;
+        case Port::H: return pin_reg ? &PINH : &PORTH;
+        case Port::J: return pin_reg ? &PINJ : &PORTJ;
+        case Port::K: return pin_reg ? &PINK : &PORTK;
+        case Port::L: return pin_reg ? &PINL : &PORTL;
+        default: return nullptr;
+    }
+}
+
+} // namespace detail
+
+template <std::uint8_t Pin, detail::Port P = detail::port_of(Pin)>
+struct FastPin {
+    using regs = detail::PortRegs<P>;
+    static constexpr std::uint8_t MASK = static_cast<std::uint8_t>(1U << detail::PIN_BIT[Pin]);
+
+    static void make_output() {
+        digitalWrite(Pin, LOW);  // Also detaches PWM
+        set_bits(regs::ddr(), true);
+    }
+    static void high() { set_bits(regs::out(), true); }
+    static void low() { set_bits(regs::out(), false); }
+    static void write(bool level) { set_bits(regs::out(), level); }
+    static void toggle() { regs::in() = MASK; }  // Writing PINx toggles PORTx on the ATmega2560
+    static void set_output(bool output) { set_bits(regs::ddr(), output); }
+    static bool read() { return (regs::in() & MASK) != 0; }
+
+private:
+    __attribute__((always_inline)) static void set_bits(volatile std::uint8_t& reg, bool set) {
+        if (regs::IO_SPACE) {
+            if (set) {
+                reg |= MASK;  // SBI
+            } else {
+                reg &= static_cast<std::uint8_t>(~MASK);  // CBI
+            }
+        } else {
+            const std::uint8_t sreg = SREG;
+            cli();
+            reg = set ? (reg | MASK) : (reg & static_cast<std::uint8_t>(~MASK));
+            SREG = sreg;
+        }
+    }
+};
+
+// Pins outside the Mega pin table go through the Arduino core
+template <std::uint8_t Pin>
+struct FastPin<Pin, detail::Port::NONE> {
+#else
+template <std::uint8_t Pin>
+struct FastPin {
+#endif
+    static void make_output() {
+        pinMode(Pin, OUTPUT);
+        digitalWrite(Pin, LOW);
+    }
+    static void high() { digitalWrite(Pin, HIGH); }
+    static void low() { digitalWrite(Pin, LOW); }
+    static void write(bool level) { digitalWrite(Pin, level ? HIGH : LOW); }
+    static void toggle() { digitalWrite(Pin, digitalRead(Pin) ? LOW : HIGH); }
+    static void set_output(bool output) { pinMode(Pin, output ? OUTPUT : INPUT); }
+    static bool read() { return digitalRead(Pin) != 0; }
+};
+
+} // namespace gpio
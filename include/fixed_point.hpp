@@ -0,0 +1,293 @@
+#pragma once
+#include <Controllino.h>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Signed fixed-point numbers for the filters, control loops and scaled outputs, in place of float: the AVR has no FPU,
+// and a float multiply costs well over 100 cycles where a 16-bit fixed-point one costs about 20.
+//
+//     using Gain = fx::Fixed<7, 8>;                  // Q7.8: -128 .. 127.996, steps of 1/256
+//     constexpr Gain KP(1.75);                       // Converted at compile time
+//     Gain error = Gain(setpoint) - Gain(level);
+//     Gain output = KP * error;                      // One 16x16 multiply, rounded and saturated
+//     fx::Q15 wave = fx::sin_turn(phase);            // Phase in 1/65536 turns, from a table in flash
+//
+// Fixed<I, F> holds I integer bits, F fraction bits and a sign in 8, 16 or 32 bits. Every operation saturates at the
+// ends of the range instead of wrapping, as a control output should, and a division by zero saturates as well.
+// Multiplications widen to twice the bits, which avr-gcc maps onto the hardware multiplier (one `muls` for 8 bits, a
+// few `mul`s for 16 bits); a 32-bit Fixed multiplies in 64 bits, which is far slower, so 16 bits is the format to
+// prefer. The values are trivially copyable and pass through ramen ports by value.
+//
+// The floating-point constructor is meant for constants: at run time it pulls in the float library.
+
+namespace fx {
+
+namespace detail {
+
+template <std::uint8_t Bits>
+using rep_t = std::conditional_t<Bits == 8, std::int8_t, std::conditional_t<Bits == 16, std::int16_t, std::int32_t>>;
+template <std::uint8_t Bits>
+using wide_t = std::conditional_t<Bits == 8, std::int16_t, std::conditional_t<Bits == 16, std::int32_t, std::int64_t>>;
+
+template <typename Rep, typename Wide>
+constexpr Rep saturate(Wide value) {
+    if (value > static_cast<Wide>(std::numeric_limits<Rep>::max())) {
+        return std::numeric_limits<Rep>::max();
+    }
+    if (value < static_cast<Wide>(std::numeric_limits<Rep>::min())) {
+        return std::numeric_limits<Rep>::min();
+    }
+    return static_cast<Rep>(value);
+}
+
+// Shifts right with rounding to nearest, or left; arithmetic for negative values
+template <typename Wide>
+constexpr Wide shift(Wide value, int bits) {
+    if (bits > 0) {
+        return static_cast<Wide>((value + (static_cast<Wide>(1) << (bits - 1))) >> bits);
+    }
+    return static_cast<Wide>(value * (static_cast<Wide>(1) << -bits));
+}
+
+} // namespace detail
+
+template <std::uint8_t I, std::uint8_t F>
+class Fixed {
+    static constexpr std::uint8_t BITS = I + F + 1U;
+    static_assert(BITS == 8 || BITS == 16 || BITS == 32, "Fixed<I, F> needs I + F + 1 to be 8, 16 or 32 bits");
+
+public:
+    using rep = detail::rep_t<BITS>;
+    using wide = detail::wide_t<BITS>;
+    static constexpr std::uint8_t INTEGER_BITS = I;
+    static constexpr std::uint8_t FRACTION_BITS = F;
+    static constexpr wide ONE = static_cast<wide>(1) << F;  // Raw value of 1.0 (which Q0.F cannot hold)
+
+    constexpr Fixed() = default;
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    explicit constexpr Fixed(T value) : raw_(from_integer(value)) {}
+
+    template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+    explicit constexpr Fixed(T value) : raw_(from_floating(static_cast<double>(value))) {}
+
+    // From another format, rounded and saturated
+    template <std::uint8_t I2, std::uint8_t F2>
+    explicit constexpr Fixed(Fixed<I2, F2> that) : raw_(convert(that.raw(), F2)) {}
+
+    static constexpr Fixed from_raw(rep raw) {
+        Fixed f;
+        f.raw_ = raw;
+        return f;
+    }
+    static constexpr Fixed max() { return from_raw(std::numeric_limits<rep>::max()); }
+    static constexpr Fixed min() { return from_raw(std::numeric_limits<rep>::min()); }
+
+    // A fraction num/den of full scale, e.g. an ADC reading: Fixed::ratio(adc, 1023) * Gain(5) for volts
+    static constexpr Fixed ratio(std::int32_t num, std::int32_t den) {
+        if (den == 0) {
+            return num < 0 ? min() : max();
+        }
+        return from_raw(detail::saturate<rep>(static_cast<std::int64_t>(num) * ONE / den));
+    }
+
+    constexpr rep raw() const { return raw_; }
+
+    // Integer part, rounded toward minus infinity; round() to the nearest
+    constexpr rep floor() const { return static_cast<rep>(raw_ >> F); }
+    constexpr rep round() const { return static_cast<rep>(detail::shift<wide>(raw_, F)); }
+    constexpr float to_float() const { return static_cast<float>(raw_) / static_cast<float>(ONE); }
+
+    constexpr Fixed operator-() const { return from_raw(detail::saturate<rep>(-static_cast<wide>(raw_))); }
+
+    constexpr Fixed& operator+=(Fixed that) { return *this = *this + that; }
+    constexpr Fixed& operator-=(Fixed that) { return *this = *this - that; }
+    constexpr Fixed& operator*=(Fixed that) { return *this = *this * that; }
+    constexpr Fixed& operator/=(Fixed that) { return *this = *this / that; }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) {
+        return from_raw(detail::saturate<rep>(static_cast<wide>(a.raw_) + b.raw_));
+    }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) {
+        return from_raw(detail::saturate<rep>(static_cast<wide>(a.raw_) - b.raw_));
+    }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) {
+        return from_raw(detail::saturate<rep>(detail::shift<wide>(static_cast<wide>(a.raw_) * b.raw_, F)));
+    }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) {
+        if (b.raw_ == 0) {
+            return a.raw_ < 0 ? min() : max();
+        }
+        using quotient = std::conditional_t<(BITS > 16), std::int64_t, std::int32_t>;
+        return from_raw(detail::saturate<rep>(static_cast<quotient>(a.raw_) * ONE / b.raw_));
+    }
+    // Scaling by an integer, without converting it to Fixed first
+    friend constexpr Fixed operator*(Fixed a, std::int16_t k) {
+        return from_raw(detail::saturate<rep>(static_cast<wide>(a.raw_) * k));
+    }
+
+    friend constexpr bool operator==(Fixed a, Fixed b) { return a.raw_ == b.raw_; }
+    friend constexpr bool operator!=(Fixed a, Fixed b) { return a.raw_ != b.raw_; }
+    friend constexpr bool operator<(Fixed a, Fixed b) { return a.raw_ < b.raw_; }
+    friend constexpr bool operator<=(Fixed a, Fixed b) { return a.raw_ <= b.raw_; }
+    friend constexpr bool operator>(Fixed a, Fixed b) { return a.raw_ > b.raw_; }
+    friend constexpr bool operator>=(Fixed a, Fixed b) { return a.raw_ >= b.raw_; }
+
+private:
+    rep raw_ = 0;
+
+    template <typename T>
+    static constexpr rep from_integer(T value) {
+        using limit = std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>;
+        if (static_cast<limit>(value) > static_cast<limit>(std::numeric_limits<rep>::max() >> F)) {
+            return std::numeric_limits<rep>::max();
+        }
+        if (std::is_signed_v<T> &&
+            static_cast<std::int64_t>(value) < static_cast<std::int64_t>(std::numeric_limits<rep>::min() >> F)) {
+            return std::numeric_limits<rep>::min();
+        }
+        return static_cast<rep>(static_cast<wide>(value) * ONE);
+    }
+
+    static constexpr rep from_floating(double value) {
+        const double scaled = value * static_cast<double>(ONE);
+        if (scaled >= static_cast<double>(std::numeric_limits<rep>::max())) {
+            return std::numeric_limits<rep>::max();
+        }
+        if (scaled <= static_cast<double>(std::numeric_limits<rep>::min())) {
+            return std::numeric_limits<rep>::min();
+        }
+        return static_cast<rep>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    }
+
+    template <typename Raw>
+    static constexpr rep convert(Raw raw, std::uint8_t from_bits) {
+        return detail::saturate<rep>(detail::shift<std::int64_t>(raw, static_cast<int>(from_bits) - F));
+    }
+};
+
+using Q7 = Fixed<0, 7>;
+using Q15 = Fixed<0, 15>;
+using Q7_8 = Fixed<7, 8>;
+using Q15_16 = Fixed<15, 16>;
+
+namespace detail {
+
+// Series evaluated by the compiler to fill the tables
+constexpr double taylor_sin(double x) {
+    double term = x;
+    double sum = x;
+    for (int k = 1; k < 12; ++k) {
+        term = -term * x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+constexpr double taylor_exp(double x) {
+    double term = 1;
+    double sum = 1;
+    for (int k = 1; k < 20; ++k) {
+        term = term * x / k;
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr std::uint8_t SIN_SEGMENTS = 64;  // Per quarter turn
+constexpr std::uint8_t EXP2_SEGMENT_BITS = 5;
+constexpr std::uint8_t EXP2_SEGMENTS = 1U << EXP2_SEGMENT_BITS;
+
+struct SinTable {
+    std::uint16_t q15[SIN_SEGMENTS + 1];  // sin(i / 64 * pi / 2); 1.0 is stored as 32767
+};
+struct Exp2Table {
+    std::uint16_t q16[EXP2_SEGMENTS + 1];  // 2^(i / 32) - 1; 1.0 is stored as 65535
+};
+
+constexpr SinTable make_sin_table() {
+    SinTable t{};
+    for (std::uint8_t i = 0; i <= SIN_SEGMENTS; ++i) {
+        const double v = taylor_sin(i * (3.14159265358979323846 / 2) / SIN_SEGMENTS) * 32768.0 + 0.5;
+        t.q15[i] = static_cast<std::uint16_t>(v > 32767.0 ? 32767.0 : v);
+    }
+    return t;
+}
+constexpr Exp2Table make_exp2_table() {
+    Exp2Table t{};
+    for (std::uint8_t i = 0; i <= EXP2_SEGMENTS; ++i) {
+        const double v = (taylor_exp(i * 0.69314718055994530942 / EXP2_SEGMENTS) - 1.0) * 65536.0 + 0.5;
+        t.q16[i] = static_cast<std::uint16_t>(v > 65535.0 ? 65535.0 : v);
+    }
+    return t;
+}
+
+inline constexpr SinTable SIN_TABLE PROGMEM = make_sin_table();
+inline constexpr Exp2Table EXP2_TABLE PROGMEM = make_exp2_table();
+
+// Linear interpolation between two table entries; `within` is the position between them in 1/2^Bits
+template <std::uint8_t Bits>
+inline std::uint16_t lerp(const std::uint16_t* entries, std::uint8_t index, std::uint16_t within) {
+    const std::uint16_t a = pgm_read_word(&entries[index]);
+    const std::uint16_t b = pgm_read_word(&entries[index + 1U]);
+    return static_cast<std::uint16_t>(a + ((static_cast<std::uint32_t>(b - a) * within) >> Bits));
+}
+
+} // namespace detail
+
+// Sine of a phase in 1/65536 turns, from a quarter-wave table with linear interpolation; within 2^-13 of the truth
+inline Q15 sin_turn(std::uint16_t phase) {
+    std::uint16_t p = phase & 0x3FFFU;  // Position in the quarter, 14 bits
+    if ((phase & 0x4000U) != 0) {
+        p = static_cast<std::uint16_t>(0x4000U - p);  // Second and fourth quarters run backwards
+    }
+    const std::uint8_t segment = static_cast<std::uint8_t>(p >> 8);
+    const std::uint16_t magnitude = segment == detail::SIN_SEGMENTS
+        ? pgm_read_word(&detail::SIN_TABLE.q15[detail::SIN_SEGMENTS])
+        : detail::lerp<8>(detail::SIN_TABLE.q15, segment, p & 0xFFU);
+    return Q15::from_raw(static_cast<std::int16_t>((phase & 0x8000U) != 0 ? -magnitude : magnitude));
+}
+
+inline Q15 cos_turn(std::uint16_t phase) { return sin_turn(static_cast<std::uint16_t>(phase + 0x4000U)); }
+
+// Phase of an angle in radians, in 1/65536 turns
+template <std::uint8_t I, std::uint8_t F>
+std::uint16_t phase_of(Fixed<I, F> radians) {
+    // 65536 / (2 pi) phase steps per radian, times 4 for two more bits of precision in the product
+    constexpr std::int32_t STEPS_PER_RADIAN_X4 = 41722;
+    using product = std::conditional_t<(I + F + 1 > 16), std::int64_t, std::int32_t>;
+    const product phase = static_cast<product>(radians.raw()) * STEPS_PER_RADIAN_X4;
+    return static_cast<std::uint16_t>(detail::shift<product>(phase, F + 2));
+}
+
+template <std::uint8_t I, std::uint8_t F>
+Q15 sin(Fixed<I, F> radians) { return sin_turn(phase_of(radians)); }
+
+template <std::uint8_t I, std::uint8_t F>
+Q15 cos(Fixed<I, F> radians) { return cos_turn(phase_of(radians)); }
+
+// e^x, as 2^(x log2 e) from a table of 2^(i/32); saturates at the top of the format
+template <std::uint8_t I, std::uint8_t F>
+Fixed<I, F> exp(Fixed<I, F> x) {
+    using Result = Fixed<I, F>;
+    using product = std::conditional_t<(I + F + 1 > 16), std::int64_t, std::int32_t>;
+    constexpr std::int32_t LOG2_E_Q14 = 23637;
+    const product t = detail::shift<product>(static_cast<product>(x.raw()) * LOG2_E_Q14, 14);
+    const std::int32_t n = static_cast<std::int32_t>(t >> F);  // Integer part of x log2 e, floored
+    const std::uint32_t fraction = static_cast<std::uint32_t>(t - static_cast<product>(n) * Result::ONE);
+    const std::uint16_t u = static_cast<std::uint16_t>(F <= 16 ? fraction << (16 - F) : fraction >> (F - 16));
+    constexpr std::uint8_t WITHIN_BITS = 16U - detail::EXP2_SEGMENT_BITS;
+    const std::uint32_t mantissa = 0x10000UL + detail::lerp<WITHIN_BITS>(detail::EXP2_TABLE.q16, u >> WITHIN_BITS,
+                                                                         u & ((1U << WITHIN_BITS) - 1U));
+    const int bits = n + static_cast<int>(F) - 16;  // mantissa is 2^(fraction) in Q16
+    if (bits >= 32) {
+        return Result::max();
+    }
+    if (bits <= -32) {
+        return Result::from_raw(0);
+    }
+    return Result::from_raw(detail::saturate<typename Result::rep>(
+        detail::shift<std::int64_t>(static_cast<std::int64_t>(mantissa), -bits)));
+}
+
+} // namespace fx
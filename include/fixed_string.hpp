@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace ramen
+{
+
+/// String of exactly N characters (plus a terminating NUL) held in place, for text assembled from constant parts in
+/// constant expressions: "LED" + a channel number + " started" becomes one literal where the message is declared,
+/// so a constexpr PROGMEM table of such strings costs its characters in flash and nothing at run time.
+///
+///     constexpr auto STARTED PROGMEM = ramen::fixed_string("LED") + ramen::to_fixed_string<3>() + " started";
+///     out(reinterpret_cast<const __FlashStringHelper*>(STARTED.c_str()));  // "LED3 started"
+///
+/// The length is part of the type, so operator+ adds the lengths of its operands; pad<M>() gives strings of different
+/// lengths a common type for a table, filling up with NULs, which c_str() then stops at.
+template <typename CharT, std::size_t N>
+class BasicFixedString
+{
+public:
+    using value_type = CharT;
+
+    constexpr BasicFixedString() noexcept = default;
+
+    constexpr BasicFixedString(const CharT (&text)[N + 1]) noexcept
+    {
+        for (std::size_t i = 0; i < N; ++i) { chars_[i] = text[i]; }
+    }
+
+    static constexpr std::size_t size() noexcept { return N; }
+    static constexpr bool        empty() noexcept { return N == 0; }
+
+    constexpr const CharT* c_str() const noexcept { return chars_; }
+    constexpr const CharT* data() const noexcept { return chars_; }
+    constexpr const CharT* begin() const noexcept { return chars_; }
+    constexpr const CharT* end() const noexcept { return chars_ + N; }
+
+    constexpr CharT&       operator[](const std::size_t index) noexcept { return chars_[index]; }
+    constexpr const CharT& operator[](const std::size_t index) const noexcept { return chars_[index]; }
+
+    /// This string followed by NULs up to M characters.
+    template <std::size_t M>
+    constexpr BasicFixedString<CharT, M> pad() const noexcept
+    {
+        static_assert(M >= N, "pad() cannot shorten a string");
+        BasicFixedString<CharT, M> result;
+        for (std::size_t i = 0; i < N; ++i) { result[i] = chars_[i]; }
+        return result;
+    }
+
+    template <std::size_t M>
+    constexpr BasicFixedString<CharT, N + M> operator+(const BasicFixedString<CharT, M>& other) const noexcept
+    {
+        BasicFixedString<CharT, N + M> result;
+        for (std::size_t i = 0; i < N; ++i) { result[i] = chars_[i]; }
+        for (std::size_t i = 0; i < M; ++i) { result[N + i] = other[i]; }
+        return result;
+    }
+
+    template <std::size_t M>
+    constexpr BasicFixedString<CharT, N + M - 1> operator+(const CharT (&text)[M]) const noexcept
+    {
+        return *this + BasicFixedString<CharT, M - 1>(text);
+    }
+
+    template <std::size_t M>
+    friend constexpr BasicFixedString<CharT, M - 1 + N> operator+(const CharT (&text)[M],
+                                                                  const BasicFixedString& string) noexcept
+    {
+        return BasicFixedString<CharT, M - 1>(text) + string;
+    }
+
+    template <std::size_t M>
+    constexpr bool operator==(const BasicFixedString<CharT, M>& other) const noexcept
+    {
+        if (M != N) { return false; }
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            if (chars_[i] != other[i]) { return false; }
+        }
+        return true;
+    }
+
+    template <std::size_t M>
+    constexpr bool operator!=(const BasicFixedString<CharT, M>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+private:
+    CharT chars_[N + 1] = {};
+};
+
+template <typename CharT, std::size_t M>
+BasicFixedString(const CharT (&)[M]) -> BasicFixedString<CharT, M - 1>;
+
+template <std::size_t N>
+using FixedString = BasicFixedString<char, N>;
+
+/// A string literal as a FixedString.
+template <std::size_t M>
+constexpr FixedString<M - 1> fixed_string(const char (&text)[M]) noexcept
+{
+    return FixedString<M - 1>(text);
+}
+
+namespace detail
+{
+constexpr std::size_t decimal_digits(unsigned long value) noexcept
+{
+    std::size_t digits = 1;
+    for (; value >= 10; value /= 10) { ++digits; }
+    return digits;
+}
+} // namespace detail
+
+/// The decimal digits of Value.
+template <unsigned long Value>
+constexpr FixedString<detail::decimal_digits(Value)> to_fixed_string() noexcept
+{
+    FixedString<detail::decimal_digits(Value)> result;
+    unsigned long value = Value;
+    for (std::size_t i = result.size(); i > 0; --i)
+    {
+        result[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return result;
+}
+
+} // namespace ramen
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "small_size.hpp"
+#include "static_vector.hpp"
+#include <cstddef>
+
+namespace ramen
+{
+
+/// Default ordering of FlatMap, std::less without pulling in <functional> (see the notes of ramen.hpp).
+struct Less
+{
+    template <typename T>
+    constexpr bool operator()(const T& lhs, const T& rhs) const noexcept { return lhs < rhs; }
+};
+
+/// Map of at most N entries, kept as two StaticVectors sorted by key: lookups are a binary search over the keys and
+/// insertions and removals move the later entries, which for the few entries of a controller costs less flash and
+/// RAM than a tree and allocates nothing. As in StaticVector, a full map refuses new keys by returning false.
+///
+///   ramen::FlatMap<std::uint8_t, Handler, 8> handlers;
+///   handlers.insert_or_assign(0x03, &read_registers);
+///   if (const Handler* handler = handlers.find(function_code)) { ... }
+///
+/// Compare must be a strict weak ordering and default-constructible. Usable in constant expressions.
+template <typename K, typename V, std::size_t N, typename Compare = Less>
+class FlatMap
+{
+public:
+    using key_type    = K;
+    using mapped_type = V;
+    using size_type   = small_size_t<N>;
+
+    static constexpr size_type capacity() noexcept { return static_cast<size_type>(N); }
+
+    constexpr size_type size() const noexcept { return keys_.size(); }
+    constexpr bool      empty() const noexcept { return keys_.empty(); }
+    constexpr bool      full() const noexcept { return keys_.full(); }
+
+    /// The value of `key`, or nullptr if the map does not hold it.
+    constexpr V* find(const K& key) noexcept
+    {
+        const size_type index = lower_bound(key);
+        return matches(index, key) ? &values_[index] : nullptr;
+    }
+
+    constexpr const V* find(const K& key) const noexcept
+    {
+        const size_type index = lower_bound(key);
+        return matches(index, key) ? &values_[index] : nullptr;
+    }
+
+    constexpr bool contains(const K& key) const noexcept { return find(key) != nullptr; }
+
+    /// Adds `key` with `value`, or replaces the value of a key the map holds; returns false if the key is new and the
+    /// map is full.
+    constexpr bool insert_or_assign(const K& key, const V& value)
+    {
+        const size_type index = lower_bound(key);
+        if (matches(index, key))
+        {
+            values_[index] = value;
+            return true;
+        }
+        return !full() && keys_.insert(index, key) && values_.insert(index, value);
+    }
+
+    /// Removes `key`; returns false if the map does not hold it.
+    constexpr bool erase(const K& key)
+    {
+        const size_type index = lower_bound(key);
+        if (!matches(index, key)) { return false; }
+        keys_.erase(index);
+        values_.erase(index);
+        return true;
+    }
+
+    constexpr void clear() noexcept
+    {
+        keys_.clear();
+        values_.clear();
+    }
+
+    /// Access by position, in ascending key order.
+    constexpr const K& key_at(const size_type index) const noexcept { return keys_[index]; }
+    constexpr V&       value_at(const size_type index) noexcept { return values_[index]; }
+    constexpr const V& value_at(const size_type index) const noexcept { return values_[index]; }
+
+private:
+    /// Position of the first key not less than `key`.
+    constexpr size_type lower_bound(const K& key) const noexcept
+    {
+        size_type first = 0;
+        size_type count = keys_.size();
+        while (count > 0)
+        {
+            const size_type half = static_cast<size_type>(count / 2U);
+            if (Compare{}(keys_[static_cast<size_type>(first + half)], key))
+            {
+                first = static_cast<size_type>(first + half + 1U);
+                count = static_cast<size_type>(count - half - 1U);
+            }
+            else
+            {
+                count = half;
+            }
+        }
+        return first;
+    }
+
+    constexpr bool matches(const size_type index, const K& key) const noexcept
+    {
+        return index < keys_.size() && !Compare{}(key, keys_[index]);
+    }
+
+    StaticVector<K, N> keys_;
+    StaticVector<V, N> values_;
+};
+
+} // namespace ramen
@@ -0,0 +1,208 @@
+#pragma once
+#include <Controllino.h>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// Typed text formatting without printf. fmt::write() streams its arguments, in order, into a sink: any object with a
+// `void put(const char* data, std::size_t length)` member. Integers go through std::to_chars (lib/avr-libstdcpp on
+// AVR), so avr-libc's vfprintf is not linked and nothing is parsed at run time:
+//
+//     fmt::Line<48> msg;
+//     fmt::write(msg, "LED", id, " interval set to ", ms, "ms");
+//     response_out(msg.c_str());
+//
+// Arguments are strings, chars, integers, flash strings (fmt::flash() or F()), and the wrappers fmt::left() and
+// fmt::right() (padded to a width, like %-7u and %5lu) and fmt::hex() (zero-filled hexadecimal, like %04x).
+
+namespace fmt {
+
+// Sink writing into a caller's character array, always NUL-terminated; what does not fit is cut off
+class Buffer {
+public:
+    Buffer(char* data, std::size_t capacity) : data_(data), capacity_(capacity) {
+        if (capacity_ > 0) {
+            data_[0] = '\0';
+        }
+    }
+
+    void put(const char* text, std::size_t length) {
+        if (capacity_ == 0) {
+            return;
+        }
+        const std::size_t room = capacity_ - 1U - length_;
+        const std::size_t n = (length < room) ? length : room;
+        std::memcpy(data_ + length_, text, n);
+        length_ += n;
+        data_[length_] = '\0';
+    }
+
+    // Appends blanks up to `column` characters, e.g. to align the next field
+    void pad_to(std::size_t column) {
+        while (length_ < column && length_ + 1U < capacity_) {
+            put(" ", 1);
+        }
+    }
+
+    void clear() {
+        length_ = 0;
+        if (capacity_ > 0) {
+            data_[0] = '\0';
+        }
+    }
+
+    const char* c_str() const { return data_; }
+    std::size_t size() const { return length_; }
+
+private:
+    char* const data_;
+    const std::size_t capacity_;
+    std::size_t length_ = 0;
+};
+
+// A Buffer with its own storage of N characters, terminator included
+template <std::size_t N>
+class Line : public Buffer {
+    static_assert(N > 0, "A line needs room for its terminator");
+
+public:
+    Line() : Buffer(storage_, N) {}
+    Line(const Line&) = delete;
+    Line& operator=(const Line&) = delete;
+
+private:
+    char storage_[N];
+};
+
+// Sink that only counts, for padding
+class Counter {
+public:
+    void put(const char*, std::size_t length) { length_ += length; }
+    std::size_t size() const { return length_; }
+
+private:
+    std::size_t length_ = 0;
+};
+
+struct Flash {
+    const char* str;  // In PROGMEM
+};
+
+inline Flash flash(const char* str_P) { return Flash{str_P}; }
+
+template <class T>
+struct Padded {
+    const T& value;
+    std::uint8_t width;
+    bool left;
+};
+
+// `value` followed by blanks up to `width` characters
+template <class T>
+Padded<T> left(const T& value, std::uint8_t width) { return Padded<T>{value, width, true}; }
+
+// `value` after blanks up to `width` characters
+template <class T>
+Padded<T> right(const T& value, std::uint8_t width) { return Padded<T>{value, width, false}; }
+
+struct Hex {
+    std::uint32_t value;
+    std::uint8_t digits;  // At least this many, zero-filled
+};
+
+inline Hex hex(std::uint32_t value, std::uint8_t digits = 1) { return Hex{value, digits}; }
+
+namespace detail {
+
+template <class T>
+constexpr bool is_number = std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                           !std::is_same<T, char>::value;
+
+template <class Sink>
+void put_arg(Sink& sink, const char* str) {
+    if (str != nullptr) {
+        sink.put(str, std::strlen(str));
+    }
+}
+
+template <class Sink>
+void put_arg(Sink& sink, char c) {
+    sink.put(&c, 1);
+}
+
+template <class Sink>
+void put_arg(Sink& sink, const Flash& str) {
+    char chunk[8];
+    std::size_t n = 0;
+    for (const char* p = str.str; p != nullptr; ++p) {
+        const char c = static_cast<char>(pgm_read_byte(p));
+        if (c == '\0') {
+            break;
+        }
+        chunk[n++] = c;
+        if (n == sizeof(chunk)) {
+            sink.put(chunk, n);
+            n = 0;
+        }
+    }
+    sink.put(chunk, n);
+}
+
+template <class Sink>
+void put_arg(Sink& sink, const __FlashStringHelper* str) {
+    put_arg(sink, Flash{reinterpret_cast<const char*>(str)});
+}
+
+template <class Sink, class T, std::enable_if_t<is_number<T>, int> = 0>
+void put_arg(Sink& sink, T value) {
+    char digits[std::numeric_limits<T>::digits10 + 3];  // Sign and the digit digits10 leaves out
+    const std::to_chars_result r = std::to_chars(digits, digits + sizeof(digits), value);
+    sink.put(digits, static_cast<std::size_t>(r.ptr - digits));
+}
+
+template <class Sink>
+void put_arg(Sink& sink, const Hex& h) {
+    char digits[8];
+    const std::to_chars_result r = std::to_chars(digits, digits + sizeof(digits), h.value, 16);
+    const std::size_t n = static_cast<std::size_t>(r.ptr - digits);
+    for (std::size_t i = n; i < h.digits; ++i) {
+        sink.put("0", 1);
+    }
+    sink.put(digits, n);
+}
+
+template <class Sink>
+void put_blanks(Sink& sink, std::size_t count) {
+    static const char blanks[] = "        ";
+    while (count > 0) {
+        const std::size_t n = (count < sizeof(blanks) - 1U) ? count : sizeof(blanks) - 1U;
+        sink.put(blanks, n);
+        count -= n;
+    }
+}
+
+template <class Sink, class T>
+void put_arg(Sink& sink, const Padded<T>& p) {
+    Counter counter;
+    put_arg(counter, p.value);  // Formatted twice rather than buffered
+    const std::size_t fill = (counter.size() < p.width) ? p.width - counter.size() : 0;
+    if (!p.left) {
+        put_blanks(sink, fill);
+    }
+    put_arg(sink, p.value);
+    if (p.left) {
+        put_blanks(sink, fill);
+    }
+}
+
+} // namespace detail
+
+template <class Sink, class... Args>
+void write(Sink& sink, const Args&... args) {
+    (detail::put_arg(sink, args), ...);
+}
+
+} // namespace fmt
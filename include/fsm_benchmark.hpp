@@ -0,0 +1,85 @@
+#pragma once
+#include "actor_fsm.hpp"
+#include "actor_led.hpp"
+#include "cycle_counter.hpp"
+#include "fmt.hpp"
+#include "ramen.hpp"
+#include <cstdint>
+
+// On-target comparison of the SML dispatch policies (see actor_fsm.hpp), run by the 'fsmbench' command.
+//
+// Each policy drives its own instance of the LED state machine with a no-op context (no pin, no timer) through
+// ITERATIONS periodic_timeout events, so the measurement is the cost of process_event() itself. The cost of the
+// timing loop is measured separately and subtracted. Every policy instantiates another copy of the machine, so
+// the benchmark is only compiled in with -D FSM_BENCHMARK.
+
+namespace fsm_benchmark {
+
+#if defined(FSM_BENCHMARK)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint16_t ITERATIONS = 256;
+
+// Stands in for blinky_led_context: no pin, no timer
+struct null_led_context {
+    std::uint32_t blink_interval_ms = 1;
+    void led_on() {}
+    void led_off() {}
+    void request_periodic_timer() {}
+    void disarm_periodic_timer() {}
+};
+
+#if defined(FSM_BENCHMARK)
+inline std::uint32_t loop_overhead() {
+    volatile std::uint16_t sink = 0;
+    const std::uint32_t start = cycle_counter::now();
+    for (std::uint16_t i = 0; i < ITERATIONS; ++i) {
+        sink = i;
+    }
+    (void)sink;
+    return cycle_counter::now() - start;
+}
+
+template <class Dispatch>
+void measure(const char* name, std::uint32_t overhead, ramen::Pusher<const char*>& out) {
+    using fsm_type = led::periodic_blinky_fsm<null_led_context>;
+    null_led_context context;
+    fsm::actor_sm<fsm_type, Dispatch, led::fsm_queue_policy> sm{context};
+    sm.process_event(led::start_blinking{});
+
+    const std::uint32_t start = cycle_counter::now();
+    for (std::uint16_t i = 0; i < ITERATIONS; ++i) {
+        sm.process_event(led::periodic_timeout{});
+    }
+    std::uint32_t cycles = cycle_counter::now() - start;
+    cycles = (cycles > overhead) ? (cycles - overhead) : 0;
+
+    fmt::Line<64> msg;
+    fmt::write(msg, "  ", fmt::left(name, 11), ' ', fmt::right(static_cast<unsigned long>(cycles / ITERATIONS), 5),
+               " cycles/event  ", fmt::right(static_cast<unsigned>(sizeof(sm)), 3), " bytes");
+    out(msg.c_str());
+}
+#endif
+
+// Reports through `out` and, for constant text, `flash_out`
+inline void run(ramen::Pusher<const char*>& out, ramen::Pusher<const __FlashStringHelper*>& flash_out) {
+#if defined(FSM_BENCHMARK)
+    const std::uint32_t overhead = loop_overhead();
+    flash_out(F("SML dispatch policy benchmark (periodic_blinky_fsm):"));
+    measure<fsm::dispatch::switch_stm>("switch_stm", overhead, out);
+    measure<fsm::dispatch::branch_stm>("branch_stm", overhead, out);
+    measure<fsm::dispatch::jump_table>("jump_table", overhead, out);
+#if defined(__cpp_fold_expressions)
+    measure<fsm::dispatch::fold_expr>("fold_expr", overhead, out);
+#endif
+    flash_out(F("Flash: build with -D LED_FSM_DISPATCH=<policy> and compare 'pio run' sizes"));
+#else
+    (void)out;
+    flash_out(F("FSM benchmark disabled (build with -D FSM_BENCHMARK)"));
+#endif
+}
+
+} // namespace fsm_benchmark
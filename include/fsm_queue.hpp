@@ -0,0 +1,131 @@
+#pragma once
+#include "ring_buffer.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Allocation-free event queue for SML's process_queue and defer_queue policies.
+//
+// SML instantiates the queue with its move-only, type-erased queue_event; the container only needs the subset of
+// std::queue / std::deque that SML calls: push / front / pop for process_queue, and push_back / begin / end / erase
+// for defer_queue. Storage is a fixed ring; an event posted to a full queue is dropped and counted. Since the
+// capacity is part of the type, pass it through the nested alias:
+//
+//     boost::sml::sm<my_fsm, boost::sml::process_queue<fsm::static_queue<4>::type>> sm;
+//
+// Events posted with process() from an action are handled when the current transition has completed, still inside
+// the same process_event() call, instead of re-entering ports from the middle of the action.
+
+namespace fsm {
+
+template <class T, std::size_t N>
+class StaticQueue {
+    static_assert(N > 0, "StaticQueue capacity must be positive");
+
+public:
+    using value_type = T;
+    using size_type = ramen::small_size_t<N>;
+
+    class const_iterator {
+    public:
+        const_iterator() = default;
+        const T& operator*() const { return (*queue_)[index_]; }
+        const T* operator->() const { return &(*queue_)[index_]; }
+        const_iterator& operator++() { ++index_; return *this; }
+        bool operator==(const const_iterator& that) const { return index_ == that.index_; }
+        bool operator!=(const const_iterator& that) const { return index_ != that.index_; }
+
+    private:
+        friend class StaticQueue;
+        const_iterator(const StaticQueue* queue, size_type index) : queue_(queue), index_(index) {}
+        const StaticQueue* queue_ = nullptr;
+        size_type index_ = 0;
+    };
+
+    StaticQueue() = default;
+    StaticQueue(const StaticQueue&) = delete;
+    StaticQueue& operator=(const StaticQueue&) = delete;
+    ~StaticQueue() {
+        while (count_ > 0) {
+            pop();
+        }
+    }
+
+    bool empty() const { return count_ == 0; }
+    size_type size() const { return count_; }
+    static constexpr size_type capacity() { return static_cast<size_type>(N); }
+
+    // Number of events dropped because the queue was full; saturates at 255.
+    std::uint8_t dropped() const { return dropped_; }
+
+    void push(T&& item) {
+        if (count_ >= N) {
+            if (dropped_ != UINT8_MAX) {
+                ++dropped_;
+            }
+            return;
+        }
+        new (raw(count_)) T(std::move(item));
+        ++count_;
+    }
+    void push_back(T&& item) { push(std::move(item)); }
+
+    T& front() { return slot(0); }
+    const T& front() const { return slot(0); }
+
+    void pop() {
+        if (count_ == 0) {
+            return;
+        }
+        slot(0).~T();
+        head_ = wrap(head_ + 1U);
+        --count_;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count_); }
+
+    // Removes the element at `pos`, keeping the order of the others; returns an iterator to the next element.
+    const_iterator erase(const_iterator pos) {
+        slot(pos.index_).~T();
+        for (size_type i = pos.index_; static_cast<size_type>(i + 1U) < count_; ++i) {
+            T& next = slot(static_cast<size_type>(i + 1U));
+            new (raw(i)) T(std::move(next));
+            next.~T();
+        }
+        --count_;
+        return const_iterator(this, pos.index_);
+    }
+
+    const T& operator[](size_type index) const { return slot(index); }
+
+private:
+    // Raw storage: SML's queue_event is move-only and a default-constructed one cannot be assigned from,
+    // so elements are constructed and destroyed in place.
+    struct alignas(T) Storage {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    static size_type wrap(std::size_t index) { return static_cast<size_type>((index >= N) ? (index - N) : index); }
+    void* raw(size_type index) { return items_[wrap(head_ + index)].bytes; }
+    T& slot(size_type index) { return *std::launder(reinterpret_cast<T*>(items_[wrap(head_ + index)].bytes)); }
+    const T& slot(size_type index) const {
+        return *std::launder(reinterpret_cast<const T*>(items_[wrap(head_ + index)].bytes));
+    }
+
+    std::array<Storage, N> items_{};
+    size_type head_ = 0;
+    size_type count_ = 0;
+    std::uint8_t dropped_ = 0;
+};
+
+// Adapts StaticQueue to the single-parameter container template expected by the SML queue policies.
+template <std::size_t N>
+struct static_queue {
+    template <class T>
+    using type = StaticQueue<T, N>;
+};
+
+} // namespace fsm
@@ -0,0 +1,357 @@
+#pragma once
+#include "process_image.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// Banks of the IEC 61131-3 standard function blocks: TON, TOF and TP timers, CTU and CTD counters, R_TRIG and F_TRIG
+// edge detectors, by the hundred. A TimerActor slot per timer would run out of slots and RAM long before that.
+//
+// A bank keeps its instances as a structure of arrays: the presets and elapsed times or counts in arrays of words,
+// the inputs, outputs and modes in arrays of bits, 8 instances to a byte. A timer costs 4 bytes and 6 bits. update()
+// runs all of them in one loop per scan, with the time since the last scan shared by every timer. Bytes whose 8
+// instances have nothing to do, no input changed and no timer running, are skipped whole. The edge detectors are
+// evaluated 8 at a time by byte operations. The cost grows linearly with the instances, a few cycles for an idle
+// one (see the micro-benchmark).
+//
+//     fb::TimerBank<200> timers;  // Presets in ms; TimerBank<N, 100> counts in 100 ms units, up to 109 min
+//     fb::CounterBank<32> counters;
+//     constexpr fb::Binding TIMER_INPUTS[] PROGMEM = {{CONTROLLINO_IN0, 0}, {CONTROLLINO_IN1, 1}};
+//     constexpr fb::Binding TIMER_OUTPUTS[] PROGMEM = {{CONTROLLINO_D0, 0}};
+//
+//     void setup() {
+//         timers.configure(0, fb::TimerBank<200>::TON, 500);
+//         timers.configure(1, fb::TimerBank<200>::TOF, 2000);
+//         counters.configure(0, fb::CounterBank<32>::CTU, 10);
+//     }
+//     void loop() {
+//         image.read_inputs();
+//         fb::read_inputs(image, timers, TIMER_INPUTS);
+//         timers.scan();                    // Or update(delta) with the delta of a cyclic executive's group
+//         counters.set_in(0, timers.q(1));  // Function blocks chained through their bits
+//         counters.update();
+//         fb::write_outputs(image, timers, TIMER_OUTPUTS);
+//         image.commit_outputs();
+//     }
+//
+// The inputs are those set since the last update(), as a PLC samples them at the start of the scan: a timer starts at
+// the update that sees its input rise and counts from the next one, so its output follows within one scan of the
+// preset. The outputs are bits as well, for the process image through a Binding table in flash, or for other blocks.
+
+namespace fb {
+
+template <std::uint16_t N>
+using Bits = std::array<std::uint8_t, (N + 7U) / 8U>;
+
+template <std::size_t Bytes>
+bool bit(const std::array<std::uint8_t, Bytes>& bits, std::uint16_t i) {
+    return (bits[i >> 3] & (1U << (i & 7U))) != 0;
+}
+
+template <std::size_t Bytes>
+void assign(std::array<std::uint8_t, Bytes>& bits, std::uint16_t i, bool value) {
+    const auto mask = static_cast<std::uint8_t>(1U << (i & 7U));
+    bits[i >> 3] = static_cast<std::uint8_t>(value ? (bits[i >> 3] | mask) : (bits[i >> 3] & ~mask));
+}
+
+// A pin of the process image and the instance of a bank it feeds or shows, in PROGMEM tables
+struct Binding {
+    std::uint8_t pin;
+    std::uint16_t instance;
+};
+
+// The elapsed time of the last scan() in units of TickMs, carrying the remainder to the next; the time of the scan
+// is that of the scan clock (scan_clock.hpp), millis() unless -D SCAN_CLOCK
+template <std::uint16_t TickMs>
+class ScanClock {
+public:
+    std::uint16_t delta() {
+        const std::uint32_t now = scan_clock::now();
+        const std::uint32_t ticks = (now - last_ms_) / TickMs;
+        last_ms_ += ticks * TickMs;
+        return static_cast<std::uint16_t>((ticks > UINT16_MAX) ? UINT16_MAX : ticks);
+    }
+
+private:
+    std::uint32_t last_ms_ = 0;
+};
+
+// TON (on delay), TOF (off delay) and TP (pulse) timers; presets and elapsed times in units of TickMs
+template <std::uint16_t N, std::uint16_t TickMs = 1>
+class TimerBank {
+    static_assert(N > 0, "A timer bank needs timers");
+    static_assert(TickMs > 0, "The time unit of a timer bank is at least 1 ms");
+
+public:
+    enum Type : std::uint8_t { TON, TOF, TP };
+
+    static constexpr std::uint16_t SIZE = N;
+
+    // Sets the type and preset of a timer and resets it
+    void configure(std::uint16_t i, Type type, std::uint16_t preset) {
+        if (i >= N) {
+            return;
+        }
+        preset_[i] = preset;
+        elapsed_[i] = 0;
+        assign(tof_, i, type == TOF);
+        assign(tp_, i, type == TP);
+        assign(q_, i, false);
+        assign(running_, i, false);
+        assign(last_in_, i, false);
+        assign(in_, i, false);
+    }
+
+    void set_preset(std::uint16_t i, std::uint16_t preset) {
+        if (i < N) {
+            preset_[i] = preset;
+        }
+    }
+
+    void set_in(std::uint16_t i, bool in) {
+        if (i < N) {
+            assign(in_, i, in);
+        }
+    }
+
+    bool q(std::uint16_t i) const { return i < N && bit(q_, i); }
+    std::uint16_t elapsed(std::uint16_t i) const { return (i < N) ? elapsed_[i] : 0; }
+    std::uint16_t preset(std::uint16_t i) const { return (i < N) ? preset_[i] : 0; }
+
+    // The inputs and outputs as bits, e.g. to set or read 8 timers at once
+    Bits<N>& in_bits() { return in_; }
+    const Bits<N>& q_bits() const { return q_; }
+
+    // One scan, `delta` units of TickMs after the last
+    void update(std::uint16_t delta) {
+        for (std::uint16_t byte = 0; byte < in_.size(); ++byte) {
+            const std::uint8_t changed = static_cast<std::uint8_t>(in_[byte] ^ last_in_[byte]);
+            std::uint8_t work = static_cast<std::uint8_t>(changed | running_[byte]);
+            if (work == 0) {
+                continue;
+            }
+            std::uint8_t q = q_[byte];
+            std::uint8_t running = running_[byte];
+            const std::uint8_t in = in_[byte];
+            const std::uint8_t tof = tof_[byte];
+            const std::uint8_t tp = tp_[byte];
+            for (std::uint8_t b = 0; work != 0; ++b, work = static_cast<std::uint8_t>(work >> 1)) {
+                if ((work & 1U) == 0) {
+                    continue;
+                }
+                const std::uint16_t i = static_cast<std::uint16_t>((byte << 3) + b);
+                const auto mask = static_cast<std::uint8_t>(1U << b);
+                const bool high = (in & mask) != 0;
+                const bool edge = (changed & mask) != 0;
+                bool out = (q & mask) != 0;
+                bool timing = (running & mask) != 0;
+                if (tp & mask) {
+                    if (edge && high && !out) {
+                        elapsed_[i] = 0;
+                        out = timing = preset_[i] > 0;
+                    } else if (timing && advance(i, delta)) {
+                        out = timing = false;
+                    }
+                    if (!high && !timing) {
+                        elapsed_[i] = 0;
+                    }
+                } else if (tof & mask) {
+                    if (high) {
+                        elapsed_[i] = 0;
+                        out = true;
+                        timing = false;
+                    } else if (edge) {
+                        out = timing = preset_[i] > 0;
+                    } else if (timing && advance(i, delta)) {
+                        out = timing = false;
+                    }
+                } else {
+                    if (!high) {
+                        elapsed_[i] = 0;
+                        out = timing = false;
+                    } else if (edge) {
+                        out = preset_[i] == 0;
+                        timing = !out;
+                    } else if (timing && advance(i, delta)) {
+                        out = true;
+                        timing = false;
+                    }
+                }
+                q = static_cast<std::uint8_t>(out ? (q | mask) : (q & ~mask));
+                running = static_cast<std::uint8_t>(timing ? (running | mask) : (running & ~mask));
+            }
+            q_[byte] = q;
+            running_[byte] = running;
+            last_in_[byte] = in;
+        }
+    }
+
+    // One scan, timed by the scan clock
+    void scan() { update(clock_.delta()); }
+
+private:
+    std::array<std::uint16_t, N> preset_{};
+    std::array<std::uint16_t, N> elapsed_{};
+    Bits<N> in_{};
+    Bits<N> last_in_{};  // As of the last update()
+    Bits<N> q_{};
+    Bits<N> running_{};
+    Bits<N> tof_{};
+    Bits<N> tp_{};
+    ScanClock<TickMs> clock_;
+
+    // True once the timer reaches its preset
+    bool advance(std::uint16_t i, std::uint16_t delta) {
+        if (preset_[i] - elapsed_[i] <= delta) {
+            elapsed_[i] = preset_[i];
+            return true;
+        }
+        elapsed_[i] = static_cast<std::uint16_t>(elapsed_[i] + delta);
+        return false;
+    }
+};
+
+// CTU (up) and CTD (down) counters, counting rising edges of their input. The reset input is R of a CTU, which holds
+// the count at 0, and LD of a CTD, which holds it at the preset. A CTU's output is count >= preset, a CTD's count <= 0.
+template <std::uint16_t N>
+class CounterBank {
+    static_assert(N > 0, "A counter bank needs counters");
+
+public:
+    enum Type : std::uint8_t { CTU, CTD };
+
+    static constexpr std::uint16_t SIZE = N;
+
+    // Sets the type and preset of a counter, and its count to 0 (CTU) or the preset (CTD)
+    void configure(std::uint16_t i, Type type, std::int16_t preset) {
+        if (i >= N) {
+            return;
+        }
+        preset_[i] = preset;
+        count_[i] = (type == CTD) ? preset : 0;
+        assign(down_, i, type == CTD);
+        assign(last_in_, i, bit(in_, i));
+        refresh(i);
+    }
+
+    void set_in(std::uint16_t i, bool in) {
+        if (i < N) {
+            assign(in_, i, in);
+        }
+    }
+
+    void set_reset(std::uint16_t i, bool reset) {
+        if (i < N) {
+            assign(reset_, i, reset);
+        }
+    }
+
+    bool q(std::uint16_t i) const { return i < N && bit(q_, i); }
+    std::int16_t count(std::uint16_t i) const { return (i < N) ? count_[i] : 0; }
+
+    Bits<N>& in_bits() { return in_; }
+    Bits<N>& reset_bits() { return reset_; }
+    const Bits<N>& q_bits() const { return q_; }
+
+    void update() {
+        for (std::uint16_t byte = 0; byte < in_.size(); ++byte) {
+            const std::uint8_t rising = static_cast<std::uint8_t>(in_[byte] & ~last_in_[byte]);
+            std::uint8_t work = static_cast<std::uint8_t>(rising | reset_[byte]);
+            last_in_[byte] = in_[byte];
+            for (std::uint8_t b = 0; work != 0; ++b, work = static_cast<std::uint8_t>(work >> 1)) {
+                if ((work & 1U) == 0) {
+                    continue;
+                }
+                const std::uint16_t i = static_cast<std::uint16_t>((byte << 3) + b);
+                const auto mask = static_cast<std::uint8_t>(1U << b);
+                const bool down = (down_[byte] & mask) != 0;
+                if (reset_[byte] & mask) {
+                    count_[i] = down ? preset_[i] : 0;
+                } else if (!down && count_[i] < INT16_MAX) {
+                    ++count_[i];
+                } else if (down && count_[i] > INT16_MIN) {
+                    --count_[i];
+                }
+                refresh(i);
+            }
+        }
+    }
+
+private:
+    std::array<std::int16_t, N> preset_{};
+    std::array<std::int16_t, N> count_{};
+    Bits<N> in_{};
+    Bits<N> last_in_{};
+    Bits<N> reset_{};
+    Bits<N> q_{};
+    Bits<N> down_{};
+
+    void refresh(std::uint16_t i) {
+        assign(q_, i, bit(down_, i) ? count_[i] <= 0 : count_[i] >= preset_[i]);
+    }
+};
+
+// R_TRIG and F_TRIG edge detectors: the output is true for the one update() after the input rose, or fell
+template <std::uint16_t N>
+class EdgeBank {
+    static_assert(N > 0, "An edge bank needs detectors");
+
+public:
+    enum Type : std::uint8_t { R_TRIG, F_TRIG };
+
+    static constexpr std::uint16_t SIZE = N;
+
+    void configure(std::uint16_t i, Type type) {
+        if (i < N) {
+            assign(falling_, i, type == F_TRIG);
+        }
+    }
+
+    void set_in(std::uint16_t i, bool in) {
+        if (i < N) {
+            assign(in_, i, in);
+        }
+    }
+
+    bool q(std::uint16_t i) const { return i < N && bit(q_, i); }
+
+    Bits<N>& in_bits() { return in_; }
+    const Bits<N>& q_bits() const { return q_; }
+
+    void update() {
+        for (std::uint16_t byte = 0; byte < in_.size(); ++byte) {
+            const std::uint8_t in = in_[byte];
+            const std::uint8_t last = last_in_[byte];
+            const std::uint8_t falling = falling_[byte];
+            q_[byte] = static_cast<std::uint8_t>((in & ~last & ~falling) | (~in & last & falling));
+            last_in_[byte] = in;
+        }
+    }
+
+private:
+    Bits<N> in_{};
+    Bits<N> last_in_{};
+    Bits<N> falling_{};
+    Bits<N> q_{};
+};
+
+// Sets the inputs of a bank from the pins of the process image, as of its last read_inputs()
+template <class Bank, std::size_t Count>
+void read_inputs(const process_image::ProcessImage& image, Bank& bank, const Binding (&table_P)[Count]) {
+    for (std::size_t k = 0; k < Count; ++k) {
+        const auto pin = static_cast<std::uint8_t>(pgm_read_byte(&table_P[k].pin));
+        bank.set_in(static_cast<std::uint16_t>(pgm_read_word(&table_P[k].instance)), image.input(pin));
+    }
+}
+
+// Writes the outputs of a bank to the pins of the process image, for its next commit_outputs()
+template <class Bank, std::size_t Count>
+void write_outputs(process_image::ProcessImage& image, const Bank& bank, const Binding (&table_P)[Count]) {
+    for (std::size_t k = 0; k < Count; ++k) {
+        const auto pin = static_cast<std::uint8_t>(pgm_read_byte(&table_P[k].pin));
+        image.write(pin, bank.q(static_cast<std::uint16_t>(pgm_read_word(&table_P[k].instance))));
+    }
+}
+
+} // namespace fb
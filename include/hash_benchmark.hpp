@@ -0,0 +1,138 @@
+#pragma once
+#include "cycle_counter.hpp"
+#include "fmt.hpp"
+#include "ramen.hpp"
+#include <bits/hash_bytes.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// On-target comparison of the byte hashes behind std::hash and the unordered containers, run by the 'hashbench'
+// command.
+//
+// With a 16-bit size_t, avr-libstdcpp's std::_Hash_bytes is CRC-CCITT and std::_Fnv_hash_bytes a 16-bit FNV-1a;
+// -D AVR_STD_HASH_FNV makes std::hash use the latter. The 32-bit MurmurHash2 that libstdc++ uses where size_t has
+// 32 bits is measured next to them for reference. Each hash is timed on 4- and 16-byte keys, loop cost subtracted,
+// and its spread is shown as the longest chain when 64 keys "led0".."led63" fill 67 buckets, as in a table of that
+// many entries. Only compiled in with -D HASH_BENCHMARK.
+
+namespace hash_benchmark {
+
+#if defined(HASH_BENCHMARK)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t ITERATIONS = 64;
+constexpr std::uint8_t KEYS = 64;
+constexpr std::uint8_t BUCKETS = 67;  // A prime of the hashtable policy
+
+using HashFn = std::size_t (*)(const void*, std::size_t, std::size_t);
+
+#if defined(HASH_BENCHMARK)
+// MurmurHashUnaligned2, as hash_bytes.cc computes it for a 32-bit size_t
+inline std::size_t murmur2_32(const void* ptr, std::size_t len, std::size_t seed) {
+    const std::uint32_t m = 0x5bd1e995UL;
+    std::uint32_t hash = static_cast<std::uint32_t>(seed) ^ len;
+    const std::uint8_t* buf = static_cast<const std::uint8_t*>(ptr);
+    for (; len >= 4; len -= 4, buf += 4) {
+        std::uint32_t k;
+        std::memcpy(&k, buf, sizeof(k));
+        k *= m;
+        k ^= k >> 24;
+        k *= m;
+        hash *= m;
+        hash ^= k;
+    }
+    switch (len) {
+    case 3:
+        hash ^= static_cast<std::uint32_t>(buf[2]) << 16;
+        [[gnu::fallthrough]];
+    case 2:
+        hash ^= static_cast<std::uint32_t>(buf[1]) << 8;
+        [[gnu::fallthrough]];
+    case 1:
+        hash ^= buf[0];
+        hash *= m;
+    }
+    hash ^= hash >> 13;
+    hash *= m;
+    hash ^= hash >> 15;
+    return static_cast<std::size_t>(hash);
+}
+
+// Cycles per call of `hash` on a key of `len` bytes
+inline std::uint32_t time_hash(HashFn hash, const char* key, std::size_t len, std::uint32_t overhead) {
+    volatile std::size_t sink = 0;
+    const std::uint32_t start = cycle_counter::now();
+    for (std::uint8_t i = 0; i < ITERATIONS; ++i) {
+        sink = hash(key, len, i);
+    }
+    (void)sink;
+    const std::uint32_t cycles = cycle_counter::now() - start;
+    return (cycles > overhead) ? (cycles - overhead) / ITERATIONS : 0;
+}
+
+inline std::uint32_t loop_overhead() {
+    volatile std::size_t sink = 0;
+    const std::uint32_t start = cycle_counter::now();
+    for (std::uint8_t i = 0; i < ITERATIONS; ++i) {
+        sink = i;
+    }
+    (void)sink;
+    return cycle_counter::now() - start;
+}
+
+// Entries in the fullest bucket
+inline std::uint8_t longest_chain(HashFn hash) {
+    std::uint8_t chains[BUCKETS] = {};
+    std::uint8_t longest = 0;
+    char key[6] = {'l', 'e', 'd'};
+    for (std::uint8_t i = 0; i < KEYS; ++i) {
+        std::size_t len = 3;
+        if (i >= 10) {
+            key[len++] = static_cast<char>('0' + i / 10);
+        }
+        key[len++] = static_cast<char>('0' + i % 10);
+        const std::uint8_t bucket = static_cast<std::uint8_t>(hash(key, len, 0xc70f6907UL) % BUCKETS);
+        if (++chains[bucket] > longest) {
+            longest = chains[bucket];
+        }
+    }
+    return longest;
+}
+
+inline void measure(const char* name, HashFn hash, std::uint32_t overhead, ramen::Pusher<const char*>& out) {
+    static const char KEY[] = "interval 1-3 250";
+    const std::uint32_t short_key = time_hash(hash, KEY, 4, overhead);
+    const std::uint32_t long_key = time_hash(hash, KEY, 16, overhead);
+    const unsigned chain = longest_chain(hash);
+    fmt::Line<64> msg;
+    fmt::write(msg, "  ", fmt::left(name, 11), fmt::right(static_cast<unsigned long>(short_key), 8),
+               fmt::right(static_cast<unsigned long>(long_key), 8), fmt::right(chain, 9));
+    out(msg.c_str());
+}
+#endif
+
+// Reports through `out` and, for constant text, `flash_out`
+inline void run(ramen::Pusher<const char*>& out, ramen::Pusher<const __FlashStringHelper*>& flash_out) {
+#if defined(HASH_BENCHMARK)
+    const std::uint32_t overhead = loop_overhead();
+    flash_out(F("Hash              4 B    16 B  Longest"));
+    flash_out(F("               cycles  cycles    chain"));
+    measure("crc_ccitt", &std::_Hash_bytes, overhead, out);
+    measure("fnv1a", &std::_Fnv_hash_bytes, overhead, out);
+    measure("murmur2_32", &murmur2_32, overhead, out);
+#if defined(AVR_STD_HASH_FNV)
+    flash_out(F("std::hash: fnv1a (AVR_STD_HASH_FNV)"));
+#else
+    flash_out(F("std::hash: crc_ccitt"));
+#endif
+#else
+    (void)out;
+    flash_out(F("Hash benchmark disabled (build with -D HASH_BENCHMARK)"));
+#endif
+}
+
+} // namespace hash_benchmark
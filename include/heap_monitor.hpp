@@ -0,0 +1,117 @@
+#pragma once
+#include "stack_monitor.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Heap usage and fragmentation, reported by the 'mem' command.
+//
+// The layout figures need no instrumentation and are always available on AVR: free_list_bytes() walks avr-libc's free
+// list, unclaimed() is the room malloc() may still take between the heap and the stack (stack_monitor::free_now()
+// less __malloc_margin), and largest_free_block() the larger of that and the largest listed block. With
+// -D HEAP_MONITOR the global operator new and delete (src/heap_monitor.cpp) also count the blocks they hand out, each
+// at the size malloc() keeps in its header, so the current and peak heap bytes include that header and any rounding.
+//
+// main() calls seal() at the end of setup(). An allocation after that is one in the steady state, like a std::deque
+// growing behind a state machine queue, and counted in late_allocations(); with -D HEAP_MONITOR_SEAL it fails an
+// assertion instead, so a test run stops at the first one.
+//
+// On non-AVR builds the layout figures are zero and operator new is left alone.
+
+#if defined(HEAP_MONITOR) && defined(POOL_OPERATOR_NEW)
+#error "HEAP_MONITOR counts malloc() blocks; with POOL_OPERATOR_NEW operator new does not use the heap"
+#endif
+
+namespace heap_monitor {
+
+#if defined(HEAP_MONITOR)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+#if defined(HEAP_MONITOR_SEAL)
+constexpr bool SEAL_ASSERTS = true;
+#else
+constexpr bool SEAL_ASSERTS = false;
+#endif
+
+namespace detail {
+inline std::size_t current_bytes = 0;
+inline std::size_t peak_bytes = 0;
+inline std::size_t live_blocks = 0;
+inline std::uint16_t allocations = 0;       // Saturates
+inline std::uint16_t late_allocations = 0;  // After seal(); saturates
+inline bool sealed = false;
+} // namespace detail
+
+inline std::size_t current_bytes() { return detail::current_bytes; }
+inline std::size_t peak_bytes() { return detail::peak_bytes; }
+inline std::size_t live_blocks() { return detail::live_blocks; }
+inline std::uint16_t allocations() { return detail::allocations; }
+inline std::uint16_t late_allocations() { return detail::late_allocations; }
+inline bool sealed() { return detail::sealed; }
+
+// From here on any allocation is a late one
+inline void seal() { detail::sealed = true; }
+
+#if defined(__AVR__)
+extern "C" {
+// avr-libc's malloc(): the free list and the room it leaves the stack (see its malloc.c)
+struct __freelist {
+    std::size_t sz;  // Usable bytes; the header itself is not included
+    __freelist* nx;
+};
+extern __freelist* __flp;
+extern std::size_t __malloc_margin;
+extern char* __malloc_heap_end;
+}
+
+// Bytes malloc() could still take from between the heap and the stack
+inline std::size_t unclaimed() {
+    const std::uint8_t* top = stack_monitor::heap_top();
+    const std::uint8_t* end = (__malloc_heap_end != nullptr) ? reinterpret_cast<std::uint8_t*>(__malloc_heap_end)
+                                                              : stack_monitor::stack_pointer() - __malloc_margin;
+    return (end > top) ? static_cast<std::size_t>(end - top) : 0;
+}
+
+// Freed blocks below the top of the heap, the fragmentation malloc() has not coalesced away
+inline std::size_t free_list_blocks() {
+    std::size_t n = 0;
+    for (const __freelist* f = __flp; f != nullptr; f = f->nx) {
+        ++n;
+    }
+    return n;
+}
+
+inline std::size_t free_list_bytes() {
+    std::size_t bytes = 0;
+    for (const __freelist* f = __flp; f != nullptr; f = f->nx) {
+        bytes += f->sz + sizeof(std::size_t);
+    }
+    return bytes;
+}
+
+// Largest request malloc() can serve right now
+inline std::size_t largest_free_block() {
+    const std::size_t room = unclaimed();
+    std::size_t largest = (room > sizeof(std::size_t)) ? room - sizeof(std::size_t) : 0;
+    for (const __freelist* f = __flp; f != nullptr; f = f->nx) {
+        if (f->sz > largest) {
+            largest = f->sz;
+        }
+    }
+    return largest;
+}
+
+// Bytes a block of malloc() occupies, from the size it keeps just below the block
+inline std::size_t block_size(void* block) {
+    return *(static_cast<std::size_t*>(block) - 1) + sizeof(std::size_t);
+}
+#else
+inline std::size_t unclaimed() { return 0; }
+inline std::size_t free_list_blocks() { return 0; }
+inline std::size_t free_list_bytes() { return 0; }
+inline std::size_t largest_free_block() { return 0; }
+#endif
+
+} // namespace heap_monitor
@@ -0,0 +1,146 @@
+#pragma once
+#include <Controllino.h>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Blinking without the CPU: pins wired to an output-compare pin of a 16-bit timer (OCnA/B/C) are toggled by the timer
+// itself, in CTC mode with toggle-on-compare. One TOP value is shared by the three channels of a timer, so every pin
+// on a timer blinks at the same interval; a pin whose timer already blinks at another interval is refused and the
+// caller keeps blinking it in software. Intervals run from 1 ms to 4194 ms (clk/1024, 64 us resolution).
+//
+// Timers used: Timer1 (pins 11..13), Timer3 (pins 2, 3, 5, i.e. CONTROLLINO_D0, D1, D3) unless STEPPER claims it,
+// and Timer4 (pins 6..8) unless TIMER_HW_COMPARE claims it. Timer5 stays with the cycle counter. A timer running a blink is taken from the
+// Arduino core, so analogWrite on its other pins stops working. Opt-in with -D LED_HW_BLINK; otherwise, and off AVR,
+// start() always refuses.
+
+namespace hw_blink {
+
+#if defined(__AVR__) && defined(LED_HW_BLINK)
+constexpr bool ENABLED = true;
+
+namespace detail {
+
+constexpr std::uint8_t NO_TIMER = 0xFF;
+constexpr std::uint8_t TIMER_COUNT = 3;  // Timer1, Timer3, Timer4
+
+struct Channel {
+    std::uint8_t timer;    // Index into the timers below, NO_TIMER if the pin has no usable compare output
+    std::uint8_t channel;  // 0 = A, 1 = B, 2 = C
+};
+
+inline Channel channel_of(std::uint8_t pin) {
+    switch (pin) {
+        case 11: return {0, 0};
+        case 12: return {0, 1};
+        case 13: return {0, 2};
+#if !defined(STEPPER)
+        case 5:  return {1, 0};
+        case 2:  return {1, 1};
+        case 3:  return {1, 2};
+#endif
+#if !defined(TIMER_HW_COMPARE)
+        case 6:  return {2, 0};
+        case 7:  return {2, 1};
+        case 8:  return {2, 2};
+#endif
+        default: return {NO_TIMER, 0};
+    }
+}
+
+struct TimerRegs {
+    volatile std::uint8_t* tccra;
+    volatile std::uint8_t* tccrb;
+    volatile std::uint16_t* tcnt;
+    volatile std::uint16_t* ocr[3];
+};
+
+inline TimerRegs regs(std::uint8_t timer) {
+    switch (timer) {
+        case 0: return {&TCCR1A, &TCCR1B, &TCNT1, {&OCR1A, &OCR1B, &OCR1C}};
+        case 1: return {&TCCR3A, &TCCR3B, &TCNT3, {&OCR3A, &OCR3B, &OCR3C}};
+        default: return {&TCCR4A, &TCCR4B, &TCNT4, {&OCR4A, &OCR4B, &OCR4C}};
+    }
+}
+
+// COMnx0 of channel c: toggle on compare match
+inline std::uint8_t toggle_bit(std::uint8_t channel) {
+    return static_cast<std::uint8_t>(1U << (6U - 2U * channel));
+}
+
+inline std::uint16_t interval_of[TIMER_COUNT] = {};  // 0 while the timer is not blinking
+inline std::uint8_t pins_of[TIMER_COUNT] = {};       // Channel bits (1 << channel) of the blinking pins
+
+} // namespace detail
+
+// Blinks `pin` with `interval_ms` between toggles, or retunes it if it already blinks alone on its timer.
+// False if the pin has no usable compare output, the interval is out of range or the timer blinks at another interval.
+inline bool start(std::uint8_t pin, std::uint32_t interval_ms) {
+    using namespace detail;
+    const Channel ch = channel_of(pin);
+    if (ch.timer == NO_TIMER || interval_ms == 0 || interval_ms > 4194U) {
+        return false;
+    }
+    const std::uint8_t bit = static_cast<std::uint8_t>(1U << ch.channel);
+    const bool alone = (pins_of[ch.timer] & static_cast<std::uint8_t>(~bit)) == 0;
+    if (!alone && interval_of[ch.timer] != interval_ms) {
+        return false;
+    }
+    const TimerRegs r = regs(ch.timer);
+    const std::uint16_t top = static_cast<std::uint16_t>((interval_ms * 15625U) / 1000U - 1U);  // 15625 Hz at clk/1024
+    const std::uint8_t sreg = SREG;
+    cli();
+    if (pins_of[ch.timer] == 0) {
+        *r.tccrb = 0;
+        *r.tccra = 0;
+        *r.tcnt = 0;
+    }
+    *r.ocr[0] = top;  // TOP in CTC mode
+    if (ch.channel != 0) {
+        *r.ocr[ch.channel] = 0;
+    }
+    if (*r.tcnt > top) {
+        *r.tcnt = 0;  // Retuned below the running count: restart the period instead of wrapping at 0xFFFF
+    }
+    *r.tccra |= toggle_bit(ch.channel);
+    *r.tccrb = _BV(WGM12) | _BV(CS12) | _BV(CS10);  // CTC with TOP = OCRnA, clk/1024 (WGMn2 and CSn2:0 share bit positions)
+    SREG = sreg;
+    pins_of[ch.timer] |= bit;
+    interval_of[ch.timer] = static_cast<std::uint16_t>(interval_ms);
+    return true;
+}
+
+inline bool running(std::uint8_t pin) {
+    const detail::Channel ch = detail::channel_of(pin);
+    return ch.timer != detail::NO_TIMER && (detail::pins_of[ch.timer] & (1U << ch.channel)) != 0;
+}
+
+// Hands the pin back to its PORT bit, driven low; stops the timer once no pin blinks on it
+inline void stop(std::uint8_t pin) {
+    using namespace detail;
+    if (!running(pin)) {
+        return;
+    }
+    const Channel ch = channel_of(pin);
+    const TimerRegs r = regs(ch.timer);
+    digitalWrite(pin, LOW);
+    const std::uint8_t sreg = SREG;
+    cli();
+    *r.tccra &= static_cast<std::uint8_t>(~(toggle_bit(ch.channel) | (toggle_bit(ch.channel) << 1U)));
+    pins_of[ch.timer] &= static_cast<std::uint8_t>(~(1U << ch.channel));
+    if (pins_of[ch.timer] == 0) {
+        *r.tccrb = 0;
+        interval_of[ch.timer] = 0;
+    }
+    SREG = sreg;
+}
+#else
+constexpr bool ENABLED = false;
+inline bool start(std::uint8_t, std::uint32_t) { return false; }
+inline bool running(std::uint8_t) { return false; }
+inline void stop(std::uint8_t) {}
+#endif
+
+} // namespace hw_blink
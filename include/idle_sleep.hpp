@@ -0,0 +1,63 @@
+#pragma once
+#include "modbus_rtu.hpp"
+#include "serial_port.hpp"
+#include <Controllino.h>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#endif
+
+// Idle hook for the end of loop(): puts the CPU into SLEEP_MODE_IDLE while no timer is due and no serial input is
+// waiting (text or a Modbus frame), instead of busy-polling.
+//
+// Idle mode stops only the CPU clock; timers, the UART and all interrupts keep running, so any interrupt wakes the
+// CPU. On the Arduino core the Timer0 overflow behind millis() fires about every millisecond, which bounds each
+// sleep to one millis() tick and keeps update() periods (and TimerActor::clock_out) unchanged; a UART RX interrupt
+// ends the sleep early. Deadlines are therefore never missed, the CPU just stops spinning between ticks. Sleeping
+// longer than one tick would need a dedicated compare interrupt and stopping Timer0, which would stall millis().
+// Pass every TimerActor to sleep(); a MicrosTimerActor keeps the CPU awake when a deadline is less than a tick away.
+// On non-AVR builds sleep() does nothing.
+
+namespace idle_sleep {
+
+#if defined(IDLE_SLEEP_DISABLE)
+constexpr bool ENABLED = false;
+#else
+constexpr bool ENABLED = true;
+#endif
+
+// True if a timer of `timer` is due within its clock's IDLE_SLEEP_GUARD
+template <class Timer>
+bool due_soon(const Timer& timer) {
+    using Clock = typename Timer::clock_type;
+    std::uint32_t deadline = 0;
+    return timer.next_deadline(deadline) &&
+           static_cast<std::int32_t>(deadline - Clock::now()) <= static_cast<std::int32_t>(Clock::IDLE_SLEEP_GUARD);
+}
+
+// Sleeps until the next interrupt unless a timer of any of `timers` is about to expire or input is pending
+template <class... Timers>
+void sleep(const Timers&... timers) {
+#if defined(__AVR__)
+    if (!ENABLED) {
+        return;
+    }
+    // Checks run with interrupts disabled; SEI takes effect after the following instruction, so an interrupt that
+    // arrives after the checks is taken only once the CPU is asleep and wakes it straight away
+    cli();
+    if ((due_soon(timers) || ...) || serial_port::available() > 0 || modbus_rtu::frame_ready()) {
+        sei();
+        return;
+    }
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+#else
+    ((void)timers, ...);
+#endif
+}
+
+} // namespace idle_sleep
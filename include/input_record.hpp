@@ -0,0 +1,247 @@
+#pragma once
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// Deterministic record and replay of the external inputs, so that a workload seen in the field can be run again,
+// byte for byte and millisecond for millisecond, on the bench or in the native build, and a performance change be
+// compared on identical input.
+//
+// With -D INPUT_RECORD the bytes the firmware reads from the programming port (serial_port::read()) and the raw levels
+// DigitalInputActor sees on its ports are appended to a compact binary log in RAM, each with the milliseconds since the
+// record before. The log starts at begin() and stops, counting what it could not keep, when INPUT_RECORD_SIZE bytes
+// are full. The 'record' command prints it for tools/input_record.py, which lists it or turns it into a header:
+//
+//     python3 tools/input_record.py capture.txt --header include/input_replay_log.h
+//
+// With -D INPUT_REPLAY that header is compiled in (INPUT_REPLAY_LOG names another), in flash on AVR, and replay()
+// plays it back in place of the inputs: each byte goes into the receive buffer of serial_port when its time comes,
+// which serial_port::read() then reads instead of the UART, and DigitalInputActor reads the recorded port levels
+// instead of the pins. The same header replays on the target and in the native environment:
+//
+//     void setup() { input_record::begin(); ... }                      // Before the input actors start
+//     void loop() { input_record::replay(&serial_port::inject); ... }  // First in every pass
+//
+// Input arrives in replay in the pass of the millisecond it was read in, so the firmware takes the same decisions in
+// the same order, as long as it reads its input every millisecond or so: a byte that waited in the UART for a slow
+// pass is read on time in replay. A replay that is recorded again gives the same log.
+//
+// A record is a tag, the kind in bits 7..6 and the milliseconds since the record before in bits 5..0, and its data:
+//   RX_BYTE      0b00dddddd <byte>
+//   PORT_LEVELS  0b01dddddd <port index 0..10, A..L> <mask of the pins read> <their levels>
+//   GAP          0b11000000 <ms, 16 bits little-endian>   gaps of over 63 ms, before the record they delay
+// Only the programming port is recorded; the other sessions, Modbus and Ethernet are not.
+
+#ifndef INPUT_RECORD_SIZE
+#define INPUT_RECORD_SIZE 512
+#endif
+#ifndef INPUT_REPLAY_LOG
+#define INPUT_REPLAY_LOG "input_replay_log.h"  // Defines INPUT_REPLAY_DATA[]
+#endif
+#if defined(INPUT_REPLAY)
+#include INPUT_REPLAY_LOG
+#endif
+
+namespace input_record {
+
+#if defined(INPUT_RECORD)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+#if defined(INPUT_REPLAY)
+constexpr bool REPLAY = true;
+#else
+constexpr bool REPLAY = false;
+#endif
+
+// The core defines SERIAL, hence the names
+enum Kind : std::uint8_t { RX_BYTE = 0x00, PORT_LEVELS = 0x40, GAP = 0xC0 };
+constexpr std::uint8_t KIND_MASK = 0xC0;
+constexpr std::uint8_t DELTA_MASK = 0x3F;
+constexpr std::uint8_t PORTS = 11;  // A..L without I, as in fast_pin.hpp
+
+namespace detail {
+#if defined(INPUT_RECORD)
+inline std::array<std::uint8_t, INPUT_RECORD_SIZE> log{};
+#endif
+inline std::uint16_t size = 0;
+inline std::uint16_t lost = 0;           // Records that did not fit, saturates at 65535
+inline std::uint32_t last_ms = 0;        // Time of the last record
+inline std::uint32_t start_ms = 0;
+inline std::array<std::uint8_t, PORTS> levels{};  // Last recorded levels of each port
+inline std::array<std::uint8_t, PORTS> known{};   // Pins whose level is in `levels`
+
+inline bool append(const std::uint8_t* bytes, std::uint8_t length) {
+#if defined(INPUT_RECORD)
+    if (size + length > INPUT_RECORD_SIZE) {
+        return false;
+    }
+    for (std::uint8_t i = 0; i < length; ++i) {
+        log[size++] = bytes[i];
+    }
+    return true;
+#else
+    (void)bytes;
+    (void)length;
+    return false;
+#endif
+}
+
+// A record of `kind` now, after GAP records for a gap too long for its tag; a record that does not fit all of it is
+// lost, and so are all after it, which keeps the log a prefix of the input
+inline void add(Kind kind, const std::uint8_t* data, std::uint8_t length) {
+    if (lost != 0) {
+        lost = static_cast<std::uint16_t>((lost == UINT16_MAX) ? lost : lost + 1U);
+        return;
+    }
+    const std::uint32_t now = millis();
+    std::uint32_t delta = now - last_ms;
+    while (delta > DELTA_MASK) {
+        const std::uint16_t step = static_cast<std::uint16_t>((delta > UINT16_MAX) ? UINT16_MAX : delta);
+        const std::uint8_t time[3] = {GAP, static_cast<std::uint8_t>(step), static_cast<std::uint8_t>(step >> 8)};
+        if (!append(time, sizeof(time))) {
+            lost = 1;
+            return;
+        }
+        last_ms += step;
+        delta -= step;
+    }
+    std::uint8_t record[4] = {static_cast<std::uint8_t>(kind | static_cast<std::uint8_t>(delta))};
+    for (std::uint8_t i = 0; i < length; ++i) {
+        record[i + 1U] = data[i];
+    }
+    if (!append(record, static_cast<std::uint8_t>(length + 1U))) {
+        lost = 1;
+        return;
+    }
+    last_ms = now;
+}
+} // namespace detail
+
+// A byte read from the programming port, from serial_port::read()
+inline void serial(std::uint8_t byte) {
+    if (ENABLED) {
+        detail::add(RX_BYTE, &byte, 1);
+    }
+}
+
+// The levels of the pins of `mask` on a port, as an input actor read them; recorded when they changed
+inline void port(std::uint8_t port, std::uint8_t mask, std::uint8_t levels) {
+    if (!ENABLED || port >= PORTS) {
+        return;
+    }
+    levels &= mask;
+    if (((levels ^ detail::levels[port]) & mask) == 0 && (mask & ~detail::known[port]) == 0) {
+        return;
+    }
+    detail::levels[port] = static_cast<std::uint8_t>((detail::levels[port] & ~mask) | levels);
+    detail::known[port] |= mask;
+    const std::uint8_t data[3] = {port, mask, levels};
+    detail::add(PORT_LEVELS, data, sizeof(data));
+}
+
+inline std::uint16_t size() { return detail::size; }
+inline std::uint16_t lost() { return detail::lost; }
+inline std::uint8_t at(std::uint16_t i) {
+#if defined(INPUT_RECORD)
+    return detail::log[i];
+#else
+    (void)i;
+    return 0;
+#endif
+}
+inline std::uint32_t duration_ms() { return detail::last_ms - detail::start_ms; }
+
+// Replay
+
+namespace detail {
+#if defined(INPUT_REPLAY)
+constexpr std::uint16_t REPLAY_SIZE = sizeof(INPUT_REPLAY_DATA);
+inline std::uint8_t replay_byte(std::uint16_t i) { return pgm_read_byte(&INPUT_REPLAY_DATA[i]); }
+#else
+constexpr std::uint16_t REPLAY_SIZE = 0;
+inline std::uint8_t replay_byte(std::uint16_t) { return 0; }
+#endif
+inline std::uint16_t replay_pos = 0;
+inline std::uint32_t replay_due = 0;  // Time of the next record, from start_ms
+inline std::array<std::uint8_t, PORTS> replay_levels{};
+
+inline std::uint8_t record_length(std::uint8_t tag) {
+    switch (tag & KIND_MASK) {
+        case RX_BYTE: return 2;
+        case PORT_LEVELS: return 4;
+        default: return 3;
+    }
+}
+
+// Takes the GAP records before the next record into replay_due
+inline void replay_skip_time() {
+    while (replay_pos + 3U <= REPLAY_SIZE && (replay_byte(replay_pos) & KIND_MASK) == GAP) {
+        replay_due += static_cast<std::uint16_t>(replay_byte(replay_pos + 1U) | (replay_byte(replay_pos + 2U) << 8));
+        replay_pos = static_cast<std::uint16_t>(replay_pos + 3U);
+    }
+}
+
+// The PORT_LEVELS record at replay_pos
+inline void play_levels() {
+    const std::uint8_t port = replay_byte(replay_pos + 1U);
+    const std::uint8_t mask = replay_byte(replay_pos + 2U);
+    if (port < PORTS) {
+        replay_levels[port] =
+            static_cast<std::uint8_t>((replay_levels[port] & ~mask) | (replay_byte(replay_pos + 3U) & mask));
+    }
+}
+} // namespace detail
+
+// Starts the log, and the replay, from now; the replay takes the port levels recorded at the start right away, so
+// that the input actors start from them
+inline void begin() {
+    detail::start_ms = millis();
+    detail::last_ms = detail::start_ms;
+    detail::replay_pos = 0;
+    detail::replay_due = 0;
+    detail::replay_skip_time();
+    while (detail::replay_pos + 4U <= detail::REPLAY_SIZE && detail::replay_byte(detail::replay_pos) == PORT_LEVELS) {
+        detail::play_levels();
+        detail::replay_pos = static_cast<std::uint16_t>(detail::replay_pos + 4U);
+    }
+}
+
+// Plays the records that are due: a byte goes to `inject`, which returns false to have it offered again on the next
+// call, e.g. while the receive buffer is full; the port levels are kept for DigitalInputActor. Does nothing without
+// INPUT_REPLAY.
+template <class Inject>
+void replay(Inject&& inject) {
+    if (!REPLAY) {
+        return;
+    }
+    const std::uint32_t now = millis() - detail::start_ms;
+    while (detail::replay_pos < detail::REPLAY_SIZE) {
+        const std::uint8_t tag = detail::replay_byte(detail::replay_pos);
+        const std::uint8_t length = detail::record_length(tag);
+        const std::uint32_t due = detail::replay_due + (tag & DELTA_MASK);
+        if (static_cast<std::int32_t>(now - due) < 0 || detail::replay_pos + length > detail::REPLAY_SIZE) {
+            return;
+        }
+        if ((tag & KIND_MASK) == RX_BYTE) {
+            if (!inject(detail::replay_byte(detail::replay_pos + 1U))) {
+                return;
+            }
+        } else if ((tag & KIND_MASK) == PORT_LEVELS) {
+            detail::play_levels();
+        }
+        detail::replay_due = due;
+        detail::replay_pos = static_cast<std::uint16_t>(detail::replay_pos + length);
+        detail::replay_skip_time();
+    }
+}
+
+// Replayed levels of a port, for DigitalInputActor in place of the pins
+inline std::uint8_t replayed_levels(std::uint8_t port) { return (port < PORTS) ? detail::replay_levels[port] : 0; }
+
+inline bool replay_done() { return detail::replay_pos >= detail::REPLAY_SIZE; }
+inline std::uint16_t replay_position() { return detail::replay_pos; }
+inline constexpr std::uint16_t replay_size() { return detail::REPLAY_SIZE; }
+
+} // namespace input_record
@@ -0,0 +1,295 @@
+#pragma once
+#include "actor_digital_input.hpp"
+#include "fast_pin.hpp"
+#include "process_image.hpp"
+#include "ramen.hpp"
+#include "ramen_mailbox.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Hard-wired style interlocks (e-stop chains, guard switches) evaluated in the input interrupt itself, so an output
+// drops within a few microseconds of its input whatever the main loop is doing.
+//
+// A rule ties an input level to a safe output level. The rules are given as a table in flash and compiled by start()
+// into per-port masks; the pin-change or external interrupt of an input port (through din::port_hook, see
+// actor_digital_input.hpp) then tests every rule of that port with one XOR and AND and writes the safe levels straight
+// to the output ports. While a rule is tripped its output is held in process_image::forced, so commits of the process
+// image cannot undo it. Latching rules stay tripped until reset() finds their input healthy again; the others release
+// by themselves, and the next commit restores the image's level. Trips and releases reach the network afterwards, as
+// TripEvents pushed by update():
+//
+//     const interlock::Rule RULES[] PROGMEM = {
+//         //  input            tripped at  output          safe level  latching
+//         {CONTROLLINO_IN0, LOW,        CONTROLLINO_R0, LOW,        true},  // e-stop chain opens
+//         {CONTROLLINO_IN0, LOW,        CONTROLLINO_R1, LOW,        true},
+//     };
+//     interlock::InterlockActor safety(RULES, 2);
+//     void setup() { safety.trip_out >> alarm.trip_in; safety.start(); }
+//     void loop()  { safety.update(); }
+//
+// Inputs need an interrupt (-D DIGITAL_INPUT_IRQ, and a pin with a pin-change or external interrupt); rules on other
+// inputs are evaluated by update() only. Outputs must be configured as outputs elsewhere, e.g. in the process image,
+// and should not be written by anything but the image. One interlock table per firmware.
+
+namespace interlock {
+
+constexpr std::uint8_t MAX_RULES = 16;
+
+struct Rule {
+    std::uint8_t input;
+    std::uint8_t trip_level;  // Input level that trips the rule, HIGH or LOW
+    std::uint8_t output;
+    std::uint8_t safe_level;  // Output level while tripped
+    bool latching;
+};
+
+struct TripEvent {
+    std::uint8_t rule;
+    bool tripped;           // false: released
+    std::uint32_t time_us;  // micros() right after the outputs were forced or released
+};
+
+namespace detail {
+
+// A compiled rule
+struct Term {
+    std::uint8_t in_mask;
+    std::uint8_t trip_bits;  // in_mask if the rule trips on a high input, 0 otherwise
+    std::uint8_t out_port;
+    std::uint8_t out_mask;
+    std::uint8_t output;
+    bool safe_high;
+    bool latching;
+};
+
+struct Table {
+    std::array<Term, MAX_RULES> terms{};
+    std::array<std::uint8_t, MAX_RULES> rule_of{};  // Table position of every term
+    std::array<std::uint8_t, gpio::detail::PORT_COUNT + 1U> first{};  // Terms of input port p: first[p]..first[p+1]-1
+    std::uint8_t count = 0;
+    std::uint16_t tripped = 0;  // Bit t for term t; interrupt side, or with interrupts disabled
+    process_image::PortBits out_ports{};  // Output bits of each port under interlock
+};
+
+inline Table table;
+inline ramen::SpscMailbox<TripEvent, 8> events;
+
+inline void write_outputs() {
+    process_image::Override& f = process_image::forced;
+    for (std::uint8_t port = 0; port < gpio::detail::PORT_COUNT; ++port) {
+        const std::uint8_t managed = table.out_ports[port];
+        if (managed == 0) {
+            continue;
+        }
+        const std::uint8_t was = static_cast<std::uint8_t>(f.clear[port] | f.set[port]);
+        std::uint8_t clear = 0;
+        std::uint8_t set = 0;
+        for (std::uint8_t t = 0; t < table.count; ++t) {
+            const Term& term = table.terms[t];
+            if (term.out_port == port && (table.tripped & (1U << t)) != 0) {
+                if (term.safe_high) {
+                    set |= term.out_mask;
+                } else {
+                    clear |= term.out_mask;
+                }
+            }
+        }
+        clear &= static_cast<std::uint8_t>(~set);  // Conflicting rules: high wins
+        f.clear[port] = clear;
+        f.set[port] = set;
+        f.resync[port] |= static_cast<std::uint8_t>(was & ~(clear | set));
+#if defined(__AVR__) && defined(PORTA)
+        volatile std::uint8_t* reg = gpio::detail::port_register(port, false);
+        *reg = static_cast<std::uint8_t>((*reg & ~clear) | set);
+#else
+        for (std::uint8_t t = 0; t < table.count; ++t) {
+            const Term& term = table.terms[t];
+            if (term.out_port == port && ((clear | set) & term.out_mask) != 0) {
+                digitalWrite(term.output, (set & term.out_mask) ? HIGH : LOW);
+            }
+        }
+#endif
+    }
+}
+
+// Tests the rules of an input port against its levels; releases latching rules only if `reset`
+inline void evaluate(std::uint8_t port, std::uint8_t levels, bool reset) {
+    std::uint16_t tripped = table.tripped;
+    for (std::uint8_t t = table.first[port]; t < table.first[port + 1U]; ++t) {
+        const Term& term = table.terms[t];
+        const std::uint16_t bit = static_cast<std::uint16_t>(1U << t);
+        if (((levels ^ term.trip_bits) & term.in_mask) == 0) {
+            tripped |= bit;
+        } else if (!term.latching || reset) {
+            tripped &= static_cast<std::uint16_t>(~bit);
+        }
+    }
+    const std::uint16_t changed = tripped ^ table.tripped;
+    if (changed == 0) {
+        return;
+    }
+    table.tripped = tripped;
+    write_outputs();
+    const std::uint32_t now = static_cast<std::uint32_t>(micros());
+    for (std::uint8_t t = table.first[port]; t < table.first[port + 1U]; ++t) {
+        if (changed & (1U << t)) {
+            events.push(TripEvent{table.rule_of[t], (tripped & (1U << t)) != 0, now});
+        }
+    }
+}
+
+// din::port_hook
+inline void on_port(std::uint8_t port, std::uint8_t levels) {
+    evaluate(port, levels, false);
+}
+
+} // namespace detail
+
+class InterlockActor {
+public:
+    ramen::Pusher<TripEvent> trip_out;
+    ramen::Pushable<TripEvent> event_in = [this](const TripEvent& evt) { trip_out(evt); };
+
+    // `rules` is a table of `count` rules in PROGMEM; rules beyond MAX_RULES and on pins outside the pin table of
+    // fast_pin.hpp are ignored
+    InterlockActor(const Rule* rules, std::uint8_t count) : rules_(rules), count_(count) {
+        detail::events.out >> event_in;
+    }
+
+    // Compiles the rules, applies them to the current input levels and hooks them to the input interrupts
+    void start() {
+        detail::Table& table = detail::table;
+        table = detail::Table{};
+        std::array<std::uint8_t, MAX_RULES> in_port{};
+        for (std::uint8_t r = 0; r < count_ && table.count < MAX_RULES; ++r) {
+            const std::uint8_t input = pgm_read_byte(&rules_[r].input);
+            const std::uint8_t output = pgm_read_byte(&rules_[r].output);
+            const gpio::detail::Port ip = gpio::detail::pin_port(input);
+            const gpio::detail::Port op = gpio::detail::pin_port(output);
+            if (ip == gpio::detail::Port::NONE || op == gpio::detail::Port::NONE) {
+                continue;
+            }
+            detail::Term term;
+            term.in_mask = static_cast<std::uint8_t>(1U << gpio::detail::pin_bit(input));
+            term.trip_bits = pgm_read_byte(&rules_[r].trip_level) ? term.in_mask : 0U;
+            term.out_port = static_cast<std::uint8_t>(static_cast<std::uint8_t>(op) - 1U);
+            term.out_mask = static_cast<std::uint8_t>(1U << gpio::detail::pin_bit(output));
+            term.output = output;
+            term.safe_high = pgm_read_byte(&rules_[r].safe_level) != 0;
+            term.latching = pgm_read_byte(&rules_[r].latching) != 0;
+            // Insertion by input port keeps the terms of a port contiguous for the interrupt
+            const std::uint8_t port = static_cast<std::uint8_t>(static_cast<std::uint8_t>(ip) - 1U);
+            std::uint8_t pos = table.count;
+            while (pos > 0 && in_port[pos - 1U] > port) {
+                table.terms[pos] = table.terms[pos - 1U];
+                table.rule_of[pos] = table.rule_of[pos - 1U];
+                in_port[pos] = in_port[pos - 1U];
+                --pos;
+            }
+            table.terms[pos] = term;
+            table.rule_of[pos] = r;
+            in_port[pos] = port;
+            ++table.count;
+            table.out_ports[term.out_port] |= term.out_mask;
+            polled_[port] |= term.in_mask;
+        }
+        for (std::uint8_t port = 0, t = 0; port <= gpio::detail::PORT_COUNT; ++port) {
+            while (t < table.count && in_port[t] < port) {
+                ++t;
+            }
+            table.first[port] = t;
+        }
+        poll(true);  // Inputs that are tripped already at start-up trip their rules at once
+
+        din::port_hook = &detail::on_port;
+        for (std::uint8_t r = 0; r < count_; ++r) {
+            const std::uint8_t input = pgm_read_byte(&rules_[r].input);
+            const gpio::detail::Port ip = gpio::detail::pin_port(input);
+            if (ip != gpio::detail::Port::NONE && din::enable_interrupt(input)) {
+                const std::uint8_t port = static_cast<std::uint8_t>(static_cast<std::uint8_t>(ip) - 1U);
+                polled_[port] &= static_cast<std::uint8_t>(~(1U << gpio::detail::pin_bit(input)));
+            }
+        }
+    }
+
+    // From loop(): reports trips and releases, and evaluates the rules whose input has no interrupt
+    void update() {
+        detail::events.drain();
+        if (has_polled()) {
+            poll(false);
+        }
+    }
+
+    // Releases the latching rules whose inputs are healthy again
+    void reset() {
+        poll(true, true);
+        detail::events.drain();
+    }
+
+    bool tripped(std::uint8_t rule) const {
+        bool result = false;
+        for (std::uint8_t t = 0; t < detail::table.count; ++t) {
+            result = result || (detail::table.rule_of[t] == rule && (detail::table.tripped & (1U << t)) != 0);
+        }
+        return result;
+    }
+
+    bool any_tripped() const { return detail::table.tripped != 0; }
+
+private:
+    const Rule* rules_;
+    const std::uint8_t count_;
+    process_image::PortBits polled_{};  // Rule inputs without an interrupt
+
+    bool has_polled() const {
+        for (std::uint8_t bits : polled_) {
+            if (bits != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Evaluates the rules of the polled input ports, or of all of them if `all`, as the interrupt would
+    void poll(bool all, bool reset = false) {
+        for (std::uint8_t port = 0; port < gpio::detail::PORT_COUNT; ++port) {
+            if (detail::table.first[port] == detail::table.first[port + 1U] || (!all && polled_[port] == 0)) {
+                continue;
+            }
+#if defined(__AVR__)
+            const std::uint8_t sreg = SREG;
+            cli();
+#endif
+            detail::evaluate(port, read_port(port), reset);
+#if defined(__AVR__)
+            SREG = sreg;
+#endif
+        }
+    }
+
+#if defined(__AVR__) && defined(PORTA)
+    static std::uint8_t read_port(std::uint8_t port) {
+        return *gpio::detail::port_register(port, true);
+    }
+#else
+    std::uint8_t read_port(std::uint8_t port) const {
+        std::uint8_t levels = 0;
+        for (std::uint8_t r = 0; r < count_; ++r) {
+            const std::uint8_t input = pgm_read_byte(&rules_[r].input);
+            if (gpio::detail::pin_port(input) != gpio::detail::Port::NONE &&
+                static_cast<std::uint8_t>(static_cast<std::uint8_t>(gpio::detail::pin_port(input)) - 1U) == port &&
+                digitalRead(input)) {
+                levels |= static_cast<std::uint8_t>(1U << gpio::detail::pin_bit(input));
+            }
+        }
+        return levels;
+    }
+#endif
+};
+
+} // namespace interlock
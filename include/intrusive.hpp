@@ -0,0 +1,347 @@
+#pragma once
+
+#include "flat_map.hpp"
+#include <bits/stl_tree.h>
+#include <cstddef>
+
+namespace ramen
+{
+
+/// Intrusive containers: the links live in the elements, as they do in ramen's port lists, so putting an object in a
+/// list or a tree allocates nothing and reaching it from the container takes no extra pointer. An element derives
+/// from the hook of each container it can be in, and the Tag tells the hooks apart:
+///
+///   struct Deadline : ramen::ListHook<>, ramen::TreeHook<>
+///   {
+///       std::uint32_t due;
+///       bool operator<(const Deadline& other) const { return due < other.due; }
+///   };
+///
+///   ramen::IntrusiveTree<Deadline> pending;   // ordered by due
+///   ramen::IntrusiveList<Deadline> expired;
+///   pending.insert(d);
+///   while (!pending.empty() && pending.front().due <= now) { expired.push_back(pending.pop_front()); }
+///
+/// An object is in at most one container per hook and must outlive its membership; the containers never own their
+/// elements. A ListHook unlinks itself when destroyed, a TreeHook must be erased first (the tree has to rebalance).
+/// Copying an element does not copy its memberships: the copy starts unlinked.
+///
+/// IntrusiveTree is a red-black tree balanced by the same out-of-line functions as std::map (tree.cc of
+/// avr-libstdcpp), so it shares their code with any std::map or std::set in the firmware.
+
+/// Links of an element of IntrusiveList<T, Tag>.
+template <typename Tag = void>
+class ListHook
+{
+    template <typename T, typename ListTag>
+    friend class IntrusiveList;
+
+public:
+    constexpr ListHook() noexcept = default;
+    constexpr ListHook(const ListHook&) noexcept {}
+    ListHook& operator=(const ListHook&) noexcept { return *this; }
+    ~ListHook() noexcept { unlink(); }
+
+    constexpr bool linked() const noexcept { return next_ != nullptr; }
+
+    /// Removes the element from its list, if it is in one.
+    void unlink() noexcept
+    {
+        if (!linked()) { return; }
+        prev_->next_ = next_;
+        next_->prev_ = prev_;
+        next_        = nullptr;
+        prev_        = nullptr;
+    }
+
+private:
+    /// Links this unlinked hook in front of `pos`.
+    void link_before(ListHook& pos) noexcept
+    {
+        next_            = &pos;
+        prev_            = pos.prev_;
+        pos.prev_->next_ = this;
+        pos.prev_        = this;
+    }
+
+    ListHook* next_ = nullptr;
+    ListHook* prev_ = nullptr;
+};
+
+/// Doubly linked list of elements deriving from ListHook<Tag>: O(1) insertion and removal anywhere. The list is
+/// circular through a hook of its own, so it must not be moved while it has elements.
+template <typename T, typename Tag = void>
+class IntrusiveList
+{
+    using Hook = ListHook<Tag>;
+
+public:
+    template <typename Value, typename HookPtr>
+    class Iterator
+    {
+    public:
+        constexpr explicit Iterator(HookPtr hook) noexcept : hook_(hook) {}
+
+        Value& operator*() const noexcept { return static_cast<Value&>(*hook_); }
+        Value* operator->() const noexcept { return &**this; }
+        Iterator& operator++() noexcept { hook_ = hook_->next_; return *this; }
+        Iterator& operator--() noexcept { hook_ = hook_->prev_; return *this; }
+        bool operator==(const Iterator& other) const noexcept { return hook_ == other.hook_; }
+        bool operator!=(const Iterator& other) const noexcept { return hook_ != other.hook_; }
+
+    private:
+        friend class IntrusiveList;
+        HookPtr hook_;
+    };
+
+    using value_type     = T;
+    using iterator       = Iterator<T, Hook*>;
+    using const_iterator = Iterator<const T, const Hook*>;
+
+    IntrusiveList() noexcept { clear_links(); }
+    IntrusiveList(const IntrusiveList&)            = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+    ~IntrusiveList() noexcept { clear(); }
+
+    bool empty() const noexcept { return head_.next_ == &head_; }
+
+    /// Elements in the list; O(n), as elements can leave it on their own.
+    std::size_t size() const noexcept
+    {
+        std::size_t n = 0;
+        for (const Hook* h = head_.next_; h != &head_; h = h->next_) { ++n; }
+        return n;
+    }
+
+    iterator       begin() noexcept { return iterator(head_.next_); }
+    const_iterator begin() const noexcept { return const_iterator(head_.next_); }
+    iterator       end() noexcept { return iterator(&head_); }
+    const_iterator end() const noexcept { return const_iterator(&head_); }
+
+    T&       front() noexcept { return *begin(); }
+    const T& front() const noexcept { return *begin(); }
+    T&       back() noexcept { return static_cast<T&>(*head_.prev_); }
+    const T& back() const noexcept { return static_cast<const T&>(*head_.prev_); }
+
+    /// Inserts `item` before `pos`, after taking it out of any list it is in.
+    iterator insert(const iterator pos, T& item) noexcept
+    {
+        Hook& hook = item;
+        hook.unlink();
+        hook.link_before(*pos.hook_);
+        return iterator(&hook);
+    }
+
+    void push_front(T& item) noexcept { insert(begin(), item); }
+    void push_back(T& item) noexcept { insert(end(), item); }
+
+    /// Inserts `item` after the elements that do not order after it, keeping a sorted list sorted and equal
+    /// elements in FIFO order; O(n).
+    template <typename Compare = Less>
+    iterator insert_sorted(T& item, Compare compare = Compare{}) noexcept
+    {
+        static_cast<Hook&>(item).unlink();
+        iterator pos = begin();
+        while (pos != end() && !compare(item, *pos)) { ++pos; }
+        return insert(pos, item);
+    }
+
+    /// Removes `item`, which must be in this list; returns the position after it.
+    iterator erase(T& item) noexcept
+    {
+        Hook& hook = item;
+        iterator next(hook.next_);
+        hook.unlink();
+        return next;
+    }
+
+    /// Removes and returns the first element; the list must not be empty.
+    T& pop_front() noexcept
+    {
+        T& item = front();
+        erase(item);
+        return item;
+    }
+
+    T& pop_back() noexcept
+    {
+        T& item = back();
+        erase(item);
+        return item;
+    }
+
+    /// Unlinks every element.
+    void clear() noexcept
+    {
+        while (!empty()) { head_.next_->unlink(); }
+    }
+
+private:
+    void clear_links() noexcept
+    {
+        head_.next_ = &head_;
+        head_.prev_ = &head_;
+    }
+
+    Hook head_;
+};
+
+/// Links of an element of IntrusiveTree<T, Compare, Tag>: a std::map node without the value.
+template <typename Tag = void>
+class TreeHook : private std::_Rb_tree_node_base
+{
+    template <typename T, typename Compare, typename TreeTag>
+    friend class IntrusiveTree;
+
+public:
+    TreeHook() noexcept { _M_parent = nullptr; }
+    TreeHook(const TreeHook&) noexcept : TreeHook() {}
+    TreeHook& operator=(const TreeHook&) noexcept { return *this; }
+
+    bool linked() const noexcept { return _M_parent != nullptr; }
+};
+
+/// Red-black tree of elements deriving from TreeHook<Tag>, ordered by Compare and allowing equal elements (like
+/// std::multiset, an element goes after those equal to it): O(log n) insertion, removal and search, O(1) access to the
+/// first element. Compare must be a strict weak ordering of T and default-constructible. Like IntrusiveList, the
+/// tree must not be moved while it has elements.
+template <typename T, typename Compare = Less, typename Tag = void>
+class IntrusiveTree
+{
+    using Hook = TreeHook<Tag>;
+    using Node = std::_Rb_tree_node_base;
+
+    static T&       value(Node* node) noexcept { return static_cast<T&>(static_cast<Hook&>(*node)); }
+    static const T& value(const Node* node) noexcept { return static_cast<const T&>(static_cast<const Hook&>(*node)); }
+    static Node*    node(T& item) noexcept { return static_cast<Node*>(&static_cast<Hook&>(item)); }
+
+public:
+    template <typename Value, typename NodePtr>
+    class Iterator
+    {
+    public:
+        constexpr explicit Iterator(NodePtr node) noexcept : node_(node) {}
+
+        Value& operator*() const noexcept { return IntrusiveTree::value(node_); }
+        Value* operator->() const noexcept { return &**this; }
+        Iterator& operator++() noexcept { node_ = std::_Rb_tree_increment(node_); return *this; }
+        Iterator& operator--() noexcept { node_ = std::_Rb_tree_decrement(node_); return *this; }
+        bool operator==(const Iterator& other) const noexcept { return node_ == other.node_; }
+        bool operator!=(const Iterator& other) const noexcept { return node_ != other.node_; }
+
+    private:
+        NodePtr node_;
+    };
+
+    using value_type     = T;
+    using iterator       = Iterator<T, Node*>;
+    using const_iterator = Iterator<const T, const Node*>;
+
+    IntrusiveTree() noexcept = default;
+    IntrusiveTree(const IntrusiveTree&)            = delete;
+    IntrusiveTree& operator=(const IntrusiveTree&) = delete;
+    ~IntrusiveTree() noexcept { clear(); }
+
+    bool        empty() const noexcept { return header_._M_node_count == 0; }
+    std::size_t size() const noexcept { return header_._M_node_count; }
+
+    iterator       begin() noexcept { return iterator(header_._M_header._M_left); }
+    const_iterator begin() const noexcept { return const_iterator(header_._M_header._M_left); }
+    iterator       end() noexcept { return iterator(&header_._M_header); }
+    const_iterator end() const noexcept { return const_iterator(&header_._M_header); }
+
+    /// The smallest element; the tree must not be empty.
+    T&       front() noexcept { return *begin(); }
+    const T& front() const noexcept { return *begin(); }
+
+    /// Inserts `item`, which must not be in a tree through this hook.
+    iterator insert(T& item) noexcept
+    {
+        Node* parent = &header_._M_header;
+        Node* x      = header_._M_header._M_parent;
+        bool  left   = true;
+        while (x != nullptr)
+        {
+            parent = x;
+            left   = compare_(item, value(x));
+            x      = left ? x->_M_left : x->_M_right;
+        }
+        Node* const z = node(item);
+        std::_Rb_tree_insert_and_rebalance(left, z, parent, header_._M_header);
+        ++header_._M_node_count;
+        return iterator(z);
+    }
+
+    /// Removes `item`, which must be in this tree; returns the position after it.
+    iterator erase(T& item) noexcept
+    {
+        Node* const z = node(item);
+        iterator    next(std::_Rb_tree_increment(z));
+        std::_Rb_tree_rebalance_for_erase(z, header_._M_header);
+        z->_M_parent = nullptr;
+        --header_._M_node_count;
+        return next;
+    }
+
+    /// Removes and returns the smallest element; the tree must not be empty.
+    T& pop_front() noexcept
+    {
+        T& item = front();
+        erase(item);
+        return item;
+    }
+
+    /// The first element not ordered before `key`, or end(). Key is T or any type Compare orders against T.
+    template <typename Key>
+    iterator lower_bound(const Key& key) noexcept
+    {
+        Node* result = &header_._M_header;
+        for (Node* x = header_._M_header._M_parent; x != nullptr;)
+        {
+            if (!compare_(value(x), key))
+            {
+                result = x;
+                x      = x->_M_left;
+            }
+            else
+            {
+                x = x->_M_right;
+            }
+        }
+        return iterator(result);
+    }
+
+    /// An element equal to `key`, or end().
+    template <typename Key>
+    iterator find(const Key& key) noexcept
+    {
+        const iterator pos = lower_bound(key);
+        return (pos == end() || compare_(key, *pos)) ? end() : pos;
+    }
+
+    /// Unlinks every element, leaves first; O(n).
+    void clear() noexcept
+    {
+        Node* const head = &header_._M_header;
+        for (Node* x = head->_M_parent; x != nullptr;)
+        {
+            if (x->_M_left != nullptr) { x = x->_M_left; }
+            else if (x->_M_right != nullptr) { x = x->_M_right; }
+            else
+            {
+                Node* const parent = x->_M_parent;
+                x->_M_parent       = nullptr;
+                if (parent == head) { break; }
+                (parent->_M_left == x ? parent->_M_left : parent->_M_right) = nullptr;
+                x = parent;
+            }
+        }
+        header_._M_reset();
+    }
+
+private:
+    std::_Rb_tree_header header_;
+    Compare              compare_{};
+};
+
+} // namespace ramen
@@ -0,0 +1,476 @@
+#pragma once
+#include "binary_frame.hpp"
+#include "eeprom_access.hpp"
+#include "function_blocks.hpp"
+#include "process_image.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// A virtual machine for PLC logic: a compact bytecode, compiled from ladder or function block diagrams on the host,
+// runs against a process image each scan, so that the logic changes without rebuilding and reflashing the firmware.
+//
+// The machine has no stack. An instruction is 4 bytes, an opcode and three operands, each a register index, a pin or
+// half of a constant: 64 bit registers, held one per byte as 0 or 1, and 16 word registers of 16 bits. Timers and
+// edge detectors keep their state in the registers they name or in 16 timers of their own. Jumps only go forward, so
+// a scan runs each instruction at most once and ends at the END it must reach. The instructions are dispatched by
+// threaded code, GCC's labels as values: each handler ends in an indirect jump through a table in flash to the next
+// one, without a loop or a switch around them, a dozen cycles an instruction on the AVR (see the micro-benchmark).
+//
+//     process_image::ProcessImage image;
+//     logic_vm::LogicVmActor<> logic(image);
+//     constexpr logic_vm::Instruction DEFAULT[] PROGMEM = {       // D0 on 500 ms after IN0 rises, while IN1 is off
+//         {logic_vm::LDK, 0, 0xF4, 0x01},                          // Word 0, the preset of timer 0: 500
+//         {logic_vm::LD, 0, CONTROLLINO_IN0, 0},
+//         {logic_vm::LD, 1, CONTROLLINO_IN1, 0},
+//         {logic_vm::ANDN, 2, 0, 1},
+//         {logic_vm::TON, 3, 2, 0},
+//         {logic_vm::ST, 3, CONTROLLINO_D0, 0},
+//         {logic_vm::END, 0, 0, 0}};
+//
+//     void setup() { image.add_input(CONTROLLINO_IN0); ...; logic.begin(DEFAULT); }  // The one in EEPROM, if any
+//     void loop()  { image.read_inputs(); logic.scan(); image.commit_outputs(); logic.update(); ... }
+//
+// Every program is verified before it runs: known opcodes, registers, timers and jump targets in range, LD on the
+// image's inputs and ST on its outputs only, and an END last. A program that fails is rejected and the one before
+// keeps running. Loading a program clears the registers.
+//
+// A program is downloaded over the binary protocol (see BinaryEndpointActor) as an image in EEPROM, before the boot
+// script's region:
+//
+//     magic 'L' version:1 count:u16 {op a b c}*count crc:u16
+//
+// PROGRAM_WRITE requests store it in chunks, which update() writes a byte per pass, and PROGRAM_COMMIT verifies it
+// and runs it in place of the current one; begin() runs it at boot. tools/logic_vm.py assembles a listing into an
+// image and downloads it. The VM is opt-in with -D LOGIC_VM, which also sizes the protocol's frames for the chunks.
+
+#ifndef LOGIC_VM_MAX_INSTRUCTIONS
+#define LOGIC_VM_MAX_INSTRUCTIONS 128  // Of the program in RAM, 4 bytes each
+#endif
+
+namespace logic_vm {
+
+#if defined(LOGIC_VM)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Operands a, b, c; "jump" targets are instruction indexes b | c << 8
+enum Op : std::uint8_t {
+    END,   //                          ends the scan
+    LD,    // bit a, pin b             a = input b of the image
+    ST,    // bit a, pin b             output b of the image = a
+    MOV,   // bits a, b                a = b
+    NOT,   // bits a, b                a = !b
+    AND,   // bits a, b, c             a = b & c
+    OR,    // bits a, b, c             a = b | c
+    XOR,   // bits a, b, c             a = b ^ c
+    ANDN,  // bits a, b, c             a = b & !c
+    SET,   // bits a, b                a = 1 if b
+    RST,   // bits a, b                a = 0 if b
+    RISE,  // bits a, b, c             a = b rose since the last scan, with c the level of b then (R_TRIG)
+    FALL,  // bits a, b, c             a = b fell, likewise (F_TRIG)
+    LDK,   // word a, constant b c     a = b | c << 8
+    MOVW,  // words a, b               a = b
+    ADD,   // words a, b, c            a = b + c, wrapping
+    SUB,   // words a, b, c            a = b - c, wrapping
+    CTU,   // word a, bits b, c        a + 1 if b, saturating; 0 if c (CTU, b from RISE)
+    GT,    // bit a, words b, c        a = b > c
+    GE,    // bit a, words b, c        a = b >= c
+    EQ,    // bit a, words b, c        a = b == c
+    TON,   // bits a, b, timer c       a = b has been on for word c ms (TON, word c the preset)
+    TOF,   // bits a, b, timer c       a = b, held for word c ms after b falls (TOF)
+    JMP,   // target                   jump
+    JMPC,  // bit a, target            jump if a
+    JMPN,  // bit a, target            jump unless a
+    OP_COUNT
+};
+
+struct Instruction {
+    std::uint8_t op;
+    std::uint8_t a;
+    std::uint8_t b;
+    std::uint8_t c;
+};
+static_assert(sizeof(Instruction) == 4, "An instruction is 4 bytes");
+
+constexpr std::uint8_t BITS = 64;
+constexpr std::uint8_t WORDS = 16;
+constexpr std::uint8_t TIMERS = 16;  // Timer t counts up to word register t
+
+// The program image in EEPROM
+constexpr std::uint8_t MAGIC = 'L';
+constexpr std::uint8_t VERSION = 1;
+constexpr std::uint16_t REGION = eeprom_access::LOGIC_PROGRAM_REGION;
+constexpr std::uint16_t REGION_SIZE = eeprom_access::BOOT_SCRIPT_REGION - REGION;
+constexpr std::uint16_t IMAGE_HEADER_SIZE = 4;
+constexpr std::uint16_t MAX_IMAGE_INSTRUCTIONS =
+    (REGION_SIZE - IMAGE_HEADER_SIZE - binary_frame::CRC_SIZE) / sizeof(Instruction);
+constexpr std::uint8_t CHUNK_SIZE = 32;  // Of a PROGRAM_WRITE
+
+// A request of the binary protocol to the store of the program; the store sets the status
+struct ProgramEvent {
+    enum Action : std::uint8_t { WRITE, COMMIT };
+    enum Status : std::uint8_t { OK, BUSY, BAD_OFFSET, BAD_PROGRAM, UNHANDLED };
+    Action action;
+    std::uint16_t offset;       // WRITE: of the data in the image
+    const std::uint8_t* data;   // WRITE: CHUNK_SIZE bytes at most
+    std::uint8_t length;
+    Status* status;             // Of the endpoint, UNHANDLED until a store sets it
+};
+
+enum class Source : std::uint8_t { NONE, FLASH, EEPROM };
+
+template <std::uint16_t MaxInstructions = LOGIC_VM_MAX_INSTRUCTIONS>
+class LogicVmActor {
+    static_assert(MaxInstructions > 0 && MaxInstructions <= MAX_IMAGE_INSTRUCTIONS,
+                  "LOGIC_VM_MAX_INSTRUCTIONS must be in [1, 254], what the EEPROM region holds");
+    static_assert(TIMERS <= 16 && TIMERS <= WORDS, "The timers' flags are 16-bit masks, their presets words");
+
+public:
+    explicit LogicVmActor(process_image::ProcessImage& process_image) : image(process_image) {}
+    LogicVmActor(const LogicVmActor&) = delete;
+    LogicVmActor& operator=(const LogicVmActor&) = delete;
+
+    // Runs the program in EEPROM, or `code_P` if there is none that passes verification; false if neither did. The
+    // image's pins must be registered first.
+    template <std::uint16_t N>
+    bool begin(const Instruction (&code_P)[N]) {
+        return load_eeprom() || load_P(code_P, N);
+    }
+    bool begin() { return load_eeprom(); }
+
+    // Runs `count` instructions from a table in PROGMEM, if they pass verification
+    bool load_P(const Instruction* code_P, std::uint16_t count) {
+        return load([code_P](std::uint16_t i) {
+            Instruction in;
+            memcpy_P(&in, &code_P[i], sizeof(in));
+            return in;
+        }, count, Source::FLASH);
+    }
+
+    // Runs the program image in EEPROM, if its CRC holds and it passes verification
+    bool load_eeprom() {
+        std::uint8_t header[IMAGE_HEADER_SIZE];
+        eeprom_access::read_block(header, REGION, sizeof(header));
+        const std::uint16_t count = binary_frame::read_le16(header + 2);
+        if (header[0] != MAGIC || header[1] != VERSION || count == 0 || count > MaxInstructions) {
+            return false;
+        }
+        std::uint16_t crc = binary_frame::crc16(header, sizeof(header));
+        for (std::uint16_t i = 0; i < count; ++i) {
+            const Instruction in = eeprom_instruction(i);
+            const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(&in);
+            for (std::uint8_t k = 0; k < sizeof(in); ++k) {
+                crc = binary_frame::crc16_update(crc, bytes[k]);
+            }
+        }
+        std::uint8_t stored[binary_frame::CRC_SIZE];
+        eeprom_access::read_block(stored, code_address(count), sizeof(stored));
+        if (binary_frame::read_le16(stored) != crc) {
+            ++rejected_;
+            return false;
+        }
+        return load([](std::uint16_t i) { return eeprom_instruction(i); }, count, Source::EEPROM);
+    }
+
+    // One scan of the program, between image.read_inputs() and image.commit_outputs()
+    void scan() {
+        if (count_ == 0) {
+            return;
+        }
+        const std::uint16_t delta = clock_.delta();
+        const std::uint32_t start = static_cast<std::uint32_t>(micros());
+        run(delta);
+        const std::uint32_t elapsed = static_cast<std::uint32_t>(micros()) - start;
+        ++scans_;
+        last_us_ = elapsed;
+        max_us_ = (elapsed > max_us_) ? elapsed : max_us_;
+    }
+
+    // Writes a downloaded chunk to EEPROM, as far as it is ready for the next byte (see eeprom_access.hpp)
+    void update() {
+        while (written_ < pending_ && eeprom_access::ready()) {
+            const bool started = eeprom_access::update_byte(chunk_address_ + written_, chunk_[written_]);
+            if (++written_ == pending_) {
+                pending_ = 0;
+                written_ = 0;
+            }
+            if (started) {
+                return;
+            }
+        }
+    }
+
+    // Input: PROGRAM_WRITE and PROGRAM_COMMIT requests of the binary protocol
+    ramen::Pushable<const ProgramEvent&> program_in = [this](const ProgramEvent& evt) { *evt.status = request(evt); };
+
+    bool bit(std::uint8_t i) const { return i < BITS && bits_[i] != 0; }
+    std::int16_t word(std::uint8_t i) const { return (i < WORDS) ? words_[i] : 0; }
+    Source source() const { return source_; }
+    std::uint16_t size() const { return count_; }
+    std::uint32_t scans() const { return scans_; }
+    std::uint32_t last_scan_us() const { return last_us_; }
+    std::uint32_t max_scan_us() const { return max_us_; }
+    std::uint16_t rejected() const { return rejected_; }  // Programs that failed their CRC or verification
+
+private:
+    process_image::ProcessImage& image;
+    std::array<Instruction, MaxInstructions> code_{};
+    std::uint16_t count_ = 0;
+    Source source_ = Source::NONE;
+    std::array<std::uint8_t, BITS> bits_{};
+    std::array<std::int16_t, WORDS> words_{};
+    std::array<std::uint16_t, TIMERS> elapsed_{};
+    std::uint16_t timing_ = 0;  // Timers counting
+    std::uint16_t held_ = 0;    // TOF timers whose output is held on
+    fb::ScanClock<1> clock_;
+    std::uint32_t scans_ = 0;
+    std::uint32_t last_us_ = 0;
+    std::uint32_t max_us_ = 0;
+    std::uint16_t rejected_ = 0;
+    std::uint8_t chunk_[CHUNK_SIZE];
+    std::uint16_t chunk_address_ = 0;
+    std::uint8_t pending_ = 0;  // Bytes of the chunk to write
+    std::uint8_t written_ = 0;
+
+    static std::uint16_t code_address(std::uint16_t i) {
+        return static_cast<std::uint16_t>(REGION + IMAGE_HEADER_SIZE + i * sizeof(Instruction));
+    }
+
+    static Instruction eeprom_instruction(std::uint16_t i) {
+        Instruction in;
+        eeprom_access::read_block(&in, code_address(i), sizeof(in));
+        return in;
+    }
+
+    static std::uint16_t target(const Instruction& in) {
+        return static_cast<std::uint16_t>(in.b | (in.c << 8));
+    }
+
+    bool valid(const Instruction& in, std::uint16_t i, std::uint16_t count) const {
+        switch (in.op) {
+            case END: return true;
+            case LD: return in.a < BITS && image.is_input(in.b);
+            case ST: return in.a < BITS && image.is_output(in.b);
+            case MOV:
+            case NOT:
+            case SET:
+            case RST: return in.a < BITS && in.b < BITS;
+            case AND:
+            case OR:
+            case XOR:
+            case ANDN:
+            case RISE:
+            case FALL: return in.a < BITS && in.b < BITS && in.c < BITS;
+            case LDK: return in.a < WORDS;
+            case MOVW: return in.a < WORDS && in.b < WORDS;
+            case ADD:
+            case SUB: return in.a < WORDS && in.b < WORDS && in.c < WORDS;
+            case CTU: return in.a < WORDS && in.b < BITS && in.c < BITS;
+            case GT:
+            case GE:
+            case EQ: return in.a < BITS && in.b < WORDS && in.c < WORDS;
+            case TON:
+            case TOF: return in.a < BITS && in.b < BITS && in.c < TIMERS;
+            case JMPC:
+            case JMPN:
+                if (in.a >= BITS) {
+                    return false;
+                }
+                [[fallthrough]];
+            case JMP: return target(in) > i && target(in) < count;
+            default: return false;
+        }
+    }
+
+    // Verifies the `count` instructions of `fetch` and runs them from the next scan on, with cleared registers
+    template <class Fetch>
+    bool load(Fetch&& fetch, std::uint16_t count, Source source) {
+        bool ok = count > 0 && count <= MaxInstructions && fetch(count - 1U).op == END;
+        for (std::uint16_t i = 0; ok && i < count; ++i) {
+            ok = valid(fetch(i), i, count);
+        }
+        if (!ok) {
+            ++rejected_;
+            return false;
+        }
+        for (std::uint16_t i = 0; i < count; ++i) {
+            code_[i] = fetch(i);
+        }
+        count_ = count;
+        source_ = source;
+        bits_ = {};
+        words_ = {};
+        elapsed_ = {};
+        timing_ = 0;
+        held_ = 0;
+        clock_.delta();
+        return true;
+    }
+
+    ProgramEvent::Status request(const ProgramEvent& evt) {
+        if (pending_ != 0) {
+            return ProgramEvent::BUSY;
+        }
+        if (evt.action == ProgramEvent::COMMIT) {
+            return load_eeprom() ? ProgramEvent::OK : ProgramEvent::BAD_PROGRAM;
+        }
+        if (evt.length == 0 || evt.length > CHUNK_SIZE || evt.offset + evt.length > REGION_SIZE) {
+            return ProgramEvent::BAD_OFFSET;
+        }
+        for (std::uint8_t i = 0; i < evt.length; ++i) {
+            chunk_[i] = evt.data[i];
+        }
+        chunk_address_ = static_cast<std::uint16_t>(REGION + evt.offset);
+        pending_ = evt.length;
+        written_ = 0;
+        return ProgramEvent::OK;
+    }
+
+    static std::uint16_t advance(std::uint16_t elapsed, std::uint16_t delta) {
+        const std::uint32_t sum = static_cast<std::uint32_t>(elapsed) + delta;
+        return static_cast<std::uint16_t>((sum > UINT16_MAX) ? UINT16_MAX : sum);
+    }
+
+    static std::uint16_t preset(std::int16_t word) { return static_cast<std::uint16_t>((word < 0) ? 0 : word); }
+
+    // The scan itself: verification guarantees the program ends, at an END, and keeps every index in range
+    void run(std::uint16_t delta) {
+        static const void* const DISPATCH[OP_COUNT] PROGMEM = {
+            &&op_end, &&op_ld,   &&op_st,  &&op_mov, &&op_not,  &&op_and, &&op_or,  &&op_xor, &&op_andn,
+            &&op_set, &&op_rst,  &&op_rise, &&op_fall, &&op_ldk, &&op_movw, &&op_add, &&op_sub, &&op_ctu,
+            &&op_gt,  &&op_ge,   &&op_eq,  &&op_ton, &&op_tof,  &&op_jmp, &&op_jmpc, &&op_jmpn};
+        std::uint8_t* const bits = bits_.data();
+        std::int16_t* const words = words_.data();
+        const Instruction* ip = code_.data();
+#define LOGIC_VM_DISPATCH goto* pgm_read_ptr(&DISPATCH[ip->op])
+#define LOGIC_VM_NEXT goto* pgm_read_ptr(&DISPATCH[(++ip)->op])
+        LOGIC_VM_DISPATCH;
+
+    op_ld:
+        bits[ip->a] = image.input(ip->b);
+        LOGIC_VM_NEXT;
+    op_st:
+        image.write(ip->b, bits[ip->a] != 0);
+        LOGIC_VM_NEXT;
+    op_mov:
+        bits[ip->a] = bits[ip->b];
+        LOGIC_VM_NEXT;
+    op_not:
+        bits[ip->a] = static_cast<std::uint8_t>(bits[ip->b] ^ 1U);
+        LOGIC_VM_NEXT;
+    op_and:
+        bits[ip->a] = static_cast<std::uint8_t>(bits[ip->b] & bits[ip->c]);
+        LOGIC_VM_NEXT;
+    op_or:
+        bits[ip->a] = static_cast<std::uint8_t>(bits[ip->b] | bits[ip->c]);
+        LOGIC_VM_NEXT;
+    op_xor:
+        bits[ip->a] = static_cast<std::uint8_t>(bits[ip->b] ^ bits[ip->c]);
+        LOGIC_VM_NEXT;
+    op_andn:
+        bits[ip->a] = static_cast<std::uint8_t>(bits[ip->b] & (bits[ip->c] ^ 1U));
+        LOGIC_VM_NEXT;
+    op_set:
+        bits[ip->a] |= bits[ip->b];
+        LOGIC_VM_NEXT;
+    op_rst:
+        bits[ip->a] &= static_cast<std::uint8_t>(bits[ip->b] ^ 1U);
+        LOGIC_VM_NEXT;
+    op_rise: {
+        const std::uint8_t level = bits[ip->b];
+        bits[ip->a] = static_cast<std::uint8_t>(level & (bits[ip->c] ^ 1U));
+        bits[ip->c] = level;
+        LOGIC_VM_NEXT;
+    }
+    op_fall: {
+        const std::uint8_t level = bits[ip->b];
+        bits[ip->a] = static_cast<std::uint8_t>((level ^ 1U) & bits[ip->c]);
+        bits[ip->c] = level;
+        LOGIC_VM_NEXT;
+    }
+    op_ldk:
+        words[ip->a] = static_cast<std::int16_t>(target(*ip));
+        LOGIC_VM_NEXT;
+    op_movw:
+        words[ip->a] = words[ip->b];
+        LOGIC_VM_NEXT;
+    op_add:
+        words[ip->a] = static_cast<std::int16_t>(static_cast<std::uint16_t>(words[ip->b]) +
+                                                 static_cast<std::uint16_t>(words[ip->c]));
+        LOGIC_VM_NEXT;
+    op_sub:
+        words[ip->a] = static_cast<std::int16_t>(static_cast<std::uint16_t>(words[ip->b]) -
+                                                 static_cast<std::uint16_t>(words[ip->c]));
+        LOGIC_VM_NEXT;
+    op_ctu:
+        if (bits[ip->c] != 0) {
+            words[ip->a] = 0;
+        } else if (bits[ip->b] != 0 && words[ip->a] != INT16_MAX) {
+            ++words[ip->a];
+        }
+        LOGIC_VM_NEXT;
+    op_gt:
+        bits[ip->a] = words[ip->b] > words[ip->c];
+        LOGIC_VM_NEXT;
+    op_ge:
+        bits[ip->a] = words[ip->b] >= words[ip->c];
+        LOGIC_VM_NEXT;
+    op_eq:
+        bits[ip->a] = words[ip->b] == words[ip->c];
+        LOGIC_VM_NEXT;
+    op_ton: {
+        const std::uint8_t t = ip->c;
+        const auto mask = static_cast<std::uint16_t>(1U << t);
+        if (bits[ip->b] != 0) {
+            elapsed_[t] = (timing_ & mask) ? advance(elapsed_[t], delta) : 0;
+            timing_ |= mask;
+            bits[ip->a] = elapsed_[t] >= preset(words[t]);
+        } else {
+            timing_ &= static_cast<std::uint16_t>(~mask);
+            elapsed_[t] = 0;
+            bits[ip->a] = 0;
+        }
+        LOGIC_VM_NEXT;
+    }
+    op_tof: {
+        const std::uint8_t t = ip->c;
+        const auto mask = static_cast<std::uint16_t>(1U << t);
+        if (bits[ip->b] != 0) {
+            held_ |= mask;
+            timing_ &= static_cast<std::uint16_t>(~mask);
+            elapsed_[t] = 0;
+        } else if (held_ & mask) {
+            elapsed_[t] = (timing_ & mask) ? advance(elapsed_[t], delta) : 0;
+            timing_ |= mask;
+            if (elapsed_[t] >= preset(words[t])) {
+                held_ &= static_cast<std::uint16_t>(~mask);
+                timing_ &= static_cast<std::uint16_t>(~mask);
+            }
+        }
+        bits[ip->a] = (held_ & mask) != 0;
+        LOGIC_VM_NEXT;
+    }
+    op_jmpc:
+        if (bits[ip->a] == 0) {
+            LOGIC_VM_NEXT;
+        }
+        goto op_jmp;
+    op_jmpn:
+        if (bits[ip->a] != 0) {
+            LOGIC_VM_NEXT;
+        }
+    op_jmp:
+        ip = code_.data() + target(*ip);
+        LOGIC_VM_DISPATCH;
+    op_end:
+        return;
+#undef LOGIC_VM_NEXT
+#undef LOGIC_VM_DISPATCH
+    }
+};
+
+} // namespace logic_vm
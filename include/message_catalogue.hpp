@@ -0,0 +1,21 @@
+#pragma once
+
+// The messages the firmware can emit as numeric records (see message_log.hpp), one X(NAME, "format") per message.
+// A message's id is its position in the list. tools/message_decode.py reads this file to turn the records back into
+// text, so it must come from the same revision as the firmware; add new messages at the end to keep old logs readable.
+//
+// Placeholders in a format stand for the arguments, in order, each sent little-endian in the given width:
+//     {u8} {u16} {u32}    unsigned integers
+//     {i16} {i32}         signed integers
+//     {output}            an output index (one byte), shown as its name, "LED<index + 1>" by default
+//
+// Keep each X() on a line of its own: the decoder reads the list line by line.
+
+#define MESSAGE_CATALOGUE(X)                                                                                \
+    X(CONTROLLER_READY, "LED Controller Ready")                                                             \
+    X(INVALID_LED_ID, "Invalid LED ID")                                                                     \
+    X(LED_STARTED, "{output} started")                                                                      \
+    X(LED_STOPPED, "{output} stopped")                                                                      \
+    X(LED_INTERVAL_SET, "{output} interval set to {u32}ms")                                                 \
+    X(BATCH_DONE, "Commands done: {u8} of {u8}, outputs updated: {u16}")                                    \
+    X(BATCH_PARTIAL, "Commands done: {u8} of {u8}, outputs updated: {u16} (invalid LED IDs in the others)")
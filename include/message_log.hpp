@@ -0,0 +1,114 @@
+#pragma once
+#include "binary_frame.hpp"
+#include "message_catalogue.hpp"
+#include "ramen.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Dictionary-based messages: a record carries the id of a message of MESSAGE_CATALOGUE and its arguments in binary
+// instead of the text, which stays on the host. "LED1 interval set to 500ms" takes 28 bytes as a text line and 12 as
+// a record, frame and CRC included; a message without arguments takes 7.
+//
+//     message_log::write<message_log::LED_INTERVAL_SET>(record_out, evt.led_id, evt.interval_ms);
+//
+// Records travel in binary_frame frames, so they share the port with text and with binary protocol replies; the
+// payload is RECORD, the id and the arguments. tools/message_decode.py prints the text of the records in a capture
+// and passes everything else through. The number and width of the arguments are checked against the placeholders of
+// the format at compile time. With -D SERIAL_DICTIONARY_LOG, SerialCommandSystem sends the messages of the catalogue
+// as records (ENABLED); otherwise the actors print their text as before.
+
+namespace message_log {
+
+#if defined(SERIAL_DICTIONARY_LOG)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t RECORD = 0x40;  // First payload byte of a record
+
+enum Id : std::uint8_t {
+#define MESSAGE_LOG_ID(name, format) name,
+    MESSAGE_CATALOGUE(MESSAGE_LOG_ID)
+#undef MESSAGE_LOG_ID
+    MESSAGE_COUNT
+};
+
+namespace detail {
+
+// Only evaluated at compile time, so the formats take no space in the firmware
+constexpr const char* FORMATS[] = {
+#define MESSAGE_LOG_FORMAT(name, format) format,
+    MESSAGE_CATALOGUE(MESSAGE_LOG_FORMAT)
+#undef MESSAGE_LOG_FORMAT
+};
+
+constexpr bool starts_with(const char* s, const char* prefix) {
+    for (; *prefix != '\0'; ++s, ++prefix) {
+        if (*s != *prefix) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Width in bytes of the placeholder at `s`, 0 if there is none
+constexpr std::size_t placeholder_width(const char* s) {
+    return (starts_with(s, "{u8}") || starts_with(s, "{output}")) ? 1
+           : (starts_with(s, "{u16}") || starts_with(s, "{i16}")) ? 2
+           : (starts_with(s, "{u32}") || starts_with(s, "{i32}")) ? 4
+                                                                  : 0;
+}
+
+// Width of placeholder `n` of `format`, 0 if it has fewer
+constexpr std::size_t argument_width(const char* format, std::size_t n) {
+    for (const char* s = format; *s != '\0'; ++s) {
+        const std::size_t width = placeholder_width(s);
+        if (width != 0 && n-- == 0) {
+            return width;
+        }
+    }
+    return 0;
+}
+
+constexpr std::size_t argument_count(const char* format) {
+    std::size_t count = 0;
+    while (argument_width(format, count) != 0) {
+        ++count;
+    }
+    return count;
+}
+
+template <Id id, class... Args, std::size_t... I>
+constexpr bool arguments_match(std::index_sequence<I...>) {
+    return sizeof...(Args) == argument_count(FORMATS[id]) &&
+           ((std::is_integral<Args>::value && sizeof(Args) == argument_width(FORMATS[id], I)) && ...);
+}
+
+template <class T>
+void put(std::uint8_t* payload, std::size_t& n, T value) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        payload[n++] = static_cast<std::uint8_t>(static_cast<std::make_unsigned_t<T>>(value) >> (8U * i));
+    }
+}
+
+} // namespace detail
+
+// Sends message `id` with `args`, which must match the placeholders of its format in number and width, to `out`, a
+// port taking ramen::Span<const std::uint8_t>
+template <Id id, class Out, class... Args>
+void write(Out& out, Args... args) {
+    static_assert(detail::arguments_match<id, Args...>(std::index_sequence_for<Args...>{}),
+                  "The arguments do not match the placeholders of the message format");
+    std::uint8_t payload[2 + (0 + ... + sizeof(Args)) + binary_frame::CRC_SIZE];
+    std::size_t n = 0;
+    payload[n++] = RECORD;
+    payload[n++] = id;
+    (detail::put(payload, n, args), ...);
+    n = binary_frame::append_crc(payload, n);
+    std::uint8_t wire[binary_frame::max_frame(sizeof(payload))];
+    out(ramen::Span<const std::uint8_t>(wire, binary_frame::encode_frame(payload, n, wire)));
+}
+
+} // namespace message_log
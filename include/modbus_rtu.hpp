@@ -0,0 +1,256 @@
+#pragma once
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+#endif
+
+// Modbus RTU link layer on the RS485 port of the Controllino MEGA (USART3, with the transceiver's direction on PJ5 and
+// PJ6, as Controllino_RS485TxEnable() sets them), with the frame timing of the Modbus serial line specification done
+// in interrupts.
+//
+// The receive interrupt stores each byte in `frame` and restarts Timer2, which runs at 64 us per count: compare B
+// fires 1.5 character times after a byte and marks a gap, compare A fires after 3.5 and ends the frame. A byte after a
+// gap, an overrun or framing error, or a frame longer than MAX_ADU makes the frame corrupt, and it is dropped when it
+// ends; a complete frame waits in `frame` until the main loop takes it:
+//
+//     modbus_rtu::begin(19200, modbus_rtu::Parity::EVEN);
+//     if (modbus_rtu::frame_ready()) { ...; modbus_rtu::transmit(reply_length); }  // Or release()
+//
+// transmit() sends from `frame` through the data register empty interrupt, with the driver on, and the transmit
+// complete interrupt turns the bus around again. No byte is received while a frame waits or a reply goes out.
+// Character times follow the baud rate up to 19200 and are 750 us and 1750 us above, as the specification fixes them;
+// rates from 2400 baud are supported. See actor_modbus.hpp for the slave on top.
+//
+// The module takes USART3 and Timer2 from the Arduino core (so Serial3, tone() and PWM on pins 9 and 10 are not
+// available) and is opt-in with -D MODBUS_RTU, which enables the interrupts in src/modbus_rtu.cpp. Without it, and off
+// AVR, ENABLED is false, begin() fails and no frame ever arrives.
+
+namespace modbus_rtu {
+
+#if defined(__AVR__) && defined(MODBUS_RTU)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::size_t MAX_ADU = 256;  // Address, PDU and CRC
+constexpr std::size_t CRC_SIZE = 2;
+constexpr std::uint8_t BROADCAST = 0;
+
+// Of the serial line; the specification requires two stop bits without parity
+enum class Parity : std::uint8_t { EVEN, ODD, NONE };
+
+enum class State : std::uint8_t {
+    IDLE,          // Waiting for the first byte of a frame
+    RECEIVING,
+    FRAME_READY,   // A frame waits for the main loop
+    TRANSMITTING
+};
+
+// CRC-16/MODBUS: polynomial 0xA001 (reflected 0x8005), initial value 0xFFFF, sent low byte first
+inline std::uint16_t crc16_update(std::uint16_t crc, std::uint8_t byte) {
+#if defined(__AVR__)
+    return _crc16_update(crc, byte);  // The same CRC, in hand-written assembly
+#else
+    crc = static_cast<std::uint16_t>(crc ^ byte);
+    for (std::uint8_t bit = 0; bit < 8; ++bit) {
+        crc = static_cast<std::uint16_t>((crc & 1U) ? (crc >> 1) ^ 0xA001U : crc >> 1);
+    }
+    return crc;
+#endif
+}
+
+inline std::uint16_t crc16(const std::uint8_t* data, std::size_t length) {
+    std::uint16_t crc = 0xFFFF;
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = crc16_update(crc, data[i]);
+    }
+    return crc;
+}
+
+// Shared with the interrupts. The main loop only touches `frame` and `length` while the state is FRAME_READY, when the
+// interrupts leave them alone
+inline std::uint8_t frame[ENABLED ? MAX_ADU : 1];
+inline volatile std::uint16_t length = 0;  // Received, or to transmit
+inline volatile State state = State::IDLE;
+inline std::uint16_t dropped_frames = 0;   // Corrupt or too short; saturates at 65535
+
+namespace detail {
+
+inline volatile std::uint16_t sent = 0;
+inline volatile bool gap = false;      // 1.5 character times passed since the last byte
+inline volatile bool corrupt = false;  // The frame being received is to be dropped
+
+constexpr std::uint16_t US_PER_COUNT = 64;  // Timer2 at clk/1024, 16 MHz
+
+inline std::uint8_t counts(std::uint32_t us) {
+    const std::uint32_t n = (us + US_PER_COUNT - 1U) / US_PER_COUNT;
+    return static_cast<std::uint8_t>(n < 255U ? n : 255U);
+}
+
+inline void count_drop() {
+    if (dropped_frames != UINT16_MAX) {
+        ++dropped_frames;
+    }
+}
+
+#if defined(__AVR__) && defined(MODBUS_RTU)
+constexpr std::uint8_t DIRECTION = _BV(PJ5) | _BV(PJ6);  // High: driver on, receiver off
+#endif
+
+} // namespace detail
+
+// Configures USART3 and Timer2 for `baud`, in the receiving direction; false if the build or the rate is unsupported
+inline bool begin(unsigned long baud, Parity parity = Parity::EVEN) {
+#if defined(__AVR__) && defined(MODBUS_RTU)
+    if (baud < 2400UL) {
+        return false;  // t3.5 would not fit into Timer2's 8 bits
+    }
+    const std::uint32_t char_us = (baud <= 19200UL) ? 11000000UL / baud : 0;
+    const std::uint8_t t15 = detail::counts(char_us != 0 ? char_us * 3U / 2U : 750U);
+    const std::uint8_t t35 = detail::counts(char_us != 0 ? char_us * 7U / 2U : 1750U);
+
+    const std::uint8_t sreg = SREG;
+    cli();
+    DDRJ |= detail::DIRECTION;
+    PORTJ &= static_cast<std::uint8_t>(~detail::DIRECTION);
+
+    UCSR3A = _BV(U2X3);
+    const std::uint16_t ubrr = static_cast<std::uint16_t>((F_CPU / 4UL / baud - 1UL) / 2UL);
+    UBRR3H = static_cast<std::uint8_t>(ubrr >> 8);
+    UBRR3L = static_cast<std::uint8_t>(ubrr);
+    switch (parity) {
+        case Parity::EVEN:
+            UCSR3C = _BV(UPM31) | _BV(UCSZ31) | _BV(UCSZ30);  // 8E1
+            break;
+        case Parity::ODD:
+            UCSR3C = _BV(UPM31) | _BV(UPM30) | _BV(UCSZ31) | _BV(UCSZ30);  // 8O1
+            break;
+        case Parity::NONE:
+            UCSR3C = _BV(USBS3) | _BV(UCSZ31) | _BV(UCSZ30);  // 8N2
+            break;
+    }
+    UCSR3B = _BV(RXEN3) | _BV(TXEN3) | _BV(RXCIE3);
+
+    TCCR2A = _BV(WGM21);  // CTC with TOP = OCR2A, stopped until a byte arrives
+    TCCR2B = 0;
+    OCR2A = t35;
+    OCR2B = t15;
+    TIMSK2 = 0;
+    state = State::IDLE;
+    SREG = sreg;
+    return true;
+#else
+    (void)baud;
+    (void)parity;
+    return false;
+#endif
+}
+
+inline bool frame_ready() { return state == State::FRAME_READY; }
+
+// Drops the waiting frame without a reply
+inline void release() {
+    if (state == State::FRAME_READY) {
+        state = State::IDLE;
+    }
+}
+
+// Sends the first `n` bytes of `frame` in place of the waiting one, CRC included
+inline void transmit(std::uint16_t n) {
+#if defined(__AVR__) && defined(MODBUS_RTU)
+    if (state != State::FRAME_READY || n == 0 || n > MAX_ADU) {
+        release();
+        return;
+    }
+    length = n;
+    detail::sent = 0;
+    state = State::TRANSMITTING;
+    PORTJ |= detail::DIRECTION;
+    UCSR3B = static_cast<std::uint8_t>(UCSR3B | _BV(UDRIE3));
+#else
+    (void)n;
+    release();
+#endif
+}
+
+// Interrupt side: a byte arrived, with the receiver status read before it
+inline void on_receive(std::uint8_t status, std::uint8_t byte) {
+#if defined(__AVR__) && defined(MODBUS_RTU)
+    if (state == State::FRAME_READY || state == State::TRANSMITTING) {
+        return;  // Not for us to take; the master waits for the reply
+    }
+    if (state == State::IDLE) {
+        state = State::RECEIVING;
+        length = 0;
+        detail::corrupt = false;
+    } else if (detail::gap) {
+        detail::corrupt = true;
+    }
+    if ((status & (_BV(FE3) | _BV(DOR3) | _BV(UPE3))) != 0 || length >= MAX_ADU) {
+        detail::corrupt = true;
+    } else {
+        frame[length] = byte;
+        length = static_cast<std::uint16_t>(length + 1U);
+    }
+    detail::gap = false;
+    TCNT2 = 0;
+    GTCCR = _BV(PSRASY);  // Restart the prescaler too, for a full first count
+    TIFR2 = _BV(OCF2A) | _BV(OCF2B);
+    TIMSK2 = _BV(OCIE2A) | _BV(OCIE2B);
+    TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20);  // clk/1024
+#else
+    (void)status;
+    (void)byte;
+#endif
+}
+
+// Interrupt side: 1.5 character times of silence
+inline void on_gap() {
+    detail::gap = true;
+}
+
+// Interrupt side: 3.5 character times of silence end the frame
+inline void on_frame_end() {
+#if defined(__AVR__) && defined(MODBUS_RTU)
+    TCCR2B = 0;
+    TIMSK2 = 0;
+    if (state != State::RECEIVING) {
+        return;
+    }
+    if (detail::corrupt || length < 4U) {  // Address, function code and CRC at least
+        detail::count_drop();
+        state = State::IDLE;
+    } else {
+        state = State::FRAME_READY;
+    }
+#endif
+}
+
+// Interrupt side: the data register takes the next byte of the reply
+inline void on_data_register_empty() {
+#if defined(__AVR__) && defined(MODBUS_RTU)
+    const std::uint16_t i = detail::sent;
+    if (i + 1U == length) {
+        UCSR3A = static_cast<std::uint8_t>(UCSR3A | _BV(TXC3));  // Cleared by writing one, before the last byte
+        UCSR3B = static_cast<std::uint8_t>((UCSR3B & ~_BV(UDRIE3)) | _BV(TXCIE3));
+    }
+    UDR3 = frame[i];
+    detail::sent = static_cast<std::uint16_t>(i + 1U);
+#endif
+}
+
+// Interrupt side: the last stop bit is out, so the bus is released to the master
+inline void on_transmit_complete() {
+#if defined(__AVR__) && defined(MODBUS_RTU)
+    UCSR3B = static_cast<std::uint8_t>(UCSR3B & ~_BV(TXCIE3));
+    PORTJ &= static_cast<std::uint8_t>(~detail::DIRECTION);
+    state = State::IDLE;
+#endif
+}
+
+} // namespace modbus_rtu
@@ -0,0 +1,140 @@
+#pragma once
+#include "actor_led.hpp"
+#include "fmt.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// Directory of the blinking outputs the command system controls, filled once and shared by every consumer.
+//
+// Outputs are looked up by index (command ids are 1-based). Each entry is the output's blinky_led_context plus a
+// flash table of thunks for its actor type, so BlinkyLedActor, FastBlinkyLedActor<Pin>, ImageBlinkyLedActor and
+// ExpanderBlinkyLedActor can be mixed in one registry at 2 pointers of RAM per output. Names come from an optional
+// table of flash strings and default to "LED<id>".
+//
+//     led::OutputRegistry<3> outputs(led1, led2, led3);
+//     serial_cmd::SerialCommandSystem commander(outputs);
+
+namespace led {
+
+class OutputTable;
+
+// One registered output
+class OutputRef {
+public:
+    struct Ops {
+        void (*start)(blinky_led_context&);
+        void (*stop)(blinky_led_context&);
+        void (*set_blink_interval)(blinky_led_context&, std::uint32_t);
+        std::uint8_t (*state_id)(const blinky_led_context&);
+        void (*resume)(blinky_led_context&, std::uint8_t);
+    };
+
+    OutputRef(blinky_led_context* context, const Ops* ops_P) : context_(context), ops_(ops_P) {}
+
+    void start() const { op<decltype(Ops::start)>(&ops_->start)(*context_); }
+    void stop() const { op<decltype(Ops::stop)>(&ops_->stop)(*context_); }
+    void set_blink_interval(std::uint32_t ms) const {
+        op<decltype(Ops::set_blink_interval)>(&ops_->set_blink_interval)(*context_, ms);
+    }
+    std::uint8_t state_id() const { return op<decltype(Ops::state_id)>(&ops_->state_id)(*context_); }
+    void resume(std::uint8_t state) const { op<decltype(Ops::resume)>(&ops_->resume)(*context_, state); }
+    std::uint8_t pin() const { return context_->pin; }
+    std::uint32_t blink_interval_ms() const { return context_->blink_interval_ms; }
+    // True if the output should blink but no timer drives it (see blinky_led_context::timer_missing())
+    bool fault() const { return state_id() != STATE_STOPPED && context_->timer_missing(); }
+
+private:
+    blinky_led_context* context_;
+    const Ops* ops_;  // In flash
+
+    template <class Fn>
+    static Fn op(const Fn* slot_P) {
+        return reinterpret_cast<Fn>(pgm_read_ptr(slot_P));
+    }
+};
+
+namespace detail {
+
+template <class Actor>
+struct output_ops {
+    static void start(blinky_led_context& c) { static_cast<Actor&>(c).start(); }
+    static void stop(blinky_led_context& c) { static_cast<Actor&>(c).stop(); }
+    static void set_blink_interval(blinky_led_context& c, std::uint32_t ms) {
+        static_cast<Actor&>(c).set_blink_interval(ms);
+    }
+    static std::uint8_t state_id(const blinky_led_context& c) { return static_cast<const Actor&>(c).state_id(); }
+    static void resume(blinky_led_context& c, std::uint8_t state) { static_cast<Actor&>(c).resume(state); }
+
+    static constexpr OutputRef::Ops table PROGMEM = {&start, &stop, &set_blink_interval, &state_id, &resume};
+};
+
+} // namespace detail
+
+// Size-independent view of an OutputRegistry, as used by the command system
+class OutputTable {
+public:
+    std::uint8_t size() const { return size_; }
+    bool contains(std::uint8_t index) const { return index < size_; }
+    OutputRef at(std::uint8_t index) const { return OutputRef(contexts_[index], ops_[index]); }
+
+    // Names of the outputs as flash strings, indexed like the outputs; nullptr selects "LED<id>"
+    void set_names_P(const char* const* names_P) { names_P_ = names_P; }
+    bool named() const { return names_P_ != nullptr; }
+
+    // Streams the name of an output into a fmt sink
+    template <class Sink>
+    void write_name(Sink& sink, std::uint8_t index) const {
+        if (names_P_ != nullptr) {
+            fmt::write(sink, fmt::flash(static_cast<const char*>(pgm_read_ptr(&names_P_[index]))));
+        } else {
+            fmt::write(sink, "LED", static_cast<unsigned>(index + 1U));
+        }
+    }
+
+    // Writes the name of an output into `buffer`
+    void name(std::uint8_t index, char* buffer, std::size_t size) const {
+        fmt::Buffer sink(buffer, size);
+        write_name(sink, index);
+    }
+
+protected:
+    OutputTable() = default;
+
+    blinky_led_context* const* contexts_ = nullptr;  // Set by OutputRegistry to its storage
+    const OutputRef::Ops* const* ops_ = nullptr;
+    const char* const* names_P_ = nullptr;
+    std::uint8_t size_ = 0;
+};
+
+template <std::uint8_t N>
+class OutputRegistry : public OutputTable {
+public:
+    template <class... Actors>
+    explicit OutputRegistry(Actors&... actors) {
+        static_assert(sizeof...(Actors) <= N, "More outputs than registry slots");
+        contexts_ = contexts_storage_.data();
+        ops_ = ops_storage_.data();
+        (add(actors), ...);
+    }
+    OutputRegistry(const OutputRegistry&) = delete;
+    OutputRegistry& operator=(const OutputRegistry&) = delete;
+
+    // Appends an output; false if the registry is full
+    template <class Actor>
+    bool add(Actor& actor) {
+        if (size_ >= N) {
+            return false;
+        }
+        contexts_storage_[size_] = &actor;
+        ops_storage_[size_] = &detail::output_ops<Actor>::table;
+        ++size_;
+        return true;
+    }
+
+private:
+    std::array<blinky_led_context*, N> contexts_storage_{};
+    std::array<const OutputRef::Ops*, N> ops_storage_{};
+};
+
+} // namespace led
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#endif
+
+namespace ramen
+{
+
+/// Copy of the item at `item_P`, an address in flash: one pgm_read_byte/word/dword for items of 1, 2 or 4 bytes,
+/// memcpy_P for others. Off AVR, where PROGMEM is ordinary memory, a plain copy.
+template <typename T>
+T pgm_read(const T* item_P) noexcept
+{
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+                  "Flash items are copied byte for byte into a T");
+#if defined(__AVR__)
+    T item;
+    if constexpr (sizeof(T) == 1)
+    {
+        const std::uint8_t raw = pgm_read_byte(item_P);
+        std::memcpy(&item, &raw, 1);
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        const std::uint16_t raw = pgm_read_word(item_P);
+        std::memcpy(&item, &raw, 2);
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        const std::uint32_t raw = pgm_read_dword(item_P);
+        std::memcpy(&item, &raw, 4);
+    }
+    else
+    {
+        memcpy_P(&item, item_P, sizeof(T));
+    }
+    return item;
+#else
+    return *item_P;
+#endif
+}
+
+/// Random-access iterator over items in flash. Dereferencing reads a copy of the item, so `reference` is T and there
+/// is no operator->; the algorithms of <algorithm> that only read (std::lower_bound, std::find_if, std::max_element,
+/// std::equal...) take it as they take a pointer.
+template <typename T>
+class PgmIterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const T*;  // In flash
+    using reference         = T;
+
+    constexpr PgmIterator() noexcept = default;
+    constexpr explicit PgmIterator(const T* item_P) noexcept : item_P_(item_P) {}
+
+    T operator*() const noexcept { return pgm_read(item_P_); }
+    T operator[](const difference_type n) const noexcept { return pgm_read(item_P_ + n); }
+
+    /// The flash address of the item, for pgm_read_* of a single member
+    constexpr const T* base() const noexcept { return item_P_; }
+
+    constexpr PgmIterator& operator++() noexcept { ++item_P_; return *this; }
+    constexpr PgmIterator& operator--() noexcept { --item_P_; return *this; }
+    constexpr PgmIterator  operator++(int) noexcept { PgmIterator old = *this; ++item_P_; return old; }
+    constexpr PgmIterator  operator--(int) noexcept { PgmIterator old = *this; --item_P_; return old; }
+    constexpr PgmIterator& operator+=(const difference_type n) noexcept { item_P_ += n; return *this; }
+    constexpr PgmIterator& operator-=(const difference_type n) noexcept { item_P_ -= n; return *this; }
+
+    friend constexpr PgmIterator operator+(PgmIterator it, const difference_type n) noexcept { return it += n; }
+    friend constexpr PgmIterator operator+(const difference_type n, PgmIterator it) noexcept { return it += n; }
+    friend constexpr PgmIterator operator-(PgmIterator it, const difference_type n) noexcept { return it -= n; }
+    friend constexpr difference_type operator-(PgmIterator a, PgmIterator b) noexcept
+    {
+        return a.item_P_ - b.item_P_;
+    }
+
+    friend constexpr bool operator==(PgmIterator a, PgmIterator b) noexcept { return a.item_P_ == b.item_P_; }
+    friend constexpr bool operator!=(PgmIterator a, PgmIterator b) noexcept { return a.item_P_ != b.item_P_; }
+    friend constexpr bool operator<(PgmIterator a, PgmIterator b) noexcept { return a.item_P_ < b.item_P_; }
+    friend constexpr bool operator>(PgmIterator a, PgmIterator b) noexcept { return a.item_P_ > b.item_P_; }
+    friend constexpr bool operator<=(PgmIterator a, PgmIterator b) noexcept { return a.item_P_ <= b.item_P_; }
+    friend constexpr bool operator>=(PgmIterator a, PgmIterator b) noexcept { return a.item_P_ >= b.item_P_; }
+
+private:
+    const T* item_P_ = nullptr;
+};
+
+/// Array of N constant items meant for flash: built in constant expressions, declared PROGMEM, and read at run time
+/// through pgm_read() without an accessor per table. Indexing and iterators return copies of the items, so a table in
+/// flash is searched and walked like one in RAM:
+///
+///     constexpr auto LIMITS PROGMEM = ramen::pgm_array<std::uint16_t>({10, 50, 100, 500, 1000});
+///     const auto it = std::lower_bound(LIMITS.begin(), LIMITS.end(), value);   // Each probe a pgm_read_word
+///     const std::uint16_t largest = LIMITS.back();
+///
+/// An instance not declared PROGMEM is read through the same calls from RAM, which on AVR gives wrong values: the
+/// accessors are for flash only. In constant expressions, constant() reads the items directly instead.
+template <typename T, std::size_t N>
+class PgmArray
+{
+    static_assert(N > 0, "PgmArray holds at least one item");
+
+public:
+    using value_type     = T;
+    using size_type      = std::size_t;
+    using const_iterator = PgmIterator<T>;
+    using iterator       = const_iterator;
+
+    constexpr PgmArray() noexcept = default;
+
+    constexpr PgmArray(const T (&items)[N]) noexcept
+    {
+        for (std::size_t i = 0; i < N; ++i) { items_[i] = items[i]; }
+    }
+
+    static constexpr size_type size() noexcept { return N; }
+    static constexpr bool      empty() noexcept { return false; }
+
+    constexpr const_iterator begin() const noexcept { return const_iterator(items_); }
+    constexpr const_iterator end() const noexcept { return const_iterator(items_ + N); }
+
+    T operator[](const size_type index) const noexcept { return pgm_read(&items_[index]); }
+    T front() const noexcept { return pgm_read(&items_[0]); }
+    T back() const noexcept { return pgm_read(&items_[N - 1U]); }
+
+    /// The flash address of the items, e.g. for memcpy_P of several at once
+    constexpr const T* data_P() const noexcept { return items_; }
+
+    /// The item at `index`, in constant expressions only: at run time, operator[]
+    constexpr const T& constant(const size_type index) const noexcept { return items_[index]; }
+
+private:
+    T items_[N]{};
+};
+
+/// A PgmArray of the items of a braced list or array, e.g. `ramen::pgm_array<Port>({Port::E, Port::E, Port::G})`
+template <typename T, std::size_t N>
+constexpr PgmArray<T, N> pgm_array(const T (&items)[N]) noexcept
+{
+    return PgmArray<T, N>(items);
+}
+
+} // namespace ramen
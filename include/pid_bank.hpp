@@ -0,0 +1,269 @@
+#pragma once
+#include "adc_pipeline.hpp"
+#include "fixed_point.hpp"
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+// A bank of PID loops in fixed point, run together at one rate: several control loops, each a few hundred cycles
+// per execution where a float PID takes several thousand.
+//
+// The loops are kept as a structure of arrays and run by update(), all of them in one pass, as a task of a rate group
+// of the cyclic executive (cyclic_executive.hpp) whose period the gains are given for. Measurements come from the
+// frames of the ADC pipeline (adc_pipeline.hpp), each loop taking a channel of the frame; the outputs leave as a frame
+// of their own after every update(), for AnalogOutputs or any other actor:
+//
+//     pid::PidBank<8> loops;
+//     pid::AnalogOutputs<8> drives({9, 10, 11, 12, 44, 45, 46, CONTROLLINO_AO0});  // analogWrite(), 0..255
+//     cyclic::CyclicExecutiveActor<10> tasks;                                       // 100 Hz
+//     constexpr cyclic::Task CONTROL[] PROGMEM = {cyclic::task<&pid::PidBank<8>::update>(loops)};
+//
+//     void setup() {
+//         smooth.out >> loops.measurement_in;  // ADC counts, a loop per channel
+//         loops.output_out >> drives.in;
+//         loops.configure(0, pid::gains(2.0, 1.5, 0.05, 0.010), 0, 255);  // Kp, Ti and Td in s, the period in s
+//         loops.set_setpoint(0, 512);
+//         tasks.set_tasks(0, CONTROL);
+//         tasks.start();
+//     }
+//
+// Values are integers, the measurements and setpoints in ADC counts, the outputs in the units of their actuator; the
+// gains are Q7.8, in output units per count. Each execution of a loop computes
+//
+//     P = kp * e,   I += ki * e,   D = -kd * filtered difference of the measurement,   output = P + I + D
+//
+// with e = setpoint - measurement. The derivative is taken on the measurement, so a setpoint step does not kick the
+// output, and low-passed with a time constant of 2^filter_shift executions. The integral has 8 fraction bits; it
+// stops integrating while the output is saturated in the direction of the error and stays within the output limits
+// (anti-windup). In manual, the output holds the value set by set_output() and the integral tracks it, so switching
+// back to automatic continues from that output (bumpless transfer); so does a change of gains.
+
+namespace pid {
+
+using Gain = fx::Fixed<7, 8>;
+
+struct Gains {
+    Gain kp;
+    Gain ki;  // Per execution
+    Gain kd;  // Per execution
+};
+
+// The discrete gains of a PID with gain kp, integral time ti and derivative time td (seconds, 0 for none) run every
+// period_s seconds; a constant expression: the float arithmetic runs at compile time
+constexpr Gains gains(double kp, double ti, double td, double period_s) {
+    return Gains{Gain(kp), Gain((ti > 0) ? kp * period_s / ti : 0.0), Gain(kp * td / period_s)};
+}
+
+template <std::uint8_t N>
+class PidBank {
+    static_assert(N > 0 && N <= adc::MAX_CHANNELS, "A bank holds 1 to 16 loops");
+
+public:
+    static constexpr std::uint8_t SIZE = N;
+    static constexpr std::uint8_t MAX_FILTER_SHIFT = 7;
+
+    using Values = ramen::Span<const std::int16_t>;
+
+    // Input: a frame of measurements, of which loop i takes the value of its channel (i unless configured)
+    ramen::Pushable<adc::Frame> measurement_in = [this](const adc::Frame& frame) {
+        for (std::uint8_t i = 0; i < N; ++i) {
+            if (channel_[i] < frame.size()) {
+                const std::uint16_t value = frame[channel_[i]];
+                pv_[i] = static_cast<std::int16_t>((value > INT16_MAX) ? INT16_MAX : value);
+            }
+        }
+    };
+
+    // Output: the outputs of all loops after each update()
+    ramen::Pusher<Values> output_out;
+
+    PidBank() {
+        for (std::uint8_t i = 0; i < N; ++i) {
+            channel_[i] = i;
+            max_[i] = INT16_MAX;
+        }
+    }
+
+    // Sets the gains and limits of a loop and resets it: automatic, the integral at 0 or the nearest limit
+    void configure(std::uint8_t i, Gains g, std::int16_t out_min, std::int16_t out_max, std::uint8_t filter_shift = 2) {
+        if (i >= N || out_min > out_max) {
+            return;
+        }
+        kp_[i] = g.kp.raw();
+        ki_[i] = g.ki.raw();
+        kd_[i] = g.kd.raw();
+        min_[i] = out_min;
+        max_[i] = out_max;
+        shift_[i] = (filter_shift > MAX_FILTER_SHIFT) ? MAX_FILTER_SHIFT : filter_shift;
+        integral_[i] = clamp_integral(i, 0);
+        derivative_[i] = 0;
+        last_pv_[i] = pv_[i];
+        out_[i] = clamp(i, 0);
+        set_bit(manual_, i, false);
+        set_bit(primed_, i, false);
+    }
+
+    // New gains without a bump: the integral takes up the change of the proportional term
+    void set_gains(std::uint8_t i, Gains g) {
+        if (i >= N) {
+            return;
+        }
+        const std::int32_t before = proportional(i);
+        kp_[i] = g.kp.raw();
+        ki_[i] = g.ki.raw();
+        kd_[i] = g.kd.raw();
+        integral_[i] = clamp_integral(i, integral_[i] + (before - proportional(i)) * 256);
+    }
+
+    void set_channel(std::uint8_t i, std::uint8_t channel) {
+        if (i < N) {
+            channel_[i] = channel;
+        }
+    }
+
+    void set_setpoint(std::uint8_t i, std::int16_t setpoint) {
+        if (i < N) {
+            sp_[i] = setpoint;
+        }
+    }
+
+    // Manual: the output holds until set_output(); back in automatic it continues from there
+    void set_manual(std::uint8_t i, bool manual) {
+        if (i < N) {
+            set_bit(manual_, i, manual);
+        }
+    }
+
+    void set_output(std::uint8_t i, std::int16_t output) {
+        if (i < N && manual(i)) {
+            out_[i] = clamp(i, output);
+        }
+    }
+
+    // Sets the measurement directly, without a frame
+    void set_measurement(std::uint8_t i, std::int16_t value) {
+        if (i < N) {
+            pv_[i] = value;
+        }
+    }
+
+    bool manual(std::uint8_t i) const { return (manual_ & (1UL << i)) != 0; }
+    std::int16_t output(std::uint8_t i) const { return (i < N) ? out_[i] : 0; }
+    std::int16_t measurement(std::uint8_t i) const { return (i < N) ? pv_[i] : 0; }
+    std::int16_t setpoint(std::uint8_t i) const { return (i < N) ? sp_[i] : 0; }
+
+    // One execution of every loop, then the output frame
+    void update() {
+        for (std::uint8_t i = 0; i < N; ++i) {
+            execute(i);
+        }
+        output_out(Values(out_.data(), N));
+    }
+
+private:
+    using Mask = std::conditional_t<(N > 8), std::uint16_t, std::uint8_t>;
+
+    std::array<std::int16_t, N> sp_{};
+    std::array<std::int16_t, N> pv_{};
+    std::array<std::int16_t, N> last_pv_{};
+    std::array<std::int16_t, N> kp_{};
+    std::array<std::int16_t, N> ki_{};
+    std::array<std::int16_t, N> kd_{};
+    std::array<std::int16_t, N> min_{};
+    std::array<std::int16_t, N> max_{};
+    std::array<std::int16_t, N> out_{};
+    std::array<std::int32_t, N> integral_{};    // Output units, 8 fraction bits
+    std::array<std::int32_t, N> derivative_{};  // Filtered measurement difference, 8 fraction bits
+    std::array<std::uint8_t, N> shift_{};
+    std::array<std::uint8_t, N> channel_{};
+    Mask manual_ = 0;
+    Mask primed_ = 0;  // Loops with a last measurement for the derivative
+
+    static void set_bit(Mask& mask, std::uint8_t i, bool value) {
+        const auto bit = static_cast<Mask>(1U << i);
+        mask = static_cast<Mask>(value ? (mask | bit) : (mask & ~bit));
+    }
+
+    static std::int16_t saturate16(std::int32_t value) {
+        return static_cast<std::int16_t>((value > INT16_MAX) ? INT16_MAX : ((value < INT16_MIN) ? INT16_MIN : value));
+    }
+
+    std::int16_t clamp(std::uint8_t i, std::int32_t value) const {
+        return static_cast<std::int16_t>((value > max_[i]) ? max_[i] : ((value < min_[i]) ? min_[i] : value));
+    }
+
+    std::int32_t clamp_integral(std::uint8_t i, std::int32_t value) const {
+        const std::int32_t low = static_cast<std::int32_t>(min_[i]) * 256;
+        const std::int32_t high = static_cast<std::int32_t>(max_[i]) * 256;
+        return (value > high) ? high : ((value < low) ? low : value);
+    }
+
+    std::int16_t error(std::uint8_t i) const { return saturate16(static_cast<std::int32_t>(sp_[i]) - pv_[i]); }
+
+    // kp * e, and -kd * the filtered difference, in output units; 16x16 multiplies only
+    std::int32_t proportional(std::uint8_t i) const {
+        return (static_cast<std::int32_t>(kp_[i]) * error(i)) >> 8;
+    }
+
+    std::int32_t derivative(std::uint8_t i) const {
+        const std::int32_t d = derivative_[i];
+        const std::int16_t whole = saturate16(d >> 8);
+        const auto fraction = static_cast<std::int16_t>(d & 0xFF);
+        const std::int32_t product = static_cast<std::int32_t>(kd_[i]) * whole +
+                                     ((static_cast<std::int32_t>(kd_[i]) * fraction) >> 8);
+        return -(product >> 8);
+    }
+
+    void execute(std::uint8_t i) {
+        const std::int16_t pv = pv_[i];
+        const std::int32_t difference = (primed_ & (1UL << i)) ? static_cast<std::int32_t>(pv) - last_pv_[i] : 0;
+        last_pv_[i] = pv;
+        set_bit(primed_, i, true);
+        derivative_[i] += (difference * 256 - derivative_[i]) >> shift_[i];
+
+        const std::int32_t p = proportional(i);
+        const std::int32_t d = derivative(i);
+        if (manual(i)) {
+            // Tracking: the integral that gives the held output
+            integral_[i] = clamp_integral(i, (static_cast<std::int32_t>(out_[i]) - p - d) * 256);
+            return;
+        }
+        const std::int16_t e = error(i);
+        const std::int32_t integral = clamp_integral(i, integral_[i] + static_cast<std::int32_t>(ki_[i]) * e);
+        const std::int32_t unclamped = p + (integral >> 8) + d;
+        const std::int16_t out = clamp(i, unclamped);
+        // Anti-windup: no integration further into a saturated output
+        if (!((unclamped > max_[i] && e > 0) || (unclamped < min_[i] && e < 0))) {
+            integral_[i] = integral;
+        }
+        out_[i] = out;
+    }
+};
+
+// Writes a frame of outputs to PWM or analog output pins with analogWrite(), a pin each, when a value changes
+template <std::uint8_t N>
+class AnalogOutputs {
+public:
+    explicit AnalogOutputs(const std::array<std::uint8_t, N>& output_pins) : pins(output_pins) {}
+
+    ramen::Pushable<ramen::Span<const std::int16_t>> in = [this](const ramen::Span<const std::int16_t>& values) {
+        const std::uint8_t n = (values.size() < N) ? static_cast<std::uint8_t>(values.size()) : N;
+        for (std::uint8_t i = 0; i < n; ++i) {
+            const std::int16_t value = (values[i] < 0) ? 0 : ((values[i] > 255) ? 255 : values[i]);
+            if (!written_[i] || value != last_[i]) {
+                analogWrite(pins[i], value);
+                last_[i] = value;
+                written_[i] = true;
+            }
+        }
+    };
+
+private:
+    const std::array<std::uint8_t, N> pins;
+    std::array<std::int16_t, N> last_{};
+    std::array<bool, N> written_{};
+};
+
+} // namespace pid
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "event_pool.hpp"
+#include <bits/functexcept.h>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Size-class pools behind the standard containers of avr-libstdcpp, so configuration-time structures can use
+// std::list, std::map or std::deque without malloc() fragmenting the small heap over a long uptime.
+//
+// The pools are the fixed-block pools of event_pool.hpp: declared statically, so their RAM is laid out by the linker
+// and shows up in the .bss of the build, and registered once in ascending block size. An allocation takes a block of
+// the smallest pool that fits and has one left; a block goes back to the pool whose storage holds it. Both are O(1),
+// a free-list pop or push after a scan over the MEMORY_POOL_CLASSES registered pools, and fixed blocks cannot
+// fragment.
+//
+//   memory_pool::Pool<8, 24> small_blocks;   // e.g. the nodes of a std::list<std::uint16_t>
+//   memory_pool::Pool<16, 16> node_blocks;   // e.g. the nodes of a std::map<std::uint8_t, std::uint16_t>
+//   void setup() { memory_pool::pools.add(small_blocks); memory_pool::pools.add(node_blocks); ... }
+//
+//   std::map<std::uint8_t, std::uint16_t, std::less<std::uint8_t>,
+//            memory_pool::Allocator<std::pair<const std::uint8_t, std::uint16_t>>> aliases;
+//
+// When no pool can serve a request, the handler of std::set_new_handler() is called as by operator new and the
+// request retried; without a handler std::__throw_bad_alloc() aborts (weak in avr-libstdcpp's functexcept.cc, so the
+// application may override it).
+//
+// With -D POOL_OPERATOR_NEW the global operator new and delete take their blocks from the same pools
+// (src/pool_allocator.cpp), so nothing in the firmware reaches malloc(). The pools must then be registered before the
+// first new, which rules out allocating in static constructors.
+
+#ifndef MEMORY_POOL_CLASSES
+#define MEMORY_POOL_CLASSES 4  // Pools the registry holds
+#endif
+
+namespace memory_pool {
+
+#if defined(POOL_OPERATOR_NEW)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+template <std::size_t BlockSize, std::uint8_t Count>
+using Pool = EventPool<BlockSize, Count>;
+
+inline PoolRegistry<MEMORY_POOL_CLASSES> pools;
+
+// A block of at least `size` bytes; does not return when the pools are exhausted and no new handler frees a block
+inline void* allocate(std::size_t size) {
+    for (;;) {
+        std::uint8_t pool_id = 0;
+        void* block = pools.allocate(size, pool_id);
+        if (block != nullptr) {
+            return block;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            std::__throw_bad_alloc();
+        }
+        handler();
+    }
+}
+
+// Returns a block from allocate(); false for a pointer no pool owns (nullptr included)
+inline bool release(void* block) { return block != nullptr && pools.release(block); }
+
+// Stateless std::allocator replacement over the pools; all instances compare equal
+template <typename T>
+class Allocator {
+public:
+    using value_type = T;
+
+    Allocator() = default;
+    template <typename U>
+    Allocator(const Allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) {
+            std::__throw_bad_alloc();
+        }
+        return static_cast<T*>(memory_pool::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t) noexcept { memory_pool::release(ptr); }
+};
+
+template <typename T, typename U>
+bool operator==(const Allocator<T>&, const Allocator<U>&) noexcept { return true; }
+
+template <typename T, typename U>
+bool operator!=(const Allocator<T>&, const Allocator<U>&) noexcept { return false; }
+
+} // namespace memory_pool
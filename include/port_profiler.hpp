@@ -0,0 +1,135 @@
+#pragma once
+#include "cycle_counter.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Per-port dispatch profiler.
+//
+// When the firmware is built with RAMEN_CFG_DISPATCH_HOOKS (and without PORT_PROFILER_DISABLE), every Event
+// invocation is timed with the cycle counter. Timings are inclusive: a dispatch that triggers further events
+// includes their cost. Results are kept per Event address in a small static table; ports beyond the table
+// capacity are counted in `overflowed()` but not timed. The 'profile' command prints the table.
+
+#ifndef PORT_PROFILER_SLOTS
+#define PORT_PROFILER_SLOTS 12
+#endif
+
+#ifndef PORT_PROFILER_MAX_DEPTH
+#define PORT_PROFILER_MAX_DEPTH 8
+#endif
+
+namespace port_profiler {
+
+#if defined(RAMEN_CFG_DISPATCH_HOOKS) && !defined(PORT_PROFILER_DISABLE)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+struct Entry {
+    const void* port = nullptr;
+    std::uint16_t count = 0;
+    std::uint32_t min_cycles = UINT32_MAX;
+    std::uint32_t max_cycles = 0;
+    std::uint32_t total_cycles = 0;
+
+    std::uint32_t avg_cycles() const { return count > 0 ? total_cycles / count : 0; }
+
+    // Times one dispatch. The average is that of the dispatches up to the first that would take count past 65535 or
+    // total_cycles past 2^32 - 1, about 4 ms a dispatch over a full count; later ones only move min and max
+    constexpr void add(std::uint32_t cycles) {
+        if (count < UINT16_MAX && total_cycles <= UINT32_MAX - cycles) {
+            ++count;
+            total_cycles += cycles;
+        }
+        if (cycles < min_cycles) {
+            min_cycles = cycles;
+        }
+        if (cycles > max_cycles) {
+            max_cycles = cycles;
+        }
+    }
+};
+
+namespace detail {
+
+// 70000 cycles a dispatch wraps a 32-bit sum after 61356 dispatches; the average must not
+constexpr bool average_survives_wrap() {
+    Entry e;
+    for (std::uint32_t i = 0; i < 65535U; ++i) {
+        e.add(70000UL);
+    }
+    return e.count == 61356U && e.total_cycles == 61356UL * 70000UL && e.total_cycles / e.count == 70000UL &&
+           e.max_cycles == 70000UL;
+}
+
+static_assert(average_survives_wrap(), "Entry::add() stops summing before total_cycles wraps");
+
+} // namespace detail
+
+class Profiler {
+public:
+    void begin(const void* port) {
+        if (depth_ < PORT_PROFILER_MAX_DEPTH) {
+            stack_[depth_] = cycle_counter::now();
+        }
+        ++depth_;
+        (void)port;
+    }
+
+    void end(const void* port) {
+        const std::uint32_t stop = cycle_counter::now();
+        if (depth_ == 0) {
+            return;
+        }
+        --depth_;
+        if (depth_ >= PORT_PROFILER_MAX_DEPTH) {
+            return;
+        }
+        Entry* entry = find_or_add(port);
+        if (entry == nullptr) {
+            if (overflowed_ < UINT16_MAX) {
+                ++overflowed_;
+            }
+            return;
+        }
+        entry->add(stop - stack_[depth_]);
+    }
+
+    void reset() {
+        for (Entry& e : entries_) {
+            e = Entry{};
+        }
+        last_ = nullptr;
+        overflowed_ = 0;
+    }
+
+    const std::array<Entry, PORT_PROFILER_SLOTS>& entries() const { return entries_; }
+    std::uint16_t overflowed() const { return overflowed_; }
+
+private:
+    Entry* find_or_add(const void* port) {
+        if (last_ != nullptr && last_->port == port) {
+            return last_;
+        }
+        for (Entry& e : entries_) {
+            if (e.port == port || e.port == nullptr) {
+                e.port = port;
+                last_ = &e;
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    std::array<Entry, PORT_PROFILER_SLOTS> entries_{};
+    std::array<std::uint32_t, PORT_PROFILER_MAX_DEPTH> stack_{};
+    Entry* last_ = nullptr;
+    std::uint8_t depth_ = 0;
+    std::uint16_t overflowed_ = 0;
+};
+
+inline Profiler profiler;
+
+} // namespace port_profiler
@@ -0,0 +1,96 @@
+#pragma once
+#include "cycle_counter.hpp"
+#include "ring_buffer.hpp"
+#include "xmem.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Port-level event trace, for following a message through the network (SerialCollectorActor -> CommandParserActor
+// -> LedExecutorActor -> TimerActor) and finding where a chain of dispatches spends its time.
+//
+// Through the ramen hooks (src/ramen_hooks.cpp), every Event invocation and every behavior it runs appends a Record to
+// a static ring buffer, overwriting the oldest when full: the cycle count, the address of the port, whether the
+// dispatch or trigger begins or ends, and for a dispatch the size of its arguments. Begin and end records nest, so
+// the trace shows which behaviors each dispatch ran and what they dispatched in turn. The 'ptrace' command prints the
+// buffer as text, which tools/port_trace_export.py turns into Chrome trace JSON for chrome://tracing or Perfetto,
+// naming the ports after the objects of the ELF they belong to.
+//
+// Opt-in with -D PORT_TRACE, together with -D RAMEN_CFG_DISPATCH_HOOKS and, to record behaviors as well,
+// -D RAMEN_CFG_TRIGGER_HOOKS. A record is 8 bytes on the ATmega2560; PORT_TRACE_CAPACITY sets how many are kept, in
+// external SRAM with -D XMEM.
+
+#ifndef PORT_TRACE_CAPACITY
+#define PORT_TRACE_CAPACITY 64
+#endif
+
+namespace port_trace {
+
+#if defined(PORT_TRACE)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+#if defined(PORT_TRACE) && !defined(RAMEN_CFG_DISPATCH_HOOKS)
+#error "PORT_TRACE records through the ramen dispatch hooks; build with -D RAMEN_CFG_DISPATCH_HOOKS as well"
+#endif
+
+// Also the letter of the record in the 'ptrace' output
+enum Kind : std::uint8_t { DISPATCH_BEGIN = 'D', DISPATCH_END = 'd', TRIGGER_BEGIN = 'T', TRIGGER_END = 't' };
+
+struct Record {
+    std::uint32_t cycles;
+    std::uintptr_t port;
+    Kind kind;
+    std::uint8_t payload_size;  // Of a DISPATCH_BEGIN, saturated at 255
+};
+
+#if defined(PORT_TRACE) && defined(XMEM)
+// In external SRAM, where PORT_TRACE_CAPACITY can be thousands of records (see xmem.hpp)
+inline ramen::RingBuffer<Record, PORT_TRACE_CAPACITY>& records =
+    xmem::place<ramen::RingBuffer<Record, PORT_TRACE_CAPACITY>>();
+#elif defined(PORT_TRACE)
+inline ramen::RingBuffer<Record, PORT_TRACE_CAPACITY> records;
+#endif
+#if defined(PORT_TRACE)
+inline std::uint16_t overwritten = 0;
+inline bool paused = false;
+#endif
+
+inline void record(Kind kind, const void* port, std::size_t payload_size = 0) {
+#if defined(PORT_TRACE)
+    if (paused) {
+        return;
+    }
+    if (records.full() && overwritten < UINT16_MAX) {
+        ++overwritten;
+    }
+    const std::uint8_t size = static_cast<std::uint8_t>((payload_size > 0xFFU) ? 0xFFU : payload_size);
+    records.push_overwrite(Record{cycle_counter::now(), reinterpret_cast<std::uintptr_t>(port), kind, size});
+#else
+    (void)kind;
+    (void)port;
+    (void)payload_size;
+#endif
+}
+
+inline void clear() {
+#if defined(PORT_TRACE)
+    records.clear();
+    overwritten = 0;
+#endif
+}
+
+// Stops recording while it lives, e.g. while the buffer is printed, which dispatches events of its own
+class Pause {
+public:
+#if defined(PORT_TRACE)
+    Pause() : was_paused_(paused) { paused = true; }
+    ~Pause() { paused = was_paused_; }
+
+private:
+    bool was_paused_;
+#endif
+};
+
+} // namespace port_trace
@@ -0,0 +1,216 @@
+#pragma once
+#include "fast_pin.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// PLC-style process image. Pins are registered once as inputs or outputs; each scan of loop() then
+//   1. read_inputs()     copies the input pins of every port into the image with one PINx read per port,
+//   2. runs the actors, which read input() and write() bits of the image only,
+//   3. commit_outputs()  writes the changed output bits of each port with one masked PORTx write.
+// Actors therefore see inputs that do not change during a scan, and outputs that several actors set in the same
+// scan change together.
+//
+//     process_image::ProcessImage image;
+//     void setup() { image.add_input(CONTROLLINO_IN0); image.add_output(CONTROLLINO_D0); }
+//     void loop()  { image.read_inputs(); ...; image.commit_outputs(); }
+//
+// Only pins of the ATmega2560 pin table in fast_pin.hpp can be registered. Off AVR the image goes through
+// digitalRead/digitalWrite pin by pin.
+
+namespace process_image {
+
+using gpio::detail::Port;
+using PortBits = std::array<std::uint8_t, gpio::detail::PORT_COUNT>;
+
+// Output bits forced from interrupt context (see interlock.hpp). While a bit is forced, commits leave it at its forced
+// level; once released, the next commit writes the image's level to it again. Written with interrupts disabled, or
+// from an interrupt.
+struct Override {
+    PortBits clear{};   // Forced low
+    PortBits set{};     // Forced high
+    PortBits resync{};  // Released, to be rewritten by the next commit
+};
+inline Override forced;
+
+class ProcessImage {
+public:
+    // Registers an input pin; false if the pin is not in the pin table
+    bool add_input(std::uint8_t pin, bool pullup = false) {
+        std::uint8_t port = 0;
+        std::uint8_t mask = 0;
+        if (!locate(pin, port, mask)) {
+            return false;
+        }
+        pinMode(pin, pullup ? INPUT_PULLUP : INPUT);
+        in_mask_[port] |= mask;
+        out_mask_[port] &= static_cast<std::uint8_t>(~mask);
+        return true;
+    }
+
+    // Registers an output pin, driven to `initial` at once; false if the pin is not in the pin table
+    bool add_output(std::uint8_t pin, bool initial = false) {
+        std::uint8_t port = 0;
+        std::uint8_t mask = 0;
+        if (!locate(pin, port, mask)) {
+            return false;
+        }
+        digitalWrite(pin, initial ? HIGH : LOW);  // Also detaches PWM
+        pinMode(pin, OUTPUT);
+        out_mask_[port] |= mask;
+        in_mask_[port] &= static_cast<std::uint8_t>(~mask);
+        set_bits(out_, port, mask, initial);
+        set_bits(committed_, port, mask, initial);
+        return true;
+    }
+
+    // Start of a scan
+    void read_inputs() {
+        for (std::uint8_t port = 0; port < gpio::detail::PORT_COUNT; ++port) {
+            if (in_mask_[port] != 0) {
+                in_[port] = read_port(port) & in_mask_[port];
+            }
+        }
+    }
+
+    // End of a scan; returns the number of ports written
+    std::uint8_t commit_outputs() {
+        std::uint8_t written = 0;
+        for (std::uint8_t port = 0; port < gpio::detail::PORT_COUNT; ++port) {
+            std::uint8_t changed = static_cast<std::uint8_t>(out_[port] ^ committed_[port]);
+            if (forced.resync[port] != 0) {
+                changed |= take_resync(port);
+            }
+            changed &= out_mask_[port];
+            if (changed != 0) {
+                write_port(port, changed);
+                committed_[port] = out_[port];
+                ++written;
+            }
+        }
+        return written;
+    }
+
+    // Input level as of the last read_inputs(); false for pins that are not registered inputs
+    bool input(std::uint8_t pin) const {
+        std::uint8_t port = 0;
+        std::uint8_t mask = 0;
+        return locate(pin, port, mask) && (in_[port] & mask) != 0;
+    }
+
+    // Output level to be committed; writes to pins that are not registered outputs are ignored
+    void write(std::uint8_t pin, bool level) {
+        std::uint8_t port = 0;
+        std::uint8_t mask = 0;
+        if (locate(pin, port, mask) && (out_mask_[port] & mask) != 0) {
+            set_bits(out_, port, mask, level);
+        }
+    }
+
+    // Whether a pin is registered as an input, or as an output
+    bool is_input(std::uint8_t pin) const {
+        std::uint8_t port = 0;
+        std::uint8_t mask = 0;
+        return locate(pin, port, mask) && (in_mask_[port] & mask) != 0;
+    }
+
+    bool is_output(std::uint8_t pin) const {
+        std::uint8_t port = 0;
+        std::uint8_t mask = 0;
+        return locate(pin, port, mask) && (out_mask_[port] & mask) != 0;
+    }
+
+    // The input bits of a port index (0..10, A..L) as of the last read_inputs(), for logic over whole bytes
+    std::uint8_t input_bits(std::uint8_t port) const { return in_[port]; }
+
+    // Output levels of the bits of `mask` on a port index; bits that are not registered outputs are ignored
+    void write_bits(std::uint8_t port, std::uint8_t mask, std::uint8_t levels) {
+        mask &= out_mask_[port];
+        out_[port] = static_cast<std::uint8_t>((out_[port] & ~mask) | (levels & mask));
+    }
+
+    bool output(std::uint8_t pin) const {
+        std::uint8_t port = 0;
+        std::uint8_t mask = 0;
+        return locate(pin, port, mask) && (out_[port] & mask) != 0;
+    }
+
+private:
+    PortBits in_{};
+    PortBits out_{};
+    PortBits in_mask_{};
+    PortBits out_mask_{};
+    PortBits committed_{};  // Output bits as last written to the port
+
+    static bool locate(std::uint8_t pin, std::uint8_t& port, std::uint8_t& mask) {
+        const Port p = gpio::detail::pin_port(pin);
+        if (p == Port::NONE) {
+            return false;
+        }
+        port = static_cast<std::uint8_t>(static_cast<std::uint8_t>(p) - 1U);
+        mask = static_cast<std::uint8_t>(1U << gpio::detail::pin_bit(pin));
+        return true;
+    }
+
+    static void set_bits(PortBits& bits, std::uint8_t port, std::uint8_t mask, bool set) {
+        bits[port] = set ? (bits[port] | mask) : (bits[port] & static_cast<std::uint8_t>(~mask));
+    }
+
+    static std::uint8_t take_resync(std::uint8_t port) {
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+#endif
+        const std::uint8_t bits = forced.resync[port];
+        forced.resync[port] = 0;
+#if defined(__AVR__)
+        SREG = sreg;
+#endif
+        return bits;
+    }
+
+#if defined(__AVR__) && defined(PORTA)
+    static std::uint8_t read_port(std::uint8_t port) {
+        return *gpio::detail::port_register(port, true);
+    }
+
+    // One read-modify-write of PORTx; interrupts are held off so that ISRs writing other bits of the port are not lost
+    void write_port(std::uint8_t port, std::uint8_t changed) const {
+        volatile std::uint8_t* reg = gpio::detail::port_register(port, false);
+        const std::uint8_t sreg = SREG;
+        cli();
+        const std::uint8_t levels = static_cast<std::uint8_t>((*reg & ~changed) | (out_[port] & changed));
+        *reg = static_cast<std::uint8_t>((levels & ~forced.clear[port]) | forced.set[port]);
+        SREG = sreg;
+    }
+#else
+    std::uint8_t read_port(std::uint8_t port) const {
+        std::uint8_t bits = 0;
+        for (std::uint8_t pin = 0; pin < gpio::detail::PIN_COUNT; ++pin) {
+            std::uint8_t p = 0;
+            std::uint8_t mask = 0;
+            if (locate(pin, p, mask) && p == port && (in_mask_[port] & mask) != 0 && digitalRead(pin)) {
+                bits |= mask;
+            }
+        }
+        return bits;
+    }
+
+    void write_port(std::uint8_t port, std::uint8_t changed) const {
+        changed &= static_cast<std::uint8_t>(~(forced.clear[port] | forced.set[port]));
+        for (std::uint8_t pin = 0; pin < gpio::detail::PIN_COUNT; ++pin) {
+            std::uint8_t p = 0;
+            std::uint8_t mask = 0;
+            if (locate(pin, p, mask) && p == port && (changed & mask) != 0) {
+                digitalWrite(pin, (out_[port] & mask) ? HIGH : LOW);
+            }
+        }
+    }
+#endif
+};
+
+} // namespace process_image
@@ -155,13 +155,15 @@
 ///         (`Function() noexcept = default;`), making it default-constructible (but potentially in an
 ///         uninitialized/invalid state until assigned). The original `Function` was not
 ///         default-constructible to ensure it was always valid upon construction.
-///     *   **State Management in Move Operations:** The AVR port explicitly nullifies `call_`,
-///         `dtor_`, and `move_` pointers in the moved-from `Function` object to prevent
-///         double-frees or calls on invalid objects.
+///     *   **State Management in Move Operations:** The AVR port explicitly nullifies the `ops_`
+///         pointer in the moved-from `Function` object to prevent double-frees or calls on invalid objects.
+///     *   **Ops Table:** Instead of three function pointers per instance (`call_`, `dtor_`, `move_`), the AVR port
+///         stores one pointer to a per-target-type `detail::FunctionOps` table. Trivially destructible targets
+///         have no destructor entry and trivially copyable targets are relocated with `memcpy`.
 ///     *   **`is_valid_target_v`:** The AVR port consistently uses `is_valid_target_v` (a `static constexpr bool`)
 ///         for SFINAE checks, which is common in pre-C++20 SFINAE.
 ///     *   **`explicit operator bool()`:** Added to check if the `Function` is initialized.
-///     *   **Error Handling:** The `operator()` in the AVR port includes an `assert(call_ != nullptr)`
+///     *   **Error Handling:** The `operator()` in the AVR port includes an `assert(ops_ != nullptr)`
 ///         to catch calls on uninitialized or moved-from functions.
 ///
 /// 3.  **`ListNode` Class:**
@@ -188,10 +190,9 @@
 ///         The AVR port's direct invocation simply calls `fun_(args...)`.
 ///
 /// 5.  **`Event` Class:**
-///     *   **`operator>>` (Linking):** The AVR port's `clusterize` call within `operator>>`
-///         gets the head of the list explicitly: `static_cast<detail::ListNode<...>*>(this)->head()->template clusterize<2>(...)`.
-///         It also includes a comment about the potential performance cost of `clusterize` on AVR
-///         and suggests conditional removal if complex event chaining isn't used.
+///     *   **`operator>>` (Linking):** Instead of merging and then running `clusterize<2>` over the whole topic,
+///         the AVR port splices the incoming list in at the Event/Behavior segment boundaries
+///         (`ListNode::merge_partitioned`), so the ordering guarantee holds without rescanning the topic.
 ///     *   **Invocation `operator()`:** Iterates using `const detail::ListNode<...>*` and
 ///         `static_cast` to call `trigger` on `Triggerable` objects.
 ///
@@ -202,6 +203,8 @@
 ///     *   Utility components like `PushUnary`, `PullUnary`, `PullNary` in the AVR port often
 ///         cap the `Footprint` passed to their internal `Pushable`/`Pullable` members, e.g.,
 ///         `Footprint<(fp < 64) ? fp : 64>`. This is a hard cap to limit memory usage on AVR.
+///     *   `make_pushable`, `make_pullable` and `make_responder` deduce the footprint from the closure they are
+///         given, and `this_footprint` fits a `[this]` lambda or `bind()`, so a behavior reserves no more than it holds.
 ///
 /// 7.  **Utility Components (`Latch`, `Lift`, `PushUnary`, `PullUnary`, `PullNary`):**
 ///     *   Constructors consistently use `std::enable_if_t` for SFINAE.
@@ -235,6 +238,37 @@
 /// `std::enable_if_t`. It also makes some minor adjustments to logic and error handling for
 /// resource-constrained environments.
 ///
+/// Extensions specific to this port (not present upstream):
+///
+///     *   `FlatPusher<capacity, T...>`: a Pusher whose topic can be frozen into a contiguous table of behavior
+///         thunks after linking, replacing the per-node pointer chase and virtual `trigger` call on dispatch.
+///     *   `DirectPusher<T...>`: a Pusher that calls the behavior of a single-subscriber topic directly.
+///     *   `KeyedPusher<Key, T, N>`: a demultiplexer with one DirectPusher per key, routing a message to the
+///         subscribers of its key by indexing.
+///     *   `MemberPushable<&C::method, T...>` / `MemberPullable`: behaviors bound to a member function at compile
+///         time, holding only the object pointer and calling the method directly from `trigger`.
+///     *   Ordered linking: `Event::operator>>` keeps topics partitioned into an Event segment followed by a Behavior
+///         segment in priority order as links are added, replacing the `clusterize<2>` pass over the whole topic on
+///         every link.
+///     *   `Function` keeps a single pointer to a per-target-type ops table instead of three function pointers.
+///     *   `Event::sent()`: a 16-bit saturating count of the invocations of every Event (Pusher, Puller).
+///     *   `RAMEN_CFG_DISPATCH_STATS`: opt-in tracking of the synchronous dispatch nesting depth and its maximum.
+///     *   `RAMEN_CFG_DISPATCH_HOOKS`: opt-in `hooks::dispatch_begin/end` calls around every Event invocation.
+///     *   `RAMEN_CFG_TRIGGER_HOOKS`: opt-in `hooks::trigger_begin/end` calls around every Behavior it triggers.
+///     *   `PushDistinct`, `DistinctLatch`, `DistinctLift`: change-detecting operators with an optional deadband.
+///     *   `Memoized`, `CachedPullUnary`, `CachedPullNary`: pull nodes evaluated at most once per scan epoch.
+///     *   `Span<T>` batch ports and the `SpanSplit` adapter: N samples per dispatch instead of one.
+///     *   `pass_t<T>`: Pushers and Pushables of small trivially copyable types pass them by value, not by const reference.
+///     *   `Event::link(behavior, priority)`: priority-ordered fan-out resolved at link time. A behavior's priority is
+///         folded into its `key()` (1 + priority; Events stay 0), costing one byte per behavior.
+///     *   `Event<R(A...)>` (declared but not defined upstream) folds the results of a topic with a combiner;
+///         `Query<Combiner, R, T...>` and `Responder<R, T...>` are its Pusher/Pushable counterparts.
+///     *   `ListNode` is circular backwards (the head's `prev_` is the tail), so `head()`/`tail()` are O(1) at the ends
+///         of a list and linking no longer walks the destination topic to find its tail.
+///     *   `bind<&C::method>(object)`: a constant-initializable target for `Function` and behaviors. Unlinked ports,
+///         empty Functions and behaviors built from bound methods have constexpr constructors, so actors made of them
+///         are placed in .data at build time instead of being constructed from `__do_global_ctors`.
+///
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -245,6 +279,10 @@
 #include <utility>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <limits>
 #include <algorithm> // For std::min/max if used, though not directly by RAMEN core
 #include <type_traits>
 
@@ -273,6 +311,106 @@ struct Event;
 
 constexpr std::size_t default_behavior_footprint = sizeof(void*) * 2;
 
+/// Link priority of a behavior within its topic (see Event::link): higher priorities are triggered first.
+using link_priority_t = std::uint8_t;
+
+/// How a Pusher/Pushable passes a message of type T. Small trivially copyable types (no larger than a pointer, e.g.
+/// bytes, bools and single-byte event structs) are passed by value so that they travel in registers through the
+/// Function thunk and the virtual trigger; everything else is passed by const reference. Explicit reference types
+/// (`Pusher<const BaseEvent&>`) are passed unchanged.
+constexpr std::size_t pass_by_value_max_size = sizeof(void*);
+template <typename T>
+using pass_t = std::conditional_t<!std::is_reference_v<T> && std::is_trivially_copyable_v<T> &&
+                                      (sizeof(T) <= pass_by_value_max_size),
+                                  T, const T&>;
+
+/// Opt-in instrumentation: when RAMEN_CFG_DISPATCH_STATS is defined, every Event invocation maintains the current
+/// nesting depth of synchronous dispatch and its high-water mark. Without the macro the guard is an empty object.
+namespace detail
+{
+struct DispatchDepthGuard
+{
+#if defined(RAMEN_CFG_DISPATCH_STATS)
+    static inline std::uint8_t current = 0;
+    static inline std::uint8_t peak    = 0;
+
+    DispatchDepthGuard() noexcept
+    {
+        ++current;
+        if (current > peak) { peak = current; }
+    }
+    ~DispatchDepthGuard() noexcept { --current; }
+#endif
+};
+} // namespace detail
+
+/// Opt-in dispatch hooks: when RAMEN_CFG_DISPATCH_HOOKS is defined, every Event invocation calls
+/// hooks::dispatch_begin() and hooks::dispatch_end() with the address of the invoked Event; dispatch_begin() also gets
+/// the size of the arguments, sizeof of each (the referenced type for a reference). When RAMEN_CFG_TRIGGER_HOOKS is
+/// defined, hooks::trigger_begin() and hooks::trigger_end() likewise bracket each behavior an Event runs, with the
+/// address of its Triggerable; behaviors in the table of a frozen FlatPusher are called without them. The application
+/// must provide the definitions (see src/ramen_hooks.cpp); this is how profilers and tracers attach to the network.
+#if defined(RAMEN_CFG_DISPATCH_HOOKS)
+namespace hooks
+{
+void dispatch_begin(const void* port, std::size_t payload_size) noexcept;
+void dispatch_end(const void* port) noexcept;
+} // namespace hooks
+#endif
+#if defined(RAMEN_CFG_TRIGGER_HOOKS)
+namespace hooks
+{
+void trigger_begin(const void* behavior) noexcept;
+void trigger_end(const void* behavior) noexcept;
+} // namespace hooks
+#endif
+
+namespace detail
+{
+template <typename... A>
+constexpr std::size_t payload_size = (std::size_t{0} + ... + sizeof(A));
+
+struct DispatchHookGuard
+{
+#if defined(RAMEN_CFG_DISPATCH_HOOKS)
+    DispatchHookGuard(const void* const port, const std::size_t payload) noexcept : port_(port)
+    {
+        hooks::dispatch_begin(port_, payload);
+    }
+    ~DispatchHookGuard() noexcept { hooks::dispatch_end(port_); }
+    const void* port_;
+#else
+    constexpr DispatchHookGuard(const void* const, const std::size_t) noexcept {}
+#endif
+};
+
+struct TriggerHookGuard
+{
+#if defined(RAMEN_CFG_TRIGGER_HOOKS)
+    explicit TriggerHookGuard(const void* const behavior) noexcept : behavior_(behavior)
+    {
+        hooks::trigger_begin(behavior_);
+    }
+    ~TriggerHookGuard() noexcept { hooks::trigger_end(behavior_); }
+    const void* behavior_;
+#else
+    explicit constexpr TriggerHookGuard(const void* const) noexcept {}
+#endif
+};
+} // namespace detail
+
+#if defined(RAMEN_CFG_DISPATCH_STATS)
+constexpr bool dispatch_stats_enabled = true;
+inline std::uint8_t dispatch_depth() noexcept { return detail::DispatchDepthGuard::current; }
+inline std::uint8_t max_dispatch_depth() noexcept { return detail::DispatchDepthGuard::peak; }
+inline void reset_max_dispatch_depth() noexcept { detail::DispatchDepthGuard::peak = detail::DispatchDepthGuard::current; }
+#else
+constexpr bool dispatch_stats_enabled = false;
+inline std::uint8_t dispatch_depth() noexcept { return 0; }
+inline std::uint8_t max_dispatch_depth() noexcept { return 0; }
+inline void reset_max_dispatch_depth() noexcept {}
+#endif
+
 namespace detail
 {
     // Helper for SFINAE on ListNode's variadic constructor
@@ -337,14 +475,76 @@ struct IsValidTarget<X_Sig, x_fp, x_al, Function<Y_Sig, y_fp, y_al>> : std::fals
 
 } // namespace detail
 
+namespace detail
+{
+/// The type-erased operations of a Function target. One instance exists per target type (not per Function),
+/// so a Function carries a single pointer to it. A null dtor means the target is trivially destructible;
+/// a null move means it is trivially copyable and is relocated with memcpy.
+template <typename R, typename... A>
+struct FunctionOps
+{
+    R (*call)(void*, A...);
+    void (*dtor)(void*) noexcept;
+    void (*move)(void*, void*) noexcept;
+};
+
+template <typename T, typename R, typename... A>
+struct FunctionOpsFor
+{
+    static R call(void* const ptr, A... args) { return (*static_cast<T*>(ptr))(args...); }
+    static void dtor(void* const ptr) noexcept { static_cast<T*>(ptr)->~T(); }
+    static void move(void* const dst, void* const src) noexcept
+    {
+        new (dst) T(std::move(*static_cast<T*>(src)));
+        static_cast<T*>(src)->~T();
+    }
+
+    static constexpr FunctionOps<R, A...> value{
+        &call,
+        std::is_trivially_destructible_v<T> ? nullptr : &dtor,
+        std::is_trivially_copyable_v<T> ? nullptr : &move,
+    };
+};
+
+/// The ops of a bound method: the Function holds only the object pointer, which is trivially copyable.
+template <auto Method, typename C, typename R, typename... A>
+struct MethodOpsFor
+{
+    static R call(void* const ptr, A... args) { return (static_cast<C*>(*static_cast<void**>(ptr))->*Method)(args...); }
+
+    static constexpr FunctionOps<R, A...> value{&call, nullptr, nullptr};
+};
+} // namespace detail
+
+/// A member function bound to its object; see bind().
+template <auto Method, typename C>
+struct BoundMethod
+{
+    C* object;
+};
+
+/// Binds `Method` to `object` as the target of a Function, Pushable or Pullable, e.g.
+/// `ramen::Pushable<int> in = ramen::bind<&Actor::on_value>(this);`. Unlike a lambda, whose bytes are copied into
+/// the Function at run time, a bound method is a constant expression, so an actor whose ports are built this way
+/// (and whose constructors are otherwise constexpr) is constant-initialized into .data with no constructor code.
+template <auto Method, typename C>
+constexpr BoundMethod<Method, C> bind(C* const object) noexcept
+{
+    return BoundMethod<Method, C>{object};
+}
+
 template <typename R, typename... A, std::size_t footprint, std::size_t alignment>
 class Function<R(A...), footprint, alignment> final : public Callable<R(A...)>
 {
     template <typename, std::size_t, std::size_t>
     friend class Function;
+    template <typename, std::size_t, bool>
+    friend struct Behavior;
 
     static_assert((alignment > 0) && ((alignment & (alignment - 1)) == 0), "alignment must be a power of 2");
 
+    using Ops = detail::FunctionOps<R, A...>;
+
 public:
     template <typename F, typename T = std::decay_t<F>>
     static constexpr bool is_valid_target_v = detail::IsValidTarget<R(A...), footprint, alignment, T>::value;
@@ -354,35 +554,25 @@ public:
     {
         construct(std::forward<F>(fun));
     }
-    
-    Function() noexcept = default;
 
-    Function(const Function& that) = delete;
-    Function(Function&& that) noexcept : call_(that.call_), dtor_(that.dtor_), move_(that.move_)
+    template <auto Method, typename C>
+    constexpr Function(const BoundMethod<Method, C> bound) noexcept
+        : fun_{const_cast<void*>(static_cast<const void*>(bound.object))},
+          ops_{&detail::MethodOpsFor<Method, C, R, A...>::value}
     {
-        if (move_ != nullptr)
-        {
-            move_(fun_.data(), that.fun_.data());
-            that.call_ = nullptr;
-            that.dtor_ = nullptr;
-            that.move_ = nullptr;
-        }
+        static_assert(std::is_invocable_r_v<R, decltype(Method), C*, A...>, "Bound method has the wrong signature");
     }
 
+    constexpr Function() noexcept = default;
+
+    Function(const Function& that) = delete;
+    Function(Function&& that) noexcept { take(std::move(that)); }
+
     template <std::size_t foot2, std::size_t align2>
     Function(Function<R(A...), foot2, align2>&& that,
-             std::enable_if_t<(foot2 <= footprint) && (align2 <= alignment), int> = 0) noexcept :
-        call_(that.call_),
-        dtor_(that.dtor_),
-        move_(that.move_)
+             std::enable_if_t<(foot2 <= footprint) && (align2 <= alignment), int> = 0) noexcept
     {
-        if (move_ != nullptr)
-        {
-            move_(fun_.data(), that.fun_.data());
-            that.call_ = nullptr;
-            that.dtor_ = nullptr;
-            that.move_ = nullptr;
-        }
+        take(std::move(that));
     }
 
     Function& operator=(const Function& that) = delete;
@@ -407,62 +597,75 @@ public:
     std::enable_if_t<is_valid_target_v<F>, Function&>
     operator=(F&& fun) noexcept
     {
-        if (dtor_ != nullptr) destroy();
+        destroy();
         construct(std::forward<F>(fun));
         return *this;
     }
 
-    explicit operator bool() const noexcept { return call_ != nullptr; }
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
 
     R operator()(A... args) const override {
-        assert(call_ != nullptr && "Function not initialized or moved from");
-        return call_(fun_.data(), args...);
+        assert(ops_ != nullptr && "Function not initialized or moved from");
+        return ops_->call(fun_.bytes.data(), args...);
     }
 
-    ~Function() noexcept { if (dtor_ != nullptr) destroy(); }
+    ~Function() noexcept { destroy(); }
 
 private:
     template <typename F, typename T_target = std::decay_t<F>>
     std::enable_if_t<detail::IsValidTarget<R(A...), footprint, alignment, T_target>::value>
     construct(F&& fun) noexcept
     {
-        call_ = [](void* const ptr, A... args) -> R { return (*static_cast<T_target*>(ptr))(args...); };
-        dtor_ = [](void* const ptr) noexcept { static_cast<T_target*>(ptr)->~T_target(); };
-        move_ = [](void* const dst, void* const src) noexcept { new (dst) T_target(std::move(*static_cast<T_target*>(src))); };
         static_assert((sizeof(T_target) <= footprint) && (alignof(T_target) <= alignment), "Function target too large");
-        new (fun_.data()) T_target(std::forward<F>(fun));
+        new (fun_.bytes.data()) T_target(std::forward<F>(fun));
+        ops_ = &detail::FunctionOpsFor<T_target, R, A...>::value;
     }
 
     void destroy() noexcept
     {
-        assert(dtor_ != nullptr);
-        dtor_(fun_.data());
-        dtor_ = nullptr;
-        call_ = nullptr;
-        move_ = nullptr;
+        if ((ops_ != nullptr) && (ops_->dtor != nullptr))
+        {
+            ops_->dtor(fun_.bytes.data());
+        }
+        ops_ = nullptr;
     }
 
+    /// Relocates the target of `that` into this (empty) Function and leaves `that` empty.
     template <std::size_t foot2, std::size_t align2>
-    std::enable_if_t<(foot2 <= footprint) && (align2 <= alignment)>
-    assign(Function<R(A...), foot2, align2>&& that) noexcept
+    void take(Function<R(A...), foot2, align2>&& that) noexcept
     {
-        if (dtor_ != nullptr) destroy();
-        call_ = that.call_;
-        dtor_ = that.dtor_;
-        move_ = that.move_;
-        if (move_ != nullptr)
+        ops_ = that.ops_;
+        if (ops_ != nullptr)
         {
-            move_(fun_.data(), that.fun_.data());
-            that.call_ = nullptr;
-            that.dtor_ = nullptr;
-            that.move_ = nullptr;
+            if (ops_->move != nullptr)
+            {
+                ops_->move(fun_.bytes.data(), that.fun_.bytes.data());
+            }
+            else
+            {
+                std::memcpy(&fun_, &that.fun_, sizeof(that.fun_));
+            }
+            that.ops_ = nullptr;
         }
     }
 
-    alignas(alignment) mutable std::array<unsigned char, footprint> fun_;
-    R (*call_)(void*, A...)              = nullptr;
-    void (*dtor_)(void*) noexcept        = nullptr;
-    void (*move_)(void*, void*) noexcept = nullptr;
+    template <std::size_t foot2, std::size_t align2>
+    std::enable_if_t<(foot2 <= footprint) && (align2 <= alignment)>
+    assign(Function<R(A...), foot2, align2>&& that) noexcept
+    {
+        destroy();
+        take(std::move(that));
+    }
+
+    /// The target, or the object of a bound method; a union so that the latter can be constant-initialized.
+    union Storage
+    {
+        void*                                object;
+        std::array<unsigned char, footprint> bytes;
+    };
+
+    alignas(alignment) mutable Storage fun_{nullptr};
+    const Ops* ops_ = nullptr;
 };
 
 // ====================================================================================================================
@@ -474,7 +677,7 @@ class ListNode : public T
 {
 public:
     template <typename... Args>
-    ListNode(Args&&... args,
+    constexpr ListNode(Args&&... args,
              std::enable_if_t<
                  detail::is_valid_listnode_forwarding_constructor_args<ListNode<T>, Args...>::value,
                  int
@@ -485,12 +688,7 @@ public:
     ListNode(ListNode&& that) noexcept(std::is_nothrow_move_constructible_v<T>)
         : T(std::move(static_cast<T&>(that)))
     {
-        prev_ = that.prev_;
-        next_ = that.next_;
-        if (prev_ != nullptr) { prev_->next_ = this; }
-        if (next_ != nullptr) { next_->prev_ = this; }
-        that.prev_ = nullptr;
-        that.next_ = nullptr;
+        take_links(that);
     }
     ListNode& operator=(const ListNode&) = delete;
     ListNode& operator=(ListNode&& that) noexcept(std::is_nothrow_move_assignable_v<T>)
@@ -499,12 +697,7 @@ public:
         {
             static_cast<T&>(*this) = std::move(static_cast<T&>(that));
             remove(); // remove this from its current list before taking over that's links
-            prev_ = that.prev_;
-            next_ = that.next_;
-            if (prev_ != nullptr) { prev_->next_ = this; }
-            if (next_ != nullptr) { next_->prev_ = this; }
-            that.prev_ = nullptr;
-            that.next_ = nullptr;
+            take_links(that);
         }
         return *this;
     }
@@ -513,31 +706,27 @@ public:
     constexpr const ListNode* next() const noexcept { return next_; } // Const version
     ListNode* next() noexcept { return next_; } // Non-const version
 
+    /// The list is null-terminated forwards but circular backwards: the prev_ link of the head points to the tail.
+    /// A node is therefore the head iff it is unlinked or its predecessor does not link forward to it.
+    constexpr bool is_head() const noexcept { return (prev_ == nullptr) || (prev_->next_ != this); }
+
+    /// O(1) when called on the head or the tail; from an interior node, walks back to the head.
     ListNode* head() noexcept
     {
         ListNode* p = this;
-        while (p->prev_ != nullptr) { p = p->prev_; }
-        return p;
-    }
-    const ListNode* head() const noexcept // Const version
-    {
-        const ListNode* p = this;
-        while (p->prev_ != nullptr) { p = p->prev_; }
+        while (!p->is_head()) { p = p->prev_; }
         return p;
     }
+    const ListNode* head() const noexcept { return const_cast<ListNode*>(this)->head(); } // Const version
 
+    /// O(1) when called on the head or the tail; from an interior node, walks back to the head.
     ListNode* tail() noexcept
     {
-        ListNode* p = this;
-        while (p->next_ != nullptr) { p = p->next_; }
-        return p;
-    }
-     const ListNode* tail() const noexcept // Const version
-    {
-        const ListNode* p = this;
-        while (p->next_ != nullptr) { p = p->next_; }
-        return p;
+        if (next_ == nullptr) { return this; }
+        ListNode* const h = head();
+        return h->prev_; // A linked head always has a distinct tail.
     }
+    const ListNode* tail() const noexcept { return const_cast<ListNode*>(this)->tail(); } // Const version
 
 
     void merge(ListNode* const that) noexcept
@@ -548,13 +737,93 @@ public:
             ListNode* const this_head_ptr = this->head(); // Use different name
             if (this_head_ptr != that_head)
             {
-                ListNode* const this_tail_ptr = this->tail(); // Use different name
+                ListNode* const this_tail_ptr = this_head_ptr->tail();
+                ListNode* const that_tail     = that_head->tail();
                 this_tail_ptr->next_          = that_head;
-                that_head->prev_          = this_tail_ptr;
+                that_head->prev_              = this_tail_ptr;
+                this_head_ptr->prev_          = that_tail;
             }
         }
     }
 
+    /// Merges the list of `that` into this list, assuming both are partitioned into a front segment
+    /// (nodes for which is_front() holds) followed by a back segment ordered by descending rank(), and keeping the
+    /// result so: the front segment of `that` goes before the head of this list, and the back segments are merged
+    /// by rank, the nodes of this list first among equal ranks. The relative order of front nodes is not preserved,
+    /// which is acceptable because only back nodes are order-sensitive. When the back segment of `that` ranks no
+    /// higher than the tail of this list, as with unprioritized links, it is spliced after the tail: only the front
+    /// segment of `that` is traversed, so linking a single node costs no more than locating the list ends.
+    template <typename Pred, typename Rank>
+    std::enable_if_t<std::is_invocable_r_v<bool, Pred, const T&> && std::is_invocable_r_v<std::size_t, Rank, const T&>>
+    merge_partitioned(ListNode* const that, const Pred& is_front, const Rank& rank) noexcept
+    {
+        if ((that == nullptr) || (that == this)) { return; }
+        ListNode* const this_head = this->head();
+        ListNode* const that_head = that->head();
+        if (this_head == that_head) { return; }
+        ListNode* const this_tail = this_head->tail();
+        ListNode* const that_tail = that_head->tail();
+
+        ListNode* last_front = nullptr;
+        ListNode* back_head  = that_head;
+        while ((back_head != nullptr) && is_front(static_cast<const T&>(*back_head)))
+        {
+            last_front = back_head;
+            back_head  = back_head->next_;
+        }
+        if ((back_head != nullptr) && !is_front(static_cast<const T&>(*this_tail)) &&
+            (rank(static_cast<const T&>(*this_tail)) < rank(static_cast<const T&>(*back_head))))
+        {
+            merge_ranked(this_head, that_head, back_head, is_front, rank);
+            return;
+        }
+        ListNode* const new_head = (last_front != nullptr) ? that_head : this_head;
+        ListNode* const new_tail = (back_head != nullptr) ? that_tail : this_tail;
+        if (last_front != nullptr)
+        {
+            last_front->next_ = this_head;
+            this_head->prev_  = last_front;
+        }
+        if (back_head != nullptr)
+        {
+            back_head->prev_ = this_tail;
+            this_tail->next_ = back_head;
+        }
+        new_head->prev_ = new_tail;
+    }
+
+    /// Inserts the unlinked `node` into this list before the first node for which goes_after() is false, or at the
+    /// tail if there is none. Used for ordered insertion; the walk stops at the insertion point.
+    template <typename Pred>
+    std::enable_if_t<std::is_invocable_r_v<bool, Pred, const T&>>
+    insert_ordered(ListNode* const node, const Pred& goes_after) noexcept
+    {
+        if ((node == nullptr) || (node == this) || node->linked()) { return; }
+        ListNode* const h = this->head();
+        ListNode* p = h;
+        while ((p != nullptr) && goes_after(static_cast<const T&>(*p))) { p = p->next_; }
+        if (p == nullptr)
+        {
+            ListNode* const t = h->tail();
+            t->next_    = node;
+            node->prev_ = t;
+            h->prev_    = node;
+        }
+        else if (p == h)
+        {
+            node->next_ = h;
+            node->prev_ = (h->prev_ != nullptr) ? h->prev_ : h;
+            h->prev_    = node;
+        }
+        else
+        {
+            node->prev_        = p->prev_;
+            node->next_        = p;
+            p->prev_->next_    = node;
+            p->prev_           = node;
+        }
+    }
+
     template <std::size_t N_Clusters, typename K_Func>
     std::enable_if_t<std::is_invocable_r_v<std::size_t, K_Func, const T&>>
     clusterize(const K_Func& key_func) noexcept
@@ -566,7 +835,8 @@ public:
         {
             ListNode* const current_node = p;
             p = p->next_;
-            current_node->remove();
+            current_node->prev_ = nullptr; // Detached wholesale; the list is rebuilt below.
+            current_node->next_ = nullptr;
             std::size_t cluster_index = key_func(static_cast<const T&>(*current_node));
             assert(cluster_index < N_Clusters && "Cluster index out of bounds");
 
@@ -605,14 +875,36 @@ public:
                 }
             }
         }
+        if ((new_global_head != nullptr) && (new_global_head != new_global_tail))
+        {
+            new_global_head->prev_ = new_global_tail;
+        }
         // After this, the list structure containing the original 'this' node is rebuilt.
         // 'this' node's prev/next pointers are now updated according to its new position.
     }
 
     void remove() noexcept
     {
-        if (prev_ != nullptr) { prev_->next_ = next_; }
-        if (next_ != nullptr) { next_->prev_ = prev_; }
+        if (!linked()) { return; }
+        if (is_head())
+        {
+            // prev_ is the tail; the successor becomes the head. A lone remaining node is unlinked.
+            next_->prev_ = (prev_ == next_) ? nullptr : prev_;
+        }
+        else
+        {
+            prev_->next_ = next_;
+            if (next_ != nullptr)
+            {
+                next_->prev_ = prev_;
+            }
+            else
+            {
+                // This was the tail: the head must now point back at the new tail.
+                ListNode* const h = prev_->head();
+                h->prev_ = (h == prev_) ? nullptr : prev_;
+            }
+        }
         prev_ = nullptr;
         next_ = nullptr;
     }
@@ -621,10 +913,94 @@ protected:
     ~ListNode() noexcept { remove(); }
 
 private:
+    /// The slow path of merge_partitioned(): relinks both lists as one, the front segment of `that` (up to
+    /// `that_back`), then that of this list, then the two back segments merged by rank.
+    template <typename Pred, typename Rank>
+    static void merge_ranked(ListNode* const this_head, ListNode* const that_head, ListNode* const that_back,
+                             const Pred& is_front, const Rank& rank) noexcept
+    {
+        ListNode* head = nullptr;
+        ListNode* tail = nullptr;
+        const auto append = [&head, &tail](ListNode* const node) noexcept
+        {
+            node->prev_ = tail;
+            node->next_ = nullptr;
+            if (tail != nullptr) { tail->next_ = node; } else { head = node; }
+            tail = node;
+        };
+        ListNode* p = this_head;
+        for (ListNode* q = that_head; q != that_back;)
+        {
+            ListNode* const node = q;
+            q = q->next_;
+            append(node);
+        }
+        while ((p != nullptr) && is_front(static_cast<const T&>(*p)))
+        {
+            ListNode* const node = p;
+            p = p->next_;
+            append(node);
+        }
+        ListNode* q = that_back;
+        while ((p != nullptr) || (q != nullptr))
+        {
+            const bool take_that =
+                (p == nullptr) ||
+                ((q != nullptr) && (rank(static_cast<const T&>(*q)) > rank(static_cast<const T&>(*p))));
+            ListNode*& from = take_that ? q : p;
+            ListNode* const node = from;
+            from = from->next_;
+            append(node);
+        }
+        head->prev_ = tail;
+    }
+
+    /// Takes over the position of `that` in its list, leaving `that` unlinked. This must be unlinked.
+    void take_links(ListNode& that) noexcept
+    {
+        if (!that.linked()) { return; }
+        const bool was_head = that.is_head();
+        prev_ = that.prev_;
+        next_ = that.next_;
+        if (was_head)
+        {
+            next_->prev_ = this;
+        }
+        else
+        {
+            if (next_ != nullptr)
+            {
+                next_->prev_ = this;
+            }
+            else
+            {
+                prev_->head()->prev_ = this; // That was the tail, referenced by the head.
+            }
+            prev_->next_ = this;
+        }
+        that.prev_ = nullptr;
+        that.next_ = nullptr;
+    }
+
     ListNode* prev_ = nullptr;
     ListNode* next_ = nullptr;
 };
 
+template <typename>
+struct Thunk;
+
+/// A raw entry point into a behavior: the type-erased call function of its Function plus the object it operates on.
+/// Arrays of thunks are what frozen topics iterate over instead of walking the list via virtual calls.
+template <typename R, typename... A>
+struct Thunk<R(A...)>
+{
+    R (*call)(void*, A...) = nullptr;
+    void* target           = nullptr;
+
+    explicit constexpr operator bool() const noexcept { return call != nullptr; }
+    R operator()(A... args) const { return call(target, args...); }
+};
+
 template <typename>
 class Triggerable;
 
@@ -634,6 +1010,8 @@ class Triggerable<R(A...)>
 public:
     virtual R trigger(A... args) const = 0;
     virtual std::size_t key() const noexcept = 0;
+    /// Events return an empty thunk because triggering them has no effect.
+    virtual Thunk<R(A...)> thunk() const noexcept = 0;
 
     Triggerable() noexcept                         = default;
     Triggerable(const Triggerable&)                = default;
@@ -695,6 +1073,10 @@ struct Behavior<R(A...), footprint_val, movable> : public detail::Port<detail::T
                  !std::is_same_v<std::decay_t<F>, Behavior>, int> = 0) :
         fun_(std::forward<F>(fun)) {}
 
+    /// Constant-initializable, see bind().
+    template <auto Method, typename C>
+    constexpr Behavior(const BoundMethod<Method, C> bound) noexcept : fun_(bound) {}
+
     Behavior(const Behavior&)                = delete;
     Behavior(Behavior&&) noexcept            = default;
     Behavior& operator=(const Behavior&)     = delete;
@@ -711,9 +1093,74 @@ struct Behavior<R(A...), footprint_val, movable> : public detail::Port<detail::T
     }
 
 private:
-    R trigger(A... args) const final { return fun_(args...); }
-    std::size_t key() const noexcept final { return 1; }
+    R trigger(A... args) const final
+    {
+        [[maybe_unused]] const detail::TriggerHookGuard trigger_guard{
+            static_cast<const detail::Triggerable<Signature>*>(this)};
+        return fun_(args...);
+    }
+    std::size_t key() const noexcept final { return 1U + priority_; }
+    detail::Thunk<Signature> thunk() const noexcept final
+    {
+        return {(fun_.ops_ != nullptr) ? fun_.ops_->call : nullptr, fun_.fun_.bytes.data()};
+    }
+    template <typename> friend struct Event;
     FunType fun_;
+    link_priority_t priority_ = 0;
+};
+
+namespace detail
+{
+template <typename> struct MethodClass;
+template <typename C, typename R, typename... P> struct MethodClass<R (C::*)(P...)> { using type = C; };
+template <typename C, typename R, typename... P> struct MethodClass<R (C::*)(P...) const> { using type = const C; };
+} // namespace detail
+
+/// A behavior whose target is a member function fixed at compile time: it stores the object pointer and nothing else
+/// (no Function storage, ops pointer or link priority), and its trigger calls the method directly, so the method can
+/// be inlined into the dispatch. Frozen and direct topics call it through a thunk on the object itself. It links with
+/// operator>> only, at priority 0. Used through MemberPushable and MemberPullable:
+/// `ramen::MemberPushable<&Actor::on_value, int> in{this};`.
+/// The method must be declared before the port. A class template cannot name its own methods in the type of a
+/// member this way (it is incomplete while instantiated), so its ports keep bind<&C::m>(this).
+template <typename Signature, auto Method>
+struct MemberBehavior;
+
+template <typename R, typename... A, auto Method>
+struct MemberBehavior<R(A...), Method> : public detail::Port<detail::Triggerable<R(A...)>>
+{
+    using Signature = R(A...);
+    using BasePort = detail::Port<detail::Triggerable<Signature>>;
+    using Object = typename detail::MethodClass<decltype(Method)>::type;
+
+    static_assert(std::is_invocable_r_v<R, decltype(Method), Object*, A...>, "Member behavior has the wrong signature");
+
+    explicit constexpr MemberBehavior(Object* const object) noexcept : object_(object) {}
+
+    MemberBehavior(const MemberBehavior&)            = delete;
+    MemberBehavior& operator=(const MemberBehavior&) = delete;
+
+    virtual ~MemberBehavior() noexcept = default;
+
+    /// As Behavior::operator(): calls the method without broadcasting.
+    R operator()(A... args) const { return (object_->*Method)(args...); }
+
+private:
+    static R call(void* const object, A... args) { return (static_cast<Object*>(object)->*Method)(args...); }
+
+    R trigger(A... args) const final
+    {
+        [[maybe_unused]] const detail::TriggerHookGuard trigger_guard{
+            static_cast<const detail::Triggerable<Signature>*>(this)};
+        return (object_->*Method)(args...);
+    }
+    std::size_t key() const noexcept final { return 1U; }
+    detail::Thunk<Signature> thunk() const noexcept final
+    {
+        return {&call, const_cast<void*>(static_cast<const void*>(object_))};
+    }
+
+    Object* object_;
 };
 
 template <typename... A>
@@ -732,19 +1179,20 @@ struct Event<void(A...)> : public detail::Port<detail::Triggerable<void(A...)>>
 
     Event& operator>>(BasePort& that) noexcept
     {
-        this->merge(&that);
-        // The clusterize call reorders the local sublist so that all key()==0 (Events)
-        // come before key()==1 (Behaviors). This ensures a defined order if events are chained.
-        // On AVR, this can be expensive. If you only ever do `Event >> Behavior` (no complex Event->Event
-        // chains mixed with Behaviors where processing order of same-level events matters),
-        // you could consider removing it for performance if the merge order is sufficient.
-        static_cast<detail::ListNode<detail::Triggerable<Signature>>*>(this)->head()
-            ->template clusterize<2>([](const detail::Triggerable<Signature>& x) { return x.key(); });
+        // Topics are kept partitioned as links are added: all key()==0 nodes (Events) come before the
+        // Behaviors, which stay in order of priority (key() is 1 + priority), then of linking. The incoming list is
+        // spliced in at the segment boundaries, or its Behaviors merged by priority with those of this topic when
+        // they outrank its last one, so no clusterize rescan of the whole topic is needed.
+        this->merge_partitioned(&that, [](const detail::Triggerable<Signature>& x) { return x.key() == 0; },
+                                [](const detail::Triggerable<Signature>& x) { return x.key(); });
         return *this;
     }
 
     void operator()(A... args) const
     {
+        count_sent();
+        [[maybe_unused]] const detail::DispatchDepthGuard depth_guard{};
+        [[maybe_unused]] const detail::DispatchHookGuard  hook_guard{this, detail::payload_size<A...>};
         // Iterate through the linked list starting from the item *after* this Event node.
         const detail::ListNode<detail::Triggerable<Signature>>* p = this->next();
         while (p != nullptr)
@@ -754,32 +1202,348 @@ struct Event<void(A...)> : public detail::Port<detail::Triggerable<void(A...)>>
         }
     }
 
+    /// Links a behavior into this topic so that it runs after behaviors of equal or higher priority and before
+    /// behaviors of lower priority; behaviors linked with operator>> have priority 0. The position is resolved here,
+    /// so dispatch costs the same as for an unordered topic. If the behavior was already part of another topic, the
+    /// two topics are merged as with operator>>, allowing the behavior to be repositioned afterwards.
+    template <std::size_t fp, bool movable>
+    Event& link(Behavior<Signature, fp, movable>& that, const link_priority_t priority) noexcept
+    {
+        using Node = detail::ListNode<detail::Triggerable<Signature>>;
+        Node& node = that;
+        if (node.linked())
+        {
+            *this >> that;
+            node.remove();
+        }
+        that.priority_ = priority;
+        const std::size_t rank = that.key();
+        this->insert_ordered(&node, [rank](const detail::Triggerable<Signature>& x) { return (x.key() == 0) || (x.key() >= rank); });
+        return *this;
+    }
+
+    /// Invocations of this Event since construction or reset_sent(), saturating at 65535. Always maintained, at
+    /// two bytes per Event, so that runaway event loops can be spotted in the field without a profiling build.
+    std::uint16_t sent() const noexcept { return sent_; }
+    const std::uint16_t& sent_counter() const noexcept { return sent_; }
+    void reset_sent() noexcept { sent_ = 0; }
+
     void detach() noexcept { this->remove(); }
     virtual ~Event() noexcept = default;
 
+protected:
+    void count_sent() const noexcept
+    {
+        if (sent_ != UINT16_MAX) { ++sent_; }
+    }
+
 private:
+    mutable std::uint16_t sent_ = 0;
+
     void trigger(A...) const final {} // Event node itself does nothing when triggered
     std::size_t key() const noexcept final { return 0; }
+    detail::Thunk<Signature> thunk() const noexcept final { return {}; }
 
     friend Event& operator^(Event& le, BasePort& ri) noexcept { return le >> ri; }
     friend Event& operator^(BasePort& le, Event& ri) noexcept { return ri >> le; }
     friend Event& operator^(Event& le, Event& ri) noexcept { return le >> ri; }
 };
 
-template <typename R, typename... A> struct Event<R(A...)>;
+/// A returning Event: invoking it folds the results of all behaviors on the topic with a combiner, in one walk.
+/// A combiner provides `init<R>()`, `step(acc, value)` and `done(acc)`; the walk stops early once done() holds.
+/// Ready-made combiners live in ramen::combine; Query binds one of them to the call operator.
+template <typename R, typename... A>
+struct Event<R(A...)> : public detail::Port<detail::Triggerable<R(A...)>>
+{
+    using Signature = R(A...);
+    using BasePort = detail::Port<detail::Triggerable<Signature>>;
+
+    using BasePort::operator bool;
+
+    Event()                   = default;
+    Event(const Event&)                = delete;
+    Event(Event&&)            = default;
+    Event& operator=(const Event&)     = delete;
+    Event& operator=(Event&&) noexcept = default;
+
+    Event& operator>>(BasePort& that) noexcept
+    {
+        this->merge_partitioned(&that, [](const detail::Triggerable<Signature>& x) { return x.key() == 0; },
+                                [](const detail::Triggerable<Signature>& x) { return x.key(); });
+        return *this;
+    }
+
+    template <typename Combiner>
+    R fold(A... args) const
+    {
+        [[maybe_unused]] const detail::DispatchDepthGuard depth_guard{};
+        [[maybe_unused]] const detail::DispatchHookGuard  hook_guard{this, detail::payload_size<A...>};
+        R acc = Combiner::template init<R>();
+        for (const auto* p = this->next(); (p != nullptr) && !Combiner::done(acc); p = p->next())
+        {
+            // Events on the topic have empty thunks and contribute nothing.
+            const auto* const node = static_cast<const detail::Triggerable<Signature>*>(p);
+            const detail::Thunk<Signature> th = node->thunk();
+            if (th)
+            {
+                [[maybe_unused]] const detail::TriggerHookGuard trigger_guard{node};
+                acc = Combiner::step(acc, th(args...));
+            }
+        }
+        return acc;
+    }
+
+    void detach() noexcept { this->remove(); }
+    virtual ~Event() noexcept = default;
+
+private:
+    R trigger(A...) const final { return R{}; } // Never called: fold() skips Event nodes.
+    std::size_t key() const noexcept final { return 0; }
+    detail::Thunk<Signature> thunk() const noexcept final { return {}; }
+};
+
+namespace combine
+{
+struct sum
+{
+    template <typename R> static constexpr R init() noexcept { return R{}; }
+    template <typename R> static constexpr R step(const R& acc, const R& v) noexcept { return acc + v; }
+    template <typename R> static constexpr bool done(const R&) noexcept { return false; }
+};
+struct min
+{
+    template <typename R> static constexpr R init() noexcept { return std::numeric_limits<R>::max(); }
+    template <typename R> static constexpr R step(const R& acc, const R& v) noexcept { return (v < acc) ? v : acc; }
+    template <typename R> static constexpr bool done(const R&) noexcept { return false; }
+};
+struct max
+{
+    template <typename R> static constexpr R init() noexcept { return std::numeric_limits<R>::lowest(); }
+    template <typename R> static constexpr R step(const R& acc, const R& v) noexcept { return (acc < v) ? v : acc; }
+    template <typename R> static constexpr bool done(const R&) noexcept { return false; }
+};
+/// Logical and; true for an empty topic, stops at the first false.
+struct all_of
+{
+    template <typename R> static constexpr R init() noexcept { return R{true}; }
+    template <typename R> static constexpr R step(const R& acc, const R& v) noexcept { return acc && v; }
+    template <typename R> static constexpr bool done(const R& acc) noexcept { return !acc; }
+};
+/// Logical or; false for an empty topic, stops at the first true.
+struct any_of
+{
+    template <typename R> static constexpr R init() noexcept { return R{false}; }
+    template <typename R> static constexpr R step(const R& acc, const R& v) noexcept { return acc || v; }
+    template <typename R> static constexpr bool done(const R& acc) noexcept { return static_cast<bool>(acc); }
+};
+/// First result that converts to true (e.g. a non-null pointer), in link order; R{} if there is none.
+struct first_non_null
+{
+    template <typename R> static constexpr R init() noexcept { return R{}; }
+    template <typename R> static constexpr R step(const R& acc, const R& v) noexcept { return acc ? acc : v; }
+    template <typename R> static constexpr bool done(const R& acc) noexcept { return static_cast<bool>(acc); }
+};
+} // namespace combine
 
 // ====================================================================================================================
 
-template <typename... T> struct Pushable final : public Behavior<void(const T&...), default_behavior_footprint> { using Behavior<void(const T&...), default_behavior_footprint>::Behavior; };
-template <typename... T, std::size_t fp> struct Pushable<Footprint<fp>, T...> final : public Behavior<void(const T&...), fp> { using Behavior<void(const T&...), fp>::Behavior; };
+template <typename... T> struct Pushable final : public Behavior<void(pass_t<T>...), default_behavior_footprint> { using Behavior<void(pass_t<T>...), default_behavior_footprint>::Behavior; };
+template <typename... T, std::size_t fp> struct Pushable<Footprint<fp>, T...> final : public Behavior<void(pass_t<T>...), fp> { using Behavior<void(pass_t<T>...), fp>::Behavior; };
 template <> struct Pushable<void> final : public Behavior<void(), default_behavior_footprint> { using Behavior<void(), default_behavior_footprint>::Behavior; };
 template <std::size_t fp> struct Pushable<Footprint<fp>, void> final : public Behavior<void(), fp> { using Behavior<void(), fp>::Behavior; };
+template <auto Method, typename... T> struct MemberPushable final : public MemberBehavior<void(pass_t<T>...), Method> { using MemberBehavior<void(pass_t<T>...), Method>::MemberBehavior; };
+template <auto Method> struct MemberPushable<Method, void> final : public MemberBehavior<void(), Method> { using MemberBehavior<void(), Method>::MemberBehavior; };
 
-template <typename... T> struct Pusher final : public Event<void(const T&...)> {};
+template <typename... T> struct Pusher final : public Event<void(pass_t<T>...)> {};
 template <> struct Pusher<void> final : public Event<void()> {};
 
+/// FlatPusher is a Pusher whose topic can be frozen after the network is linked (typically at the end of setup()).
+/// Freezing copies the entry point of every behavior on the topic into a contiguous table of up to `capacity` thunks,
+/// so that invocation iterates linearly over the table instead of chasing list pointers and making a virtual call
+/// per node. Relinking through this FlatPusher thaws it automatically; if the topic is altered through another port
+/// of the same topic, the FlatPusher has to be re-frozen by the user. If the topic does not fit in the table,
+/// freeze() returns false and the FlatPusher keeps dispatching through the list.
+template <std::size_t capacity, typename... T>
+struct FlatPusher final : public Event<void(pass_t<T>...)>
+{
+    static_assert((capacity > 0) && (capacity <= 255), "FlatPusher capacity must be in [1, 255]");
+
+    using Base     = Event<void(pass_t<T>...)>;
+    using BasePort = typename Base::BasePort;
+    using Base::operator bool;
+
+    FlatPusher& operator>>(BasePort& that) noexcept
+    {
+        thaw();
+        Base::operator>>(that);
+        return *this;
+    }
+
+    template <std::size_t fp, bool movable>
+    FlatPusher& link(Behavior<void(pass_t<T>...), fp, movable>& that, const link_priority_t priority) noexcept
+    {
+        thaw();
+        Base::link(that, priority);
+        return *this;
+    }
+
+    bool freeze() noexcept
+    {
+        thaw();
+        std::uint8_t n = 0;
+        for (auto* p = this->next(); p != nullptr; p = p->next())
+        {
+            const detail::Thunk<void(pass_t<T>...)> th = static_cast<const detail::Triggerable<void(pass_t<T>...)>*>(p)->thunk();
+            if (th)
+            {
+                if (n >= capacity) { return false; }
+                table_[n++] = th;
+            }
+        }
+        size_ = n;
+        frozen_ = true;
+        return true;
+    }
+
+    void thaw() noexcept { size_ = 0; frozen_ = false; }
+    bool frozen() const noexcept { return frozen_; }
+
+    void operator()(pass_t<T>... args) const
+    {
+        if (frozen_)
+        {
+            this->count_sent();
+            [[maybe_unused]] const detail::DispatchDepthGuard depth_guard{};
+            [[maybe_unused]] const detail::DispatchHookGuard  hook_guard{this, detail::payload_size<pass_t<T>...>};
+            for (std::uint8_t i = 0; i < size_; ++i) { table_[i](args...); }
+        }
+        else
+        {
+            Base::operator()(args...);
+        }
+    }
+
+private:
+    std::array<detail::Thunk<void(pass_t<T>...)>, capacity> table_{};
+    std::uint8_t size_ = 0;
+    bool frozen_ = false;
+};
+
+/// DirectPusher is a Pusher specialized for the common topic with a single subscriber, i.e. a topic whose only node
+/// after this one is a behavior. For such a topic it calls the entry point of that behavior directly, skipping the list
+/// walk and the virtual `trigger` call. The shape of the topic is re-checked on every invocation (two pointer
+/// comparisons), so linking or unlinking through any port of the topic is safe: other topics fall back to the
+/// regular dispatch, and the fast path is re-established as soon as the topic has a single subscriber again.
+template <typename... T>
+struct DirectPusher final : public Event<void(pass_t<T>...)>
+{
+    using Base     = Event<void(pass_t<T>...)>;
+    using BasePort = typename Base::BasePort;
+    using Node     = detail::ListNode<detail::Triggerable<void(pass_t<T>...)>>;
+    using Base::operator bool;
+
+    DirectPusher& operator>>(BasePort& that) noexcept
+    {
+        Base::operator>>(that);
+        bind();
+        return *this;
+    }
+
+    void operator()(pass_t<T>... args) const
+    {
+        if ((single_ == nullptr) || (this->next() != single_) || (single_->next() != nullptr))
+        {
+            bind();
+            if (single_ == nullptr)
+            {
+                Base::operator()(args...);
+                return;
+            }
+        }
+        this->count_sent();
+        [[maybe_unused]] const detail::DispatchDepthGuard depth_guard{};
+        [[maybe_unused]] const detail::DispatchHookGuard  hook_guard{this, detail::payload_size<pass_t<T>...>};
+        [[maybe_unused]] const detail::TriggerHookGuard   trigger_guard{
+            static_cast<const detail::Triggerable<void(pass_t<T>...)>*>(single_)};
+        thunk_(args...);
+    }
+
+    /// True if the last invocation or link found a single-subscriber topic.
+    bool direct() const noexcept { return single_ != nullptr; }
+
+private:
+    void bind() const noexcept
+    {
+        single_ = nullptr;
+        const Node* const p = this->next();
+        if ((p != nullptr) && (p->next() == nullptr))
+        {
+            thunk_ = static_cast<const detail::Triggerable<void(pass_t<T>...)>*>(p)->thunk();
+            if (thunk_) { single_ = p; }
+        }
+    }
+
+    mutable const Node* single_ = nullptr;
+    mutable detail::Thunk<void(pass_t<T>...)> thunk_{};
+};
+
+/// KeyedPusher demultiplexes a stream of messages by key: it holds one DirectPusher per key in [0, N), and a message
+/// pushed with a key goes through the port of that key only, found by indexing instead of by every subscriber
+/// receiving it and filtering out the keys of the others. Dispatch costs one bounds check and one array index however
+/// many keys there are, and a key with a single subscriber calls it directly. Messages whose key is out of range, or
+/// whose port has no subscriber, go to `unrouted` instead:
+///
+///     ramen::KeyedPusher<std::uint8_t, LedCommandEvent, 3> command_out;
+///     command_out.port<0>() >> led1_status.command_in;  // Only the messages for output 0
+///     command_out.unrouted >> errors.command_in;
+///     command_out(evt.led_id, evt);
+///
+/// Key is an integral or enumeration type whose values index the ports, as dense as the table is large. Wiring names
+/// a port by a key in range: port<key>() checks it at compile time, operator[] asserts it, so a mistyped key never
+/// subscribes to `unrouted`, which is reached by its own name only.
+template <typename Key, typename T, std::size_t N>
+struct KeyedPusher final
+{
+    static_assert(std::is_integral_v<Key> || std::is_enum_v<Key>, "KeyedPusher keys must be integers or enumerators");
+    static_assert((N > 0) && (N <= 255), "KeyedPusher must have [1, 255] keys");
+
+    using Port = DirectPusher<T>;
+
+    /// The port of `key`, linked to the subscribers of that key.
+    template <Key key>
+    Port& port() noexcept
+    {
+        static_assert(static_cast<std::size_t>(key) < N, "KeyedPusher key out of range");
+        return ports_[static_cast<std::size_t>(key)];
+    }
+
+    /// As port<key>(), for a key known at run time only; it must be in range.
+    Port& operator[](const Key key) noexcept
+    {
+        const std::size_t index = static_cast<std::size_t>(key);
+        assert(index < N && "KeyedPusher key out of range");
+        return ports_[index];
+    }
+
+    void operator()(const Key key, pass_t<T> value) const
+    {
+        const std::size_t index = static_cast<std::size_t>(key);
+        if ((index < N) && ports_[index]) { ports_[index](value); }
+        else { unrouted(value); }
+    }
+
+    static constexpr std::size_t size() noexcept { return N; }
+
+    /// Messages for keys no port subscribes to.
+    Port unrouted;
+
+private:
+    std::array<Port, N> ports_{};
+};
+
 template <typename... T> struct Pullable final : public Behavior<void(T&...), default_behavior_footprint> { using Behavior<void(T&...), default_behavior_footprint>::Behavior; };
 template <typename... T, std::size_t fp> struct Pullable<Footprint<fp>, T...> final : public Behavior<void(T&...), fp> { using Behavior<void(T&...), fp>::Behavior; };
+template <auto Method, typename... T> struct MemberPullable final : public MemberBehavior<void(T&...), Method> { using MemberBehavior<void(T&...), Method>::MemberBehavior; };
 
 namespace detail { template <typename T_val> struct PullerArrowProxy { T_val value{}; T_val* operator->() noexcept { return &value; } }; }
 
@@ -790,6 +1554,58 @@ template <typename T_param> struct Puller<T_param> final : public Event<void(T_p
 };
 template <> struct Puller<void> final : public Event<void()> {};
 
+/// Query/Responder: a returning topic. Invoking a Query asks every linked Responder and folds the answers with the
+/// combiner, e.g. `Query<combine::all_of, bool> zones_safe;` linked to one `Responder<bool>` per zone.
+template <typename R, typename... T> struct Responder final : public Behavior<R(pass_t<T>...), default_behavior_footprint> { using Behavior<R(pass_t<T>...), default_behavior_footprint>::Behavior; };
+template <typename R, typename... T, std::size_t fp> struct Responder<R, Footprint<fp>, T...> final : public Behavior<R(pass_t<T>...), fp> { using Behavior<R(pass_t<T>...), fp>::Behavior; };
+
+template <typename Combiner, typename R, typename... T> struct Query final : public Event<R(pass_t<T>...)> {
+    R operator()(pass_t<T>... args) const { return this->template fold<Combiner>(args...); }
+};
+
+/// Exact-fit behaviors: the closure storage sized to the closure at hand instead of default_behavior_footprint, so a
+/// behavior takes the RAM of its captures and a large closure needs no hand-tuned Footprint. The factories deduce it,
+/// for behaviors that are variables (`auto in = ramen::make_pushable<int>([&count](int v) { count += v; });`); a
+/// member cannot deduce its type, but this_footprint fits the common `[this]` lambda and bind():
+/// `ramen::Pushable<ramen::Footprint<ramen::this_footprint>, int> in = [this](int v) { on_value(v); };`.
+template <typename F> constexpr std::size_t closure_footprint = sizeof(std::decay_t<F>);
+constexpr std::size_t this_footprint = sizeof(void*);
+template <typename... T, typename F> Pushable<Footprint<closure_footprint<F>>, T...> make_pushable(F&& fun) { return {std::forward<F>(fun)}; }
+template <typename... T, typename F> Pullable<Footprint<closure_footprint<F>>, T...> make_pullable(F&& fun) { return {std::forward<F>(fun)}; }
+template <typename R, typename... T, typename F> Responder<R, Footprint<closure_footprint<F>>, T...> make_responder(F&& fun) { return {std::forward<F>(fun)}; }
+
+// ====================================================================================================================
+
+/// A non-owning view of a contiguous run of objects, for ports that move a batch of samples in one dispatch
+/// (e.g. Pusher<Span<const std::uint8_t>> for serial byte runs). The viewed storage only has to stay valid for the
+/// duration of the dispatch; receivers that keep data must copy it.
+template <typename T> struct Span {
+    T* ptr = nullptr; std::size_t len = 0;
+    constexpr Span() noexcept = default;
+    constexpr Span(T* const data_, const std::size_t size_) noexcept : ptr(data_), len(size_) {}
+    template <std::size_t N> constexpr Span(T (&arr)[N]) noexcept : ptr(arr), len(N) {}
+    template <typename U, std::size_t N, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+    constexpr Span(std::array<U, N>& arr) noexcept : ptr(arr.data()), len(N) {}
+    template <typename U, std::size_t N, typename = std::enable_if_t<std::is_convertible_v<const U(*)[], T(*)[]>>>
+    constexpr Span(const std::array<U, N>& arr) noexcept : ptr(arr.data()), len(N) {}
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+    constexpr Span(const Span<U>& that) noexcept : ptr(that.data()), len(that.size()) {}
+    constexpr T* data() const noexcept { return ptr; }
+    constexpr std::size_t size() const noexcept { return len; }
+    constexpr bool empty() const noexcept { return len == 0; }
+    constexpr T* begin() const noexcept { return ptr; }
+    constexpr T* end() const noexcept { return ptr + len; }
+    constexpr T& operator[](const std::size_t i) const noexcept { return ptr[i]; }
+    constexpr Span first(const std::size_t n) const noexcept { return {ptr, (n < len) ? n : len}; }
+    constexpr Span subspan(const std::size_t offset) const noexcept { return (offset < len) ? Span{ptr + offset, len - offset} : Span{}; }
+};
+
+/// Splits a batch back into per-item pushes, for consumers that only have a single-item input.
+template <typename T_val> struct SpanSplit {
+    Pushable<Span<const T_val>> in = [this](const Span<const T_val>& batch) { if (out) { for (const T_val& item : batch) { out(item); } } };
+    Pusher<T_val> out{};
+};
+
 // ====================================================================================================================
 
 template <typename T_val, typename In_type = T_val, typename Out_type = T_val> struct Latch {
@@ -799,6 +1615,42 @@ template <typename T_val, typename Out_type = T_val> struct Lift {
     T_val value{}; Puller<T_val> in{}; Pusher<Out_type> out{}; Pushable<> trigger = [this] { if (in) in(value); if (out) out(static_cast<Out_type>(value)); };
 };
 
+// Change-detecting counterparts of the above. A value counts as changed if it differs from the last accepted one by
+// more than the deadband (for arithmetic types; other types are compared with ==). The first value is always a change.
+namespace detail
+{
+template <typename T>
+constexpr bool differs(const T& a, const T& b, const T& deadband)
+{
+    if constexpr (std::is_arithmetic_v<T>) { return (a > b) ? ((a - b) > deadband) : ((b - a) > deadband); }
+    else { (void)deadband; return !(a == b); }
+}
+} // namespace detail
+
+/// Forwards a pushed value only if it has changed since the last forwarded value.
+template <typename T_val> struct PushDistinct {
+    explicit PushDistinct(const T_val& deadband_ = T_val{}) : deadband(deadband_) {}
+    T_val value{}; T_val deadband; bool primed = false;
+    Pushable<T_val> in = [this](const T_val& val) { if (!primed || detail::differs(val, value, deadband)) { value = val; primed = true; if (out) out(value); } };
+    Pusher<T_val> out{};
+};
+/// A Latch that ignores unchanged values; a change raises `dirty` and fires `changed`.
+template <typename T_val> struct DistinctLatch {
+    explicit DistinctLatch(const T_val& deadband_ = T_val{}) : deadband(deadband_) {}
+    T_val value{}; T_val deadband; bool primed = false; bool dirty = false;
+    Pushable<T_val> in = [this](const T_val& val) { if (!primed || detail::differs(val, value, deadband)) { value = val; primed = true; dirty = true; if (changed) changed(value); } };
+    Pullable<T_val> out = [this](T_val& val) { val = value; };
+    Pusher<T_val> changed{};
+    /// Returns the dirty flag and clears it.
+    bool take_dirty() noexcept { const bool d = dirty; dirty = false; return d; }
+};
+/// A Lift that publishes only when the pulled value has changed since the last publication.
+template <typename T_val> struct DistinctLift {
+    explicit DistinctLift(const T_val& deadband_ = T_val{}) : deadband(deadband_) {}
+    T_val value{}; T_val deadband; bool primed = false; Puller<T_val> in{}; Pusher<T_val> out{};
+    Pushable<> trigger = [this] { T_val val = value; if (in) in(val); if (!primed || detail::differs(val, value, deadband)) { value = val; primed = true; if (out) out(value); } };
+};
+
 // ====================================================================================================================
 
 template <typename Out_type, typename... In_types> struct PushUnary;
@@ -836,6 +1688,26 @@ public: std::tuple<In_types...> value; std::tuple<Puller<In_types>...> in{}; Pul
 };
 template <typename Out_type, typename... In_types> struct PullNary : public PullNary<Footprint<default_behavior_footprint>, Out_type, In_types...> { using PullNary<Footprint<default_behavior_footprint>, Out_type, In_types...>::PullNary; };
 
+// Scan-epoch memoization for pull graphs. The application advances the global scan epoch once per scan (e.g. at the
+// top of loop()); a Memoized node evaluates its wrapped node on the first pull of each epoch and serves the cached
+// value to every further consumer in the same epoch, so shared subtrees of a diamond-shaped graph evaluate once.
+using scan_epoch_t = std::uint16_t;
+namespace detail { inline scan_epoch_t scan_epoch = 0; }
+inline scan_epoch_t current_scan_epoch() noexcept { return detail::scan_epoch; }
+inline void advance_scan_epoch() noexcept { ++detail::scan_epoch; }
+
+/// Wraps a pull node (PullUnary, PullNary, or anything with an `out` Pullable of Out_type) with a per-epoch cache.
+/// Its `out` hides the node's own `out`; the inputs of the node are linked as usual.
+template <typename Out_type, typename Node> struct Memoized : public Node {
+    using Node::Node;
+    Out_type cached{}; scan_epoch_t epoch = 0; bool primed = false;
+    Pullable<Out_type> out = [this](Out_type& val) { if (!primed || (epoch != detail::scan_epoch)) { Node::out(cached); epoch = detail::scan_epoch; primed = true; } val = cached; };
+    /// Forces re-evaluation on the next pull, e.g. after an input was changed mid-scan.
+    void invalidate() noexcept { primed = false; }
+};
+template <typename Out_type, typename... In_types> using CachedPullUnary = Memoized<Out_type, PullUnary<Out_type, In_types...>>;
+template <typename Out_type, typename... In_types> using CachedPullNary  = Memoized<Out_type, PullNary<Out_type, In_types...>>;
+
 // ====================================================================================================================
 
 template <typename To, typename From> struct PushCast final : public PushUnary<Footprint<sizeof(void*)>, To, From> { PushCast() : PushUnary<Footprint<sizeof(void*)>, To, From>([](const From& val) { return static_cast<To>(val); }) {} };
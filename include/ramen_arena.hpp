@@ -0,0 +1,216 @@
+/// Compact RAMEN ports backed by a static port arena.
+///
+/// A regular port is a ListNode: a vtable pointer, two list pointers and, for behaviors, a Function. In a PortArena
+/// every port is a slot holding the entry point of its behavior (if any), an inline closure the size of a pointer and
+/// the 8-bit index of the next slot of its topic; the port object itself only stores its own index. On AVR that
+/// makes a behavior port 6 bytes instead of 13. Topics keep the semantics of regular ones (senders in front,
+/// behaviors in link order behind them) and can be relinked at run time; linking costs a scan of the arena instead
+/// of pointer chasing, which is acceptable for the at most 255 ports an arena can hold.
+///
+///     ramen::PortArena<32> ports;
+///     ramen::ArenaPusher<ports, std::uint8_t> byte_out;
+///     ramen::ArenaPushable<ports, std::uint8_t> byte_in = [this](std::uint8_t b) { consume(b); };
+///     byte_out >> byte_in;
+///
+/// Behaviors must be trivially copyable closures no larger than a pointer, which covers `[this]` lambdas and plain
+/// functions. Ports are meant to be statically allocated: a destroyed port is unlinked, but its slot is not reused.
+
+#pragma once
+
+#include "ramen.hpp"
+#include <array>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace ramen
+{
+
+template <std::uint8_t capacity>
+class PortArena final
+{
+    static_assert((capacity > 0) && (capacity < 255), "PortArena capacity must be in [1, 254]");
+
+public:
+    /// Slot index plus one; 0 denotes "no port", so a zero-initialized arena is empty and ready before any port
+    /// constructor runs.
+    using index_t = std::uint8_t;
+    static constexpr index_t none = 0;
+
+    /// Reserves a slot. `call` is null for senders; `closure` is copied into the slot. Returns `none` (and counts
+    /// the failure) if the arena is full, in which case the port stays inert.
+    template <typename F>
+    index_t allocate(void (*const call)(), const F* const closure) noexcept
+    {
+        static_assert((sizeof(F) <= sizeof(void*)) && (alignof(F) <= alignof(void*)) && std::is_trivially_copyable_v<F>,
+                      "Arena closures must be trivially copyable and no larger than a pointer");
+        if (used_ >= capacity)
+        {
+            if (overflowed_ != UINT8_MAX) { ++overflowed_; }
+            return none;
+        }
+        Slot& s = slots_[used_];
+        s.call = call;
+        if (closure != nullptr) { new (s.closure) F(*closure); }
+        return ++used_;
+    }
+
+    /// Joins the topics of `src` and `dst` like Event::operator>>.
+    void link(const index_t src, const index_t dst) noexcept
+    {
+        if ((src == none) || (dst == none)) { return; }
+        const index_t this_head = head_of(src);
+        const index_t that_head = head_of(dst);
+        if (this_head == that_head) { return; }
+
+        index_t last_front = none;
+        index_t back_head  = that_head;
+        while ((back_head != none) && (at(back_head).call == nullptr))
+        {
+            last_front = back_head;
+            back_head  = at(back_head).next;
+        }
+        if (last_front != none) { at(last_front).next = this_head; }
+        if (back_head != none) { at(tail_of(this_head)).next = back_head; }
+    }
+
+    /// Removes a port from its topic; the rest of the topic stays linked.
+    void detach(const index_t id) noexcept
+    {
+        if (id == none) { return; }
+        const index_t pred = predecessor(id);
+        if (pred != none) { at(pred).next = at(id).next; }
+        at(id).next = none;
+    }
+
+    bool linked(const index_t id) const noexcept
+    {
+        return (id != none) && ((at(id).next != none) || (predecessor(id) != none));
+    }
+
+    /// Triggers every behavior after `from` in its topic. A must be the exact parameter types of the topic.
+    template <typename... A>
+    void dispatch(const index_t from, A... args) const
+    {
+        if (from == none) { return; }
+        [[maybe_unused]] const detail::DispatchDepthGuard depth_guard{};
+        [[maybe_unused]] const detail::DispatchHookGuard  hook_guard{&at(from), detail::payload_size<A...>};
+        for (index_t i = at(from).next; i != none; i = at(i).next)
+        {
+            [[maybe_unused]] const detail::TriggerHookGuard trigger_guard{&at(i)};
+            invoke<A...>(i, args...);
+        }
+    }
+
+    /// Triggers the behavior of a single slot.
+    template <typename... A>
+    void invoke(const index_t id, A... args) const
+    {
+        const Slot& s = at(id);
+        if (s.call != nullptr)
+        {
+            reinterpret_cast<void (*)(const void*, A...)>(s.call)(s.closure, args...);
+        }
+    }
+
+    index_t      used() const noexcept { return used_; }
+    std::uint8_t overflowed() const noexcept { return overflowed_; }
+
+private:
+    struct Slot
+    {
+        void (*call)() = nullptr;
+        alignas(void*) unsigned char closure[sizeof(void*)]{};
+        index_t next = none;
+    };
+
+    Slot&       at(const index_t id) noexcept { return slots_[id - 1U]; }
+    const Slot& at(const index_t id) const noexcept { return slots_[id - 1U]; }
+
+    index_t predecessor(const index_t id) const noexcept
+    {
+        for (index_t i = 1; i <= used_; ++i)
+        {
+            if (at(i).next == id) { return i; }
+        }
+        return none;
+    }
+    index_t head_of(index_t id) const noexcept
+    {
+        for (index_t p = predecessor(id); p != none; p = predecessor(id)) { id = p; }
+        return id;
+    }
+    index_t tail_of(index_t id) const noexcept
+    {
+        while (at(id).next != none) { id = at(id).next; }
+        return id;
+    }
+
+    std::array<Slot, capacity> slots_{};
+    index_t      used_       = 0;
+    std::uint8_t overflowed_ = 0;
+};
+
+namespace detail
+{
+template <typename F, typename... A>
+void arena_call(const void* const closure, A... args)
+{
+    (*std::launder(reinterpret_cast<const F*>(closure)))(args...);
+}
+} // namespace detail
+
+template <auto& arena, typename... T>
+struct ArenaPushable;
+
+/// Sending port of an arena topic.
+template <auto& arena, typename... T>
+struct ArenaPusher final
+{
+    using index_t = typename std::remove_reference_t<decltype(arena)>::index_t;
+
+    ArenaPusher() noexcept : id_(arena.template allocate<void*>(nullptr, nullptr)) {}
+    ArenaPusher(const ArenaPusher&)            = delete;
+    ArenaPusher& operator=(const ArenaPusher&) = delete;
+    ~ArenaPusher() noexcept { arena.detach(id_); }
+
+    ArenaPusher& operator>>(ArenaPushable<arena, T...>& that) noexcept { arena.link(id_, that.id()); return *this; }
+    ArenaPusher& operator>>(ArenaPusher& that) noexcept { arena.link(id_, that.id()); return *this; }
+
+    explicit operator bool() const noexcept { return arena.linked(id_); }
+
+    void operator()(pass_t<T>... args) const { arena.template dispatch<pass_t<T>...>(id_, args...); }
+
+    void    detach() noexcept { arena.detach(id_); }
+    index_t id() const noexcept { return id_; }
+
+private:
+    index_t id_;
+};
+
+/// Receiving port of an arena topic.
+template <auto& arena, typename... T>
+struct ArenaPushable final
+{
+    using index_t = typename std::remove_reference_t<decltype(arena)>::index_t;
+
+    template <typename F, typename = std::enable_if_t<std::is_invocable_r_v<void, const F&, pass_t<T>...>>>
+    ArenaPushable(const F fun) noexcept :
+        id_(arena.allocate(reinterpret_cast<void (*)()>(&detail::arena_call<F, pass_t<T>...>), &fun)) {}
+    ArenaPushable(const ArenaPushable&)            = delete;
+    ArenaPushable& operator=(const ArenaPushable&) = delete;
+    ~ArenaPushable() noexcept { arena.detach(id_); }
+
+    explicit operator bool() const noexcept { return arena.linked(id_); }
+
+    /// Calls the behavior directly, without broadcasting to the topic.
+    void operator()(pass_t<T>... args) const { if (id_ != arena.none) { arena.template invoke<pass_t<T>...>(id_, args...); } }
+
+    void    detach() noexcept { arena.detach(id_); }
+    index_t id() const noexcept { return id_; }
+
+private:
+    index_t id_;
+};
+
+} // namespace ramen
@@ -0,0 +1,93 @@
+/// Deferred message delivery for RAMEN.
+///
+/// Every push through a regular Pusher is a synchronous nested call, so a chain of actors that loops back on itself
+/// grows the stack with every hop. An AsyncPusher breaks such a chain: invoking it only copies the message into
+/// a fixed-capacity ring buffer, and the linked behaviors are triggered later, from the main loop, when drain()
+/// is called. The stack depth of a delivery is therefore bounded by the depth of the subscribers alone.
+///
+///     ramen::AsyncPusher<Command, 8> command_out;   // in the producer
+///     command_out >> consumer.command_in;            // linked as usual
+///     ...
+///     void loop() { command_out.drain(); }
+
+#pragma once
+
+#include "ramen.hpp"
+#include "ring_buffer.hpp"
+#include <cassert>
+#include <cstdint>
+
+namespace ramen
+{
+
+/// What an AsyncPusher does with a message pushed while its queue is full.
+enum class Overflow : std::uint8_t
+{
+    drop_newest, ///< Discard the incoming message.
+    drop_oldest, ///< Discard the oldest queued message to make room.
+    assert_full, ///< Treat overflow as a design error (assertion); the message is dropped if asserts are disabled.
+};
+
+template <typename T, std::size_t capacity, Overflow overflow = Overflow::drop_newest>
+struct AsyncPusher final : public Event<void(pass_t<T>)>
+{
+    using Base = Event<void(pass_t<T>)>;
+    using Base::operator bool;
+    using size_type = typename RingBuffer<T, capacity>::size_type;
+
+    /// Queues a copy of the message for later delivery.
+    void operator()(pass_t<T> msg)
+    {
+        if (!queue_.full())
+        {
+            queue_.push(msg);
+            return;
+        }
+        if (dropped_ < UINT16_MAX) { ++dropped_; }
+        switch (overflow)
+        {
+        case Overflow::drop_oldest: queue_.push_overwrite(msg); break;
+        case Overflow::assert_full: assert(false && "AsyncPusher queue overflow"); break;
+        case Overflow::drop_newest: break;
+        }
+    }
+
+    /// Delivers the messages queued at the time of the call (messages pushed by the subscribers during delivery
+    /// are left for the next drain, so a subscriber that reposts cannot livelock the loop).
+    /// Returns the number of messages delivered.
+    size_type drain()
+    {
+        size_type n = queue_.size();
+        const size_type delivered = n;
+        while (n-- > 0)
+        {
+            const T msg = queue_.front();  // Pop before delivery so that reentrant pushes see the freed slot.
+            queue_.pop_front();
+            Base::operator()(msg);
+        }
+        return delivered;
+    }
+
+    /// Delivers a single queued message if there is one.
+    bool drain_one()
+    {
+        if (queue_.empty()) { return false; }
+        const T msg = queue_.front();
+        queue_.pop_front();
+        Base::operator()(msg);
+        return true;
+    }
+
+    size_type pending() const noexcept { return queue_.size(); }
+    void      clear() noexcept { queue_.clear(); }
+
+    /// Number of messages lost to overflow since the last reset; saturates.
+    std::uint16_t dropped() const noexcept { return dropped_; }
+    void          reset_dropped() noexcept { dropped_ = 0; }
+
+private:
+    RingBuffer<T, capacity> queue_;
+    std::uint16_t           dropped_ = 0;
+};
+
+} // namespace ramen
@@ -0,0 +1,224 @@
+/// Port links between RAMEN networks on different controllers.
+///
+/// A BridgeExport is a Pushable on the sending controller, a BridgeImport a Pusher on the receiving one; the two
+/// stand in for the ends of one link and share a channel number. Messages pushed into the exports of a BridgeLink
+/// are copied into its batch, and flush() sends the batch as a single frame: COBS-encoded records of channel, length
+/// and message bytes, closed by a CRC-16 (see binary_frame.hpp). The receiving BridgeLink checks each frame and
+/// pushes every record through the import of its channel, in the order they were sent.
+///
+///     // Controller A                                  // Controller B
+///     ramen::BridgeLink bridge;                        ramen::BridgeLink bridge;
+///     ramen::BridgeExport<RelayCommand> relay_out(     ramen::BridgeImport<RelayCommand> relay_in(bridge, 1);
+///         bridge, 1);
+///     ramen::Pushable<ramen::Span<const std::uint8_t>> serial2_writer = [](ramen::Span<const std::uint8_t> frame) {
+///         Serial2.write(frame.ptr, frame.len);
+///     };
+///
+///     // In setup(), on A and on B:
+///     sequencer.command_out >> relay_out.in;           relay_in.out >> relays.command_in;
+///     bridge.frame_out >> serial2_writer;              bridge.frame_out >> serial2_writer;
+///
+///     void loop() {
+///         while (Serial2.available() > 0) { bridge.on_byte(static_cast<std::uint8_t>(Serial2.read())); }
+///         ...
+///         bridge.flush();  // Everything pushed during this pass, in one frame
+///     }
+///
+/// The link is transport-agnostic: frames leave through frame_out and bytes come back through on_byte(), so any
+/// UART (RS232, or RS485 on a dedicated pair with its driver enabled) can carry it. Messages are sent as their object
+/// representation, so both controllers must be built from the same declaration with the same compiler, and each
+/// must be trivially copyable. A message that does not fit into the rest of the batch flushes it first; a frame that
+/// arrives damaged is dropped whole, and its messages are lost: a bridge is for state that is sent again, like
+/// commands and readings, not for one-shot events that must arrive.
+///
+/// Imports register with their link when they are constructed, so a link must be defined before its imports.
+/// A channel is delivered to the first import registered for it; records of unknown channels are counted and skipped.
+
+#pragma once
+
+#include "binary_frame.hpp"
+#include "ramen.hpp"
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#ifndef RAMEN_BRIDGE_BATCH_SIZE
+#define RAMEN_BRIDGE_BATCH_SIZE 64 // Record bytes per frame
+#endif
+
+namespace ramen
+{
+
+namespace detail
+{
+/// The part of a BridgeImport its link dispatches to.
+struct BridgeInput
+{
+    using Deliver = void (*)(BridgeInput&, const std::uint8_t*);
+
+    BridgeInput(std::uint8_t channel_, std::uint8_t size_, Deliver deliver_) noexcept
+        : channel(channel_), size(size_), deliver(deliver_)
+    {
+    }
+
+    std::uint8_t channel;
+    std::uint8_t size;
+    Deliver      deliver;
+    BridgeInput* next = nullptr;
+};
+} // namespace detail
+
+/// One end of a serial link between two controllers: batches and frames outgoing records, checks and dispatches
+/// incoming ones.
+class BridgeLink final
+{
+public:
+    static constexpr std::size_t batch_size   = RAMEN_BRIDGE_BATCH_SIZE;
+    static constexpr std::size_t record_head  = 2; // Channel and length
+    static constexpr std::size_t max_message  = batch_size - record_head;
+    static constexpr std::size_t max_frame    = binary_frame::max_frame(batch_size + binary_frame::CRC_SIZE);
+
+    static_assert(batch_size > record_head && batch_size <= 250, "RAMEN_BRIDGE_BATCH_SIZE must be in [3, 250]");
+
+    BridgeLink() noexcept = default;
+    BridgeLink(const BridgeLink&)            = delete;
+    BridgeLink& operator=(const BridgeLink&) = delete;
+
+    /// Encoded frames, delimiters included, for the transport to write out.
+    Pusher<Span<const std::uint8_t>> frame_out;
+
+    /// Triggers flush(), for senders whose messages must not wait for the end of the loop pass.
+    Pushable<> flush_in = [this] { flush(); };
+
+    /// Copies a record into the batch, flushing the batch first if the record does not fit.
+    void send(std::uint8_t channel, const void* message, std::uint8_t size)
+    {
+        if (length_ + record_head + size > batch_size) { flush(); }
+        batch_[length_++] = channel;
+        batch_[length_++] = size;
+        std::memcpy(batch_ + length_, message, size);
+        length_ = static_cast<std::uint8_t>(length_ + size);
+    }
+
+    /// Sends the batch, if it holds any record, as one frame.
+    void flush()
+    {
+        if (length_ == 0) { return; }
+        std::uint8_t wire[max_frame];
+        const std::size_t n = binary_frame::encode_frame(batch_, binary_frame::append_crc(batch_, length_), wire);
+        length_             = 0;
+        frame_out(Span<const std::uint8_t>{wire, n});
+    }
+
+    /// Takes the next byte from the transport; a complete frame is dispatched before this returns.
+    void on_byte(const std::uint8_t byte)
+    {
+        if (byte != binary_frame::DELIMITER)
+        {
+            if (received_ < max_frame) { rx_[received_] = byte; }
+            if (received_ <= max_frame) { ++received_; } // One past max_frame marks a frame too long
+            return;
+        }
+        if (received_ == 0) { return; } // Idle, or the opening delimiter
+        const std::uint16_t received = received_;
+        received_                   = 0;
+        std::size_t length          = 0;
+        if (received > max_frame || !binary_frame::cobs_decode(rx_, received, length) ||
+            !binary_frame::crc_ok(rx_, length))
+        {
+            count(bad_frames_);
+            return;
+        }
+        dispatch(length - binary_frame::CRC_SIZE);
+    }
+
+    /// Registers an import; called by its constructor.
+    void attach(detail::BridgeInput& input) noexcept
+    {
+        detail::BridgeInput** last = &inputs_;
+        while (*last != nullptr) { last = &(*last)->next; }
+        *last = &input;
+    }
+
+    /// Received frames that were too long, not COBS or failed the CRC; saturates at 65535.
+    std::uint16_t bad_frames() const noexcept { return bad_frames_; }
+
+    /// Received records for no import, or of another size than the import's message; saturates at 65535.
+    std::uint16_t unknown_records() const noexcept { return unknown_records_; }
+
+private:
+    std::uint8_t         batch_[batch_size + binary_frame::CRC_SIZE];
+    std::uint8_t         rx_[max_frame];
+    std::uint8_t         length_          = 0; // Of the batch
+    std::uint16_t        received_        = 0; // Bytes of the frame being received
+    std::uint16_t        bad_frames_      = 0;
+    std::uint16_t        unknown_records_ = 0;
+    detail::BridgeInput* inputs_          = nullptr;
+
+    static void count(std::uint16_t& counter) noexcept
+    {
+        if (counter != UINT16_MAX) { ++counter; }
+    }
+
+    void dispatch(const std::size_t length)
+    {
+        std::size_t at = 0;
+        while (at + record_head <= length)
+        {
+            const std::uint8_t channel = rx_[at];
+            const std::uint8_t size    = rx_[at + 1];
+            at += record_head;
+            if (at + size > length) { break; } // Cannot happen with a good CRC, but a peer may be buggy
+            detail::BridgeInput* input = inputs_;
+            while (input != nullptr && input->channel != channel) { input = input->next; }
+            if (input != nullptr && input->size == size) { input->deliver(*input, rx_ + at); }
+            else { count(unknown_records_); }
+            at += size;
+        }
+    }
+};
+
+/// The sending end of a bridged link: messages pushed into `in` go to the import of the same channel on the peer.
+template <typename T>
+struct BridgeExport final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Bridged messages are sent as bytes and must be PODs");
+    static_assert(sizeof(T) <= BridgeLink::max_message, "Bridged message does not fit into RAMEN_BRIDGE_BATCH_SIZE");
+
+    BridgeExport(BridgeLink& link, const std::uint8_t channel) noexcept : link_(link), channel_(channel) {}
+
+    Pushable<T> in = [this](const T& msg) { link_.send(channel_, &msg, static_cast<std::uint8_t>(sizeof(T))); };
+
+private:
+    BridgeLink&        link_;
+    const std::uint8_t channel_;
+};
+
+/// The receiving end of a bridged link: `out` pushes the messages of its channel as they arrive.
+template <typename T>
+struct BridgeImport final : private detail::BridgeInput
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Bridged messages are sent as bytes and must be PODs");
+    static_assert(sizeof(T) <= BridgeLink::max_message, "Bridged message does not fit into RAMEN_BRIDGE_BATCH_SIZE");
+
+    BridgeImport(BridgeLink& link, const std::uint8_t channel) noexcept
+        : detail::BridgeInput(channel, static_cast<std::uint8_t>(sizeof(T)), &deliver_to)
+    {
+        link.attach(*this);
+    }
+
+    BridgeImport(const BridgeImport&)            = delete;
+    BridgeImport& operator=(const BridgeImport&) = delete;
+
+    Pusher<T> out;
+
+private:
+    static void deliver_to(detail::BridgeInput& input, const std::uint8_t* bytes)
+    {
+        T msg;
+        std::memcpy(&msg, bytes, sizeof(T)); // The record may sit at any alignment
+        static_cast<BridgeImport&>(input).out(msg);
+    }
+};
+
+} // namespace ramen
@@ -0,0 +1,279 @@
+/// Statically scheduled pull graphs for RAMEN: a synchronous dataflow executor.
+///
+/// A graph of PullUnary/PullNary nodes is evaluated by pulling from its sinks: each pull recurses into the inputs of
+/// the node, so the stack grows with the depth of the graph, every edge costs a call through a Puller, and a shared
+/// subtree runs once per consumer unless it is Memoized. Dataflow holds such a graph as a table instead. Nodes are
+/// registered with the nodes they read; compile() sorts them once, in topological order, at link time, and evaluate()
+/// then runs the whole graph in one flat loop over that order, each node reading its operands from a contiguous
+/// buffer of values laid out in the same order:
+///
+///     using Graph = ramen::Dataflow<std::int16_t, 8>;
+///     std::int16_t sum(const std::int16_t* in, void*) { return static_cast<std::int16_t>(in[0] + in[1]); }
+///     std::int16_t limit(const std::int16_t* in, void* max) { return std::min(in[0], *static_cast<int16_t*>(max)); }
+///
+///     Graph graph;
+///     const Graph::Node level   = graph.variable(&adc_counts[0]);  // Read at every evaluate()
+///     const Graph::Node offset  = graph.input(-40);                // Set with graph.set()
+///     const Graph::Node trimmed = graph.node(&sum, level, offset);
+///     const Graph::Node limited = graph.node(&limit, &level_max, trimmed);  // With a context for the function
+///
+///     void setup() { if (graph.compile() != Graph::Error::none) { ... } }
+///     void loop() { graph.evaluate(); if (graph.value(limited) > 900) { ... } }
+///
+/// Every node is evaluated once per evaluate(), shared or not, with no recursion and a cost that depends only on the
+/// number of nodes and edges. An operand may be a node registered later (set_operand() rewires one at link time); a
+/// change to the wiring marks the graph for a new sort, which the next evaluate() performs if compile() was not
+/// called again. A cycle, an operand that is not a node or a full table sets error() and leaves the graph unevaluated.
+///
+/// Values are of one type T, and operations are plain function pointers taking the operand values and a context;
+/// captureless lambdas convert to them.
+
+#pragma once
+
+#include "ramen.hpp"
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace ramen
+{
+
+/// A graph of up to max_nodes nodes reading max_operands operands in all (by default two a node, at most 255).
+template <typename T, std::uint8_t max_nodes,
+          std::uint8_t max_operands = static_cast<std::uint8_t>((max_nodes < 128) ? 2U * max_nodes : 255U)>
+class Dataflow final
+{
+    static_assert((max_nodes > 0) && (max_nodes < 0xFF), "A graph holds 1 to 254 nodes");
+
+public:
+    using Node = std::uint8_t;
+    using Op   = T (*)(const T* operands, void* context);
+
+    static constexpr Node         invalid_node = 0xFF;
+    static constexpr std::uint8_t max_arity    = 4;
+
+    enum class Error : std::uint8_t
+    {
+        none,
+        full,        // More nodes or operands than the table holds.
+        bad_operand, // An operand that names no node.
+        cycle,       // A node depends on itself, directly or not.
+    };
+
+    /// Fires after every evaluate() that ran the graph; value() then returns the values of this scan.
+    Pusher<> evaluated_out;
+
+    /// Runs evaluate() on a trigger, e.g. from a rate group or a scan event.
+    Pushable<> evaluate_in = [this] { evaluate(); };
+
+    Dataflow() noexcept
+    {
+        for (std::uint8_t i = 0; i < max_nodes; ++i) { position_[i] = i; }
+    }
+
+    Dataflow(const Dataflow&)            = delete;
+    Dataflow& operator=(const Dataflow&) = delete;
+
+    /// A value that the application sets with set().
+    Node input(const T& initial = T{}) noexcept { return add(nullptr, nullptr, 0, initial); }
+
+    /// A value read from a variable at every evaluate() (single-context data: see ramen_latch.hpp for ISR data).
+    Node variable(const T* const source) noexcept
+    {
+        return add([](const T*, void* context) { return *static_cast<const T*>(context); },
+                   const_cast<T*>(source), 0, T{});
+    }
+
+    /// A node computing op(operands, nullptr) from the values of up to max_arity nodes.
+    template <typename... In, typename = std::enable_if_t<(std::is_convertible_v<In, Node> && ...)>>
+    Node node(const Op op, const In... operands) noexcept
+    {
+        return node(op, nullptr, operands...);
+    }
+
+    /// A node computing op(operands, context).
+    template <typename... In, typename = std::enable_if_t<(std::is_convertible_v<In, Node> && ...)>>
+    Node node(const Op op, void* const context, const In... operands) noexcept
+    {
+        static_assert(sizeof...(In) <= max_arity, "A node reads up to max_arity operands");
+        const Node n = add(op, context, sizeof...(In), T{});
+        if (n != invalid_node)
+        {
+            std::uint8_t slot = 0;
+            ((operands_[first_[n] + slot++] = static_cast<Node>(operands)), ...);
+        }
+        return n;
+    }
+
+    /// Rewires operand `slot` of node `n` to `source`; the graph is sorted again before it next runs.
+    bool set_operand(const Node n, const std::uint8_t slot, const Node source) noexcept
+    {
+        if ((n >= count_) || (slot >= arity_[position_[n]])) { return false; }
+        denormalize();
+        operands_[first_[n] + slot] = source;
+        error_                      = Error::none;
+        return true;
+    }
+
+    /// Sorts the nodes in evaluation order; call once when the graph is complete.
+    Error compile() noexcept
+    {
+        if (error_ == Error::full) { return error_; }
+        denormalize();
+        for (std::uint8_t i = 0; i < first_free_; ++i)
+        {
+            if (operands_[i] >= count_)
+            {
+                error_ = Error::bad_operand;
+                return error_;
+            }
+        }
+
+        // Kahn's algorithm by passes over the table: a node is placed once all of its operands are, in the order of
+        // registration among the ready ones. At most count_ passes, at link time only.
+        std::array<Node, max_nodes> order{};
+        std::array<bool, max_nodes> placed{};
+        std::uint8_t                done = 0;
+        while (done < count_)
+        {
+            const std::uint8_t before = done;
+            for (Node n = 0; n < count_; ++n)
+            {
+                if (placed[n]) { continue; }
+                bool ready = true;
+                for (std::uint8_t j = 0; j < arity_[n]; ++j) { ready = ready && placed[operands_[first_[n] + j]]; }
+                if (ready)
+                {
+                    placed[n]     = true;
+                    order[done++] = n;
+                }
+            }
+            if (done == before)
+            {
+                error_ = Error::cycle;
+                return error_;
+            }
+        }
+
+        // Permute the nodes into that order and take the operands as positions in the buffer of values.
+        gather_all(order);
+        for (std::uint8_t k = 0; k < count_; ++k) { position_[order[k]] = k; }
+        for (std::uint8_t i = 0; i < first_free_; ++i) { operands_[i] = position_[operands_[i]]; }
+        sorted_ = true;
+        error_  = Error::none;
+        return error_;
+    }
+
+    /// Evaluates every node once, in order, sorting the graph first if its wiring changed.
+    void evaluate()
+    {
+        if (!sorted_ && ((error_ != Error::none) || (compile() != Error::none))) { return; }
+        T in[max_arity]{};
+        for (std::uint8_t k = 0; k < count_; ++k)
+        {
+            const Op op = ops_[k];
+            if (op == nullptr) { continue; }
+            const std::uint8_t* const operand = &operands_[first_[k]];
+            for (std::uint8_t j = 0; j < arity_[k]; ++j) { in[j] = values_[operand[j]]; }
+            values_[k] = op(in, contexts_[k]);
+        }
+        if (evaluated_out) { evaluated_out(); }
+    }
+
+    /// Sets the value of an input node.
+    void set(const Node n, const T& val) noexcept
+    {
+        if ((n < count_) && (ops_[position_[n]] == nullptr)) { values_[position_[n]] = val; }
+    }
+
+    /// The value of a node at the last evaluate() (its initial value before).
+    const T& value(const Node n) const noexcept { return values_[position_[(n < count_) ? n : 0]]; }
+
+    Error        error() const noexcept { return error_; }
+    bool         sorted() const noexcept { return sorted_; }
+    std::uint8_t size() const noexcept { return count_; }
+
+private:
+    std::array<Op, max_nodes>                ops_{};      // In evaluation order once sorted, like the four below.
+    std::array<void*, max_nodes>             contexts_{};
+    std::array<std::uint8_t, max_nodes>      arity_{};
+    std::array<std::uint8_t, max_nodes>      first_{};    // Index of the node's first operand in operands_.
+    std::array<T, max_nodes>                 values_{};
+    std::array<Node, max_operands>           operands_{}; // Nodes before the sort, positions after.
+    std::array<std::uint8_t, max_nodes>      position_{}; // The position of each node in evaluation order.
+    std::uint8_t                             count_      = 0;
+    std::uint8_t                             first_free_ = 0;
+    Error                                    error_      = Error::none;
+    bool                                     sorted_     = false;
+
+    Node add(const Op op, void* const context, const std::uint8_t arity, const T& initial) noexcept
+    {
+        if ((count_ >= max_nodes) || (arity > max_operands - first_free_))
+        {
+            error_ = Error::full;
+            return invalid_node;
+        }
+        denormalize();
+        error_        = Error::none;
+        const Node n  = count_++;
+        ops_[n]       = op;
+        contexts_[n]  = context;
+        arity_[n]     = arity;
+        first_[n]     = first_free_;
+        values_[n]    = initial;
+        first_free_   = static_cast<std::uint8_t>(first_free_ + arity);
+        return n;
+    }
+
+    /// The node at a position of the evaluation order.
+    Node handle(const std::uint8_t position) const noexcept
+    {
+        for (Node n = 0; n < count_; ++n)
+        {
+            if (position_[n] == position) { return n; }
+        }
+        return invalid_node;
+    }
+
+    /// Returns a sorted table to registration order, with operands naming nodes, so that it can be changed.
+    void denormalize() noexcept
+    {
+        if (!sorted_) { return; }
+        for (std::uint8_t i = 0; i < first_free_; ++i) { operands_[i] = handle(operands_[i]); }
+        gather_all(position_);
+        for (Node n = 0; n < count_; ++n) { position_[n] = n; }
+        sorted_ = false;
+    }
+
+    void gather_all(const std::array<std::uint8_t, max_nodes>& from) noexcept
+    {
+        gather(ops_, from);
+        gather(contexts_, from);
+        gather(arity_, from);
+        gather(first_, from);
+        gather(values_, from);
+    }
+
+    /// a[k] = a[from[k]] for every node, in place: by the cycles of the permutation, with no copy of the table.
+    template <typename U>
+    void gather(std::array<U, max_nodes>& a, const std::array<std::uint8_t, max_nodes>& from) const noexcept
+    {
+        std::array<bool, max_nodes> moved{};
+        for (std::uint8_t start = 0; start < count_; ++start)
+        {
+            if (moved[start]) { continue; }
+            const U      saved = a[start];
+            std::uint8_t k     = start;
+            while (from[k] != start)
+            {
+                a[k]     = a[from[k]];
+                moved[k] = true;
+                k        = from[k];
+            }
+            a[k]     = saved;
+            moved[k] = true;
+        }
+    }
+};
+
+} // namespace ramen
@@ -0,0 +1,90 @@
+/// Compile-time RAM accounting for RAMEN actors and ports.
+///
+/// Every port and actor has a size that is fixed at compile time, so RAM regressions can be caught before the
+/// firmware is even linked:
+///
+///     static_assert(ramen::footprint_of<led::BlinkyLedActor>().ram <= 64, "BlinkyLedActor grew");
+///     RAMEN_RAM_BUDGET(2048, timer, led1, led2, led3, commander);   // whole network declared in main.cpp
+///
+/// For an inventory of the sizes themselves, define RAMEN_CFG_FOOTPRINT_REPORT and list the objects with
+/// RAMEN_FOOTPRINT_REPORT(obj); each one produces a compiler warning that names the type and its size in bytes
+/// (the warning is the only portable way to print a constant expression during compilation).
+
+#pragma once
+
+#include "ramen.hpp"
+#include <cstddef>
+#include <type_traits>
+
+namespace ramen
+{
+
+struct FootprintInfo
+{
+    std::size_t ram;       ///< sizeof: bytes of SRAM one instance occupies
+    std::size_t alignment; ///< alignof
+};
+
+template <typename T>
+constexpr FootprintInfo footprint_of() noexcept
+{
+    return {sizeof(T), alignof(T)};
+}
+
+/// Sum of the sizes of all listed types. Padding between separately defined globals is not included.
+template <typename... T>
+constexpr std::size_t total_footprint() noexcept
+{
+    return (std::size_t{0} + ... + sizeof(T));
+}
+
+namespace detail
+{
+template <std::size_t fp, std::size_t size>
+struct BehaviorFootprint
+{
+    static constexpr std::size_t capacity = fp;
+    static constexpr std::size_t overhead = size - fp;
+};
+template <typename R, typename... A, std::size_t fp, bool movable>
+BehaviorFootprint<fp, sizeof(Behavior<R(A...), fp, movable>)> behavior_footprint_of(const Behavior<R(A...), fp, movable>*);
+} // namespace detail
+
+/// Behavior storage introspection: the inline capacity reserved for the closure and the bookkeeping around it
+/// (vtable pointer, list links and the Function ops pointer). Works for Pushable/Pullable through their base.
+template <typename T>
+struct behavior_footprint : decltype(detail::behavior_footprint_of(static_cast<const T*>(nullptr))) { };
+
+/// Overhead of a Pusher: list links, the vtable pointer and the sent() count; Pushers have no payload.
+template <typename... T>
+constexpr std::size_t pusher_footprint_v = sizeof(Pusher<T...>);
+
+namespace detail
+{
+template <typename T, std::size_t bytes>
+[[deprecated("footprint report (not an error)")]] constexpr bool footprint_report() noexcept
+{
+    return true;
+}
+
+/// Sums sizeof of the arguments' types without evaluating them; used by RAMEN_RAM_BUDGET.
+template <typename... T>
+constexpr std::size_t decltype_footprint_sum(const T&...) noexcept
+{
+    return total_footprint<T...>();
+}
+} // namespace detail
+
+} // namespace ramen
+
+/// Fails compilation if the listed objects together occupy more than `bytes` of RAM.
+#define RAMEN_RAM_BUDGET(bytes, ...)                                                                           \
+    static_assert(::ramen::detail::decltype_footprint_sum(__VA_ARGS__) <= (bytes),                           \
+                  "RAM budget exceeded: " #__VA_ARGS__ " need more than " #bytes " bytes")
+
+#if defined(RAMEN_CFG_FOOTPRINT_REPORT)
+#define RAMEN_FOOTPRINT_REPORT(obj)                                                                            \
+    static_assert(::ramen::detail::footprint_report<std::remove_reference_t<decltype(obj)>, sizeof(obj)>(), "")
+#else
+#define RAMEN_FOOTPRINT_REPORT(obj) static_assert(true, "")
+#endif
@@ -0,0 +1,130 @@
+/// Tear-free latches for values shared between an interrupt and the main loop.
+///
+/// A ramen::Latch assigns its value with a plain copy, and on AVR a copy of anything wider than a byte is several
+/// instructions an interrupt can fall between: a main loop reading an encoder position, a timestamp or an ADC result
+/// the ISR is writing may see half of the old value and half of the new one. Disabling interrupts around every read
+/// delays the ISR; these latches publish through one 8-bit store instead, which AVR performs atomically.
+///
+/// SeqLatch carries values from an ISR to the main loop. The writer makes a sequence counter odd, stores the value
+/// and makes the counter even again; a reader copies the value between two reads of the counter and retries if it
+/// changed, which only an interrupt arriving during the copy does. The writer never waits, and a reader retries at
+/// most once per interrupt:
+///
+///     ramen::SeqLatch<std::int32_t> position;
+///     ISR(INT4_vect) { position.write(position.unsafe_value() + step()); }  // The writer's own copy, for the ISR only
+///     void setup() { position.out >> display.position_in; }                 // Or position.read() in the loop
+///
+/// DoubleLatch carries values the other way, from the main loop to an ISR (setpoints, PWM tables): an ISR cannot
+/// retry while the code it interrupted finishes a write, so the main loop writes the buffer the ISR is not reading and
+/// then flips the index; the ISR reads whichever buffer the index names, in one piece, as nothing interrupts it.
+///
+///     ramen::DoubleLatch<Profile> profile;
+///     void setup() { planner.profile_out >> profile.in; }
+///     ISR(TIMER3_COMPA_vect) { const Profile& p = profile.read(); ... }
+///
+/// Neither latch runs a port from interrupt context: writes into a SeqLatch and reads of a DoubleLatch from an ISR use
+/// write() and read(), and the ports belong to the main loop.
+
+#pragma once
+
+#include "ramen.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace ramen
+{
+
+/// A value written by one interrupt (or any single context that preempts its readers) and read anywhere it runs.
+template <typename T>
+class SeqLatch final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Latched values are copied across contexts and must be PODs");
+
+public:
+    /// Main-loop port: the latest value, read without tearing.
+    Pullable<T> out = [this](T& val) { val = read(); };
+
+    /// Writer side (typically an ISR); never waits.
+    void write(const T& val) noexcept
+    {
+        sequence_ = static_cast<std::uint8_t>(sequence_ + 1U); // Odd: a write is in progress.
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        value_ = val;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        sequence_ = static_cast<std::uint8_t>(sequence_ + 1U);
+    }
+
+    /// Reader side: copies the value again while a write lands during the copy.
+    T read() const noexcept
+    {
+        T val;
+        read(val);
+        return val;
+    }
+
+    /// As read(), returning the sequence number of the copied value (even; advances by 2 with every write).
+    std::uint8_t read(T& val) const noexcept
+    {
+        for (;;)
+        {
+            const std::uint8_t before = sequence_;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            val = value_;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            if (((before & 1U) == 0) && (sequence_ == before)) { return before; }
+        }
+    }
+
+    /// Copies the value if it was written since the last take(); for a single reader.
+    bool take(T& val) noexcept
+    {
+        const std::uint8_t sequence = read(val);
+        const bool fresh = (sequence != taken_);
+        taken_ = sequence;
+        return fresh;
+    }
+
+    /// The value without the sequence check: consistent only in the writer's context, which no write interrupts.
+    const T& unsafe_value() const noexcept { return value_; }
+
+private:
+    T                     value_{};
+    volatile std::uint8_t sequence_ = 0; // Written by the writer only.
+    std::uint8_t          taken_ = 0;    // Written by the reader only.
+};
+
+/// A value written by the main loop and read by an interrupt (or anything the writer cannot interrupt).
+template <typename T>
+class DoubleLatch final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Latched values are copied across contexts and must be PODs");
+
+public:
+    /// Main-loop port.
+    Pushable<T> in = [this](const T& val) { write(val); };
+
+    /// Writer side: fills the idle buffer, then publishes it with one byte store. Not reentrant with itself.
+    void write(const T& val) noexcept
+    {
+        const std::uint8_t idle = static_cast<std::uint8_t>(active_ ^ 1U);
+        buffers_[idle] = val;
+        std::atomic_signal_fence(std::memory_order_release); // The value must be stored before it is published.
+        active_ = idle;
+    }
+
+    /// Reader side (typically an ISR): the published value, stable until the next write returns.
+    const T& read() const noexcept
+    {
+        const std::uint8_t active = active_;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        return buffers_[active];
+    }
+
+private:
+    std::array<T, 2>      buffers_{};
+    volatile std::uint8_t active_ = 0; // Written by the writer only.
+};
+
+} // namespace ramen
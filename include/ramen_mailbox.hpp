@@ -0,0 +1,94 @@
+/// Interrupt-to-main-loop message injection for RAMEN.
+///
+/// RAMEN ports must not be invoked from interrupt context: a push runs an arbitrary chain of behaviors, which would
+/// then execute inside the ISR with interrupts disabled. SpscMailbox is the sanctioned bridge. The ISR (the single
+/// producer) only copies a small trivially-copyable message into a ring and publishes it by storing an 8-bit index;
+/// the main loop (the single consumer) drains the ring into an ordinary Pusher. Since 8-bit loads and stores are
+/// atomic on AVR and each index is written by one side only, neither side ever disables interrupts.
+///
+///     ramen::SpscMailbox<EdgeSample, 16> edges;
+///     ISR(PCINT0_vect) { edges.push(EdgeSample{PINB, TCNT1}); }
+///     void setup() { edges.out >> input_actor.edge_in; }
+///     void loop()  { edges.drain(); }
+
+#pragma once
+
+#include "ramen.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace ramen
+{
+
+/// Single-producer/single-consumer lock-free ring. The capacity must be a power of two not greater than 128,
+/// so that free-running 8-bit indices distinguish a full ring from an empty one.
+template <typename T, std::uint8_t capacity>
+class SpscMailbox final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Mailbox messages are copied across contexts and must be PODs");
+    static_assert((capacity > 0) && (capacity <= 128) && ((capacity & (capacity - 1U)) == 0),
+                  "Mailbox capacity must be a power of two in [1, 128]");
+
+public:
+    /// Delivery port; linked behaviors are invoked from drain(), i.e. in the consumer's context.
+    Pusher<T> out;
+
+    /// Producer side (typically an ISR). Returns false and counts a drop if the ring is full.
+    bool push(const T& msg) noexcept
+    {
+        const std::uint8_t head = head_;
+        if (static_cast<std::uint8_t>(head - tail_) >= capacity)
+        {
+            if (dropped_ != UINT8_MAX) { dropped_ = static_cast<std::uint8_t>(dropped_ + 1U); }
+            return false;
+        }
+        items_[head & mask] = msg;
+        std::atomic_signal_fence(std::memory_order_release); // The payload must be stored before it is published.
+        head_ = static_cast<std::uint8_t>(head + 1U);
+        return true;
+    }
+
+    /// Consumer side. Returns false if the ring is empty.
+    bool pop(T& out_msg) noexcept
+    {
+        const std::uint8_t tail = tail_;
+        if (tail == head_) { return false; }
+        std::atomic_signal_fence(std::memory_order_acquire);
+        out_msg = items_[tail & mask];
+        std::atomic_signal_fence(std::memory_order_release); // The slot must be read before it is released.
+        tail_ = static_cast<std::uint8_t>(tail + 1U);
+        return true;
+    }
+
+    /// Consumer side: delivers the messages available at the time of the call through `out`.
+    /// Messages arriving during delivery are left for the next call, which bounds the time spent here.
+    std::uint8_t drain()
+    {
+        std::uint8_t n = size();
+        const std::uint8_t delivered = n;
+        T msg;
+        while ((n-- > 0) && pop(msg))
+        {
+            out(msg);
+        }
+        return delivered;
+    }
+
+    std::uint8_t size() const noexcept { return static_cast<std::uint8_t>(head_ - tail_); }
+    bool         empty() const noexcept { return head_ == tail_; }
+
+    /// Number of messages the producer could not store; saturates at 255. Written by the producer only.
+    std::uint8_t dropped() const noexcept { return dropped_; }
+
+private:
+    static constexpr std::uint8_t mask = capacity - 1U;
+
+    std::array<T, capacity> items_{};
+    volatile std::uint8_t   head_    = 0; // Written by the producer only.
+    volatile std::uint8_t   tail_    = 0; // Written by the consumer only.
+    volatile std::uint8_t   dropped_ = 0;
+};
+
+} // namespace ramen
@@ -0,0 +1,625 @@
+/// Compile-time wired actor networks for RAMEN.
+///
+/// A regular RAMEN network is linked at runtime with operator>>: every port carries list pointers and a vtable
+/// pointer, and every link costs a merge/clusterize pass at boot. For the parts of a network whose topology never
+/// changes, the topology can instead be declared as a type:
+///
+///     using AppNetwork = ramen::Network<
+///         ramen::link<RAMEN_PORT(sensor, value_out), RAMEN_PORT(filter, sample_in), RAMEN_PORT(logger, on_sample)>,
+///         ramen::link<RAMEN_PORT(filter, value_out), RAMEN_PORT(output, level_in)>
+///     >;
+///
+///     void setup() { AppNetwork::install(); }
+///
+/// The source of a link must be a StaticPusher. Destinations can be any callable member of a global object:
+/// a Pushable (invoked directly, its list links are never used) or a plain member function, in which case the
+/// fan-out is a sequence of direct calls that the compiler can inline into the generated dispatcher.
+///
+/// C++17 does not allow addresses of subobjects as template arguments, so a port is identified by the global
+/// object plus a pointer to member, and each StaticPusher keeps a single pointer to its generated dispatcher,
+/// set by install(). Destinations carry no link state at all and no linking algorithm runs at boot.
+///
+/// The topology also bounds the stack. A behavior runs on the stack of the push that reached it, so a chain such as
+/// adc -> filter -> alarm bank -> event log nests all of them below the entry port. Declaring, for the destinations
+/// that push on, their frame and the sources they push through lets the Network work out every chain at compile
+/// time, and a ramen::budget bounds them:
+///
+///     template <> struct ramen::deferrable<alarms::Event> : std::true_type {};  // Owns its fields, see below
+///
+///     using AppNetwork = ramen::Network<
+///         ramen::budget<2, 120>,  // At most 2 nested behaviors and 120 bytes of stack below any entry port
+///         ramen::link<RAMEN_PORT(adc, sample_out),
+///                     ramen::behavior<RAMEN_PORT(filter, sample_in), 32, RAMEN_PORT(filter, value_out)>>,
+///         ramen::link<RAMEN_PORT(filter, value_out),
+///                     ramen::behavior<RAMEN_PORT(levels, measurement_in), 40, RAMEN_PORT(levels, event_out)>>,
+///         ramen::link<RAMEN_PORT(levels, event_out), RAMEN_PORT(events, alarm_in)>
+///     >;
+///
+///     static_assert(AppNetwork::stack<RAMEN_PORT(adc, sample_out)>() <= 120);
+///     void loop() { adc.update(); AppNetwork::run(); ... }
+///
+/// Each level of a chain takes the destination's frame (default_behavior_frame for a plain port) and dispatcher_frame
+/// for the dispatcher. Where a chain from any source would go deeper or larger than the budget, the destination that
+/// crosses it is deferred: its dispatcher copies the message into a queue of the link, and run() delivers it later
+/// from the top of the stack, where it starts a new chain, itself within the budget. Deferred destinations get their
+/// messages after the direct ones, and those of a full queue are dropped and counted. depth<Source>(), stack<Source>()
+/// and deferred<Source, Destination>() tell the outcome, so the worst stack holds by construction; a frame that alone
+/// exceeds the budget, or a cycle of pushes without a budget, fails to compile. Pushes into ports outside the Network
+/// are not seen, so a behavior's frame should include them. Without a budget, nothing is deferred.
+///
+/// A deferred message outlives the push, so it must own what it carries. Numbers and enumerators do; a class is
+/// declared to with a specialization of ramen::deferrable, as above, and must also be trivially copyable and not
+/// polymorphic. Pointers, and views such as a command line or a Span into the sender's buffer, would dangle by the
+/// time run() delivers them, and a reference to a base class would be sliced: a link whose destinations are deferred
+/// and whose message is not deferrable fails to compile. Give such a chain a budget it fits in.
+#pragma once
+
+#include "ramen.hpp"
+#include "ring_buffer.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ramen
+{
+
+/// An output port of a statically wired network. It has no list links; Network::install() points it to
+/// a dispatcher generated at compile time for all of its destinations.
+template <typename... T>
+struct StaticPusher final
+{
+    using Dispatch = void (*)(pass_t<T>...);
+
+    constexpr StaticPusher() noexcept = default;
+    StaticPusher(const StaticPusher&)            = delete;
+    StaticPusher& operator=(const StaticPusher&) = delete;
+
+    explicit constexpr operator bool() const noexcept { return dispatch_ != nullptr; }
+
+    void operator()(pass_t<T>... args) const
+    {
+        if (dispatch_ != nullptr) { dispatch_(args...); }
+    }
+
+    void install(const Dispatch dispatch) noexcept { dispatch_ = dispatch; }
+
+private:
+    Dispatch dispatch_ = nullptr;
+};
+
+template <> struct StaticPusher<void> final
+{
+    using Dispatch = void (*)();
+
+    constexpr StaticPusher() noexcept = default;
+    StaticPusher(const StaticPusher&)            = delete;
+    StaticPusher& operator=(const StaticPusher&) = delete;
+
+    explicit constexpr operator bool() const noexcept { return dispatch_ != nullptr; }
+
+    void operator()() const
+    {
+        if (dispatch_ != nullptr) { dispatch_(); }
+    }
+
+    void install(const Dispatch dispatch) noexcept { dispatch_ = dispatch; }
+
+private:
+    Dispatch dispatch_ = nullptr;
+};
+
+/// A port of a global object: `obj` is the address of the object with static storage duration,
+/// `member` is a pointer to a data member (a port) or to a member function.
+template <auto obj, auto member>
+struct port
+{
+    static_assert(std::is_pointer_v<decltype(obj)>, "obj must be the address of a global object");
+    static_assert(std::is_member_pointer_v<decltype(member)>, "member must be a pointer to member");
+
+    static constexpr auto& get() noexcept { return obj->*member; }
+
+    template <typename... A>
+    static void invoke(const A&... args)
+    {
+        (obj->*member)(args...);
+    }
+};
+
+/// Spells out a ramen::port for a member of a global object: RAMEN_PORT(timer, arm_timer_request_in).
+#define RAMEN_PORT(obj, member) ::ramen::port<&(obj), &std::remove_reference_t<decltype(obj)>::member>
+
+/// Stack bytes a generated dispatcher adds to every level of a chain: the return address of its indirect call and
+/// the registers it saves. run() adds as much to the chains it starts.
+constexpr std::size_t dispatcher_frame = 8;
+
+/// Frame assumed for a destination listed as a plain port, without behavior<>.
+constexpr std::size_t default_behavior_frame = 16;
+
+/// A destination of a link declared with what the analysis of a Network needs: the stack `frame` its behavior takes
+/// (from the compiler's -fstack-usage report, say) and the sources of the same Network it pushes synchronously.
+template <typename Port, std::size_t frame, typename... Emits>
+struct behavior
+{
+    template <typename... A>
+    static void invoke(const A&... args)
+    {
+        Port::invoke(args...);
+    }
+};
+
+/// The chain budget of a Network: at most `depth` nested behaviors and `stack` bytes below an entry port; `queue`
+/// messages wait on each link with deferred destinations.
+template <std::size_t depth, std::size_t stack, std::size_t queue = 4>
+struct budget
+{
+    static_assert(depth > 0 && queue > 0, "A budget allows one behavior and one queued message at least");
+
+    static constexpr std::size_t max_depth  = depth;
+    static constexpr std::size_t max_stack  = stack;
+    static constexpr std::size_t queue_size = queue;
+};
+
+using unbounded = budget<SIZE_MAX, SIZE_MAX, 1>;
+
+/// Whether a message of type T may wait in the queue of a deferred link: true for numbers and enumerators, and for the
+/// classes specialized to say they own what they carry.
+template <typename T>
+struct deferrable : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>>
+{
+};
+
+template <typename T>
+constexpr bool deferrable_v = deferrable<std::remove_cv_t<T>>::value && std::is_trivially_copyable_v<T> &&
+                              !std::is_pointer_v<T> && !std::is_polymorphic_v<T>;
+
+namespace detail
+{
+struct DeferrableBase
+{
+    virtual ~DeferrableBase() = default;
+    std::uint8_t value;
+};
+} // namespace detail
+
+static_assert(deferrable_v<std::uint16_t> && deferrable_v<const float> && !deferrable_v<const char*> &&
+                  !deferrable_v<Span<const std::uint8_t>> && !deferrable_v<detail::DeferrableBase>,
+              "Values may be deferred; pointers, views and polymorphic classes may not");
+
+namespace detail
+{
+template <typename... T>
+struct type_list
+{
+    static constexpr std::size_t size = sizeof...(T);
+};
+
+template <typename D>
+struct destination_traits
+{
+    static constexpr std::size_t frame = default_behavior_frame;
+    using emits                        = type_list<>;
+};
+template <typename Port, std::size_t frame_, typename... Emits>
+struct destination_traits<behavior<Port, frame_, Emits...>>
+{
+    static constexpr std::size_t frame = frame_;
+    using emits                        = type_list<Emits...>;
+};
+} // namespace detail
+
+/// Links one StaticPusher source to any number of destinations. Destinations are invoked in the listed order.
+template <typename Source, typename... Destinations>
+struct link
+{
+    static_assert(sizeof...(Destinations) <= 32, "A link has at most 32 destinations");
+
+    using source       = Source;
+    using destinations = detail::type_list<Destinations...>;
+
+    static constexpr std::size_t size       = sizeof...(Destinations);
+    static constexpr std::size_t emit_count =
+        (std::size_t{0} + ... + detail::destination_traits<Destinations>::emits::size);
+
+    template <typename... A>
+    static void dispatch(pass_t<A>... args)
+    {
+        (Destinations::invoke(args...), ...);
+    }
+
+    /// Invokes the destinations whose bit in `mask` is set, the first destination's being bit 0.
+    template <std::uint32_t mask, typename... A>
+    static void dispatch_masked(pass_t<A>... args)
+    {
+        dispatch_each<mask, A...>(std::index_sequence_for<Destinations...>{}, args...);
+    }
+
+private:
+    template <std::uint32_t mask, typename... A, std::size_t... J>
+    static void dispatch_each(std::index_sequence<J...>, pass_t<A>... args)
+    {
+        ((((mask >> J) & 1U) != 0 ? Destinations::invoke(args...) : void()), ...);
+    }
+};
+
+namespace detail
+{
+template <typename P>
+struct StaticPusherArgs;
+template <typename... T>
+struct StaticPusherArgs<StaticPusher<T...>>
+{
+    using message = std::tuple<std::decay_t<T>...>;  // A deferred message, copied
+
+    // Of a reference, what it refers to: a polymorphic one would be sliced
+    static constexpr bool deferrable = (deferrable_v<std::remove_reference_t<T>> && ...);
+
+    template <typename Net, std::size_t index>
+    static void install(StaticPusher<T...>& pusher) noexcept { pusher.install(&Net::template dispatch<index, T...>); }
+
+    template <typename Link, std::uint32_t mask>
+    static void deliver(const message& msg)
+    {
+        std::apply([](const auto&... args) { Link::template dispatch_masked<mask, T...>(args...); }, msg);
+    }
+};
+template <>
+struct StaticPusherArgs<StaticPusher<void>>
+{
+    using message = std::tuple<>;
+
+    static constexpr bool deferrable = true;
+
+    template <typename Net, std::size_t index>
+    static void install(StaticPusher<void>& pusher) noexcept { pusher.install(&Net::template dispatch<index>); }
+
+    template <typename Link, std::uint32_t mask>
+    static void deliver(const message&) { Link::template dispatch_masked<mask>(); }
+};
+
+static_assert(StaticPusherArgs<StaticPusher<int, const std::uint8_t&>>::deferrable &&
+                  !StaticPusherArgs<StaticPusher<const char*>>::deferrable &&
+                  !StaticPusherArgs<StaticPusher<const Span<const char>&>>::deferrable &&
+                  !StaticPusherArgs<StaticPusher<const DeferrableBase&>>::deferrable,
+              "The messages a deferred link refuses: a pointer, a view, a reference to a polymorphic class");
+
+template <typename Source, typename... Links>
+constexpr std::size_t count_source() noexcept
+{
+    return (std::size_t{0} + ... + (std::is_same_v<Source, typename Links::source> ? 1U : 0U));
+}
+
+/// Index of the link of `Source`, or the number of links if it has none.
+template <typename Source, typename... Links>
+constexpr std::size_t source_index() noexcept
+{
+    constexpr bool match[] = {std::is_same_v<Source, typename Links::source>..., false};
+    std::size_t    i       = 0;
+    while (i < sizeof...(Links) && !match[i]) { ++i; }
+    return i;
+}
+
+template <typename D, typename... Ds>
+constexpr std::size_t destination_index(type_list<Ds...>) noexcept
+{
+    constexpr bool match[] = {std::is_same_v<D, Ds>..., false};
+    std::size_t    i       = 0;
+    while (i < sizeof...(Ds) && !match[i]) { ++i; }
+    return i;
+}
+
+/// A destination of a link: its frame and the links its behavior pushes into, emits[first_emit..+emit_count).
+struct ChainEdge
+{
+    std::size_t frame      = 0;
+    std::size_t first_emit = 0;
+    std::size_t emit_count = 0;
+};
+
+/// How deep and how large a chain gets: behaviors nested, and stack bytes.
+struct ChainExtent
+{
+    std::size_t depth = 0;
+    std::size_t stack = 0;
+
+    constexpr void widen(const ChainExtent& other) noexcept
+    {
+        depth = (other.depth > depth) ? other.depth : depth;
+        stack = (other.stack > stack) ? other.stack : stack;
+    }
+};
+
+/// The destinations of link k are edges[first_edge[k]..first_edge[k + 1]).
+template <std::size_t L, std::size_t E, std::size_t M>
+struct ChainGraph
+{
+    std::array<std::size_t, L + 1> first_edge{};
+    std::array<ChainEdge, E>       edges{};
+    std::array<std::size_t, M>     emits{};
+};
+
+template <std::size_t L, std::size_t E>
+struct ChainPlan
+{
+    std::array<bool, E>        deferred{};
+    std::array<ChainExtent, L> entry{};  // Of each source, pushed from outside the network
+    ChainExtent                run{};    // Of the deferred deliveries of run()
+    bool                       changed = false;
+    bool                       cyclic  = false;  // A chain went round: deferred, or an error without a budget
+    bool                       fits    = true;   // False if a behavior on its own exceeds the stack budget
+};
+
+/// The synchronous chains of a network, worked out at compile time: the graph of its links, in which a destination
+/// declared with behavior<> leads on to the links of the sources it pushes, and the plan of the destinations deferred
+/// to keep every chain within the budget.
+template <typename Budget, typename... Links>
+struct ChainAnalysis
+{
+    static constexpr std::size_t link_count = sizeof...(Links);
+    static constexpr std::size_t edge_count = (std::size_t{0} + ... + Links::size);
+    static constexpr std::size_t emit_count = (std::size_t{0} + ... + Links::emit_count);
+
+    using graph_type = ChainGraph<link_count, edge_count, emit_count>;
+    using plan_type  = ChainPlan<link_count, edge_count>;
+
+    static constexpr graph_type build() noexcept
+    {
+        graph_type  g{};
+        std::size_t l = 0;
+        std::size_t e = 0;
+        std::size_t m = 0;
+        ((g.first_edge[l++] = e, add_edges(g, e, m, typename Links::destinations{})), ...);
+        g.first_edge[link_count] = e;
+        return g;
+    }
+
+    /// Walks every chain from every source, and from every deferred destination as run() delivers to it, deferring
+    /// each destination whose level would take a chain beyond the budget, until a pass defers no more. Deferring only
+    /// cuts chains, so the chains a pass has found within the budget stay so.
+    static constexpr plan_type plan(const graph_type& g) noexcept
+    {
+        plan_type p{};
+        do
+        {
+            p.changed = false;
+            p.run     = ChainExtent{};
+            for (std::size_t k = 0; k < link_count; ++k) { p.entry[k] = enter(g, p, k, ChainExtent{}); }
+            for (std::size_t f = 0; f < edge_count; ++f)
+            {
+                if (!p.deferred[f]) { continue; }
+                const ChainExtent level{1, dispatcher_frame + g.edges[f].frame};
+                if (level.stack > Budget::max_stack) { p.fits = false; }
+                p.run.widen(deliver(g, p, f, level));
+            }
+        } while (p.changed);
+        return p;
+    }
+
+private:
+    template <typename... Destinations>
+    static constexpr void add_edges(graph_type& g, std::size_t& e, std::size_t& m, type_list<Destinations...>) noexcept
+    {
+        (add_edge<Destinations>(g, e, m), ...);
+    }
+
+    template <typename D>
+    static constexpr void add_edge(graph_type& g, std::size_t& e, std::size_t& m) noexcept
+    {
+        using traits = destination_traits<D>;
+        g.edges[e++] = ChainEdge{traits::frame, m, traits::emits::size};
+        add_emits(g, m, typename traits::emits{});
+    }
+
+    template <typename... Emits>
+    static constexpr void add_emits(graph_type& g, std::size_t& m, type_list<Emits...>) noexcept
+    {
+        static_assert(((source_index<Emits, Links...>() < link_count) && ...),
+                      "A behavior pushes a source that is not linked in its Network");
+        ((g.emits[m++] = source_index<Emits, Links...>()), ...);
+    }
+
+    /// The chains through the destinations of link `k`, pushed at `at`.
+    static constexpr ChainExtent enter(const graph_type& g, plan_type& p, std::size_t k, ChainExtent at) noexcept
+    {
+        ChainExtent worst = at;
+        for (std::size_t f = g.first_edge[k]; f < g.first_edge[k + 1]; ++f)
+        {
+            if (p.deferred[f]) { continue; }
+            const ChainExtent level{at.depth + 1, at.stack + dispatcher_frame + g.edges[f].frame};
+            if (at.depth == 0 && level.stack > Budget::max_stack) { p.fits = false; }
+            // A chain longer than the edges has been round one of them
+            if (at.depth > 0 && (level.depth > Budget::max_depth || level.stack > Budget::max_stack ||
+                                 level.depth > edge_count))
+            {
+                p.deferred[f] = true;
+                p.changed     = true;
+                p.cyclic      = p.cyclic || level.depth > edge_count;
+                continue;
+            }
+            worst.widen(deliver(g, p, f, level));
+        }
+        return worst;
+    }
+
+    /// The chains of the pushes of destination `f`'s behavior, running at `level`.
+    static constexpr ChainExtent deliver(const graph_type& g, plan_type& p, std::size_t f, ChainExtent level) noexcept
+    {
+        ChainExtent worst = level;
+        for (std::size_t i = 0; i < g.edges[f].emit_count; ++i)
+        {
+            worst.widen(enter(g, p, g.emits[g.edges[f].first_emit + i], level));
+        }
+        return worst;
+    }
+};
+
+template <typename Budget, typename... Links>
+struct NetworkImpl
+{
+    static_assert(((count_source<typename Links::source, Links...>() == 1) && ...),
+                  "Each source port may appear in only one link of a Network");
+
+private:
+    using analysis = ChainAnalysis<Budget, Links...>;
+
+    static constexpr typename analysis::graph_type graph = analysis::build();
+    static constexpr typename analysis::plan_type  plan  = analysis::plan(graph);
+
+    static_assert(plan.fits, "A behavior's frame on its own exceeds the stack budget of the Network");
+    static_assert(!std::is_same_v<Budget, unbounded> || !plan.cyclic,
+                  "The behaviors of a Network push in a cycle; give it a budget to defer a link of it");
+
+public:
+    static void install() noexcept
+    {
+        install_all(std::index_sequence_for<Links...>{});
+    }
+
+    /// Delivers the deferred messages, one per step, those queued during the run included, until none is left or
+    /// `max_steps` were delivered; returns the number delivered. Call it from loop(), where each starts a new chain.
+    static std::uint16_t run(const std::uint16_t max_steps = UINT16_MAX)
+    {
+        std::uint16_t n        = 0;
+        bool          progress = true;
+        while (progress && n < max_steps)
+        {
+            progress = false;
+            run_all(std::index_sequence_for<Links...>{}, n, progress, max_steps);
+        }
+        return n;
+    }
+
+    static constexpr std::size_t link_count     = sizeof...(Links);
+    static constexpr std::size_t deferred_count = [] {
+        std::size_t n = 0;
+        for (const bool deferred : plan.deferred) { n += deferred ? 1U : 0U; }
+        return n;
+    }();
+
+    /// Worst chain below a push of `Source` from outside the network, with the deferred destinations cut off.
+    template <typename Source>
+    static constexpr std::size_t depth() noexcept
+    {
+        return plan.entry[index_of<Source>()].depth;
+    }
+    template <typename Source>
+    static constexpr std::size_t stack() noexcept
+    {
+        return plan.entry[index_of<Source>()].stack;
+    }
+
+    /// Worst chain of the deliveries of run().
+    static constexpr std::size_t run_depth = plan.run.depth;
+    static constexpr std::size_t run_stack = plan.run.stack;
+
+    /// Whether the analysis moved `Destination` of the link of `Source` behind a queue.
+    template <typename Source, typename Destination>
+    static constexpr bool deferred() noexcept
+    {
+        using Link              = link_at<index_of<Source>()>;
+        constexpr std::size_t j = destination_index<Destination>(typename Link::destinations{});
+        static_assert(j < Link::size, "Not a destination of the link of this source");
+        return plan.deferred[graph.first_edge[index_of<Source>()] + j];
+    }
+
+    /// Deferred messages dropped because their queue was full; saturates at 65535.
+    static std::uint16_t dropped() noexcept { return dropped_; }
+
+    template <std::size_t index, typename... T>
+    static void dispatch(pass_t<T>... args)
+    {
+        link_at<index>::template dispatch_masked<mask<index>(false), T...>(args...);
+        if constexpr (mask<index>(true) != 0)
+        {
+            static_assert(args_at<index>::deferrable,
+                          "A destination of this link is deferred, but its message does not own what it carries "
+                          "(see ramen::deferrable): raise the budget, or send a value");
+            if (!queue_<index>.push(message<index>{args...}) && dropped_ != UINT16_MAX) { ++dropped_; }
+        }
+    }
+
+private:
+    template <std::size_t index>
+    using link_at = std::tuple_element_t<index, std::tuple<Links...>>;
+
+    template <std::size_t index>
+    using args_at = StaticPusherArgs<std::remove_reference_t<decltype(link_at<index>::source::get())>>;
+
+    template <std::size_t index>
+    using message = typename args_at<index>::message;
+
+    template <std::size_t index>
+    static inline RingBuffer<message<index>, Budget::queue_size> queue_{};
+
+    static inline std::uint16_t dropped_ = 0;
+
+    template <typename Source>
+    static constexpr std::size_t index_of() noexcept
+    {
+        constexpr std::size_t k = source_index<Source, Links...>();
+        static_assert(k < link_count, "Not a source of this Network");
+        return k;
+    }
+
+    /// The destinations of link `index` that are deferred, or those that are not.
+    template <std::size_t index>
+    static constexpr std::uint32_t mask(const bool deferred) noexcept
+    {
+        std::uint32_t bits = 0;
+        for (std::size_t f = graph.first_edge[index]; f < graph.first_edge[index + 1]; ++f)
+        {
+            if (plan.deferred[f] == deferred) { bits |= std::uint32_t{1} << (f - graph.first_edge[index]); }
+        }
+        return bits;
+    }
+
+    template <std::size_t... I>
+    static void install_all(std::index_sequence<I...>) noexcept
+    {
+        (args_at<I>::template install<NetworkImpl, I>(link_at<I>::source::get()), ...);
+    }
+
+    template <std::size_t... I>
+    static void run_all(std::index_sequence<I...>, std::uint16_t& n, bool& progress, const std::uint16_t max_steps)
+    {
+        (run_one<I>(n, progress, max_steps), ...);
+    }
+
+    template <std::size_t index>
+    static void run_one(std::uint16_t& n, bool& progress, const std::uint16_t max_steps)
+    {
+        if constexpr (mask<index>(true) != 0)
+        {
+            message<index> msg{};
+            if (n < max_steps && queue_<index>.pop(msg))
+            {
+                ++n;
+                progress = true;
+                args_at<index>::template deliver<link_at<index>, mask<index>(true)>(msg);
+            }
+        }
+        else
+        {
+            (void)n;
+            (void)progress;
+            (void)max_steps;
+        }
+    }
+};
+} // namespace detail
+
+/// A statically declared network. Each source may appear in exactly one link; list all of its destinations there.
+/// A ramen::budget as the first argument bounds its chains (see above).
+template <typename... Links>
+struct Network : detail::NetworkImpl<unbounded, Links...>
+{
+};
+
+template <std::size_t depth, std::size_t stack, std::size_t queue, typename... Links>
+struct Network<budget<depth, stack, queue>, Links...> : detail::NetworkImpl<budget<depth, stack, queue>, Links...>
+{
+};
+
+} // namespace ramen
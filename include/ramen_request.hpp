@@ -0,0 +1,185 @@
+/// Asynchronous request/response ports for RAMEN.
+///
+/// A Puller asks and is answered in the same call, which a service behind a BridgeLink or a bus transaction queue
+/// cannot do, and a plain Pusher gets no answer at all. A RequestPort sends each request with a correlation id and
+/// matches the responses that come back later by that id, with up to `capacity` requests in flight at once: the
+/// requests to a remote or bus-attached service are pipelined instead of each waiting for the answer to the one
+/// before. Every request ends in exactly one Result on result_out, either the response or a timeout:
+///
+///     ramen::RequestPort<ReadCmd, Reading, 4> reads;
+///     reads.request_out >> read_out.in;                // BridgeExport<ramen::Request<ReadCmd>>
+///     read_in.out >> reads.response_in;                // BridgeImport<ramen::Response<Reading>>
+///     timer.clock_out >> reads.clock_in;
+///     reads.result_out >> display.reading_in;
+///     const std::uint8_t id = reads(ReadCmd{3}, 200); // 0 if all 4 are in flight
+///
+/// The service answers each Request with a Response of the same id, at once (a RequestServer) or when it is done:
+///
+///     ramen::RequestServer<ReadCmd, Reading> service = [](const ReadCmd& cmd) { return sensors.read(cmd.channel); };
+///     read_in.out >> service.request_in;  service.response_out >> read_out.in;
+///
+/// Like the operators of ramen_timing.hpp, a RequestPort does not read the time itself: its clock_in is linked to
+/// TimerActor::clock_out, so timeouts are checked once per TimerActor::update(), in the units of its clock. A
+/// response that arrives after its request timed out, or with an id nothing is waiting for, is counted and dropped.
+/// Requests and responses are plain aggregates, so they cross a BridgeLink as long as their bodies do.
+
+#pragma once
+
+#include "ramen.hpp"
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace ramen
+{
+
+/// A request with the correlation id its response carries back; id 0 is never sent.
+template <typename T>
+struct Request
+{
+    std::uint8_t id;
+    T            body;
+};
+
+template <typename T>
+struct Response
+{
+    std::uint8_t id;
+    T            body;
+};
+
+/// How a request ended, as reported to the client.
+template <typename T>
+struct Result
+{
+    std::uint8_t id;
+    bool         timed_out; ///< No response, and `body` is default-constructed.
+    T            body;
+};
+
+/// Client side of a request/response pair: sends requests, matches responses to them and times them out.
+template <typename Req, typename Resp, std::uint8_t capacity>
+struct RequestPort
+{
+    static_assert((capacity > 0) && (capacity < 255), "RequestPort capacity must be in [1, 254]");
+    static_assert(std::is_default_constructible_v<Resp>, "A timed-out Result carries a default Resp");
+
+    Pusher<Request<Req>>     request_out{};
+    Pushable<Response<Resp>> response_in = [this](const Response<Resp>& response) { resolve(response); };
+    Pushable<std::uint32_t>  clock_in    = [this](const std::uint32_t& t) { now_ = t; expire(); };
+    Pusher<Result<Resp>>     result_out{};
+
+    /// Sends `body` and returns its id, or 0 if `capacity` requests are in flight already. A response is awaited for
+    /// `timeout` ticks of the clock; the Result may come back before this returns, from a service answering at once.
+    std::uint8_t operator()(const Req& body, const std::uint32_t timeout)
+    {
+        std::uint8_t slot = 0;
+        while ((slot < capacity) && (pending_[slot].id != 0)) { ++slot; }
+        if (slot == capacity)
+        {
+            if (refused_ != UINT16_MAX) { ++refused_; }
+            return 0;
+        }
+        do { next_id_ = static_cast<std::uint8_t>((next_id_ == 255U) ? 1U : (next_id_ + 1U)); }
+        while (find(next_id_) != nullptr); // Skips a request still waiting from 255 ids ago
+        const std::uint8_t id = next_id_;
+        pending_[slot] = Pending{id, now_ + timeout};
+        ++in_flight_;
+        request_out(Request<Req>{id, body});
+        return id;
+    }
+
+    /// Forgets a request in flight, whose Result then never comes; false if it has ended already.
+    bool cancel(const std::uint8_t id) noexcept
+    {
+        Pending* const pending = find(id);
+        if (pending == nullptr) { return false; }
+        release(*pending);
+        return true;
+    }
+
+    bool         in_flight(const std::uint8_t id) const noexcept { return (id != 0) && (find(id) != nullptr); }
+    std::uint8_t in_flight() const noexcept { return in_flight_; }
+    bool         full() const noexcept { return in_flight_ == capacity; }
+
+    /// Counters saturating at 65535: requests refused for want of a slot, requests timed out, and responses dropped
+    /// because no request was waiting for their id.
+    std::uint16_t refused() const noexcept { return refused_; }
+    std::uint16_t timeouts() const noexcept { return timeouts_; }
+    std::uint16_t stale() const noexcept { return stale_; }
+
+private:
+    struct Pending
+    {
+        std::uint8_t  id; ///< 0 for a free slot
+        std::uint32_t deadline;
+    };
+
+    void resolve(const Response<Resp>& response)
+    {
+        Pending* const pending = find(response.id);
+        if (pending == nullptr)
+        {
+            if (stale_ != UINT16_MAX) { ++stale_; }
+            return;
+        }
+        release(*pending);
+        result_out(Result<Resp>{response.id, false, response.body});
+    }
+
+    void expire()
+    {
+        for (Pending& pending : pending_)
+        {
+            if ((pending.id != 0) && (static_cast<std::int32_t>(now_ - pending.deadline) >= 0))
+            {
+                const std::uint8_t id = pending.id;
+                release(pending);
+                if (timeouts_ != UINT16_MAX) { ++timeouts_; }
+                result_out(Result<Resp>{id, true, Resp{}});
+            }
+        }
+    }
+
+    Pending* find(const std::uint8_t id) noexcept
+    {
+        for (Pending& pending : pending_) { if ((id != 0) && (pending.id == id)) { return &pending; } }
+        return nullptr;
+    }
+    const Pending* find(const std::uint8_t id) const noexcept { return const_cast<RequestPort*>(this)->find(id); }
+
+    void release(Pending& pending) noexcept
+    {
+        pending.id = 0;
+        --in_flight_;
+    }
+
+    std::array<Pending, capacity> pending_{};
+    std::uint32_t now_       = 0;
+    std::uint8_t  next_id_   = 0;
+    std::uint8_t  in_flight_ = 0;
+    std::uint16_t refused_   = 0;
+    std::uint16_t timeouts_  = 0;
+    std::uint16_t stale_     = 0;
+};
+
+/// Service side for a function that answers at once: each Request is answered with the function's result under the
+/// same id. A service that answers later keeps the id of the request and pushes its Response itself.
+template <typename Req, typename Resp>
+struct RequestServer
+{
+    template <typename F, typename = std::enable_if_t<std::is_invocable_r_v<Resp, F&, const Req&>>>
+    RequestServer(F&& f) : serve(std::forward<F>(f)) // Not explicit: initialized from a lambda
+    {
+    }
+
+    Function<Resp(const Req&), default_behavior_footprint> serve;
+    Pushable<Request<Req>> request_in = [this](const Request<Req>& request) {
+        const Resp body = serve(request.body);
+        response_out(Response<Resp>{request.id, body});
+    };
+    Pusher<Response<Resp>> response_out{};
+};
+
+} // namespace ramen
@@ -0,0 +1,162 @@
+/// Cooperative priority scheduler for active objects built on RAMEN ports.
+///
+/// An active object is an actor whose inputs are queued instead of being executed synchronously by the caller.
+/// ActiveQueue provides that queue: producers push into its `in` behavior, which stores the message and marks the
+/// queue's priority ready; the Scheduler then delivers one message per run-to-completion step through the queue's
+/// `out` event, always choosing the highest ready priority. There is no preemption: a step always runs to
+/// completion before the next one is selected, so the latency of a high-priority message is bounded by the
+/// longest single step of any actor, not by the backlog of lower-priority work.
+///
+///     ramen::Scheduler sched;
+///     ramen::ActiveQueue<LedCommandEvent, 4> led_queue;    // inbox of the executor
+///     parser.led_command_out >> led_queue.in;
+///     led_queue.out >> executor.command_in;
+///     sched.attach(led_queue, 6);
+///     ...
+///     void loop() { sched.run(); timer.update(); }
+///
+/// Each priority level hosts at most one queue (like QP-nano); there are 8 levels, 7 being the highest.
+
+#pragma once
+
+#include "ramen.hpp"
+#include "ring_buffer.hpp"
+#include <array>
+#include <cstdint>
+
+namespace ramen
+{
+
+class Scheduler;
+
+namespace detail
+{
+/// Index of the most significant set bit of a nibble; entry 0 is unused.
+constexpr std::array<std::uint8_t, 16> log2_nibble{{0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3}};
+
+constexpr std::uint8_t log2_u8(const std::uint8_t x) noexcept
+{
+    return ((x & 0xF0U) != 0) ? static_cast<std::uint8_t>(4U + log2_nibble[x >> 4U]) : log2_nibble[x & 0x0FU];
+}
+
+class ActiveBase
+{
+    friend class ramen::Scheduler;
+
+public:
+    ActiveBase()                             = default;
+    ActiveBase(const ActiveBase&)            = delete;
+    ActiveBase& operator=(const ActiveBase&) = delete;
+
+    std::uint8_t priority() const noexcept { return priority_; }
+    bool         attached() const noexcept { return sched_ != nullptr; }
+
+protected:
+    ~ActiveBase() noexcept = default;
+
+    inline void mark_ready() noexcept;
+    inline void mark_idle() noexcept;
+
+    /// Delivers one queued message. Called by the scheduler only when the queue is marked ready.
+    virtual void step() = 0;
+
+private:
+    Scheduler*   sched_    = nullptr;
+    std::uint8_t priority_ = 0;
+};
+} // namespace detail
+
+class Scheduler
+{
+public:
+    static constexpr std::uint8_t priority_levels = 8;
+
+    Scheduler()                            = default;
+    Scheduler(const Scheduler&)            = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /// Registers an active object at the given priority (0..7, 7 is the highest). Returns false if the priority
+    /// is out of range or already taken.
+    bool attach(detail::ActiveBase& ao, const std::uint8_t priority) noexcept
+    {
+        if ((priority >= priority_levels) || (table_[priority] != nullptr) || ao.attached()) { return false; }
+        table_[priority] = &ao;
+        ao.sched_        = this;
+        ao.priority_     = priority;
+        return true;
+    }
+
+    /// Executes one run-to-completion step of the highest-priority ready active object.
+    /// Returns false if nothing was ready.
+    bool run_once()
+    {
+        if (ready_ == 0) { return false; }
+        table_[detail::log2_u8(ready_)]->step();
+        return true;
+    }
+
+    /// Runs steps until no active object is ready or `max_steps` were executed; returns the number executed.
+    /// Bounding the count keeps timer polling and other loop work going under a message flood.
+    std::uint16_t run(const std::uint16_t max_steps = UINT16_MAX)
+    {
+        std::uint16_t n = 0;
+        while ((n < max_steps) && run_once()) { ++n; }
+        return n;
+    }
+
+    bool         idle() const noexcept { return ready_ == 0; }
+    std::uint8_t ready_mask() const noexcept { return ready_; }
+
+private:
+    friend class detail::ActiveBase;
+
+    std::array<detail::ActiveBase*, priority_levels> table_{};
+    std::uint8_t                                     ready_ = 0;
+};
+
+inline void detail::ActiveBase::mark_ready() noexcept
+{
+    if (sched_ != nullptr) { sched_->ready_ |= static_cast<std::uint8_t>(1U << priority_); }
+}
+
+inline void detail::ActiveBase::mark_idle() noexcept
+{
+    if (sched_ != nullptr) { sched_->ready_ &= static_cast<std::uint8_t>(~(1U << priority_)); }
+}
+
+/// The bounded inbox of an active object. Messages pushed into `in` are queued (dropped and counted when full);
+/// the scheduler delivers them one per step through `out`, in FIFO order.
+template <typename T, std::size_t capacity>
+struct ActiveQueue final : public detail::ActiveBase
+{
+    Pushable<T> in = [this](const T& msg) { post(msg); };
+    Pusher<T>   out;
+
+    bool post(const T& msg)
+    {
+        if (!queue_.push(msg))
+        {
+            if (dropped_ < UINT16_MAX) { ++dropped_; }
+            return false;
+        }
+        mark_ready();
+        return true;
+    }
+
+    typename RingBuffer<T, capacity>::size_type pending() const noexcept { return queue_.size(); }
+    std::uint16_t                               dropped() const noexcept { return dropped_; }
+
+private:
+    void step() override
+    {
+        const T msg = queue_.front();
+        queue_.pop_front();
+        if (queue_.empty()) { mark_idle(); }
+        out(msg);
+    }
+
+    RingBuffer<T, capacity> queue_;
+    std::uint16_t           dropped_ = 0;
+};
+
+} // namespace ramen
@@ -0,0 +1,79 @@
+/// Time-aware stream operators for RAMEN.
+///
+/// These have the same `in`/`out` shape as PushUnary but decide when (or whether) a value is forwarded based on
+/// time. None of them reads millis() itself: each has a `clock_in` port that is linked to a shared clock, normally
+/// TimerActor::clock_out, which pushes the current time once per TimerActor::update(). Time therefore advances in
+/// steps of one main-loop iteration, and all operators in the firmware agree on it.
+///
+///     ramen::PushDebounce<bool> contact{20};          // 20 ms settle time
+///     timer.clock_out >> contact.clock_in;
+///     input.level_out >> contact.in;
+///     contact.out >> fsm.level_in;
+
+#pragma once
+
+#include "ramen.hpp"
+#include <array>
+#include <cstdint>
+
+namespace ramen
+{
+
+using millis_t = std::uint32_t;
+
+/// Forwards at most one value per period; values arriving before the period has elapsed are dropped (leading edge).
+template <typename T_val>
+struct PushThrottle
+{
+    explicit PushThrottle(const millis_t period_) : period(period_) {}
+    millis_t period; millis_t now = 0; millis_t last = 0; bool primed = false;
+    Pushable<millis_t> clock_in = [this](const millis_t& t) { now = t; };
+    Pushable<T_val>    in       = [this](const T_val& val) { if (!primed || ((now - last) >= period)) { last = now; primed = true; if (out) out(val); } };
+    Pusher<T_val>      out{};
+};
+
+/// Forwards the latest value once no new value has arrived for the settle time (trailing edge).
+template <typename T_val>
+struct PushDebounce
+{
+    explicit PushDebounce(const millis_t settle_) : settle(settle_) {}
+    millis_t settle; millis_t now = 0; millis_t since = 0; T_val pending{}; bool has_pending = false;
+    Pushable<millis_t> clock_in = [this](const millis_t& t) { now = t; if (has_pending && ((now - since) >= settle)) { has_pending = false; if (out) out(pending); } };
+    Pushable<T_val>    in       = [this](const T_val& val) { pending = val; since = now; has_pending = true; };
+    Pusher<T_val>      out{};
+};
+
+/// Forwards the latest value once per period, provided a new value has arrived since the previous sample.
+template <typename T_val>
+struct PushSample
+{
+    explicit PushSample(const millis_t period_) : period(period_) {}
+    millis_t period; millis_t last = 0; T_val latest{}; bool fresh = false; bool primed = false;
+    Pushable<millis_t> clock_in = [this](const millis_t& t) {
+        if (!primed) { last = t; primed = true; return; }
+        if ((t - last) < period) { return; }
+        last = ((t - last) >= (2U * period)) ? t : (last + period); // Keep the phase unless samples were missed.
+        if (fresh) { fresh = false; if (out) out(latest); }
+    };
+    Pushable<T_val>    in       = [this](const T_val& val) { latest = val; fresh = true; };
+    Pusher<T_val>      out{};
+};
+
+/// Accumulates up to `capacity` values and forwards them as one Span batch when full, when `flush` is triggered, or,
+/// if `max_age` is non-zero, once the oldest buffered value is older than `max_age`. The batch refers to the internal
+/// buffer and is valid only for the duration of the dispatch.
+template <typename T_val, std::size_t capacity>
+struct PushBatch
+{
+    static_assert((capacity > 0) && (capacity <= UINT8_MAX), "PushBatch capacity must be in [1, 255]");
+    explicit PushBatch(const millis_t max_age_ = 0) : max_age(max_age_) {}
+    millis_t max_age; millis_t now = 0; millis_t since = 0; std::array<T_val, capacity> items{}; std::uint8_t count = 0;
+    Pushable<millis_t> clock_in = [this](const millis_t& t) { now = t; if ((max_age > 0) && (count > 0) && ((now - since) >= max_age)) { emit(); } };
+    Pushable<T_val>    in       = [this](const T_val& val) { if (count == 0) { since = now; } items[count++] = val; if (count >= capacity) { emit(); } };
+    Pushable<>         flush    = [this] { if (count > 0) { emit(); } };
+    Pusher<Span<const T_val>> out{};
+private:
+    void emit() { const Span<const T_val> batch(items.data(), count); count = 0; if (out) out(batch); }
+};
+
+} // namespace ramen
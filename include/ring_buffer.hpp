@@ -0,0 +1,95 @@
+#pragma once
+
+#include "small_size.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ramen
+{
+
+/// Fixed-capacity FIFO with no dynamic allocation. Indices use the smallest type that fits the capacity.
+/// Usable in constant expressions. Not interrupt-safe; use SpscMailbox for ISR-to-main-loop exchange.
+template <typename T, std::size_t N>
+class RingBuffer
+{
+    static_assert(N > 0, "RingBuffer capacity must be positive");
+
+public:
+    using value_type = T;
+    using size_type  = small_size_t<N>;
+
+    static constexpr size_type capacity() noexcept { return static_cast<size_type>(N); }
+
+    constexpr size_type size() const noexcept { return count_; }
+    constexpr bool      empty() const noexcept { return count_ == 0; }
+    constexpr bool      full() const noexcept { return count_ == N; }
+
+    constexpr void clear() noexcept
+    {
+        while (!empty()) { pop_front(); }
+        head_ = 0;
+    }
+
+    /// Appends an item; returns false and leaves the buffer unchanged if it is full.
+    constexpr bool push(const T& item) noexcept(std::is_nothrow_copy_assignable_v<T>)
+    {
+        if (full()) { return false; }
+        items_[wrap(head_ + count_)] = item;
+        ++count_;
+        return true;
+    }
+
+    /// Appends an item, discarding the oldest one if the buffer is full. Returns false if an item was discarded.
+    constexpr bool push_overwrite(const T& item) noexcept(std::is_nothrow_copy_assignable_v<T>)
+    {
+        const bool was_full = full();
+        if (was_full) { pop_front(); }
+        push(item);
+        return !was_full;
+    }
+
+    /// Removes the oldest item into `out`; returns false if the buffer is empty.
+    constexpr bool pop(T& out) noexcept(std::is_nothrow_copy_assignable_v<T>)
+    {
+        if (empty()) { return false; }
+        out = items_[head_];
+        pop_front();
+        return true;
+    }
+
+    constexpr T&       front() noexcept { return items_[head_]; }
+    constexpr const T& front() const noexcept { return items_[head_]; }
+    constexpr T&       back() noexcept { return items_[wrap(head_ + count_ - 1U)]; }
+    constexpr const T& back() const noexcept { return items_[wrap(head_ + count_ - 1U)]; }
+
+    constexpr void pop_front() noexcept
+    {
+        if (!empty())
+        {
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                items_[head_] = T{}; // Release whatever the item holds (e.g. a reference-counted event).
+            }
+            head_ = wrap(head_ + 1U);
+            --count_;
+        }
+    }
+
+    /// Access by age: index 0 is the oldest item.
+    constexpr T&       operator[](const size_type index) noexcept { return items_[wrap(head_ + index)]; }
+    constexpr const T& operator[](const size_type index) const noexcept { return items_[wrap(head_ + index)]; }
+
+private:
+    static constexpr size_type wrap(const std::size_t index) noexcept
+    {
+        return static_cast<size_type>((index >= N) ? (index - N) : index);
+    }
+
+    std::array<T, N> items_{};
+    size_type        head_  = 0;
+    size_type        count_ = 0;
+};
+
+} // namespace ramen
@@ -0,0 +1,71 @@
+#pragma once
+#include "ramen.hpp"
+#include <Controllino.h>
+#include <chrono>
+#include <cstdint>
+
+// The time of the scan, read once per loop() pass: millis() holds off interrupts for every call, and a pass that calls
+// it from the TimerActor, the function blocks and the trace hooks sees a few slightly different "nows". With the
+// scan clock, sample() at the top of loop() reads it once and everything after takes the same timestamp from a
+// variable until the next pass, so the logic of one scan runs at one instant:
+//
+//     scan_clock::ScanClockActor scan_time;
+//     TimerActor<4, DefaultTimerQueue, scan_clock::Clock> timer;  // Deadlines from the scan's time
+//
+//     void loop() {
+//         scan_time.sample();
+//         ...                                // scan_clock::now(), or a Puller linked to scan_time.time_out
+//         timer.update();
+//     }
+//
+// The time then advances in steps of one pass: a timer armed late in a pass counts its interval from the start of the
+// pass, and one due during a pass fires in the next. fb::ScanClock (function_blocks.hpp) and the timestamps of
+// sml_trace take their time here as well.
+//
+// Opt-in with -D SCAN_CLOCK. Without it ENABLED is false, sample() does nothing and now() is millis(), so the same
+// code runs on the direct reads.
+
+namespace scan_clock {
+
+using Timestamp = std::uint32_t;
+
+#if defined(SCAN_CLOCK)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+namespace detail {
+inline Timestamp sampled_ms = 0;  // Written and read by the main loop only
+inline std::uint32_t scans = 0;
+} // namespace detail
+
+// Milliseconds at the last sample(), or millis() without the scan clock
+inline Timestamp now() { return ENABLED ? detail::sampled_ms : static_cast<Timestamp>(millis()); }
+
+// Clock of a TimerActor on the scan's time. A deadline reached since the sample keeps the CPU from idling at the end
+// of the pass one millisecond early, hence the guard
+struct Clock {
+    using duration = std::chrono::milliseconds;
+    static constexpr std::uint32_t IDLE_SLEEP_GUARD = ENABLED ? 1 : 0;
+    static std::uint32_t now() { return scan_clock::now(); }
+    static constexpr std::uint32_t ticks(duration interval) { return static_cast<std::uint32_t>(interval.count()); }
+};
+
+// Samples the time for the pass and serves it to pullers; one per firmware, as the time it samples is shared
+class ScanClockActor {
+public:
+    ramen::Pullable<Timestamp> time_out = [](Timestamp& t) { t = scan_clock::now(); };
+
+    void sample() {
+        if (ENABLED) {
+            detail::sampled_ms = static_cast<Timestamp>(millis());
+            ++detail::scans;
+        }
+    }
+
+    Timestamp now() const { return scan_clock::now(); }
+    std::uint32_t scans() const { return detail::scans; }
+};
+
+} // namespace scan_clock
@@ -0,0 +1,149 @@
+#pragma once
+#include "timer_latency.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+
+// Scan-cycle monitor, the PLC "scan time" of the firmware: how long each loop() pass works before it goes idle, with
+// the minimum, maximum, the average of the last second and a histogram; the longest time each stage of the pass took,
+// and which stage took most of the longest pass; and the CPU utilization, the fraction of time spent working instead
+// of in the idle hook. The 'scan' command prints them and the telemetry frames carry the headline figures.
+//
+//     void loop() {
+//         scan_monitor::begin_scan();
+//         scan_monitor::stage(scan_monitor::COMMANDER, [] { commander.update(); });
+//         ...
+//         scan_monitor::end_busy();
+//         idle_sleep::sleep(timer);
+//     }
+//
+// A scan runs from begin_scan() to end_busy(), a period from one begin_scan() to the next, idle time included. Times
+// come from micros(), so they are multiples of 4 us. The histogram (timer_latency::Histogram) counts scan times in
+// units of BUCKET_US: bucket 0 holds scans under 16 us, bucket i those in [16 * 2^(i-1), 16 * 2^i) us. Utilization and
+// the average are those of the last window of at least WINDOW_US; with -D IDLE_SLEEP_DISABLE the loop never idles and
+// the utilization reads 100%.
+//
+// Opt-in with -D SCAN_MONITOR. Without it ENABLED is false, stage() just runs its function and the rest does nothing.
+
+namespace scan_monitor {
+
+#if defined(SCAN_MONITOR)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// The stages of loop(), in the order it runs them (SCRIPT is the boot script, whose name is taken by its build flag)
+enum Stage : std::uint8_t { MODBUS = 0, COMMANDER, NETWORK, CONFIG, SCRIPT, LOGIC, TIMERS, STAGE_COUNT };
+
+constexpr std::uint8_t BUCKET_US = 16;
+constexpr std::uint32_t WINDOW_US = 1000000UL;
+
+struct Stats {
+    std::uint32_t scans = 0;
+    std::uint32_t min_us = UINT32_MAX;
+    std::uint32_t max_us = 0;
+    std::uint32_t max_period_us = 0;
+    std::uint32_t avg_us = 0;          // Of the last window
+    std::uint16_t busy_permille = 0;   // Of the last window
+    bool window_done = false;          // False until a window has passed since reset
+    Stage slowest_stage = MODBUS;      // The stage that took most of the longest scan
+    timer_latency::Histogram histogram;
+    std::array<std::uint32_t, STAGE_COUNT> stage_max_us{};
+};
+
+namespace detail {
+inline Stats stats;
+inline bool scanning = false;  // Between begin_scan() and end_busy()
+inline bool started = false;   // A scan has begun since reset, so the next begin_scan() ends a period
+inline std::uint32_t scan_start = 0;
+inline std::uint32_t window_start = 0;
+inline std::uint32_t window_busy_us = 0;
+inline std::uint32_t window_scans = 0;
+inline std::array<std::uint32_t, STAGE_COUNT> stage_us{};  // Of the current scan
+} // namespace detail
+
+inline const Stats& stats() { return detail::stats; }
+
+// Clears the statistics; the scan under way is not counted
+inline void reset() {
+    detail::stats = Stats{};
+    detail::scanning = false;
+    detail::started = false;
+}
+
+inline void begin_scan() {
+    if (!ENABLED) {
+        return;
+    }
+    const std::uint32_t now = micros();
+    if (detail::started) {
+        const std::uint32_t period = now - detail::scan_start;
+        if (period > detail::stats.max_period_us) {
+            detail::stats.max_period_us = period;
+        }
+        const std::uint32_t window = now - detail::window_start;
+        if (window >= WINDOW_US) {
+            const std::uint32_t permille = detail::window_busy_us / (window / 1000U);
+            detail::stats.busy_permille = static_cast<std::uint16_t>((permille > 1000U) ? 1000U : permille);
+            detail::stats.avg_us = (detail::window_scans > 0) ? detail::window_busy_us / detail::window_scans : 0;
+            detail::stats.window_done = true;
+            detail::window_start = now;
+            detail::window_busy_us = 0;
+            detail::window_scans = 0;
+        }
+    } else {
+        detail::window_start = now;
+        detail::window_busy_us = 0;
+        detail::window_scans = 0;
+    }
+    detail::started = true;
+    detail::scanning = true;
+    detail::scan_start = now;
+    detail::stage_us.fill(0);
+}
+
+// Runs one stage of the scan, e.g. stage(TIMERS, [] { timer.update(); })
+template <class F>
+void stage(Stage s, F&& f) {
+    if (!ENABLED) {
+        f();
+        return;
+    }
+    const std::uint32_t start = micros();
+    f();
+    const std::uint32_t elapsed = micros() - start;
+    detail::stage_us[s] += elapsed;
+    if (elapsed > detail::stats.stage_max_us[s]) {
+        detail::stats.stage_max_us[s] = elapsed;
+    }
+}
+
+// Ends the scan; the idle hook follows
+inline void end_busy() {
+    if (!ENABLED || !detail::scanning) {
+        return;
+    }
+    detail::scanning = false;
+    const std::uint32_t busy = static_cast<std::uint32_t>(micros()) - detail::scan_start;
+    Stats& s = detail::stats;
+    ++s.scans;
+    if (busy < s.min_us) {
+        s.min_us = busy;
+    }
+    if (busy > s.max_us) {
+        s.max_us = busy;
+        std::uint8_t slowest = 0;
+        for (std::uint8_t i = 1; i < STAGE_COUNT; ++i) {
+            if (detail::stage_us[i] > detail::stage_us[slowest]) {
+                slowest = i;
+            }
+        }
+        s.slowest_stage = static_cast<Stage>(slowest);
+    }
+    s.histogram.record(busy / BUCKET_US);
+    detail::window_busy_us += busy;
+    ++detail::window_scans;
+}
+
+} // namespace scan_monitor
@@ -0,0 +1,574 @@
+#pragma once
+#include "fast_pin.hpp"
+#include "input_record.hpp"
+#include "ramen_mailbox.hpp"
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// The programming port (USART0) with output that never stalls the main loop.
+//
+// The core's Serial queues at most 64 bytes for transmission and then waits in write() until the UART has sent
+// enough of them: at 9600 baud, the help text holds loop() for over half a second. With -D SERIAL_BUFFERED_OUTPUT this
+// module takes over USART0 instead. Output goes to a ring of SERIAL_TX_BUFFER_SIZE bytes that the data register empty
+// interrupt drains, input arrives through the receive interrupt in `rx`. Every write states what happens if the ring
+// is full: Overflow::DROP discards the message whole and counts it, Overflow::BLOCK waits for room like Serial does.
+// Producers with much to say check tx_free() (or SerialOutputActor::can_accept) and continue on a later pass.
+//
+//     serial_port::begin(9600);
+//     serial_port::write_line("Ready", serial_port::Overflow::DROP);
+//     while (serial_port::available() > 0) { parse(serial_port::read()); }
+//
+// The core defines the USART0 interrupts in the same object file as Serial (HardwareSerial0.cpp), which is only
+// linked if Serial is used; with the option set, nothing in the firmware may use Serial. Without it, and off AVR,
+// the functions fall back to Serial, which never drops.
+//
+// The rate can change while the port runs (set_baud(), after tx_idle()), e.g. from the 'baud' command, to any rate
+// the 16 MHz clock divides to within MAX_RATE_ERROR_PERMILLE: divisor() picks the UART's normal or double speed,
+// whichever comes nearer. The receive interrupt counts framing errors, the sign of a peer at another rate, in
+// framing_errors.
+//
+// A peer that streams, say a script of commands at a megabaud, overruns the receive buffer between two passes of the
+// loop; flow control tells it to wait instead. When `rx` fills to RX_HIGH_WATER the receive interrupt asks the peer to
+// stop, and the main loop asks it to go on once read() has taken the buffer down to RX_LOW_WATER:
+//   -D SERIAL_XON_XOFF   sends XOFF (0x13) and XON (0x11) ahead of any queued output, and honours the peer's: those
+//                        bytes never reach the input, so the option is for text only (not SERIAL_BINARY_PROTOCOL)
+//   -D SERIAL_RTS_PIN=p  drives RTS on spare pin p, low while the peer may send
+//   -D SERIAL_CTS_PIN=p  sends while the peer holds CTS on pin p (pulled up) low; call poll() every pass to resume
+// Both need SERIAL_BUFFERED_OUTPUT, whose interrupts do the work.
+//
+// With -D SERIAL_ABORT, the byte ABORT (CAN, Ctrl-X on a terminal) is a priority lane past everything queued: the
+// receive interrupt takes it out of the input, empties the transmit ring of the bulk output waiting there, and notes
+// how many received bytes came before it. take_abort() then drops those bytes, which the main loop takes before any
+// other input, so an emergency stop acts after the step running when it arrives, however long the queues were. The
+// rest of a message being written at that moment may still follow. Binary frames are followed as the endpoint reads
+// them, so an ABORT byte inside one is data. Without SERIAL_BUFFERED_OUTPUT, the byte arrives through read() in turn.
+//
+// The bytes read are recorded with -D INPUT_RECORD; with -D INPUT_REPLAY they come from `rx` instead, into which the
+// replay injects them, on every build (see input_record.hpp).
+
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 512  // A power of two
+#endif
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 64  // A power of two, at most 128
+#endif
+
+#if defined(SERIAL_XON_XOFF) && defined(SERIAL_BINARY_PROTOCOL)
+#error "SERIAL_XON_XOFF takes the bytes 0x11 and 0x13 out of the input, which binary frames carry: use RTS/CTS"
+#endif
+
+namespace serial_port {
+
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT) && (defined(SERIAL_XON_XOFF) || defined(SERIAL_RTS_PIN))
+constexpr bool RX_FLOW_CONTROL = true;
+#else
+constexpr bool RX_FLOW_CONTROL = false;
+#endif
+
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT) && defined(SERIAL_ABORT)
+constexpr bool ABORT_ENABLED = true;
+#else
+constexpr bool ABORT_ENABLED = false;
+#endif
+
+constexpr std::uint8_t XON = 0x11;
+constexpr std::uint8_t XOFF = 0x13;
+constexpr std::uint8_t ABORT = 0x18;
+// The peer may send a few bytes more after XOFF (those in its UART and USB bridge), 16 at most
+constexpr std::uint8_t RX_HIGH_WATER = SERIAL_RX_BUFFER_SIZE - 16;
+constexpr std::uint8_t RX_LOW_WATER = SERIAL_RX_BUFFER_SIZE / 4;
+static_assert(!RX_FLOW_CONTROL || SERIAL_RX_BUFFER_SIZE >= 32, "Flow control needs an RX buffer of 32 bytes or more");
+
+#if defined(F_CPU)
+constexpr unsigned long CPU_HZ = F_CPU;
+#else
+constexpr unsigned long CPU_HZ = 16000000UL;  // The ATmega2560 of the Controllino
+#endif
+
+constexpr unsigned long DEFAULT_BAUD = 9600;  // Of every boot, and of terminals that know nothing else
+constexpr std::uint16_t MAX_RATE_ERROR_PERMILLE = 25;  // Of the baud rates accepted; 115200 is 21 off at 16 MHz
+
+// Baud rate register setting
+struct Divisor {
+    std::uint16_t ubrr;
+    bool double_speed;            // U2X: 8 samples a bit instead of 16
+    std::int16_t error_permille;  // Of the rate obtained against the one asked for
+};
+
+namespace detail {
+
+constexpr Divisor divisor_at(unsigned long baud, unsigned long clock, unsigned long samples) {
+    const unsigned long long per_bit = static_cast<unsigned long long>(samples) * baud;
+    unsigned long long ubrr = (clock + per_bit / 2U) / per_bit;
+    ubrr = (ubrr == 0U) ? 0U : ((ubrr > 4096U) ? 4095U : ubrr - 1U);
+    const long long actual = static_cast<long long>(clock / (samples * (ubrr + 1U)));
+    const long long error = (actual - static_cast<long long>(baud)) * 1000 / static_cast<long long>(baud);
+    return Divisor{static_cast<std::uint16_t>(ubrr), samples == 8U,
+                   static_cast<std::int16_t>((error > 1000) ? 1000 : ((error < -1000) ? -1000 : error))};
+}
+
+constexpr std::int16_t magnitude(std::int16_t error) { return static_cast<std::int16_t>((error < 0) ? -error : error); }
+
+} // namespace detail
+
+// The setting nearest to `baud`: at normal speed, which tolerates more noise, unless double speed comes nearer
+constexpr Divisor divisor(unsigned long baud, unsigned long clock = CPU_HZ) {
+    if (baud == 0U) {
+        return Divisor{0, true, 1000};
+    }
+    const Divisor normal = detail::divisor_at(baud, clock, 16U);
+    const Divisor fast = detail::divisor_at(baud, clock, 8U);
+    return (detail::magnitude(fast.error_permille) < detail::magnitude(normal.error_permille)) ? fast : normal;
+}
+
+// Whether the port runs at `baud` closely enough for a peer at the exact rate
+constexpr bool supported(unsigned long baud, unsigned long clock = CPU_HZ) {
+    return baud > 0U && baud <= clock / 8U && detail::magnitude(divisor(baud, clock).error_permille) <=
+                                                  static_cast<std::int16_t>(MAX_RATE_ERROR_PERMILLE);
+}
+
+static_assert(supported(9600) && supported(115200) && supported(250000) && supported(1000000) && !supported(230400),
+              "Baud rates of the 16 MHz clock");
+
+enum class Overflow : std::uint8_t {
+    DROP,  // A message that does not fit is discarded whole
+    BLOCK  // Waits for room; for output that must not be lost, at the cost of timing
+};
+
+// Byte ring drained by an interrupt. The 16-bit indices are not atomic on AVR, so each side reads the other side's
+// index, and the producer publishes its own, with interrupts disabled.
+template <std::uint16_t Capacity>
+class TxRing {
+    static_assert(Capacity > 0 && Capacity <= 32768U && (Capacity & (Capacity - 1U)) == 0,
+                  "The TX ring capacity must be a power of two");
+
+public:
+    static constexpr std::uint16_t capacity() { return Capacity; }
+
+    // Producer side
+    std::uint16_t free() const { return static_cast<std::uint16_t>(Capacity - (head_ - load(tail_))); }
+
+    // Producer side; the caller has checked free()
+    void put(const char* data, std::uint16_t length) {
+        std::uint16_t head = head_;
+        for (std::uint16_t i = 0; i < length; ++i, ++head) {
+            bytes_[head & MASK] = static_cast<std::uint8_t>(data[i]);
+        }
+        store(head_, head);
+    }
+
+    // Consumer side (the interrupt); false if the ring is empty
+    bool take(std::uint8_t& byte) {
+        const std::uint16_t tail = tail_;
+        if (tail == head_) {
+            return false;
+        }
+        byte = bytes_[tail & MASK];
+        tail_ = static_cast<std::uint16_t>(tail + 1U);
+        return true;
+    }
+
+    // Consumer side; forgets the bytes not sent yet
+    void discard() { tail_ = head_; }
+
+    bool empty() const { return load(head_) == load(tail_); }
+
+private:
+    static constexpr std::uint16_t MASK = Capacity - 1U;
+
+    std::uint8_t bytes_[Capacity];
+    volatile std::uint16_t head_ = 0;  // Written by the producer only
+    volatile std::uint16_t tail_ = 0;  // Written by the consumer only
+
+    static std::uint16_t load(const volatile std::uint16_t& index) {
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+        const std::uint16_t value = index;
+        SREG = sreg;
+        return value;
+#else
+        return index;
+#endif
+    }
+
+    static void store(volatile std::uint16_t& index, std::uint16_t value) {
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+        index = value;
+        SREG = sreg;
+#else
+        index = value;
+#endif
+    }
+};
+
+inline TxRing<SERIAL_TX_BUFFER_SIZE> tx;
+inline ramen::SpscMailbox<std::uint8_t, SERIAL_RX_BUFFER_SIZE> rx;
+inline std::uint16_t dropped_messages = 0;  // Saturates at 65535
+inline volatile std::uint8_t framing_errors = 0;  // Bytes received with a bad stop bit, dropped; saturates at 255
+inline unsigned long baud_rate = DEFAULT_BAUD;
+
+namespace detail {
+
+inline volatile bool rx_throttled = false;  // The peer was asked to stop
+inline volatile bool tx_paused = false;     // By the peer's XOFF
+inline volatile std::uint8_t control = 0;   // XON or XOFF to send ahead of the ring, or 0
+inline volatile bool abort_pending = false;     // An ABORT arrived that take_abort() has not handled
+inline volatile std::uint8_t abort_backlog = 0;  // Bytes of `rx` received before it
+
+inline void start_transmitter() {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    UCSR0B = static_cast<std::uint8_t>(UCSR0B | _BV(UDRIE0));
+#endif
+}
+
+// Asks the peer to stop sending, or to go on; with interrupts disabled
+inline void throttle_rx(bool stop) {
+    rx_throttled = stop;
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT) && defined(SERIAL_RTS_PIN)
+    gpio::FastPin<SERIAL_RTS_PIN>::write(stop);  // Active low
+#elif defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT) && defined(SERIAL_XON_XOFF)
+    control = stop ? XOFF : XON;
+    start_transmitter();
+#endif
+}
+
+// Whether the peer lets us send
+inline bool tx_allowed() {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT) && defined(SERIAL_CTS_PIN)
+    return !gpio::FastPin<SERIAL_CTS_PIN>::read();  // Active low
+#else
+    return !tx_paused;
+#endif
+}
+
+// Interrupt side: whether `byte` is an ABORT and not part of a binary frame, which it follows like the endpoint does
+// (see BinaryEndpointActor::on_byte()): a zero opens a frame and the next zero after a byte of it closes the frame
+inline bool is_abort(std::uint8_t byte) {
+#if defined(SERIAL_BINARY_PROTOCOL)
+    enum Frame : std::uint8_t { OUTSIDE, OPENED, INSIDE };
+    static Frame frame = OUTSIDE;
+    if (byte == 0) {
+        frame = (frame == INSIDE) ? OUTSIDE : OPENED;
+        return false;
+    }
+    if (frame != OUTSIDE) {
+        frame = INSIDE;
+        return false;
+    }
+#endif
+    return byte == ABORT;
+}
+
+// Main-loop side: asks the peer to go on once read() has taken the buffer down to RX_LOW_WATER
+inline void resume_rx() {
+    if (RX_FLOW_CONTROL && rx_throttled && rx.size() <= RX_LOW_WATER) {
+#if defined(__AVR__)
+        const std::uint8_t sreg = SREG;
+        cli();
+        throttle_rx(false);
+        SREG = sreg;
+#endif
+    }
+}
+
+} // namespace detail
+
+// Interrupt side: moves the next byte into the UART, a pending XON/XOFF first, or stops the interrupt once the ring is
+// empty or the peer holds output back. `ignore_peer` sends regardless, for a drain with interrupts disabled
+inline void on_data_register_empty(bool ignore_peer = false) {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    std::uint8_t byte = detail::control;
+    if (byte != 0 || ((ignore_peer || detail::tx_allowed()) && tx.take(byte))) {
+        detail::control = 0;
+        UDR0 = byte;
+        UCSR0A = static_cast<std::uint8_t>((UCSR0A & _BV(U2X0)) | _BV(TXC0));  // Complete again once it is sent
+    } else {
+        UCSR0B = static_cast<std::uint8_t>(UCSR0B & ~_BV(UDRIE0));
+    }
+#else
+    (void)ignore_peer;
+#endif
+}
+
+// Interrupt side: queues a received byte; the mailbox counts the bytes lost while it is full. Ignored during a replay,
+// whose bytes take the place of the UART's
+inline void on_receive(std::uint8_t byte) {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT) && defined(SERIAL_XON_XOFF)
+    if (byte == XOFF || byte == XON) {
+        detail::tx_paused = byte == XOFF;
+        if (byte == XON) {
+            detail::start_transmitter();
+        }
+        return;
+    }
+#endif
+    if (ABORT_ENABLED && !input_record::REPLAY && detail::is_abort(byte)) {
+        tx.discard();
+        detail::abort_backlog = static_cast<std::uint8_t>(rx.size());
+        detail::abort_pending = true;
+        return;
+    }
+    if (!input_record::REPLAY) {
+        rx.push(byte);
+        if (RX_FLOW_CONTROL && !detail::rx_throttled && rx.size() >= RX_HIGH_WATER) {
+            detail::throttle_rx(true);
+        }
+    }
+}
+
+// As on_receive(byte), with the receiver's status read before the byte: a byte with a framing error is counted
+// instead. Called by the USART0 receive interrupt
+inline void on_receive(std::uint8_t byte, std::uint8_t status) {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    if ((status & _BV(FE0)) != 0) {
+        if (framing_errors != UINT8_MAX) {
+            framing_errors = static_cast<std::uint8_t>(framing_errors + 1U);
+        }
+        return;
+    }
+#else
+    (void)status;
+#endif
+    on_receive(byte);
+}
+
+namespace detail {
+
+inline void set_divisor(const Divisor& d) {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    UCSR0A = d.double_speed ? _BV(U2X0) : 0;
+    UBRR0H = static_cast<std::uint8_t>(d.ubrr >> 8);
+    UBRR0L = static_cast<std::uint8_t>(d.ubrr);
+#else
+    (void)d;
+#endif
+}
+
+} // namespace detail
+
+inline void begin(unsigned long baud) {
+    baud_rate = baud;
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    detail::set_divisor(divisor(baud));
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);  // 8N1
+    UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+#if defined(SERIAL_RTS_PIN)
+    gpio::FastPin<SERIAL_RTS_PIN>::make_output();  // Low: the peer may send
+#endif
+#if defined(SERIAL_CTS_PIN)
+    pinMode(SERIAL_CTS_PIN, INPUT_PULLUP);
+#endif
+#else
+    Serial.begin(baud);
+#endif
+}
+
+// Resumes output the peer held back with CTS; call every pass with -D SERIAL_CTS_PIN (nothing to do otherwise)
+inline void poll() {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT) && defined(SERIAL_CTS_PIN)
+    if (!tx.empty() && detail::tx_allowed()) {
+        detail::start_transmitter();
+    }
+#endif
+}
+
+// True once every byte written has left the UART, when the rate can change without garbling one; the UART reports it
+// from the completion of a byte, so not before the first byte was sent
+inline bool tx_idle() {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    return tx.empty() && (UCSR0A & _BV(UDRE0)) != 0 && (UCSR0A & _BV(TXC0)) != 0;
+#else
+    return true;  // Serial.flush() in set_baud() waits
+#endif
+}
+
+// Switches the running port to `baud`; false, and no change, if the clock does not divide to it. Bytes still being
+// sent or received are garbled: check tx_idle() first
+inline bool set_baud(unsigned long baud) {
+    if (!supported(baud)) {
+        return false;
+    }
+    baud_rate = baud;
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    detail::set_divisor(divisor(baud));
+#else
+    Serial.flush();
+    Serial.begin(baud);
+#endif
+    return true;
+}
+
+// Main-loop side: queues a byte as the receive interrupt would, for replayed input; false while the buffer is full
+inline bool inject(std::uint8_t byte) {
+#if defined(__AVR__)
+    const std::uint8_t sreg = SREG;
+    cli();
+    const bool room = rx.size() < SERIAL_RX_BUFFER_SIZE && rx.push(byte);
+    SREG = sreg;
+    return room;
+#else
+    return rx.size() < SERIAL_RX_BUFFER_SIZE && rx.push(byte);
+#endif
+}
+
+inline int available() {
+#if (defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)) || defined(INPUT_REPLAY)
+    return rx.size();
+#else
+    return Serial.available();
+#endif
+}
+
+// Next received byte, or -1
+inline int read() {
+#if (defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)) || defined(INPUT_REPLAY)
+    std::uint8_t byte = 0;
+    const int ch = rx.pop(byte) ? byte : -1;
+    detail::resume_rx();
+#else
+    const int ch = Serial.read();
+#endif
+    if (ch >= 0) {
+        input_record::serial(static_cast<std::uint8_t>(ch));
+    }
+    return ch;
+}
+
+// Main-loop side: whether an ABORT arrived since the last call (-D SERIAL_ABORT), having dropped the input received
+// before it; read() goes on with the bytes after it. Without SERIAL_BUFFERED_OUTPUT, the ABORT byte reaches read()
+// behind the queued input instead
+inline bool take_abort() {
+    if (!ABORT_ENABLED || !detail::abort_pending) {
+        return false;
+    }
+#if defined(__AVR__)
+    const std::uint8_t sreg = SREG;
+    cli();
+#endif
+    std::uint8_t backlog = detail::abort_backlog;
+    detail::abort_pending = false;
+#if defined(__AVR__)
+    SREG = sreg;
+#endif
+    for (std::uint8_t byte = 0; backlog > 0 && rx.pop(byte); --backlog) {
+    }
+    detail::resume_rx();
+    return true;
+}
+
+// Bytes that can be written without dropping or blocking
+inline std::uint16_t tx_free() {
+    return ENABLED ? tx.free() : static_cast<std::uint16_t>(SERIAL_TX_BUFFER_SIZE);
+}
+
+namespace detail {
+
+// Waits until the ring has room, as long as the peer holds output back; with interrupts disabled, e.g. called from an
+// ISR, it drains the ring itself, past flow control, as no XON could arrive
+inline void wait_for_room() {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    while (tx.free() == 0) {
+        poll();
+        if ((SREG & _BV(SREG_I)) == 0 && (UCSR0A & _BV(UDRE0)) != 0) {
+            on_data_register_empty(true);
+        }
+    }
+#endif
+}
+
+inline void count_drop() {
+    if (dropped_messages != UINT16_MAX) {
+        ++dropped_messages;
+    }
+}
+
+} // namespace detail
+
+// Queues `length` bytes; false if they were dropped
+inline bool write(const char* data, std::uint16_t length, Overflow overflow) {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    if (overflow == Overflow::DROP) {
+        if (tx.free() < length) {
+            detail::count_drop();
+            return false;
+        }
+        tx.put(data, length);
+    } else {
+        for (std::uint16_t i = 0; i < length;) {
+            detail::wait_for_room();
+            const std::uint16_t room = tx.free();
+            const std::uint16_t n = (length - i < room) ? static_cast<std::uint16_t>(length - i) : room;
+            tx.put(data + i, n);
+            detail::start_transmitter();
+            i = static_cast<std::uint16_t>(i + n);
+        }
+    }
+    detail::start_transmitter();
+    return true;
+#else
+    (void)overflow;
+    Serial.write(reinterpret_cast<const std::uint8_t*>(data), length);
+    return true;
+#endif
+}
+
+// Queues `text` and a line break as one message, like Serial.println()
+inline bool write_line(const char* text, Overflow overflow) {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    const std::uint16_t length = static_cast<std::uint16_t>(std::strlen(text));
+    if (overflow == Overflow::DROP && tx.free() < length + 2U) {
+        detail::count_drop();
+        return false;
+    }
+    write(text, length, overflow);
+    return write("\r\n", 2, overflow);
+#else
+    (void)overflow;
+    Serial.println(text);
+    return true;
+#endif
+}
+
+// write_line() of a flash string
+inline bool write_line(const __FlashStringHelper* text, Overflow overflow) {
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+    const char* text_P = reinterpret_cast<const char*>(text);
+    const std::uint16_t length = static_cast<std::uint16_t>(strlen_P(text_P));
+    if (overflow == Overflow::DROP && tx.free() < length + 2U) {
+        detail::count_drop();
+        return false;
+    }
+    char chunk[8];
+    std::uint16_t n = 0;
+    for (std::uint16_t i = 0; i < length; ++i) {
+        chunk[n++] = static_cast<char>(pgm_read_byte(text_P + i));
+        if (n == sizeof(chunk)) {
+            write(chunk, n, overflow);
+            n = 0;
+        }
+    }
+    write(chunk, n, overflow);
+    return write("\r\n", 2, overflow);
+#else
+    (void)overflow;
+    Serial.println(text);
+    return true;
+#endif
+}
+
+} // namespace serial_port
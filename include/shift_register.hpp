@@ -0,0 +1,186 @@
+#pragma once
+#include "fast_pin.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Outputs on a chain of 74HC595 shift registers, clocked by the hardware SPI of the ATmega2560 instead of a
+// digitalWrite per bit and clock edge. Actors write bits of a frame in RAM; commit(), once per scan like
+// process_image's commit_outputs(), sends the frame to the chain in one burst if a bit changed and pulses the latch,
+// so the outputs of all registers change together:
+//
+//     MOSI (51) -> SER of the first register, its QH' -> SER of the next; SCK (52) -> SRCLK; latch pin -> RCLK
+//
+//     expander::ShiftRegisterChain<2, CONTROLLINO_D5> expander;            // 16 outputs, latch on D5
+//     led::ExpanderBlinkyLedActor led4(expander, 0, 250);                  // Q0 of the first register
+//     void setup() { expander.begin(); led4.init(); outputs.add(led4); }   // Then like any output
+//     void loop()  { ...; expander.commit(); }
+//
+// Bit i of the frame is output Qi%8 of register i/8, register 0 being the one wired to MOSI. The frame is double
+// buffered: commit() copies the frame actors write to the one the SPI interrupt shifts out (last register first) and
+// starts the transfer, which the interrupt pumps a byte at a time while the scan goes on; bits written meanwhile wait
+// for the next commit, and a commit while a burst is still running leaves the frame dirty for the next scan. The SPI
+// runs at F_CPU/2, a microsecond per register.
+//
+// The W5100 of the Ethernet library shares the bus: commit at the end of the scan, after the network steps, so that
+// the burst is over before the next SPI transaction begins. The registers shift in the W5100's traffic as well, but
+// the latch only copies a complete frame of the chain.
+//
+// Opt-in with -D SPI_EXPANDER, which defines the SPI interrupt (src/shift_register.cpp), so a firmware has one chain.
+// Without it the frame is kept but never sent. Outputs of the chain have pseudo pin numbers from PIN_BASE up: to
+// BlinkyLedActor and the command system they are pins like any other, which hw_blink leaves to the software timer.
+
+namespace expander {
+
+#if defined(__AVR__) && defined(SPI_EXPANDER)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t PIN_BASE = 0xC0;   // Pin number of bit 0, beyond those of the ATmega2560
+constexpr std::uint8_t MAX_BYTES = 8;     // 64 outputs, the range of the pseudo pin numbers
+
+constexpr std::uint8_t pin(std::uint8_t bit) { return static_cast<std::uint8_t>(PIN_BASE + bit); }
+constexpr std::uint8_t bit_of(std::uint8_t pin) { return static_cast<std::uint8_t>(pin - PIN_BASE); }
+
+namespace detail {
+
+// The burst in progress, shared with the SPI interrupt
+inline const std::uint8_t* frame = nullptr;  // Sent from its last byte down
+inline volatile std::uint8_t bytes_left = 0;  // After the one in the SPI
+inline volatile bool busy = false;            // Until the latch is pulsed
+inline void (*latch)() = nullptr;
+
+// Interrupt side: loads the next byte into the SPI, or latches the frame after the last one
+inline void on_transfer_complete() {
+#if defined(__AVR__) && defined(SPI_EXPANDER)
+    const std::uint8_t left = bytes_left;
+    if (left != 0) {
+        bytes_left = static_cast<std::uint8_t>(left - 1U);
+        SPDR = frame[left - 1U];
+        return;
+    }
+    latch();
+    SPCR = static_cast<std::uint8_t>(SPCR & ~_BV(SPIE));  // The Ethernet library polls the SPI
+    busy = false;
+#endif
+}
+
+template <std::uint8_t LatchPin>
+void pulse_latch() {
+    gpio::FastPin<LatchPin>::high();  // RCLK: the rising edge copies the shift registers to the outputs
+    gpio::FastPin<LatchPin>::low();
+}
+
+} // namespace detail
+
+// Size-independent view of a chain's frame, for contexts and actors that write its bits
+class OutputFrame {
+public:
+    std::uint8_t bits() const { return static_cast<std::uint8_t>(size_ * 8U); }
+    bool contains(std::uint8_t bit) const { return bit < bits(); }
+
+    // Level to be committed; writes to bits beyond the chain are ignored
+    void write(std::uint8_t bit, bool level) {
+        if (!contains(bit)) {
+            return;
+        }
+        const std::uint8_t mask = static_cast<std::uint8_t>(1U << (bit & 7U));
+        std::uint8_t& byte = back_[bit >> 3];
+        const std::uint8_t levels = level ? static_cast<std::uint8_t>(byte | mask)
+                                          : static_cast<std::uint8_t>(byte & ~mask);
+        dirty_ = dirty_ || levels != byte;
+        byte = levels;
+    }
+
+    // Levels of the eight outputs of register `index`
+    void write_byte(std::uint8_t index, std::uint8_t levels) {
+        if (index < size_ && back_[index] != levels) {
+            back_[index] = levels;
+            dirty_ = true;
+        }
+    }
+
+    bool level(std::uint8_t bit) const { return contains(bit) && (back_[bit >> 3] & (1U << (bit & 7U))) != 0; }
+    bool dirty() const { return dirty_; }
+
+protected:
+    OutputFrame() = default;
+
+    std::uint8_t* back_ = nullptr;  // Set by ShiftRegisterChain to its storage
+    std::uint8_t size_ = 0;
+    bool dirty_ = true;             // The chain powers up with random levels
+};
+
+template <std::uint8_t Bytes, std::uint8_t LatchPin>
+class ShiftRegisterChain : public OutputFrame {
+    static_assert(Bytes > 0 && Bytes <= MAX_BYTES, "1 to 8 registers");
+
+public:
+    ShiftRegisterChain() {
+        back_ = frames_[0].data();
+        size_ = Bytes;
+    }
+    ShiftRegisterChain(const ShiftRegisterChain&) = delete;
+    ShiftRegisterChain& operator=(const ShiftRegisterChain&) = delete;
+
+    // Sets up the latch pin and the SPI pins; the first commit() drives every output low
+    void begin() {
+        gpio::FastPin<LatchPin>::make_output();
+#if defined(__AVR__) && defined(SPI_EXPANDER)
+        pinMode(MOSI, OUTPUT);
+        pinMode(SCK, OUTPUT);
+        pinMode(SS, OUTPUT);  // An input SS low would switch the SPI to slave mode
+        detail::latch = &detail::pulse_latch<LatchPin>;
+#endif
+    }
+
+    // Sends the frame if a bit changed since the last commit; false if it changed but a burst is still running
+    bool commit() {
+        if (!dirty_) {
+            return true;
+        }
+        if (busy()) {
+            count(deferred_);
+            return false;
+        }
+        std::memcpy(frames_[1].data(), frames_[0].data(), Bytes);
+        dirty_ = false;
+        count(commits_);
+#if defined(__AVR__) && defined(SPI_EXPANDER)
+        detail::frame = frames_[1].data();
+        detail::bytes_left = Bytes - 1U;
+        detail::busy = true;
+        SPSR = _BV(SPI2X);
+        SPCR = _BV(SPE) | _BV(MSTR) | _BV(SPIE);  // Mode 0, MSB first: Q7 gets bit 7
+        SPDR = frames_[1][Bytes - 1U];
+#endif
+        return true;
+    }
+
+    // A burst is running
+    bool busy() const { return ENABLED && detail::busy; }
+
+    // Frames sent, and commits that found the previous burst still running; saturating at 65535
+    std::uint16_t commits() const { return commits_; }
+    std::uint16_t deferred() const { return deferred_; }
+
+private:
+    std::array<std::array<std::uint8_t, Bytes>, 2> frames_{};  // Written by actors, and sent by the interrupt
+    std::uint16_t commits_ = 0;
+    std::uint16_t deferred_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+};
+
+} // namespace expander
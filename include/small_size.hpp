@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ramen
+{
+
+/// Smallest unsigned type able to hold values up to and including N. The fixed-capacity containers (RingBuffer,
+/// StaticVector, FlatMap) count their items in it, so a container of fewer than 256 items keeps an 8-bit size.
+template <std::size_t N>
+using small_size_t = std::conditional_t<(N <= 0xFFU), std::uint8_t,
+                     std::conditional_t<(N <= 0xFFFFU), std::uint16_t, std::uint32_t>>;
+
+} // namespace ramen
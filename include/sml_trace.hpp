@@ -0,0 +1,126 @@
+#pragma once
+#include "ring_buffer.hpp"
+#include "scan_clock.hpp"
+#include "sml.hpp"
+#include <Controllino.h>
+#include <cstdint>
+
+// Binary transition trace for Boost SML state machines.
+//
+// sml_trace::Logger is an SML logger policy (boost::sml::logger<sml_trace::Logger>) that appends one 8-byte Record
+// per state change to a static ring buffer, overwriting the oldest record when full. Recording is a handful of
+// stores, so it can stay enabled in the field; the 'trace' command prints the buffer for post-mortem analysis.
+//
+// State and event ids are the indices of the types in boost::sml::sm<Fsm>::states and ::events, i.e. their order of
+// first appearance in the transition table. Tracing is compiled in with -D SML_TRACE; otherwise the logger hooks
+// are empty and no buffer is allocated.
+
+#ifndef SML_TRACE_CAPACITY
+#define SML_TRACE_CAPACITY 32
+#endif
+
+namespace sml_trace {
+
+#if defined(SML_TRACE)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t UNKNOWN_ID = 0xFF;
+
+struct Record {
+    std::uint32_t timestamp_ms;
+    std::uint8_t sm_id;
+    std::uint8_t event_id;
+    std::uint8_t src_state;
+    std::uint8_t dst_state;
+};
+
+#if defined(SML_TRACE)
+inline ramen::RingBuffer<Record, SML_TRACE_CAPACITY> records;
+inline std::uint16_t overwritten = 0;
+#endif
+
+namespace detail {
+template <class T, class List>
+struct index_of;
+template <class T>
+struct index_of<T, boost::sml::aux::type_list<>> {
+    static constexpr std::uint8_t value = UNKNOWN_ID;
+};
+template <class T, class... Ts>
+struct index_of<T, boost::sml::aux::type_list<T, Ts...>> {
+    static constexpr std::uint8_t value = 0;
+};
+template <class T, class U, class... Ts>
+struct index_of<T, boost::sml::aux::type_list<U, Ts...>> {
+    static constexpr std::uint8_t next = index_of<T, boost::sml::aux::type_list<Ts...>>::value;
+    static constexpr std::uint8_t value = (next == UNKNOWN_ID) ? UNKNOWN_ID : static_cast<std::uint8_t>(next + 1);
+};
+
+// log_state_change receives the states wrapped in aux::string<>
+template <class T>
+struct unwrap {
+    using type = T;
+};
+template <class T>
+struct unwrap<boost::sml::aux::string<T>> {
+    using type = T;
+};
+} // namespace detail
+
+class Logger {
+public:
+#if defined(SML_TRACE)
+    explicit Logger(std::uint8_t sm_id) : sm_id_(sm_id) {}
+#else
+    explicit Logger(std::uint8_t) {}
+#endif
+
+    template <class SM, class TEvent>
+    void log_process_event(const TEvent&) {
+#if defined(SML_TRACE)
+        last_event_ = detail::index_of<TEvent, typename boost::sml::sm<SM>::events>::value;
+#endif
+    }
+
+    template <class SM, class TGuard, class TEvent>
+    void log_guard(const TGuard&, const TEvent&, bool) {}
+
+    template <class SM, class TAction, class TEvent>
+    void log_action(const TAction&, const TEvent&) {}
+
+    template <class SM, class TSrcState, class TDstState>
+    void log_state_change(const TSrcState&, const TDstState&) {
+#if defined(SML_TRACE)
+        using states = typename boost::sml::sm<SM>::states;
+        const Record record{
+            scan_clock::now(),
+            sm_id_,
+            last_event_,
+            detail::index_of<typename detail::unwrap<TSrcState>::type, states>::value,
+            detail::index_of<typename detail::unwrap<TDstState>::type, states>::value,
+        };
+        if (records.full() && overwritten < UINT16_MAX) {
+            ++overwritten;
+        }
+        records.push_overwrite(record);
+#endif
+    }
+
+#if defined(SML_TRACE)
+private:
+    std::uint8_t sm_id_;
+    std::uint8_t last_event_ = UNKNOWN_ID;
+#endif
+};
+
+inline void clear() {
+#if defined(SML_TRACE)
+    records.clear();
+    overwritten = 0;
+#endif
+}
+
+} // namespace sml_trace
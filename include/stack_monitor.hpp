@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
+
+// Stack high-water-mark measurement by stack painting.
+//
+// paint() fills the free RAM between the top of the heap and the current stack pointer with a known pattern.
+// Later, unused() scans upwards from the top of the heap for the first overwritten byte; everything above it has
+// been reached by the stack (or the heap) at some point. Call paint() as early as possible in setup(), before
+// deep call chains have run. On non-AVR builds the functions report zero.
+
+namespace stack_monitor {
+
+constexpr std::uint8_t PAINT_PATTERN = 0xC5;
+// Bytes just below the current stack pointer left unpainted, so that paint() does not clobber its own frame.
+constexpr std::size_t SAFETY_MARGIN = 16;
+
+#if defined(__AVR__)
+extern "C" {
+extern char __heap_start;
+extern char* __brkval;
+}
+
+inline std::uint8_t* heap_top() {
+    return reinterpret_cast<std::uint8_t*>(__brkval != nullptr ? __brkval : &__heap_start);
+}
+
+inline std::uint8_t* stack_pointer() {
+    return reinterpret_cast<std::uint8_t*>(SP);
+}
+
+// Bytes currently free between the heap and the stack.
+inline std::size_t free_now() {
+    const std::uint8_t* top = heap_top();
+    const std::uint8_t* sp = stack_pointer();
+    return (sp > top) ? static_cast<std::size_t>(sp - top) : 0;
+}
+
+inline void paint() {
+    std::uint8_t* p = heap_top();
+    std::uint8_t* const end = stack_pointer() - SAFETY_MARGIN;
+    while (p < end) {
+        *p++ = PAINT_PATTERN;
+    }
+}
+
+// Bytes above the heap that still hold the paint pattern, i.e. the smallest free gap observed since paint().
+inline std::size_t unused() {
+    const std::uint8_t* p = heap_top();
+    const std::uint8_t* const sp = stack_pointer();
+    std::size_t n = 0;
+    while (p < sp && *p == PAINT_PATTERN) {
+        ++p;
+        ++n;
+    }
+    return n;
+}
+#else
+inline std::size_t free_now() { return 0; }
+inline void paint() {}
+inline std::size_t unused() { return 0; }
+#endif
+
+} // namespace stack_monitor
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "small_size.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace ramen
+{
+
+/// Vector of at most N items in place, with no dynamic allocation: the fixed "array plus count" of the actors with a
+/// std::vector-like interface. The count uses the smallest type that fits the capacity.
+///
+/// Operations that would exceed the capacity return false and leave the vector unchanged, as RingBuffer::push() does;
+/// there are no exceptions to throw on AVR. Items live in a std::array, so T must be default-constructible; a removed
+/// item is assigned T{} to release whatever it holds. Usable in constant expressions.
+template <typename T, std::size_t N>
+class StaticVector
+{
+    static_assert(N > 0, "StaticVector capacity must be positive");
+
+public:
+    using value_type     = T;
+    using size_type      = small_size_t<N>;
+    using iterator       = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_type capacity() noexcept { return static_cast<size_type>(N); }
+
+    constexpr size_type size() const noexcept { return count_; }
+    constexpr bool      empty() const noexcept { return count_ == 0; }
+    constexpr bool      full() const noexcept { return count_ == N; }
+
+    constexpr iterator       begin() noexcept { return items_.data(); }
+    constexpr const_iterator begin() const noexcept { return items_.data(); }
+    constexpr iterator       end() noexcept { return items_.data() + count_; }
+    constexpr const_iterator end() const noexcept { return items_.data() + count_; }
+    constexpr T*             data() noexcept { return items_.data(); }
+    constexpr const T*       data() const noexcept { return items_.data(); }
+
+    constexpr T&       operator[](const size_type index) noexcept { return items_[index]; }
+    constexpr const T& operator[](const size_type index) const noexcept { return items_[index]; }
+    constexpr T&       front() noexcept { return items_[0]; }
+    constexpr const T& front() const noexcept { return items_[0]; }
+    constexpr T&       back() noexcept { return items_[count_ - 1U]; }
+    constexpr const T& back() const noexcept { return items_[count_ - 1U]; }
+
+    /// Appends an item; returns false if the vector is full.
+    constexpr bool push_back(const T& item) noexcept(std::is_nothrow_copy_assignable_v<T>)
+    {
+        if (full()) { return false; }
+        items_[count_++] = item;
+        return true;
+    }
+
+    /// Appends T{args...}; returns false if the vector is full.
+    template <typename... Args>
+    constexpr bool emplace_back(Args&&... args)
+    {
+        if (full()) { return false; }
+        items_[count_++] = T{std::forward<Args>(args)...};
+        return true;
+    }
+
+    constexpr void pop_back() noexcept
+    {
+        if (!empty()) { release(--count_); }
+    }
+
+    /// Inserts an item before `index`, moving the later ones up; returns false if the vector is full or `index` is
+    /// past the end.
+    constexpr bool insert(const size_type index, const T& item)
+    {
+        if (full() || index > count_) { return false; }
+        for (size_type i = count_; i > index; --i) { items_[i] = std::move(items_[i - 1U]); }
+        items_[index] = item;
+        ++count_;
+        return true;
+    }
+
+    /// Removes the item at `index`, moving the later ones down and keeping their order.
+    constexpr void erase(const size_type index)
+    {
+        if (index >= count_) { return; }
+        for (size_type i = index; i + 1U < count_; ++i) { items_[i] = std::move(items_[i + 1U]); }
+        release(--count_);
+    }
+
+    constexpr void clear() noexcept
+    {
+        while (!empty()) { pop_back(); }
+    }
+
+private:
+    constexpr void release(const size_type index) noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            items_[index] = T{};
+        }
+    }
+
+    std::array<T, N> items_{};
+    size_type        count_ = 0;
+};
+
+} // namespace ramen
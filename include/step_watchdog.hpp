@@ -0,0 +1,350 @@
+#pragma once
+#include "binary_frame.hpp"
+#include "cycle_counter.hpp"
+#include "port_trace.hpp"
+#include "ramen.hpp"
+#include "ring_buffer.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/wdt.h>
+#endif
+
+// Cycle budgets for the run-to-completion steps of the actors, and the AVR watchdog fed only while the critical actors
+// make progress. A step is a scheduled update run through run(), or with -D RAMEN_CFG_TRIGGER_HOOKS any behavior an
+// Event triggers (see src/ramen_hooks.cpp); steps nest, as the behaviors of an update run within it.
+//
+//     step_watchdog::set_budget(&modbus_slave, 2000);  // us; the others get STEP_WATCHDOG_BUDGET_US
+//     step_watchdog::add_critical(&timer);             // The watchdog waits for a completed step of the timer
+//     step_watchdog::start();
+//     ...
+//     step_watchdog::run(&timer, [] { timer.update(); });
+//     step_watchdog::feed();                           // Once per loop() pass
+//
+// A step that takes longer than its budget is recorded with its port and time when it ends. One that does not end is
+// caught while it runs: the Timer5 compare A interrupt, on the free-running cycle counter, fires at the deadline of the
+// innermost step and notes the port that is running. The watchdog runs in interrupt-then-reset mode; feed() resets it
+// only once every critical actor has completed a step since the feed before, so a handler that hangs, or one that keeps
+// the others from running, leaves it hungry. Its interrupt saves the running and the late port, and the critical
+// actors still waiting, to .noinit RAM and resets the board 16 ms later: recovery takes at most the timeout plus 16 ms.
+// After the reset, last_reset() tells what the watchdog saw and reset_cause the MCUSR flags of the reset; the
+// 'watchdog' command prints them with the overruns.
+//
+// The record is a crash dump as well: the address the interrupt returns to, that is the instruction of the hung code,
+// the depth of nested steps and of synchronous dispatch (with -D RAMEN_CFG_DISPATCH_STATS), the ports of the last
+// STEP_WATCHDOG_TRACE records of the port trace, newest first (with -D PORT_TRACE), and the STEP_WATCHDOG_STACK bytes
+// above the interrupt's return address, the frames of the hung code, with the stack pointer they start at. The
+// interrupt is naked: it takes the stack pointer before anything is pushed, which puts the return address at known
+// offsets, and jumps to a C function that never returns. A CRC over the record tells a dump from RAM that a power-up
+// or a reset halfway through the write left behind; avr-addr2line turns the address into a source line.
+//
+// Output that waits for the serial port (serial_port::Overflow::BLOCK) counts as working: at 9600 baud the default
+// timeout of 2 s covers about 1.9 KB of text in one pass.
+//
+// Opt-in with -D STEP_WATCHDOG. STEP_WATCHDOG_BUDGET_US sets the default budget and STEP_WATCHDOG_TIMEOUT the watchdog
+// timeout, a WDTO_ constant of avr/wdt.h; STEP_WATCHDOG_TRACE and STEP_WATCHDOG_STACK the size of the dump. Without
+// the flag ENABLED is false, run() just runs its function and the rest does nothing.
+
+#ifndef STEP_WATCHDOG_BUDGET_US
+#define STEP_WATCHDOG_BUDGET_US 5000
+#endif
+#ifndef STEP_WATCHDOG_TIMEOUT
+#define STEP_WATCHDOG_TIMEOUT 7  // WDTO_2S
+#endif
+#ifndef STEP_WATCHDOG_TRACE
+#define STEP_WATCHDOG_TRACE 8
+#endif
+#ifndef STEP_WATCHDOG_STACK
+#define STEP_WATCHDOG_STACK 16
+#endif
+
+namespace step_watchdog {
+
+#if defined(STEP_WATCHDOG)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+#if defined(STEP_WATCHDOG) && defined(CYCLE_COUNTER_DISABLE)
+#error "STEP_WATCHDOG times steps with the cycle counter, which CYCLE_COUNTER_DISABLE removes"
+#endif
+
+constexpr std::uint8_t MAX_DEPTH = 8;        // Nested steps tracked; deeper ones run without a budget
+constexpr std::uint8_t MAX_BUDGETS = 8;      // Ports with a budget of their own
+constexpr std::uint8_t MAX_CRITICAL = 8;
+constexpr std::uint8_t OVERRUN_RECORDS = 8;  // The latest overruns kept
+constexpr std::uint16_t DEFAULT_BUDGET_US = STEP_WATCHDOG_BUDGET_US;
+constexpr std::uint16_t TIMEOUT_MS = 16U << STEP_WATCHDOG_TIMEOUT;  // Nominal, the watchdog oscillator is +-10%
+constexpr std::uint8_t TRACE_PORTS = STEP_WATCHDOG_TRACE;
+constexpr std::uint8_t STACK_BYTES = STEP_WATCHDOG_STACK;
+
+struct Overrun {
+    std::uintptr_t port;
+    std::uint32_t cycles;      // Taken by the step
+    std::uint16_t budget_us;
+};
+
+// What the watchdog interrupt saw before the reset; magic and the CRC tell it from the garbage of a power-up
+struct ResetRecord {
+    std::uint16_t magic;
+    std::uintptr_t running;  // The innermost step
+    std::uintptr_t late;     // The step the compare interrupt caught past its deadline, 0 if none
+    std::uint8_t waiting;    // Bits of the critical actors that had not completed a step, in add_critical() order
+    std::uint32_t pc;        // Byte address of the interrupted instruction
+    std::uint16_t sp;        // Address of stack[0]
+    std::uint8_t step_depth;
+    std::uint8_t dispatch_depth;  // 0 without RAMEN_CFG_DISPATCH_STATS
+    std::uint8_t trace_count;     // Of trace, 0 without PORT_TRACE
+    std::uintptr_t trace[TRACE_PORTS];  // Ports of the newest port trace records, newest first
+    std::uint8_t stack[STACK_BYTES];
+    std::uint8_t crc[binary_frame::CRC_SIZE];
+};
+constexpr std::uint16_t RESET_MAGIC = 0x57D7;
+
+// Kept in .noinit across the reset (src/step_watchdog.cpp)
+extern ResetRecord reset_record;
+
+// MCUSR as the board came out of reset, its PORF, EXTRF, BORF, WDRF and JTRF flags, saved before .init3 clears it
+// (src/step_watchdog.cpp); with or without STEP_WATCHDOG, 0 off AVR
+extern std::uint8_t reset_cause;
+
+namespace detail {
+struct Step {
+    const void* port;
+    std::uint32_t start;
+    std::uint16_t budget_us;
+    std::uint32_t armed_at;  // Deadline programmed while this step is the innermost: its own or an outer earlier one
+};
+struct Budget {
+    const void* port;
+    std::uint16_t us;
+};
+
+inline std::array<Step, MAX_DEPTH> steps{};
+inline std::uint8_t depth = 0;
+inline volatile std::uintptr_t running = 0;
+inline volatile std::uintptr_t late = 0;
+inline volatile std::uint32_t armed_at = 0;
+inline std::array<Budget, MAX_BUDGETS> budgets{};
+inline std::uint8_t budget_count = 0;
+inline std::array<const void*, MAX_CRITICAL> critical{};
+inline std::uint8_t critical_count = 0;
+inline volatile std::uint8_t progressed = 0;
+inline ramen::RingBuffer<Overrun, OVERRUN_RECORDS> overruns;
+inline std::uint16_t overrun_count = 0;
+inline ResetRecord last_reset{};
+
+inline std::uint8_t all_critical() { return static_cast<std::uint8_t>((1U << critical_count) - 1U); }
+
+// The compare interrupts at the low 16 bits of the deadline, and again every 65536 cycles until the deadline is due
+inline void arm(std::uint32_t deadline) {
+#if defined(__AVR__) && defined(STEP_WATCHDOG)
+    const std::uint8_t sreg = SREG;
+    cli();
+    armed_at = deadline;
+    OCR5A = static_cast<std::uint16_t>(deadline);
+    TIFR5 = _BV(OCF5A);
+    TIMSK5 |= _BV(OCIE5A);
+    SREG = sreg;
+#else
+    armed_at = deadline;
+#endif
+}
+
+inline void disarm() {
+#if defined(__AVR__) && defined(STEP_WATCHDOG)
+    TIMSK5 &= static_cast<std::uint8_t>(~_BV(OCIE5A));
+#endif
+}
+
+inline void set_running(std::uintptr_t port) {
+#if defined(__AVR__)
+    const std::uint8_t sreg = SREG;
+    cli();
+    running = port;
+    SREG = sreg;
+#else
+    running = port;
+#endif
+}
+
+// The compare interrupt: true once the programmed deadline is due
+inline bool due() { return static_cast<std::int32_t>(cycle_counter::now() - armed_at) >= 0; }
+
+inline std::uint16_t crc_of(const ResetRecord& r) {
+    return binary_frame::crc16(reinterpret_cast<const std::uint8_t*>(&r), offsetof(ResetRecord, crc));
+}
+
+// The watchdog interrupt, past its naked entry: fills `r` with what was going on when the code at `pc` was
+// interrupted, `stack` being the memory above its return address
+inline void dump(ResetRecord& r, std::uint32_t pc, const std::uint8_t* stack, std::uint16_t stack_bytes) {
+    r.magic = RESET_MAGIC;
+    r.running = running;
+    r.late = late;
+    r.waiting = static_cast<std::uint8_t>(all_critical() & ~progressed);
+    r.pc = pc;
+    r.sp = static_cast<std::uint16_t>(reinterpret_cast<std::uintptr_t>(stack));
+    r.step_depth = depth;
+    r.dispatch_depth = ramen::dispatch_depth();
+    r.trace_count = 0;
+#if defined(PORT_TRACE)
+    for (auto i = port_trace::records.size(); i-- > 0 && r.trace_count < TRACE_PORTS;) {
+        r.trace[r.trace_count++] = port_trace::records[i].port;
+    }
+#endif
+    for (std::uint8_t i = 0; i < STACK_BYTES; ++i) {
+        r.stack[i] = (i < stack_bytes) ? stack[i] : 0;
+    }
+    binary_frame::write_le16(r.crc, crc_of(r));
+}
+} // namespace detail
+
+inline std::uint16_t budget_us(const void* port) {
+    for (std::uint8_t i = 0; i < detail::budget_count; ++i) {
+        if (detail::budgets[i].port == port) {
+            return detail::budgets[i].us;
+        }
+    }
+    return DEFAULT_BUDGET_US;
+}
+
+// Gives the steps of a port a budget other than DEFAULT_BUDGET_US; false once MAX_BUDGETS ports have one
+inline bool set_budget(const void* port, std::uint16_t us) {
+    for (std::uint8_t i = 0; i < detail::budget_count; ++i) {
+        if (detail::budgets[i].port == port) {
+            detail::budgets[i].us = us;
+            return true;
+        }
+    }
+    if (detail::budget_count == MAX_BUDGETS) {
+        return false;
+    }
+    detail::budgets[detail::budget_count++] = detail::Budget{port, us};
+    return true;
+}
+
+// Makes feed() wait for a completed step of the port; false once MAX_CRITICAL are critical
+inline bool add_critical(const void* port) {
+    if (detail::critical_count == MAX_CRITICAL) {
+        return false;
+    }
+    detail::critical[detail::critical_count++] = port;
+    return true;
+}
+
+inline std::uint8_t critical_count() { return detail::critical_count; }
+inline const void* critical(std::uint8_t i) { return detail::critical[i]; }
+
+inline void begin_step(const void* port) {
+    if (!ENABLED) {
+        return;
+    }
+    if (detail::depth < MAX_DEPTH) {
+        detail::Step& s = detail::steps[detail::depth];
+        s.port = port;
+        s.budget_us = budget_us(port);
+        s.start = cycle_counter::now();
+        s.armed_at = s.start + static_cast<std::uint32_t>(s.budget_us) * cycle_counter::CYCLES_PER_US;
+        if (detail::depth > 0) {
+            const std::uint32_t outer = detail::steps[detail::depth - 1U].armed_at;
+            if (static_cast<std::int32_t>(outer - s.armed_at) < 0) {
+                s.armed_at = outer;
+            }
+        }
+        detail::set_running(reinterpret_cast<std::uintptr_t>(port));
+        detail::arm(s.armed_at);
+    }
+    ++detail::depth;
+}
+
+inline void end_step() {
+    if (!ENABLED || detail::depth == 0) {
+        return;
+    }
+    --detail::depth;
+    if (detail::depth >= MAX_DEPTH) {
+        return;
+    }
+    const detail::Step& s = detail::steps[detail::depth];
+    const std::uint32_t cycles = cycle_counter::now() - s.start;
+    if (cycles > static_cast<std::uint32_t>(s.budget_us) * cycle_counter::CYCLES_PER_US) {
+        detail::overruns.push_overwrite(Overrun{reinterpret_cast<std::uintptr_t>(s.port), cycles, s.budget_us});
+        if (detail::overrun_count < UINT16_MAX) {
+            ++detail::overrun_count;
+        }
+    }
+    for (std::uint8_t i = 0; i < detail::critical_count; ++i) {
+        if (detail::critical[i] == s.port) {
+            detail::progressed = static_cast<std::uint8_t>(detail::progressed | (1U << i));
+        }
+    }
+    if (detail::depth > 0) {
+        const detail::Step& outer = detail::steps[detail::depth - 1U];
+        detail::set_running(reinterpret_cast<std::uintptr_t>(outer.port));
+        detail::arm(outer.armed_at);
+    } else {
+        detail::set_running(0);
+        detail::disarm();
+    }
+}
+
+// Runs a step of the port within its budget, e.g. run(&timer, [] { timer.update(); })
+template <class F>
+void run(const void* port, F&& f) {
+    begin_step(port);
+    f();
+    end_step();
+}
+
+// Resets the watchdog if every critical actor has completed a step since the last feed; called once per loop() pass
+inline void feed() {
+    if (!ENABLED) {
+        return;
+    }
+    if ((detail::progressed & detail::all_critical()) == detail::all_critical()) {
+        detail::progressed = 0;
+#if defined(__AVR__)
+        wdt_reset();
+#endif
+    }
+}
+
+// Takes what the watchdog saved before the last reset, then enables it in interrupt-then-reset mode; the cycle counter
+// must be running. Called at the end of setup(), after the critical actors are added.
+inline void start() {
+#if defined(STEP_WATCHDOG)
+    detail::last_reset = reset_record;
+    reset_record.magic = 0;
+#endif
+#if defined(__AVR__) && defined(STEP_WATCHDOG)
+    constexpr std::uint8_t prescaler =
+        (STEP_WATCHDOG_TIMEOUT & 0x07) | ((STEP_WATCHDOG_TIMEOUT & 0x08) ? _BV(WDP3) : 0);
+    const std::uint8_t sreg = SREG;
+    cli();
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | _BV(WDE) | prescaler;
+    SREG = sreg;
+#endif
+}
+
+// Whether the last reset was the watchdog's, and what it saw
+inline bool reset_by_watchdog() {
+    return detail::last_reset.magic == RESET_MAGIC &&
+           detail::crc_of(detail::last_reset) == binary_frame::read_le16(detail::last_reset.crc);
+}
+inline const ResetRecord& last_reset() { return detail::last_reset; }
+
+inline std::uint16_t overrun_count() { return detail::overrun_count; }
+inline const ramen::RingBuffer<Overrun, OVERRUN_RECORDS>& overruns() { return detail::overruns; }
+
+inline void clear() {
+    detail::overruns.clear();
+    detail::overrun_count = 0;
+    detail::late = 0;
+    detail::last_reset = ResetRecord{};
+}
+
+} // namespace step_watchdog
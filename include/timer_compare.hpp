@@ -0,0 +1,76 @@
+#pragma once
+#include "ramen_mailbox.hpp"
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// Output-compare wake-up for TimerActor on the ATmega2560's Timer4 (clk/64, i.e. 4 us per count at 16 MHz, so the
+// 16-bit counter reaches about 262 ms ahead).
+//
+// TimerActor::use_hardware_compare() hands the earliest deadline to arm(); the compare A interrupt defined in
+// src/timer_compare.cpp then posts the slot and generation it was armed for to the `ready` mailbox, and the next
+// update() fires that timer without waiting for millis() to tick over. Deadlines further out than the counter reaches
+// are armed with NO_SLOT, which only wakes the CPU so that update() can arm the rest of the interval. Ticks are still
+// dispatched from the main loop, as RAMEN ports must not run in interrupt context (see ramen_mailbox.hpp).
+//
+// start() takes Timer4 over from the Arduino core, which configures it for PWM on pins 6..8. The mode is opt-in with
+// -D TIMER_HW_COMPARE; otherwise, and on non-AVR builds, ENABLED is false and arm() does nothing.
+
+namespace timer_compare {
+
+constexpr std::uint8_t NO_SLOT = 0xFF;
+constexpr std::uint16_t TICKS_PER_MS = 250;
+constexpr std::uint16_t MAX_TICKS = 0xFF00;  // Keeps OCR4A clear of the count it was computed from
+
+struct Expiry {
+    std::uint8_t slot;
+    std::uint8_t generation;
+};
+
+// Filled by the compare ISR, drained by TimerActor::update()
+inline ramen::SpscMailbox<Expiry, 4> ready;
+
+inline volatile std::uint8_t armed_slot = NO_SLOT;
+inline volatile std::uint8_t armed_generation = 0;
+
+#if defined(__AVR__) && defined(TIMER_HW_COMPARE)
+constexpr bool ENABLED = true;
+
+inline void start() {
+    const std::uint8_t sreg = SREG;
+    cli();
+    TCCR4A = 0;
+    TCCR4B = _BV(CS41) | _BV(CS40);  // Normal mode, clk/64
+    TIMSK4 = 0;
+    TIFR4 = _BV(OCF4A);
+    SREG = sreg;
+}
+
+// Interrupts `ticks` counts from now (at least 2, so the compare is not set behind the running count)
+inline void arm(std::uint16_t ticks, std::uint8_t slot, std::uint8_t generation) {
+    if (ticks < 2U) {
+        ticks = 2U;
+    }
+    const std::uint8_t sreg = SREG;
+    cli();
+    armed_slot = slot;
+    armed_generation = generation;
+    OCR4A = static_cast<std::uint16_t>(TCNT4 + ticks);
+    TIFR4 = _BV(OCF4A);
+    TIMSK4 |= _BV(OCIE4A);
+    SREG = sreg;
+}
+
+inline void disarm() {
+    TIMSK4 &= static_cast<std::uint8_t>(~_BV(OCIE4A));
+}
+#else
+constexpr bool ENABLED = false;
+inline void start() {}
+inline void arm(std::uint16_t, std::uint8_t, std::uint8_t) {}
+inline void disarm() {}
+#endif
+
+} // namespace timer_compare
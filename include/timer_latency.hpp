@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Expiry latency of TimerActor: how late each timer was dispatched (update() time minus its deadline), recorded in a
+// logarithmic histogram with a per-slot maximum. Bucket 0 counts on-time expiries, bucket i counts lateness in
+// [2^(i-1), 2^i) clock units and the last bucket everything above. The 'latency' command prints the histogram.
+//
+// Opt-in with -D TIMER_LATENCY_STATS, which adds the statistics to every TimerActor (2 bytes per bucket and 4 per
+// slot) and their upkeep to every expiry.
+
+namespace timer_latency {
+
+#if defined(TIMER_LATENCY_STATS)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint8_t BUCKETS = 12;  // 0, 1, 2-3, 4-7, ... 512-1023, >= 1024
+
+struct Histogram {
+    std::array<std::uint16_t, BUCKETS> counts{};
+
+    static std::uint8_t bucket_of(std::uint32_t late) {
+        std::uint8_t bucket = 0;
+        while (late != 0 && bucket < BUCKETS - 1U) {
+            late >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    // Lower bound of a bucket, in clock units
+    static std::uint32_t bucket_floor(std::uint8_t bucket) {
+        return (bucket == 0) ? 0 : (static_cast<std::uint32_t>(1) << (bucket - 1U));
+    }
+
+    void record(std::uint32_t late) {
+        std::uint16_t& count = counts[bucket_of(late)];
+        if (count < UINT16_MAX) {
+            ++count;
+        }
+    }
+};
+
+template <std::uint8_t N>
+struct Stats {
+    Histogram histogram;
+    std::array<std::uint32_t, N> slot_max{};
+
+    void record(std::uint8_t slot, std::int32_t late) {
+        const std::uint32_t units = (late > 0) ? static_cast<std::uint32_t>(late) : 0;
+        histogram.record(units);
+        if (units > slot_max[slot]) {
+            slot_max[slot] = units;
+        }
+    }
+};
+
+// Untyped access to the Stats of one TimerActor, for the command system
+struct Report {
+    Histogram* histogram = nullptr;
+    std::uint32_t* slot_max = nullptr;
+    std::uint8_t slots = 0;
+
+    bool attached() const { return histogram != nullptr; }
+
+    void reset() const {
+        histogram->counts.fill(0);
+        for (std::uint8_t i = 0; i < slots; ++i) {
+            slot_max[i] = 0;
+        }
+    }
+};
+
+} // namespace timer_latency
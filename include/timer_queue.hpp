@@ -0,0 +1,254 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Deadline queues behind TimerActor.
+//
+// A queue orders the timer slots (indices 0..N-1) of its owner by deadline; the deadlines themselves stay with the
+// owner and are read through the `deadline_of(slot)` callable passed to each operation. Both backends offer:
+//   insert(slot, deadline_of)   queue a slot whose deadline has been set
+//   remove(slot, deadline_of)   unqueue a slot; no-op if it is not queued
+//   queued(slot)
+//   pop_due(now, deadline_of)   unqueue and return one slot whose deadline has passed, or NONE
+//   earliest(deadline_of)       queued slot with the earliest deadline, or NONE
+//   next_deadline(deadline_of, deadline)  earliest queued deadline; false if nothing is queued
+//
+// Heap       binary min-heap: O(log n) insert and remove, O(1) check while nothing is due. Fires exactly on time.
+// Wheel      hashed timing wheel of WheelSize buckets of TickMs each (both powers of two): O(1) insert and remove,
+//            expiry scans the slots hashed to the current bucket, so it stays cheap while timers are spread over the
+//            buckets. Timers further out than one revolution simply stay in their bucket for more rounds.
+//
+// Deadlines are compared by their signed distance, which is correct across the millis() wraparound as long as no
+// interval exceeds 2^31 ms.
+
+namespace timer_queue {
+
+constexpr std::uint8_t NONE = 0xFF;
+
+inline bool before(std::uint32_t a, std::uint32_t b) {
+    return static_cast<std::int32_t>(a - b) < 0;
+}
+
+// An array of NONE, as a constant initializer (std::array::fill is constexpr from C++20 only)
+template <std::size_t Size>
+constexpr std::array<std::uint8_t, Size> none_filled() {
+    std::array<std::uint8_t, Size> a{};
+    for (std::size_t i = 0; i < Size; ++i) {
+        a[i] = NONE;
+    }
+    return a;
+}
+
+template <std::uint8_t N>
+class Heap {
+    static_assert(N < NONE, "Timer slots are indexed with 8 bits");
+
+public:
+    constexpr Heap() = default;
+
+    bool queued(std::uint8_t slot) const { return pos_[slot] != NONE; }
+    std::uint8_t size() const { return size_; }
+
+    template <class DeadlineOf>
+    void insert(std::uint8_t slot, const DeadlineOf& deadline_of) {
+        const std::uint8_t pos = size_++;
+        heap_[pos] = slot;
+        pos_[slot] = pos;
+        sift_up(pos, deadline_of);
+    }
+
+    template <class DeadlineOf>
+    void remove(std::uint8_t slot, const DeadlineOf& deadline_of) {
+        const std::uint8_t pos = pos_[slot];
+        if (pos == NONE) {
+            return;
+        }
+        pos_[slot] = NONE;
+        const std::uint8_t last = --size_;
+        if (pos != last) {
+            heap_[pos] = heap_[last];
+            pos_[heap_[pos]] = pos;
+            sift_down(pos, deadline_of);
+            sift_up(pos, deadline_of);
+        }
+    }
+
+    template <class DeadlineOf>
+    std::uint8_t pop_due(std::uint32_t now, const DeadlineOf& deadline_of) {
+        if (size_ == 0 || before(now, deadline_of(heap_[0]))) {
+            return NONE;  // Earliest deadline not reached, so neither is any other
+        }
+        const std::uint8_t slot = heap_[0];
+        remove(slot, deadline_of);
+        return slot;
+    }
+
+    template <class DeadlineOf>
+    std::uint8_t earliest(const DeadlineOf&) const {
+        return (size_ == 0) ? NONE : heap_[0];
+    }
+
+    template <class DeadlineOf>
+    bool next_deadline(const DeadlineOf& deadline_of, std::uint32_t& deadline) const {
+        if (size_ == 0) {
+            return false;
+        }
+        deadline = deadline_of(heap_[0]);
+        return true;
+    }
+
+private:
+    template <class DeadlineOf>
+    bool earlier(std::uint8_t a, std::uint8_t b, const DeadlineOf& deadline_of) const {
+        return before(deadline_of(heap_[a]), deadline_of(heap_[b]));
+    }
+
+    void swap_entries(std::uint8_t a, std::uint8_t b) {
+        const std::uint8_t slot = heap_[a];
+        heap_[a] = heap_[b];
+        heap_[b] = slot;
+        pos_[heap_[a]] = a;
+        pos_[heap_[b]] = b;
+    }
+
+    template <class DeadlineOf>
+    void sift_up(std::uint8_t pos, const DeadlineOf& deadline_of) {
+        while (pos > 0) {
+            const std::uint8_t parent = static_cast<std::uint8_t>((pos - 1U) / 2U);
+            if (!earlier(pos, parent, deadline_of)) {
+                break;
+            }
+            swap_entries(pos, parent);
+            pos = parent;
+        }
+    }
+
+    template <class DeadlineOf>
+    void sift_down(std::uint8_t pos, const DeadlineOf& deadline_of) {
+        for (;;) {
+            const std::uint8_t left = static_cast<std::uint8_t>(2U * pos + 1U);
+            const std::uint8_t right = static_cast<std::uint8_t>(left + 1U);
+            std::uint8_t first = pos;
+            if (left < size_ && earlier(left, first, deadline_of)) {
+                first = left;
+            }
+            if (right < size_ && earlier(right, first, deadline_of)) {
+                first = right;
+            }
+            if (first == pos) {
+                break;
+            }
+            swap_entries(pos, first);
+            pos = first;
+        }
+    }
+
+    std::array<std::uint8_t, N> heap_{};                  // Slot indices in heap order
+    std::array<std::uint8_t, N> pos_ = none_filled<N>();  // Heap position of every slot, NONE when not queued
+    std::uint8_t size_ = 0;
+};
+
+template <std::uint8_t N, std::uint8_t WheelSize, std::uint16_t TickMs>
+class Wheel {
+    static_assert(N < NONE, "Timer slots are indexed with 8 bits");
+    // Powers of two keep ticks and buckets contiguous across the millis() wraparound
+    static_assert(WheelSize > 0 && (WheelSize & (WheelSize - 1U)) == 0, "Wheel size must be a power of two");
+    static_assert(TickMs > 0 && (TickMs & (TickMs - 1U)) == 0, "Wheel tick must be a power of two milliseconds");
+
+public:
+    constexpr Wheel() = default;
+
+    bool queued(std::uint8_t slot) const { return bucket_[slot] != NONE; }
+
+    template <class DeadlineOf>
+    void insert(std::uint8_t slot, const DeadlineOf& deadline_of) {
+        // Overdue deadlines (periodic timers catching up) go to the bucket under the cursor, which is still checked
+        std::uint32_t tick = deadline_of(slot) / TickMs;
+        if (started_ && before(tick, cursor_)) {
+            tick = cursor_;
+        }
+        const std::uint8_t b = static_cast<std::uint8_t>(tick % WheelSize);
+        bucket_[slot] = b;
+        prev_[slot] = NONE;
+        next_[slot] = head_[b];
+        if (head_[b] != NONE) {
+            prev_[head_[b]] = slot;
+        }
+        head_[b] = slot;
+    }
+
+    template <class DeadlineOf>
+    void remove(std::uint8_t slot, const DeadlineOf&) {
+        const std::uint8_t b = bucket_[slot];
+        if (b == NONE) {
+            return;
+        }
+        if (prev_[slot] != NONE) {
+            next_[prev_[slot]] = next_[slot];
+        } else {
+            head_[b] = next_[slot];
+        }
+        if (next_[slot] != NONE) {
+            prev_[next_[slot]] = prev_[slot];
+        }
+        bucket_[slot] = NONE;
+    }
+
+    template <class DeadlineOf>
+    std::uint8_t pop_due(std::uint32_t now, const DeadlineOf& deadline_of) {
+        const std::uint32_t now_tick = now / TickMs;
+        if (static_cast<std::uint32_t>(now_tick - cursor_) > WheelSize) {
+            cursor_ = now_tick - WheelSize;  // Behind by more than a revolution (or not started): visit every bucket once
+        }
+        started_ = true;
+        // Buckets of past ticks are drained before the cursor moves on; the current one is only checked, since
+        // timers may still be added to it
+        while (!before(now_tick, cursor_)) {
+            const std::uint8_t b = static_cast<std::uint8_t>(cursor_ % WheelSize);
+            for (std::uint8_t slot = head_[b]; slot != NONE; slot = next_[slot]) {
+                if (!before(now, deadline_of(slot))) {
+                    remove(slot, deadline_of);
+                    return slot;
+                }
+            }
+            if (cursor_ == now_tick) {
+                break;
+            }
+            ++cursor_;
+        }
+        return NONE;
+    }
+
+    // Walks all queued slots; meant for the idle path, not for every update
+    template <class DeadlineOf>
+    std::uint8_t earliest(const DeadlineOf& deadline_of) const {
+        std::uint8_t first = NONE;
+        for (std::uint8_t slot = 0; slot < N; ++slot) {
+            if (queued(slot) && (first == NONE || before(deadline_of(slot), deadline_of(first)))) {
+                first = slot;
+            }
+        }
+        return first;
+    }
+
+    template <class DeadlineOf>
+    bool next_deadline(const DeadlineOf& deadline_of, std::uint32_t& deadline) const {
+        const std::uint8_t first = earliest(deadline_of);
+        if (first == NONE) {
+            return false;
+        }
+        deadline = deadline_of(first);
+        return true;
+    }
+
+private:
+    std::array<std::uint8_t, WheelSize> head_ = none_filled<WheelSize>();  // First slot hashed to each bucket
+    std::array<std::uint8_t, N> next_ = none_filled<N>();
+    std::array<std::uint8_t, N> prev_ = none_filled<N>();
+    std::array<std::uint8_t, N> bucket_ = none_filled<N>();  // Bucket of every slot, NONE when not queued
+    std::uint32_t cursor_ = 0;                               // Tick of the next bucket to expire
+    bool started_ = false;                                   // Cursor follows the clock once pop_due() has run
+};
+
+} // namespace timer_queue
@@ -0,0 +1,316 @@
+#pragma once
+#include "ramen.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <array>
+#include <cstdint>
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+// I2C transactions run by the TWI interrupt instead of Wire, which waits out every transfer (a two-byte register read
+// at 100 kHz is 0.5 ms of a busy loop). Clients push a transaction; the interrupt works through the queue one bus
+// event at a time, and update() publishes each completed transaction to the port its client named, so expanders,
+// sensors and displays share the bus without the scan waiting for any of them:
+//
+//     twi::TwiBusActor bus;
+//     std::uint8_t reg = 0x00, temperature[2];
+//     ramen::Pushable<const twi::Result&> temperature_in = [](const twi::Result& r) { if (r.ok()) { ... } };
+//     ramen::Pusher<const twi::Result&> temperature_out;
+//
+//     void setup() {
+//         bus.begin(400000);
+//         temperature_out >> temperature_in;
+//     }
+//     void loop() {
+//         bus.request_in(twi::Transaction{0x48, &reg, 1, temperature, 2, &temperature_out, 0});  // Write, then read
+//         bus.update();
+//     }
+//
+// A transaction writes write_length bytes and then, after a repeated start, reads read_length bytes; either may be 0.
+// Its buffers belong to the client and must stay untouched until the result. A transaction that finds the queue of
+// TWI_QUEUE_DEPTH full is answered at once with QUEUE_FULL; one the bus does not finish within TIMEOUT_MS (a device
+// holding SDA low) is aborted with TIMEOUT, the TWI reset and the queue resumed. Results come in the order of the
+// requests, from update(), never from the interrupt.
+//
+// Opt-in with -D TWI_ASYNC, which defines the TWI interrupt (src/twi_bus.cpp): the Wire library cannot be used in the
+// same firmware, and a firmware has one bus actor. Without it every transaction is answered with NO_BUS.
+
+#ifndef TWI_QUEUE_DEPTH
+#define TWI_QUEUE_DEPTH 8  // A power of two, at most 128
+#endif
+
+namespace twi {
+
+#if defined(__AVR__) && defined(TWI_ASYNC)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+static_assert(TWI_QUEUE_DEPTH > 0 && TWI_QUEUE_DEPTH <= 128 && (TWI_QUEUE_DEPTH & (TWI_QUEUE_DEPTH - 1)) == 0,
+              "TWI_QUEUE_DEPTH must be a power of two in [1, 128]");
+
+enum class Status : std::uint8_t {
+    OK,
+    ADDRESS_NACK,  // No device answered the address
+    DATA_NACK,     // The device refused a byte written
+    BUS_ERROR,     // Illegal start or stop, e.g. noise on the lines
+    TIMEOUT,       // Aborted after TIMEOUT_MS
+    QUEUE_FULL,    // Not queued
+    NO_BUS         // Built without -D TWI_ASYNC
+};
+
+struct Result {
+    std::uint8_t tag;          // Of the transaction
+    std::uint8_t address;
+    Status status;
+    std::uint8_t transferred;  // Bytes of the phase that ended it: written, or read once the read began
+
+    bool ok() const { return status == Status::OK; }
+};
+
+struct Transaction {
+    std::uint8_t address;  // 7-bit
+    const std::uint8_t* write;
+    std::uint8_t write_length;
+    std::uint8_t* read;
+    std::uint8_t read_length;
+    ramen::Pusher<const Result&>* result_out;  // nullptr: no result wanted
+    std::uint8_t tag;                           // The client's, e.g. to tell its transactions apart
+};
+
+namespace detail {
+
+// TWSR status codes (prescaler bits masked) of master transmitter and receiver
+enum Code : std::uint8_t {
+    START = 0x08,
+    REPEATED_START = 0x10,
+    SLA_W_ACK = 0x18,
+    SLA_W_NACK = 0x20,
+    DATA_W_ACK = 0x28,
+    DATA_W_NACK = 0x30,
+    ARBITRATION_LOST = 0x38,
+    SLA_R_ACK = 0x40,
+    SLA_R_NACK = 0x48,
+    DATA_R_ACK = 0x50,
+    DATA_R_NACK = 0x58
+};
+
+struct Slot {
+    Transaction transaction;
+    Status status;
+    std::uint8_t transferred;
+};
+
+constexpr std::uint8_t MASK = TWI_QUEUE_DEPTH - 1;
+
+// Free-running indices: the main loop owns `head` (oldest not yet reported) and `tail` (next free), the interrupt
+// owns `run` (the transaction on the bus) while `busy`
+inline std::array<Slot, TWI_QUEUE_DEPTH> slots{};
+inline std::uint8_t head = 0;
+inline volatile std::uint8_t run = 0;
+inline volatile std::uint8_t tail = 0;
+inline volatile bool busy = false;
+inline std::uint8_t position = 0;  // Of the next byte of the phase
+
+#if defined(__AVR__) && defined(TWI_ASYNC)
+constexpr std::uint8_t GO = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+
+inline void start() { TWCR = GO | _BV(TWSTA); }
+
+// Ends the transaction on the bus and starts the next one, or releases the bus
+inline void finish(Status status) {
+    Slot& s = slots[run & MASK];
+    s.status = status;
+    s.transferred = position;
+    const std::uint8_t next = static_cast<std::uint8_t>(run + 1U);
+    run = next;
+    if (next != tail) {
+        TWCR = GO | _BV(TWSTO) | _BV(TWSTA);  // A stop, then a start
+    } else {
+        TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+        busy = false;
+    }
+}
+#endif
+
+// Interrupt side: the next step of the transaction on the bus
+inline void on_twi() {
+#if defined(__AVR__) && defined(TWI_ASYNC)
+    const Transaction& t = slots[run & MASK].transaction;
+    switch (static_cast<std::uint8_t>(TWSR & 0xF8)) {
+    case START:
+        position = 0;  // A read alone starts with SLA+R; a probe, with neither, with SLA+W
+        TWDR = static_cast<std::uint8_t>((t.address << 1) | ((t.write_length == 0 && t.read_length > 0) ? 1U : 0U));
+        TWCR = GO;
+        return;
+    case REPEATED_START:
+        position = 0;
+        TWDR = static_cast<std::uint8_t>((t.address << 1) | 1U);
+        TWCR = GO;
+        return;
+    case SLA_W_ACK:
+    case DATA_W_ACK:
+        if (position < t.write_length) {
+            TWDR = t.write[position++];
+            TWCR = GO;
+        } else if (t.read_length > 0) {
+            start();  // Repeated start
+        } else {
+            finish(Status::OK);
+        }
+        return;
+    case SLA_W_NACK:
+    case SLA_R_NACK:
+        finish(Status::ADDRESS_NACK);
+        return;
+    case DATA_W_NACK:
+        finish(Status::DATA_NACK);
+        return;
+    case ARBITRATION_LOST:
+        start();  // Again once the bus is free
+        return;
+    case SLA_R_ACK:
+        TWCR = GO | ((t.read_length > 1) ? _BV(TWEA) : 0);
+        return;
+    case DATA_R_ACK:
+        t.read[position++] = TWDR;
+        TWCR = GO | ((position + 1U < t.read_length) ? _BV(TWEA) : 0);  // NACK ends the read
+        return;
+    case DATA_R_NACK:
+        t.read[position++] = TWDR;
+        finish(Status::OK);
+        return;
+    default:
+        finish(Status::BUS_ERROR);
+        return;
+    }
+#endif
+}
+
+} // namespace detail
+
+class TwiBusActor {
+public:
+    static constexpr std::uint32_t DEFAULT_HZ = 100000;
+    static constexpr std::uint32_t TIMEOUT_MS = 25;  // 64 bytes at 100 kHz take 6 ms
+
+    TwiBusActor() = default;
+    TwiBusActor(const TwiBusActor&) = delete;
+    TwiBusActor& operator=(const TwiBusActor&) = delete;
+
+    // Input: transactions, run in the order they arrive
+    ramen::Pushable<const Transaction&> request_in = [this](const Transaction& t) { submit(t); };
+
+    // Sets the clock (100 or 400 kHz) and turns on the pull-ups of SDA and SCL, enough for short lines
+    void begin(std::uint32_t hz = DEFAULT_HZ) {
+#if defined(__AVR__) && defined(TWI_ASYNC)
+        digitalWrite(SDA, HIGH);
+        digitalWrite(SCL, HIGH);
+        TWSR = 0;  // Prescaler 1
+        TWBR = static_cast<std::uint8_t>(((F_CPU / hz) - 16U) / 2U);
+        TWCR = _BV(TWEN);
+#else
+        (void)hz;
+#endif
+    }
+
+    // Aborts a transaction the bus holds too long and publishes the results of the completed ones
+    void update() {
+        watch();
+        const std::uint8_t done = detail::run;
+        while (detail::head != done) {
+            const detail::Slot& s = detail::slots[detail::head & detail::MASK];
+            const Result result{s.transaction.tag, s.transaction.address, s.status, s.transferred};
+            ramen::Pusher<const Result&>* const out = s.transaction.result_out;
+            ++detail::head;  // Free before the push, which may queue the next transaction
+            count(result.ok() ? completed_ : failed_);
+            if (out != nullptr && *out) {
+                (*out)(result);
+            }
+        }
+    }
+
+    // Transactions queued or on the bus
+    std::uint8_t pending() const { return static_cast<std::uint8_t>(detail::tail - detail::head); }
+    bool idle() const { return pending() == 0; }
+
+    // Counters, saturating at 65535
+    std::uint16_t completed() const { return completed_; }
+    std::uint16_t failed() const { return failed_; }        // Timeouts and refusals among them
+    std::uint16_t timeouts() const { return timeouts_; }
+    std::uint16_t rejected() const { return rejected_; }    // QUEUE_FULL, answered at once, not counted as failed
+
+private:
+    std::uint8_t watched_ = 0;         // The transaction on the bus at the last update()
+    std::uint32_t watched_since_ = 0;
+    std::uint16_t completed_ = 0;
+    std::uint16_t failed_ = 0;
+    std::uint16_t timeouts_ = 0;
+    std::uint16_t rejected_ = 0;
+
+    static void count(std::uint16_t& counter) {
+        if (counter != UINT16_MAX) {
+            ++counter;
+        }
+    }
+
+    static void answer(const Transaction& t, Status status) {
+        if (t.result_out != nullptr && *t.result_out) {
+            (*t.result_out)(Result{t.tag, t.address, status, 0});
+        }
+    }
+
+    void submit(const Transaction& t) {
+        if (!ENABLED) {
+            answer(t, Status::NO_BUS);
+            return;
+        }
+        if (pending() >= TWI_QUEUE_DEPTH) {
+            count(rejected_);
+            answer(t, Status::QUEUE_FULL);
+            return;
+        }
+        const std::uint8_t at = detail::tail;
+        detail::slots[at & detail::MASK] = detail::Slot{t, Status::OK, 0};
+#if defined(__AVR__) && defined(TWI_ASYNC)
+        const std::uint8_t sreg = SREG;
+        cli();
+        detail::tail = static_cast<std::uint8_t>(at + 1U);
+        if (!detail::busy) {
+            detail::busy = true;
+            detail::start();
+        }
+        SREG = sreg;
+#endif
+    }
+
+    // Aborts the transaction on the bus once it has taken TIMEOUT_MS
+    void watch() {
+#if defined(__AVR__) && defined(TWI_ASYNC)
+        const std::uint32_t now = scan_clock::now();
+        const std::uint8_t run = detail::run;
+        if (!detail::busy || run != watched_) {
+            watched_ = run;
+            watched_since_ = now;
+            return;
+        }
+        if (now - watched_since_ < TIMEOUT_MS) {
+            return;
+        }
+        count(timeouts_);
+        const std::uint8_t sreg = SREG;
+        cli();
+        if (detail::busy && detail::run == run) {
+            TWCR = 0;  // Releases the lines; the TWI forgets the transfer
+            detail::finish(Status::TIMEOUT);  // Then a stop, and a start if more are queued
+        }
+        SREG = sreg;
+        watched_since_ = now;
+#endif
+    }
+};
+
+} // namespace twi
@@ -0,0 +1,262 @@
+#pragma once
+#include "binary_frame.hpp"
+#include "output_registry.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// A warm restart after a watchdog or software reset: the state of the outputs (blink interval and FSM state) and of
+// the objects passed to keep() is mirrored into .noinit RAM, which the reset leaves alone, and setup() takes it back
+// instead of the constructors' defaults. An output lit before the reset is driven high again as its pin becomes an
+// output, so it does not drop for the rest of setup():
+//
+//     warm_restart::WarmRestartActor<3> warm(outputs);
+//     void setup() {
+//         warm.keep(totaliser);                    // Plain data, e.g. the accumulators of a function block bank
+//         const bool warm_start = warm.begin();    // Restores the kept objects
+//         led1.init(warm.level(0));                // The level before the reset, or off
+//         ...
+//         led1.start();  config.begin();           // The cold defaults...
+//         warm.resume();                           // ...replaced by the state before the reset
+//     }
+//     void loop() { warm.update(); ... }
+//
+// update() compares a snapshot with the image every pass and writes the image again if it changed, alternately into
+// two copies with a sequence number and a CRC-16, so a reset in the middle of a write leaves the copy before it. The
+// image is taken back if a copy's CRC holds and it was written by the same build for the same outputs and kept
+// objects; RAM after a power-up fails that, as does the image of the firmware uploaded before. A restart that comes
+// within STABLE_MS of the one before counts against MAX_RESTARTS, after which the board starts cold, so state that
+// keeps the firmware crashing is dropped rather than restored for ever. Blinking resumes in the state it was in, with
+// a full interval: the time into the interval before the reset is lost.
+//
+// The cost is one snapshot a pass and a CRC over the image when something changed: some 60 us for 48 bytes, on every
+// pass if a kept object changes on every pass.
+//
+// Opt-in with -D WARM_RESTART; WARM_RESTART_SIZE sets the bytes of state kept, ENTRY_SIZE per output and then the
+// kept objects. Without it begin() is always a cold start and update() does nothing.
+
+#ifndef WARM_RESTART_SIZE
+#define WARM_RESTART_SIZE 48
+#endif
+
+namespace warm_restart {
+
+#if defined(WARM_RESTART)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uint16_t MAGIC = 0x5752;
+constexpr std::uint8_t MAX_RESTARTS = 3;     // Warm restarts in a row before a cold one
+constexpr std::uint32_t STABLE_MS = 60000;   // Of running, after which a restart counts as the first again
+
+struct Image {
+    std::uint16_t magic;
+    std::uint16_t build;     // Of the firmware that wrote it
+    std::uint16_t seq;
+    std::uint8_t restarts;   // Warm restarts in a row so far
+    std::uint8_t length;     // Of data
+    std::uint8_t data[WARM_RESTART_SIZE];
+    std::uint8_t crc[binary_frame::CRC_SIZE];
+};
+
+// Written in turn; in .noinit RAM on AVR (src/warm_restart.cpp), and defined only with -D WARM_RESTART
+extern Image images[2];
+
+namespace detail {
+
+// Tells one build from another: the time the including translation unit was compiled
+constexpr std::uint16_t build_tag() {
+    constexpr char STAMP[] = __DATE__ " " __TIME__;
+    std::uint16_t tag = 0x811C;
+    for (char c : STAMP) {
+        tag = static_cast<std::uint16_t>((tag ^ static_cast<std::uint8_t>(c)) * 0x0193U);
+    }
+    return tag;
+}
+
+inline std::uint16_t crc_of(const Image& image) {
+    return binary_frame::crc16(reinterpret_cast<const std::uint8_t*>(&image), offsetof(Image, crc));
+}
+
+inline bool valid(const Image& image) {
+    return image.magic == MAGIC && image.length <= WARM_RESTART_SIZE &&
+           crc_of(image) == binary_frame::read_le16(image.crc);
+}
+
+} // namespace detail
+
+template <std::uint8_t MaxOutputs, std::uint8_t MaxKept = 4>
+class WarmRestartActor {
+public:
+    static constexpr std::uint8_t ENTRY_SIZE = 5;  // interval:u32 state
+    static constexpr std::uint16_t BUILD = detail::build_tag();
+
+    static_assert(MaxOutputs * ENTRY_SIZE <= WARM_RESTART_SIZE && WARM_RESTART_SIZE <= 255,
+                  "WARM_RESTART_SIZE holds the outputs, in at most 255 bytes");
+
+    explicit WarmRestartActor(const led::OutputTable& output_table) : outputs(output_table) {}
+    WarmRestartActor(const WarmRestartActor&) = delete;
+    WarmRestartActor& operator=(const WarmRestartActor&) = delete;
+
+    // Keeps `value` across warm restarts, restored by begin(); false if WARM_RESTART_SIZE has no room left for it.
+    // Call before begin(), in the same order in every build
+    template <class T>
+    bool keep(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Kept objects are copied byte for byte");
+        if (kept_count_ >= MaxKept || layout_size() + sizeof(T) > WARM_RESTART_SIZE) {
+            return false;
+        }
+        kept_[kept_count_++] = Kept{&value, static_cast<std::uint8_t>(sizeof(T))};
+        kept_size_ = static_cast<std::uint8_t>(kept_size_ + sizeof(T));
+        return true;
+    }
+
+    // True for a warm restart, with the kept objects restored; false for a cold start, which discards any image
+    bool begin() {
+        started_ms_ = scan_clock::now();
+        warm_ = false;
+#if defined(WARM_RESTART)
+        const Image* image = newest();
+        if (image == nullptr || image->build != BUILD || image->length != layout_size() ||
+            image->restarts >= MAX_RESTARTS) {
+            discard();
+            return false;
+        }
+        warm_ = true;
+        seq_ = image->seq;
+        restarts_ = static_cast<std::uint8_t>(image->restarts + 1U);
+        std::memcpy(data_, image->data, image->length);
+        std::uint8_t offset = output_size();
+        for (std::uint8_t k = 0; k < kept_count_; ++k) {
+            std::memcpy(kept_[k].object, data_ + offset, kept_[k].size);
+            offset = static_cast<std::uint8_t>(offset + kept_[k].size);
+        }
+        save();  // The count of restarts, before anything else can reset the board
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // The level of output `index` before the reset, for the output's init(); false after a cold start
+    bool level(std::uint8_t index) const {
+        return warm_ && index < output_count() && data_[index * ENTRY_SIZE + 4U] == led::STATE_LED_ON;
+    }
+
+    // Puts the outputs back in their state before the reset; does nothing after a cold start
+    void resume() {
+        if (!warm_) {
+            return;
+        }
+        for (std::uint8_t i = 0; i < output_count(); ++i) {
+            const led::OutputRef output = outputs.at(i);
+            const std::uint8_t* entry = data_ + i * ENTRY_SIZE;
+            const std::uint32_t interval = binary_frame::read_le32(entry);
+            if (interval > 0) {
+                output.set_blink_interval(interval);
+            }
+            if (entry[4] < led::STATE_COUNT) {
+                output.resume(entry[4]);
+            }
+        }
+    }
+
+    // Writes the image again if the state changed
+    void update() {
+#if defined(WARM_RESTART)
+        bool changed = false;
+        if (restarts_ != 0 && scan_clock::now() - started_ms_ >= STABLE_MS) {
+            restarts_ = 0;
+            changed = true;
+        }
+        std::uint8_t snapshot[WARM_RESTART_SIZE];
+        take(snapshot);
+        if (changed || std::memcmp(snapshot, data_, layout_size()) != 0) {
+            std::memcpy(data_, snapshot, layout_size());
+            save();
+        }
+#endif
+    }
+
+    // Invalidates the image, so the next reset starts cold (before a reset meant to start afresh, say)
+    void discard() {
+#if defined(WARM_RESTART)
+        images[0].magic = 0;
+        images[1].magic = 0;
+#endif
+    }
+
+    bool warm() const { return warm_; }
+    std::uint8_t restarts() const { return restarts_; }  // Warm restarts in a row, this one included
+    std::uint16_t writes() const { return writes_; }     // Of the image, saturating at 65535
+
+private:
+    struct Kept {
+        void* object;
+        std::uint8_t size;
+    };
+
+    const led::OutputTable& outputs;
+    Kept kept_[MaxKept] = {};
+    std::uint8_t kept_count_ = 0;
+    std::uint8_t kept_size_ = 0;
+    std::uint8_t data_[WARM_RESTART_SIZE] = {};
+    std::uint8_t active_ = 0;  // The copy written last
+    std::uint16_t seq_ = 0;
+    std::uint8_t restarts_ = 0;
+    bool warm_ = false;
+    std::uint32_t started_ms_ = 0;
+    std::uint16_t writes_ = 0;
+
+    std::uint8_t output_count() const { return outputs.size() < MaxOutputs ? outputs.size() : MaxOutputs; }
+    std::uint8_t output_size() const { return static_cast<std::uint8_t>(output_count() * ENTRY_SIZE); }
+    std::uint8_t layout_size() const { return static_cast<std::uint8_t>(output_size() + kept_size_); }
+
+    // The newest copy whose CRC holds, or nullptr
+    const Image* newest() {
+        const bool ok0 = detail::valid(images[0]);
+        const bool ok1 = detail::valid(images[1]);
+        if (!ok0 && !ok1) {
+            return nullptr;
+        }
+        active_ = (ok0 && (!ok1 || static_cast<std::int16_t>(images[0].seq - images[1].seq) > 0)) ? 0 : 1;
+        return &images[active_];
+    }
+
+    void take(std::uint8_t* snapshot) const {
+        for (std::uint8_t i = 0; i < output_count(); ++i) {
+            const led::OutputRef output = outputs.at(i);
+            std::uint8_t* entry = snapshot + i * ENTRY_SIZE;
+            binary_frame::write_le32(entry, output.blink_interval_ms());
+            entry[4] = output.state_id();
+        }
+        std::uint8_t offset = output_size();
+        for (std::uint8_t k = 0; k < kept_count_; ++k) {
+            std::memcpy(snapshot + offset, kept_[k].object, kept_[k].size);
+            offset = static_cast<std::uint8_t>(offset + kept_[k].size);
+        }
+    }
+
+    // Into the copy not written last, which then becomes the newest
+    void save() {
+        active_ ^= 1U;
+        Image& image = images[active_];
+        image.magic = MAGIC;
+        image.build = BUILD;
+        image.seq = ++seq_;
+        image.restarts = restarts_;
+        image.length = layout_size();
+        std::memcpy(image.data, data_, image.length);
+        binary_frame::write_le16(image.crc, detail::crc_of(image));
+        if (writes_ != UINT16_MAX) {
+            ++writes_;
+        }
+    }
+};
+
+} // namespace warm_restart
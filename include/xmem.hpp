@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
+
+// External SRAM on the ATmega2560's memory bus, for large buffers that are too big for the 8 KB inside.
+//
+// With -D XMEM, src/xmem.cpp enables the bus in .init3, before .data is copied and before any constructor runs, and
+// the addresses from START (just past the internal SRAM, 0x2200) to XMEM_END address the expansion: 0x8000 for a
+// 32 KB part, whose lowest 8.5 KB the internal SRAM hides, or 0x10000 for 64 KB. The linker never places anything
+// there (.data, .bss, the heap and the stack stay inside), so the region is handed out by allocate(), in order and
+// for good, to the buffers that are set up once:
+//
+//     inline Trace& trace = xmem::place<Trace>();                       // In XMEM, or the heap if it is full
+//     std::uint8_t* history = static_cast<std::uint8_t*>(xmem::allocate(4096));   // nullptr without room
+//
+// The bus takes port A (multiplexed AD0-7), port C (A8-15) and PG0-2 (WR, RD, ALE), so their pins cannot be used
+// for anything else, and an access costs one cycle more than inside, plus XMEM_WAIT_STATES: buffers that are written
+// in bulk and read rarely (traces, logs, histories, serial rings) belong in XMEM, the scan's working data inside.
+// Objects in XMEM are not zeroed by the startup code; place() constructs them, allocate() leaves the bytes as the
+// chip powered up. test() checks that the expansion is there.
+//
+// Opt-in with -D XMEM; XMEM_END and XMEM_WAIT_STATES (0 to 3, for the upper sector, which is all of the region) set
+// the part. Without it allocate() returns nullptr and place() takes the heap.
+
+#ifndef XMEM_END
+#define XMEM_END 0x8000UL
+#endif
+#ifndef XMEM_WAIT_STATES
+#define XMEM_WAIT_STATES 0
+#endif
+
+namespace xmem {
+
+#if defined(XMEM)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::uintptr_t START = 0x2200;  // RAMEND + 1 on the ATmega2560
+constexpr std::size_t SIZE = ENABLED ? static_cast<std::size_t>(XMEM_END - START) : 0;
+
+static_assert(XMEM_END > START && XMEM_END <= 0x10000UL, "XMEM_END is past the internal SRAM and at most 0x10000");
+static_assert(XMEM_WAIT_STATES >= 0 && XMEM_WAIT_STATES <= 3, "XMEM_WAIT_STATES is 0 to 3");
+
+#if defined(__AVR__)
+// SRE enables the bus; with no sector limit (SRL = 0) the whole region is the upper sector, timed by SRW11:SRW10
+constexpr std::uint8_t XMCRA_VALUE = static_cast<std::uint8_t>(_BV(SRE) | (XMEM_WAIT_STATES << SRW10));
+#endif
+
+namespace detail {
+#if defined(XMEM) && !defined(__AVR__)
+alignas(std::max_align_t) inline std::uint8_t host_region[SIZE];  // Off the board, ordinary memory stands in
+#endif
+inline std::size_t used = 0;
+inline std::uint16_t spilled = 0;
+
+inline std::uint8_t* region() {
+#if defined(XMEM) && defined(__AVR__)
+    return reinterpret_cast<std::uint8_t*>(START);
+#elif defined(XMEM)
+    return host_region;
+#else
+    return nullptr;
+#endif
+}
+} // namespace detail
+
+// `size` bytes of XMEM at a multiple of `align`, kept for good; nullptr if the region has no room left
+inline void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+    if (!ENABLED) {
+        return nullptr;
+    }
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(detail::region());
+    const std::size_t offset = static_cast<std::size_t>(((base + detail::used + align - 1U) & ~(align - 1U)) - base);
+    if (offset > SIZE || size > SIZE - offset) {
+        return nullptr;
+    }
+    detail::used = offset + size;
+    return detail::region() + offset;
+}
+
+// A T constructed in XMEM, or on the internal heap if the region is full (counted in spilled()) or disabled
+template <class T, class... Args>
+T& place(Args&&... args) {
+    void* storage = allocate(sizeof(T), alignof(T));
+    if (storage == nullptr) {
+        if (ENABLED && detail::spilled != UINT16_MAX) {
+            ++detail::spilled;
+        }
+        return *new T(std::forward<Args>(args)...);
+    }
+    return *new (storage) T(std::forward<Args>(args)...);
+}
+
+inline std::size_t used() { return detail::used; }
+inline std::size_t available() { return SIZE - detail::used; }
+inline std::uint16_t spilled() { return detail::spilled; }  // Objects place() put on the heap, saturating at 65535
+
+// Whether the expansion answers over the whole region: a pattern written into the first and last bytes not yet
+// allocated is read back, and the bytes are restored
+inline bool test() {
+    if (!ENABLED || available() < 2) {
+        return ENABLED;
+    }
+    volatile std::uint8_t* const first = detail::region() + detail::used;
+    volatile std::uint8_t* const last = detail::region() + SIZE - 1U;
+    const std::uint8_t saved_first = *first;
+    const std::uint8_t saved_last = *last;
+    *first = 0xA5;
+    *last = 0x5A;
+    const bool ok = *first == 0xA5 && *last == 0x5A;
+    *last = saved_last;
+    *first = saved_first;
+    return ok;
+}
+
+} // namespace xmem
@@ -0,0 +1,188 @@
+/*
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// The AVR has no atomic instructions beyond single-byte loads and stores,
+// so avr-gcc turns every other std::atomic operation (a 16- or 32-bit load,
+// any read-modify-write, atomic<T> of a struct) into a call to the
+// __atomic_* library functions that libatomic provides elsewhere. These are
+// those functions for a single core: each runs with interrupts disabled and
+// restores the interrupt flag afterwards, so it is atomic against interrupt
+// handlers and can be used from them. A 16-bit operation masks interrupts for
+// a few cycles.
+//
+// The compiler still reports these types as not always lock-free
+// (ATOMIC_SHORT_LOCK_FREE and friends are __GCC_ATOMIC_*_LOCK_FREE), and
+// is_lock_free() agrees: masking interrupts is a lock, if one no handler can
+// deadlock on. Only the byte loads and stores are inlined and lock-free.
+
+#if defined(__AVR__)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace
+{
+	// Saves SREG and disables interrupts; the memory clobbers keep the
+	// compiler from moving accesses out of the critical section.
+	struct __irq_guard
+	{
+		uint8_t __sreg;
+
+		__irq_guard()
+		{ __asm__ __volatile__("in %0, __SREG__\n\tcli" : "=r"(__sreg) :: "memory"); }
+
+		~__irq_guard()
+		{ __asm__ __volatile__("out __SREG__, %0" :: "r"(__sreg) : "memory"); }
+	};
+
+	template<typename _Tp>
+	inline _Tp
+	__load(const volatile void* __ptr)
+	{
+		__irq_guard __g;
+		return *static_cast<const volatile _Tp*>(__ptr);
+	}
+
+	template<typename _Tp>
+	inline void
+	__store(volatile void* __ptr, _Tp __val)
+	{
+		__irq_guard __g;
+		*static_cast<volatile _Tp*>(__ptr) = __val;
+	}
+
+	template<typename _Tp>
+	inline _Tp
+	__exchange(volatile void* __ptr, _Tp __val)
+	{
+		__irq_guard __g;
+		volatile _Tp* __p = static_cast<volatile _Tp*>(__ptr);
+		const _Tp __old = *__p;
+		*__p = __val;
+		return __old;
+	}
+
+	template<typename _Tp>
+	inline bool
+	__compare_exchange(volatile void* __ptr, void* __expected, _Tp __desired)
+	{
+		__irq_guard __g;
+		volatile _Tp* __p = static_cast<volatile _Tp*>(__ptr);
+		_Tp* __e = static_cast<_Tp*>(__expected);
+		const _Tp __cur = *__p;
+		if (__cur == *__e)
+		{
+			*__p = __desired;
+			return true;
+		}
+		*__e = __cur;
+		return false;
+	}
+
+	// Applies __op and returns the value before (__Fetch_first) or after it
+	template<bool __Fetch_first, typename _Tp, typename _Op>
+	inline _Tp
+	__rmw(volatile void* __ptr, _Tp __val, _Op __op)
+	{
+		__irq_guard __g;
+		volatile _Tp* __p = static_cast<volatile _Tp*>(__ptr);
+		const _Tp __old = *__p;
+		const _Tp __new = __op(__old, __val);
+		*__p = __new;
+		return __Fetch_first ? __old : __new;
+	}
+
+	struct __add { template<typename _Tp> _Tp operator()(_Tp __a, _Tp __b) const { return __a + __b; } };
+	struct __sub { template<typename _Tp> _Tp operator()(_Tp __a, _Tp __b) const { return __a - __b; } };
+	struct __and { template<typename _Tp> _Tp operator()(_Tp __a, _Tp __b) const { return __a & __b; } };
+	struct __or  { template<typename _Tp> _Tp operator()(_Tp __a, _Tp __b) const { return __a | __b; } };
+	struct __xor { template<typename _Tp> _Tp operator()(_Tp __a, _Tp __b) const { return __a ^ __b; } };
+	struct __nand { template<typename _Tp> _Tp operator()(_Tp __a, _Tp __b) const { return ~(__a & __b); } };
+} // namespace
+
+#define __AVR_ATOMIC_RMW(_N, _Tp, _Name, _Op)					\
+	_Tp __atomic_fetch_##_Name##_##_N(volatile void* __ptr, _Tp __val, int)	\
+	{ return __rmw<true>(__ptr, __val, _Op{}); }				\
+	_Tp __atomic_##_Name##_fetch_##_N(volatile void* __ptr, _Tp __val, int)	\
+	{ return __rmw<false>(__ptr, __val, _Op{}); }
+
+#define __AVR_ATOMIC(_N, _Tp)							\
+	_Tp __atomic_load_##_N(const volatile void* __ptr, int)			\
+	{ return __load<_Tp>(__ptr); }						\
+	void __atomic_store_##_N(volatile void* __ptr, _Tp __val, int)		\
+	{ __store(__ptr, __val); }						\
+	_Tp __atomic_exchange_##_N(volatile void* __ptr, _Tp __val, int)	\
+	{ return __exchange(__ptr, __val); }					\
+	bool __atomic_compare_exchange_##_N(volatile void* __ptr,		\
+					    void* __expected, _Tp __desired,	\
+					    bool, int, int)			\
+	{ return __compare_exchange(__ptr, __expected, __desired); }		\
+	__AVR_ATOMIC_RMW(_N, _Tp, add, __add)					\
+	__AVR_ATOMIC_RMW(_N, _Tp, sub, __sub)					\
+	__AVR_ATOMIC_RMW(_N, _Tp, and, __and)					\
+	__AVR_ATOMIC_RMW(_N, _Tp, or, __or)					\
+	__AVR_ATOMIC_RMW(_N, _Tp, xor, __xor)					\
+	__AVR_ATOMIC_RMW(_N, _Tp, nand, __nand)
+
+extern "C"
+{
+	__AVR_ATOMIC(1, uint8_t)
+	__AVR_ATOMIC(2, uint16_t)
+	__AVR_ATOMIC(4, uint32_t)
+	__AVR_ATOMIC(8, uint64_t)
+
+	// The generic forms, for std::atomic<T> of any trivially copyable T
+
+	void
+	__atomic_load(size_t __size, const volatile void* __ptr, void* __ret, int)
+	{
+		__irq_guard __g;
+		memcpy(__ret, const_cast<const void*>(__ptr), __size);
+	}
+
+	void
+	__atomic_store(size_t __size, volatile void* __ptr, void* __val, int)
+	{
+		__irq_guard __g;
+		memcpy(const_cast<void*>(__ptr), __val, __size);
+	}
+
+	void
+	__atomic_exchange(size_t __size, volatile void* __ptr, void* __val,
+			  void* __ret, int)
+	{
+		__irq_guard __g;
+		memcpy(__ret, const_cast<const void*>(__ptr), __size);
+		memcpy(const_cast<void*>(__ptr), __val, __size);
+	}
+
+	bool
+	__atomic_compare_exchange(size_t __size, volatile void* __ptr,
+				  void* __expected, void* __desired, int, int)
+	{
+		__irq_guard __g;
+		if (memcmp(const_cast<const void*>(__ptr), __expected, __size) == 0)
+		{
+			memcpy(const_cast<void*>(__ptr), __desired, __size);
+			return true;
+		}
+		memcpy(__expected, const_cast<const void*>(__ptr), __size);
+		return false;
+	}
+
+	bool
+	__atomic_is_lock_free(size_t, const volatile void*)
+	{ return false; }
+}
+
+#undef __AVR_ATOMIC
+#undef __AVR_ATOMIC_RMW
+
+#endif // __AVR__
@@ -194,7 +194,12 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
     static size_t
     hash(const void* __ptr, size_t __clength,
 	 size_t __seed = static_cast<size_t>(0xc70f6907UL))
+#if defined(AVR_STD_HASH_FNV) && __SIZEOF_SIZE_T__ == 2
+    // The 16-bit FNV-1a of hash_bytes.cc rather than CRC-CCITT
+    { return _Fnv_hash_bytes(__ptr, __clength, __seed); }
+#else
     { return _Hash_bytes(__ptr, __clength, __seed); }
+#endif
 
     template<typename _Tp>
       static size_t
@@ -180,6 +180,7 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
     return hash;
   }
 #elif __SIZEOF_SIZE_T__ == 2 && defined(__AVR__)
+  // CRC-CCITT, one table-free byte step of <util/crc16.h> per byte.
   size_t
   _Hash_bytes(const void* ptr, size_t len, size_t seed)
   {
@@ -191,9 +192,21 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
     return hash;
   }
 
+  // FNV-1a in 16 bits: the low half of the 32-bit FNV-1a hash, which the
+  // high half of the prime 0x01000193 and of the offset basis never
+  // reaches, so a byte costs a 16-bit multiply instead of a 32-bit one.
+  // Selected for std::hash by AVR_STD_HASH_FNV (see functional_hash.h).
   size_t
-  _Fnv_hash_bytes(const void* ptr, size_t len, size_t seed)
-  { return _Hash_bytes(ptr, len, seed); }
+  _Fnv_hash_bytes(const void* ptr, size_t len, size_t hash)
+  {
+    const unsigned char* cptr = static_cast<const unsigned char*>(ptr);
+    for (; len; --len)
+      {
+	hash ^= static_cast<size_t>(*cptr++);
+	hash *= static_cast<size_t>(0x0193);
+      }
+    return hash;
+  }
 #else
 
   // Dummy hash implementation for unusual sizeof(size_t).
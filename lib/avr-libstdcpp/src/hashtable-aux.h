@@ -24,6 +24,25 @@
 
 namespace __detail
 {
+#if __SIZEOF_SIZE_T__ == 2
+  // With a 16-bit size_t only the primes up to 4027 are kept: a bucket
+  // array of 4027 pointers already fills the 8 KB of RAM of an AVR, and
+  // the table itself lives in RAM like any const data there.  The last
+  // prime doubles as the sentinel.
+  extern const size_t __prime_list[] = // 79 + 1
+  {
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+    37, 41, 43, 47, 53, 59, 61, 67, 71, 73, 79,
+    83, 89, 97, 103, 109, 113, 127, 137, 139, 149,
+    157, 167, 179, 193, 199, 211, 227, 241, 257,
+    277, 293, 313, 337, 359, 383, 409, 439, 467,
+    503, 541, 577, 619, 661, 709, 761, 823, 887,
+    953, 1031, 1109, 1193, 1289, 1381, 1493, 1613,
+    1741, 1879, 2029, 2179, 2357, 2549, 2753, 2971,
+    3209, 3469, 3739, 4027,
+    4027
+  };
+#else
   // The sentinel value is kept only for abi backward compatibility.
   extern const unsigned long __prime_list[] = // 256 + 1 or 256 + 48 + 1
   {
@@ -89,4 +108,5 @@ namespace __detail
     18446744073709551557ul, 18446744073709551557ul
 #endif
   };
+#endif
 } // namespace __detail
@@ -64,14 +64,14 @@ namespace __detail
 
     // Number of primes (without sentinel).
     constexpr auto __n_primes
-      = sizeof(__prime_list) / sizeof(unsigned long) - 1;
+      = sizeof(__prime_list) / sizeof(__prime_list[0]) - 1;
 
     // Don't include the last prime in the search, so that anything
     // higher than the second-to-last prime returns a past-the-end
     // iterator that can be dereferenced to get the last prime.
     constexpr auto __last_prime = __prime_list + __n_primes - 1;
 
-    const unsigned long* __next_bkt =
+    const auto* __next_bkt =
       std::lower_bound(__prime_list + 6, __last_prime, __n);
 
     if (__next_bkt == __last_prime)
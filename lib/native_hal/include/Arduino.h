@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// The part of the Arduino AVR core API the firmware uses, over the simulated board of native_hal.hpp. Flash is
+// ordinary memory here, so PROGMEM, F() and the pgm_read_*() and *_P() functions read it directly.
+
+typedef std::uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define SERIAL_8N1 0x06
+#define SERIAL_8E1 0x26
+#define SERIAL_8N2 0x0E
+
+#define PROGMEM
+#define PSTR(s) (s)
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(PSTR(s)))
+#define pgm_read_byte(p) (*(const std::uint8_t*)(p))
+#define pgm_read_word(p) (*(const std::uint16_t*)(p))
+#define pgm_read_dword(p) (*(const std::uint32_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strlen_P std::strlen
+#define strncpy_P std::strncpy
+#define strcmp_P std::strcmp
+#define memcpy_P std::memcpy
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(std::uint8_t pin, std::uint8_t mode);
+void digitalWrite(std::uint8_t pin, std::uint8_t level);
+int digitalRead(std::uint8_t pin);
+int analogRead(std::uint8_t pin);
+void analogWrite(std::uint8_t pin, int value);
+
+inline void interrupts() {}
+inline void noInterrupts() {}
+inline int digitalPinToInterrupt(std::uint8_t pin) { return pin; }
+inline void attachInterrupt(int, void (*)(), int) {}
+inline void detachInterrupt(int) {}
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual std::size_t write(std::uint8_t c) = 0;
+    virtual std::size_t write(const std::uint8_t* buffer, std::size_t size);
+    std::size_t write(const char* text) { return write(reinterpret_cast<const std::uint8_t*>(text), std::strlen(text)); }
+    virtual int availableForWrite() { return 0; }
+
+    std::size_t print(const char* text) { return write(text); }
+    std::size_t print(const __FlashStringHelper* text) { return print(reinterpret_cast<const char*>(text)); }
+    std::size_t print(char c) { return write(static_cast<std::uint8_t>(c)); }
+    std::size_t print(unsigned long value, int base = 10);
+    std::size_t print(long value, int base = 10);
+    std::size_t print(unsigned value, int base = 10) { return print(static_cast<unsigned long>(value), base); }
+    std::size_t print(int value, int base = 10) { return print(static_cast<long>(value), base); }
+
+    std::size_t println() { return write("\r\n"); }
+    template <typename T>
+    std::size_t println(const T& value) { return print(value) + println(); }
+    template <typename T>
+    std::size_t println(const T& value, int base) { return print(value, base) + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+    explicit HardwareSerial(std::uint8_t port) : port_(port) {}
+
+    void begin(unsigned long) {}
+    void begin(unsigned long, std::uint8_t) {}
+    void end() {}
+    int available();
+    int read();
+    int peek();
+    void flush() {}
+    std::size_t write(std::uint8_t c) override;
+    std::size_t write(const std::uint8_t* buffer, std::size_t size) override;
+    using Print::write;
+    int availableForWrite() override { return 63; }  // The core's TX buffer, always drained
+    explicit operator bool() const { return true; }
+
+private:
+    std::uint8_t port_;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+extern HardwareSerial Serial3;
+
+void setup();
+void loop();
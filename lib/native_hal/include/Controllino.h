@@ -0,0 +1,32 @@
+#pragma once
+#include <Arduino.h>
+
+// The CONTROLLINO pin names the firmware and its examples use, as Arduino pin numbers of the ATmega2560
+
+#define CONTROLLINO_D0 2
+#define CONTROLLINO_D1 3
+#define CONTROLLINO_D2 4
+#define CONTROLLINO_D3 5
+#define CONTROLLINO_D4 6
+#define CONTROLLINO_D5 7
+#define CONTROLLINO_D6 8
+#define CONTROLLINO_D7 9
+
+#define CONTROLLINO_R0 22
+#define CONTROLLINO_R1 23
+#define CONTROLLINO_R2 24
+#define CONTROLLINO_R3 25
+#define CONTROLLINO_R4 26
+#define CONTROLLINO_R5 27
+#define CONTROLLINO_R6 28
+#define CONTROLLINO_R7 29
+#define CONTROLLINO_R8 30
+#define CONTROLLINO_R9 31
+
+#define CONTROLLINO_IN0 18
+#define CONTROLLINO_IN1 19
+
+#define CONTROLLINO_A0 54
+#define CONTROLLINO_A1 55
+#define CONTROLLINO_A2 56
+#define CONTROLLINO_A3 57
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// The simulated board of the native environment (pio run -e native): a virtual clock, the pin levels and the serial
+// ports, for running and profiling the firmware on a workstation.
+//
+// Time only moves when the simulation moves it: main() (src/native_main.cpp) advances the clock by a fixed step after
+// every loop() pass, delay() and delayMicroseconds() advance it by their argument, and nothing else does. A run is
+// therefore the same on every machine and under any profiler, however slow it makes the code: timer expiries,
+// debounce times and serial timeouts happen after the same passes.
+//
+// Serial input is given before the run, all at once; output goes to stdout, prefixed with the port unless it is
+// Serial. A pin write is printed to stderr as "<ms> D<pin>=<level>" when NATIVE_GPIO_TRACE is set in the environment.
+
+namespace native_hal {
+
+constexpr std::uint8_t PIN_COUNT = 70;  // Of the ATmega2560 Arduino core
+
+// Virtual time since reset
+std::uint64_t now_us();
+void advance_us(std::uint32_t us);
+inline void advance_ms(std::uint32_t ms) { advance_us(ms * 1000UL); }
+
+// Level last written to an output, or set on an input
+std::uint8_t pin_level(std::uint8_t pin);
+void set_pin_level(std::uint8_t pin, std::uint8_t level);
+std::uint32_t pin_writes();  // digitalWrite() calls so far
+
+// Bytes the firmware will read from a serial port (0 is Serial), appended to what it has not read yet
+void feed_serial(std::uint8_t port, const std::string& bytes);
+
+} // namespace native_hal
@@ -0,0 +1,130 @@
+#include "native_hal.hpp"
+#include <Arduino.h>
+#include <array>
+#include <cstdio>
+
+namespace {
+
+std::uint64_t clock_us = 0;
+std::array<std::uint8_t, native_hal::PIN_COUNT> levels{};
+std::uint32_t writes = 0;
+const bool trace_gpio = std::getenv("NATIVE_GPIO_TRACE") != nullptr;
+
+constexpr std::uint8_t SERIAL_PORTS = 4;
+struct SerialInput {
+    std::string bytes;
+    std::size_t pos = 0;
+};
+std::array<SerialInput, SERIAL_PORTS> inputs;
+std::array<bool, SERIAL_PORTS> line_start{{true, true, true, true}};
+
+} // namespace
+
+namespace native_hal {
+
+std::uint64_t now_us() { return clock_us; }
+void advance_us(std::uint32_t us) { clock_us += us; }
+
+std::uint8_t pin_level(std::uint8_t pin) { return (pin < PIN_COUNT) ? levels[pin] : LOW; }
+
+void set_pin_level(std::uint8_t pin, std::uint8_t level) {
+    if (pin < PIN_COUNT) {
+        levels[pin] = (level != LOW) ? HIGH : LOW;
+    }
+}
+
+std::uint32_t pin_writes() { return writes; }
+
+void feed_serial(std::uint8_t port, const std::string& bytes) {
+    if (port < SERIAL_PORTS) {
+        SerialInput& in = inputs[port];
+        in.bytes.erase(0, in.pos);
+        in.pos = 0;
+        in.bytes += bytes;
+    }
+}
+
+} // namespace native_hal
+
+unsigned long millis() { return static_cast<unsigned long>(clock_us / 1000U); }
+unsigned long micros() { return static_cast<unsigned long>(clock_us); }
+void delay(unsigned long ms) { native_hal::advance_us(static_cast<std::uint32_t>(ms * 1000UL)); }
+void delayMicroseconds(unsigned int us) { native_hal::advance_us(us); }
+
+void pinMode(std::uint8_t, std::uint8_t) {}
+
+void digitalWrite(std::uint8_t pin, std::uint8_t level) {
+    native_hal::set_pin_level(pin, level);
+    ++writes;
+    if (trace_gpio) {
+        std::fprintf(stderr, "%lu D%u=%u\n", millis(), static_cast<unsigned>(pin), native_hal::pin_level(pin));
+    }
+}
+
+int digitalRead(std::uint8_t pin) { return native_hal::pin_level(pin); }
+int analogRead(std::uint8_t) { return 0; }
+void analogWrite(std::uint8_t pin, int value) { digitalWrite(pin, value >= 128 ? HIGH : LOW); }
+
+std::size_t Print::write(const std::uint8_t* buffer, std::size_t size) {
+    std::size_t n = 0;
+    while (n < size && write(buffer[n]) == 1) {
+        ++n;
+    }
+    return n;
+}
+
+std::size_t Print::print(unsigned long value, int base) {
+    char digits[8 * sizeof(value) + 1];
+    char* p = digits + sizeof(digits);
+    *--p = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        const unsigned long digit = value % static_cast<unsigned long>(base);
+        *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= static_cast<unsigned long>(base);
+    } while (value != 0);
+    return write(p);
+}
+
+std::size_t Print::print(long value, int base) {
+    if (value < 0 && base == 10) {
+        return print('-') + print(0UL - static_cast<unsigned long>(value), base);
+    }
+    return print(static_cast<unsigned long>(value), base);
+}
+
+int HardwareSerial::available() {
+    const SerialInput& in = inputs[port_];
+    return static_cast<int>(in.bytes.size() - in.pos);
+}
+
+int HardwareSerial::read() {
+    SerialInput& in = inputs[port_];
+    return (in.pos < in.bytes.size()) ? static_cast<unsigned char>(in.bytes[in.pos++]) : -1;
+}
+
+int HardwareSerial::peek() {
+    const SerialInput& in = inputs[port_];
+    return (in.pos < in.bytes.size()) ? static_cast<unsigned char>(in.bytes[in.pos]) : -1;
+}
+
+std::size_t HardwareSerial::write(std::uint8_t c) { return write(&c, 1); }
+
+std::size_t HardwareSerial::write(const std::uint8_t* buffer, std::size_t size) {
+    // Lines of the other ports are marked with the port
+    for (std::size_t i = 0; i < size; ++i) {
+        if (port_ != 0 && line_start[port_]) {
+            std::printf("[Serial%u] ", static_cast<unsigned>(port_));
+        }
+        std::putchar(buffer[i]);
+        line_start[port_] = (buffer[i] == '\n');
+    }
+    return size;
+}
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+HardwareSerial Serial3(3);
@@ -0,0 +1,28 @@
+#include "native_hal.hpp"
+#include <Arduino.h>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+
+// Runs the firmware on the simulated board: stdin becomes the input of Serial, then setup() runs once and loop() a
+// given number of passes, the virtual clock advancing by a fixed step after each.
+//
+//     program [passes [step_us]]        defaults: 10000 passes of 1000 us, i.e. 10 s of virtual time
+//
+//     echo "start 1-3; interval 2 250" | .pio/build/native/program 60000
+//     valgrind --tool=callgrind .pio/build/native/program 100000 < commands.txt
+
+int main(int argc, char** argv) {
+    const unsigned long passes = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000UL;
+    const unsigned long step_us = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 1000UL;
+
+    native_hal::feed_serial(0, std::string(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>()));
+
+    setup();
+    for (unsigned long i = 0; i < passes; ++i) {
+        loop();
+        native_hal::advance_us(static_cast<std::uint32_t>(step_us));
+    }
+    std::fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,7 @@
+#include "adc_pipeline.hpp"
+
+#if defined(__AVR__) && defined(ADC_FREE_RUNNING)
+ISR(ADC_vect) {
+    adc::on_conversion(ADC);
+}
+#endif
@@ -0,0 +1,24 @@
+#include "boot_profile.hpp"
+
+#if defined(__AVR__) && defined(BOOT_PROFILE)
+#include <avr/io.h>
+
+// The .init sections run in order as one stretch of code from the reset vector, so these are naked and fall through
+// to the next section instead of returning. .init2 has set up the stack and the zero register.
+
+// Timer5 in normal mode at clk/64, the prescaler the core's init() sets again
+extern "C" void boot_profile_start() __attribute__((naked, used, section(".init3")));
+void boot_profile_start() {
+    TCCR5A = 0;
+    TCNT5 = 0;
+    TIFR5 = _BV(TOV5);
+    TCCR5B = _BV(CS51) | _BV(CS50);
+}
+
+// After the constructors (.init6), before main(); .bss is cleared by now, so the count stays
+extern "C" void boot_profile_constructed() __attribute__((naked, used, section(".init7")));
+void boot_profile_constructed() {
+    const std::uint16_t ticks = TCNT5;
+    boot_profile::constructor_ticks = ((TIFR5 & _BV(TOV5)) != 0) ? 0xFFFFU : ticks;
+}
+#endif
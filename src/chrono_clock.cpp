@@ -0,0 +1,25 @@
+#include <Controllino.h>
+#include <chrono>
+
+#if defined(__AVR__)
+#include <avr/io.h>
+
+// avr-libstdcpp's <chrono> leaves now() of std::chrono::high_resolution_clock, which is also its steady_clock, to the
+// platform. Here it counts Timer0 like micros() does, at 4 us resolution for 16 MHz, but over the Arduino core's full
+// 32-bit overflow count, so it runs for 49.7 days (as millis() does) where micros() wraps after 71 minutes.
+
+extern volatile unsigned long timer0_overflow_count;  // wiring.c, incremented by the Timer0 overflow interrupt
+
+std::chrono::high_resolution_clock::time_point std::chrono::high_resolution_clock::now() noexcept {
+    const std::uint8_t sreg = SREG;
+    cli();
+    unsigned long overflows = timer0_overflow_count;
+    const std::uint8_t count = TCNT0;
+    if ((TIFR0 & _BV(TOV0)) != 0 && count < 255) {
+        ++overflows;  // The interrupt is pending
+    }
+    SREG = sreg;
+    const std::uint64_t ticks = (static_cast<std::uint64_t>(overflows) << 8) | count;
+    return time_point(duration(static_cast<rep>(ticks * (64 / clockCyclesPerMicrosecond()))));
+}
+#endif
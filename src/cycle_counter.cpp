@@ -0,0 +1,7 @@
+#include "cycle_counter.hpp"
+
+#if defined(__AVR__) && !defined(CYCLE_COUNTER_DISABLE)
+ISR(TIMER5_OVF_vect) {
+    cycle_counter::overflow_count = cycle_counter::overflow_count + 1U;
+}
+#endif
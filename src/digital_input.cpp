@@ -0,0 +1,21 @@
+#include "actor_digital_input.hpp"
+#include "actor_encoder.hpp"
+
+// Pin-change vectors of din::enable_interrupt(), and of the encoder on port B or K (see actor_encoder.hpp); the INTn
+// pins go through attachInterrupt()
+#if defined(__AVR__) && defined(DIGITAL_INPUT_IRQ)
+ISR(PCINT0_vect) {
+    encoder::on_pin_change<gpio::detail::Port::B>();
+    din::capture_port<gpio::detail::Port::B>();
+}
+
+ISR(PCINT1_vect) {
+    din::capture_port<gpio::detail::Port::E>();
+    din::capture_port<gpio::detail::Port::J>();
+}
+
+ISR(PCINT2_vect) {
+    encoder::on_pin_change<gpio::detail::Port::K>();
+    din::capture_port<gpio::detail::Port::K>();
+}
+#endif
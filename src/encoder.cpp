@@ -0,0 +1,8 @@
+#include "actor_encoder.hpp"
+
+// The encoder's pin-change vector; with DIGITAL_INPUT_IRQ, src/digital_input.cpp defines it and calls the encoder
+#if defined(__AVR__) && defined(QUADRATURE_ENCODER) && !defined(DIGITAL_INPUT_IRQ)
+ISR(ENCODER_PCINT_VECT) {
+    encoder::detail::on_edge();
+}
+#endif
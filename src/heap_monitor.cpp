@@ -0,0 +1,73 @@
+#include "heap_monitor.hpp"
+
+#if defined(__AVR__) && defined(HEAP_MONITOR)
+#include <bits/functexcept.h>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+// Every form the Arduino core's new.cpp defines, so its object is not linked in beside these.
+
+namespace {
+
+void* counted_malloc(std::size_t size) {
+    void* block = std::malloc(size != 0 ? size : 1);
+    if (block == nullptr) {
+        return nullptr;
+    }
+    using namespace heap_monitor::detail;
+    current_bytes += heap_monitor::block_size(block);
+    if (current_bytes > peak_bytes) {
+        peak_bytes = current_bytes;
+    }
+    ++live_blocks;
+    if (allocations != UINT16_MAX) {
+        ++allocations;
+    }
+    if (sealed) {
+        assert(!heap_monitor::SEAL_ASSERTS && "Heap allocation after setup()");
+        if (late_allocations != UINT16_MAX) {
+            ++late_allocations;
+        }
+    }
+    return block;
+}
+
+// As operator new: the new handler gets to free memory before the request fails
+void* allocate(std::size_t size) {
+    for (;;) {
+        void* block = counted_malloc(size);
+        if (block != nullptr) {
+            return block;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            std::__throw_bad_alloc();
+        }
+        handler();
+    }
+}
+
+void release(void* block) {
+    if (block == nullptr) {
+        return;
+    }
+    heap_monitor::detail::current_bytes -= heap_monitor::block_size(block);
+    --heap_monitor::detail::live_blocks;
+    std::free(block);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+#endif
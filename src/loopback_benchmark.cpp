@@ -0,0 +1,239 @@
+#if defined(LOOPBACK_BENCHMARK)
+#include "actor_led.hpp"
+#include "actor_serial_commander.hpp"
+#include "actor_timer.hpp"
+#include "cycle_counter.hpp"
+#include "fmt.hpp"
+#include "output_registry.hpp"
+#include "serial_port.hpp"
+#include <Controllino.h>
+
+// The loopback benchmark firmware: the end-to-end actuation latency as the field sees it, from a command or a timer
+// deadline to the edge on the output terminal, digitalWrite, the dispatch through the network and the output driver
+// included. The output LOOPBACK_OUTPUT_PIN is wired back to ICP5 (PL1, Arduino pin 48), the input capture of Timer5,
+// which the cycle counter runs at clk/1: the edge is timestamped by the hardware in cycles, without interrupt latency.
+// The CONTROLLINO outputs switch 24 V, so the wire needs a divider (e.g. 10k/4.7k) or an optocoupler to 5 V.
+//
+//     pio run -e loopback -t upload && pio device monitor
+//
+// Each round measures both paths on one LED of the commander, driven by a MicrosTimerActor:
+//   1. "start 1" is queued in the receive buffer, and the LED arms a timer of LOOPBACK_INTERVAL_US
+//   2. the timer deadline turns the LED on: deadline to rising edge. The deadline is the timer's, in micros(), mapped
+//      to cycles with an offset taken at boot, to within 4 us
+//   3. "stop 1" is queued, as the receive interrupt would at the end of the line: receipt to falling edge
+// After LOOPBACK_ROUNDS rounds the firmware prints the minimum, average and maximum of each path in microseconds and
+// starts over. The receive buffer needs SERIAL_BUFFERED_OUTPUT; off AVR there is no capture and every round times out.
+
+#ifndef LOOPBACK_OUTPUT_PIN
+#define LOOPBACK_OUTPUT_PIN CONTROLLINO_D0
+#endif
+#ifndef LOOPBACK_INTERVAL_US
+#define LOOPBACK_INTERVAL_US 2000
+#endif
+#ifndef LOOPBACK_ROUNDS
+#define LOOPBACK_ROUNDS 64
+#endif
+
+#if defined(__AVR__) && !defined(SERIAL_BUFFERED_OUTPUT)
+#error "The commands go through the receive buffer of serial_port; build with -D SERIAL_BUFFERED_OUTPUT"
+#endif
+
+namespace {
+
+constexpr std::uint8_t CAPTURE_PIN = 48;              // ICP5
+constexpr std::uint32_t EDGE_TIMEOUT_MS = 100;
+constexpr std::uint32_t SETTLE_MS = 5;                // Between rounds
+
+volatile bool captured = false;
+volatile std::uint32_t captured_at = 0;
+
+MicrosTimerActor<1> timer;
+led::BlinkyLedActor led1(LOOPBACK_OUTPUT_PIN, LOOPBACK_INTERVAL_US);
+led::OutputRegistry<1> outputs(led1);
+serial_cmd::SerialCommandSystem commander(outputs);
+
+std::uint32_t offset = 0;  // cycle_counter::now() - 16 * micros()
+
+// Latencies of a path, in cycles
+struct Path {
+    std::uint32_t min = UINT32_MAX;
+    std::uint32_t max = 0;
+    std::uint32_t sum = 0;
+    std::uint16_t count = 0;
+
+    void add(std::uint32_t cycles) {
+        min = (cycles < min) ? cycles : min;
+        max = (cycles > max) ? cycles : max;
+        sum += cycles;
+        ++count;
+    }
+};
+Path timer_path;
+Path command_path;
+
+enum class Phase : std::uint8_t { SETTLE, TIMER_EDGE, COMMAND_EDGE };
+Phase phase = Phase::SETTLE;
+std::uint32_t phase_start = 0;
+bool expecting = false;
+std::uint32_t expected_from = 0;  // Cycle count the latency is measured from
+std::uint16_t rounds = 0;
+std::uint16_t timeouts = 0;
+
+void write(const char* text) { serial_port::write_line(text, serial_port::Overflow::BLOCK); }
+
+// Cycles of micros() `us`, as offset by calibrate()
+std::uint32_t cycles_at(std::uint32_t us) { return us * cycle_counter::CYCLES_PER_US + offset; }
+
+void calibrate() {
+    noInterrupts();
+    const std::uint32_t us = micros();
+    offset = cycle_counter::now() - us * cycle_counter::CYCLES_PER_US;
+    interrupts();
+}
+
+// Captures the next edge of the given direction
+void expect(bool rising, std::uint32_t from) {
+#if defined(__AVR__)
+    noInterrupts();
+    TCCR5B = rising ? (TCCR5B | _BV(ICES5)) : (TCCR5B & static_cast<std::uint8_t>(~_BV(ICES5)));
+    TIFR5 = _BV(ICF5);  // Changing the edge may set the flag
+    captured = false;
+    TIMSK5 |= _BV(ICIE5);
+    interrupts();
+#else
+    (void)rising;
+    captured = false;
+#endif
+    expected_from = from;
+    expecting = true;
+}
+
+// A command line, into the receive buffer as from the receive interrupt; returns the cycle count of its end
+std::uint32_t receive(const char* line) {
+    noInterrupts();
+    if (serial_port::ENABLED) {
+        for (; *line != '\0'; ++line) {
+            serial_port::on_receive(static_cast<std::uint8_t>(*line));
+        }
+        serial_port::on_receive('\n');
+    }
+    const std::uint32_t at = cycle_counter::now();
+    interrupts();
+    return at;
+}
+
+void print(const char* name, const Path& p) {
+    fmt::Line<80> msg;
+    if (p.count == 0) {
+        fmt::write(msg, name, ": no edges");
+    } else {
+        const unsigned long avg = p.sum / p.count;
+        fmt::write(msg, name, ": min ", static_cast<unsigned long>(p.min / cycle_counter::CYCLES_PER_US), " us, avg ",
+                   avg / cycle_counter::CYCLES_PER_US, " us, max ",
+                   static_cast<unsigned long>(p.max / cycle_counter::CYCLES_PER_US), " us (", p.count, " edges)");
+    }
+    write(msg.c_str());
+}
+
+void report() {
+    print("Timer deadline to edge", timer_path);
+    print("Command receipt to edge", command_path);
+    if (timeouts > 0) {
+        fmt::Line<80> msg;
+        fmt::write(msg, timeouts, " rounds without an edge: is the output wired to pin 48 (ICP5)?");
+        write(msg.c_str());
+    }
+    timer_path = Path{};
+    command_path = Path{};
+    rounds = 0;
+    timeouts = 0;
+}
+
+void next_phase(Phase next) {
+    phase = next;
+    phase_start = millis();
+}
+
+void end_round() {
+    expecting = false;
+    if (++rounds == LOOPBACK_ROUNDS) {
+        report();
+    }
+    next_phase(Phase::SETTLE);
+}
+
+void step() {
+    if (phase != Phase::SETTLE && millis() - phase_start > EDGE_TIMEOUT_MS) {
+        ++timeouts;
+        receive("stop 1");
+        end_round();
+        return;
+    }
+    switch (phase) {
+        case Phase::SETTLE:
+            if (millis() - phase_start >= SETTLE_MS) {
+                receive("start 1");
+                next_phase(Phase::TIMER_EDGE);
+            }
+            break;
+        case Phase::TIMER_EDGE:
+            if (expecting && captured) {
+                timer_path.add(captured_at - expected_from);
+                expect(false, receive("stop 1"));
+                next_phase(Phase::COMMAND_EDGE);
+            }
+            break;
+        case Phase::COMMAND_EDGE:
+            if (expecting && captured) {
+                command_path.add(captured_at - expected_from);
+                end_round();
+            }
+            break;
+    }
+}
+
+} // namespace
+
+#if defined(__AVR__)
+// The edge, timestamped by Timer5 in ICR5; extended to 32 bits like cycle_counter::now()
+ISR(TIMER5_CAPT_vect) {
+    const std::uint16_t low = ICR5;
+    std::uint16_t high = cycle_counter::overflow_count;
+    if ((TIFR5 & _BV(TOV5)) && low < 0x8000U) {
+        ++high;
+    }
+    captured_at = (static_cast<std::uint32_t>(high) << 16) | low;
+    captured = true;
+    TIMSK5 &= static_cast<std::uint8_t>(~_BV(ICIE5));  // One capture per expect()
+}
+#endif
+
+void setup() {
+    cycle_counter::start();
+    calibrate();
+    pinMode(CAPTURE_PIN, INPUT);
+    commander.init();
+    led1.init();
+    led1.arm_timer_request_out >> timer.arm_timer_request_in;
+    led1.disarm_timer_request_out >> timer.disarm_timer_request_in;
+
+    fmt::Line<80> msg;
+    fmt::write(msg, "Loopback latency: pin ", static_cast<unsigned>(LOOPBACK_OUTPUT_PIN), " to pin 48, ",
+               static_cast<unsigned>(LOOPBACK_ROUNDS), " rounds of ", static_cast<unsigned long>(LOOPBACK_INTERVAL_US),
+               " us");
+    write(msg.c_str());
+    next_phase(Phase::SETTLE);
+}
+
+void loop() {
+    step();
+    commander.update();
+    // The deadline about to expire is the LED's; its edge is measured from it
+    std::uint32_t deadline = 0;
+    if (phase == Phase::TIMER_EDGE && !expecting && timer.next_deadline(deadline) &&
+        static_cast<std::int32_t>(MicrosClock::now() - deadline) >= 0) {
+        expect(true, cycles_at(deadline));
+    }
+    timer.update();
+}
+#endif
@@ -1,19 +1,198 @@
 #include "actor_timer.hpp"
+#include "actor_alarm_manager.hpp"
+#include "actor_boot_script.hpp"
+#include "actor_config_store.hpp"
+#include "actor_encoder.hpp"
+#include "actor_event_log.hpp"
+#include "actor_http.hpp"
+#include "actor_integrity.hpp"
 #include "actor_led.hpp"
+#include "actor_modbus.hpp"
+#include "actor_modbus_tcp.hpp"
+#include "actor_mqtt_sn.hpp"
+#include "actor_pulse_counter.hpp"
+#include "actor_recipe.hpp"
 #include "actor_serial_commander.hpp"
+#include "actor_stepper.hpp"
+#include "actor_udp.hpp"
+#include "actor_wall_clock.hpp"
+#include "actor_watch.hpp"
+#include "boot_profile.hpp"
+#include "heap_monitor.hpp"
+#include "input_record.hpp"
+#include "logic_vm.hpp"
+#include "pool_allocator.hpp"
+#include "ramen_footprint.hpp"
+#include "scan_clock.hpp"
+#include "scan_monitor.hpp"
+#include "step_watchdog.hpp"
+#include "warm_restart.hpp"
+#include "idle_sleep.hpp"
 #include <Controllino.h>
 
-TimerActor timer;
+scan_clock::ScanClockActor scan_time;  // The time of each loop() pass (opt-in, see platformio.ini), else millis()
+constexpr std::uint8_t TIMER_SLOTS = MAX_CONCURRENT_TIMEOUTS + serial_cmd::SerialCommandSystem::TIMERS + watch::TIMERS;
+TimerActor<TIMER_SLOTS, DefaultTimerQueue, scan_clock::Clock> timer;  // Outputs, then commander and watches
 led::BlinkyLedActor led1(CONTROLLINO_D0, 500);  // 500ms interval
 led::BlinkyLedActor led2(CONTROLLINO_D1, 1000); // 1s interval
 led::BlinkyLedActor led3(CONTROLLINO_D2, 500);
 
-serial_cmd::SerialCommandSystem commander(led1, led2, led3);
+led::OutputRegistry<3> outputs(led1, led2, led3);  // Ids 1..3 of the serial commands
+
+serial_cmd::SerialCommandSystem commander(outputs);
+config_store::ConfigStoreActor<3> config(outputs);  // Intervals and run states in EEPROM (opt-in, see platformio.ini)
+boot_script::BootScriptActor boot;                  // Commands run at boot, from EEPROM (opt-in, see platformio.ini)
+wall_clock::WallClockActor<> wall_time;             // The RTC's time, read once a minute (opt-in, see platformio.ini)
+warm_restart::WarmRestartActor<3> warm(outputs);    // Output states kept across watchdog resets (opt-in, as well)
+event_log::EventLogActor<> events;                  // Output changes with RTC time, in EEPROM (opt-in, as well)
+recipe::OutputRecipeActor<3> recipe_outputs(outputs);  // Intervals and run states switched as one, by the recipes
+recipe::RecipeActor<recipe::OutputRecipe<3>> recipes;  // of the binary protocol and EEPROM (opt-in, as well)
+modbus::ModbusSlaveActor modbus_slave(outputs, 1);  // Slave address 1 on the RS485 port (opt-in, see platformio.ini)
+net::UdpEndpointActor udp_endpoint(outputs);        // The binary protocol over Ethernet (opt-in, see platformio.ini)
+modbus::ModbusTcpActor<> modbus_tcp(modbus_slave);  // The slave's data model on TCP port 502 (opt-in, as well)
+mqtt_sn::MqttSnActor<3> mqtt(outputs);              // Output states pushed to an MQTT-SN gateway (opt-in, as well)
+http::StatusPageActor status_page(outputs);         // The outputs in a browser (opt-in, as well)
+pulse_counter::PulseCounterActor pulses;            // Pulses on pin 47, counted by Timer5 (opt-in, as well)
+encoder::EncoderActor axis(100);                    // A quadrature encoder on A8/A9, velocity over 100 ms (opt-in)
+stepper::StepperActor drive;                        // Step pulses on D6, direction on D7, from Timer3 (opt-in, as well)
+#if defined(SERIAL_HMI_SESSION)
+serial_cmd::UartSession hmi_session(Serial1);       // Commands of an HMI on Serial1, beside the programming port
+#endif
+#if defined(ALARM_MANAGER)
+alarms::AlarmManager<16> alarm_table;               // The alarms for the HMIs, ids 0..63 (see actor_alarm_manager.hpp)
+integrity::IntegrityActor self_test;                // Flash CRC and RAM march test in the idle time, alarms 62 and 63
+#endif
+#if defined(LOGIC_VM)
+process_image::ProcessImage logic_image;            // The I/O of the downloadable logic (see logic_vm.hpp)
+logic_vm::LogicVmActor<> logic(logic_image);
+constexpr std::uint8_t LOGIC_INPUTS[] = {CONTROLLINO_IN0, CONTROLLINO_IN1};
+constexpr std::uint8_t LOGIC_OUTPUTS[] = {CONTROLLINO_D3, CONTROLLINO_D4};
+// Until a program is downloaded: D3 on 500 ms after IN0 rises, while IN1 is off
+constexpr logic_vm::Instruction LOGIC_DEFAULT[] PROGMEM = {
+    {logic_vm::LDK, 0, 0xF4, 0x01},  // Word 0, the preset of timer 0: 500
+    {logic_vm::LD, 0, CONTROLLINO_IN0, 0},
+    {logic_vm::LD, 1, CONTROLLINO_IN1, 0},
+    {logic_vm::ANDN, 2, 0, 1},
+    {logic_vm::TON, 3, 2, 0},
+    {logic_vm::ST, 3, CONTROLLINO_D3, 0},
+    {logic_vm::END, 0, 0, 0}};
+#endif
+#if defined(LIVE_WATCH)
+// The variables of the WATCH requests, by index in this order (see actor_watch.hpp)
+constexpr auto WATCHES PROGMEM = ramen::pgm_array<watch::Entry>({
+    WATCH(led1.blink_interval_ms),
+    WATCH(led2.blink_interval_ms),
+    WATCH(led3.blink_interval_ms),
+    WATCH(timer.last_error),
+    WATCH(serial_port::dropped_messages),
+});
+watch::WatchActor watches(WATCHES);
+#endif
+#if defined(POOL_OPERATOR_NEW)
+memory_pool::Pool<16, 16> small_blocks;             // Blocks of operator new, smallest first (see pool_allocator.hpp)
+memory_pool::Pool<64, 4> large_blocks;
+#endif
+std::uint8_t ETHERNET_MAC[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};  // Locally administered
+constexpr std::uint8_t ETHERNET_IP[4] = {192, 168, 1, 177};
+constexpr std::uint8_t MQTT_SN_GATEWAY[4] = {192, 168, 1, 10};
+
+// Statically allocated actor network must leave most of the 8 KB of SRAM to the stack and the Arduino core.
+// Sizes are target-specific (pointer width, alignment), so the budget is only checked for the AVR build.
+#if defined(__AVR__)
+RAMEN_RAM_BUDGET(2048, timer, led1, led2, led3, commander);
+#endif
+RAMEN_FOOTPRINT_REPORT(timer);
+RAMEN_FOOTPRINT_REPORT(led1);
+RAMEN_FOOTPRINT_REPORT(commander);
+
+// A stage of loop(), timed by the scan monitor and run as a step of its actor within the actor's budget (both opt-in)
+template <class F>
+void step(scan_monitor::Stage stage, const void* actor, F&& f) {
+    scan_monitor::stage(stage, [&] { step_watchdog::run(actor, f); });
+}
 
 void setup() {
+    // Opt-in (see platformio.ini): the boot phases are timed from reset for the 'boot' command
+    boot_profile::mark(boot_profile::SETUP);
+
+#if defined(POOL_OPERATOR_NEW)
+    // Before anything can call operator new
+    memory_pool::pools.add(small_blocks);
+    memory_pool::pools.add(large_blocks);
+#endif
+
+    // Paint free RAM first so that the 'stats' command can report the stack high-water mark
+    stack_monitor::paint();
+
+    // Opt-in (see platformio.ini): after a watchdog or software reset the outputs come back at the level they had,
+    // taken from .noinit RAM before the rest of setup() runs
+    warm.begin();
+
+    // The LED pins are set up here, not by the constructors, which run before the Arduino core is initialized
+    led1.init(warm.level(0));
+    led2.init(warm.level(1));
+    led3.init(warm.level(2));
+
+    // The dispatch profiler, the port trace and the benchmarks (opt-in, see platformio.ini) need the cycle counter
+    if (port_profiler::ENABLED || port_trace::ENABLED || step_watchdog::ENABLED || fsm_benchmark::ENABLED ||
+        hash_benchmark::ENABLED) {
+        cycle_counter::start();
+    }
+
+    // Opt-in (see platformio.ini): expire timers from the Timer4 output compare instead of the next millis() tick
+    if (timer_compare::ENABLED) {
+        timer.use_hardware_compare();
+    }
+
+    // Opt-in (see platformio.ini): the plant's Modbus master polls the outputs over RS485
+    if (modbus_rtu::ENABLED) {
+        modbus_slave.begin(19200, modbus_rtu::Parity::EVEN);
+    }
+
     // Initialize serial commander
+    commander.attach_timer_latency(timer.latency_report());
+    commander.attach_timer(timer);
+    commander.attach_boot_script(boot);
     commander.init();
-    
+    boot_profile::mark(boot_profile::COMMANDER_READY);
+#if defined(SERIAL_HMI_SESSION)
+    Serial1.begin(9600);
+    commander.attach_session(hmi_session);
+#endif
+
+    // Opt-in (see platformio.ini): remote monitoring through UDP port 5000, served like the serial binary protocol
+    if (net::ENABLED && udp_endpoint.begin(ETHERNET_MAC, ETHERNET_IP)) {
+        commander.attach_binary_endpoint(udp_endpoint.binary);
+    }
+
+    // Opt-in (see platformio.ini): the state of each output is published to topic ids 1..3 of the gateway as it changes
+    if (mqtt_sn::ENABLED) {
+        mqtt.publish_outputs(1, mqtt_sn::Qos::AT_LEAST_ONCE);
+        if (net::ENABLED) {
+            mqtt.begin(MQTT_SN_GATEWAY, "controllino");
+        } else {
+            mqtt.begin(ETHERNET_MAC, ETHERNET_IP, MQTT_SN_GATEWAY, "controllino");
+        }
+    }
+
+    // Opt-in (see platformio.ini): http://192.168.1.177/ and /status.json, on the interface started above if any
+    if (http::ENABLED) {
+        if (net::ENABLED || mqtt_sn::ENABLED) {
+            status_page.begin();
+        } else {
+            status_page.begin(ETHERNET_MAC, ETHERNET_IP);
+        }
+    }
+
+    // Opt-in (see platformio.ini): the SCADA polls the registers of the RS485 slave over Modbus TCP as well
+    if (modbus::TCP_ENABLED) {
+        if (net::ENABLED || mqtt_sn::ENABLED || http::ENABLED) {
+            modbus_tcp.begin();
+        } else {
+            modbus_tcp.begin(ETHERNET_MAC, ETHERNET_IP);
+        }
+    }
+
     // Connect ArmTimerEvt requests:
     led1.arm_timer_request_out >> timer.arm_timer_request_in;
     led2.arm_timer_request_out >> timer.arm_timer_request_in;
@@ -24,17 +203,180 @@ void setup() {
     led2.disarm_timer_request_out >> timer.disarm_timer_request_in;
     led3.disarm_timer_request_out >> timer.disarm_timer_request_in;
 
+    // The 'stats' command counts the timer requests of each LED, where a runaway event loop would show first
+    commander.watch(F("led1 timer arms"), led1.arm_timer_request_out.sent_counter());
+    commander.watch(F("led2 timer arms"), led2.arm_timer_request_out.sent_counter());
+    commander.watch(F("led3 timer arms"), led3.arm_timer_request_out.sent_counter());
+
+    // Opt-in (see platformio.ini): LEDs on timer compare pins blink in hardware, the others fall back to TimerActor
+    led1.use_hardware_blink();
+    led2.use_hardware_blink();
+    led3.use_hardware_blink();
+
+    // LEDs blinking at the same interval share one phase, so their timers expire together
+    timer.set_coalescing(0, true);
+
     // Start all LEDs initially (optional - can be controlled via serial)
     led1.start();
     led2.start();
     led3.start();
+
+    // Opt-in (see platformio.ini): the configuration saved before the last reset replaces these defaults
+    if (config_store::ENABLED) {
+        config.begin();
+    }
+
+    // Opt-in (see platformio.ini): after a warm restart, the state before the reset replaces both
+    warm.resume();
+
+    // Opt-in (see platformio.ini): the outputs' settings as they are now form the first recipe; the next ones are
+    // staged, saved and loaded over the binary protocol and switched in between two scans
+    if (recipe::ENABLED) {
+        recipes.switched_out >> recipe_outputs.recipe_in;
+        recipes.begin(recipe::capture<3>(outputs));
+        commander.attach_recipes(recipes);
+        udp_endpoint.binary.recipe_out >> recipes.request_in;
+    }
+
+    // Opt-in (see platformio.ini): the date and time from the RTC, kept between its reads by the scan clock
+    if (wall_clock::ENABLED) {
+        wall_time.begin();
+        events.seconds_in >> wall_time.seconds_out;
+    }
+
+    // Opt-in (see platformio.ini): a record of the boot and of every output change from here on, read over the binary
+    // protocol
+    if (event_log::ENABLED) {
+        events.begin();
+        events.watch(outputs);
+        events.log(event_log::BOOT, 0, step_watchdog::reset_cause);  // MCUSR, saved before .init3 cleared it
+        commander.attach_event_log(events);
+        udp_endpoint.binary.log_read_out >> events.read_in;
+    }
+
+#if defined(ALARM_MANAGER)
+    // Opt-in (see platformio.ini): the alarm table, followed and acknowledged by the HMIs over the binary protocol and
+    // Modbus
+    commander.attach_alarms(alarm_table);
+    udp_endpoint.binary.alarm_read_out >> alarm_table.read_in;
+    udp_endpoint.binary.alarm_ack_out >> alarm_table.ack_in;
+    modbus_slave.use_alarms(alarm_table);
+
+    // Opt-in (see platformio.ini): the flash and RAM self-tests, their faults as alarms and their failed passes in
+    // 'stats'
+    if (integrity::ENABLED) {
+        self_test.event_out >> alarm_table.event_in;
+        commander.watch(F("Flash CRC failures"), self_test.flash_failures());
+        commander.watch(F("RAM test failures"), self_test.ram_failures());
+    }
+#endif
+
+#if defined(LIVE_WATCH)
+    // Opt-in (see platformio.ini): the variables of WATCHES, read, written and sampled over the binary protocol
+    commander.attach_watch(watches);
+    udp_endpoint.binary.watch_out >> watches.request_in;
+    watches.arm_timer_request_out >> timer.arm_timer_request_in;
+    watches.disarm_timer_request_out >> timer.disarm_timer_request_in;
+#endif
+
+#if defined(LOGIC_VM)
+    // Opt-in (see platformio.ini): the logic program in EEPROM, or the default, on its own pins; new ones arrive over
+    // the binary protocol
+    for (const std::uint8_t pin : LOGIC_INPUTS) {
+        logic_image.add_input(pin);
+    }
+    for (const std::uint8_t pin : LOGIC_OUTPUTS) {
+        logic_image.add_output(pin);
+    }
+    logic.begin(LOGIC_DEFAULT);
+    commander.attach_logic_vm(logic);
+    udp_endpoint.binary.program_out >> logic.program_in;
+#endif
+
+    // Opt-in (see platformio.ini): a meter's pulses counted by Timer5 from here on, sampled every pass
+    pulses.begin();
+
+    // Opt-in (see platformio.ini): quadrature edges counted by the pin-change interrupt from here on
+    axis.begin();
+
+    // Opt-in (see platformio.ini): the step and direction pins, driven once moves arrive on drive.move_in
+    drive.begin();
+
+    // Opt-in (see platformio.ini): the commands saved with 'script' run last, without waiting for a host, unless a warm
+    // restart has resumed the state they led to
+    if (boot_script::ENABLED && !warm.warm()) {
+        boot.begin();
+    }
+    boot_profile::mark(boot_profile::LINKED);
+
+    // Opt-in (see platformio.ini): from here on the watchdog resets the board unless the commander and the timer keep
+    // completing their updates
+    step_watchdog::add_critical(&commander);
+    step_watchdog::add_critical(&timer);
+    step_watchdog::start();
+
+    // Opt-in (see platformio.ini): the serial input is recorded for the 'record' command, or replayed, from here on
+    input_record::begin();
+
+    // Opt-in (see platformio.ini): operator new counts, and with HEAP_MONITOR_SEAL forbids, allocations from here on
+    heap_monitor::seal();
 }
 
 void loop() {
-    // Process serial commands
-    commander.update();
+    // Opt-in (see platformio.ini): each stage is timed for the 'scan' command and held to a budget by the step
+    // watchdog, until the idle hook takes over
+    scan_monitor::begin_scan();
+
+    // Opt-in (see platformio.ini): timers and traces take the time of the pass, read here once
+    scan_time.sample();
+
+    // Opt-in (see platformio.ini): the recorded input due by now takes the place of the UART's
+    input_record::replay(&serial_port::inject);
+
+    // Opt-in (see platformio.ini): a recipe switched by the last pass's requests applies before anything else runs
+    step(scan_monitor::CONFIG, &recipes, [] { recipes.update(); });
+
+    // Modbus replies first: the master's poll cycle leaves a few milliseconds for the whole turnaround
+    step(scan_monitor::MODBUS, &modbus_slave, [] { modbus_slave.update(); });
+
+    // Process serial commands, and those arriving over the network
+    step(scan_monitor::COMMANDER, &commander, [] { commander.update(); });
+    step(scan_monitor::NETWORK, &udp_endpoint, [] { udp_endpoint.update(); });
+    step(scan_monitor::NETWORK, &mqtt, [] { mqtt.update(); });
+    step(scan_monitor::NETWORK, &status_page, [] { status_page.update(); });
+    step(scan_monitor::NETWORK, &modbus_tcp, [] { modbus_tcp.update(); });
+
+    // Save configuration changes once they settle, a saved boot script and the event log, a byte per pass; the wall
+    // clock reads the RTC once a minute
+    step(scan_monitor::CONFIG, &config, [] { config.update(); });
+    step(scan_monitor::SCRIPT, &boot, [] { boot.update(); });
+    step(scan_monitor::CONFIG, &wall_time, [] { wall_time.update(); });
+    step(scan_monitor::CONFIG, &events, [] { events.update(); });
+#if defined(LOGIC_VM)
+    step(scan_monitor::LOGIC, &logic, [] {
+        logic_image.read_inputs();
+        logic.scan();
+        logic_image.commit_outputs();
+        logic.update();
+    });
+#endif
     
     // Poll actors needing periodic checks (like TimerActor).
     // Event-driven actors (e.g., BlinkyLed) are updated by their event sources.
-    timer.update();
+    step(scan_monitor::TIMERS, &timer, [] { timer.update(); });
+    step(scan_monitor::TIMERS, &pulses, [] { pulses.update(); });
+    step(scan_monitor::TIMERS, &axis, [] { axis.update(); });
+    step(scan_monitor::TIMERS, &drive, [] { drive.update(); });
+
+    // Opt-in (see platformio.ini): the state at the end of the pass is what a warm restart resumes
+    step(scan_monitor::CONFIG, &warm, [] { warm.update(); });
+    scan_monitor::end_busy();
+#if defined(ALARM_MANAGER)
+    // Opt-in (see platformio.ini): a slice of the flash and RAM self-tests, in time the pass leaves over
+    self_test.update();
+#endif
+    step_watchdog::feed();
+
+    // Nothing left to do until the next interrupt (millis() tick or serial input)
+    idle_sleep::sleep(timer);
 }
@@ -0,0 +1,408 @@
+#if defined(MICRO_BENCHMARK)
+#include "actor_serial_commander.hpp"
+#include "actor_timer.hpp"
+#include "alarm_bank.hpp"
+#include "boolean_network.hpp"
+#include "coroutine.hpp"
+#include "cycle_counter.hpp"
+#include "fast_pin.hpp"
+#include "fmt.hpp"
+#include "fsm_benchmark.hpp"
+#include "function_blocks.hpp"
+#include "logic_vm.hpp"
+#include "pid_bank.hpp"
+#include "ramen.hpp"
+#include "ramen_dataflow.hpp"
+#include "ramen_latch.hpp"
+#include "scan_clock.hpp"
+#include <Controllino.h>
+
+// The micro-benchmark firmware, the yardstick for performance changes: instead of the application of main.cpp,
+// setup() measures the building blocks once and prints a table of cycle counts on the programming port.
+//
+//     pio run -e benchmark -t upload && pio device monitor
+//
+// Every figure is the average over REPEAT runs of the operation, less the cost of the timing loop around it. The
+// objects measured are hidden from the optimizer (opaque() below), so their calls are not folded into the loop as a
+// constant or devirtualized; the figures are what the operations cost where the firmware uses them.
+
+namespace {
+
+constexpr std::uint8_t REPEAT = 64;
+constexpr std::uint8_t BENCH_PIN = CONTROLLINO_D0;
+
+volatile std::uint8_t sink;
+
+// The same object, of which the compiler no longer knows anything
+template <class T>
+T& opaque(T& object) {
+    T* p = &object;
+    __asm__ __volatile__("" : "+r"(p));
+    return *p;
+}
+
+template <class Body>
+std::uint32_t total_cycles(Body&& body) {
+    const std::uint32_t start = cycle_counter::now();
+    for (std::uint8_t i = 0; i < REPEAT; ++i) {
+        body(i);
+    }
+    return cycle_counter::now() - start;
+}
+
+std::uint32_t loop_overhead = 0;
+
+// Average cycles of body(i), which should leave its result in `sink`
+template <class Body>
+std::uint32_t cycles_of(Body&& body) {
+    const std::uint32_t cycles = total_cycles(body);
+    return (cycles > loop_overhead) ? (cycles - loop_overhead) / REPEAT : 0;
+}
+
+void row(const char* name, std::uint32_t cycles) {
+    fmt::Line<64> msg;
+    fmt::write(msg, "  ", fmt::left(name, 36), ' ', fmt::right(static_cast<unsigned long>(cycles), 7));
+    Serial.println(msg.c_str());
+}
+
+void bench_function() {
+    ramen::Function<void(std::uint8_t), ramen::default_behavior_footprint> f = [](std::uint8_t v) { sink = v; };
+    row("Function call", cycles_of([&](std::uint8_t i) { opaque(f)(i); }));
+}
+
+struct Subscriber {
+    ramen::Pushable<std::uint8_t> in = [](std::uint8_t v) { sink = v; };
+};
+
+template <std::uint8_t N>
+void bench_fan_out(const char* name) {
+    Subscriber subscribers[N];
+    ramen::Pusher<std::uint8_t> out;
+    for (Subscriber& s : subscribers) {
+        out >> s.in;
+    }
+    row(name, cycles_of([&](std::uint8_t i) { opaque(out)(i); }));
+}
+
+// Linking is timed one operator>> at a time, as the cost grows with the subscribers already linked
+void bench_link() {
+    constexpr std::uint8_t LINKS = 16;
+    Subscriber subscribers[LINKS];
+    ramen::Pusher<std::uint8_t> out;
+    const std::uint32_t empty = total_cycles([](std::uint8_t) {}) / REPEAT;
+    std::uint32_t cycles = 0;
+    for (Subscriber& s : subscribers) {
+        const std::uint32_t start = cycle_counter::now();
+        opaque(out) >> opaque(s.in);
+        cycles += cycle_counter::now() - start;
+    }
+    const std::uint32_t per_link = cycles / LINKS;
+    row("Event >> Behavior (avg of 16 links)", (per_link > empty) ? per_link - empty : 0);
+}
+
+// The clock of the timers, moved by hand, so that update() finds exactly the expiries it is meant to
+struct BenchClock {
+    using duration = std::chrono::milliseconds;
+    static constexpr std::uint32_t IDLE_SLEEP_GUARD = 0;
+    static inline std::uint32_t current = 0;
+    static std::uint32_t now() { return current; }
+    static constexpr std::uint32_t ticks(duration interval) { return static_cast<std::uint32_t>(interval.count()); }
+};
+
+// update() with no timer due, then with all N due at once; noinline, so each pool is on the stack only while measured
+template <std::uint8_t N>
+__attribute__((noinline)) void bench_timers(const char* idle_name, const char* expiry_name) {
+    constexpr std::uint32_t PERIOD = 1000;
+    TimerActor<N, DefaultTimerQueue, BenchClock> timers;
+    ramen::Pusher<const BaseEvent&> expired;
+    ramen::Pushable<const BaseEvent&> on_expired = [](const BaseEvent& e) { sink = e.pool_id; };
+    expired >> on_expired;
+
+    BenchClock::current = 0;
+    for (std::uint8_t i = 0; i < N; ++i) {
+        timers.arm(ArmTimerEvt(PERIOD, &expired, true));
+    }
+    const std::uint32_t idle = cycles_of([&](std::uint8_t) { opaque(timers).update(); });
+    row(idle_name, idle);
+
+    // Periodic timers: every round expires all N and reschedules them one period on
+    std::uint32_t cycles = 0;
+    constexpr std::uint8_t ROUNDS = 4;
+    for (std::uint8_t round = 1; round <= ROUNDS; ++round) {
+        BenchClock::current = round * PERIOD;
+        const std::uint32_t start = cycle_counter::now();
+        opaque(timers).update();
+        cycles += cycle_counter::now() - start;
+    }
+    cycles /= ROUNDS;
+    row(expiry_name, (cycles > idle) ? (cycles - idle) / N : 0);
+}
+
+// Lines of each kind of argument the parser takes, and one it rejects; the outputs of the parser are not linked
+void bench_parse() {
+    static const char* const LINES[] = {"help",  "status",   "profile reset",  "start 1",
+                                        "stop *", "stop 1-3", "interval 2 250", "bogus",
+                                        "start 1; stop 2; stop 3"};
+    serial_cmd::CommandParserActor parser;
+    for (const char* line : LINES) {
+        const serial_cmd::CommandLineEvent evt{reinterpret_cast<const std::uint8_t*>(line), std::strlen(line)};
+        fmt::Line<40> name;
+        fmt::write(name, "parse \"", line, '"');
+        row(name.c_str(), cycles_of([&](std::uint8_t) { opaque(parser).line_in(evt); }));
+    }
+}
+
+// One update() of banks of N blocks, per block: idle, then with every timer running and every counter counting
+template <std::uint16_t N>
+__attribute__((noinline)) void bench_function_blocks(const char* timer_idle, const char* timer_busy,
+                                                     const char* counters, const char* edges) {
+    fb::TimerBank<N> timers;
+    for (std::uint16_t i = 0; i < N; ++i) {
+        timers.configure(i, static_cast<typename fb::TimerBank<N>::Type>(i % 3U), 60000);
+    }
+    row(timer_idle, cycles_of([&](std::uint8_t) { opaque(timers).update(1); }) / N);
+    for (std::uint16_t i = 0; i < N; ++i) {
+        timers.set_in(i, true);
+    }
+    timers.update(1);  // The edges start the timers
+    row(timer_busy, cycles_of([&](std::uint8_t) { opaque(timers).update(1); }) / N);
+
+    fb::CounterBank<N> counting;
+    row(counters, cycles_of([&](std::uint8_t i) {
+            counting.in_bits().fill((i & 1U) ? 0xFF : 0x00);  // Every other update, every counter sees a rising edge
+            opaque(counting).update();
+        }) / N);
+
+    fb::EdgeBank<N> detectors;
+    row(edges, cycles_of([&](std::uint8_t i) {
+            detectors.in_bits().fill(static_cast<std::uint8_t>(i));
+            opaque(detectors).update();
+        }) / N);
+}
+
+// 64 permissives of 4 terms, the n-th of each byte on the n-th pins of ports A, C, K and L, per signal: evaluated a
+// byte at a time by a boolean network, and a pin at a time from the process image
+constexpr std::uint8_t PERMISSIVES = 64;
+constexpr std::uint8_t pin_of(std::uint8_t port_first, bool descending, std::uint8_t bit) {
+    return static_cast<std::uint8_t>(descending ? port_first - bit : port_first + bit);
+}
+constexpr auto PERMISSIVE_RULES = [] {
+    std::array<boolnet::Rule, PERMISSIVES> rules{};
+    for (std::uint8_t i = 0; i < PERMISSIVES; ++i) {
+        const std::uint8_t bit = i % 8U;
+        rules[i] = boolnet::all(boolnet::internal(i), boolnet::input(pin_of(22, false, bit)),  // Port A
+                                boolnet::input(pin_of(37, true, bit)),                         // Port C
+                                !boolnet::input(pin_of(62, false, bit)),                       // Port K
+                                boolnet::input(pin_of(49, true, bit)));                        // Port L
+    }
+    return rules;
+}();
+constexpr auto PERMISSIVE_NET PROGMEM = boolnet::compile<PERMISSIVES, 48>(PERMISSIVE_RULES);
+static_assert(PERMISSIVE_NET.error == boolnet::Error::NONE, "See boolnet::Error");
+
+__attribute__((noinline)) void bench_boolean_network() {
+    process_image::ProcessImage image;
+    boolnet::Network<PERMISSIVES> net(image);
+    row("boolnet::Network, 64 permissives, per signal",
+        cycles_of([&](std::uint8_t) { opaque(net).evaluate(PERMISSIVE_NET); }) / PERMISSIVES);
+    std::array<bool, PERMISSIVES> permits{};
+    row("ProcessImage::input() chain, per signal", cycles_of([&](std::uint8_t) {
+            const process_image::ProcessImage& in = opaque(image);
+            for (std::uint8_t i = 0; i < PERMISSIVES; ++i) {
+                const std::uint8_t bit = i % 8U;
+                permits[i] = in.input(pin_of(22, false, bit)) & in.input(pin_of(37, true, bit)) &  // Every term
+                             !in.input(pin_of(62, false, bit)) & in.input(pin_of(49, true, bit));
+            }
+        }) / PERMISSIVES);
+    sink = permits[0];
+}
+
+// A scan of the logic VM over 64 bit instructions, per instruction: the dispatch and the operation, with the timing of
+// the scan spread over them
+constexpr std::uint8_t VM_OPS = 64;
+constexpr auto VM_PROGRAM = [] {
+    std::array<logic_vm::Instruction, VM_OPS + 1U> code{};
+    for (std::uint8_t i = 0; i < VM_OPS; ++i) {
+        const std::uint8_t op = (i % 3U == 0) ? logic_vm::AND : ((i % 3U == 1) ? logic_vm::OR : logic_vm::ANDN);
+        code[i] = {op, static_cast<std::uint8_t>(i % 32U), static_cast<std::uint8_t>((i + 7U) % 32U), i};
+    }
+    code[VM_OPS] = {logic_vm::END, 0, 0, 0};
+    return code;
+}();
+constexpr std::array<logic_vm::Instruction, VM_OPS + 1U> VM_PROGRAM_P PROGMEM = VM_PROGRAM;
+
+__attribute__((noinline)) void bench_logic_vm() {
+    process_image::ProcessImage image;
+    logic_vm::LogicVmActor<VM_OPS + 1U> vm(image);
+    vm.load_P(VM_PROGRAM_P.data(), VM_PROGRAM_P.size());
+    row("LogicVmActor::scan, per instruction", cycles_of([&](std::uint8_t) { opaque(vm).scan(); }) / (VM_OPS + 1U));
+}
+
+// A coroutine resumed by a port and returning at its next wait, per value
+struct Counting : coro::Coroutine<Counting> {
+    coro::Await<std::uint8_t, Counting> value_in{*this};
+    std::uint8_t total = 0;
+
+    void run() {
+        CORO_BEGIN();
+        for (;;) {
+            CORO_AWAIT_EVENT(value_in);
+            total = static_cast<std::uint8_t>(total + value_in.value());
+        }
+        CORO_END();
+    }
+};
+
+__attribute__((noinline)) void bench_coroutine() {
+    Counting counting;
+    counting.start();
+    row("Await::in, resume to the next wait", cycles_of([&](std::uint8_t i) { opaque(counting).value_in.in(i); }));
+    sink = counting.total;
+}
+
+// A 32-bit value read tear-free by the main loop: with interrupts held off, and from a SeqLatch
+volatile std::uint32_t shared_value = 0;
+ramen::SeqLatch<std::uint32_t> shared_latch;
+
+__attribute__((noinline)) void bench_latch() {
+    row("uint32_t read, interrupts off", cycles_of([](std::uint8_t) {
+#if defined(__AVR__)
+            const std::uint8_t sreg = SREG;
+            cli();
+            sink = static_cast<std::uint8_t>(shared_value);
+            SREG = sreg;
+#else
+            sink = static_cast<std::uint8_t>(shared_value);
+#endif
+        }));
+    row("SeqLatch<uint32_t>::write", cycles_of([](std::uint8_t i) { shared_latch.write(i); }));
+    row("SeqLatch<uint32_t>::read", cycles_of([](std::uint8_t) {
+            sink = static_cast<std::uint8_t>(shared_latch.read());
+        }));
+}
+
+// The time of a pass: from millis(), with interrupts held off, and as the scan clock keeps it for the pass
+__attribute__((noinline)) void bench_scan_clock() {
+    row("millis()", cycles_of([](std::uint8_t) { sink = static_cast<std::uint8_t>(millis()); }));
+    row("scan_clock sample, read", cycles_of([](std::uint8_t) {
+            sink = static_cast<std::uint8_t>(opaque(scan_clock::detail::sampled_ms));
+        }));
+}
+
+// Eight PID loops in one update, per loop, with errors that keep the outputs off their limits
+__attribute__((noinline)) void bench_pid_bank() {
+    pid::PidBank<8> loops;
+    for (std::uint8_t i = 0; i < 8; ++i) {
+        loops.configure(i, pid::gains(1.5, 2.0, 0.05, 0.010), -1000, 1000);
+        loops.set_setpoint(i, 512);
+    }
+    row("PidBank<8>::update, per loop", cycles_of([&](std::uint8_t i) {
+            loops.set_measurement(i % 8U, static_cast<std::int16_t>(500 + (i & 15U)));
+            opaque(loops).update();
+        }) / 8);
+}
+
+// Sixteen alarm channels in one update, per channel, with all four limits set and the measurements inside them
+__attribute__((noinline)) void bench_alarm_bank() {
+    alarms::AlarmBank<16> bank;
+    for (std::uint8_t i = 0; i < 16; ++i) {
+        bank.set_limit(i, alarms::HH, 900);
+        bank.set_limit(i, alarms::H, 800);
+        bank.set_limit(i, alarms::L, 200);
+        bank.set_limit(i, alarms::LL, 100);
+        bank.set_hysteresis(i, 10);
+    }
+    row("AlarmBank<16>::update, per channel", cycles_of([&](std::uint8_t i) {
+            bank.set_measurement(i % 16U, static_cast<std::int16_t>(500 + (i & 15U)));
+            opaque(bank).update();
+        }) / 16);
+}
+
+// A chain of 8 pull nodes over a variable: pulled from its end, each node pulling the one before, and as a table
+std::int16_t chain_source = 0;
+
+std::int16_t chain_step(const std::int16_t* in, void*) { return static_cast<std::int16_t>(in[0] + 1); }
+
+struct ChainStep {
+    ramen::PullUnary<std::int16_t, std::int16_t> node{[](std::int16_t v) { return static_cast<std::int16_t>(v + 1); }};
+};
+
+__attribute__((noinline)) void bench_dataflow() {
+    ramen::Pullable<std::int16_t> source = [](std::int16_t& val) { val = chain_source; };
+    ChainStep chain[8];
+    chain[0].node.in >> source;
+    for (std::uint8_t i = 1; i < 8; ++i) {
+        chain[i].node.in >> chain[i - 1].node.out;
+    }
+    row("PullUnary chain of 8, pulled", cycles_of([&](std::uint8_t i) {
+            chain_source = i;
+            std::int16_t val = 0;
+            opaque(chain[7]).node.out(val);
+            sink = static_cast<std::uint8_t>(val);
+        }));
+
+    ramen::Dataflow<std::int16_t, 9> graph;
+    ramen::Dataflow<std::int16_t, 9>::Node last = graph.variable(&chain_source);
+    for (std::uint8_t i = 0; i < 8; ++i) {
+        last = graph.node(&chain_step, last);
+    }
+    graph.compile();
+    row("Dataflow chain of 8, evaluate", cycles_of([&](std::uint8_t i) {
+            chain_source = i;
+            opaque(graph).evaluate();
+            sink = static_cast<std::uint8_t>(graph.value(last));
+        }));
+}
+
+void bench_pins() {
+    pinMode(BENCH_PIN, OUTPUT);
+    row("digitalWrite(D0)", cycles_of([](std::uint8_t i) { digitalWrite(BENCH_PIN, i & 1U); }));
+    row("FastPin<D0>::write", cycles_of([](std::uint8_t i) { gpio::FastPin<BENCH_PIN>::write(i & 1U); }));
+    row("FastPin<D0>::toggle", cycles_of([](std::uint8_t) { gpio::FastPin<BENCH_PIN>::toggle(); }));
+    digitalWrite(BENCH_PIN, LOW);
+}
+
+} // namespace
+
+void setup() {
+    cycle_counter::start();
+    Serial.begin(9600);
+    loop_overhead = total_cycles([](std::uint8_t i) { sink = i; });
+
+    Serial.println(F("Micro-benchmarks, CPU cycles per operation:"));
+    bench_function();
+    bench_fan_out<1>("Pusher fan-out, 1 subscriber");
+    bench_fan_out<4>("Pusher fan-out, 4 subscribers");
+    bench_fan_out<16>("Pusher fan-out, 16 subscribers");
+    bench_link();
+    bench_timers<3>("TimerActor<3>::update, none due", "TimerActor<3>::update, per expiry");
+    bench_timers<32>("TimerActor<32>::update, none due", "TimerActor<32>::update, per expiry");
+    bench_timers<128>("TimerActor<128>::update, none due", "TimerActor<128>::update, per expiry");
+    bench_parse();
+    bench_function_blocks<256>("TimerBank<256>, per timer, idle", "TimerBank<256>, per timer, running",
+                               "CounterBank<256>, per counter", "EdgeBank<256>, per detector");
+    bench_logic_vm();
+    bench_pid_bank();
+    bench_alarm_bank();
+    bench_dataflow();
+    bench_coroutine();
+    bench_latch();
+    bench_scan_clock();
+    bench_boolean_network();
+    bench_pins();
+
+    ramen::Pusher<const char*> out;
+    ramen::Pusher<const __FlashStringHelper*> flash_out;
+    ramen::Pushable<const char*> print = [](const char* text) { Serial.println(text); };
+    ramen::Pushable<const __FlashStringHelper*> flash_print = [](const __FlashStringHelper* text) {
+        Serial.println(text);
+    };
+    out >> print;
+    flash_out >> flash_print;
+    fsm_benchmark::run(out, flash_out);
+    Serial.println(F("Done"));
+}
+
+void loop() {}
+
+#endif
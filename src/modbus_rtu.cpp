@@ -0,0 +1,24 @@
+#include "modbus_rtu.hpp"
+
+#if defined(__AVR__) && defined(MODBUS_RTU)
+ISR(USART3_RX_vect) {
+    const std::uint8_t status = UCSR3A;  // Valid for the byte in UDR3 until it is read
+    modbus_rtu::on_receive(status, UDR3);
+}
+
+ISR(USART3_UDRE_vect) {
+    modbus_rtu::on_data_register_empty();
+}
+
+ISR(USART3_TX_vect) {
+    modbus_rtu::on_transmit_complete();
+}
+
+ISR(TIMER2_COMPB_vect) {
+    modbus_rtu::on_gap();
+}
+
+ISR(TIMER2_COMPA_vect) {
+    modbus_rtu::on_frame_end();
+}
+#endif
@@ -0,0 +1,22 @@
+#include "pool_allocator.hpp"
+
+#if defined(POOL_OPERATOR_NEW)
+// Every form the Arduino core's new.cpp defines, so its object is not linked in beside these. A block no pool owns
+// cannot have come from here and is ignored.
+
+void* operator new(std::size_t size) { return memory_pool::allocate(size); }
+void* operator new[](std::size_t size) { return memory_pool::allocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    std::uint8_t pool_id = 0;
+    return memory_pool::pools.allocate(size, pool_id);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* ptr) noexcept { memory_pool::release(ptr); }
+void operator delete[](void* ptr) noexcept { memory_pool::release(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { memory_pool::release(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { memory_pool::release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { memory_pool::release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { memory_pool::release(ptr); }
+#endif
@@ -0,0 +1,58 @@
+// Definitions of the optional ramen dispatch hooks (see RAMEN_CFG_DISPATCH_HOOKS in ramen.hpp).
+// Each instrumentation module that wants to observe dispatches is called from here.
+#include "ramen.hpp"
+#include "port_profiler.hpp"
+#include "port_trace.hpp"
+#include "step_watchdog.hpp"
+
+#if defined(RAMEN_CFG_DISPATCH_HOOKS)
+namespace ramen {
+namespace hooks {
+
+void dispatch_begin(const void* port, std::size_t payload_size) noexcept {
+    if (port_trace::ENABLED) {
+        port_trace::record(port_trace::DISPATCH_BEGIN, port, payload_size);
+    }
+    if (port_profiler::ENABLED) {
+        port_profiler::profiler.begin(port);
+    }
+}
+
+void dispatch_end(const void* port) noexcept {
+    if (port_profiler::ENABLED) {
+        port_profiler::profiler.end(port);
+    }
+    if (port_trace::ENABLED) {
+        port_trace::record(port_trace::DISPATCH_END, port);
+    }
+}
+
+} // namespace hooks
+} // namespace ramen
+#endif
+
+#if defined(RAMEN_CFG_TRIGGER_HOOKS)
+namespace ramen {
+namespace hooks {
+
+void trigger_begin(const void* behavior) noexcept {
+    if (port_trace::ENABLED) {
+        port_trace::record(port_trace::TRIGGER_BEGIN, behavior);
+    }
+    if (step_watchdog::ENABLED) {
+        step_watchdog::begin_step(behavior);
+    }
+}
+
+void trigger_end(const void* behavior) noexcept {
+    if (step_watchdog::ENABLED) {
+        step_watchdog::end_step();
+    }
+    if (port_trace::ENABLED) {
+        port_trace::record(port_trace::TRIGGER_END, behavior);
+    }
+}
+
+} // namespace hooks
+} // namespace ramen
+#endif
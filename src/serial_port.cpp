@@ -0,0 +1,12 @@
+#include "serial_port.hpp"
+
+#if defined(__AVR__) && defined(SERIAL_BUFFERED_OUTPUT)
+ISR(USART0_UDRE_vect) {
+    serial_port::on_data_register_empty();
+}
+
+ISR(USART0_RX_vect) {
+    const std::uint8_t status = UCSR0A;  // Valid until UDR0 is read
+    serial_port::on_receive(UDR0, status);
+}
+#endif
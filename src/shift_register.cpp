@@ -0,0 +1,7 @@
+#include "shift_register.hpp"
+
+#if defined(__AVR__) && defined(SPI_EXPANDER)
+ISR(SPI_STC_vect) {
+    expander::detail::on_transfer_complete();
+}
+#endif
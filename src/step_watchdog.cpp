@@ -0,0 +1,62 @@
+#include "step_watchdog.hpp"
+
+#if defined(__AVR__)
+std::uint8_t step_watchdog::reset_cause __attribute__((section(".noinit")));  // .bss is cleared after .init3
+
+// A watchdog reset leaves the watchdog enabled at its shortest timeout, which would reset the board again before
+// setup() could start it; it is turned off here, naked in .init3 like the .init code around it (see boot_profile.cpp).
+// Its flag in MCUSR must be cleared first, and the flags stay until cleared, so MCUSR is saved for the reset cause and
+// cleared for the next one.
+extern "C" void step_watchdog_off() __attribute__((naked, used, section(".init3")));
+void step_watchdog_off() {
+    step_watchdog::reset_cause = MCUSR;
+    MCUSR = 0;
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = 0;
+}
+#else
+std::uint8_t step_watchdog::reset_cause = 0;
+#endif
+
+#if defined(STEP_WATCHDOG)
+#if defined(__AVR__)
+step_watchdog::ResetRecord step_watchdog::reset_record __attribute__((section(".noinit")));
+
+// At the deadline of the innermost step, or 65536 cycles before it
+ISR(TIMER5_COMPA_vect) {
+    if (step_watchdog::detail::due()) {
+        TIMSK5 &= static_cast<std::uint8_t>(~_BV(OCIE5A));
+        step_watchdog::detail::late = step_watchdog::detail::running;
+    }
+}
+
+// The critical actors missed a feed. Naked, so that the stack pointer is taken before anything is pushed: the return
+// address, 3 bytes high byte first on the ATmega2560, sits right above it. No register needs saving, as the board
+// resets; r1 is cleared for the C++ code.
+extern "C" void step_watchdog_crash(std::uint16_t sp) __attribute__((noreturn, used));
+
+ISR(WDT_vect, ISR_NAKED) {
+    asm volatile(
+        "in r24, __SP_L__\n\t"
+        "in r25, __SP_H__\n\t"
+        "clr r1\n\t"
+        "jmp step_watchdog_crash\n\t");
+}
+
+// Saves what was going on and resets the board at the shortest timeout
+void step_watchdog_crash(std::uint16_t sp) {
+    const std::uint8_t* const ret = reinterpret_cast<const std::uint8_t*>(sp + 1U);
+    const std::uint32_t pc = ((static_cast<std::uint32_t>(ret[0]) << 16) | (static_cast<std::uint32_t>(ret[1]) << 8) |
+                              ret[2]) << 1;
+    const std::uint16_t above = static_cast<std::uint16_t>(sp + 4U);
+    const std::uint16_t available = (above <= RAMEND) ? static_cast<std::uint16_t>(RAMEND + 1U - above) : 0U;
+    step_watchdog::detail::dump(step_watchdog::reset_record, pc, reinterpret_cast<const std::uint8_t*>(above),
+                                available);
+    wdt_enable(WDTO_15MS);
+    for (;;) {
+    }
+}
+#else
+step_watchdog::ResetRecord step_watchdog::reset_record{};
+#endif
+#endif
@@ -0,0 +1,8 @@
+#include "actor_stepper.hpp"
+
+// The step generator's compare interrupt (see actor_stepper.hpp)
+#if defined(__AVR__) && defined(STEPPER)
+ISR(TIMER3_COMPA_vect) {
+    stepper::detail::on_compare();
+}
+#endif
@@ -0,0 +1,247 @@
+#if defined(STRESS_TEST)
+#include "actor_led.hpp"
+#include "actor_serial_commander.hpp"
+#include "actor_timer.hpp"
+#include "fmt.hpp"
+#include "output_registry.hpp"
+#include "ramen.hpp"
+#include "serial_port.hpp"
+#include "stack_monitor.hpp"
+#include <Controllino.h>
+
+// The stress-test firmware, for finding where the architecture falls over as the number of actors grows: instead of
+// the application of main.cpp, the commander with its three LEDs runs next to STRESS_ACTORS synthetic actors that
+// blink like BlinkyLedActor on periodic timers of mixed periods, while a script floods the command parser.
+//
+//     pio run -e stress -t upload && pio device monitor
+//
+// The run is a series of stages of STRESS_STAGE_MS, each with twice the active synthetic actors of the one before
+// (1, 2, 4, ... up to STRESS_ACTORS, then the last again). At the end of a stage a row shows the figures of the stage:
+//   * loop pass time, longest and average (us); loop() does not idle, so the average is the full load
+//   * timer jitter: the latest tick of any actor behind its deadline (ms), the ticks, and the periods skipped
+//   * arm requests TimerActor had no free slot for, and the actors left without a timer
+//   * RAM headroom: the least free stack since reset (stack_monitor)
+//   * output lines serial_port dropped, and flood bytes lost because the receive buffer was full
+// STRESS_TIMER_SLOTS sizes the TimerActor, by default a slot for every actor; -D STRESS_TIMER_SLOTS=4 gives the
+// production count of main.cpp. The flood injects one line of FLOOD every STRESS_FLOOD_MS into the receive buffer, as
+// the receive interrupt would, so the build needs SERIAL_BUFFERED_OUTPUT; off AVR commands come from Serial instead.
+
+#ifndef STRESS_ACTORS
+#define STRESS_ACTORS 32
+#endif
+#ifndef STRESS_TIMER_SLOTS
+#define STRESS_TIMER_SLOTS (STRESS_ACTORS + MAX_CONCURRENT_TIMEOUTS + serial_cmd::SerialCommandSystem::TIMERS)
+#endif
+#ifndef STRESS_STAGE_MS
+#define STRESS_STAGE_MS 5000
+#endif
+#ifndef STRESS_FLOOD_MS
+#define STRESS_FLOOD_MS 50
+#endif
+
+#if defined(__AVR__) && !defined(SERIAL_BUFFERED_OUTPUT)
+#error "The command flood goes through the receive buffer of serial_port; build with -D SERIAL_BUFFERED_OUTPUT"
+#endif
+
+namespace {
+
+constexpr std::uint8_t ACTORS = STRESS_ACTORS;
+constexpr std::uint16_t PERIODS_MS[] = {10, 25, 40, 100, 150, 250, 500, 1000};  // Of actor i, cyclically
+
+constexpr std::size_t FLOOD_LINE_SIZE = 48;
+constexpr char FLOOD[][FLOOD_LINE_SIZE] PROGMEM = {
+    "interval 1 100; interval 2 150; interval 3 200",
+    "stop 2; start 2",
+    "status",
+    "start 1-3; interval * 250",
+    "stats",
+    "stop *; start 1-3",
+};
+constexpr std::uint8_t FLOOD_LINES = sizeof(FLOOD) / sizeof(FLOOD[0]);
+
+volatile bool sink;
+
+// Blinks like BlinkyLedActor, without a pin: a periodic timer ticks it, and it checks each tick against its deadline
+class SyntheticActor {
+public:
+    ramen::Pusher<const ArmTimerEvt&> arm_timer_request_out;
+    ramen::Pusher<const BaseEvent&> timeout_event_relay_out;
+    ramen::Pushable<const BaseEvent&> timeout_in =
+        [this](const BaseEvent& evt) { on_tick(static_cast<const TickEvent&>(evt)); };
+
+    // Figures since clear_figures()
+    std::uint32_t max_late_ms = 0;
+    std::uint16_t ticks = 0;
+    std::uint16_t missed = 0;
+
+    SyntheticActor() { timeout_event_relay_out >> timeout_in; }
+
+    void start(std::uint16_t period_ms) {
+        period_ms_ = period_ms;
+        due_ = millis() + period_ms;
+        ArmTimerEvt evt(period_ms, &timeout_event_relay_out, true, &handle_, OverrunPolicy::COALESCE);
+        arm_timer_request_out(evt);
+    }
+
+    bool armed() const { return handle_.valid(); }
+
+    void clear_figures() {
+        max_late_ms = 0;
+        ticks = 0;
+        missed = 0;
+    }
+
+private:
+    void on_tick(const TickEvent& tick) {
+        const std::uint32_t deadline = due_ + static_cast<std::uint32_t>(tick.missed) * period_ms_;
+        const std::uint32_t late = millis() - deadline;
+        if (static_cast<std::int32_t>(late) > 0 && late > max_late_ms) {
+            max_late_ms = late;
+        }
+        due_ = deadline + period_ms_;
+        if (ticks != UINT16_MAX) {
+            ++ticks;
+        }
+        missed = static_cast<std::uint16_t>((missed > UINT16_MAX - tick.missed) ? UINT16_MAX : missed + tick.missed);
+        state_ = !state_;
+        sink = state_;
+    }
+
+    std::uint32_t due_ = 0;
+    std::uint16_t period_ms_ = 0;
+    bool state_ = false;
+    TimerHandle handle_;
+};
+
+TimerActor<STRESS_TIMER_SLOTS> timer;
+led::BlinkyLedActor led1(CONTROLLINO_D0, 500);
+led::BlinkyLedActor led2(CONTROLLINO_D1, 1000);
+led::BlinkyLedActor led3(CONTROLLINO_D2, 500);
+led::OutputRegistry<3> outputs(led1, led2, led3);
+serial_cmd::SerialCommandSystem commander(outputs);
+SyntheticActor actors[ACTORS];
+
+std::uint8_t active = 0;
+std::uint32_t stage_start = 0;
+std::uint32_t last_flood = 0;
+std::uint8_t flood_line = 0;
+
+// Loop figures of the stage
+std::uint32_t passes = 0;
+std::uint32_t busy_us = 0;
+std::uint32_t max_pass_us = 0;
+std::uint16_t no_slot_seen = 0;
+std::uint16_t dropped_seen = 0;
+
+void write(const char* text) { serial_port::write_line(text, serial_port::Overflow::BLOCK); }
+
+// Activates the actors of the next stage
+void grow() {
+    const std::uint8_t target = (active == 0) ? 1 : ((active >= ACTORS / 2U) ? ACTORS : active * 2U);
+    for (; active < target; ++active) {
+        actors[active].start(PERIODS_MS[active % (sizeof(PERIODS_MS) / sizeof(PERIODS_MS[0]))]);
+    }
+}
+
+// The next flood line, into the receive buffer with interrupts disabled as from the receive interrupt
+void flood() {
+    if (!serial_port::ENABLED || millis() - last_flood < STRESS_FLOOD_MS) {
+        return;
+    }
+    last_flood = millis();
+    const char* line = FLOOD[flood_line];
+    flood_line = static_cast<std::uint8_t>((flood_line + 1U) % FLOOD_LINES);
+    noInterrupts();
+    for (std::uint8_t i = 0; i < FLOOD_LINE_SIZE; ++i) {
+        const char c = static_cast<char>(pgm_read_byte(line + i));
+        if (c == '\0') {
+            break;
+        }
+        serial_port::on_receive(static_cast<std::uint8_t>(c));
+    }
+    serial_port::on_receive('\n');
+    interrupts();
+}
+
+void report() {
+    std::uint32_t late_ms = 0;
+    std::uint32_t ticks = 0;
+    std::uint32_t missed = 0;
+    std::uint8_t unarmed = 0;
+    for (std::uint8_t i = 0; i < active; ++i) {
+        SyntheticActor& a = actors[i];
+        late_ms = (a.max_late_ms > late_ms) ? a.max_late_ms : late_ms;
+        ticks += a.ticks;
+        missed += a.missed;
+        unarmed = static_cast<std::uint8_t>(unarmed + (a.armed() ? 0U : 1U));
+        a.clear_figures();
+    }
+    const std::uint16_t no_slot = timer.error_counts[static_cast<std::uint8_t>(TimerError::NO_FREE_SLOTS)];
+
+    fmt::Line<96> msg;
+    fmt::write(msg, fmt::right(static_cast<unsigned>(active), 6), fmt::right(static_cast<unsigned>(timer.capacity), 6),
+               fmt::right(static_cast<unsigned long>(max_pass_us), 9),
+               fmt::right(static_cast<unsigned long>((passes > 0) ? busy_us / passes : 0), 7),
+               fmt::right(static_cast<unsigned long>(late_ms), 8), fmt::right(static_cast<unsigned long>(ticks), 7),
+               fmt::right(static_cast<unsigned long>(missed), 8),
+               fmt::right(static_cast<unsigned>(no_slot - no_slot_seen), 8),
+               fmt::right(static_cast<unsigned>(unarmed), 8),
+               fmt::right(static_cast<unsigned>(stack_monitor::unused()), 7),
+               fmt::right(static_cast<unsigned>(serial_port::dropped_messages - dropped_seen), 8),
+               fmt::right(static_cast<unsigned>(serial_port::rx.dropped()), 8));
+    write(msg.c_str());
+
+    no_slot_seen = no_slot;
+    dropped_seen = serial_port::dropped_messages;
+    passes = 0;
+    busy_us = 0;
+    max_pass_us = 0;
+}
+
+} // namespace
+
+void setup() {
+    stack_monitor::paint();
+    commander.attach_timer(timer);
+    commander.init();
+
+    led1.init();
+    led2.init();
+    led3.init();
+    led1.arm_timer_request_out >> timer.arm_timer_request_in;
+    led2.arm_timer_request_out >> timer.arm_timer_request_in;
+    led3.arm_timer_request_out >> timer.arm_timer_request_in;
+    led1.disarm_timer_request_out >> timer.disarm_timer_request_in;
+    led2.disarm_timer_request_out >> timer.disarm_timer_request_in;
+    led3.disarm_timer_request_out >> timer.disarm_timer_request_in;
+    for (SyntheticActor& a : actors) {
+        a.arm_timer_request_out >> timer.arm_timer_request_in;
+    }
+    led1.start();
+    led2.start();
+    led3.start();
+
+    write("Stress test: actors, timer slots; loop max, avg (us); late (ms), ticks, skipped periods;");
+    write("no-slot arms, actors without timer; min free stack (bytes); TX lines dropped, RX bytes lost");
+    write("Actors Slots Loop max    avg    Late  Ticks Skipped  NoSlot Untimed  Stack  TXdrop  RXlost");
+    grow();
+    stage_start = millis();
+}
+
+void loop() {
+    const std::uint32_t start = micros();
+    flood();
+    commander.update();
+    timer.update();
+    const std::uint32_t elapsed = micros() - start;
+    ++passes;
+    busy_us += elapsed;
+    max_pass_us = (elapsed > max_pass_us) ? elapsed : max_pass_us;
+
+    if (millis() - stage_start >= STRESS_STAGE_MS) {
+        report();
+        grow();
+        stage_start = millis();
+    }
+}
+#endif
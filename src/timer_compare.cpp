@@ -0,0 +1,8 @@
+#include "timer_compare.hpp"
+
+#if defined(__AVR__) && defined(TIMER_HW_COMPARE)
+ISR(TIMER4_COMPA_vect) {
+    TIMSK4 &= static_cast<std::uint8_t>(~_BV(OCIE4A));  // One interrupt per arm()
+    timer_compare::ready.push(timer_compare::Expiry{timer_compare::armed_slot, timer_compare::armed_generation});
+}
+#endif
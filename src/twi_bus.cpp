@@ -0,0 +1,7 @@
+#include "twi_bus.hpp"
+
+#if defined(__AVR__) && defined(TWI_ASYNC)
+ISR(TWI_vect) {
+    twi::detail::on_twi();
+}
+#endif
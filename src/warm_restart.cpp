@@ -0,0 +1,10 @@
+#include "warm_restart.hpp"
+
+#if defined(WARM_RESTART)
+#if defined(__AVR__)
+// Past .bss, so neither the startup code nor a reset clears it, and below the heap
+warm_restart::Image warm_restart::images[2] __attribute__((section(".noinit")));
+#else
+warm_restart::Image warm_restart::images[2]{};
+#endif
+#endif
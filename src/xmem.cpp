@@ -0,0 +1,12 @@
+#include "xmem.hpp"
+
+#if defined(XMEM) && defined(__AVR__)
+// In .init3, after the stack is set up and before .data, .bss and the constructors, so that objects placed in XMEM
+// by the constructors of globals can be written
+extern "C" void xmem_init() __attribute__((naked, used, section(".init3")));
+
+extern "C" void xmem_init() {
+    XMCRA = xmem::XMCRA_VALUE;
+    XMCRB = 0;  // All of port C drives A8-15
+}
+#endif
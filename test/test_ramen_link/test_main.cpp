@@ -0,0 +1,93 @@
+#include "ramen.hpp"
+#include <string>
+#include <unity.h>
+
+// Order in which the behaviors of a topic run, as linked with Event::link(behavior, priority) and operator>>.
+//
+//     pio test -e native
+
+namespace {
+
+std::string order;
+
+// A behavior that notes its name when triggered
+struct Named {
+    explicit Named(char name) : in([this](int) { order += tag; }), tag(name) {}
+    ramen::Pushable<int> in;
+    char tag;
+};
+
+void run(ramen::Pusher<int>& topic) {
+    order.clear();
+    topic(0);
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+// Behaviors linked to one topic run by priority, then in the order of linking
+void test_link_orders_by_priority() {
+    ramen::Pusher<int> topic;
+    Named a('a'), b('b'), c('c'), d('d');
+    topic.link(a.in, 1);
+    topic.link(b.in, 3);
+    topic >> c.in;  // Priority 0
+    topic.link(d.in, 1);
+    run(topic);
+    TEST_ASSERT_EQUAL_STRING("badc", order.c_str());
+}
+
+// Joining a topic of lower priorities to one of higher priorities, the reverse of their order, merges the behaviors
+void test_merge_of_prioritized_topics_in_reverse_order() {
+    ramen::Pusher<int> low;
+    ramen::Pusher<int> high;
+    Named a('a'), b('b'), c('c'), d('d'), e('e');
+    low.link(a.in, 1);
+    low >> b.in;
+    high.link(c.in, 4);
+    high.link(d.in, 2);
+    high.link(e.in, 1);
+    low >> high;
+    run(low);
+    TEST_ASSERT_EQUAL_STRING("cdaeb", order.c_str());
+    run(high);
+    TEST_ASSERT_EQUAL_STRING("cdaeb", order.c_str());
+}
+
+// Equal priorities keep the order of linking across a merge: the topic linked to comes first
+void test_merge_keeps_link_order_for_equal_priorities() {
+    ramen::Pusher<int> first;
+    ramen::Pusher<int> second;
+    Named a('a'), b('b'), c('c'), d('d');
+    first.link(a.in, 2);
+    first >> b.in;
+    second.link(c.in, 2);
+    second >> d.in;
+    first >> second;
+    run(first);
+    TEST_ASSERT_EQUAL_STRING("acbd", order.c_str());
+}
+
+// Without priorities a merge appends, as before priorities existed
+void test_merge_without_priorities_appends() {
+    ramen::Pusher<int> first;
+    ramen::Pusher<int> second;
+    Named a('a'), b('b'), c('c');
+    first >> a.in;
+    second >> b.in;
+    second >> c.in;
+    first >> second;
+    run(first);
+    TEST_ASSERT_EQUAL_STRING("abc", order.c_str());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_link_orders_by_priority);
+    RUN_TEST(test_merge_of_prioritized_topics_in_reverse_order);
+    RUN_TEST(test_merge_keeps_link_order_for_equal_priorities);
+    RUN_TEST(test_merge_without_priorities_appends);
+    return UNITY_END();
+}
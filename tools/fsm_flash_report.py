@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Attributes flash use of a firmware image to its Boost SML state machines.
+
+Text symbols of the ELF are grouped by the state machine they were generated for: dispatch code of an sm<> is found
+through the sm_policy<Fsm, ...> in its name, actions and guards through the lambda of Fsm::operator()() they wrap.
+Actions that the compiler inlined into the dispatch code are counted there; build with -D FSM_NOINLINE_ACTIONS (see
+actor_fsm.hpp) to see every action on its own line.
+
+    python3 tools/fsm_flash_report.py .pio/build/controllino_maxi_automation/firmware.elf [--nm avr-nm]
+
+or run it through PlatformIO with 'pio run -t fsmreport'.
+"""
+
+import argparse
+import collections
+import subprocess
+import sys
+
+TEXT_TYPES = set("tTwW")
+LAMBDA_MARK = "::operator()() const::{lambda("
+
+
+def template_argument(name, start):
+    """Returns the first template argument of the template whose '<' is at name[start - 1]."""
+    depth = 0
+    for i in range(start, len(name)):
+        c = name[i]
+        if c == "<":
+            depth += 1
+        elif c == ">":
+            if depth == 0:
+                return name[start:i]
+            depth -= 1
+        elif c == "," and depth == 0:
+            return name[start:i]
+    return name[start:]
+
+
+def qualified_name_before(name, end):
+    """Returns the qualified name (with template arguments) that ends at name[end]."""
+    depth = 0
+    i = end
+    while i > 0:
+        c = name[i - 1]
+        if c == ">":
+            depth += 1
+        elif c == "<":
+            if depth == 0:
+                break
+            depth -= 1
+        elif depth == 0 and not (c.isalnum() or c in "_:"):
+            break
+        i -= 1
+    return name[i:end]
+
+
+def dispatch_policy(name):
+    mark = "policies::dispatch<"
+    pos = name.find(mark)
+    if pos < 0:
+        return None
+    return template_argument(name, pos + len(mark)).rsplit("::", 1)[-1]
+
+
+def classify(name):
+    """Returns (fsm, component) for symbols generated for a state machine, None otherwise."""
+    pos = name.find(LAMBDA_MARK)
+    if pos >= 0:
+        fsm = qualified_name_before(name, pos)
+        start = pos + len("::operator()() const::")
+        end = name.find("}", start)
+        lam = name[start + 1:end] if end > 0 else name[start + 1:]
+        args, _, index = lam.partition(")#")
+        return fsm, "lambda #%s (%s)" % (index or "?", args[len("lambda("):])
+    pos = name.find("sm_policy<")
+    if pos >= 0:
+        fsm = template_argument(name, pos + len("sm_policy<"))
+        policy = dispatch_policy(name)
+        return fsm, "dispatch and state handling" + (" [%s]" % policy if policy else "")
+    return None
+
+
+def read_symbols(nm, elf):
+    out = subprocess.run([nm, "-C", "-S", "--size-sort", elf], check=True, capture_output=True, text=True).stdout
+    seen = set()
+    for line in out.splitlines():
+        parts = line.split(" ", 3)
+        if len(parts) != 4 or parts[2] not in TEXT_TYPES:
+            continue
+        address, size, _, name = parts
+        if address in seen:  # Aliases such as complete and base object constructors
+            continue
+        seen.add(address)
+        yield int(size, 16), name
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="avr-nm")
+    args = parser.parse_args()
+
+    report = collections.defaultdict(lambda: collections.Counter())
+    total = 0
+    for size, name in read_symbols(args.nm, args.elf):
+        total += size
+        hit = classify(name)
+        if hit is not None:
+            report[hit[0]][hit[1]] += size
+
+    fsm_total = sum(sum(c.values()) for c in report.values())
+    print("State machine flash use in %s" % args.elf)
+    print("  %6s  %s" % ("Bytes", "State machine / component"))
+    for fsm, components in sorted(report.items(), key=lambda kv: -sum(kv[1].values())):
+        print("  %6d  %s" % (sum(components.values()), fsm))
+        for component, size in components.most_common():
+            print("  %6d      %s" % (size, component))
+    print("  %6d  total of %d bytes of code (%.1f%%)" % (fsm_total, total, 100.0 * fsm_total / total if total else 0.0))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
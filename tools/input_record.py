@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Turns the output of the 'record' command into a replay header, a binary log or a listing.
+
+A firmware built with -D INPUT_RECORD logs the serial bytes it reads and the input levels it sees (see
+include/input_record.hpp); 'record' prints the log as
+
+    Input record: <bytes> bytes, <lost> records lost, <ms> ms
+    > <hex bytes>
+
+--header writes the log as INPUT_REPLAY_DATA[] for a build with -D INPUT_REPLAY, on the target or in the native
+environment; --bin writes the bytes as they are. Without either, or with --list, the records are listed one per line
+with their time, which is handy for comparing two records.
+
+    python3 tools/input_record.py capture.txt --header include/input_replay_log.h
+    python3 tools/input_record.py capture.txt --list
+"""
+
+import argparse
+import sys
+
+HEADER = "Input record: "
+PORT_NAMES = "ABCDEFGHJKL"
+RX_BYTE, PORT_LEVELS, GAP = 0x00, 0x40, 0xC0
+
+
+def read_log(lines):
+    """Returns (header line, log bytes) of the last record in the capture."""
+    header, data = None, bytearray()
+    for line in lines:
+        line = line.strip()
+        if line.startswith(HEADER):
+            header, data = line, bytearray()
+        elif header is not None and line.startswith("> "):
+            data += bytes.fromhex(line[2:])
+    return header, bytes(data)
+
+
+def records(data):
+    """Yields (ms since the start, kind, fields) of each record."""
+    ms, i = 0, 0
+    while i < len(data):
+        tag = data[i]
+        kind = tag & 0xC0
+        if kind == GAP:
+            if i + 3 > len(data):
+                break
+            ms += data[i + 1] | (data[i + 2] << 8)
+            i += 3
+            continue
+        length = 2 if kind == RX_BYTE else 4
+        if i + length > len(data):
+            break
+        ms += tag & 0x3F
+        yield ms, kind, data[i + 1:i + length]
+        i += length
+
+
+def listing(data):
+    out = []
+    for ms, kind, fields in records(data):
+        if kind == RX_BYTE:
+            out.append("%8d ms  rx    %s" % (ms, repr(chr(fields[0]))))
+        elif kind == PORT_LEVELS:
+            port, mask, levels = fields
+            name = PORT_NAMES[port] if port < len(PORT_NAMES) else "?"
+            out.append("%8d ms  port  %s mask %s levels %s" % (ms, name, format(mask, "08b"), format(levels, "08b")))
+        else:
+            out.append("%8d ms  ?     %s" % (ms, fields.hex()))
+    return "\n".join(out) + "\n"
+
+
+def header_file(data, source):
+    lines = ["#pragma once", "#include <Controllino.h>", "#include <cstdint>", "",
+             "// Input replayed with -D INPUT_REPLAY (see input_record.hpp); from %s by tools/input_record.py" % source,
+             "constexpr std::uint8_t INPUT_REPLAY_DATA[] PROGMEM = {"]
+    for i in range(0, len(data), 16):
+        lines.append("    " + " ".join("0x%02x," % b for b in data[i:i + 16]))
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="text captured from the serial port (default: stdin)")
+    parser.add_argument("--header", help="replay header to write, e.g. include/input_replay_log.h")
+    parser.add_argument("--bin", help="binary log to write")
+    parser.add_argument("--list", action="store_true", help="list the records (the default without --header/--bin)")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, errors="replace") as f:
+            header, data = read_log(f)
+    else:
+        header, data = read_log(sys.stdin)
+    if header is None:
+        print("No input record found", file=sys.stderr)
+        return 1
+    if not data:
+        print("The input record is empty", file=sys.stderr)
+        return 1
+    if " 0 records lost" not in header:
+        print("Warning: the record is incomplete, %s" % header[len(HEADER):], file=sys.stderr)
+
+    if args.header:
+        with open(args.header, "w") as f:
+            f.write(header_file(data, args.capture or "stdin"))
+    if args.bin:
+        with open(args.bin, "wb") as f:
+            f.write(data)
+    if args.list or not (args.header or args.bin):
+        sys.stdout.write(listing(data))
+    print("%d bytes, %d records" % (len(data), sum(1 for _ in records(data))), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
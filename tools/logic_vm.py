@@ -0,0 +1,267 @@
+#!/usr/bin/env python3
+"""Assembles a logic program for the VM of a firmware built with -D LOGIC_VM, and downloads it.
+
+The listing has an instruction per line, its operands separated by commas, as in include/logic_vm.hpp: bit registers
+b0..b63, word registers w0..w15, timers t0..t15 (whose presets are the word registers of the same number), pins as
+numbers or names given with .pin, constants for LDK, and labels for the jumps, which only go forward:
+
+    .pin IN0 18
+    .pin D3 5
+        LDK  w0, 500        ; the preset of timer 0
+        LD   b0, IN0
+        TON  b1, b0, t0
+        ST   b1, D3
+        END
+
+The program becomes the image the firmware keeps in EEPROM (magic, version, count, code, CRC-16), which --port
+downloads over the binary protocol in PROGRAM_WRITE chunks and runs with PROGRAM_COMMIT; the firmware answers
+BAD_PROGRAM if its pins are not the image's or the program fails verification, and keeps the one it runs.
+
+    python3 tools/logic_vm.py interlock.lvm --list
+    python3 tools/logic_vm.py interlock.lvm --bin interlock.bin
+    python3 tools/logic_vm.py interlock.lvm --port /dev/ttyACM0        # needs pyserial
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+MAGIC, VERSION = ord("L"), 1
+BITS, WORDS, TIMERS = 64, 16, 16
+MAX_INSTRUCTIONS = 254
+CHUNK_SIZE = 32
+PROGRAM_WRITE, PROGRAM_COMMIT, REPLY = 0x04, 0x05, 0x80
+RESULTS = ["OK", "UNKNOWN_TYPE (no logic VM?)", "BAD_LENGTH", "BAD_INDEX", "BAD_ACTION", "BAD_PERIOD", "BUSY",
+           "BAD_PROGRAM"]
+BUSY = 6
+
+# Opcode and operand kinds, in the order of logic_vm::Op: b bit, w word, t timer, p pin, k constant, j jump target
+OPS = [("END", ""), ("LD", "bp"), ("ST", "bp"), ("MOV", "bb"), ("NOT", "bb"), ("AND", "bbb"), ("OR", "bbb"),
+       ("XOR", "bbb"), ("ANDN", "bbb"), ("SET", "bb"), ("RST", "bb"), ("RISE", "bbb"), ("FALL", "bbb"),
+       ("LDK", "wk"), ("MOVW", "ww"), ("ADD", "www"), ("SUB", "www"), ("CTU", "wbb"), ("GT", "bww"),
+       ("GE", "bww"), ("EQ", "bww"), ("TON", "bbt"), ("TOF", "bbt"), ("JMP", "j"), ("JMPC", "bj"), ("JMPN", "bj")]
+OPCODES = {name: (code, kinds) for code, (name, kinds) in enumerate(OPS)}
+
+
+class AsmError(Exception):
+    pass
+
+
+def register(text, prefix, count):
+    if not text.lower().startswith(prefix) or not text[1:].isdigit() or int(text[1:]) >= count:
+        raise AsmError("expected %s0..%s%d, not %r" % (prefix, prefix, count - 1, text))
+    return int(text[1:])
+
+
+def number(text, names, low, high, what):
+    if text in names:
+        value = names[text]
+    else:
+        try:
+            value = int(text, 0)
+        except ValueError:
+            raise AsmError("unknown %s %r" % (what, text))
+    if not low <= value <= high:
+        raise AsmError("%s %d out of range" % (what, value))
+    return value
+
+
+def assemble(lines):
+    """Returns the instructions, each (op, a, b, c), of a listing."""
+    names, labels, parsed = {}, {}, []
+    for lineno, line in enumerate(lines, 1):
+        line = line.split(";")[0].strip()
+        if not line:
+            continue
+        if line.endswith(":"):
+            labels[line[:-1].strip()] = len(parsed)
+            continue
+        if line.startswith(".pin"):
+            parts = line.split()
+            if len(parts) != 3:
+                raise AsmError("line %d: .pin <name> <pin>" % lineno)
+            names[parts[1]] = int(parts[2], 0)
+            continue
+        mnemonic, _, rest = line.partition(" ")
+        operands = [o.strip() for o in rest.split(",") if o.strip()]
+        parsed.append((lineno, mnemonic.upper(), operands))
+    code = []
+    for index, (lineno, mnemonic, operands) in enumerate(parsed):
+        try:
+            if mnemonic not in OPCODES:
+                raise AsmError("unknown instruction %s" % mnemonic)
+            op, kinds = OPCODES[mnemonic]
+            if len(operands) != len(kinds):
+                raise AsmError("%s takes %d operands" % (mnemonic, len(kinds)))
+            fields = []
+            for kind, text in zip(kinds, operands):
+                if kind == "b":
+                    fields.append(register(text, "b", BITS))
+                elif kind == "w":
+                    fields.append(register(text, "w", WORDS))
+                elif kind == "t":
+                    fields.append(register(text, "t", TIMERS))
+                elif kind == "p":
+                    fields.append(number(text, names, 0, 255, "pin"))
+                elif kind == "k":
+                    value = number(text, {}, -32768, 65535, "constant") & 0xFFFF
+                    fields += [value & 0xFF, value >> 8]
+                else:
+                    if text not in labels:
+                        raise AsmError("unknown label %r" % text)
+                    if labels[text] <= index:
+                        raise AsmError("jumps only go forward")
+                    fields += [labels[text] & 0xFF, labels[text] >> 8]
+            code.append(tuple([op] + fields + [0] * (3 - len(fields))))
+        except AsmError as e:
+            raise AsmError("line %d: %s" % (lineno, e))
+    if not code or code[-1][0] != 0:
+        raise AsmError("the program must end in END")
+    if len(code) > MAX_INSTRUCTIONS:
+        raise AsmError("%d instructions, the EEPROM region holds %d" % (len(code), MAX_INSTRUCTIONS))
+    return code
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def image(code):
+    data = bytes([MAGIC, VERSION]) + struct.pack("<H", len(code)) + b"".join(bytes(i) for i in code)
+    return data + struct.pack("<H", crc16(data))
+
+
+def listing(code):
+    out = []
+    for index, (op, a, b, c) in enumerate(code):
+        out.append("%3d  %02x %02x %02x %02x  %s" % (index, op, a, b, c, OPS[op][0]))
+    return "\n".join(out) + "\n"
+
+
+def cobs_encode(data):
+    out, block = bytearray(), bytearray()
+    for byte in data:
+        if byte == 0:
+            out += bytes([len(block) + 1]) + block
+            block = bytearray()
+        else:
+            block.append(byte)
+            if len(block) == 254:
+                out += bytes([255]) + block
+                block = bytearray()
+    return bytes(out + bytes([len(block) + 1]) + block)
+
+
+def cobs_decode(data):
+    out, i = bytearray(), 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 255 and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Endpoint:
+    """Requests and replies of the binary protocol on a serial port; text between frames is skipped."""
+
+    def __init__(self, port, baud, timeout):
+        import serial  # pyserial
+
+        self.port = serial.Serial(port, baud, timeout=0.05)
+        self.timeout = timeout
+        self.seq = 0
+
+    def request(self, type_, body=b"", retries=3):
+        self.seq = (self.seq + 1) & 0xFF
+        payload = bytes([type_, self.seq]) + body
+        frame = b"\0" + cobs_encode(payload + struct.pack("<H", crc16(payload))) + b"\0"
+        for _ in range(retries):
+            self.port.write(frame)
+            result = self.reply(type_ | REPLY)
+            if result is not None:
+                return result
+        raise RuntimeError("no reply to request type 0x%02x" % type_)
+
+    def reply(self, type_):
+        deadline, buffer, inside = time.time() + self.timeout, bytearray(), False
+        while time.time() < deadline:
+            for byte in self.port.read(64):
+                if byte != 0:
+                    if inside:
+                        buffer.append(byte)
+                    continue
+                if inside and buffer:
+                    payload = cobs_decode(bytes(buffer))
+                    if (payload and len(payload) >= 5 and crc16(payload[:-2]) == struct.unpack("<H", payload[-2:])[0]
+                            and payload[0] == type_ and payload[1] == self.seq):
+                        return payload[2]
+                inside, buffer = True, bytearray()
+        return None
+
+
+def download(endpoint, data):
+    offset = 0
+    while offset < len(data):
+        chunk = data[offset:offset + CHUNK_SIZE]
+        result = endpoint.request(PROGRAM_WRITE, struct.pack("<H", offset) + chunk)
+        if result == BUSY:  # The chunk before is still being written, 3.4 ms a byte
+            time.sleep(0.02)
+            continue
+        if result != 0:
+            raise RuntimeError("writing at %d: %s" % (offset, RESULTS[result] if result < len(RESULTS) else result))
+        offset += len(chunk)
+    while True:
+        result = endpoint.request(PROGRAM_COMMIT)
+        if result != BUSY:
+            break
+        time.sleep(0.02)
+    if result != 0:
+        raise RuntimeError("commit: %s" % (RESULTS[result] if result < len(RESULTS) else result))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("listing", help="the program, e.g. interlock.lvm")
+    parser.add_argument("--list", action="store_true", help="print the assembled instructions")
+    parser.add_argument("--bin", help="write the EEPROM image to a file")
+    parser.add_argument("--port", help="download to the firmware on a serial port, e.g. /dev/ttyACM0")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--timeout", type=float, default=0.5, help="seconds to wait for a reply")
+    args = parser.parse_args()
+
+    try:
+        with open(args.listing) as f:
+            code = assemble(f)
+    except AsmError as e:
+        print("%s: %s" % (args.listing, e), file=sys.stderr)
+        return 1
+    data = image(code)
+    if args.list:
+        sys.stdout.write(listing(code))
+    if args.bin:
+        with open(args.bin, "wb") as f:
+            f.write(data)
+    if args.port:
+        try:
+            download(Endpoint(args.port, args.baud, args.timeout), data)
+        except RuntimeError as e:
+            print("%s: %s" % (args.port, e), file=sys.stderr)
+            return 1
+        print("Downloaded %d instructions, %d bytes" % (len(code), len(data)), file=sys.stderr)
+    elif not (args.list or args.bin):
+        sys.stdout.write(listing(code))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
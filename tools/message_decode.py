@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Turns the message records of a firmware built with -D SERIAL_DICTIONARY_LOG back into text.
+
+The firmware sends the messages of MESSAGE_CATALOGUE (include/message_catalogue.hpp) as COBS frames holding the
+message id and its arguments (see message_log.hpp). This script reads the catalogue from the same source tree, then
+decodes a capture of the serial output: records become their text, the text between frames passes through unchanged,
+and other frames (binary protocol replies) are shown in hex.
+
+    python3 tools/message_decode.py capture.bin
+    python3 tools/message_decode.py --port /dev/ttyACM0        # live, needs pyserial
+    python3 tools/message_decode.py --names Pump,Valve,Lamp capture.bin
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+RECORD = 0x40
+CATALOGUE = os.path.join(os.path.dirname(__file__), "..", "include", "message_catalogue.hpp")
+ENTRY = re.compile(r'^\s*X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)')
+PLACEHOLDER = re.compile(r"\{(u8|u16|u32|i16|i32|output)\}")
+FIELDS = {"u8": "<B", "u16": "<H", "u32": "<I", "i16": "<h", "i32": "<i", "output": "<B"}
+
+
+def read_catalogue(path):
+    """Returns the formats of the catalogue, indexed by message id."""
+    formats = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            match = ENTRY.match(line)
+            if match:
+                formats.append(match.group(2).encode("utf-8").decode("unicode_escape"))
+    return formats
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as binary_frame::crc16()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Returns the decoded payload, or None if `data` is no valid encoding."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def format_record(formats, names, payload):
+    """Returns the text of a record payload (without its CRC)."""
+    message_id = payload[1]
+    if message_id >= len(formats):
+        return "<unknown message %d: %s>" % (message_id, payload[2:].hex())
+    args = payload[2:]
+    offset = 0
+
+    def argument(match):
+        nonlocal offset
+        kind = match.group(1)
+        field = FIELDS[kind]
+        size = struct.calcsize(field)
+        if offset + size > len(args):
+            return "<missing>"
+        (value,) = struct.unpack_from(field, args, offset)
+        offset += size
+        if kind == "output":
+            return names[value] if value < len(names) else "LED%d" % (value + 1)
+        return str(value)
+
+    return PLACEHOLDER.sub(argument, formats[message_id])
+
+
+def decode_frame(formats, names, encoded):
+    payload = cobs_decode(encoded)
+    if payload is None or len(payload) < 3 or crc16(payload[:-2]) != struct.unpack("<H", payload[-2:])[0]:
+        return "<bad frame: %s>" % encoded.hex()
+    payload = payload[:-2]
+    if payload[0] == RECORD and len(payload) >= 2:
+        return format_record(formats, names, payload)
+    return "<frame: %s>" % payload.hex()
+
+
+def decode_stream(chunks, formats, names, out):
+    """Decodes a byte stream given as an iterable of chunks, writing text to `out`."""
+    in_frame = False
+    frame = bytearray()
+    for chunk in chunks:
+        for byte in chunk:
+            if byte == 0:
+                if not in_frame:
+                    in_frame = True
+                    frame.clear()
+                elif frame:  # Repeated delimiters open the same frame
+                    in_frame = False
+                    out.write(decode_frame(formats, names, bytes(frame)) + "\n")
+            elif in_frame:
+                frame.append(byte)
+            elif byte != ord("\r"):
+                out.write(chr(byte))
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="captured serial output (default: standard input)")
+    parser.add_argument("--port", help="read a serial port instead, e.g. /dev/ttyACM0")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--catalogue", default=CATALOGUE, help="message_catalogue.hpp of the firmware's revision")
+    parser.add_argument("--names", default="", help="output names, comma-separated, if set with set_names_P()")
+    args = parser.parse_args()
+
+    formats = read_catalogue(args.catalogue)
+    names = [n for n in args.names.split(",") if n]
+    if args.port:
+        import serial  # pyserial
+
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        chunks = iter(lambda: port.read(256), None)
+    else:
+        source = open(args.capture, "rb") if args.capture else sys.stdin.buffer
+        chunks = iter(lambda: source.read(4096), b"")
+    try:
+        decode_stream(chunks, formats, names, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,13 @@
+# PlatformIO extra script: 'pio run -t fsmreport' builds the firmware and prints its flash use per SML state machine
+# (see fsm_flash_report.py).
+Import("env")
+
+nm = env.subst("$SIZETOOL").replace("size", "nm")
+
+env.AddCustomTarget(
+    name="fsmreport",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions='"$PYTHONEXE" "$PROJECT_DIR/tools/fsm_flash_report.py" --nm "%s" "$BUILD_DIR/${PROGNAME}.elf"' % nm,
+    title="FSM flash report",
+    description="Flash use per SML state machine and action",
+)
@@ -0,0 +1,22 @@
+# PlatformIO extra script: after every link of the firmware, prints its flash and RAM use per namespace, writes it to
+# size_report.json in the build directory and fails the build when it exceeds tools/size_budget.json (see
+# size_budget.py). 'pio run -t sizereport' prints the report of the last build again, without checking.
+Import("env")
+
+objdump = env.subst("$SIZETOOL").replace("size", "objdump")
+command = '"$PYTHONEXE" "$PROJECT_DIR/tools/size_budget.py" --objdump "%s" --json "$BUILD_DIR/size_report.json"' % (
+    objdump
+)
+
+env.AddPostAction(
+    "$BUILD_DIR/${PROGNAME}.elf",
+    env.VerboseAction(command + ' --budget "$PROJECT_DIR/tools/size_budget.json" "$TARGET"', "Checking size budgets"),
+)
+
+env.AddCustomTarget(
+    name="sizereport",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=command + ' "$BUILD_DIR/${PROGNAME}.elf"',
+    title="Size report",
+    description="Flash and RAM use per namespace",
+)
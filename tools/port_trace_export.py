@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Converts the output of the 'ptrace' command into Chrome trace JSON, for chrome://tracing or ui.perfetto.dev.
+
+A firmware built with -D PORT_TRACE -D RAMEN_CFG_DISPATCH_HOOKS [-D RAMEN_CFG_TRIGGER_HOOKS] records every Event
+dispatch and behavior trigger (see include/port_trace.hpp); 'ptrace' prints the records as lines of
+
+    @ <cycles> <D|d|T|t> <port address in hex> <payload size>
+
+Each begin (D, T) and end (d, t) becomes a duration event of the same name, so the viewer draws behaviors inside the
+dispatch that ran them, and dispatches inside the behavior that made them. With --elf, a port is named after the
+object of the firmware it lies in, e.g. 'commander+0x1c4'; otherwise after its address. Records whose begin was
+overwritten in the ring buffer are dropped, spans still open at the end close with the last record.
+
+    python3 tools/port_trace_export.py capture.txt -o trace.json \\
+        [--elf .pio/build/controllino_maxi_automation/firmware.elf --nm avr-nm]
+"""
+
+import argparse
+import bisect
+import json
+import re
+import subprocess
+import sys
+
+HEADER = re.compile(r"Port trace: (\d+) records, (\d+) overwritten, (\d+) cycles/us")
+RECORD = re.compile(r"^@ (\d+) ([DdTt]) ([0-9a-fA-F]+) (\d+)\s*$")
+DATA_TYPES = set("bBdDvV")
+AVR_DATA_OFFSET = 0x800000  # Of RAM addresses in an AVR ELF
+BEGIN = {"D": "dispatch", "T": "trigger"}
+END = {"d": "D", "t": "T"}
+
+
+class ObjectNames:
+    """Names addresses after the objects of an ELF that contain them."""
+
+    def __init__(self, nm, elf):
+        out = subprocess.run([nm, "-C", "-S", "-n", elf], check=True, capture_output=True, text=True).stdout
+        self.objects = []
+        for line in out.splitlines():
+            parts = line.split(" ", 3)
+            if len(parts) != 4 or parts[2] not in DATA_TYPES:
+                continue
+            address = int(parts[0], 16)
+            if address >= AVR_DATA_OFFSET:
+                address -= AVR_DATA_OFFSET
+            self.objects.append((address, int(parts[1], 16), parts[3]))
+        self.objects.sort()
+        self.starts = [o[0] for o in self.objects]
+
+    def name(self, address):
+        i = bisect.bisect_right(self.starts, address) - 1
+        if i >= 0:
+            start, size, name = self.objects[i]
+            if address < start + size:
+                return name if address == start else "%s+0x%x" % (name, address - start)
+        return "0x%04x" % address
+
+
+def read_records(lines):
+    """Returns (cycles per us, overwritten, records) of the last trace in the capture."""
+    cycles_per_us, overwritten, records = 16, 0, []
+    for line in lines:
+        header = HEADER.search(line)
+        if header:
+            overwritten, cycles_per_us, records = int(header.group(2)), int(header.group(3)), []
+            continue
+        match = RECORD.match(line.strip())
+        if match:
+            records.append((int(match.group(1)), match.group(2), int(match.group(3), 16), int(match.group(4))))
+    return cycles_per_us, overwritten, records
+
+
+def to_events(records, cycles_per_us, name_of):
+    events = []
+    open_spans = []  # (kind, port) of the spans begun and not ended yet
+    base = records[0][0] if records else 0
+    wraps = 0
+    previous = base
+    ts = 0.0
+    for cycles, kind, port, size in records:
+        if cycles < previous:  # The 32-bit cycle count wrapped
+            wraps += 1
+        previous = cycles
+        ts = (cycles + (wraps << 32) - base) / float(cycles_per_us)
+        if kind in BEGIN:
+            args = {"port": "0x%04x" % port}
+            if kind == "D":
+                args["payload_bytes"] = size
+            events.append({"name": name_of(port), "cat": BEGIN[kind], "ph": "B", "ts": ts, "pid": 1, "tid": 1,
+                           "args": args})
+            open_spans.append((kind, port))
+        elif open_spans and open_spans[-1] == (END[kind], port):
+            open_spans.pop()
+            events.append({"name": name_of(port), "cat": BEGIN[END[kind]], "ph": "E", "ts": ts, "pid": 1, "tid": 1})
+    for kind, port in reversed(open_spans):
+        events.append({"name": name_of(port), "cat": BEGIN[kind], "ph": "E", "ts": ts, "pid": 1, "tid": 1})
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="text captured from the serial port (default: stdin)")
+    parser.add_argument("-o", "--output", help="JSON file to write (default: stdout)")
+    parser.add_argument("--elf", help="firmware ELF, to name the ports")
+    parser.add_argument("--nm", default="avr-nm")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, errors="replace") as f:
+            cycles_per_us, overwritten, records = read_records(f)
+    else:
+        cycles_per_us, overwritten, records = read_records(sys.stdin)
+    if not records:
+        print("No port trace records found", file=sys.stderr)
+        return 1
+    name_of = ObjectNames(args.nm, args.elf).name if args.elf else (lambda address: "0x%04x" % address)
+
+    trace = {
+        "traceEvents": to_events(records, cycles_per_us, name_of),
+        "displayTimeUnit": "ns",
+        "otherData": {"records": len(records), "overwritten": overwritten},
+    }
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(trace, f, indent=1)
+    else:
+        json.dump(trace, sys.stdout, indent=1)
+    print("%d records, %d overwritten before the capture" % (len(records), overwritten), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""Breaks the flash and RAM use of a firmware image down by C++ namespace and checks it against budgets.
+
+Every sized symbol of the ELF is charged to the outermost namespace of its demangled name: led, serial_cmd, ramen,
+boost (the SML state machines), std, and so on. Members of classes of the global namespace count for the class
+template (TimerActor, EventRouter, HardwareSerial), other functions and objects of the global namespace (the actor
+network of main.cpp, the Arduino core, avr-libc) make up 'global', and anonymous namespaces count for the namespace
+they are in. Code and PROGMEM data (.text) count as flash, zero-initialized objects (.bss, .noinit) as RAM, and
+initialized objects (.data) as both, as their initial values are copied from flash at reset. Padding, the vector table
+and code without symbols are not charged to any namespace, so the namespaces add up to a little less than the totals
+that 'pio run' prints.
+
+    python3 tools/size_budget.py .pio/build/controllino_maxi_automation/firmware.elf \\
+        [--objdump avr-objdump] [--budget tools/size_budget.json] [--json size_report.json]
+
+The report is a table on stdout and, with --json, a machine-readable file: {"total": {"flash": .., "ram": ..},
+"namespaces": {"led": {"flash": .., "ram": ..}, ..}}. When the JSON file exists already, the table shows the change of
+every namespace against it before overwriting it, so successive builds show what each change added.
+
+The budget file gives ceilings in bytes for the totals and for any namespace, e.g.
+
+    {"total": {"flash": 65536, "ram": 3072}, "namespaces": {"led": {"ram": 256}}}
+
+and the exit status is 1 when one is exceeded. PlatformIO runs this after every link of the firmware (see
+pio_size_budget.py), so a change that breaks a budget fails the build.
+"""
+
+import argparse
+import collections
+import json
+import os
+import re
+import subprocess
+import sys
+
+SYMBOL = re.compile(r"^([0-9a-fA-F]+) (.{7}) (\S+)\s+([0-9a-fA-F]+) (.*)$")
+FLASH_SECTIONS = (".text", ".progmem", ".rodata")
+RAM_SECTIONS = (".bss", ".noinit")
+DATA_SECTIONS = (".data",)
+SPECIAL_PREFIXES = ("vtable for ", "typeinfo for ", "typeinfo name for ", "VTT for ", "guard variable for ",
+                    "non-virtual thunk to ", "virtual thunk to ", "construction vtable for ")
+ANONYMOUS = "(anonymous namespace)::"
+
+
+def memories(section):
+    """Returns (flash, ram): whether a symbol of the section takes flash and RAM."""
+    if section.startswith(DATA_SECTIONS):
+        return True, True
+    if section.startswith(FLASH_SECTIONS):
+        return True, False
+    if section.startswith(RAM_SECTIONS):
+        return False, True
+    return False, False
+
+
+def qualified_name(name):
+    """Returns the qualified name of a demangled symbol, without its return type, parameters and prefixes."""
+    for prefix in SPECIAL_PREFIXES:
+        if name.startswith(prefix):
+            name = name[len(prefix):]
+    name = name.replace(ANONYMOUS, "")
+    depth = 0
+    start = 0
+    for i, c in enumerate(name):
+        if c in "<[":
+            depth += 1
+        elif c in ">]":
+            depth -= 1
+        elif depth == 0 and c == "(":
+            return name[start:i]
+        elif depth == 0 and c == " " and "operator" not in name[start:i]:
+            start = i + 1  # Past the return type of a function template
+    return name[start:]
+
+
+def namespace_of(name):
+    """Returns the outermost namespace of a symbol or, for a class of the global namespace, the class template."""
+    qualified = qualified_name(name)
+    depth = 0
+    for i, c in enumerate(qualified):
+        if c == "<":
+            depth += 1
+        elif c == ">":
+            depth -= 1
+        elif depth == 0 and qualified.startswith("::", i):
+            outer = qualified[:i].split("<", 1)[0]
+            return outer or "global"
+    return "global"
+
+
+def read_symbols(objdump, elf):
+    out = subprocess.run([objdump, "-t", "-C", elf], check=True, capture_output=True, text=True).stdout
+    seen = set()
+    for line in out.splitlines():
+        match = SYMBOL.match(line)
+        if match is None:
+            continue
+        address, flags, section, size, name = match.groups()
+        size = int(size, 16)
+        # Sections and files (d, f), aliases such as complete and base object constructors
+        if size == 0 or "d" in flags[6:] or "f" in flags[6:] or (section, address) in seen:
+            continue
+        seen.add((section, address))
+        yield section, size, name
+
+
+def section_totals(objdump, elf):
+    """Returns the flash and RAM taken by the loaded sections, as 'pio run' counts them."""
+    out = subprocess.run([objdump, "-h", elf], check=True, capture_output=True, text=True).stdout
+    flash = ram = 0
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) < 3 or not parts[0].isdigit():
+            continue
+        in_flash, in_ram = memories(parts[1])
+        size = int(parts[2], 16)
+        flash += size if in_flash else 0
+        ram += size if in_ram else 0
+    return {"flash": flash, "ram": ram}
+
+
+def breakdown(objdump, elf):
+    namespaces = collections.defaultdict(lambda: {"flash": 0, "ram": 0})
+    for section, size, name in read_symbols(objdump, elf):
+        in_flash, in_ram = memories(section)
+        if not (in_flash or in_ram):
+            continue
+        usage = namespaces[namespace_of(name)]
+        usage["flash"] += size if in_flash else 0
+        usage["ram"] += size if in_ram else 0
+    return {"total": section_totals(objdump, elf), "namespaces": dict(namespaces)}
+
+
+def delta(current, previous):
+    if previous is None:
+        return ""
+    change = current - previous
+    return " (%+d)" % change if change else ""
+
+
+def print_report(report, previous, elf):
+    old = previous["namespaces"] if previous else {}
+    print("Flash and RAM use per namespace in %s" % elf)
+    print("  %-18s %14s %14s" % ("Namespace", "Flash", "RAM"))
+    rows = sorted(report["namespaces"].items(), key=lambda kv: -(kv[1]["ram"] * 32 + kv[1]["flash"]))
+    for namespace, usage in rows:
+        before = old.get(namespace, {"flash": 0, "ram": 0}) if previous else {"flash": None, "ram": None}
+        print("  %-18s %14s %14s" % (namespace, "%d%s" % (usage["flash"], delta(usage["flash"], before["flash"])),
+                                     "%d%s" % (usage["ram"], delta(usage["ram"], before["ram"]))))
+    total = report["total"]
+    before = previous["total"] if previous else {"flash": None, "ram": None}
+    print("  %-18s %14s %14s" % ("total", "%d%s" % (total["flash"], delta(total["flash"], before["flash"])),
+                                 "%d%s" % (total["ram"], delta(total["ram"], before["ram"]))))
+
+
+def over_budget(report, budget):
+    """Yields a message for each budget the report exceeds."""
+    checks = [("total", report["total"], budget.get("total", {}))]
+    for namespace, limits in sorted(budget.get("namespaces", {}).items()):
+        checks.append((namespace, report["namespaces"].get(namespace, {"flash": 0, "ram": 0}), limits))
+    for name, usage, limits in checks:
+        for memory in ("flash", "ram"):
+            if memory in limits and usage[memory] > limits[memory]:
+                yield "%s %s: %d bytes, budget %d" % (name, memory, usage[memory], limits[memory])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--objdump", default="avr-objdump")
+    parser.add_argument("--budget", help="JSON file of ceilings in bytes")
+    parser.add_argument("--json", help="where to write the machine-readable report")
+    args = parser.parse_args()
+
+    report = breakdown(args.objdump, args.elf)
+    previous = None
+    if args.json and os.path.exists(args.json):
+        with open(args.json) as f:
+            previous = json.load(f)
+    print_report(report, previous, args.elf)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write("\n")
+
+    if args.budget:
+        with open(args.budget) as f:
+            budget = json.load(f)
+        failures = list(over_budget(report, budget))
+        for failure in failures:
+            print("Over budget: %s" % failure, file=sys.stderr)
+        if failures:
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""Reads, writes and samples the live variables of a firmware built with -D LIVE_WATCH.
+
+The firmware keeps a table of watched variables in flash, each with its address, type and a hash of its name (see
+include/actor_watch.hpp). This script finds the names in the WATCH(...) entries of the source, hashes them the same
+way, and matches them with the table the firmware lists with WATCH_LIST; variables are then read, written and
+sampled by name over the binary protocol, the samples printed a line per frame:
+
+    python3 tools/watch.py --port /dev/ttyACM0 list
+    python3 tools/watch.py --port /dev/ttyACM0 read led1.blink_interval_ms timer.last_error
+    python3 tools/watch.py --port /dev/ttyACM0 write led1.blink_interval_ms=250
+    python3 tools/watch.py --port /dev/ttyACM0 sample --period 20 led1.blink_interval_ms   # Ctrl-C stops
+
+The port needs pyserial.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import time
+
+WATCH_LIST, WATCH_READ, WATCH_WRITE, WATCH_SAMPLE, REPLY = 0x07, 0x08, 0x09, 0x0A, 0x80
+SAMPLE_FRAME = 0x51
+MAX_BATCH = 8
+READ_ONLY = 0x80
+RESULTS = ["OK", "UNKNOWN_TYPE", "BAD_LENGTH", "BAD_INDEX", "BAD_ACTION", "BAD_PERIOD", "BUSY", "BAD_PROGRAM",
+           "NOT_WRITABLE"]
+TYPES = [("u8", "<B"), ("i8", "<b"), ("u16", "<H"), ("i16", "<h"), ("u32", "<I"), ("i32", "<i"), ("f32", "<f"),
+         ("bool", "<?")]
+SOURCE = os.path.join(os.path.dirname(__file__), "..", "src", "main.cpp")
+ENTRY = re.compile(r"\bWATCH\(\s*([^()]+?)\s*\)")
+
+
+def fnv1a(name):
+    """watch::hash()"""
+    h = 2166136261
+    for byte in name.encode("utf-8"):
+        h = ((h ^ byte) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as binary_frame::crc16()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out, block = bytearray(), bytearray()
+    for byte in data:
+        if byte == 0:
+            out += bytes([len(block) + 1]) + block
+            block = bytearray()
+        else:
+            block.append(byte)
+            if len(block) == 254:
+                out += bytes([255]) + block
+                block = bytearray()
+    return bytes(out + bytes([len(block) + 1]) + block)
+
+
+def cobs_decode(data):
+    out, i = bytearray(), 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 255 and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def source_names(paths):
+    """The names of the WATCH(...) entries of the source files, by hash."""
+    names = {}
+    for path in paths:
+        with open(path, encoding="utf-8") as f:
+            for name in ENTRY.findall(f.read()):
+                if name != "variable":  # The macro's own definition
+                    names[fnv1a(name)] = name
+    return names
+
+
+class Endpoint:
+    """Requests and replies of the binary protocol on a serial port; text between frames is skipped."""
+
+    def __init__(self, port, baud, timeout):
+        import serial  # pyserial
+
+        self.port = serial.Serial(port, baud, timeout=0.05)
+        self.timeout = timeout
+        self.seq = 0
+
+    def request(self, type_, body=b"", retries=3):
+        """The body of the reply, after its result; raises RuntimeError for a result other than OK."""
+        self.seq = (self.seq + 1) & 0xFF
+        payload = bytes([type_, self.seq]) + body
+        frame = b"\0" + cobs_encode(payload + struct.pack("<H", crc16(payload))) + b"\0"
+        for _ in range(retries):
+            self.port.write(frame)
+            deadline = time.time() + self.timeout
+            while time.time() < deadline:
+                reply = self.frame()
+                if reply and reply[0] == type_ | REPLY and reply[1] == self.seq:
+                    if reply[2] != 0:
+                        raise RuntimeError(RESULTS[reply[2]] if reply[2] < len(RESULTS) else str(reply[2]))
+                    return reply[3:]
+        raise RuntimeError("no reply to request type 0x%02x" % type_)
+
+    def frame(self):
+        """The next frame whose CRC holds, without the CRC, or None after a read timeout."""
+        buffer, inside = bytearray(), False
+        while True:
+            data = self.port.read(1)
+            if not data:
+                return None
+            if data[0] != 0:
+                if inside:
+                    buffer += data
+                continue
+            if inside and buffer:
+                payload = cobs_decode(bytes(buffer))
+                if payload and len(payload) >= 4 and crc16(payload[:-2]) == struct.unpack("<H", payload[-2:])[0]:
+                    return payload[:-2]
+            inside, buffer = True, bytearray()
+
+
+def table(endpoint, names):
+    """[(name, type)] of the firmware's table, in index order; unknown names are shown by hash."""
+    entries = []
+    while True:
+        body = endpoint.request(WATCH_LIST, bytes([len(entries)]))
+        total, count = body[0], body[1]
+        for i in range(count):
+            hash_, type_ = struct.unpack_from("<IB", body, 2 + 5 * i)
+            entries.append((names.get(hash_, "#%08x" % hash_), type_))
+        if count == 0 or len(entries) >= total:
+            return entries
+
+
+def decode(entry_type, data, offset):
+    fmt = TYPES[entry_type & ~READ_ONLY][1]
+    return struct.unpack_from(fmt, data, offset)[0], offset + struct.calcsize(fmt)
+
+
+def indices(entries, names):
+    lookup = {name: i for i, (name, _) in enumerate(entries)}
+    missing = [name for name in names if name not in lookup]
+    if missing:
+        raise RuntimeError("not in the firmware's table: " + ", ".join(missing))
+    if len(names) > MAX_BATCH:
+        raise RuntimeError("at most %d variables at once" % MAX_BATCH)
+    return [lookup[name] for name in names]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", required=True, help="the firmware's serial port, e.g. /dev/ttyACM0")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--timeout", type=float, default=0.5, help="seconds to wait for a reply")
+    parser.add_argument("--source", action="append", help="files with the WATCH(...) table (default src/main.cpp)")
+    parser.add_argument("--period", type=int, default=100, help="of the samples, in ms (at least 10)")
+    parser.add_argument("command", choices=["list", "read", "write", "sample"])
+    parser.add_argument("variables", nargs="*", help="names, or name=value for write")
+    args = parser.parse_args()
+
+    try:
+        endpoint = Endpoint(args.port, args.baud, args.timeout)
+        entries = table(endpoint, source_names(args.source or [SOURCE]))
+        if args.command == "list":
+            for i, (name, type_) in enumerate(entries):
+                print("%3d  %-4s %s%s" % (i, TYPES[type_ & ~READ_ONLY][0], name, "  (read-only)" if type_ & READ_ONLY
+                                          else ""))
+        elif args.command == "read":
+            chosen = indices(entries, args.variables)
+            body, offset = endpoint.request(WATCH_READ, bytes(chosen)), 0
+            for i in chosen:
+                value, offset = decode(entries[i][1], body, offset)
+                print("%s = %s" % (entries[i][0], value))
+        elif args.command == "write":
+            pairs = [v.split("=", 1) for v in args.variables]
+            chosen = indices(entries, [name for name, _ in pairs])
+            body = bytearray()
+            for i, (_, value) in zip(chosen, pairs):
+                fmt = TYPES[entries[i][1] & ~READ_ONLY][1]
+                body += bytes([i]) + struct.pack(fmt, float(value) if fmt == "<f" else int(value, 0))
+            endpoint.request(WATCH_WRITE, bytes(body))
+        else:
+            chosen = indices(entries, args.variables)
+            endpoint.request(WATCH_SAMPLE, struct.pack("<H", args.period) + bytes(chosen))
+            print("time_ms " + " ".join(entries[i][0] for i in chosen))
+            try:
+                while True:
+                    frame = endpoint.frame()
+                    if not frame or frame[0] != SAMPLE_FRAME:
+                        continue
+                    values, offset = [], 6
+                    for i in chosen:
+                        value, offset = decode(entries[i][1], frame, offset)
+                        values.append(str(value))
+                    print("%d %s" % (struct.unpack_from("<I", frame, 2)[0], " ".join(values)))
+            except KeyboardInterrupt:
+                endpoint.request(WATCH_SAMPLE, struct.pack("<H", args.period))
+    except RuntimeError as e:
+        print("%s: %s" % (args.port, e), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())